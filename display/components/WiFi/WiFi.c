@@ -31,6 +31,7 @@
 #include "audio_player.h"
 #include <dirent.h>
 #include "s3_tracking.h"
+#include "s3_sync_report.h"
 #include "s3_definitions.h"
 #include "s3_bluetooth.h"  // For BLE/BT coexistence coordination
 #include "s3_logger.h"
@@ -436,6 +437,9 @@ esp_err_t init_wifi_station(bool sync_mode)
 
 esp_err_t deinit_wifi_station(void)
 {
+	// Drop the cloud keep-alive connections while the link is still up; TLS sessions are kept
+	s3_cloud_api_close();
+
 	// Disconnect first to allow clean shutdown
 	esp_err_t ret = esp_wifi_disconnect();
 	if (ret != ESP_OK && ret != ESP_ERR_WIFI_NOT_CONNECT) {
@@ -486,6 +490,7 @@ esp_err_t disconnect_wifi_with_cleanup(void)
 	// This avoids power management issues that cause screen blinks
 
 	ESP_LOGI(TAG, "Performing lightweight WiFi disconnect for memory cleanup");
+	s3_cloud_api_close();
 
 	// Disconnect first to allow clean shutdown
 	esp_err_t ret = esp_wifi_disconnect();
@@ -549,100 +554,6 @@ bool version_gt(const char *a, const char *b) {
     return false;
 }
 
-// Helper structure to hold file information
-typedef struct {
-    char name[64];
-    time_t mtime;
-} file_entry_t;
-
-// Comparison function for qsort
-static int compare_files(const void *a, const void *b) {
-    file_entry_t *file_a = (file_entry_t *)a;
-    file_entry_t *file_b = (file_entry_t *)b;
-    return difftime(file_a->mtime, file_b->mtime);
-}
-
-static esp_err_t exec_upload_tracking_info(void)
-{
-    const char *dir_path = "/sdcard/tmp";
-    DIR *dir = opendir(dir_path);
-    if (!dir) {
-        ESP_LOGE(TAG, "Failed to open directory: %s", dir_path);
-        return ESP_FAIL;
-    }
-
-    file_entry_t *files = NULL;
-    int file_count = 0;
-    struct dirent *entry = NULL;
-
-    while ((entry = readdir(dir)) != NULL) {
-        if (strncmp(entry->d_name, "tracking_", 9) == 0 && strstr(entry->d_name, ".bin") != NULL) {
-            files = heap_caps_realloc(files, (file_count + 1) * sizeof(file_entry_t), MALLOC_CAP_SPIRAM);
-            if (!files) {
-                ESP_LOGE(TAG, "Failed to allocate memory for file list");
-                closedir(dir);
-                return ESP_ERR_NO_MEM;
-            }
-
-            char full_path[256];
-            size_t max_name_len = sizeof(full_path) - strlen(dir_path) - 2;
-            snprintf(full_path, sizeof(full_path), "%s/%.*s", dir_path, (int)max_name_len, entry->d_name);
-
-            struct stat st;
-            if (stat(full_path, &st) == 0) {
-                strncpy(files[file_count].name, entry->d_name, sizeof(files[file_count].name) - 1);
-                files[file_count].name[sizeof(files[file_count].name) - 1] = '\0';
-                files[file_count].mtime = st.st_mtime;
-                file_count++;
-            }
-        }
-    }
-    closedir(dir);
-
-    if (file_count == 0) {
-        ESP_LOGI(TAG, "No tracking files found in %s", dir_path);
-        return ESP_OK;
-    }
-
-    qsort(files, file_count, sizeof(file_entry_t), compare_files);
-
-    ESP_LOGI(TAG, "Found %d tracking files. Processing in chronological order...", file_count);
-
-    for (int i = 0; i < file_count; i++) {
-        char filepath[256];
-        snprintf(filepath, sizeof(filepath), "%s/%s", dir_path, files[i].name);
-        ESP_LOGI(TAG, "Processing file: %s", filepath);
-
-        TrackingRecord *loaded_records = NULL;
-        int record_count = 0;
-
-        if (s3_tracking_load_records_from_file(filepath, &loaded_records, &record_count) == 0) {
-            if (record_count > 0) {
-                char *json_data = make_json_tracking_messages(loaded_records, record_count);
-                ESP_LOGI(TAG, "%s", json_data);
-                if (json_data) {
-                    if (s3_cloud_upload_tracking_info(json_data) == ESP_OK) {
-                        ESP_LOGI(TAG, "Successfully uploaded tracking info from %s", filepath);
-                        remove(filepath);
-                    } else {
-                        ESP_LOGE(TAG, "Failed to upload tracking info from %s", filepath);
-                    }
-                    free(json_data);
-                }
-                s3_tracking_free_loaded_records(loaded_records, record_count);
-            } else {
-                ESP_LOGI(TAG, "No records in %s, deleting empty file.", filepath);
-                remove(filepath);
-            }
-        } else {
-            ESP_LOGE(TAG, "Failed to load records from %s", filepath);
-        }
-    }
-
-    free(files);
-    return ESP_OK;
-}
-
 // LEGACY: This function is kept for backward compatibility but should use unified_sync_task for new implementations
 void wifi_connect_task(void *pvParameters) {
     gWiFi_SYNC_USER_INTERRUPT = false;
@@ -793,8 +704,16 @@ void wifi_connect_task(void *pvParameters) {
     set_current_screen(DATA_SYNC_SCREEN, NULL_SCREEN);
     ESP_LOGI(TAG, "[7.1] DATA_SYNC_SCREEN ");
     i = 0;
+    bool account_modified = true;
     while (!gWiFi_SYNC_USER_INTERRUPT) {
         ret = https_download_account_file(NULL);
+        // Files that failed to install or were deleted need fresh signed links: fetch the whole manifest
+        if (ret == CEI_NOT_MODIFIED && !account_contents_present())
+            ret = https_download_account_file(NULL);
+        if (ret == CEI_NOT_MODIFIED) {
+            account_modified = false;
+            ret = ESP_OK;
+        }
         if (ret == ESP_OK || i > 2)
             break;
         i++;
@@ -819,11 +738,16 @@ void wifi_connect_task(void *pvParameters) {
         ESP_LOGE(TAG, " ota retry =%d", i);
     }
 
-    ESP_LOGI(TAG, "[7.2] s3_cloud_upload_tracking_info");
-    exec_upload_tracking_info();
+    ESP_LOGI(TAG, "[7.2] s3_tracking_upload_pending");
+    s3_tracking_upload_pending();
 
     ESP_LOGI(TAG, "[8.1] parser_and_contents_sync");
-    ret = parser_account_contents(PARSE_AND_DOWNLOAD);
+    if (!account_modified) {
+        ESP_LOGI(TAG, "[8.1] account manifest unchanged, content already in sync");
+        ret = ESP_OK;
+    } else {
+        ret = parser_account_contents(PARSE_AND_DOWNLOAD);
+    }
     if (ret == ESP_OK) {
         s3_albums_dynamic_build();
         success = true;
@@ -1493,6 +1417,8 @@ void unified_sync_task(void *pvParameters) {
     vTaskDelay(pdMS_TO_TICKS(300)); // Allow UI to update
 
     ESP_LOGI(TAG, "[1.0] init_wifi_station");
+    s3_sync_report_begin();
+    s3_sync_report_stage("wifi");
     
     // DIAGNOSTIC: Log state before WiFi init attempt
     size_t dma_pre_init_kb;
@@ -1564,6 +1490,7 @@ void unified_sync_task(void *pvParameters) {
     // FULL and BLE sync mode: SNTP time synchronization
     if (sync_mode == SYNC_MODE_FULL || sync_mode == SYNC_MODE_BLE) {
         ESP_LOGI(TAG, "[2.0] sntp");
+        s3_sync_report_stage("sntp");
         ESP_LOGI(TAG, "Available heap: %u, SPIRAM: %u", heap_caps_get_free_size(MALLOC_CAP_8BIT), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
         if (read_timezone(tz) == ESP_OK) {
             init_sntp(tz);
@@ -1578,6 +1505,7 @@ void unified_sync_task(void *pvParameters) {
 
         // FULL sync mode: OOB binding
         ESP_LOGI(TAG, "[3.0] oob");
+        s3_sync_report_stage("binding");
         ESP_LOGI(TAG, "Available heap: %u, SPIRAM: %u", heap_caps_get_free_size(MALLOC_CAP_8BIT), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
         if (oob_status == OOB_FACTORY_RESET) {
             ESP_LOGI(TAG, "[3.1] OOB==OOB_FACTORY_RESET -> binding");
@@ -1640,6 +1568,7 @@ void unified_sync_task(void *pvParameters) {
 
     // Resource updates (both modes)
     ESP_LOGI(TAG, "[4.0] resource");
+    s3_sync_report_stage("resource");
     char *resource_version = NULL;
     char *resource_url = NULL;
     parser_ota_resource_info(&resource_version, &resource_url);
@@ -1671,6 +1600,7 @@ void unified_sync_task(void *pvParameters) {
 
     // FULL and BLE sync mode: OTA firmware update
     if (sync_mode == SYNC_MODE_FULL || sync_mode == SYNC_MODE_BLE) {
+        s3_sync_report_stage("ota");
         // Check if OTA should be skipped
         if (skip_ota_flag) {
             ESP_LOGI(TAG, "[5.0] Skipping OTA verification (developer skip mode enabled)");
@@ -1724,6 +1654,7 @@ void unified_sync_task(void *pvParameters) {
     set_pixsee_status(S3ER_SETUP_CONNECT_SUCCESS);
     if (sync_mode == SYNC_MODE_FULL || sync_mode == SYNC_MODE_BLE) {
         ESP_LOGI(TAG, "[6.0] cei_upload_device_info - preparing data");
+        s3_sync_report_stage("device");
         uint8_t mac[6];
         esp_read_mac(mac, ESP_MAC_WIFI_STA);
         char patch_data[256] = {0};
@@ -1753,8 +1684,9 @@ void unified_sync_task(void *pvParameters) {
             vTaskDelay(pdMS_TO_TICKS(500)); // Longer delay between retries
         }
 
-        ESP_LOGI(TAG, "[6.1] s3_cloud_upload_tracking_info");
-        exec_upload_tracking_info();
+        ESP_LOGI(TAG, "[6.1] s3_tracking_upload_pending");
+        s3_sync_report_stage("tracking");
+        s3_tracking_upload_pending();
     }
 
     // Now update screen for stage 2 AFTER upload completes to avoid SDMMC DMA conflict
@@ -1764,11 +1696,21 @@ void unified_sync_task(void *pvParameters) {
 
     // Download account file and sync content (both modes)
     ESP_LOGI(TAG, "[7.0] account");
+    s3_sync_report_stage("account");
+    bool account_modified = true;
     i = 0;
     while (!gWiFi_SYNC_USER_INTERRUPT) {
         ESP_LOGI(TAG, "[AccountFile n%d - start]: downloading account file", i+1);
         ret = https_download_account_file(NULL);
-        if (ret == ESP_OK) {
+        // Files that failed to install or were deleted need fresh signed links: fetch the whole manifest
+        if (ret == CEI_NOT_MODIFIED && !account_contents_present())
+            ret = https_download_account_file(NULL);
+        if (ret == CEI_NOT_MODIFIED) {
+            ESP_LOGI(TAG, "[AccountFile n%d - success]: account file not modified", i+1);
+            account_modified = false;
+            ret = ESP_OK;
+            break;
+        } else if (ret == ESP_OK) {
             ESP_LOGI(TAG, "[AccountFile n%d - success]: https_download_account_file completed", i+1);
             break;
         } else if (i > 2) {
@@ -1786,12 +1728,20 @@ void unified_sync_task(void *pvParameters) {
     }
 
     ESP_LOGI(TAG, "[7.1] parser_and_contents_sync");
-    s3_wifi_downloading = true;
-    ret = parser_account_contents(PARSE_AND_DOWNLOAD);
-    s3_wifi_downloading = false;
+    s3_sync_report_stage("contents");
+    if (!account_modified) {
+        // Nothing to parse or diff; the model is loaded from the card on first use
+        ESP_LOGI(TAG, "[7.1] account manifest unchanged, skipping parse and content diff");
+        ret = ESP_OK;
+    } else {
+        s3_wifi_downloading = true;
+        ret = parser_account_contents(PARSE_AND_DOWNLOAD);
+        s3_wifi_downloading = false;
+    }
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "[7.2] Content download completed, waiting for SD card write completion...");
-        vTaskDelay(pdMS_TO_TICKS(1000)); // Allow time for SD card writes to complete
+        if (account_modified)
+            vTaskDelay(pdMS_TO_TICKS(1000)); // Allow time for SD card writes to complete
         
         ESP_LOGI(TAG, "[7.3] Checking album availability after download completion");
         bool album_check_result = s3_albums_dynamic_build();
@@ -1834,6 +1784,12 @@ FINISH:
         ESP_LOGI(TAG, "[7.6] No NFC callback to execute (param=%p, callback=%p)", param, param ? param->callback : NULL);
     }
     
+    s3_cloud_api_stats_t api_stats;
+    s3_cloud_api_get_stats(&api_stats);
+    ESP_LOGI(TAG, "[8.0] Cloud API: %u requests, %u TLS connections, %u on kept-alive connections",
+             (unsigned int)api_stats.requests, (unsigned int)api_stats.connections, (unsigned int)api_stats.reused);
+    s3_sync_report_end();
+
     if (msg) {
         ESP_LOGI(TAG, "[8.0] unified_sync_task end: %s", msg);
         // set_pixsee_status(S3ER_SYNC_FAIL);
@@ -1933,6 +1889,7 @@ FINISH:
     }
 
 FINISH_WITHOUT_UI:
+    s3_sync_report_end();   // No-op if the sync already logged it
     ESP_LOGI(TAG, "[8.1] WIFI_DEINIT");
     get_alarm_setting(TIMER_SOURCE_ESP_TIMER);
 
@@ -18,6 +18,10 @@
 #include "storage.h"
 #include "s3_definitions.h"
 #include "s3_logger.h"
+#include "s3_content_index.h"
+
+// Provided by lv_decoders.c
+extern void lvgl_native_img_remove(const char *path);
 
 // Define MIN macro if not available
 #ifndef MIN
@@ -447,6 +451,10 @@ static esp_err_t http_upload_handler(httpd_req_t *req)
     fclose(fd);
     free(buf);
     ESP_LOGI(TAG, "File reception complete");
+
+    /* Keep the album content index and the native image files in step with the card */
+    s3_content_index_file_updated(filepath);
+    s3_content_index_flush();
     
     /* Update JSON cache after successful upload */
     ESP_LOGI(TAG, "Updating JSON cache after file upload");
@@ -522,6 +530,11 @@ static esp_err_t http_delete_handler(httpd_req_t *req)
     }
     
     ESP_LOGI(TAG, "File deleted : %s", filepath);
+
+    /* Keep the album content index and the native image files in step with the card */
+    s3_content_index_file_removed(filepath);
+    s3_content_index_flush();
+    lvgl_native_img_remove(filepath);
     
     /* Update JSON cache after successful delete */
     ESP_LOGI(TAG, "Updating JSON cache after file deletion");
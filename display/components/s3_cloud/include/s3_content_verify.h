@@ -0,0 +1,87 @@
+#ifndef S3_CONTENT_VERIFY_H
+#define S3_CONTENT_VERIFY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "mbedtls/md5.h"
+#include "mbedtls/sha256.h"
+
+/**
+ * Content integrity: incremental digests of downloads and a background re-verify.
+ *
+ * Downloads are hashed as the bytes arrive from the network (SHA-256, hardware accelerated),
+ * so no second read pass over the SD card is needed. When the manifest provides a digest
+ * ("sha256", or "md5" as the cloud uses for other files) it is checked before the file is
+ * installed. The SHA-256 of every installed file is appended to CONTENT_DIGEST_PATH, which
+ * s3_content_verify_start() later uses to find files that were silently corrupted on the card.
+ */
+
+#define S3_SHA256_HEX_LEN   64
+#define S3_MD5_HEX_LEN      32
+
+typedef struct {
+    mbedtls_sha256_context sha256;
+    mbedtls_md5_context md5;
+    bool with_md5;
+} s3_content_digest_t;
+
+/**
+ * @brief Start a digest
+ * @param expected Manifest digest the result will be checked against (NULL if none); MD5 is only computed when it is an MD5
+ */
+void s3_content_digest_start(s3_content_digest_t *digest, const char *expected);
+
+void s3_content_digest_update(s3_content_digest_t *digest, const void *data, size_t len);
+
+/**
+ * @brief Hash the first len bytes already in a file (prefix of a resumed download)
+ */
+esp_err_t s3_content_digest_file(s3_content_digest_t *digest, const char *path, long len);
+
+/**
+ * @brief Finish the digest and free it
+ * @param sha256_hex Receives the lowercase SHA-256, S3_SHA256_HEX_LEN + 1 bytes
+ * @param expected   Manifest digest (hex SHA-256 or MD5, any case), or NULL
+ * @return false if expected is given and does not match, or is neither a SHA-256 nor an MD5
+ */
+bool s3_content_digest_finish(s3_content_digest_t *digest, char *sha256_hex, const char *expected);
+
+/**
+ * @brief Discard a digest without finishing it
+ */
+void s3_content_digest_free(s3_content_digest_t *digest);
+
+/**
+ * @brief Remember the digest of an installed file for later re-verification
+ */
+esp_err_t s3_content_verify_record(const char *path, const char *sha256_hex, int size);
+
+typedef struct {
+    bool running;
+    uint32_t files_checked;
+    uint32_t files_corrupt;
+    uint32_t files_missing;     // Recorded but gone (deleted by sync); dropped from the record
+    uint64_t bytes;
+    int64_t elapsed_us;
+} s3_content_verify_stats_t;
+
+/**
+ * @brief Re-hash every recorded file in a low-priority background task
+ *
+ * Reads yield to audio playback. Corrupt files are logged; with repair they are deleted so
+ * the next sync downloads them again.
+ *
+ * @return ESP_ERR_INVALID_STATE if a re-verify is already running
+ */
+esp_err_t s3_content_verify_start(bool repair);
+
+/**
+ * @brief Ask a running re-verify to stop after the current file
+ */
+void s3_content_verify_cancel(void);
+
+void s3_content_verify_get_stats(s3_content_verify_stats_t *stats);
+
+#endif // S3_CONTENT_VERIFY_H
@@ -0,0 +1,75 @@
+#ifndef S3_DOWNLOAD_JOURNAL_H
+#define S3_DOWNLOAD_JOURNAL_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+/**
+ * Persistent journal for partial downloads.
+ *
+ * Every partial file <path> has a small text record at <path>.journal holding the source URL
+ * (without its query string, which changes with each signed link), the expected size, the
+ * server validator (ETag, or Last-Modified when there is no ETag) and the bytes known to be on
+ * the card. Retries, later syncs and reboots resume from the partial file with a Range request;
+ * the partial is discarded only when the record does not match or the server copy changed.
+ */
+
+#define S3_DL_JOURNAL_URL_MAX       256
+#define S3_DL_VALIDATOR_MAX         96
+#define S3_DL_CHECKPOINT_BYTES      (1024 * 1024)   // Sync the partial file and the record this often
+
+typedef struct {
+    char url[S3_DL_JOURNAL_URL_MAX];        // Normalized source URL
+    int expected_size;                      // -1 if unknown
+    char validator[S3_DL_VALIDATOR_MAX];    // Empty until the server sent one
+    int bytes;                              // Bytes synced to the partial file
+} s3_dl_journal_t;
+
+/**
+ * @brief Decide where a download into path starts
+ *
+ * Keeps the partial file if its record matches url and expected_size and it can be
+ * validated (stored validator for If-Range, or a manifest digest checked at the end);
+ * otherwise the partial file and its record are removed. A kept file is cut back to the
+ * last journal checkpoint, since bytes after it were never recorded as synced.
+ *
+ * @param has_digest true if the complete file will be checked against a manifest digest
+ * @param journal Receives the record to continue with (stored validator kept)
+ * @return Resume offset in bytes (0 to start over)
+ */
+long s3_dl_journal_prepare(const char *path, const char *url, int expected_size, bool has_digest,
+                           s3_dl_journal_t *journal);
+
+/**
+ * @brief Check a response validator against the one the partial file was started with
+ * @return true if both are known and differ, i.e. the server copy changed
+ */
+bool s3_dl_journal_validator_changed(const s3_dl_journal_t *journal, const char *validator);
+
+esp_err_t s3_dl_journal_save(const char *path, const s3_dl_journal_t *journal);
+
+/**
+ * @brief Remove the partial file and its record
+ */
+void s3_dl_journal_discard(const char *path);
+
+/**
+ * @brief Remove only the record, once the file is complete
+ */
+void s3_dl_journal_done(const char *path);
+
+/**
+ * @brief Remove every journaled partial download in dir (for content no longer wanted)
+ * @return Number of partial files removed
+ */
+int s3_dl_journal_prune(const char *dir);
+
+/**
+ * @brief esp_http_client event handler that copies ETag / Last-Modified into user_data
+ *
+ * user_data must point to a char[S3_DL_VALIDATOR_MAX]; clear it before each request.
+ */
+esp_err_t s3_dl_journal_http_event(esp_http_client_event_t *evt);
+
+#endif // S3_DOWNLOAD_JOURNAL_H
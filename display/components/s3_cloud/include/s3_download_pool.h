@@ -0,0 +1,138 @@
+#ifndef S3_DOWNLOAD_POOL_H
+#define S3_DOWNLOAD_POOL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+/**
+ * Bounded pool of download workers for content sync.
+ *
+ * Each worker keeps one keep-alive HTTPS connection to the content host and reuses it
+ * for every file it fetches, so a sync of hundreds of files pays for a handful of TLS
+ * handshakes instead of one per file. Total memory is bounded: the worker count is
+ * limited by free internal RAM (TLS buffers), receive buffers share a fixed PSRAM
+ * budget, and all SD writes go through one writer task, in large chunks.
+ */
+
+/**
+ * @brief Called from a worker task when a job finishes (successfully or not)
+ * @param result ESP_OK when the file was fully downloaded
+ * @param path   File the job wrote
+ * @param bytes  Size of the file on the SD card after the job
+ * @param sha256_hex SHA-256 of the file, computed while it downloaded (NULL on failure)
+ * @param ctx    Caller context passed to s3_download_pool_submit()
+ * @return ESP_OK once the caller is done with the file; an error counts the job as failed
+ */
+typedef esp_err_t (*s3_download_done_cb_t)(esp_err_t result, const char *path, int bytes, const char *sha256_hex, void *ctx);
+
+typedef struct {
+    int workers;                // Workers started by the last s3_download_pool_start()
+    uint32_t files_ok;
+    uint32_t files_failed;
+    uint32_t connections;       // Connections opened (first request of a worker, or after an error)
+    uint32_t retries;           // Attempts after a file's first one
+    uint32_t resumed;           // Partial files continued with a 206 response
+    uint32_t restarted;         // Partial files dropped (full 200 response, 416, or copy changed on the server)
+    uint64_t bytes;             // Body bytes received
+    int64_t sd_write_us;        // Time the SD writer spent writing those bytes
+    int64_t elapsed_us;         // From start to the last s3_download_pool_wait()
+} s3_download_pool_stats_t;
+
+/**
+ * @brief Start the download workers
+ * @param max_workers Upper bound; fewer are started if internal RAM is short (at least one)
+ */
+esp_err_t s3_download_pool_start(int max_workers);
+
+/**
+ * @brief Queue a download; blocks while the queue is full
+ * @param url           Source URL (copied)
+ * @param path          Destination file (copied); existing content is resumed with a Range request
+ * @param expected_size Expected file size, or -1 if unknown
+ * @param expected_digest Manifest SHA-256 or MD5 (hex), or NULL; a mismatching file fails the job
+ * @param cb            Optional completion callback, called from the worker task
+ * @param ctx           Passed to cb
+ * @return ESP_ERR_INVALID_STATE if the pool is not running, ESP_FAIL if sync was interrupted
+ */
+esp_err_t s3_download_pool_submit(const char *url, const char *path, int expected_size,
+                                  const char *expected_digest, s3_download_done_cb_t cb, void *ctx);
+
+/**
+ * @brief Wait until every queued job has finished
+ * @return ESP_OK if all jobs since start succeeded, ESP_FAIL otherwise
+ */
+esp_err_t s3_download_pool_wait(void);
+
+/**
+ * @brief Stop the workers and close their connections; queued jobs complete with ESP_FAIL
+ */
+void s3_download_pool_stop(void);
+
+void s3_download_pool_get_stats(s3_download_pool_stats_t *stats);
+
+/**
+ * @brief Counters summed over every pool run since boot (workers and elapsed_us are left 0)
+ *
+ * Unlike s3_download_pool_get_stats() this is not reset by s3_download_pool_start(), so the
+ * difference between two calls covers whatever ran in between (see s3_sync_report.h).
+ */
+void s3_download_pool_get_totals(s3_download_pool_stats_t *totals);
+
+/**
+ * @brief Download the same URL file_count times with 1 worker and then with max_workers, and log wall time
+ *
+ * Intended for a LAN HTTPS test server with injected latency (e.g. tc netem delay 150ms) to check
+ * that sync time follows bandwidth rather than per-file round trips. Files go to /sdcard/tmp/bench/.
+ */
+esp_err_t s3_download_pool_benchmark(const char *url, int file_count, int max_workers);
+
+/**
+ * Double-buffered download-to-SD stream.
+ *
+ * The network side fills one buffer while the shared SD writer task writes the other, so
+ * reads and writes overlap. The producer only waits when both buffers are full, and it
+ * backs off only on real pressure: an SD write much slower than usual, low DMA-capable
+ * internal heap, or audio playback that needs the SD bus.
+ */
+typedef struct s3_dl_stream s3_dl_stream_t;
+
+typedef struct {
+    uint32_t bytes_written;
+    int64_t write_us;           // Time spent in fwrite by the writer task
+    int64_t throttle_us;        // Time the producer deliberately backed off
+} s3_dl_stream_stats_t;
+
+/**
+ * @brief Start streaming into an open file
+ * @param buf_size Size of each of the two PSRAM buffers
+ * @return NULL if out of memory
+ */
+s3_dl_stream_t *s3_dl_stream_open(FILE *file, size_t buf_size);
+
+/**
+ * @brief Free space in the current buffer; read network data straight into it
+ */
+uint8_t *s3_dl_stream_space(s3_dl_stream_t *stream, size_t *avail);
+
+/**
+ * @brief Account for len bytes written into the space returned by s3_dl_stream_space()
+ * @return ESP_FAIL once any SD write of this stream has failed
+ */
+esp_err_t s3_dl_stream_produced(s3_dl_stream_t *stream, size_t len);
+
+/**
+ * @brief Write what is buffered and flush the file to the card
+ * @note Blocks until the writer is idle for this stream; use at checkpoints, not per chunk
+ * @return ESP_FAIL once any SD write of this stream has failed
+ */
+esp_err_t s3_dl_stream_sync(s3_dl_stream_t *stream);
+
+/**
+ * @brief Write what is buffered, wait for the writer and free the stream (the file stays open)
+ * @param stats Optional, receives this stream's counters
+ * @return ESP_FAIL if any SD write failed
+ */
+esp_err_t s3_dl_stream_close(s3_dl_stream_t *stream, s3_dl_stream_stats_t *stats);
+
+#endif // S3_DOWNLOAD_POOL_H
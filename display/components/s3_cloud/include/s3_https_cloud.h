@@ -12,8 +12,11 @@
 #define STG_DOMAIN "https://s3-stg.ipg-services.com"
 #define PRO_DOMAIN "https://s3.ipg-services.com"
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "time.h"
 #define CEI_INVALID_SECRET_KEY 10032
+#define CEI_NOT_MODIFIED 304    // Account manifest unchanged since the last completed sync
 
 esp_err_t ensure_dir_exists(const char *dir_path);
 
@@ -29,13 +32,54 @@ esp_err_t OTA_Update(char *url);
 
 esp_err_t https_download_content_file(void *pvParameters);
 
+/**
+ * @brief Download account_file.json if it changed
+ * @return ESP_OK with a new manifest to sync, CEI_NOT_MODIFIED if the one on the card is
+ *         current and its sync completed (nothing to parse), ESP_FAIL on error
+ */
 esp_err_t https_download_account_file(void *pvParameters);
 
+/**
+ * @brief Record that the sync of the current account manifest completed
+ */
+void s3_cloud_account_manifest_synced(void);
+
+/**
+ * @brief Force the next sync to parse the account manifest even if it did not change
+ *        (local content was removed outside sync)
+ */
+void s3_cloud_account_manifest_invalidate(void);
+
 esp_err_t parser_ota_info(char **version, char **ota_url);
 
 esp_err_t parser_ota_resource_info(char **version, char **ota_url);
 
-esp_err_t s3_cloud_upload_tracking_info(const char *tracking_data);
+/**
+ * @brief Upload a play-tracking body prepared on the SD card (see s3_tracking_write_upload())
+ *
+ * The body is streamed from the file, so its size does not matter.
+ * @param gzip The body is gzip compressed
+ * @return ESP_OK when the server accepted it, ESP_ERR_NOT_SUPPORTED when it does not take this
+ *         kind of body (HTTP 400, 404 or 415), ESP_FAIL on other errors (401, 429, 5xx, network)
+ */
+esp_err_t s3_cloud_upload_tracking_file(const char *body_path, bool gzip);
+
+typedef struct {
+    uint32_t requests;
+    uint32_t connections;   // TLS connections opened (resumed with a session ticket when possible)
+    uint32_t reused;        // Requests sent on an already open keep-alive connection
+    uint32_t retries;       // Requests sent again after the kept-alive connection was found closed
+    uint64_t bytes_sent;    // Request bodies
+    uint64_t bytes_received; // Response bodies read
+} s3_cloud_api_stats_t;
+
+/**
+ * @brief Close the shared cloud API connections (e.g. before WiFi stops)
+ * @note The clients and their TLS sessions are kept, so the next call resumes the session
+ */
+void s3_cloud_api_close(void);
+
+void s3_cloud_api_get_stats(s3_cloud_api_stats_t *stats);
 
 
 
@@ -0,0 +1,63 @@
+#ifndef S3_JSON_STREAM_H
+#define S3_JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "cJSON.h"
+
+/**
+ * Incremental JSON reader for manifests too large to hold as one cJSON tree.
+ *
+ * The document is fed in chunks of any size. Objects are walked without being built;
+ * every other value is handed to the callback as a small cJSON tree, keyed by its dotted
+ * member path ("result.babyId"). Arrays listed as split paths are not built as a whole:
+ * each element is delivered on its own, so memory is bounded by the largest element
+ * (one baby pack) instead of the whole account.
+ */
+
+#define S3_JSON_STREAM_MAX_DEPTH    16
+#define S3_JSON_STREAM_PATH_MAX     96
+#define S3_JSON_STREAM_VALUE_MAX    (512 * 1024)    // Largest single value accepted
+
+typedef struct s3_json_stream s3_json_stream_t;
+
+/**
+ * @param path  Member path of the value; elements of a split array carry the array's path ("" is the root)
+ * @param index Element index in a split array, or -1 for a member value
+ * @param value Parsed value, freed when the callback returns; NULL with index -1 when a split array opens
+ * @return false to stop parsing
+ */
+typedef bool (*s3_json_stream_cb_t)(const char *path, int index, const cJSON *value, void *ctx);
+
+/**
+ * @param split_paths Paths of the arrays to deliver element by element (not copied)
+ */
+s3_json_stream_t *s3_json_stream_create(const char *const *split_paths, int split_count,
+                                        s3_json_stream_cb_t cb, void *ctx);
+
+/**
+ * @return ESP_FAIL on malformed JSON or when the callback stopped, ESP_ERR_NO_MEM /
+ *         ESP_ERR_INVALID_SIZE when a value does not fit
+ */
+esp_err_t s3_json_stream_feed(s3_json_stream_t *stream, const char *data, size_t len);
+
+/**
+ * @brief Check that a complete document was fed
+ */
+esp_err_t s3_json_stream_finish(s3_json_stream_t *stream);
+
+/**
+ * @brief Size of the largest value buffered so far (the parser's peak memory, besides the callback's)
+ */
+size_t s3_json_stream_peak(const s3_json_stream_t *stream);
+
+void s3_json_stream_destroy(s3_json_stream_t *stream);
+
+/**
+ * @brief Stream a file from the SD card through a new parser
+ */
+esp_err_t s3_json_stream_file(const char *file_path, const char *const *split_paths, int split_count,
+                              s3_json_stream_cb_t cb, void *ctx);
+
+#endif // S3_JSON_STREAM_H
@@ -5,6 +5,8 @@
 #ifndef S3_SYNC_ACCOUNT_CONTENTS
 #define S3_SYNC_ACCOUNT_CONTENTS
 
+#include <stdbool.h>
+
 #define SDCARD_CONTENT_PATH "/sdcard/content/full/%s/"
 #define SDCARD_CONTENT_FULLNAME "/sdcard/content/full/%s/%s"
 
@@ -48,6 +50,8 @@ typedef  struct  {
     char *language;
     int contentCount;  // Number of content files for this SKU
     unsigned int expiresAt; // timestamp (e.g. 1774145903, 2026年03月22日10點18分23秒 (+08:00 CST))
+    char **filenames;  // Content filenames in account order (used by SKURC playlists)
+    int filenameCount;
 } s3_nfc_skus_t;
 
 typedef struct  {
@@ -59,6 +63,15 @@ typedef struct  {
 
 esp_err_t parser_account_contents(int justPaserContent);
 
+// For an unchanged manifest: check every listed file is on the card with its listed size.
+// Returns false, and marks the manifest for a full sync, if any failed to install or was deleted.
+bool account_contents_present(void);
+
+// The parsed account model is shared by the sync task, NFC handling and playback.
+// Hold the (recursive) lock while using the arrays from get_babyPacks/get_alarms/get_nfcs.
+bool account_model_lock(void);
+void account_model_unlock(void);
+
 void get_babyPacks(const s3_babyPack_t **babyPack, int *conunt);
 
 void get_alarms(const s3_alarm_t **alarm, int *conunt);
@@ -90,9 +103,17 @@ void cleanup_sync_connection_reuse(void);
 esp_err_t test_pure_download_speed(char *url, int test_duration_seconds);
 
 // Filename to ContentId mapping functions
-const char* GetContentId(const char* filename);
+char* GetContentId(const char* filename);     // PSRAM copy, caller frees
 void free_filename_contentid_map(void);
 
+// Hashed lookups into the parsed account model; rebuilt on every parser_account_contents()
+// and parsed on first use if no parse succeeded since boot. Results are copies owned by the caller.
+bool find_nfc_by_sn(const char *sn, s3_nfc_t *nfc);     // nfc may be NULL; else free with free_nfc_copy()
+void free_nfc_copy(s3_nfc_t *nfc);
+bool find_sku_expires_at(const char *skuId, unsigned int *expiresAt);
+int get_sku_filenames(const char *skuId, char ***filenames);    // free with free_sku_filenames()
+void free_sku_filenames(char **filenames, int count);
+
 // SPIRAM-aware string duplication to avoid internal RAM exhaustion
 char* strdup_spiram(const char* str);
 
@@ -0,0 +1,34 @@
+#ifndef S3_SYNC_REPORT_H
+#define S3_SYNC_REPORT_H
+
+/**
+ * Per-stage report of a sync: wall time, bytes and retries of each stage.
+ *
+ * The cloud API and download pool counters are cumulative; the report snapshots them at
+ * every stage boundary and logs the differences as one table when the sync ends. Together
+ * with CONFIG_CLOUD_HOST_OVERRIDE this makes sync runs comparable between builds.
+ *
+ * The mock server with bandwidth, latency, reset and Range fault injection is
+ * host_test/mock_cloud.py; host_test/sync_harness.c runs the same stages on the host
+ * against it and prints this table after its own per-stage wire and retry counts.
+ */
+
+#define S3_SYNC_REPORT_MAX_STAGES   12
+
+/**
+ * @brief Start a report; the first stage opens with s3_sync_report_stage()
+ */
+void s3_sync_report_begin(void);
+
+/**
+ * @brief Close the current stage and open the next one
+ * @param name Stage label, e.g. "account" (not copied, use a literal)
+ */
+void s3_sync_report_stage(const char *name);
+
+/**
+ * @brief Close the current stage and log the report
+ */
+void s3_sync_report_end(void);
+
+#endif // S3_SYNC_REPORT_H
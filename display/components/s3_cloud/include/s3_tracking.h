@@ -1,7 +1,24 @@
 #ifndef S3_TRACKING_H
 #define S3_TRACKING_H
 
+#include <stdbool.h>
 #include <time.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#if CONFIG_TRACKING_UPLOAD_GZIP
+#define S3_TRACKING_UPLOAD_GZIP     1
+#else
+#define S3_TRACKING_UPLOAD_GZIP     0
+#endif
+
+#if CONFIG_TRACKING_UPLOAD_BATCH
+#define S3_TRACKING_UPLOAD_BATCH    1
+#else
+#define S3_TRACKING_UPLOAD_BATCH    0
+#endif
+
+#define TRACKING_UPLOAD_BODY_PATH   "/sdcard/tmp/upload_tracking.json"
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +62,28 @@ const TrackingRecord* s3_tracking_get_records(int *count);
  */
 void s3_tracking_cleanup(void);
 
+/**
+ * @brief Callback for each record read by s3_tracking_read_file().
+ *
+ * @param record The record; its contentId is only valid during the call.
+ * @param ctx The context passed to s3_tracking_read_file().
+ * @return true to continue reading, false to stop.
+ */
+typedef bool (*s3_tracking_record_cb_t)(const TrackingRecord *record, void *ctx);
+
+/**
+ * @brief Reads a tracking file one record at a time.
+ *
+ * Reads both the versioned .trk format and the .bin files written by older firmware.
+ * A record cut short at the end of the file (power lost while saving) is ignored.
+ *
+ * @param filepath The path to the file to read.
+ * @param cb Called for each record.
+ * @param ctx Passed to cb.
+ * @return The number of records read, or -1 on failure.
+ */
+int s3_tracking_read_file(const char *filepath, s3_tracking_record_cb_t cb, void *ctx);
+
 /**
  * @brief Loads tracking records from a file into a dynamically allocated array.
  *
@@ -74,11 +113,32 @@ void s3_tracking_free_loaded_records(TrackingRecord *loaded_records, int count);
  */
 void s3_tracking_save_now(void);
 
-/*
- *  upload format : https://redmine.pixseecare.com:8081/issues/15143#note-4
+/**
+ * @brief Writes the upload body for a set of tracking files without loading them whole.
+ *
+ * Each file becomes one day object; upload format : https://redmine.pixseecare.com:8081/issues/15143#note-4
+ *
+ * @param paths Tracking files, one per day.
+ * @param path_count The number of files.
+ * @param as_array true to write a batch (a JSON array of days), false for a single day object.
+ * @param gzip Compress the body with gzip; ignored unless CONFIG_TRACKING_UPLOAD_GZIP is set.
+ * @param out_path The body file to write.
+ * @param[out] day_records Records written for each file, -1 for a file that could not be read.
+ * @return ESP_OK on success.
  */
+esp_err_t s3_tracking_write_upload(const char *const *paths, int path_count, bool as_array, bool gzip,
+                                   const char *out_path, int *day_records);
 
-char *make_json_tracking_messages(TrackingRecord *records, int record_count);
+/**
+ * @brief Uploads the tracking files waiting in /sdcard/tmp, oldest first.
+ *
+ * All days go up in one request (CONFIG_TRACKING_UPLOAD_BATCH); once the server rejects a
+ * batch, one day per request until reboot. Uploaded files are deleted, the others are kept
+ * for the next sync.
+ *
+ * @return ESP_OK when nothing is left to upload.
+ */
+esp_err_t s3_tracking_upload_pending(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "audio_player.h"
+#include "s3_definitions.h"
+#include "s3_logger.h"
+#include "s3_content_index.h"
+#include "s3_content_verify.h"
+#include "s3_https_cloud.h"
+
+static const char *TAG = "CONTENT_VERIFY";
+
+// Provided by lv_decoders.c
+extern void lvgl_native_img_remove(const char *path);
+
+#define VERIFY_CHUNK            (16 * 1024)
+#define VERIFY_TASK_STACK       4096
+#define VERIFY_PLAYBACK_YIELD_MS 10     // Gap left per chunk so playback reads get the bus
+#define RECORD_LINE_MAX         (S3_SHA256_HEX_LEN + 320)
+
+typedef struct {
+    char *path;
+    int size;
+    int seq;                    // Line number; the last record of a path wins
+    char sha256[S3_SHA256_HEX_LEN + 1];
+} digest_record_t;
+
+static SemaphoreHandle_t s_lock = NULL;
+static portMUX_TYPE s_lock_create = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_appended = 0;         // Records appended since boot
+static volatile bool s_cancel = false;
+static bool s_repair = false;
+static s3_content_verify_stats_t s_stats;
+
+static bool verify_lock(void) {
+    if (s_lock == NULL) {
+        SemaphoreHandle_t m = xSemaphoreCreateMutex();
+        portENTER_CRITICAL(&s_lock_create);
+        if (s_lock == NULL) {
+            s_lock = m;
+            m = NULL;
+        }
+        portEXIT_CRITICAL(&s_lock_create);
+        if (m) {
+            vSemaphoreDelete(m);
+        }
+    }
+    return s_lock && xSemaphoreTake(s_lock, portMAX_DELAY) == pdTRUE;
+}
+
+static void verify_unlock(void) {
+    xSemaphoreGive(s_lock);
+}
+
+static void to_hex(const uint8_t *bin, size_t len, char *hex) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        hex[2 * i] = digits[bin[i] >> 4];
+        hex[2 * i + 1] = digits[bin[i] & 0x0f];
+    }
+    hex[2 * len] = '\0';
+}
+
+void s3_content_digest_start(s3_content_digest_t *digest, const char *expected) {
+    mbedtls_sha256_init(&digest->sha256);
+    mbedtls_sha256_starts(&digest->sha256, 0);
+    digest->with_md5 = expected && strlen(expected) == S3_MD5_HEX_LEN;
+    if (digest->with_md5) {
+        mbedtls_md5_init(&digest->md5);
+        mbedtls_md5_starts(&digest->md5);
+    }
+}
+
+void s3_content_digest_update(s3_content_digest_t *digest, const void *data, size_t len) {
+    mbedtls_sha256_update(&digest->sha256, data, len);
+    if (digest->with_md5) {
+        mbedtls_md5_update(&digest->md5, data, len);
+    }
+}
+
+esp_err_t s3_content_digest_file(s3_content_digest_t *digest, const char *path, long len) {
+    uint8_t *buf = heap_caps_malloc(VERIFY_CHUNK, MALLOC_CAP_SPIRAM);
+    FILE *f = buf ? s3_fopen(path, "rb") : NULL;
+    if (!f) {
+        free(buf);
+        return ESP_FAIL;
+    }
+    long left = len;
+    while (left > 0) {
+        size_t n = s3_fread(buf, 1, left < VERIFY_CHUNK ? (size_t)left : VERIFY_CHUNK, f);
+        if (n == 0) {
+            break;
+        }
+        s3_content_digest_update(digest, buf, n);
+        left -= (long)n;
+    }
+    s3_fclose(f);
+    free(buf);
+    return left == 0 ? ESP_OK : ESP_FAIL;
+}
+
+void s3_content_digest_free(s3_content_digest_t *digest) {
+    mbedtls_sha256_free(&digest->sha256);
+    if (digest->with_md5) {
+        mbedtls_md5_free(&digest->md5);
+    }
+}
+
+bool s3_content_digest_finish(s3_content_digest_t *digest, char *sha256_hex, const char *expected) {
+    uint8_t sha256[32];
+    uint8_t md5[16];
+    char md5_hex[S3_MD5_HEX_LEN + 1] = {0};
+
+    mbedtls_sha256_finish(&digest->sha256, sha256);
+    to_hex(sha256, sizeof(sha256), sha256_hex);
+    if (digest->with_md5) {
+        mbedtls_md5_finish(&digest->md5, md5);
+        to_hex(md5, sizeof(md5), md5_hex);
+    }
+    s3_content_digest_free(digest);
+
+    if (!expected || !expected[0]) {
+        return true;
+    }
+    size_t len = strlen(expected);
+    if (len == S3_SHA256_HEX_LEN) {
+        return strcasecmp(expected, sha256_hex) == 0;
+    }
+    if (len == S3_MD5_HEX_LEN && digest->with_md5) {
+        return strcasecmp(expected, md5_hex) == 0;
+    }
+    // A truncated or malformed manifest digest proves nothing about the file
+    ESP_LOGE(TAG, "Unsupported manifest digest '%s', file not accepted", expected);
+    return false;
+}
+
+esp_err_t s3_content_verify_record(const char *path, const char *sha256_hex, int size) {
+    if (!path || !sha256_hex || !verify_lock()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = ESP_FAIL;
+    FILE *f = s3_fopen(CONTENT_DIGEST_PATH, "a");
+    if (f) {
+        char line[RECORD_LINE_MAX];
+        int len = snprintf(line, sizeof(line), "%s %d %s\n", sha256_hex, size, path);
+        if (len > 0 && len < (int)sizeof(line) && s3_fwrite(line, 1, len, f) == (size_t)len) {
+            ret = ESP_OK;
+            s_appended++;
+        }
+        s3_fclose(f);
+    }
+    verify_unlock();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to record digest of %s", path);
+    }
+    return ret;
+}
+
+static int record_cmp(const void *a, const void *b) {
+    const digest_record_t *ra = a;
+    const digest_record_t *rb = b;
+    int c = strcmp(ra->path, rb->path);
+    return c ? c : ra->seq - rb->seq;
+}
+
+static void records_free(digest_record_t *records, int count) {
+    for (int i = 0; i < count; i++) {
+        free(records[i].path);
+    }
+    heap_caps_free(records);
+}
+
+/**
+ * @brief Load CONTENT_DIGEST_PATH, one record per path (the latest), sorted by path
+ */
+static int records_load(digest_record_t **out) {
+    *out = NULL;
+    FILE *f = s3_fopen(CONTENT_DIGEST_PATH, "r");
+    if (!f) {
+        return 0;
+    }
+
+    int count = 0;
+    int cap = 0;
+    digest_record_t *records = NULL;
+    char line[RECORD_LINE_MAX];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *size_str = strchr(line, ' ');
+        char *path = size_str ? strchr(size_str + 1, ' ') : NULL;
+        if (!path || size_str - line != S3_SHA256_HEX_LEN) {
+            continue;
+        }
+        if (count == cap) {
+            int new_cap = cap ? cap * 2 : 128;
+            digest_record_t *grown = heap_caps_realloc(records, new_cap * sizeof(digest_record_t), MALLOC_CAP_SPIRAM);
+            if (!grown) {
+                break;
+            }
+            records = grown;
+            cap = new_cap;
+        }
+        digest_record_t *r = &records[count];
+        memcpy(r->sha256, line, S3_SHA256_HEX_LEN);
+        r->sha256[S3_SHA256_HEX_LEN] = '\0';
+        r->size = atoi(size_str + 1);
+        r->seq = count;
+        r->path = strdup_spiram(path + 1);
+        if (r->path) {
+            count++;
+        }
+    }
+    s3_fclose(f);
+
+    if (count > 1) {
+        qsort(records, count, sizeof(digest_record_t), record_cmp);
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            if (i + 1 < count && strcmp(records[i].path, records[i + 1].path) == 0) {
+                free(records[i].path);
+                continue;
+            }
+            records[kept++] = records[i];
+        }
+        count = kept;
+    }
+    *out = records;
+    return count;
+}
+
+static void records_save(const digest_record_t *records, int count) {
+    FILE *f = s3_fopen(CONTENT_DIGEST_PATH, "w");
+    if (!f) {
+        return;
+    }
+    char line[RECORD_LINE_MAX];
+    for (int i = 0; i < count; i++) {
+        if (!records[i].path) {
+            continue;
+        }
+        int len = snprintf(line, sizeof(line), "%s %d %s\n", records[i].sha256, records[i].size, records[i].path);
+        if (len > 0 && len < (int)sizeof(line)) {
+            s3_fwrite(line, 1, len, f);
+        }
+    }
+    s3_fclose(f);
+}
+
+static bool verify_file(const char *path, long size, char *sha256_hex, uint8_t *buf) {
+    FILE *f = s3_fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    s3_content_digest_t digest;
+    s3_content_digest_start(&digest, NULL);
+    long left = size;
+    while (left > 0 && !s_cancel) {
+        size_t n = s3_fread(buf, 1, left < VERIFY_CHUNK ? (size_t)left : VERIFY_CHUNK, f);
+        if (n == 0) {
+            break;
+        }
+        s3_content_digest_update(&digest, buf, n);
+        left -= (long)n;
+        s_stats.bytes += n;
+        if (is_audio_playing()) {
+            vTaskDelay(pdMS_TO_TICKS(VERIFY_PLAYBACK_YIELD_MS));
+        }
+    }
+    s3_fclose(f);
+    s3_content_digest_finish(&digest, sha256_hex, NULL);
+    return left == 0;
+}
+
+static void verify_task(void *param) {
+    int64_t start_us = esp_timer_get_time();
+    uint8_t *buf = heap_caps_malloc(VERIFY_CHUNK, MALLOC_CAP_SPIRAM);
+
+    verify_lock();
+    uint32_t appended_at_load = s_appended;
+    digest_record_t *records = NULL;
+    int count = buf ? records_load(&records) : 0;
+    verify_unlock();
+    ESP_LOGI(TAG, "Re-verifying %d recorded files%s", count, s_repair ? " (repair)" : "");
+
+    bool changed = false;
+    char sha256_hex[S3_SHA256_HEX_LEN + 1];
+    for (int i = 0; i < count && !s_cancel; i++) {
+        digest_record_t *r = &records[i];
+        struct stat st;
+        if (stat(r->path, &st) != 0 || st.st_size != r->size) {
+            // Deleted or replaced outside of sync (e.g. file server): nothing to compare against
+            s_stats.files_missing++;
+            free(r->path);
+            r->path = NULL;
+            changed = true;
+            continue;
+        }
+        if (!verify_file(r->path, r->size, sha256_hex, buf)) {
+            if (s_cancel) {
+                break;
+            }
+            ESP_LOGW(TAG, "Could not read %s", r->path);
+            continue;
+        }
+        s_stats.files_checked++;
+        if (strcmp(sha256_hex, r->sha256) != 0) {
+            s_stats.files_corrupt++;
+            ESP_LOGE(TAG, "Corrupt on SD: %s (expected %.16s..., got %.16s...)", r->path, r->sha256, sha256_hex);
+            if (s_repair && s3_remove(r->path) == 0) {
+                // Missing files are downloaded again by the next sync, even if the manifest is unchanged
+                s3_content_index_file_removed(r->path);
+                lvgl_native_img_remove(r->path);
+                s3_cloud_account_manifest_invalidate();
+                free(r->path);
+                r->path = NULL;
+                changed = true;
+            }
+        }
+    }
+
+    // Compact the record file unless sync appended to it meanwhile
+    verify_lock();
+    if (records && (changed || !s_cancel) && s_appended == appended_at_load) {
+        records_save(records, count);
+    }
+    verify_unlock();
+    records_free(records, count);
+    heap_caps_free(buf);
+
+    s_stats.elapsed_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "Re-verify %s: %u checked, %u corrupt, %u gone, %.1f MB in %lld ms",
+             s_cancel ? "cancelled" : "done", (unsigned int)s_stats.files_checked,
+             (unsigned int)s_stats.files_corrupt, (unsigned int)s_stats.files_missing,
+             s_stats.bytes / (1024.0f * 1024.0f), s_stats.elapsed_us / 1000);
+    s_stats.running = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t s3_content_verify_start(bool repair) {
+    if (s_stats.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.running = true;
+    s_cancel = false;
+    s_repair = repair;
+    if (xTaskCreate(verify_task, "content_verify", VERIFY_TASK_STACK, NULL, 1, NULL) != pdPASS) {
+        s_stats.running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void s3_content_verify_cancel(void) {
+    s_cancel = true;
+}
+
+void s3_content_verify_get_stats(s3_content_verify_stats_t *stats) {
+    if (stats) {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,203 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "esp_log.h"
+
+#include "s3_logger.h"
+#include "s3_download_journal.h"
+
+static const char *TAG = "DL_JOURNAL";
+
+#define JOURNAL_SUFFIX      ".journal"
+
+static void journal_path(const char *path, char *out, size_t out_size) {
+    snprintf(out, out_size, "%s" JOURNAL_SUFFIX, path);
+}
+
+// Signed links carry a fresh query string on every sync; only scheme, host and path identify the file
+static void normalize_url(const char *url, char *out, size_t out_size) {
+    size_t len = strcspn(url, "?#");
+    if (len >= out_size) {
+        len = out_size - 1;
+    }
+    memcpy(out, url, len);
+    out[len] = '\0';
+}
+
+static bool journal_load(const char *path, s3_dl_journal_t *journal) {
+    char jpath[320];
+    journal_path(path, jpath, sizeof(jpath));
+
+    FILE *f = s3_fopen(jpath, "r");
+    if (!f) {
+        return false;
+    }
+
+    memset(journal, 0, sizeof(*journal));
+    journal->expected_size = -1;
+    journal->bytes = -1;
+
+    char line[S3_DL_JOURNAL_URL_MAX + 16];
+    bool has_url = false;
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strncmp(line, "url=", 4) == 0) {
+            strlcpy(journal->url, line + 4, sizeof(journal->url));
+            has_url = true;
+        } else if (strncmp(line, "size=", 5) == 0) {
+            journal->expected_size = atoi(line + 5);
+        } else if (strncmp(line, "validator=", 10) == 0) {
+            strlcpy(journal->validator, line + 10, sizeof(journal->validator));
+        } else if (strncmp(line, "bytes=", 6) == 0) {
+            journal->bytes = atoi(line + 6);
+        }
+    }
+    s3_fclose(f);
+
+    // A record cut short by a power loss is treated as missing
+    return has_url && journal->bytes >= 0;
+}
+
+esp_err_t s3_dl_journal_save(const char *path, const s3_dl_journal_t *journal) {
+    char jpath[320];
+    journal_path(path, jpath, sizeof(jpath));
+
+    FILE *f = s3_fopen(jpath, "w");
+    if (!f) {
+        ESP_LOGW(TAG, "Failed to write %s", jpath);
+        return ESP_FAIL;
+    }
+    char buf[S3_DL_JOURNAL_URL_MAX + S3_DL_VALIDATOR_MAX + 64];
+    int len = snprintf(buf, sizeof(buf), "url=%s\nsize=%d\nvalidator=%s\nbytes=%d\n",
+                       journal->url, journal->expected_size, journal->validator, journal->bytes);
+    size_t written = s3_fwrite(buf, 1, len, f);
+    s3_fclose(f);
+    return written == (size_t)len ? ESP_OK : ESP_FAIL;
+}
+
+void s3_dl_journal_done(const char *path) {
+    char jpath[320];
+    journal_path(path, jpath, sizeof(jpath));
+    if (access(jpath, F_OK) == 0) {
+        s3_remove(jpath);
+    }
+}
+
+void s3_dl_journal_discard(const char *path) {
+    if (access(path, F_OK) == 0) {
+        s3_remove(path);
+    }
+    s3_dl_journal_done(path);
+}
+
+// Cuts the partial file back to the last checkpoint the journal recorded as synced
+static bool journal_truncate(const char *path, long len) {
+    FILE *f = s3_fopen(path, "r+b");
+    if (!f) {
+        return false;
+    }
+    bool ok = ftruncate(fileno(f), len) == 0;
+    s3_fclose(f);
+    return ok;
+}
+
+long s3_dl_journal_prepare(const char *path, const char *url, int expected_size, bool has_digest,
+                           s3_dl_journal_t *journal) {
+    memset(journal, 0, sizeof(*journal));
+    normalize_url(url, journal->url, sizeof(journal->url));
+    journal->expected_size = expected_size;
+
+    struct stat st;
+    long size = (stat(path, &st) == 0) ? (long)st.st_size : 0;
+
+    s3_dl_journal_t stored;
+    const char *reason = NULL;
+    if (size <= 0) {
+        reason = NULL;      // Nothing to keep
+    } else if (!journal_load(path, &stored)) {
+        reason = "no journal record";
+    } else if (strcmp(stored.url, journal->url) != 0) {
+        reason = "source URL changed";
+    } else if (stored.expected_size != expected_size) {
+        reason = "expected size changed";
+    } else if (stored.validator[0] == '\0' && !has_digest) {
+        // Same size is no proof of the same bytes: a replaced object would be spliced onto stale ones
+        reason = "no validator or digest to check the partial file against";
+    } else if (stored.bytes <= 0) {
+        reason = "no checkpoint recorded";
+    } else if (expected_size > 0 && stored.bytes > expected_size) {
+        reason = "partial file larger than expected";
+    } else if (size > stored.bytes && !journal_truncate(path, stored.bytes)) {
+        reason = "could not cut back to the checkpoint";
+    }
+
+    if (size <= 0 || reason) {
+        if (reason) {
+            ESP_LOGW(TAG, "Discarding partial %s (%ld bytes): %s", path, size, reason);
+        }
+        s3_dl_journal_discard(path);
+        journal->bytes = 0;
+        return 0;
+    }
+
+    // Only bytes the journal recorded as synced are trusted; a power cut may leave garbage past them
+    long resume = size < stored.bytes ? size : stored.bytes;
+    strlcpy(journal->validator, stored.validator, sizeof(journal->validator));
+    journal->bytes = (int)resume;
+    ESP_LOGI(TAG, "Resuming %s at %ld bytes (%ld on the card, validator %s)",
+             path, resume, size, stored.validator[0] ? stored.validator : "none");
+    return resume;
+}
+
+bool s3_dl_journal_validator_changed(const s3_dl_journal_t *journal, const char *validator) {
+    return journal->validator[0] != '\0' && validator && validator[0] != '\0' &&
+           strcmp(journal->validator, validator) != 0;
+}
+
+int s3_dl_journal_prune(const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        return 0;
+    }
+
+    int removed = 0;
+    size_t suffix_len = strlen(JOURNAL_SUFFIX);
+    struct dirent *entry;
+    char jpath[320];
+    char partial[320];
+    while ((entry = readdir(d)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len <= suffix_len || strcmp(entry->d_name + len - suffix_len, JOURNAL_SUFFIX) != 0) {
+            continue;
+        }
+        snprintf(jpath, sizeof(jpath), "%s/%s", dir, entry->d_name);
+        snprintf(partial, sizeof(partial), "%s/%.*s", dir, (int)(len - suffix_len), entry->d_name);
+        if (access(partial, F_OK) == 0 && s3_remove(partial) == 0) {
+            removed++;
+        }
+        s3_remove(jpath);
+    }
+    closedir(d);
+
+    if (removed > 0) {
+        ESP_LOGI(TAG, "Pruned %d stale partial downloads from %s", removed, dir);
+    }
+    return removed;
+}
+
+esp_err_t s3_dl_journal_http_event(esp_http_client_event_t *evt) {
+    if (evt->event_id != HTTP_EVENT_ON_HEADER || !evt->user_data || !evt->header_key || !evt->header_value) {
+        return ESP_OK;
+    }
+    char *validator = (char *)evt->user_data;
+    if (strcasecmp(evt->header_key, "ETag") == 0) {
+        strlcpy(validator, evt->header_value, S3_DL_VALIDATOR_MAX);
+    } else if (strcasecmp(evt->header_key, "Last-Modified") == 0 && validator[0] == '\0') {
+        strlcpy(validator, evt->header_value, S3_DL_VALIDATOR_MAX);
+    }
+    return ESP_OK;
+}
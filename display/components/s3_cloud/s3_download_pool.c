@@ -0,0 +1,811 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "esp_heap_caps.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+#include "esp_crt_bundle.h"
+#endif
+
+#include "audio_player.h"
+#include "s3_definitions.h"
+#include "s3_logger.h"
+#include "s3_https_cloud.h"
+#include "s3_sync_account_contents.h"
+#include "s3_download_pool.h"
+#include "s3_download_journal.h"
+#include "s3_content_verify.h"
+
+static const char *TAG = "DL_POOL";
+extern bool gWiFi_SYNC_USER_INTERRUPT;
+
+#define POOL_MAX_WORKERS        4
+#define POOL_QUEUE_LEN          8
+#define POOL_TASK_STACK         8192
+#define POOL_TLS_INTERNAL_COST  (48 * 1024)     // mbedTLS buffers + task stack per worker
+#define POOL_INTERNAL_RESERVE   (64 * 1024)     // Left for audio, LVGL and WiFi
+#define POOL_PSRAM_BUDGET       (192 * 1024)    // Shared by all worker stream buffers (two each)
+#define POOL_BUF_MAX            (32 * 1024)
+#define POOL_BUF_MIN            (8 * 1024)
+#define POOL_HTTP_RX_BUFFER     4096
+
+#define STREAM_QUEUE_LEN        8
+#define STREAM_WRITER_STACK     4096
+#define STREAM_SLOW_WRITE_US    (50 * 1000)     // Writes slower than this and 2x the average mean a busy card
+#define STREAM_MIN_FREE_DMA     (24 * 1024)     // Below this, let WiFi/TLS release buffers first
+#define STREAM_SD_BACKOFF_MS    10
+#define STREAM_HEAP_BACKOFF_MS  20
+#define STREAM_PLAYBACK_YIELD_MS 5              // Gap left per chunk so playback reads get the bus
+
+#define POOL_BIT_IDLE           BIT0
+
+typedef struct {
+    char *url;
+    char *path;
+    int expected_size;
+    char *expected_digest;      // Manifest SHA-256 / MD5 (hex), or NULL
+    s3_download_done_cb_t cb;
+    void *ctx;
+} pool_job_t;
+
+typedef struct {
+    int id;
+    TaskHandle_t task;
+    esp_http_client_handle_t client;
+    bool connected;             // Keep-alive connection believed open
+    char validator[S3_DL_VALIDATOR_MAX];    // ETag / Last-Modified of the current response
+} pool_worker_t;
+
+struct s3_dl_stream {
+    FILE *file;
+    uint8_t *buf[2];
+    size_t cap;
+    size_t fill;                // Bytes in buf[cur]
+    int cur;                    // Buffer the producer is filling
+    SemaphoreHandle_t idle[2];  // Given while buf[i] is not queued or being written
+    volatile bool write_error;
+    volatile uint32_t last_write_us;
+    uint32_t writes;
+    s3_dl_stream_stats_t stats;
+};
+
+typedef struct {
+    s3_dl_stream_t *stream;
+    int idx;
+    size_t len;
+} stream_write_req_t;
+
+static pool_worker_t s_workers[POOL_MAX_WORKERS];
+static int s_worker_count = 0;
+static QueueHandle_t s_job_queue = NULL;
+static SemaphoreHandle_t s_state_lock = NULL;
+static size_t s_stream_buf_size = POOL_BUF_MIN;
+static QueueHandle_t s_write_queue = NULL;
+static TaskHandle_t s_writer_task = NULL;
+static EventGroupHandle_t s_events = NULL;
+static volatile bool s_stopping = false;
+static volatile int s_running_workers = 0;
+static int s_pending = 0;
+static bool s_any_failed = false;
+static int64_t s_start_us = 0;
+static s3_download_pool_stats_t s_stats;
+static s3_download_pool_stats_t s_totals;   // Finished runs, folded in by s3_download_pool_stop()
+
+static void pool_stats_add(s3_download_pool_stats_t *sum, const s3_download_pool_stats_t *run) {
+    sum->files_ok += run->files_ok;
+    sum->files_failed += run->files_failed;
+    sum->connections += run->connections;
+    sum->retries += run->retries;
+    sum->resumed += run->resumed;
+    sum->restarted += run->restarted;
+    sum->bytes += run->bytes;
+    sum->sd_write_us += run->sd_write_us;
+}
+
+static void pool_job_free(pool_job_t *job) {
+    if (job) {
+        free(job->url);
+        free(job->path);
+        free(job->expected_digest);
+        free(job);
+    }
+}
+
+static void pool_job_finished(pool_job_t *job, esp_err_t result, int bytes, const char *sha256_hex) {
+    if (job->cb) {
+        esp_err_t cb_err = job->cb(result, job->path, bytes, result == ESP_OK ? sha256_hex : NULL, job->ctx);
+        if (result == ESP_OK && cb_err != ESP_OK) {
+            result = cb_err;
+        }
+    }
+
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    if (result == ESP_OK) {
+        s_stats.files_ok++;
+    } else {
+        s_stats.files_failed++;
+        s_any_failed = true;
+    }
+    if (--s_pending == 0) {
+        xEventGroupSetBits(s_events, POOL_BIT_IDLE);
+    }
+    xSemaphoreGive(s_state_lock);
+    pool_job_free(job);
+}
+
+// Single SD writer for every download stream: one large write at a time keeps the 1-line bus fair to audio
+static void stream_writer_task(void *param) {
+    stream_write_req_t req;
+    while (true) {
+        if (xQueueReceive(s_write_queue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        s3_dl_stream_t *st = req.stream;
+        int64_t t0 = esp_timer_get_time();
+        size_t written = s3_fwrite(st->buf[req.idx], 1, req.len, st->file);
+        uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+
+        st->last_write_us = dt;
+        st->writes++;
+        st->stats.write_us += dt;
+        st->stats.bytes_written += written;
+        if (written != req.len) {
+            st->write_error = true;
+        }
+        xSemaphoreGive(st->idle[req.idx]);
+    }
+}
+
+static esp_err_t stream_writer_init(void) {
+    if (s_writer_task) {
+        return ESP_OK;
+    }
+    s_write_queue = xQueueCreate(STREAM_QUEUE_LEN, sizeof(stream_write_req_t));
+    if (!s_write_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(stream_writer_task, "dl_sd_writer", STREAM_WRITER_STACK, NULL, 2, &s_writer_task) != pdPASS) {
+        vQueueDelete(s_write_queue);
+        s_write_queue = NULL;
+        s_writer_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// Back off only when something else actually needs the resources the download competes for
+static void stream_throttle(s3_dl_stream_t *st) {
+    int delay_ms = 0;
+
+    uint32_t avg_us = st->writes ? (uint32_t)(st->stats.write_us / st->writes) : 0;
+    if (st->writes > 2 && st->last_write_us > STREAM_SLOW_WRITE_US && st->last_write_us > 2 * avg_us) {
+        delay_ms = STREAM_SD_BACKOFF_MS;
+    }
+    if (heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL) < STREAM_MIN_FREE_DMA &&
+        delay_ms < STREAM_HEAP_BACKOFF_MS) {
+        delay_ms = STREAM_HEAP_BACKOFF_MS;
+    }
+    if (is_audio_playing() && delay_ms < STREAM_PLAYBACK_YIELD_MS) {
+        delay_ms = STREAM_PLAYBACK_YIELD_MS;
+    }
+
+    if (delay_ms > 0) {
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+        st->stats.throttle_us += delay_ms * 1000;
+    }
+}
+
+static esp_err_t stream_submit(s3_dl_stream_t *st, bool throttle) {
+    stream_write_req_t req = { .stream = st, .idx = st->cur, .len = st->fill };
+    xQueueSend(s_write_queue, &req, portMAX_DELAY);
+
+    // Switch to the other buffer; waits only if its previous write is still running
+    st->cur ^= 1;
+    st->fill = 0;
+    xSemaphoreTake(st->idle[st->cur], portMAX_DELAY);
+
+    if (throttle) {
+        stream_throttle(st);
+    }
+    return st->write_error ? ESP_FAIL : ESP_OK;
+}
+
+s3_dl_stream_t *s3_dl_stream_open(FILE *file, size_t buf_size) {
+    if (!file || buf_size == 0 || stream_writer_init() != ESP_OK) {
+        return NULL;
+    }
+
+    s3_dl_stream_t *st = heap_caps_calloc(1, sizeof(s3_dl_stream_t), MALLOC_CAP_SPIRAM);
+    if (!st) {
+        return NULL;
+    }
+    st->file = file;
+    st->cap = buf_size;
+    for (int i = 0; i < 2; i++) {
+        st->buf[i] = heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+        st->idle[i] = xSemaphoreCreateBinary();
+        if (!st->buf[i] || !st->idle[i]) {
+            for (int j = 0; j <= i; j++) {
+                free(st->buf[j]);
+                if (st->idle[j]) vSemaphoreDelete(st->idle[j]);
+            }
+            free(st);
+            return NULL;
+        }
+    }
+    // Buffer 1 starts idle; the producer owns buffer 0
+    xSemaphoreGive(st->idle[1]);
+    return st;
+}
+
+uint8_t *s3_dl_stream_space(s3_dl_stream_t *stream, size_t *avail) {
+    *avail = stream->cap - stream->fill;
+    return stream->buf[stream->cur] + stream->fill;
+}
+
+esp_err_t s3_dl_stream_produced(s3_dl_stream_t *stream, size_t len) {
+    stream->fill += len;
+    if (stream->fill >= stream->cap) {
+        return stream_submit(stream, true);
+    }
+    return stream->write_error ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t s3_dl_stream_sync(s3_dl_stream_t *stream) {
+    if (stream->fill > 0 && !stream->write_error) {
+        stream_submit(stream, false);
+    }
+    // Once the other buffer is idle nothing of this stream is queued or being written
+    xSemaphoreTake(stream->idle[stream->cur ^ 1], portMAX_DELAY);
+    if (g_sdcard_dma_mutex) xSemaphoreTake(g_sdcard_dma_mutex, portMAX_DELAY);
+    if (fflush(stream->file) != 0 || fsync(fileno(stream->file)) != 0) {
+        stream->write_error = true;
+    }
+    if (g_sdcard_dma_mutex) xSemaphoreGive(g_sdcard_dma_mutex);
+    xSemaphoreGive(stream->idle[stream->cur ^ 1]);
+    return stream->write_error ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t s3_dl_stream_close(s3_dl_stream_t *stream, s3_dl_stream_stats_t *stats) {
+    if (!stream) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (stream->fill > 0 && !stream->write_error) {
+        stream_submit(stream, false);
+    }
+    // Wait for the buffer that may still be in flight
+    xSemaphoreTake(stream->idle[stream->cur ^ 1], portMAX_DELAY);
+
+    esp_err_t ret = stream->write_error ? ESP_FAIL : ESP_OK;
+    if (stats) {
+        *stats = stream->stats;
+    }
+    for (int i = 0; i < 2; i++) {
+        free(stream->buf[i]);
+        vSemaphoreDelete(stream->idle[i]);
+    }
+    free(stream);
+    return ret;
+}
+
+static void pool_client_close(pool_worker_t *w) {
+    esp_http_client_close(w->client);
+    w->connected = false;
+}
+
+static esp_err_t pool_client_prepare(pool_worker_t *w, const char *url) {
+    if (!w->client) {
+        esp_http_client_config_t config = {
+            .url = url,
+            .buffer_size = POOL_HTTP_RX_BUFFER,
+            .timeout_ms = 30000,
+            .crt_bundle_attach = esp_crt_bundle_attach,
+            .keep_alive_enable = true,
+            .event_handler = s3_dl_journal_http_event,
+            .user_data = w->validator,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+            .save_client_session = true,    // Reconnects after an error resume the TLS session
+#endif
+        };
+        w->client = esp_http_client_init(&config);
+        if (!w->client) {
+            ESP_LOGE(TAG, "[w%d] Failed to init HTTP client", w->id);
+            return ESP_FAIL;
+        }
+        esp_http_client_set_header(w->client, "Accept-Encoding", "identity");
+        return ESP_OK;
+    }
+    // Same host keeps the open connection; a different host makes the client reconnect
+    return esp_http_client_set_url(w->client, url);
+}
+
+/**
+ * @brief One attempt at fetching a job's file, resuming from the journaled partial file
+ *
+ * The file is hashed as it arrives; only the prefix of a resumed file is read back from the card.
+ *
+ * @param sha256_hex Receives the SHA-256 of the complete file
+ * @return ESP_OK when complete, ESP_ERR_INVALID_SIZE when cut short (retry resumes),
+ *         ESP_ERR_INVALID_CRC when the manifest digest does not match, error otherwise
+ */
+static esp_err_t pool_fetch(pool_worker_t *w, pool_job_t *job, int *out_size, char *sha256_hex) {
+    s3_dl_journal_t journal;
+    s3_content_digest_t digest;
+    long offset = s3_dl_journal_prepare(job->path, job->url, job->expected_size,
+                                        job->expected_digest && job->expected_digest[0], &journal);
+    *out_size = (int)offset;
+
+    if (job->expected_size > 0 && offset == job->expected_size) {
+        // Completed before a reboot or a failed install
+        s3_content_digest_start(&digest, job->expected_digest);
+        if (s3_content_digest_file(&digest, job->path, offset) != ESP_OK) {
+            s3_content_digest_free(&digest);
+            s3_dl_journal_discard(job->path);
+            *out_size = 0;
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (!s3_content_digest_finish(&digest, sha256_hex, job->expected_digest)) {
+            ESP_LOGE(TAG, "[w%d] Digest mismatch for %s", w->id, job->path);
+            s3_dl_journal_discard(job->path);
+            *out_size = 0;
+            return ESP_ERR_INVALID_CRC;
+        }
+        s3_dl_journal_done(job->path);
+        return ESP_OK;
+    }
+
+    if (pool_client_prepare(w, job->url) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    char range[40];
+    if (offset > 0) {
+        snprintf(range, sizeof(range), "bytes=%ld-", offset);
+        esp_http_client_set_header(w->client, "Range", range);
+    } else {
+        esp_http_client_delete_header(w->client, "Range");
+    }
+    // With a validator the server itself sends the whole file (200) if its copy changed
+    if (offset > 0 && journal.validator[0]) {
+        esp_http_client_set_header(w->client, "If-Range", journal.validator);
+    } else {
+        esp_http_client_delete_header(w->client, "If-Range");
+    }
+    w->validator[0] = '\0';
+
+    bool fresh = !w->connected;
+    esp_err_t err = esp_http_client_open(w->client, 0);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "[w%d] Open failed: %s", w->id, esp_err_to_name(err));
+        pool_client_close(w);
+        return err;
+    }
+    w->connected = true;
+    if (fresh) {
+        xSemaphoreTake(s_state_lock, portMAX_DELAY);
+        s_stats.connections++;
+        xSemaphoreGive(s_state_lock);
+    }
+
+    int content_length = esp_http_client_fetch_headers(w->client);
+    int status = esp_http_client_get_status_code(w->client);
+    if (offset > 0 && (status == 200 || status == 206 || status == 416)) {
+        bool kept = status == 206 && !s3_dl_journal_validator_changed(&journal, w->validator);
+        xSemaphoreTake(s_state_lock, portMAX_DELAY);
+        if (kept) {
+            s_stats.resumed++;
+        } else {
+            s_stats.restarted++;
+        }
+        xSemaphoreGive(s_state_lock);
+    }
+    if (status == 200 && offset > 0) {
+        // Server copy changed (If-Range) or Range not supported: start the file over
+        ESP_LOGW(TAG, "[w%d] Full response for %s, dropping %ld partial bytes", w->id, job->path, offset);
+        offset = 0;
+    } else if (status == 206 && s3_dl_journal_validator_changed(&journal, w->validator)) {
+        ESP_LOGW(TAG, "[w%d] %s changed on the server (%s -> %s), restarting", w->id, job->path, journal.validator, w->validator);
+        pool_client_close(w);
+        s3_dl_journal_discard(job->path);
+        *out_size = 0;
+        return ESP_ERR_INVALID_SIZE;
+    } else if (status == 416) {
+        ESP_LOGW(TAG, "[w%d] Range not satisfiable for %s, restarting", w->id, job->path);
+        pool_client_close(w);
+        s3_dl_journal_discard(job->path);
+        *out_size = 0;
+        return ESP_ERR_INVALID_SIZE;
+    } else if (status != 200 && status != 206) {
+        ESP_LOGE(TAG, "[w%d] HTTP %d for %s", w->id, status, job->path);
+        pool_client_close(w);
+        return ESP_FAIL;
+    }
+    if (w->validator[0]) {
+        strlcpy(journal.validator, w->validator, sizeof(journal.validator));
+    }
+
+    FILE *file = s3_fopen(job->path, offset > 0 ? "ab" : "wb");
+    s3_dl_stream_t *stream = file ? s3_dl_stream_open(file, s_stream_buf_size) : NULL;
+    if (!stream) {
+        ESP_LOGE(TAG, "[w%d] Failed to open %s", w->id, job->path);
+        if (file) s3_fclose(file);
+        pool_client_close(w);
+        return ESP_FAIL;
+    }
+    journal.bytes = (int)offset;
+    s3_dl_journal_save(job->path, &journal);
+
+    s3_content_digest_start(&digest, job->expected_digest);
+    if (offset > 0 && s3_content_digest_file(&digest, job->path, offset) != ESP_OK) {
+        ESP_LOGW(TAG, "[w%d] Could not read back the partial %s, restarting", w->id, job->path);
+        s3_content_digest_free(&digest);
+        s3_dl_stream_close(stream, NULL);
+        s3_fclose(file);
+        pool_client_close(w);
+        s3_dl_journal_discard(job->path);
+        *out_size = 0;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int total = (int)offset;
+    int next_checkpoint = total + S3_DL_CHECKPOINT_BYTES;
+    bool write_ok = true;
+    while (!gWiFi_SYNC_USER_INTERRUPT && !s_stopping) {
+        size_t avail;
+        uint8_t *space = s3_dl_stream_space(stream, &avail);
+        int n = esp_http_client_read(w->client, (char *)space, avail);
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+        s3_content_digest_update(&digest, space, n);
+        if (s3_dl_stream_produced(stream, n) != ESP_OK) {
+            write_ok = false;
+            break;
+        }
+        if (total >= next_checkpoint) {
+            // Survives a reboot or deep sleep from here on
+            if (s3_dl_stream_sync(stream) != ESP_OK) {
+                write_ok = false;
+                break;
+            }
+            journal.bytes = total;
+            s3_dl_journal_save(job->path, &journal);
+            next_checkpoint = total + S3_DL_CHECKPOINT_BYTES;
+        }
+    }
+    s3_dl_stream_stats_t stream_stats;
+    if (s3_dl_stream_close(stream, &stream_stats) != ESP_OK) {
+        write_ok = false;
+    }
+    s3_fclose(file);
+
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    s_stats.bytes += (uint64_t)(total - offset);
+    s_stats.sd_write_us += stream_stats.write_us;
+    xSemaphoreGive(s_state_lock);
+    *out_size = total;
+
+    bool complete = esp_http_client_is_complete_data_received(w->client);
+    if (!complete || !write_ok) {
+        // Drop the connection: its state is unknown after a partial body
+        pool_client_close(w);
+    }
+    if (!write_ok) {
+        ESP_LOGE(TAG, "[w%d] SD write failed for %s", w->id, job->path);
+        s3_content_digest_free(&digest);
+        return ESP_FAIL;
+    }
+    if (!complete || (content_length > 0 && total < (int)offset + content_length)) {
+        journal.bytes = total;
+        s3_dl_journal_save(job->path, &journal);
+        s3_content_digest_free(&digest);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (job->expected_size > 0 && total != job->expected_size) {
+        ESP_LOGE(TAG, "[w%d] Size mismatch for %s: expected %d, got %d", w->id, job->path, job->expected_size, total);
+        s3_dl_journal_discard(job->path);
+        s3_content_digest_free(&digest);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!s3_content_digest_finish(&digest, sha256_hex, job->expected_digest)) {
+        // Right size, wrong bytes: never install it
+        ESP_LOGE(TAG, "[w%d] Digest mismatch for %s (got sha256 %s)", w->id, job->path, sha256_hex);
+        s3_dl_journal_discard(job->path);
+        *out_size = 0;
+        return ESP_ERR_INVALID_CRC;
+    }
+    s3_dl_journal_done(job->path);
+    return ESP_OK;
+}
+
+static void pool_worker_task(void *param) {
+    pool_worker_t *w = (pool_worker_t *)param;
+    pool_job_t *job = NULL;
+
+    while (true) {
+        if (xQueueReceive(s_job_queue, &job, pdMS_TO_TICKS(200)) != pdTRUE) {
+            if (s_stopping) {
+                break;
+            }
+            continue;
+        }
+
+        if (s_stopping || gWiFi_SYNC_USER_INTERRUPT) {
+            pool_job_finished(job, ESP_FAIL, 0, NULL);
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        esp_err_t result = ESP_FAIL;
+        int size = 0;
+        char sha256_hex[S3_SHA256_HEX_LEN + 1] = {0};
+        for (int attempt = 1; attempt <= MAX_DOWNLOAD_ATTEMPTS; attempt++) {
+            if (attempt > 1) {
+                xSemaphoreTake(s_state_lock, portMAX_DELAY);
+                s_stats.retries++;
+                xSemaphoreGive(s_state_lock);
+            }
+            result = pool_fetch(w, job, &size, sha256_hex);
+            if (result == ESP_OK || gWiFi_SYNC_USER_INTERRUPT || s_stopping) {
+                break;
+            }
+            ESP_LOGW(TAG, "[w%d] Attempt %d/%d failed for %s (%s, %d bytes on card)",
+                     w->id, attempt, MAX_DOWNLOAD_ATTEMPTS, job->path, esp_err_to_name(result), size);
+            if (result != ESP_ERR_INVALID_SIZE) {
+                // Hard failure: start the next attempt on a fresh connection
+                esp_http_client_cleanup(w->client);
+                w->client = NULL;
+                w->connected = false;
+            }
+        }
+
+        if (result == ESP_OK) {
+            int64_t elapsed_us = esp_timer_get_time() - start_us;
+            ESP_LOGI(TAG, "[w%d] %s: %d bytes in %lld ms", w->id, job->path, size, elapsed_us / 1000);
+        }
+        pool_job_finished(job, result, size, sha256_hex);
+    }
+
+    if (w->client) {
+        esp_http_client_cleanup(w->client);
+        w->client = NULL;
+    }
+    w->task = NULL;
+
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    s_running_workers--;
+    xSemaphoreGive(s_state_lock);
+    vTaskDelete(NULL);
+}
+
+esp_err_t s3_download_pool_start(int max_workers) {
+    if (s_worker_count > 0) {
+        ESP_LOGW(TAG, "Download pool already running");
+        return ESP_OK;
+    }
+
+    if (!s_state_lock) {
+        s_state_lock = xSemaphoreCreateMutex();
+        s_events = xEventGroupCreate();
+        s_job_queue = xQueueCreate(POOL_QUEUE_LEN, sizeof(pool_job_t *));
+        if (!s_state_lock || !s_events || !s_job_queue) {
+            ESP_LOGE(TAG, "Failed to create download pool primitives");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // Each connection costs TLS buffers in internal RAM: only start what fits
+    size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    int affordable = free_internal > POOL_INTERNAL_RESERVE
+                     ? (int)((free_internal - POOL_INTERNAL_RESERVE) / POOL_TLS_INTERNAL_COST) : 0;
+    int workers = max_workers;
+    if (workers > POOL_MAX_WORKERS) workers = POOL_MAX_WORKERS;
+    if (workers > affordable) workers = affordable;
+    if (workers < 1) workers = 1;
+
+    size_t buf_size = POOL_PSRAM_BUDGET / (2 * workers);
+    if (buf_size > POOL_BUF_MAX) buf_size = POOL_BUF_MAX;
+    if (buf_size < POOL_BUF_MIN) buf_size = POOL_BUF_MIN;
+    s_stream_buf_size = buf_size;
+
+    if (stream_writer_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the SD writer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stopping = false;
+    s_pending = 0;
+    s_any_failed = false;
+    s_running_workers = 0;
+    xEventGroupSetBits(s_events, POOL_BIT_IDLE);
+
+    for (int i = 0; i < workers; i++) {
+        pool_worker_t *w = &s_workers[i];
+        memset(w, 0, sizeof(*w));
+        w->id = i;
+        char name[16];
+        snprintf(name, sizeof(name), "dl_pool_%d", i);
+        s_running_workers++;
+        if (xTaskCreate(pool_worker_task, name, POOL_TASK_STACK, w, 1, &w->task) != pdPASS) {
+            ESP_LOGW(TAG, "Failed to create worker %d", i);
+            s_running_workers--;
+            break;
+        }
+        s_worker_count++;
+    }
+
+    if (s_worker_count == 0) {
+        ESP_LOGE(TAG, "No download worker could be started");
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_stats.workers = s_worker_count;
+    s_start_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Download pool started: %d workers (asked %d, internal RAM allows %d), 2 x %u KB buffers each",
+             s_worker_count, max_workers, affordable, (unsigned int)(buf_size / 1024));
+    return ESP_OK;
+}
+
+esp_err_t s3_download_pool_submit(const char *url, const char *path, int expected_size,
+                                  const char *expected_digest, s3_download_done_cb_t cb, void *ctx) {
+    if (s_worker_count == 0 || s_stopping) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!url || !path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pool_job_t *job = heap_caps_calloc(1, sizeof(pool_job_t), MALLOC_CAP_SPIRAM);
+    if (!job) {
+        return ESP_ERR_NO_MEM;
+    }
+    job->url = strdup_spiram(url);
+    job->path = strdup_spiram(path);
+    job->expected_size = expected_size;
+    job->expected_digest = expected_digest ? strdup_spiram(expected_digest) : NULL;
+    job->cb = cb;
+    job->ctx = ctx;
+    if (!job->url || !job->path || (expected_digest && !job->expected_digest)) {
+        pool_job_free(job);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    s_pending++;
+    xEventGroupClearBits(s_events, POOL_BIT_IDLE);
+    xSemaphoreGive(s_state_lock);
+
+    // Bounded queue: the parser waits here instead of queuing the whole manifest
+    while (xQueueSend(s_job_queue, &job, pdMS_TO_TICKS(500)) != pdTRUE) {
+        if (gWiFi_SYNC_USER_INTERRUPT || s_stopping) {
+            xSemaphoreTake(s_state_lock, portMAX_DELAY);
+            if (--s_pending == 0) {
+                xEventGroupSetBits(s_events, POOL_BIT_IDLE);
+            }
+            xSemaphoreGive(s_state_lock);
+            pool_job_free(job);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t s3_download_pool_wait(void) {
+    if (!s_events) {
+        return ESP_OK;
+    }
+    xEventGroupWaitBits(s_events, POOL_BIT_IDLE, pdFALSE, pdTRUE, portMAX_DELAY);
+    s_stats.elapsed_us = esp_timer_get_time() - s_start_us;
+
+    float seconds = s_stats.elapsed_us / 1000000.0f;
+    float sd_seconds = s_stats.sd_write_us / 1000000.0f;
+    float mb = s_stats.bytes / (1024.0f * 1024.0f);
+    ESP_LOGI(TAG, "Download pool idle: %u ok, %u failed, %.2f MB in %.1f s (%.2f MB/s, SD %.2f MB/s), %u connections, %d workers, "
+             "%u retries, %u resumed, %u restarted",
+             (unsigned int)s_stats.files_ok, (unsigned int)s_stats.files_failed, mb, seconds,
+             seconds > 0 ? mb / seconds : 0.0f, sd_seconds > 0 ? mb / sd_seconds : 0.0f,
+             (unsigned int)s_stats.connections, s_stats.workers,
+             (unsigned int)s_stats.retries, (unsigned int)s_stats.resumed, (unsigned int)s_stats.restarted);
+    return s_any_failed ? ESP_FAIL : ESP_OK;
+}
+
+void s3_download_pool_stop(void) {
+    if (s_worker_count == 0) {
+        return;
+    }
+
+    // Workers fail whatever is still queued, then exit
+    s_stopping = true;
+    s3_download_pool_wait();
+    while (s_running_workers > 0) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    pool_stats_add(&s_totals, &s_stats);
+    s_worker_count = 0;
+    xSemaphoreGive(s_state_lock);
+    s_stopping = false;
+    ESP_LOGI(TAG, "Download pool stopped");
+}
+
+void s3_download_pool_get_stats(s3_download_pool_stats_t *stats) {
+    if (stats) {
+        *stats = s_stats;
+    }
+}
+
+void s3_download_pool_get_totals(s3_download_pool_stats_t *totals) {
+    if (!totals) {
+        return;
+    }
+    memset(totals, 0, sizeof(*totals));
+    if (!s_state_lock) {
+        return;
+    }
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    pool_stats_add(totals, &s_totals);
+    if (s_worker_count > 0) {
+        // Current run, not folded in yet
+        pool_stats_add(totals, &s_stats);
+    }
+    xSemaphoreGive(s_state_lock);
+}
+
+esp_err_t s3_download_pool_benchmark(const char *url, int file_count, int max_workers) {
+    if (!url || file_count <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const int runs[2] = { 1, max_workers };
+    char path[64];
+    ensure_dir_exists("/sdcard/tmp/bench");
+
+    for (int r = 0; r < 2; r++) {
+        for (int i = 0; i < file_count; i++) {
+            snprintf(path, sizeof(path), "/sdcard/tmp/bench/%03d.bin", i);
+            s3_dl_journal_discard(path);
+        }
+
+        esp_err_t err = s3_download_pool_start(runs[r]);
+        if (err != ESP_OK) {
+            return err;
+        }
+        for (int i = 0; i < file_count && err == ESP_OK; i++) {
+            snprintf(path, sizeof(path), "/sdcard/tmp/bench/%03d.bin", i);
+            err = s3_download_pool_submit(url, path, -1, NULL, NULL, NULL);
+        }
+        esp_err_t result = s3_download_pool_wait();
+
+        s3_download_pool_stats_t stats;
+        s3_download_pool_get_stats(&stats);
+        s3_download_pool_stop();
+
+        float seconds = stats.elapsed_us / 1000000.0f;
+        float sd_seconds = stats.sd_write_us / 1000000.0f;
+        float mb = stats.bytes / (1024.0f * 1024.0f);
+        ESP_LOGI(TAG, "Benchmark %d worker(s): %d files, %.2f MB, %.2f s, %.2f MB/s (SD %.2f MB/s), %.0f ms/file, %u connections, %s",
+                 stats.workers, file_count, mb, seconds,
+                 seconds > 0 ? mb / seconds : 0.0f, sd_seconds > 0 ? mb / sd_seconds : 0.0f,
+                 stats.elapsed_us / 1000.0f / file_count, (unsigned int)stats.connections,
+                 result == ESP_OK ? "ok" : "FAILED");
+        if (err != ESP_OK || result != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+
+    for (int i = 0; i < file_count; i++) {
+        snprintf(path, sizeof(path), "/sdcard/tmp/bench/%03d.bin", i);
+        s3_dl_journal_discard(path);
+    }
+    return ESP_OK;
+}
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_tls.h"
@@ -18,8 +19,13 @@
 #include "esp_timer.h"
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mbedtls/sha256.h"
 #include "s3_https_cloud.h"
+#include "s3_download_journal.h"
+#include "s3_json_stream.h"
 #include "s3_nvs_item.h"
+#include "s3_definitions.h"
 #include "storage.h"
 #include "manual_ota.h"
 #include "alarm_mgr.h"
@@ -27,8 +33,6 @@
 #include <time.h>
 
 static const char *TAG = "HTTP_CLIENT";
-static char *dynamic_buffer = NULL; // Buffer to store response of http request from event handler
-static int buffer_len = 0; // Stores number of bytes read
 
 #define FILE_PATH "/sdcard/shane.bin"
 
@@ -49,6 +53,20 @@ static const char *ota_Basic_Authorization[DOMAIN_ARRAY_SIZE] ={
 	"Basic Y09vdTkwQnl6ZUhKRVlQd08xbDVQeVh6Skhub2U1WjE6Q0VXaE9aMHhzWUhQa0xleXF6anZ6dUhZUXY2VnNEN1g=",
 	"Basic WHBOR1ZnOEMzWjZpRDF0TGFmZWkybXlRRjVPN1JQaEw6d3ZTdTA5VzRyQUtpc0FJMVg5QjRmQ1E0R0l5aElOdDM="};
 
+#if CONFIG_CLOUD_HOST_OVERRIDE_HTTP
+#define CLOUD_SCHEME    "http"
+#else
+#define CLOUD_SCHEME    "https"
+#endif
+
+// API / OTA host, or the developer override (e.g. a local mock server) when one is configured
+static const char *cloud_host(const char *const *domains, int domain) {
+    if (CONFIG_CLOUD_HOST_OVERRIDE[0] != '\0') {
+        return CONFIG_CLOUD_HOST_OVERRIDE;
+    }
+    return domains[domain];
+}
+
 esp_err_t ensure_dir_exists(const char *dir_path) {
     struct stat st = {0};
 
@@ -81,75 +99,314 @@ void create_directories(const char *fullpath) {
     mkdir(tmp, 0775);
 }
 
-esp_err_t _http_event_handler(esp_http_client_event_t *evt) {
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGD(TAG, "HTTP_EVENT_ERROR");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
+/*
+ * Shared cloud API client.
+ *
+ * Every API call goes through one keep-alive esp_http_client per host, so a sync pays for
+ * one TLS handshake per host instead of one per call. The handles outlive the connection:
+ * with CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS the TLS session is kept in the handle and a
+ * reconnect (server idle timeout, WiFi restarted for the next sync) resumes it with a ticket
+ * instead of a full handshake. Calls are serialized by s_cloud_lock.
+ */
+#define CLOUD_CLIENT_SLOTS      2       // API/OTA host plus one upload host
+#define CLOUD_MAX_HEADERS       4
+#define CLOUD_API_TIMEOUT_MS    20000
+#define CLOUD_BODY_INITIAL      1024
+#define CLOUD_BODY_CHUNK        4096    // Request bodies streamed from the SD card
+
+typedef struct {
+    const char *key;
+    const char *value;
+} cloud_header_t;
+
+typedef struct {
+    esp_http_client_handle_t client;
+    char host[64];
+    bool connected;                                 // Keep-alive connection believed open
+    uint32_t last_used;
+    const char *header_keys[CLOUD_MAX_HEADERS];     // Set by the last request, removed before the next
+    int header_count;
+    char validator[S3_DL_VALIDATOR_MAX];            // ETag / Last-Modified of the last response
+} cloud_client_t;
+
+static cloud_client_t s_cloud_clients[CLOUD_CLIENT_SLOTS];
+static SemaphoreHandle_t s_cloud_lock = NULL;
+static uint32_t s_cloud_use_seq = 0;
+static s3_cloud_api_stats_t s_cloud_stats;
+
+static void cloud_url_host(const char *url, char *host, size_t host_size) {
+    const char *start = strstr(url, "://");
+    start = start ? start + 3 : url;
+    size_t len = strcspn(start, "/:?");
+    if (len >= host_size) {
+        len = host_size - 1;
+    }
+    memcpy(host, start, len);
+    host[len] = '\0';
+}
+
+static void cloud_client_disconnect(cloud_client_t *slot) {
+    if (slot->client && slot->connected) {
+        esp_http_client_close(slot->client);
+    }
+    slot->connected = false;
+}
+
+// Client for the URL's host; the least recently used slot is recycled for a new host
+static cloud_client_t *cloud_client_for(const char *url) {
+    char host[64];
+    cloud_url_host(url, host, sizeof(host));
+
+    cloud_client_t *slot = NULL;
+    for (int i = 0; i < CLOUD_CLIENT_SLOTS; i++) {
+        if (s_cloud_clients[i].client && strcmp(s_cloud_clients[i].host, host) == 0) {
+            slot = &s_cloud_clients[i];
             break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
+        }
+    }
+    if (!slot) {
+        slot = &s_cloud_clients[0];
+        for (int i = 1; i < CLOUD_CLIENT_SLOTS; i++) {
+            if (!s_cloud_clients[i].client ||
+                (slot->client && s_cloud_clients[i].last_used < slot->last_used)) {
+                slot = &s_cloud_clients[i];
+            }
+        }
+        if (slot->client) {
+            cloud_client_disconnect(slot);
+            esp_http_client_cleanup(slot->client);
+        }
+        memset(slot, 0, sizeof(*slot));
+
+        esp_http_client_config_t config = {
+                .url = url,
+                .timeout_ms = CLOUD_API_TIMEOUT_MS,
+                .crt_bundle_attach = esp_crt_bundle_attach,
+                .disable_auto_redirect = true,
+                .keep_alive_enable = true,
+                .event_handler = s3_dl_journal_http_event,
+                .user_data = slot->validator,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+                .save_client_session = true,
+#endif
+        };
+        slot->client = esp_http_client_init(&config);
+        if (!slot->client) {
+            ESP_LOGE(TAG, "Failed to init cloud client for %s", host);
+            return NULL;
+        }
+        strlcpy(slot->host, host, sizeof(slot->host));
+    } else if (esp_http_client_set_url(slot->client, url) != ESP_OK) {
+        return NULL;
+    }
+    slot->last_used = ++s_cloud_use_seq;
+    return slot;
+}
+
+// Stream a request body from the SD card; read again from the start on every attempt
+static esp_err_t cloud_write_body_file(esp_http_client_handle_t client, const char *body_path, int body_len) {
+    FILE *f = s3_fopen(body_path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", body_path);
+        return ESP_FAIL;
+    }
+    char *chunk = heap_caps_malloc(CLOUD_BODY_CHUNK, MALLOC_CAP_SPIRAM);
+    esp_err_t err = chunk ? ESP_OK : ESP_ERR_NO_MEM;
+    int sent = 0;
+    while (err == ESP_OK && sent < body_len) {
+        int n = s3_fread(chunk, 1, MIN(CLOUD_BODY_CHUNK, body_len - sent), f);
+        if (n <= 0 || esp_http_client_write(client, chunk, n) != n) {
+            err = ESP_FAIL;
             break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            // Clean the buffer in case of a new request
-            // first init buffer
-            if (dynamic_buffer == NULL) {
-                int content_length = esp_http_client_get_content_length(evt->client);
-                if (content_length <= 0) {
-                    ESP_LOGE(TAG, "Invalid content length");
-                    return ESP_FAIL;
-                }
+        }
+        sent += n;
+    }
+    free(chunk);
+    s3_fclose(f);
+    return err;
+}
 
-                dynamic_buffer = (char *) heap_caps_calloc(content_length + 1, sizeof(char),MALLOC_CAP_SPIRAM); // +1 for null terminator
-                if (!dynamic_buffer) {
-                    ESP_LOGE(TAG, "Failed to allocate memory");
-                    return ESP_FAIL;
-                }
-                buffer_len = 0;
-            }
+/**
+ * @brief Send a request on the shared client and read the response headers
+ *
+ * The body comes from memory (body) or from a file on the SD card (body_path), or is empty.
+ * On success the caller owns the client (s_cloud_lock held) until cloud_request_finish().
+ * A keep-alive connection the server already closed is retried once on a new connection.
+ */
+static esp_err_t cloud_request_open(esp_http_client_method_t method, const char *url,
+                                    const cloud_header_t *headers, int header_count,
+                                    const char *body, const char *body_path,
+                                    cloud_client_t **out_slot, int *content_length) {
+    int body_len = body ? strlen(body) : 0;
+    if (body_path) {
+        struct stat st;
+        if (stat(body_path, &st) != 0) {
+            ESP_LOGE(TAG, "Failed to stat file: %s", body_path);
+            return ESP_FAIL;
+        }
+        body_len = st.st_size;
+    }
+    if (header_count > CLOUD_MAX_HEADERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_cloud_lock) {
+        s_cloud_lock = xSemaphoreCreateMutex();
+    }
+    xSemaphoreTake(s_cloud_lock, portMAX_DELAY);
 
-            // Copy  paragraph information to buffer
-            if (dynamic_buffer && (buffer_len + evt->data_len <= esp_http_client_get_content_length(evt->client))) {
-                memcpy(dynamic_buffer + buffer_len, evt->data, evt->data_len);
-                buffer_len += evt->data_len;
-            } else {
-                ESP_LOGE(TAG, "Buffer overflow or invalid state");
-                return ESP_FAIL;
+    cloud_client_t *slot = cloud_client_for(url);
+    if (!slot) {
+        xSemaphoreGive(s_cloud_lock);
+        return ESP_FAIL;
+    }
+    esp_http_client_handle_t client = slot->client;
+    esp_http_client_set_method(client, method);
+    for (int i = 0; i < slot->header_count; i++) {
+        esp_http_client_delete_header(client, slot->header_keys[i]);
+    }
+    for (int i = 0; i < header_count; i++) {
+        esp_http_client_set_header(client, headers[i].key, headers[i].value);
+        slot->header_keys[i] = headers[i].key;
+    }
+    slot->header_count = header_count;
+
+    esp_err_t err = ESP_FAIL;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = slot->connected;
+        slot->validator[0] = '\0';
+        int64_t start_us = esp_timer_get_time();
+        err = esp_http_client_open(client, body_len);
+        if (err == ESP_OK && body_len > 0) {
+            if (body_path) {
+                err = cloud_write_body_file(client, body_path, body_len);
+            } else if (esp_http_client_write(client, body, body_len) != body_len) {
+                err = ESP_FAIL;
             }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGD(TAG, "HTTP_EVENT_DISCONNECTED");
-            int mbedtls_err = 0;
-            esp_err_t err = esp_tls_get_and_clear_last_error((esp_tls_error_handle_t) evt->data, &mbedtls_err, NULL);
-            if (err != 0) {
-                ESP_LOGD(TAG, "Last esp error code: 0x%x", err);
-                ESP_LOGD(TAG, "Last mbedtls failure: 0x%x", mbedtls_err);
+        }
+        if (err == ESP_OK) {
+            *content_length = esp_http_client_fetch_headers(client);
+            if (*content_length < 0) {
+                err = ESP_FAIL;
             }
-            if (dynamic_buffer != NULL) {
-                free(dynamic_buffer);
-                dynamic_buffer = NULL;
+        }
+        if (err == ESP_OK) {
+            slot->connected = true;
+            s_cloud_stats.requests++;
+            s_cloud_stats.bytes_sent += body_len;
+            if (!reused) {
+                s_cloud_stats.connections++;
+                ESP_LOGI(TAG, "Connected to %s in %lld ms", slot->host, (esp_timer_get_time() - start_us) / 1000);
+            } else {
+                s_cloud_stats.reused++;
             }
-            buffer_len = 0;
             break;
-        case HTTP_EVENT_REDIRECT:
-            ESP_LOGE(TAG, "HTTP_EVENT_REDIRECT");
-            // esp_http_client_set_header(evt->client, "From", "user@example.com");
-            // esp_http_client_set_header(evt->client, "Accept", "text/html");
-            // esp_http_client_set_redirection(evt->client);
+        }
+        cloud_client_disconnect(slot);
+        if (!reused) {
             break;
+        }
+        s_cloud_stats.retries++;
+        ESP_LOGI(TAG, "Keep-alive connection to %s was closed, reconnecting", slot->host);
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Request to %s failed: %s", slot->host, esp_err_to_name(err));
+        xSemaphoreGive(s_cloud_lock);
+        return err;
     }
+    *out_slot = slot;
     return ESP_OK;
 }
 
+// Response body read, counted in the API stats
+static int cloud_read(cloud_client_t *slot, char *buf, int len) {
+    int n = esp_http_client_read(slot->client, buf, len);
+    if (n > 0) {
+        s_cloud_stats.bytes_received += n;
+    }
+    return n;
+}
+
+static void cloud_request_finish(cloud_client_t *slot) {
+    // A body that was not read to the end leaves the connection in an unknown state
+    if (!esp_http_client_is_complete_data_received(slot->client)) {
+        cloud_client_disconnect(slot);
+    }
+    xSemaphoreGive(s_cloud_lock);
+}
+
+/**
+ * @brief Request with an in-memory response body (PSRAM, NUL terminated)
+ * @param response_data Receives the body, or stays untouched if the body is empty; may be NULL
+ * @return ESP_OK if the request completed, whatever the HTTP status
+ */
+static esp_err_t cloud_api_request(esp_http_client_method_t method, const char *url,
+                                   const cloud_header_t *headers, int header_count,
+                                   const char *body, char **response_data) {
+    cloud_client_t *slot;
+    int content_length = 0;
+    esp_err_t err = cloud_request_open(method, url, headers, header_count, body, NULL, &slot, &content_length);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ESP_LOGI(TAG, "HTTPS Status = %d", esp_http_client_get_status_code(slot->client));
+
+    // Chunked responses have no length; grow as needed
+    int cap = content_length > 0 ? content_length + 1 : CLOUD_BODY_INITIAL;
+    int len = 0;
+    char *buf = heap_caps_malloc(cap, MALLOC_CAP_SPIRAM);
+    while (buf) {
+        if (len + 1 >= cap) {
+            char *grown = heap_caps_realloc(buf, cap * 2, MALLOC_CAP_SPIRAM);
+            if (!grown) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        int n = cloud_read(slot, buf + len, cap - len - 1);
+        if (n <= 0) {
+            break;
+        }
+        len += n;
+    }
+    if (!buf) {
+        ESP_LOGE(TAG, "Failed to allocate memory");
+        err = ESP_ERR_NO_MEM;
+    } else if (!esp_http_client_is_complete_data_received(slot->client)) {
+        ESP_LOGE(TAG, "Response from %s cut short after %d bytes", slot->host, len);
+        err = ESP_FAIL;
+    }
+    cloud_request_finish(slot);
+
+    if (err == ESP_OK && len > 0 && response_data) {
+        buf[len] = '\0';
+        *response_data = buf;
+    } else {
+        free(buf);
+    }
+    return err;
+}
+
+void s3_cloud_api_close(void) {
+    if (!s_cloud_lock) {
+        return;
+    }
+    xSemaphoreTake(s_cloud_lock, portMAX_DELAY);
+    for (int i = 0; i < CLOUD_CLIENT_SLOTS; i++) {
+        cloud_client_disconnect(&s_cloud_clients[i]);
+    }
+    xSemaphoreGive(s_cloud_lock);
+}
+
+void s3_cloud_api_get_stats(s3_cloud_api_stats_t *stats) {
+    if (stats) {
+        *stats = s_cloud_stats;
+    }
+}
+
 /* Doc : APIs_for_Device_v0.3.17.docx 2.2
  * 1. Get Sn from nvs (SPKLF20000001)
  * 2. Get secretKey from nvs (3fc048a5-d89c-4e1d-9483-21147b23f046)
@@ -191,31 +448,14 @@ esp_err_t https_cloud_complete_binding_of_device(char **response_data) {
 	}
 
     char tmp_url[128] = {0};
-    sprintf(tmp_url, "https://%s/client_service/api/v1/devices/s3/c/%s",s3_domain_str[domain], sn);
+    sprintf(tmp_url, CLOUD_SCHEME "://%s/client_service/api/v1/devices/s3/c/%s", cloud_host(s3_domain_str, domain), sn);
 	ESP_LOGI(TAG, "url:%s", tmp_url);
 
-    esp_http_client_config_t config = {
-            .url = tmp_url,
-            .method = HTTP_METHOD_PATCH,
-            .event_handler = _http_event_handler,
-            .crt_bundle_attach = esp_crt_bundle_attach,
-            .disable_auto_redirect = true,
+    const cloud_header_t headers[] = {
+            { "Content-Type", "application/json" },
+            { "Authorization", s3_Basic_Authorization[domain] },
     };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "Authorization", s3_Basic_Authorization[domain]);
-    esp_http_client_set_post_field(client, patch_data, strlen(patch_data));
-    esp_err_t result = esp_http_client_perform(client);
-    ESP_LOGI(TAG, "HTTPS Status = %d", esp_http_client_get_status_code(client));
-    if (dynamic_buffer != NULL) {
-        *response_data = strdup_spiram(dynamic_buffer);
-        free(dynamic_buffer);
-        dynamic_buffer = NULL;
-    }
-    buffer_len = 0;
-    esp_http_client_cleanup(client);
-    return result;
+    return cloud_api_request(HTTP_METHOD_PATCH, tmp_url, headers, 2, patch_data, response_data);
 }
 
 esp_err_t cei_complete_binding_of_device(int *biding_code) {
@@ -271,30 +511,13 @@ esp_err_t https_upload_device_info(char *input_data, char **response_data) {
     }
 
     char tmp_url[128] = {0};
-    sprintf(tmp_url, "https://%s/client_service/api/v1/devices/s3/s/%s", s3_domain_str[domain], sn);
+    sprintf(tmp_url, CLOUD_SCHEME "://%s/client_service/api/v1/devices/s3/s/%s", cloud_host(s3_domain_str, domain), sn);
     ESP_LOGI(TAG, "url:%s", tmp_url);
-    esp_http_client_config_t config = {
-            .url = tmp_url,
-            .method = HTTP_METHOD_PATCH,
-            .event_handler = _http_event_handler,
-            .crt_bundle_attach = esp_crt_bundle_attach,
-            .disable_auto_redirect = true,
+    const cloud_header_t headers[] = {
+            { "Content-Type", "application/json" },
+            { "x-player-secret", secret_key },
     };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "x-player-secret", secret_key);
-    esp_http_client_set_post_field(client, input_data, strlen(input_data));
-    esp_err_t result = esp_http_client_perform(client);
-    ESP_LOGI(TAG, "HTTPS Status = %d", esp_http_client_get_status_code(client));
-    if (dynamic_buffer != NULL) {
-        *response_data = strdup_spiram(dynamic_buffer);
-        free(dynamic_buffer);
-        dynamic_buffer = NULL;
-    }
-    buffer_len = 0;
-    esp_http_client_cleanup(client);
-    return result;
+    return cloud_api_request(HTTP_METHOD_PATCH, tmp_url, headers, 2, input_data, response_data);
 }
 
 esp_err_t cei_upload_device_info(char *input_data) {
@@ -350,29 +573,14 @@ esp_err_t cei_sync_all_available_contents(char **response_data) {
 		domain = DOMAIN_PRODUCTION;
 	}
 	char tmp_url[128] = {0};
-	sprintf(tmp_url, "https://%s/client_service/api/v1/contents/s3/c", s3_domain_str[domain]);
+	sprintf(tmp_url, CLOUD_SCHEME "://%s/client_service/api/v1/contents/s3/c", cloud_host(s3_domain_str, domain));
 	ESP_LOGI(TAG, "url:%s", tmp_url);
-    esp_http_client_config_t config = {
-            .url = tmp_url,
-            .method = HTTP_METHOD_GET,
-            .event_handler = _http_event_handler,
-            .crt_bundle_attach = esp_crt_bundle_attach,
-            .disable_auto_redirect = true,
+    const cloud_header_t headers[] = {
+            { "Content-Type", "application/json" },
+            { "Authorization", s3_Basic_Authorization[domain] },
+            { "x-player-secret", secret_key },
     };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-	esp_http_client_set_header(client, "Authorization", s3_Basic_Authorization[domain]);
-    esp_http_client_set_header(client, "x-player-secret", secret_key);
-    esp_err_t result = esp_http_client_perform(client);
-    ESP_LOGI(TAG, "HTTPS Status = %d", esp_http_client_get_status_code(client));
-    if (dynamic_buffer != NULL) {
-        *response_data = strdup_spiram(dynamic_buffer);
-        free(dynamic_buffer);
-        dynamic_buffer = NULL;
-    }
-    buffer_len = 0;
-    esp_http_client_cleanup(client);
-    return result;
+    return cloud_api_request(HTTP_METHOD_GET, tmp_url, headers, 3, NULL, response_data);
 }
 
 #if 0
@@ -399,7 +607,7 @@ esp_err_t cei_sync_content_list_by_account(char **response_data) {
 		domain = DOMAIN_PRODUCTION;
 	}
 	char tmp_url[128] = {0};
-	sprintf(tmp_url, "https://%s/client_service/api/v1/devices/s3/pc", s3_domain_str[domain]);
+	sprintf(tmp_url, CLOUD_SCHEME "://%s/client_service/api/v1/devices/s3/pc", cloud_host(s3_domain_str, domain));
 	ESP_LOGI(TAG, "url:%s", tmp_url);
     esp_http_client_config_t config = {
             .url = tmp_url,
@@ -624,36 +832,142 @@ esp_err_t https_download_content_file(void *pvParameters) {
     return ret;
 }
 
-static char* read_file_to_buffer(const char *path) {
-    struct stat st;
-    if (stat(path, &st) != 0) {
-        ESP_LOGE(TAG, "Failed to stat file: %s", path);
-        return NULL;
+/**
+ * Account manifest state, kept next to account_file.json.
+ *
+ * The cloud signs every content URL again and puts a fresh traceId in each response, so
+ * the raw bytes of the manifest change on every call. The version token is the SHA-256 of
+ * the manifest values, hashed as they stream in, without those fields; together with the
+ * server validator it tells whether the manifest changed since the last sync that completed.
+ */
+#define ACCOUNT_META_PATH   CLOUD_DOWNLOAD_PATH CLOUD_ACCOUNT_FILENAME ".meta"
+
+typedef struct {
+    char validator[S3_DL_VALIDATOR_MAX];    // ETag, or Last-Modified
+    char token[65];                         // Hex SHA-256 version token
+    bool synced;                            // A sync with this manifest completed
+} account_meta_t;
+
+static void account_meta_load(account_meta_t *meta) {
+    memset(meta, 0, sizeof(*meta));
+    FILE *f = s3_fopen(ACCOUNT_META_PATH, "r");
+    if (!f) {
+        return;
+    }
+    char line[S3_DL_VALIDATOR_MAX + 16];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strncmp(line, "validator=", 10) == 0) {
+            strlcpy(meta->validator, line + 10, sizeof(meta->validator));
+        } else if (strncmp(line, "token=", 6) == 0) {
+            strlcpy(meta->token, line + 6, sizeof(meta->token));
+        } else if (strncmp(line, "synced=", 7) == 0) {
+            meta->synced = atoi(line + 7) == 1;
+        }
     }
+    s3_fclose(f);
+}
 
-    long fsize = st.st_size;
+static void account_meta_save(const account_meta_t *meta) {
+    FILE *f = s3_fopen(ACCOUNT_META_PATH, "w");
+    if (!f) {
+        ESP_LOGW(TAG, "Failed to write %s", ACCOUNT_META_PATH);
+        return;
+    }
+    char buf[S3_DL_VALIDATOR_MAX + 128];
+    int len = snprintf(buf, sizeof(buf), "validator=%s\ntoken=%s\nsynced=%d\n",
+                       meta->validator, meta->token, meta->synced ? 1 : 0);
+    s3_fwrite(buf, 1, len, f);
+    s3_fclose(f);
+}
 
-    FILE *fp = s3_fopen(path, "r");
-    if (fp == NULL) {
-        ESP_LOGE(TAG, "Failed to open file for reading: %s", path);
-        return NULL;
+static void account_token_update(mbedtls_sha256_context *sha, const cJSON *item) {
+    if (item->string) {
+        mbedtls_sha256_update(sha, (const unsigned char *)item->string, strlen(item->string) + 1);
     }
+    unsigned char type = (unsigned char)(item->type & 0xFF);
+    mbedtls_sha256_update(sha, &type, 1);
+
+    if (cJSON_IsString(item)) {
+        const char *value = item->valuestring;
+        // Signed links: only the part before the query string identifies the content
+        size_t len = strncmp(value, "http", 4) == 0 ? strcspn(value, "?") : strlen(value);
+        mbedtls_sha256_update(sha, (const unsigned char *)value, len + 1);
+    } else if (cJSON_IsNumber(item)) {
+        mbedtls_sha256_update(sha, (const unsigned char *)&item->valuedouble, sizeof(item->valuedouble));
+    } else if (cJSON_IsArray(item) || cJSON_IsObject(item)) {
+        for (const cJSON *child = item->child; child; child = child->next) {
+            account_token_update(sha, child);
+        }
+        mbedtls_sha256_update(sha, &type, 1);
+    }
+}
 
-    char *buffer = heap_caps_malloc(fsize + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate buffer for file");
-        s3_fclose(fp);
-        return NULL;
+// Arrays of the account manifest hashed element by element while it downloads
+static const char *const ACCOUNT_TOKEN_SPLIT_PATHS[] = { "result.babyPacks", "result.NFCs" };
+
+// Download state: the body is parsed as it arrives, never held whole
+typedef struct {
+    mbedtls_sha256_context sha;
+    int code;
+    char *alarms_json;      // {"alarms":[...]} for register_alarms()
+} account_download_t;
+
+static bool account_download_cb(const char *path, int index, const cJSON *value, void *ctx) {
+    account_download_t *dl = ctx;
+    if (strcmp(path, "traceId") == 0) {
+        return true;
     }
-    if (s3_fread(buffer, 1, fsize, fp) != fsize) {
-        ESP_LOGE(TAG, "Failed to read complete file: %s", path);
-        free(buffer);
-        s3_fclose(fp);
-        return NULL;
+    if (strcmp(path, "code") == 0 && cJSON_IsNumber(value)) {
+        dl->code = value->valueint;
     }
-    buffer[fsize] = '\0';
-    s3_fclose(fp);
-    return buffer;
+
+    int32_t element = index;
+    mbedtls_sha256_update(&dl->sha, (const unsigned char *)path, strlen(path) + 1);
+    mbedtls_sha256_update(&dl->sha, (const unsigned char *)&element, sizeof(element));
+    if (value) {
+        account_token_update(&dl->sha, value);
+    }
+
+    if (strcmp(path, "result.alarms") == 0 && cJSON_IsArray(value) && !dl->alarms_json) {
+        cJSON *wrapped = cJSON_CreateObject();
+        if (wrapped) {
+            cJSON_AddItemReferenceToObject(wrapped, "alarms", (cJSON *)value);
+            dl->alarms_json = cJSON_PrintUnformatted(wrapped);
+            cJSON_Delete(wrapped);
+        }
+    }
+    return true;
+}
+
+static void account_token_finish(account_download_t *dl, char *hex) {
+    unsigned char digest[32];
+    mbedtls_sha256_finish(&dl->sha, digest);
+    for (int i = 0; i < 32; i++) {
+        sprintf(hex + i * 2, "%02x", digest[i]);
+    }
+    hex[64] = '\0';
+}
+
+void s3_cloud_account_manifest_synced(void) {
+    account_meta_t meta;
+    account_meta_load(&meta);
+    if (meta.token[0] == '\0' || meta.synced) {
+        return;
+    }
+    meta.synced = true;
+    account_meta_save(&meta);
+}
+
+void s3_cloud_account_manifest_invalidate(void) {
+    account_meta_t meta;
+    account_meta_load(&meta);
+    if (!meta.synced) {
+        return;
+    }
+    meta.synced = false;
+    account_meta_save(&meta);
+    ESP_LOGI(TAG, "Account manifest marked for a full sync");
 }
 
 esp_err_t https_download_account_file(void *pvParameters) {
@@ -671,7 +985,7 @@ esp_err_t https_download_account_file(void *pvParameters) {
     }
 
     char tmp_url[128] = {0};
-    sprintf(tmp_url, "https://%s/client_service/api/v1/devices/s3/pc", s3_domain_str[domain]);
+    sprintf(tmp_url, CLOUD_SCHEME "://%s/client_service/api/v1/devices/s3/pc", cloud_host(s3_domain_str, domain));
     ESP_LOGI(TAG, "url:%s", tmp_url);
 
     if (ensure_dir_exists(CLOUD_DOWNLOAD_PATH) != ESP_OK) {
@@ -680,7 +994,17 @@ esp_err_t https_download_account_file(void *pvParameters) {
     }
 
     char tempPath[128];
+    char finalPath[128];
+    char backupPath[128];
     sprintf(tempPath, "%s%s.tmp", CLOUD_DOWNLOAD_PATH, CLOUD_ACCOUNT_FILENAME);
+    sprintf(finalPath, "%s%s", CLOUD_DOWNLOAD_PATH, CLOUD_ACCOUNT_FILENAME);
+    sprintf(backupPath, "%s%s.bak", CLOUD_DOWNLOAD_PATH, CLOUD_ACCOUNT_FILENAME);
+
+    // Ask for the body only if it changed, but only once the last sync with it completed:
+    // a 304 does not carry the fresh signed links an unfinished sync still needs
+    account_meta_t meta;
+    account_meta_load(&meta);
+    bool conditional = meta.synced && meta.validator[0] != '\0' && access(finalPath, F_OK) == 0;
 
     FILE *f = s3_fopen(tempPath, "w");
     if (f == NULL) {
@@ -688,68 +1012,96 @@ esp_err_t https_download_account_file(void *pvParameters) {
         return ESP_FAIL;
     }
 
-    esp_http_client_config_t config = {
-            .url = tmp_url,
-            .method = HTTP_METHOD_GET,
-            .crt_bundle_attach = esp_crt_bundle_attach,
-            .disable_auto_redirect = true,
-            .timeout_ms = 20000, // 20s
+    cloud_header_t headers[] = {
+            { "Content-Type", "application/json" },
+            { "x-player-secret", secret_key },
+            { NULL, meta.validator },
     };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "x-player-secret", secret_key);
-
-    if (esp_http_client_open(client, 0) != ESP_OK) {
+    int header_count = 2;
+    if (conditional) {
+        bool is_etag = meta.validator[0] == '"' || strncmp(meta.validator, "W/", 2) == 0;
+        headers[2].key = is_etag ? "If-None-Match" : "If-Modified-Since";
+        header_count = 3;
+    }
+    cloud_client_t *slot = NULL;
+    s3_json_stream_t *stream = NULL;
+    account_download_t dl = { 0 };
+    int content_length = 0;
+    if (cloud_request_open(HTTP_METHOD_GET, tmp_url, headers, header_count, NULL, NULL, &slot, &content_length) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to open HTTP connection");
         goto cleanup;
     }
 
-    int content_length = esp_http_client_fetch_headers(client);
-    int status_code = esp_http_client_get_status_code(client);
-
+    int status_code = esp_http_client_get_status_code(slot->client);
+    if (conditional && status_code == 304) {
+        cloud_request_finish(slot);
+        s3_fclose(f);
+        s3_remove(tempPath);
+        ESP_LOGI(TAG, "account_file.json not modified (%s)", meta.validator);
+        return CEI_NOT_MODIFIED;
+    }
     if (status_code != 200) {
         ESP_LOGE(TAG, "HTTP request failed with status code %d", status_code);
         goto cleanup;
     }
+    char validator[S3_DL_VALIDATOR_MAX];
+    strlcpy(validator, slot->validator, sizeof(validator));
+
+    // Parse while downloading: only one baby pack or NFC is in memory at a time
+    dl.code = -1;
+    mbedtls_sha256_init(&dl.sha);
+    mbedtls_sha256_starts(&dl.sha, 0);
+    stream = s3_json_stream_create(ACCOUNT_TOKEN_SPLIT_PATHS,
+                                   sizeof(ACCOUNT_TOKEN_SPLIT_PATHS) / sizeof(ACCOUNT_TOKEN_SPLIT_PATHS[0]),
+                                   account_download_cb, &dl);
+    if (stream == NULL) {
+        ESP_LOGE(TAG, "Failed to create JSON stream");
+        goto cleanup;
+    }
 
     char buffer[1024];
     int total_read_len = 0;
     int read_len;
-    while ((read_len = esp_http_client_read(client, buffer, sizeof(buffer))) > 0) {
+    esp_err_t parse_err = ESP_OK;
+    while ((read_len = cloud_read(slot, buffer, sizeof(buffer))) > 0) {
         s3_fwrite(buffer, 1, read_len, f);
         total_read_len += read_len;
+        if (parse_err == ESP_OK) {
+            parse_err = s3_json_stream_feed(stream, buffer, read_len);
+        }
     }
 
-    if (content_length > 0 && total_read_len != content_length) {
+    if (!esp_http_client_is_complete_data_received(slot->client) ||
+        (content_length > 0 && total_read_len != content_length)) {
         ESP_LOGE(TAG, "Download incomplete. Expected %d, got %d", content_length, total_read_len);
         goto cleanup;
     }
 
     s3_fclose(f);
     f = NULL;
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
-    client = NULL;
+    cloud_request_finish(slot);
+    slot = NULL;
 
-    // Now read back and parse
-    char *response_data = read_file_to_buffer(tempPath);
-    if (response_data == NULL) {
-        s3_remove(tempPath);
-        return ESP_FAIL;
+    if (parse_err == ESP_OK) {
+        parse_err = s3_json_stream_finish(stream);
     }
-
-    register_alarms((const char*)response_data);
-
-    cJSON *root = cJSON_Parse(response_data);
-    int code = -1;
-    if (root) {
-        const cJSON *jCode = cJSON_GetObjectItem(root, "code");
-        if (cJSON_IsNumber(jCode)) {
-            code = jCode->valueint;
-        }
-        cJSON_Delete(root);
+    ESP_LOGI(TAG, "account_file.json: %d bytes, largest value %u bytes", total_read_len,
+             (unsigned int)s3_json_stream_peak(stream));
+    s3_json_stream_destroy(stream);
+    stream = NULL;
+
+    char token[65] = {0};
+    account_token_finish(&dl, token);
+    mbedtls_sha256_free(&dl.sha);
+    int code = parse_err == ESP_OK ? dl.code : -1;
+
+    if (dl.alarms_json) {
+        register_alarms(dl.alarms_json);
+        free(dl.alarms_json);
+        dl.alarms_json = NULL;
+    } else {
+        ESP_LOGE(TAG, "No alarms in account_file.json");
     }
-    free(response_data);
 
     if (code != 0) {
         ESP_LOGE(TAG, "https_download_account_file Err code %d", code);
@@ -757,12 +1109,18 @@ esp_err_t https_download_account_file(void *pvParameters) {
         return ESP_FAIL;
     }
 
-    // Success, move temp file with backup strategy (for differential updates)
-    char finalPath[128];
-    char backupPath[128];
-    sprintf(finalPath, "%s%s", CLOUD_DOWNLOAD_PATH, CLOUD_ACCOUNT_FILENAME);
-    sprintf(backupPath, "%s%s.bak", CLOUD_DOWNLOAD_PATH, CLOUD_ACCOUNT_FILENAME);
+    // Servers that ignore the conditional headers: the version token still spots an unchanged manifest
+    if (meta.synced && strcmp(token, meta.token) == 0 && access(finalPath, F_OK) == 0) {
+        s3_remove(tempPath);
+        if (strcmp(validator, meta.validator) != 0) {
+            strlcpy(meta.validator, validator, sizeof(meta.validator));
+            account_meta_save(&meta);
+        }
+        ESP_LOGI(TAG, "account_file.json unchanged (token %.16s)", token);
+        return CEI_NOT_MODIFIED;
+    }
 
+    // Success, move temp file with backup strategy (for differential updates)
     // Step 1: Remove old backup (if exists), then rename original to backup (if exists)
     s3_remove(backupPath);  // Remove old backup first to avoid rename failure
     bool had_original = (access(finalPath, F_OK) == 0);
@@ -788,12 +1146,21 @@ esp_err_t https_download_account_file(void *pvParameters) {
         return ESP_FAIL;
     }
 
+    // Not synced until the caller reports the sync with this manifest completed
+    strlcpy(meta.validator, validator, sizeof(meta.validator));
+    strlcpy(meta.token, token, sizeof(meta.token));
+    meta.synced = false;
+    account_meta_save(&meta);
+
     ESP_LOGI(TAG, "Finish https_download_account_file");
     return ESP_OK;
 
 cleanup:
     if (f) s3_fclose(f);
-    if (client) esp_http_client_cleanup(client);
+    if (slot) cloud_request_finish(slot);
+    s3_json_stream_destroy(stream);
+    mbedtls_sha256_free(&dl.sha);
+    free(dl.alarms_json);
     s3_remove(tempPath);
     return ESP_FAIL;
 }
@@ -815,27 +1182,12 @@ esp_err_t api_ota_info(char **response_data) {
     }
 
     char tmp_url[128] = {0};
-    sprintf(tmp_url, "https://%s/api/v1/otas/?model=ITC9", ota_domain_str[domain]);
+    sprintf(tmp_url, CLOUD_SCHEME "://%s/api/v1/otas/?model=ITC9", cloud_host(ota_domain_str, domain));
     ESP_LOGI(TAG, "url:%s", tmp_url);
-    esp_http_client_config_t config = {
-        .url = tmp_url,
-        .method = HTTP_METHOD_GET,
-        .event_handler = _http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .disable_auto_redirect = true,
-};
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_header(client, "Authorization", ota_Basic_Authorization[domain]);
-    esp_err_t result = esp_http_client_perform(client);
-    ESP_LOGI(TAG, "HTTPS Status = %d", esp_http_client_get_status_code(client));
-    if (dynamic_buffer != NULL) {
-        *response_data = strdup_spiram(dynamic_buffer);
-        free(dynamic_buffer);
-        dynamic_buffer = NULL;
-    }
-    buffer_len = 0;
-    esp_http_client_cleanup(client);
-    return result;
+    const cloud_header_t headers[] = {
+            { "Authorization", ota_Basic_Authorization[domain] },
+    };
+    return cloud_api_request(HTTP_METHOD_GET, tmp_url, headers, 1, NULL, response_data);
 }
 
 esp_err_t parser_ota_info(char **version, char **ota_url) {
@@ -909,27 +1261,12 @@ esp_err_t api_ota_resource_info(char **response_data) {
     }
 
     char tmp_url[128] = {0};
-    sprintf(tmp_url, "https://%s/api/v1/otas/?model=ITC9_RESOURCE", ota_domain_str[domain]);
+    sprintf(tmp_url, CLOUD_SCHEME "://%s/api/v1/otas/?model=ITC9_RESOURCE", cloud_host(ota_domain_str, domain));
     ESP_LOGI(TAG, "url:%s", tmp_url);
-    esp_http_client_config_t config = {
-        .url = tmp_url,
-        .method = HTTP_METHOD_GET,
-        .event_handler = _http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .disable_auto_redirect = true,
+    const cloud_header_t headers[] = {
+            { "Authorization", ota_Basic_Authorization[domain] },
     };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_header(client, "Authorization", ota_Basic_Authorization[domain]);
-    esp_err_t result = esp_http_client_perform(client);
-    ESP_LOGI(TAG, "HTTPS Status = %d", esp_http_client_get_status_code(client));
-    if (dynamic_buffer != NULL) {
-        *response_data = strdup_spiram(dynamic_buffer);
-        free(dynamic_buffer);
-        dynamic_buffer = NULL;
-    }
-    buffer_len = 0;
-    esp_http_client_cleanup(client);
-    return result;
+    return cloud_api_request(HTTP_METHOD_GET, tmp_url, headers, 1, NULL, response_data);
 }
 
 esp_err_t parser_ota_resource_info(char **version, char **ota_url) {
@@ -992,7 +1329,7 @@ esp_err_t parser_ota_resource_info(char **version, char **ota_url) {
     return ret;
 }
 
-esp_err_t s3_cloud_upload_tracking_info(const char *tracking_data) {
+esp_err_t s3_cloud_upload_tracking_file(const char *body_path, bool gzip) {
     char *post_url = NULL;
     char *auth_token = NULL;
     esp_err_t ret = ESP_FAIL;
@@ -1005,23 +1342,17 @@ esp_err_t s3_cloud_upload_tracking_info(const char *tracking_data) {
     }
 
     char tmp_url[256] = {0};
-    sprintf(tmp_url, "https://%s/client_service/api/v1/contents/tracking_info", s3_domain_str[domain]);
-
-    esp_http_client_config_t config_get = {
-        .url = tmp_url,
-        .method = HTTP_METHOD_GET,
-        .event_handler = _http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .disable_auto_redirect = true,
+    sprintf(tmp_url, CLOUD_SCHEME "://%s/client_service/api/v1/contents/tracking_info", cloud_host(s3_domain_str, domain));
+
+    const cloud_header_t get_headers[] = {
+        { "Authorization", s3_Basic_Authorization[domain] },
     };
+    char *response_data = NULL;
 
-    esp_http_client_handle_t client_get = esp_http_client_init(&config_get);
-    esp_http_client_set_header(client_get, "Authorization", s3_Basic_Authorization[domain]);
-    
-    if (esp_http_client_perform(client_get) == ESP_OK) {
-        ESP_LOGI(TAG, "s3_cloud_upload_tracking_info: GET request successful, status = %d", esp_http_client_get_status_code(client_get));
-        if (dynamic_buffer != NULL) {
-            cJSON *root = cJSON_Parse(dynamic_buffer);
+    if (cloud_api_request(HTTP_METHOD_GET, tmp_url, get_headers, 1, NULL, &response_data) == ESP_OK) {
+        ESP_LOGI(TAG, "s3_cloud_upload_tracking_file: GET request successful");
+        if (response_data != NULL) {
+            cJSON *root = cJSON_Parse(response_data);
             if (root) {
                 cJSON *result = cJSON_GetObjectItem(root, "result");
                 if (result) {
@@ -1037,54 +1368,51 @@ esp_err_t s3_cloud_upload_tracking_info(const char *tracking_data) {
             }
         }
     } else {
-        ESP_LOGE(TAG, "s3_cloud_upload_tracking_info: GET request failed");
-    }
-
-    esp_http_client_cleanup(client_get);
-    if (dynamic_buffer) {
-        free(dynamic_buffer);
-        dynamic_buffer = NULL;
-        buffer_len = 0;
+        ESP_LOGE(TAG, "s3_cloud_upload_tracking_file: GET request failed");
     }
+    free(response_data);
 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get upload URL or token.");
         return ret;
     }
 
-    // Step 2: Post the tracking data
+    // Step 2: Post the tracking data, streamed from the SD card
     ESP_LOGI(TAG, "Uploading tracking info to: %s", post_url);
-    esp_http_client_config_t config_post = {
-        .url = post_url,
-        .method = HTTP_METHOD_POST,
-        .event_handler = _http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .disable_auto_redirect = true,
+    const cloud_header_t post_headers[] = {
+        { "Content-Type", "application/json" },
+        { "Authorization", auth_token },
+        { "Content-Encoding", "gzip" },
     };
 
-    esp_http_client_handle_t client_post = esp_http_client_init(&config_post);
-    esp_http_client_set_header(client_post, "Content-Type", "application/json");
-    esp_http_client_set_header(client_post, "Authorization", auth_token);
-    esp_http_client_set_post_field(client_post, tracking_data, strlen(tracking_data));
+    cloud_client_t *slot = NULL;
+    int content_length = 0;
+    ret = cloud_request_open(HTTP_METHOD_POST, post_url, post_headers, gzip ? 3 : 2, NULL, body_path,
+                             &slot, &content_length);
+    if (ret == ESP_OK) {
+        int status_code = esp_http_client_get_status_code(slot->client);
+        char discard[256];
+        while (cloud_read(slot, discard, sizeof(discard)) > 0) {
+        }
+        cloud_request_finish(slot);
 
-    if (esp_http_client_perform(client_post) == ESP_OK) {
-        ESP_LOGI(TAG, "s3_cloud_upload_tracking_info: POST request successful, status = %d", esp_http_client_get_status_code(client_post));
-        ret = ESP_OK;
+        ESP_LOGI(TAG, "s3_cloud_upload_tracking_file: POST status %d", status_code);
+        if (status_code >= 200 && status_code < 300) {
+            ret = ESP_OK;
+        } else if (status_code == 400 || status_code == 404 || status_code == 415) {
+            ret = ESP_ERR_NOT_SUPPORTED;
+        } else {
+            ret = ESP_FAIL;
+        }
     } else {
-        ESP_LOGE(TAG, "s3_cloud_upload_tracking_info: POST request failed, status = %d", esp_http_client_get_status_code(client_post));
+        ESP_LOGE(TAG, "s3_cloud_upload_tracking_file: POST request failed");
         ret = ESP_FAIL;
     }
 
-    esp_http_client_cleanup(client_post);
     if(post_url)
     	free(post_url);
     if (auth_token)
     	free(auth_token);
-    if (dynamic_buffer) {
-        free(dynamic_buffer);
-        dynamic_buffer = NULL;
-        buffer_len = 0;
-    }
 
     return ret;
 }
@@ -0,0 +1,418 @@
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "s3_logger.h"
+#include "s3_json_stream.h"
+
+static const char *TAG = "JSON_STREAM";
+
+#define STREAM_KEY_MAX          64
+#define STREAM_BUF_INITIAL      1024
+#define STREAM_FILE_CHUNK       4096
+
+typedef enum {
+    EXPECT_VALUE,
+    EXPECT_KEY,
+    EXPECT_COLON,
+    EXPECT_NEXT,        // ',' or the closing bracket
+} expect_t;
+
+typedef struct {
+    char type;          // '{' or '['
+    bool split;
+    int index;          // Next element index of a split array
+    uint8_t path_len;   // Length of this container's path in stream->path
+    expect_t expect;
+} stream_frame_t;
+
+typedef enum {
+    CAPTURE_NONE,
+    CAPTURE_STRING,
+    CAPTURE_LITERAL,
+    CAPTURE_CONTAINER,
+} capture_t;
+
+struct s3_json_stream {
+    const char *const *split_paths;
+    int split_count;
+    s3_json_stream_cb_t cb;
+    void *ctx;
+
+    stream_frame_t frames[S3_JSON_STREAM_MAX_DEPTH];
+    int depth;
+    bool done;
+    bool failed;
+    bool stopped;       // By the callback
+    size_t offset;
+    char path[S3_JSON_STREAM_PATH_MAX];     // Path of the innermost open container
+
+    char key[STREAM_KEY_MAX];
+    int key_len;
+    bool in_key;
+    bool key_escape;
+
+    // Value being buffered for the callback
+    capture_t capture;
+    int nest;
+    bool cap_in_string;
+    bool cap_escape;
+    char cap_path[S3_JSON_STREAM_PATH_MAX];
+    int cap_index;
+    char *buf;
+    size_t len;
+    size_t size;
+    size_t peak;
+};
+
+s3_json_stream_t *s3_json_stream_create(const char *const *split_paths, int split_count,
+                                        s3_json_stream_cb_t cb, void *ctx) {
+    s3_json_stream_t *stream = heap_caps_calloc(1, sizeof(s3_json_stream_t), MALLOC_CAP_SPIRAM);
+    if (!stream) {
+        return NULL;
+    }
+    stream->split_paths = split_paths;
+    stream->split_count = split_count;
+    stream->cb = cb;
+    stream->ctx = ctx;
+    return stream;
+}
+
+void s3_json_stream_destroy(s3_json_stream_t *stream) {
+    if (!stream) {
+        return;
+    }
+    free(stream->buf);
+    free(stream);
+}
+
+size_t s3_json_stream_peak(const s3_json_stream_t *stream) {
+    return stream ? stream->peak : 0;
+}
+
+static bool stream_is_split(const s3_json_stream_t *stream, const char *path) {
+    for (int i = 0; i < stream->split_count; i++) {
+        if (strcmp(stream->split_paths[i], path) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static esp_err_t stream_append(s3_json_stream_t *stream, char c) {
+    if (stream->len + 1 >= stream->size) {
+        size_t new_size = stream->size ? stream->size * 2 : STREAM_BUF_INITIAL;
+        if (new_size > S3_JSON_STREAM_VALUE_MAX + 1) {
+            new_size = S3_JSON_STREAM_VALUE_MAX + 1;
+        }
+        if (new_size <= stream->len + 1) {
+            ESP_LOGE(TAG, "Value at %s larger than %d bytes", stream->cap_path, S3_JSON_STREAM_VALUE_MAX);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        char *grown = heap_caps_realloc(stream->buf, new_size, MALLOC_CAP_SPIRAM);
+        if (!grown) {
+            ESP_LOGE(TAG, "Failed to grow value buffer to %u bytes", (unsigned int)new_size);
+            return ESP_ERR_NO_MEM;
+        }
+        stream->buf = grown;
+        stream->size = new_size;
+    }
+    stream->buf[stream->len++] = c;
+    if (stream->len > stream->peak) {
+        stream->peak = stream->len;
+    }
+    return ESP_OK;
+}
+
+// A value has ended: the enclosing container expects ',' or its end next
+static void stream_value_done(s3_json_stream_t *stream) {
+    if (stream->depth == 0) {
+        stream->done = true;
+    } else {
+        stream->frames[stream->depth - 1].expect = EXPECT_NEXT;
+    }
+}
+
+static esp_err_t stream_capture_begin(s3_json_stream_t *stream, capture_t kind, const char *path, int index, char c) {
+    stream->capture = kind;
+    stream->nest = 1;
+    stream->cap_in_string = false;
+    stream->cap_escape = false;
+    strlcpy(stream->cap_path, path, sizeof(stream->cap_path));
+    stream->cap_index = index;
+    stream->len = 0;
+    return stream_append(stream, c);
+}
+
+static esp_err_t stream_capture_end(s3_json_stream_t *stream) {
+    stream->capture = CAPTURE_NONE;
+    stream->buf[stream->len] = '\0';    // stream_append() always leaves room
+
+    cJSON *value = cJSON_Parse(stream->buf);
+    if (!value) {
+        ESP_LOGE(TAG, "Malformed value at %s (byte %u)", stream->cap_path, (unsigned int)stream->offset);
+        return ESP_FAIL;
+    }
+    stream->stopped = !stream->cb(stream->cap_path, stream->cap_index, value, stream->ctx);
+    cJSON_Delete(value);
+    stream_value_done(stream);
+    return stream->stopped ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t stream_push(s3_json_stream_t *stream, char type, const char *path, bool split) {
+    if (stream->depth >= S3_JSON_STREAM_MAX_DEPTH) {
+        ESP_LOGE(TAG, "Nesting deeper than %d at %s", S3_JSON_STREAM_MAX_DEPTH, path);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    strlcpy(stream->path, path, sizeof(stream->path));
+    stream_frame_t *frame = &stream->frames[stream->depth++];
+    frame->type = type;
+    frame->split = split;
+    frame->index = 0;
+    frame->path_len = (uint8_t)strlen(stream->path);
+    frame->expect = type == '{' ? EXPECT_KEY : EXPECT_VALUE;
+    if (split) {
+        stream->stopped = !stream->cb(path, -1, NULL, stream->ctx);
+    }
+    return stream->stopped ? ESP_FAIL : ESP_OK;
+}
+
+static void stream_pop(s3_json_stream_t *stream) {
+    stream->depth--;
+    stream->path[stream->depth > 0 ? stream->frames[stream->depth - 1].path_len : 0] = '\0';
+    stream_value_done(stream);
+}
+
+static esp_err_t stream_begin_value(s3_json_stream_t *stream, char c, const char *path, int index) {
+    if (index >= 0) {
+        // Element of a split array: buffered whatever its type
+        capture_t kind = (c == '{' || c == '[') ? CAPTURE_CONTAINER : (c == '"' ? CAPTURE_STRING : CAPTURE_LITERAL);
+        return stream_capture_begin(stream, kind, path, index, c);
+    }
+    if (c == '{') {
+        return stream_push(stream, '{', path, false);
+    }
+    if (c == '[') {
+        if (stream_is_split(stream, path)) {
+            return stream_push(stream, '[', path, true);
+        }
+        return stream_capture_begin(stream, CAPTURE_CONTAINER, path, -1, c);
+    }
+    if (c == '"') {
+        return stream_capture_begin(stream, CAPTURE_STRING, path, -1, c);
+    }
+    if (c == '-' || isdigit((unsigned char)c) || c == 't' || c == 'f' || c == 'n') {
+        return stream_capture_begin(stream, CAPTURE_LITERAL, path, -1, c);
+    }
+    return ESP_FAIL;
+}
+
+// Consume one byte of a buffered value; *consumed is false when c ends a literal and must be parsed again
+static esp_err_t stream_capture_byte(s3_json_stream_t *stream, char c, bool *consumed) {
+    *consumed = true;
+    switch (stream->capture) {
+        case CAPTURE_STRING:
+            if (stream_append(stream, c) != ESP_OK) {
+                return ESP_ERR_NO_MEM;
+            }
+            if (stream->cap_escape) {
+                stream->cap_escape = false;
+            } else if (c == '\\') {
+                stream->cap_escape = true;
+            } else if (c == '"' && stream->len > 1) {
+                return stream_capture_end(stream);
+            }
+            return ESP_OK;
+
+        case CAPTURE_LITERAL:
+            if (c == ',' || c == '}' || c == ']' || isspace((unsigned char)c)) {
+                *consumed = false;
+                return stream_capture_end(stream);
+            }
+            return stream_append(stream, c);
+
+        case CAPTURE_CONTAINER: {
+            esp_err_t err = stream_append(stream, c);
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (stream->cap_in_string) {
+                if (stream->cap_escape) {
+                    stream->cap_escape = false;
+                } else if (c == '\\') {
+                    stream->cap_escape = true;
+                } else if (c == '"') {
+                    stream->cap_in_string = false;
+                }
+            } else if (c == '"') {
+                stream->cap_in_string = true;
+            } else if (c == '{' || c == '[') {
+                stream->nest++;
+            } else if ((c == '}' || c == ']') && --stream->nest == 0) {
+                return stream_capture_end(stream);
+            }
+            return ESP_OK;
+        }
+
+        default:
+            return ESP_OK;
+    }
+}
+
+static esp_err_t stream_byte(s3_json_stream_t *stream, char c) {
+    if (stream->capture != CAPTURE_NONE) {
+        bool consumed;
+        esp_err_t err = stream_capture_byte(stream, c, &consumed);
+        if (err != ESP_OK || consumed) {
+            return err;
+        }
+    }
+
+    if (stream->in_key) {
+        if (stream->key_escape) {
+            stream->key_escape = false;
+        } else if (c == '\\') {
+            stream->key_escape = true;
+        } else if (c == '"') {
+            stream->in_key = false;
+            stream->key[stream->key_len] = '\0';
+            stream->frames[stream->depth - 1].expect = EXPECT_COLON;
+            return ESP_OK;
+        }
+        if (stream->key_len < STREAM_KEY_MAX - 1) {
+            stream->key[stream->key_len++] = c;
+        }
+        return ESP_OK;
+    }
+
+    if (isspace((unsigned char)c)) {
+        return ESP_OK;
+    }
+    if (stream->done) {
+        return ESP_FAIL;    // Data after the document
+    }
+    if (stream->depth == 0) {
+        return stream_begin_value(stream, c, "", -1);
+    }
+
+    stream_frame_t *frame = &stream->frames[stream->depth - 1];
+    switch (frame->expect) {
+        case EXPECT_KEY:
+            if (c == '"') {
+                stream->in_key = true;
+                stream->key_len = 0;
+                return ESP_OK;
+            }
+            if (c == '}') {
+                stream_pop(stream);
+                return ESP_OK;
+            }
+            return ESP_FAIL;
+
+        case EXPECT_COLON:
+            if (c != ':') {
+                return ESP_FAIL;
+            }
+            frame->expect = EXPECT_VALUE;
+            return ESP_OK;
+
+        case EXPECT_VALUE:
+            if (frame->type == '[') {
+                if (c == ']') {
+                    stream_pop(stream);
+                    return ESP_OK;
+                }
+                return stream_begin_value(stream, c, stream->path, frame->index++);
+            } else {
+                char path[S3_JSON_STREAM_PATH_MAX];
+                strlcpy(path, stream->path, sizeof(path));
+                if (frame->path_len) {
+                    strlcat(path, ".", sizeof(path));
+                }
+                strlcat(path, stream->key, sizeof(path));
+                return stream_begin_value(stream, c, path, -1);
+            }
+
+        case EXPECT_NEXT:
+            if (c == ',') {
+                frame->expect = frame->type == '{' ? EXPECT_KEY : EXPECT_VALUE;
+                return ESP_OK;
+            }
+            if ((c == '}' && frame->type == '{') || (c == ']' && frame->type == '[')) {
+                stream_pop(stream);
+                return ESP_OK;
+            }
+            return ESP_FAIL;
+    }
+    return ESP_FAIL;
+}
+
+esp_err_t s3_json_stream_feed(s3_json_stream_t *stream, const char *data, size_t len) {
+    if (stream->failed) {
+        return ESP_FAIL;
+    }
+    for (size_t i = 0; i < len; i++, stream->offset++) {
+        esp_err_t err = stream_byte(stream, data[i]);
+        if (err != ESP_OK) {
+            if (err == ESP_FAIL && !stream->stopped) {
+                ESP_LOGE(TAG, "Malformed JSON at byte %u (in '%s')", (unsigned int)stream->offset, stream->path);
+            }
+            stream->failed = true;
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t s3_json_stream_finish(s3_json_stream_t *stream) {
+    if (stream->failed) {
+        return ESP_FAIL;
+    }
+    // A number as the whole document has no delimiter after it
+    if (stream->capture == CAPTURE_LITERAL && stream->depth == 0 && stream_capture_end(stream) != ESP_OK) {
+        stream->failed = true;
+        return ESP_FAIL;
+    }
+    if (!stream->done) {
+        ESP_LOGE(TAG, "Document truncated at byte %u", (unsigned int)stream->offset);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t s3_json_stream_file(const char *file_path, const char *const *split_paths, int split_count,
+                              s3_json_stream_cb_t cb, void *ctx) {
+    FILE *f = s3_fopen(file_path, "rb");
+    if (!f) {
+        ESP_LOGW(TAG, "Failed to open %s", file_path);
+        return ESP_FAIL;
+    }
+    char *chunk = heap_caps_malloc(STREAM_FILE_CHUNK, MALLOC_CAP_SPIRAM);
+    s3_json_stream_t *stream = s3_json_stream_create(split_paths, split_count, cb, ctx);
+    if (!chunk || !stream) {
+        free(chunk);
+        s3_json_stream_destroy(stream);
+        s3_fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = ESP_OK;
+    size_t n;
+    while (err == ESP_OK && (n = s3_fread(chunk, 1, STREAM_FILE_CHUNK, f)) > 0) {
+        err = s3_json_stream_feed(stream, chunk, n);
+    }
+    s3_fclose(f);
+    if (err == ESP_OK) {
+        err = s3_json_stream_finish(stream);
+    }
+    ESP_LOGI(TAG, "%s: %u bytes, largest value %u bytes", file_path,
+             (unsigned int)stream->offset, (unsigned int)stream->peak);
+
+    free(chunk);
+    s3_json_stream_destroy(stream);
+    return err;
+}
@@ -6,6 +6,7 @@
 #include <s3_logger.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <ctype.h>
@@ -16,12 +17,16 @@
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/ringbuf.h"
 #include "freertos/semphr.h"
 #include "stdbool.h"
 
 #include "s3_definitions.h"
+#include "s3_content_index.h"
 #include "s3_https_cloud.h"
+#include "s3_download_pool.h"
+#include "s3_download_journal.h"
+#include "s3_content_verify.h"
+#include "s3_json_stream.h"
 #include "s3_sync_account_contents.h"
 #if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
 #include "esp_crt_bundle.h"
@@ -34,9 +39,13 @@ static const char *TAG = "SYNC_CONTENTS";
 extern bool gWiFi_SYNC_USER_INTERRUPT;
 
 // Forward declaration - actual implementation will be provided by lv_decoders.c
-extern void jpeg_cache_invalidate(const char *path);
-extern void png_cache_invalidate(const char *path);
+extern void img_cache_invalidate(const char *path);
+extern esp_err_t lvgl_native_img_convert(const char *path);
+extern int lvgl_native_img_prune(void);
+// Provided by audio_player.c
+extern void audio_sound_cache_invalidate(const char *path);
 static void invalidate_image_cache(const char *path);
+static void convert_native_image(const char *path);
 
 static int gBabyPackCount;
 static s3_babyPack_t *gBabyPack = NULL;
@@ -55,6 +64,38 @@ typedef struct {
 
 static filename_contentid_entry_t* gFilenameContentIdMap = NULL;
 static int gFilenameContentIdMapCount = 0;
+static int gFilenameContentIdMapCap = 0;
+
+// Open-addressing string index over the parsed account model (keys are not owned)
+typedef struct {
+    const char *key;
+    int value;
+} account_slot_t;
+
+typedef struct {
+    account_slot_t *slots;
+    int cap;            // Power of two, 0 while empty
+    int count;
+    bool nocase;
+} account_hash_t;
+
+// Per-SKU view: expiry of the first occurrence (baby packs before NFCs), files of the first NFC entry
+typedef struct {
+    unsigned int expiresAt;
+    const s3_nfc_skus_t *nfcSku;
+} account_sku_entry_t;
+
+static account_hash_t gFilenameContentIdIndex = { .nocase = true };
+static account_hash_t gSkuIndex = { .nocase = false };
+static account_hash_t gNfcSnIndex = { .nocase = false };
+static account_sku_entry_t *gSkuEntries = NULL;
+static int gSkuEntryCount = 0;
+static bool gAccountModelLoaded = false;     // A parse completed since boot
+static bool gAccountModelBuilding = false;   // parser_account_contents() is filling the arrays
+
+// Guards every global above; recursive so getters can parse on first use while holding it
+static SemaphoreHandle_t gAccountModelMutex = NULL;
+static portMUX_TYPE gAccountModelMutexCreateLock = portMUX_INITIALIZER_UNLOCKED;
 
 // Global HTTP client for connection reuse to avoid repeated SSL handshakes
 static esp_http_client_handle_t g_reusable_client = NULL;
@@ -173,7 +214,6 @@ static esp_err_t recover_connection_if_needed(void) {
     return ESP_OK;
 }
 
-// Removed write_task function - now using direct file write instead of ring buffer system
 // ---- sync & re-download
 int get_file_size(const char *path) {
     if (!path)
@@ -189,34 +229,6 @@ int get_file_size(const char *path) {
     return (int) st.st_size;
 }
 
-// Network condition detection
-typedef enum {
-    NETWORK_FAST = 0,   // Taiwan-like: >100KB/s, low latency
-    NETWORK_SLOW,       // Brazil-like: <50KB/s, high latency  
-    NETWORK_UNKNOWN     // Initial state
-} network_condition_t;
-
-// Ring buffer download state
-typedef struct {
-    RingbufHandle_t ring_buffer;
-    TaskHandle_t write_task_handle;
-    FILE *file_handle;
-    volatile bool download_complete;
-    volatile bool write_error;
-    volatile esp_err_t error_code;
-    int total_downloaded;
-    int content_length;
-    char temp_path[512];
-    SemaphoreHandle_t completion_semaphore;
-    
-    // Network adaptation
-    network_condition_t network_condition;
-    int64_t download_start_time;
-    int ring_buffer_timeout_ms;
-    int write_task_timeout_ms;
-    bool use_direct_fallback;
-} download_context_t;
-
 // Central download speed calculation function - eliminates code duplication and ensures consistent calculation
 typedef struct {
     float current_speed_kbps;    // Speed for current measurement window
@@ -262,35 +274,19 @@ static download_speed_stats_t calculate_download_speed(
     return stats;
 }
 
-// Network condition detection
-static network_condition_t detect_network_condition(int64_t download_time_us, int bytes_downloaded) {
-    if (bytes_downloaded < 1024) return NETWORK_UNKNOWN; // Need some data first
-    
-    float speed_kbps = (bytes_downloaded / 1024.0f) / (download_time_us / 1000000.0f);
-    
-    if (speed_kbps > 80.0f) {
-        return NETWORK_FAST;  // Taiwan-like performance
-    } else if (speed_kbps < 50.0f) {
-        return NETWORK_SLOW;  // Brazil-like performance
-    }
-    
-    return NETWORK_UNKNOWN;
-}
+#define DIRECT_STREAM_BUF_SIZE  (32 * 1024)  // Each of the two buffers overlapping network reads and SD writes
 
-// Direct download fallback (without ring buffer)
+// Direct download: reads overlap SD writes through a double-buffered stream (see s3_download_pool.h)
 static esp_err_t direct_download_fallback(char *url, char *tempPath) {
     ESP_LOGW(TAG, "Using enhanced direct download fallback (resume + retry enabled) ");
 
     FILE *file = NULL;
-    long file_offset = 0;
-    bool resume_mode = false;
+    s3_dl_journal_t journal;
+    char validator[S3_DL_VALIDATOR_MAX] = {0};
 
-    struct stat st;
-    if (stat(tempPath, &st) == 0 && st.st_size > 0) {
-        file_offset = st.st_size;
-        resume_mode = true;
-        ESP_LOGW(TAG, "Existing temp file found with size: %ld bytes", file_offset);
-    }
+    // Partial file from an earlier attempt, sync or boot; discarded if it cannot be validated
+    long file_offset = s3_dl_journal_prepare(tempPath, url, -1, false, &journal);
+    bool resume_mode = file_offset > 0;
 
     esp_http_client_config_t config = {
             .url = url,
@@ -298,6 +294,8 @@ static esp_err_t direct_download_fallback(char *url, char *tempPath) {
             .timeout_ms = 30000,  // Longer timeout for slow networks
             .crt_bundle_attach = esp_crt_bundle_attach,  // Disabled for max speed
             .keep_alive_enable = true,
+            .event_handler = s3_dl_journal_http_event,
+            .user_data = validator,
     };
 
     esp_http_client_handle_t client = esp_http_client_init(&config);
@@ -314,6 +312,8 @@ static esp_err_t direct_download_fallback(char *url, char *tempPath) {
     if (resume_mode) {
         snprintf(range_header, sizeof(range_header), "bytes=%ld-", file_offset);
         esp_http_client_set_header(client, "Range", range_header);
+        // Server sends the whole file instead if its copy changed
+        esp_http_client_set_header(client, "If-Range", journal.validator);
         ESP_LOGI(TAG, "Resuming download from offset: %ld bytes", file_offset);
     }
 
@@ -325,20 +325,39 @@ static esp_err_t direct_download_fallback(char *url, char *tempPath) {
     }
 
     int actual_content_length = esp_http_client_fetch_headers(client);
+    int status = esp_http_client_get_status_code(client);
+    if (resume_mode && (status == 200 || status == 416 || s3_dl_journal_validator_changed(&journal, validator))) {
+        ESP_LOGW(TAG, "Direct fallback: server copy changed (HTTP %d), dropping %ld partial bytes", status, file_offset);
+        if (status != 200) {
+            // Body is a partial of the new copy or an error page: retry from zero
+            esp_http_client_close(client);
+            esp_http_client_cleanup(client);
+            s3_dl_journal_discard(tempPath);
+            return 999;
+        }
+        file_offset = 0;
+        resume_mode = false;
+    }
     if (resume_mode)
         actual_content_length = actual_content_length + file_offset;
     ESP_LOGI(TAG, "Direct fallback: Content length: %d", actual_content_length);
+    if (validator[0])
+        strlcpy(journal.validator, validator, sizeof(journal.validator));
 
     file = s3_fopen(tempPath, resume_mode ? "ab" : "wb");
-    if (file == NULL) {
+    s3_dl_stream_t *stream = file ? s3_dl_stream_open(file, DIRECT_STREAM_BUF_SIZE) : NULL;
+    if (stream == NULL) {
         ESP_LOGE(TAG, "Direct fallback: Failed to open file for writing: %s", tempPath);
+        if (file) s3_fclose(file);
         esp_http_client_close(client);
         esp_http_client_cleanup(client);
         return ESP_FAIL;
     }
 
-    char buffer[4096];
     int total_downloaded = 0;
+    bool write_failed = false;
+    journal.bytes = (int)file_offset;
+    s3_dl_journal_save(tempPath, &journal);
     int64_t start_us = esp_timer_get_time();
     int64_t last_log_us = start_us;
     int read_len_this_second = 0;
@@ -346,8 +365,11 @@ static esp_err_t direct_download_fallback(char *url, char *tempPath) {
     const int max_zero_read_retry = 0; // 最大 retry 次數
 
     total_downloaded = file_offset;
+    int next_checkpoint = total_downloaded + S3_DL_CHECKPOINT_BYTES;
     while (!gWiFi_SYNC_USER_INTERRUPT) {
-        int read_len = esp_http_client_read(client, buffer, sizeof(buffer));
+        size_t avail;
+        uint8_t *space = s3_dl_stream_space(stream, &avail);
+        int read_len = esp_http_client_read(client, (char *)space, avail);
         if (read_len <= 0) {
             zero_read_count++;
             ESP_LOGI(TAG, "No data %d/5 retries", zero_read_count);
@@ -360,10 +382,26 @@ static esp_err_t direct_download_fallback(char *url, char *tempPath) {
         }
         zero_read_count = 0;
 
-        s3_fwrite(buffer, 1, read_len, file);
+        // Hands full buffers to the SD writer; blocks only on real back-pressure
+        if (s3_dl_stream_produced(stream, read_len) != ESP_OK) {
+            ESP_LOGE(TAG, "Direct fallback: SD write failed for %s", tempPath);
+            write_failed = true;
+            break;
+        }
         total_downloaded += read_len;
         read_len_this_second += read_len;
 
+        // Journal checkpoint: progress survives a reboot or deep sleep from here on
+        if (total_downloaded >= next_checkpoint) {
+            if (s3_dl_stream_sync(stream) != ESP_OK) {
+                write_failed = true;
+                break;
+            }
+            journal.bytes = total_downloaded;
+            s3_dl_journal_save(tempPath, &journal);
+            next_checkpoint = total_downloaded + S3_DL_CHECKPOINT_BYTES;
+        }
+
         // Log speed every second using central speed calculation
         int64_t now_us = esp_timer_get_time();
         if (now_us - last_log_us >= 1000000) {
@@ -377,100 +415,51 @@ static esp_err_t direct_download_fallback(char *url, char *tempPath) {
             last_log_us = now_us;
             read_len_this_second = 0;
         }
-        vTaskDelay(10 / portTICK_PERIOD_MS);
     }
 
+    s3_dl_stream_stats_t stream_stats;
+    if (s3_dl_stream_close(stream, &stream_stats) != ESP_OK) {
+        write_failed = true;
+    }
     s3_fclose(file);
     esp_http_client_close(client);
     esp_http_client_cleanup(client);
 
+    float elapsed_s = (esp_timer_get_time() - start_us) / 1000000.0f;
+    float mb = stream_stats.bytes_written / (1024.0f * 1024.0f);
+    ESP_LOGI(TAG, "Direct fallback: %.2f MB in %.2f s, %.2f MB/s end to end, SD %.2f MB/s, throttled %lld ms",
+             mb, elapsed_s, elapsed_s > 0 ? mb / elapsed_s : 0.0f,
+             stream_stats.write_us > 0 ? mb / (stream_stats.write_us / 1000000.0f) : 0.0f,
+             stream_stats.throttle_us / 1000);
+
+    if (write_failed) {
+        return ESP_FAIL;
+    }
+
+    journal.bytes = total_downloaded;
     if (gWiFi_SYNC_USER_INTERRUPT) {
         ESP_LOGW(TAG, "Direct fallback: Download interrupted");
+        s3_dl_journal_save(tempPath, &journal);
         return ESP_FAIL;
     }
 
     if (actual_content_length > 0 && total_downloaded < actual_content_length) {
         ESP_LOGW(TAG, "File incomplete (%d/%d bytes) — can resume next time", total_downloaded, actual_content_length);
+        s3_dl_journal_save(tempPath, &journal);
         return 999;
     }else{
         ESP_LOGI(TAG, "Direct fallback: Downloaded %d bytes successfully", total_downloaded);
+        s3_dl_journal_done(tempPath);
         return ESP_OK;
     }
 
 }
 
-static void write_task(void *param) {
-    download_context_t *ctx = (download_context_t *)param;
-    size_t received_size = 0;
-    void *received_data = NULL;
-    
-    // Monitor stack usage for debugging
-    UBaseType_t stack_high_water_mark = uxTaskGetStackHighWaterMark(NULL);
-    ESP_LOGI(TAG, "Write task started for: %s (stack available: %d bytes)", ctx->temp_path, stack_high_water_mark * sizeof(StackType_t));
-    
-    // Use very short timeout initially for maximum responsiveness
-    TickType_t short_timeout = pdMS_TO_TICKS(50);   // 50ms for fast response
-    TickType_t long_timeout = pdMS_TO_TICKS(1000);  // 1s fallback timeout
-    
-    int no_data_count = 0;
-    
-    while (1) {
-        // Dynamically adjust timeout based on data availability
-        TickType_t current_timeout = (no_data_count > 2) ? long_timeout : short_timeout;
-        
-        // Receive data from ring buffer with adaptive timeout
-        received_data = xRingbufferReceive(ctx->ring_buffer, &received_size, current_timeout);
-        
-        if (received_data) {
-            // Reset no-data counter on successful receive
-            no_data_count = 0;
-            
-            // Write received data to file immediately
-            s3_fwrite(received_data, 1, received_size, ctx->file_handle);
-            vRingbufferReturnItem(ctx->ring_buffer, received_data);
-            
-            // Optional: Force flush for small files to ensure data is written
-            if (received_size < 4096) {
-                fflush(ctx->file_handle);
-            }
-        } else {
-            no_data_count++;
-            
-            if (ctx->download_complete) {
-                break;
-            }
-            
-            // If we've been waiting too long, something might be wrong
-            if (no_data_count > 20) {  // 20 * 1000ms = 20 seconds max
-                ESP_LOGW(TAG, "Write task: Long wait for data, checking completion status");
-                if (ctx->download_complete) break;
-                no_data_count = 10; // Reset but stay in long timeout mode
-            }
-        }
-    }
-    
-    // Ensure all data is written to disk
-    fflush(ctx->file_handle);
-    
-    ESP_LOGI(TAG, "Write task completed for: %s", ctx->temp_path);
-    
-    // Signal completion
-    if (ctx->completion_semaphore) {
-        xSemaphoreGive(ctx->completion_semaphore);
-    }
-    
-    vTaskDelete(NULL);
-}
-
 esp_err_t content_download(char *url, char *fullPath) {
     // Use safe download: download to temporary file first
     char tempPath[320];
     snprintf(tempPath, sizeof(tempPath), "%s.tmp", fullPath);
-    // Remove old temp file if exists to ensure clean download
-    if (access(tempPath, F_OK) == 0) {
-        ESP_LOGW(TAG, "content_download remove:%s", tempPath);
-        s3_remove(tempPath);
-    }
+    // A journaled partial temp file is resumed; direct_download_fallback() discards it if stale
     // Ensure directory exists for new download
     create_directories(tempPath);
 
@@ -522,26 +511,239 @@ void free_alarms(void) {
     gAlarmsCount = 0;
 }
 
+void free_nfc_copy(s3_nfc_t *nfc) {
+    if (!nfc)
+        return;
+    for (int j = 0; nfc->skus && j < nfc->skusCount; j++) {
+        free(nfc->skus[j].skuId);
+        free(nfc->skus[j].language);
+        for (int k = 0; k < nfc->skus[j].filenameCount; k++) {
+            free(nfc->skus[j].filenames[k]);
+        }
+        free(nfc->skus[j].filenames);
+    }
+    free(nfc->skus);
+    free(nfc->sn);
+    free(nfc->linked);
+    memset(nfc, 0, sizeof(*nfc));
+}
+
 void free_NFCs(void) {
     if (!gNfcs || gNfcCount <= 0)
         return;
     for (int i = 0; i < gNfcCount; i++) {
-        for (int j = 0; j < gNfcs[i].skusCount; j++) {
-            free(gNfcs[i].skus[j].skuId);
-            free(gNfcs[i].skus[j].language);
-        }
-        free(gNfcs[i].skus);
-        free(gNfcs[i].sn);
-        free(gNfcs[i].linked);
+        free_nfc_copy(&gNfcs[i]);
     }
     free(gNfcs);
     gNfcs = NULL;
     gNfcCount = 0;
 }
 
+static uint32_t account_hash_str(const char *str, bool nocase) {
+    uint32_t hash = 2166136261u;    // FNV-1a
+    for (; *str; str++) {
+        hash ^= (uint8_t)(nocase ? tolower((unsigned char)*str) : *str);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void account_hash_clear(account_hash_t *table) {
+    free(table->slots);
+    table->slots = NULL;
+    table->cap = 0;
+    table->count = 0;
+}
+
+static bool account_hash_grow(account_hash_t *table) {
+    int new_cap = table->cap ? table->cap * 2 : 64;
+    account_slot_t *slots = heap_caps_calloc(new_cap, sizeof(account_slot_t), MALLOC_CAP_SPIRAM);
+    if (!slots) {
+        ESP_LOGE(TAG, "Failed to grow account index to %d slots", new_cap);
+        return false;
+    }
+    for (int i = 0; i < table->cap; i++) {
+        if (!table->slots[i].key)
+            continue;
+        uint32_t j = account_hash_str(table->slots[i].key, table->nocase) & (new_cap - 1);
+        while (slots[j].key)
+            j = (j + 1) & (new_cap - 1);
+        slots[j] = table->slots[i];
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->cap = new_cap;
+    return true;
+}
+
+static int account_hash_get(const account_hash_t *table, const char *key) {
+    if (!key || table->cap == 0)
+        return -1;
+    uint32_t j = account_hash_str(key, table->nocase) & (table->cap - 1);
+    while (table->slots[j].key) {
+        int cmp = table->nocase ? strcasecmp(table->slots[j].key, key) : strcmp(table->slots[j].key, key);
+        if (cmp == 0)
+            return table->slots[j].value;
+        j = (j + 1) & (table->cap - 1);
+    }
+    return -1;
+}
+
+// Caller checks for an existing key first; the key must outlive the table
+static bool account_hash_put(account_hash_t *table, const char *key, int value) {
+    if ((table->count + 1) * 4 > table->cap * 3 && !account_hash_grow(table))
+        return false;
+    uint32_t j = account_hash_str(key, table->nocase) & (table->cap - 1);
+    while (table->slots[j].key)
+        j = (j + 1) & (table->cap - 1);
+    table->slots[j].key = key;
+    table->slots[j].value = value;
+    table->count++;
+    return true;
+}
+
+static void free_account_index(void) {
+    account_hash_clear(&gSkuIndex);
+    account_hash_clear(&gNfcSnIndex);
+    free(gSkuEntries);
+    gSkuEntries = NULL;
+    gSkuEntryCount = 0;
+}
+
+static void add_sku_entry(const char *skuId, unsigned int expiresAt, const s3_nfc_skus_t *nfcSku) {
+    int idx = account_hash_get(&gSkuIndex, skuId);
+    if (idx < 0) {
+        idx = gSkuEntryCount;
+        if (!account_hash_put(&gSkuIndex, skuId, idx))
+            return;
+        gSkuEntries[idx].expiresAt = expiresAt;
+        gSkuEntries[idx].nfcSku = NULL;
+        gSkuEntryCount++;
+    }
+    // SKURC playlists use the first NFC entry that actually lists files
+    if (nfcSku && (!gSkuEntries[idx].nfcSku || gSkuEntries[idx].nfcSku->filenameCount == 0))
+        gSkuEntries[idx].nfcSku = nfcSku;
+}
+
+/**
+ * @brief Index the parsed baby packs and NFCs by SKU and NFC serial number
+ *
+ * Runs once per parse, so NFC taps and playlist builds never walk the arrays or touch the JSON.
+ */
+static void build_account_index(void) {
+    free_account_index();
+
+    int total = gBabyPackCount;
+    for (int i = 0; gNfcs && i < gNfcCount; i++)
+        total += gNfcs[i].skusCount;
+    if (total > 0)
+        gSkuEntries = heap_caps_calloc(total, sizeof(account_sku_entry_t), MALLOC_CAP_SPIRAM);
+    if (total > 0 && !gSkuEntries) {
+        ESP_LOGE(TAG, "Failed to allocate account SKU index");
+        return;
+    }
+
+    for (int i = 0; gBabyPack && i < gBabyPackCount; i++) {
+        if (gBabyPack[i].skuId)
+            add_sku_entry(gBabyPack[i].skuId, gBabyPack[i].expiresAt, NULL);
+    }
+    for (int i = 0; gNfcs && i < gNfcCount; i++) {
+        if (gNfcs[i].sn && account_hash_get(&gNfcSnIndex, gNfcs[i].sn) < 0)
+            account_hash_put(&gNfcSnIndex, gNfcs[i].sn, i);
+        for (int j = 0; gNfcs[i].skus && j < gNfcs[i].skusCount; j++) {
+            if (gNfcs[i].skus[j].skuId)
+                add_sku_entry(gNfcs[i].skus[j].skuId, gNfcs[i].skus[j].expiresAt, &gNfcs[i].skus[j]);
+        }
+    }
+
+    ESP_LOGI(TAG, "Account index: %d SKUs, %d NFCs, %d filenames",
+             gSkuEntryCount, gNfcSnIndex.count, gFilenameContentIdIndex.count);
+}
+
+bool account_model_lock(void) {
+    if (gAccountModelMutex == NULL) {
+        SemaphoreHandle_t m = xSemaphoreCreateRecursiveMutex();
+        portENTER_CRITICAL(&gAccountModelMutexCreateLock);
+        if (gAccountModelMutex == NULL) {
+            gAccountModelMutex = m;
+            m = NULL;
+        }
+        portEXIT_CRITICAL(&gAccountModelMutexCreateLock);
+        if (m)
+            vSemaphoreDelete(m);
+    }
+    return gAccountModelMutex && xSemaphoreTakeRecursive(gAccountModelMutex, portMAX_DELAY) == pdTRUE;
+}
+
+void account_model_unlock(void) {
+    xSemaphoreGiveRecursive(gAccountModelMutex);
+}
+
+/**
+ * @brief Parse account_file.json if no parse has succeeded since boot (caller holds the model lock)
+ *
+ * Retried on every lookup until it succeeds, so a manifest written after the first lookup is
+ * still picked up. Skipped while a sync is filling the model.
+ */
+static void account_model_ensure_loaded(void) {
+    if (gAccountModelLoaded || gAccountModelBuilding)
+        return;
+    if (access("/sdcard/tmp/" CLOUD_ACCOUNT_FILENAME, F_OK) != 0)
+        return;
+    ESP_LOGI(TAG, "Account model not built yet, parsing %s", CLOUD_ACCOUNT_FILENAME);
+    parser_account_contents(PARSE_ONLY);
+}
+
+// Deep copy of one NFC entry, so callers can use it after the model lock is released
+static bool copy_nfc(const s3_nfc_t *src, s3_nfc_t *dst) {
+    memset(dst, 0, sizeof(*dst));
+    dst->sn = src->sn ? strdup_spiram(src->sn) : NULL;
+    dst->linked = src->linked ? strdup_spiram(src->linked) : NULL;
+    if (src->skus && src->skusCount > 0) {
+        dst->skus = heap_caps_calloc(src->skusCount, sizeof(s3_nfc_skus_t), MALLOC_CAP_SPIRAM);
+        if (!dst->skus)
+            goto _FAIL;
+        dst->skusCount = src->skusCount;
+    }
+    for (int j = 0; j < dst->skusCount; j++) {
+        const s3_nfc_skus_t *from = &src->skus[j];
+        s3_nfc_skus_t *to = &dst->skus[j];
+        to->skuId = from->skuId ? strdup_spiram(from->skuId) : NULL;
+        to->language = from->language ? strdup_spiram(from->language) : NULL;
+        to->contentCount = from->contentCount;
+        to->expiresAt = from->expiresAt;
+        if ((from->skuId && !to->skuId) || (from->language && !to->language))
+            goto _FAIL;
+        if (from->filenames && from->filenameCount > 0) {
+            to->filenames = heap_caps_calloc(from->filenameCount, sizeof(char *), MALLOC_CAP_SPIRAM);
+            if (!to->filenames)
+                goto _FAIL;
+            for (; to->filenameCount < from->filenameCount; to->filenameCount++) {
+                to->filenames[to->filenameCount] = strdup_spiram(from->filenames[to->filenameCount]);
+                if (!to->filenames[to->filenameCount])
+                    goto _FAIL;
+            }
+        }
+    }
+    if ((src->sn && !dst->sn) || (src->linked && !dst->linked))
+        goto _FAIL;
+    return true;
+
+_FAIL:
+    ESP_LOGE(TAG, "No memory to copy NFC %s", src->sn ? src->sn : "");
+    free_nfc_copy(dst);
+    return false;
+}
+
 void free_filename_contentid_map(void) {
-    if (!gFilenameContentIdMap || gFilenameContentIdMapCount <= 0)
+    account_hash_clear(&gFilenameContentIdIndex);
+    if (!gFilenameContentIdMap || gFilenameContentIdMapCount <= 0) {
+        free(gFilenameContentIdMap);
+        gFilenameContentIdMap = NULL;
+        gFilenameContentIdMapCount = 0;
+        gFilenameContentIdMapCap = 0;
         return;
+    }
     
     for (int i = 0; i < gFilenameContentIdMapCount; i++) {
         free(gFilenameContentIdMap[i].filename_lowercase);
@@ -550,6 +752,7 @@ void free_filename_contentid_map(void) {
     free(gFilenameContentIdMap);
     gFilenameContentIdMap = NULL;
     gFilenameContentIdMapCount = 0;
+    gFilenameContentIdMapCap = 0;
     ESP_LOGI(TAG, "Filename-ContentId mapping freed");
 }
 
@@ -578,84 +781,126 @@ static void add_filename_contentid_mapping(const char* filename, const char* con
         return;
     }
     
-    // Convert filename to lowercase
-    char* filename_lower = to_lowercase(filename);
-    if (!filename_lower) {
-        ESP_LOGE(TAG, "Failed to convert filename to lowercase: %s", filename);
+    // Check if mapping already exists (case-insensitive)
+    if (account_hash_get(&gFilenameContentIdIndex, filename) >= 0) {
+        ESP_LOGD(TAG, "Mapping already exists for filename: %s -> %s", filename, contentId);
         return;
     }
-    
-    // Check if mapping already exists
-    for (int i = 0; i < gFilenameContentIdMapCount; i++) {
-        if (strcmp(gFilenameContentIdMap[i].filename_lowercase, filename_lower) == 0) {
-            ESP_LOGD(TAG, "Mapping already exists for filename: %s -> %s", filename, contentId);
-            free(filename_lower);
+
+    // Grow map array geometrically; the index stores positions, not pointers into it
+    if (gFilenameContentIdMapCount == gFilenameContentIdMapCap) {
+        int new_cap = gFilenameContentIdMapCap ? gFilenameContentIdMapCap * 2 : 64;
+        filename_contentid_entry_t* new_map = heap_caps_realloc(
+            gFilenameContentIdMap,
+            new_cap * sizeof(filename_contentid_entry_t),
+            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT
+        );
+        if (!new_map) {
+            ESP_LOGE(TAG, "Failed to reallocate filename-contentId map");
             return;
         }
+        gFilenameContentIdMap = new_map;
+        gFilenameContentIdMapCap = new_cap;
     }
-    
-    // Reallocate map array
-    filename_contentid_entry_t* new_map = heap_caps_realloc(
-        gFilenameContentIdMap,
-        (gFilenameContentIdMapCount + 1) * sizeof(filename_contentid_entry_t),
-        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT
-    );
-    
-    if (!new_map) {
-        ESP_LOGE(TAG, "Failed to reallocate filename-contentId map");
+
+    char* filename_lower = to_lowercase(filename);
+    char* contentId_copy = strdup_spiram(contentId);
+    if (!filename_lower || !contentId_copy) {
+        ESP_LOGE(TAG, "Failed to allocate mapping for %s -> %s", filename, contentId);
         free(filename_lower);
+        free(contentId_copy);
         return;
     }
-    
-    gFilenameContentIdMap = new_map;
-    
-    // Add new mapping
-    gFilenameContentIdMap[gFilenameContentIdMapCount].filename_lowercase = filename_lower;
-    gFilenameContentIdMap[gFilenameContentIdMapCount].contentId = heap_caps_malloc(strlen(contentId) + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    
-    if (!gFilenameContentIdMap[gFilenameContentIdMapCount].contentId) {
-        ESP_LOGE(TAG, "Failed to allocate memory for contentId: %s", contentId);
+
+    if (!account_hash_put(&gFilenameContentIdIndex, filename_lower, gFilenameContentIdMapCount)) {
         free(filename_lower);
+        free(contentId_copy);
         return;
     }
-    
-    strcpy(gFilenameContentIdMap[gFilenameContentIdMapCount].contentId, contentId);
+    gFilenameContentIdMap[gFilenameContentIdMapCount].filename_lowercase = filename_lower;
+    gFilenameContentIdMap[gFilenameContentIdMapCount].contentId = contentId_copy;
     gFilenameContentIdMapCount++;
     
     ESP_LOGD(TAG, "Added mapping: %s -> %s", filename, contentId);
 }
 
 // Public API function to get contentId by filename
-const char* GetContentId(const char* filename) {
+char* GetContentId(const char* filename) {
     if (!filename) {
         ESP_LOGW(TAG, "GetContentId called with NULL filename");
         return NULL;
     }
-    
-    if (!gFilenameContentIdMap || gFilenameContentIdMapCount <= 0) {
-        ESP_LOGW(TAG, "Filename-ContentId map is empty or not initialized");
-        return NULL;
-    }
-    
-    // Convert input filename to lowercase
-    char* filename_lower = to_lowercase(filename);
-    if (!filename_lower) {
-        ESP_LOGE(TAG, "Failed to convert query filename to lowercase: %s", filename);
+    if (!account_model_lock())
         return NULL;
+
+    char *contentId = NULL;
+    account_model_ensure_loaded();
+    int idx = account_hash_get(&gFilenameContentIdIndex, filename);
+    if (idx >= 0) {
+        ESP_LOGD(TAG, "Found contentId for %s: %s", filename, gFilenameContentIdMap[idx].contentId);
+        contentId = strdup_spiram(gFilenameContentIdMap[idx].contentId);
+    } else if (!gFilenameContentIdMap || gFilenameContentIdMapCount <= 0) {
+        ESP_LOGW(TAG, "Filename-ContentId map is empty or not initialized");
+    } else {
+        ESP_LOGD(TAG, "No contentId found for filename: %s", filename);
     }
-    
-    // Search for matching filename
-    for (int i = 0; i < gFilenameContentIdMapCount; i++) {
-        if (strcmp(gFilenameContentIdMap[i].filename_lowercase, filename_lower) == 0) {
-            free(filename_lower);
-            ESP_LOGD(TAG, "Found contentId for %s: %s", filename, gFilenameContentIdMap[i].contentId);
-            return gFilenameContentIdMap[i].contentId;
+    account_model_unlock();
+    return contentId;
+}
+
+bool find_nfc_by_sn(const char *sn, s3_nfc_t *nfc) {
+    if (!account_model_lock())
+        return false;
+    account_model_ensure_loaded();
+    int idx = account_hash_get(&gNfcSnIndex, sn);
+    bool found = idx >= 0 && (!nfc || copy_nfc(&gNfcs[idx], nfc));
+    account_model_unlock();
+    return found;
+}
+
+bool find_sku_expires_at(const char *skuId, unsigned int *expiresAt) {
+    if (!account_model_lock())
+        return false;
+    account_model_ensure_loaded();
+    int idx = account_hash_get(&gSkuIndex, skuId);
+    if (idx >= 0 && expiresAt)
+        *expiresAt = gSkuEntries[idx].expiresAt;
+    account_model_unlock();
+    return idx >= 0;
+}
+
+int get_sku_filenames(const char *skuId, char ***filenames) {
+    *filenames = NULL;
+    if (!account_model_lock())
+        return 0;
+    account_model_ensure_loaded();
+    int idx = account_hash_get(&gSkuIndex, skuId);
+    const s3_nfc_skus_t *nfcSku = idx >= 0 ? gSkuEntries[idx].nfcSku : NULL;
+    int count = 0;
+    if (nfcSku && nfcSku->filenameCount > 0) {
+        char **copy = heap_caps_calloc(nfcSku->filenameCount, sizeof(char *), MALLOC_CAP_SPIRAM);
+        for (; copy && count < nfcSku->filenameCount; count++) {
+            if (!(copy[count] = strdup_spiram(nfcSku->filenames[count])))
+                break;
+        }
+        if (copy && count < nfcSku->filenameCount) {
+            free_sku_filenames(copy, count);
+            copy = NULL;
+        }
+        if (!copy) {
+            ESP_LOGE(TAG, "No memory to copy the file list of %s", skuId);
+            count = 0;
         }
+        *filenames = copy;
     }
-    
-    free(filename_lower);
-    ESP_LOGD(TAG, "No contentId found for filename: %s", filename);
-    return NULL;
+    account_model_unlock();
+    return count;
+}
+
+void free_sku_filenames(char **filenames, int count) {
+    for (int i = 0; filenames && i < count; i++)
+        free(filenames[i]);
+    free(filenames);
 }
 
 // Comparison result enum (used for both resource and content differential updates)
@@ -671,716 +916,634 @@ typedef struct {
     char *url;         // Download URL
     int size;          // File size in bytes
     char *contentType; // "babypack", "alarm", "nfc"
+    resource_change_type_t change;  // Against the old manifest, set by diff_content_manifests()
 } content_entry_t;
 
+// Outcome of a manifest diff; duplicate paths count once
+typedef struct {
+    int unchanged;
+    int modified;
+    int added;
+    int removed;    // In the old manifest only
+} manifest_diff_stats_t;
+
+// Arrays of account_file.json delivered one element at a time by the stream parser
+static const char *const ACCOUNT_SPLIT_PATHS[] = { "result.babyPacks", "result.alarms", "result.NFCs" };
+#define ACCOUNT_SPLIT_PATH_COUNT ((int)(sizeof(ACCOUNT_SPLIT_PATHS) / sizeof(ACCOUNT_SPLIT_PATHS[0])))
+
 // Forward declarations for content manifest helper functions
 static content_entry_t* parse_account_contents_manifest(const char *json_path, int *out_count);
 static void free_content_entries(content_entry_t *entries, int count);
-static resource_change_type_t compare_content_entry(
-    const content_entry_t *new_entry,
-    const content_entry_t *old_entries,
-    int old_count
-);
+static void diff_content_manifests(content_entry_t *new_entries, int new_count,
+                                   const content_entry_t *old_entries, int old_count,
+                                   account_hash_t *new_index, manifest_diff_stats_t *stats);
 
+// Per-file state handed to the download pool; freed by install_downloaded_file()
+typedef struct {
+    char *fullName;
+    int expected_size;
+} content_job_t;
 
-esp_err_t parser_account_contents(int justPaserContent) {
-    ESP_LOGI(TAG, "parser_account_contents justPaser? %d", justPaserContent );
-
-    // Clean up existing data and filename-contentId map
-    free_baby_packs();
-    free_alarms();
-    free_NFCs();
-    free_filename_contentid_map();
-
-    char *buf = read_file_to_spiram("/sdcard/tmp/" CLOUD_ACCOUNT_FILENAME);
-    if (buf == NULL) {
-        return ESP_FAIL;
-    }
-    ESP_LOGD(TAG, "%s",buf);  // print account_file.json
+/**
+ * @brief Swap a finished download into place (runs in a download pool worker)
+ *
+ * The original is kept as .bak until the rename succeeds, so a failed replace never
+ * leaves the album without the previous version of the file.
+ * @return ESP_OK once the file is in place; otherwise the pool counts the job as failed
+ */
+static esp_err_t install_downloaded_file(esp_err_t result, const char *tempDownloadPath, int download_size,
+                                         const char *sha256_hex, void *ctx) {
+    content_job_t *job = (content_job_t *)ctx;
+    const char *fullName = job->fullName;
+    esp_err_t ret = ESP_FAIL;
 
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to parse JSON");
-        free(buf);
-        return ESP_FAIL;
-    }
-    const cJSON *result = cJSON_GetObjectItem(root, "result");
-    if (!cJSON_IsObject(result)) {
-        ESP_LOGE(TAG, "No 'result' object in JSON");
-        goto _FAIL;
-    }
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "Download failed for %s", fullName);
+        ret = result;
+    } else if (download_size != job->expected_size) {
+        ESP_LOGE(TAG, "Downloaded file size mismatch: expected %d, got %d - kept at %s", job->expected_size, download_size, tempDownloadPath);
+        ret = ESP_ERR_INVALID_SIZE;
+    } else {
+        // Ensure destination directory exists before replacement
+        create_directories(fullName);
 
-    const cJSON *babyId = cJSON_GetObjectItem(result, "babyId");
-    if (!cJSON_IsString(babyId)) {
-        ESP_LOGE(TAG, "'babyId' is not an string");
-        goto _FAIL;
-    }
-	strncpy(s3_babyId, babyId->valuestring, 32 - 1);
-	s3_babyId[32 - 1] = '\0';
-	ESP_LOGI(TAG, "babyId:%s", s3_babyId);
+        char backupPath[256];
+        snprintf(backupPath, sizeof(backupPath), "%s.bak", fullName);
+        if (access(backupPath, F_OK) == 0) {
+            unlink(backupPath);
+        }
 
-    const cJSON *kid = cJSON_GetObjectItem(result, "kidCharacter");
-    if (!cJSON_IsString(kid)) {
-        ESP_LOGE(TAG, "'kid' is not an string");
-        goto _FAIL;
+        // Step 1: Rename original to backup (if original exists)
+        bool had_original = (access(fullName, F_OK) == 0);
+        if (had_original == false)
+            create_directories(backupPath);
+        if (had_original && s3_rename(fullName, backupPath) != 0) {
+            ESP_LOGE(TAG, "Failed to backup original file %s", fullName);
+        } else {
+            // Step 2: Move temp to original place
+            if (s3_rename(tempDownloadPath, fullName) == 0) {
+                // Step 3: Success - remove backup
+                if (had_original) s3_remove(backupPath);
+                ESP_LOGI(TAG, "Successfully replaced %s (%d bytes)", fullName, download_size);
+                s3_content_index_file_updated(fullName);
+                s3_content_verify_record(fullName, sha256_hex, download_size);
+                convert_native_image(fullName);
+                ret = ESP_OK;
+            } else {
+                // Step 4: Failed - restore original from backup
+                if (had_original) s3_rename(backupPath, fullName);
+                ESP_LOGE(TAG, "Failed to replace %s - original restored, downloaded file kept at %s", fullName, tempDownloadPath);
+            }
+        }
     }
-    strcpy(s3_WiFiSyncKidIcon, kid->valuestring);
-    ESP_LOGI(TAG, "kid:%s",s3_WiFiSyncKidIcon);
-
-    // ========== DIFFERENTIAL UPDATE PREPARATION START ==========
 
-    // Skip differential logic if justPaserContent (only parsing metadata)
-    content_entry_t *new_entries = NULL;
-    content_entry_t *old_entries = NULL;
-    int new_count = 0;
-    int old_count = 0;
-    bool has_old_manifest = false;
+    free(job->fullName);
+    free(job);
+    return ret;
+}
 
-    if (!justPaserContent) {
-        // Log memory status before parsing to diagnose issues
-        ESP_LOGI(TAG, "Pre-parse memory: Free heap: %u bytes, Free SPIRAM: %u bytes",
-            heap_caps_get_free_size(MALLOC_CAP_8BIT),
-            heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+// Optional per-file digest in the manifest ("sha256" preferred, else "md5"); NULL if none
+static const char *manifest_digest(const cJSON *entry) {
+    const cJSON *digest = cJSON_GetObjectItem(entry, "sha256");
+    if (!cJSON_IsString(digest))
+        digest = cJSON_GetObjectItem(entry, "md5");
+    return cJSON_IsString(digest) && digest->valuestring[0] ? digest->valuestring : NULL;
+}
 
-        // Step 1: Parse NEW manifest FIRST (critical - must succeed)
-        new_entries = parse_account_contents_manifest("/sdcard/tmp/" CLOUD_ACCOUNT_FILENAME, &new_count);
-        if (!new_entries) {
-            ESP_LOGW(TAG, "Failed to parse new content manifest - proceeding without differential update");
-        } else {
-            ESP_LOGI(TAG, "Parsed %d entries from new content manifest", new_count);
+/**
+ * @brief Queue one content file on the download pool
+ *
+ * Files download to /sdcard/tmp/downloads/<folder>_<filename>.tmp: the folder prefix keeps
+ * two albums that ship the same filename from sharing a temp file while they download in parallel.
+ */
+static esp_err_t queue_content_download(const char *url, const char *fullName, int expected_size, const char *expected_digest) {
+    char tempDownloadPath[320];
+    const char *filename_only = strrchr(fullName, '/');
+    const char *folder = filename_only;
+    while (folder && folder > fullName && *(folder - 1) != '/')
+        folder--;
+    if (filename_only) filename_only++; else filename_only = fullName;
+    int folder_len = (folder && filename_only - folder > 1) ? (int)(filename_only - folder - 1) : 0;
+    snprintf(tempDownloadPath, sizeof(tempDownloadPath), "/sdcard/tmp/downloads/%.*s%s%s.tmp",
+             folder_len, folder ? folder : "", folder_len ? "_" : "", filename_only);
+
+    // A partial file left by an earlier sync is resumed by the pool (see s3_download_journal.h)
+    create_directories(tempDownloadPath);
+
+    content_job_t *job = heap_caps_calloc(1, sizeof(content_job_t), MALLOC_CAP_SPIRAM);
+    if (!job || !(job->fullName = strdup_spiram(fullName))) {
+        free(job);
+        ESP_LOGE(TAG, "No memory to queue %s", fullName);
+        return ESP_ERR_NO_MEM;
+    }
+    job->expected_size = expected_size;
+
+    esp_err_t err = s3_download_pool_submit(url, tempDownloadPath, expected_size, expected_digest,
+                                            install_downloaded_file, job);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to queue %s: %s", fullName, esp_err_to_name(err));
+        free(job->fullName);
+        free(job);
+    }
+    return err;
+}
 
-            // Log memory after parsing new manifest
-            ESP_LOGI(TAG, "Post-new-manifest memory: Free heap: %u bytes, Free SPIRAM: %u bytes",
-                heap_caps_get_free_size(MALLOC_CAP_8BIT),
-                heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+// State shared by the account_file.json stream callbacks
+typedef struct {
+    int justPaserContent;
+    const content_entry_t *new_entries;
+    const account_hash_t *new_index;    // fullPath -> new_entries index
+    int babyPackCap;
+    int alarmsCap;
+    int nfcCap;
+    bool has_babyId;
+    bool has_kid;
+    bool has_babyPacks;
+    bool has_alarms;
+    bool has_NFCs;
+    bool failed;
+    bool queue_failed;      // A wanted file could not be handed to the download pool
+} account_parse_ctx_t;
+
+// Make room for element index of a model array; new slots are zeroed
+static bool account_array_reserve(void **array, int *cap, int index, size_t elem_size) {
+    if (index < *cap)
+        return true;
+    int new_cap = *cap ? *cap * 2 : 8;
+    while (new_cap <= index)
+        new_cap *= 2;
+    void *grown = heap_caps_realloc(*array, new_cap * elem_size, MALLOC_CAP_SPIRAM);
+    if (!grown) {
+        ESP_LOGE(TAG, "Failed to grow account array to %d entries", new_cap);
+        return false;
+    }
+    memset((char *)grown + *cap * elem_size, 0, (new_cap - *cap) * elem_size);
+    *array = grown;
+    *cap = new_cap;
+    return true;
+}
 
-            // Step 2: Check for and parse OLD manifest (optional - for differential comparison)
-            char backup_path[256];
-            snprintf(backup_path, sizeof(backup_path), "/sdcard/tmp/%s.bak", CLOUD_ACCOUNT_FILENAME);
-            has_old_manifest = (access(backup_path, F_OK) == 0);
+// Queue one content file unless the diff says it is unchanged and it is on the card
+static void account_sync_file(account_parse_ctx_t *ctx, const char *label, const char *folder,
+                              const char *filename, const char *url, int fileSize, const cJSON *item) {
+    char fullName[128];
+    snprintf(fullName, sizeof(fullName), SDCARD_CONTENT_FULLNAME, folder, filename);
 
-            if (has_old_manifest) {
-                ESP_LOGI(TAG, "Found old content manifest backup, parsing for differential update");
-                old_entries = parse_account_contents_manifest(backup_path, &old_count);
-                if (old_entries) {
-                    ESP_LOGI(TAG, "Parsed %d entries from old content manifest", old_count);
-                } else {
-                    ESP_LOGW(TAG, "Failed to parse old content manifest, will download all files");
-                    has_old_manifest = false;
-                }
-            } else {
-                ESP_LOGI(TAG, "No old content manifest backup found, will download all files");
-            }
+    // ========== DIFFERENTIAL UPDATE LOGIC ==========
+    int entry_idx = account_hash_get(ctx->new_index, fullName);
+    resource_change_type_t change_type = entry_idx >= 0 ? ctx->new_entries[entry_idx].change : RESOURCE_NEW;
 
-            // Step 3: Compare manifests and count changes
-            int unchanged_count = 0;
-            int modified_count = 0;
-            int new_file_count = 0;
-
-            for (int i = 0; i < new_count; i++) {
-                content_entry_t *entry = &new_entries[i];
-                resource_change_type_t change_type = compare_content_entry(entry, old_entries, old_count);
-
-                switch (change_type) {
-                    case RESOURCE_UNCHANGED:
-                        unchanged_count++;
-                        break;
-                    case RESOURCE_MODIFIED:
-                        modified_count++;
-                        break;
-                    case RESOURCE_NEW:
-                        new_file_count++;
-                        break;
-                }
-            }
+    int size = get_file_size(fullName);
 
-            ESP_LOGI(TAG, "========== CONTENT DIFFERENTIAL UPDATE SUMMARY ==========");
-            ESP_LOGI(TAG, "Total files in new manifest: %d", new_count);
-            ESP_LOGI(TAG, "Unchanged files: %d (will skip if exists)", unchanged_count);
-            ESP_LOGI(TAG, "Modified files: %d (will re-download)", modified_count);
-            ESP_LOGI(TAG, "New files: %d (will download)", new_file_count);
-            ESP_LOGI(TAG, "Expected downloads: %d", modified_count + new_file_count);
-            ESP_LOGI(TAG, "=========================================================");
+    // Check if file is unchanged and exists with correct size
+    if (change_type == RESOURCE_UNCHANGED && size >= 0 && size == fileSize) {
+        ESP_LOGI(TAG, "[%s UNCHANGED - skipped]: %s (size: %d bytes)", label, fullName, size);
+        convert_native_image(fullName);
+        return;  // Skip downloading this file
+    }
 
-            // Note: Keep old_entries for download loops - will free at function end
-        }
+    // File needs to be downloaded (either MODIFIED or NEW, or UNCHANGED but missing/corrupted)
+    if (change_type == RESOURCE_MODIFIED) {
+        ESP_LOGI(TAG, "[%s MODIFIED - download]: %s", label, fullName);
+    } else if (change_type == RESOURCE_NEW) {
+        ESP_LOGI(TAG, "[%s NEW - download]: %s", label, fullName);
     }
 
-    // ========== DIFFERENTIAL UPDATE PREPARATION END ==========
+    // Initialize attempt counter for this file
+    int attempt = 1;
+    ESP_LOGI(TAG, "[AudioData n%d - start]: %s", attempt, fullName);
 
-    char path[128];
-    char fullName[128];
+    if (size >= 0 && size == fileSize) {
+        ESP_LOGI(TAG, "[AudioData n%d - success]: %s", attempt, fullName);
+    } else {
+        ESP_LOGW(TAG, "[AudioData n%d - fail]: %s, received:%d, expected:%d", attempt, fullName, size, fileSize);
 
-    // babyPacks
-    const cJSON *babyPacks = cJSON_GetObjectItem(result, "babyPacks");
-    if (!cJSON_IsArray(babyPacks)) {
-        ESP_LOGE(TAG, "'babyPacks' is not an array");
-        goto _FAIL;
+        // Downloaded by the pool; install_downloaded_file() swaps it into place. The submit
+        // waits for queue space, so lookups get the model lock meanwhile (they see no index yet)
+        account_model_unlock();
+        if (queue_content_download(url, fullName, fileSize, manifest_digest(item)) != ESP_OK)
+            ctx->queue_failed = true;
+        account_model_lock();
     }
+}
 
-    gBabyPackCount = 0;
-    gBabyPackCount = cJSON_GetArraySize(babyPacks);
-    ESP_LOGI(TAG, "babyPacks count: %d", gBabyPackCount);
-    if (gBabyPackCount <= 0) {
-        ESP_LOGE(TAG, "No babyPacks in JSON");
-    }else {
-        gBabyPack = heap_caps_calloc(gBabyPackCount, sizeof(s3_babyPack_t), MALLOC_CAP_SPIRAM);
+static bool account_parse_baby_pack(account_parse_ctx_t *ctx, int i, const cJSON *pack) {
+    if (!account_array_reserve((void **)&gBabyPack, &ctx->babyPackCap, i, sizeof(s3_babyPack_t)))
+        return false;
+    gBabyPackCount = i + 1;
+    if (!cJSON_IsObject(pack))
+        return true;
+
+    const cJSON *skuId = cJSON_GetObjectItem(pack, "skuId");
+    const cJSON *language = cJSON_GetObjectItem(pack, "language");
+    const cJSON *contents = cJSON_GetObjectItem(pack, "contents");
+    if (!cJSON_IsArray(contents))
+        return true;
+    int contentCount = cJSON_GetArraySize(contents);
+
+    if (cJSON_IsString(skuId))
+        gBabyPack[i].skuId = strdup_spiram(skuId->valuestring);
+
+    if (cJSON_IsString(language))
+        gBabyPack[i].language = strdup_spiram(language->valuestring);
+    else
+        gBabyPack[i].language = strdup_spiram("en-us"); // Default fallback
+
+    // Store the content count from JSON
+    gBabyPack[i].contentCount = contentCount;
+
+    const cJSON *expiresAt = cJSON_GetObjectItem(pack, "expiresAt");
+    if (cJSON_IsNumber(expiresAt)) {
+        gBabyPack[i].expiresAt = (unsigned int)expiresAt->valuedouble;
+    } else {
+        gBabyPack[i].expiresAt = 0;
     }
 
-    for (int i = 0; i < gBabyPackCount; i++) {
-
-        cJSON *pack = cJSON_GetArrayItem(babyPacks, i);
-        if (!cJSON_IsObject(pack))
+    // ~~~ get contents ~~~
+    int j = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, contents) {
+        if (gWiFi_SYNC_USER_INTERRUPT)
+            return false;
+        int idx = j++;
+        if (!cJSON_IsObject(item))
             continue;
 
-        cJSON *skuId = cJSON_GetObjectItem(pack, "skuId");
-        cJSON *language = cJSON_GetObjectItem(pack, "language");
-        cJSON *contents = cJSON_GetObjectItem(pack, "contents");
-        if (!cJSON_IsArray(contents))
-            continue;
-        int contentCount = cJSON_GetArraySize(contents);
+        const cJSON *url = cJSON_GetObjectItem(item, "url");
+        const cJSON *fileSize = cJSON_GetObjectItem(item, "fileSize");
+        const cJSON *filename = cJSON_GetObjectItem(item, "filename");
+        const cJSON *contentId = cJSON_GetObjectItem(item, "contentId");
 
-        if (cJSON_IsString(skuId))
-            gBabyPack[i].skuId = strdup_spiram(skuId->valuestring);
-        
-        if (cJSON_IsString(language))
-            gBabyPack[i].language = strdup_spiram(language->valuestring);
-        else
-            gBabyPack[i].language = strdup_spiram("en-us"); // Default fallback
-        
-        // Store the content count from JSON
-        gBabyPack[i].contentCount = contentCount;
+        if (!(cJSON_IsString(filename) && cJSON_IsString(url) && cJSON_IsNumber(fileSize)))
+            continue;
 
-        cJSON *expiresAt = cJSON_GetObjectItem(pack, "expiresAt");
-        if (cJSON_IsNumber(expiresAt)) {
-            gBabyPack[i].expiresAt = (unsigned int)expiresAt->valuedouble;
-        } else {
-            gBabyPack[i].expiresAt = 0;
+        // Add filename-contentId mapping
+        if (cJSON_IsString(contentId)) {
+            add_filename_contentid_mapping(filename->valuestring, contentId->valuestring);
         }
+        if (ctx->justPaserContent || !cJSON_IsString(skuId))
+            continue;
 
-        // ~~~ get contents ~~~
-        for (int j = 0; j < contentCount; j++) {
-        	if (gWiFi_SYNC_USER_INTERRUPT)
-        		goto _FAIL;
-            cJSON *item = cJSON_GetArrayItem(contents, j);
-            if (!cJSON_IsObject(item))
-                continue;
-
-            cJSON *url = cJSON_GetObjectItem(item, "url");
-            cJSON *fileSize = cJSON_GetObjectItem(item, "fileSize");
-            cJSON *filename = cJSON_GetObjectItem(item, "filename");
-            cJSON *contentId = cJSON_GetObjectItem(item, "contentId");
-
-            if (!(cJSON_IsString(filename) && cJSON_IsString(url) && cJSON_IsNumber(fileSize)))
-                continue;
-                
-            // Add filename-contentId mapping
-            if (cJSON_IsString(contentId)) {
-                add_filename_contentid_mapping(filename->valuestring, contentId->valuestring);
-            }
-            if (justPaserContent)
-            	continue;
-
-            ESP_LOGD(TAG, "  [%d] filename: %s", j, cJSON_IsString(filename) ? filename->valuestring : "N/A");
-            ESP_LOGD(TAG, "      url: %s", cJSON_IsString(url) ? url->valuestring : "N/A");
-            ESP_LOGD(TAG, "      size: %d", cJSON_IsNumber(fileSize) ? fileSize->valueint : -1);
-
-            memset(path, 0, sizeof(path));
-            memset(fullName, 0, sizeof(fullName));
-            sprintf(path, SDCARD_CONTENT_PATH, skuId->valuestring);
-            sprintf(fullName, SDCARD_CONTENT_FULLNAME, skuId->valuestring, filename->valuestring);
-
-            // ========== DIFFERENTIAL UPDATE LOGIC (BabyPacks) ==========
-            // Find this file in the new_entries array to determine change type
-            resource_change_type_t change_type = RESOURCE_NEW;
-            content_entry_t *matching_entry = NULL;
-
-            if (new_entries && new_count > 0) {
-                for (int k = 0; k < new_count; k++) {
-                    if (strcmp(new_entries[k].fullPath, fullName) == 0) {
-                        matching_entry = &new_entries[k];
-                        change_type = compare_content_entry(matching_entry, old_entries, old_count);
-                        break;
-                    }
-                }
-            }
-
-            int size = get_file_size(fullName);
-
-            // Check if file is unchanged and exists with correct size
-            if (change_type == RESOURCE_UNCHANGED && size >= 0 && size == fileSize->valueint) {
-                ESP_LOGI(TAG, "[BabyPack UNCHANGED - skipped]: %s (size: %d bytes)", fullName, size);
-                continue;  // Skip downloading this file
-            }
-
-            // File needs to be downloaded (either MODIFIED or NEW, or UNCHANGED but missing/corrupted)
-            if (change_type == RESOURCE_MODIFIED) {
-                ESP_LOGI(TAG, "[BabyPack MODIFIED - download]: %s", fullName);
-            } else if (change_type == RESOURCE_NEW) {
-                ESP_LOGI(TAG, "[BabyPack NEW - download]: %s", fullName);
-            }
-
-            // Initialize attempt counter for this file
-            int attempt = 1;
-            ESP_LOGI(TAG, "[AudioData n%d - start]: %s", attempt, fullName);
+        ESP_LOGD(TAG, "  [%d] filename: %s", idx, filename->valuestring);
+        ESP_LOGD(TAG, "      url: %s", url->valuestring);
+        ESP_LOGD(TAG, "      size: %d", fileSize->valueint);
 
-            if (size >= 0 && size == fileSize->valueint) {
-                ESP_LOGI(TAG, "[AudioData n%d - success]: %s", attempt, fullName);
-            } else {
-                ESP_LOGW(TAG, "[AudioData n%d - fail]: %s, received:%d, expected:%d", attempt, fullName, size, fileSize->valueint);
-                attempt++; // Increment for actual download attempts
-                
-                // Download to tmp/downloads instead of overwriting original
-                char downloadPath[300];
-                const char* filename_only = strrchr(fullName, '/');
-                if (filename_only) filename_only++; else filename_only = fullName;
-                snprintf(downloadPath, sizeof(downloadPath), "/sdcard/tmp/downloads/%s", filename_only);
-                create_directories(downloadPath);
-
-                // Try download with retry tracking
-                esp_err_t result = ESP_FAIL;
-                while (attempt <= MAX_DOWNLOAD_ATTEMPTS && result != ESP_OK) {
-                    ESP_LOGI(TAG, "[AudioData n%d - start]: %s", attempt, downloadPath);
-                    result = content_download(url->valuestring, downloadPath);
-                    
-                    if (result != ESP_OK) {
-                        ESP_LOGW(TAG, "[AudioData n%d - fail]: download failed", attempt);
-                        attempt++;
-                    } else {
-                        ESP_LOGI(TAG, "[AudioData n%d - success]: %s", attempt, downloadPath);
-                    }
-                }
-                
-                if (result == ESP_OK) {
-                    // content_download leaves file at downloadPath.tmp, check that file
-                    char tempDownloadPath[320];
-                    snprintf(tempDownloadPath, sizeof(tempDownloadPath), "%s.tmp", downloadPath);
-                    int download_size = get_file_size(tempDownloadPath);
-                    if (download_size == fileSize->valueint) {
-                        // Download successful and size matches - replace original atomically with backup strategy
-                        // Ensure destination directory exists before replacement
-                        create_directories(fullName);
-                        
-                        char backupPath[256];
-                        snprintf(backupPath, sizeof(backupPath), "%s.bak", fullName);
-                        if (access(backupPath, F_OK) == 0) {
-                            unlink(backupPath);
-                        }
+        account_sync_file(ctx, "BabyPack", skuId->valuestring, filename->valuestring,
+                          url->valuestring, fileSize->valueint, item);
+    }
+    return true;
+}
 
-                        // Step 1: Rename original to backup (if original exists)
-                        bool had_original = (access(fullName, F_OK) == 0);
-                        if (had_original == false)
-                            create_directories(backupPath);
-                        if (had_original && s3_rename(fullName, backupPath) != 0) {
-                            ESP_LOGE(TAG, "Failed to backup original file %s", fullName);
-                        } else {
-                            // Step 2: Move temp to original place
-                            if (s3_rename(tempDownloadPath, fullName) == 0) {
-                                // Step 3: Success - remove backup
-                                if (had_original) s3_remove(backupPath);
-                                ESP_LOGI(TAG, "Successfully replaced %s (%d bytes)", fullName, download_size);
-                            } else {
-                                // Step 4: Failed - restore original from backup
-                                if (had_original) s3_rename(backupPath, fullName);
-                                ESP_LOGE(TAG, "Failed to replace %s - original restored, downloaded file kept at %s", fullName, tempDownloadPath);
-                            }
-                        }
-                    } else {
-                        ESP_LOGE(TAG, "Downloaded file size mismatch: expected %d, got %d - kept at %s", fileSize->valueint, download_size, downloadPath);
-                    }
-                } else {
-                    ESP_LOGE(TAG, "Download failed for %s", fullName);
+static bool account_parse_alarm(account_parse_ctx_t *ctx, int i, const cJSON *alarm) {
+    if (!account_array_reserve((void **)&gAlarms, &ctx->alarmsCap, i, sizeof(s3_alarm_t)))
+        return false;
+    gAlarmsCount = i + 1;
+    if (!cJSON_IsObject(alarm))
+        return true;
+
+    const cJSON *time = cJSON_GetObjectItem(alarm, "time");
+    const cJSON *period = cJSON_GetObjectItem(alarm, "period");
+    const cJSON *audio = cJSON_GetObjectItem(alarm, "audio");
+    const cJSON *filename = cJSON_GetObjectItem(alarm, "filename");
+    const cJSON *fileSize = cJSON_GetObjectItem(alarm, "fileSize");
+    const cJSON *days = cJSON_GetObjectItem(alarm, "days");
+    if (!(cJSON_IsString(audio) && cJSON_IsString(filename) && cJSON_IsNumber(fileSize) && cJSON_IsArray(days)))
+        return true;
+
+    gAlarms[i].time = strdup_spiram(cJSON_IsString(time) ? time->valuestring : "UNKNOWN");
+    gAlarms[i].period = strdup_spiram(cJSON_IsString(period) ? period->valuestring : "UNKNOWN");
+    gAlarms[i].filename = strdup_spiram(filename->valuestring);
+    for (int d = 0; d < Days_Size; d++) {
+        gAlarms[i].days[d] = 0;
+    }
+    const cJSON *day;
+    cJSON_ArrayForEach(day, days) {
+        if (cJSON_IsString(day)) {
+            for (int d = 0; d < Days_Size; d++) {
+                if (strcmp(day->valuestring, s3_days_array[d]) == 0) {
+                    gAlarms[i].days[d] = 1;
+                    break;
                 }
             }
+            ESP_LOGD(TAG, "Day: %s", day->valuestring);
         }
     }
+    ESP_LOGD(TAG, "  [%d] filename: %s", i, filename->valuestring);
+    ESP_LOGD(TAG, "      url: %s", audio->valuestring);
+    ESP_LOGD(TAG, "      size: %d", fileSize->valueint);
+    if (ctx->justPaserContent)
+        return true;
 
-    if (gWiFi_SYNC_USER_INTERRUPT)
-        goto _FAIL;
-
-    // alarm
-    const cJSON *alarms = cJSON_GetObjectItem(result, "alarms");
-    if (!cJSON_IsArray(alarms)) {
-        ESP_LOGE(TAG, "'alarms' is not an array");
-        goto _FAIL;
-    }
-
-    gAlarmsCount = 0;
-    gAlarmsCount = cJSON_GetArraySize(alarms);
-    ESP_LOGI(TAG, "alarms count: %d", gAlarmsCount);
-    if (gAlarmsCount <= 0) {
-        ESP_LOGE(TAG, "No alarms in JSON");
-    } else {
-        gAlarms = heap_caps_calloc(gAlarmsCount, sizeof(s3_alarm_t), MALLOC_CAP_SPIRAM);
-    }
+    account_sync_file(ctx, "Alarm", "alarms", filename->valuestring,
+                      audio->valuestring, fileSize->valueint, alarm);
+    return true;
+}
 
-    for (int i = 0; i < gAlarmsCount; i++) {
-        cJSON *alarm = cJSON_GetArrayItem(alarms, i);
-        if (!cJSON_IsObject(alarm))
+static bool account_parse_nfc(account_parse_ctx_t *ctx, int i, const cJSON *nfc) {
+    if (!account_array_reserve((void **)&gNfcs, &ctx->nfcCap, i, sizeof(s3_nfc_t)))
+        return false;
+    gNfcCount = i + 1;
+    if (!cJSON_IsObject(nfc))
+        return true;
+
+    const cJSON *sn = cJSON_GetObjectItem(nfc, "sn");
+    const cJSON *linked = cJSON_GetObjectItem(nfc, "linked");
+    const cJSON *skus = cJSON_GetObjectItem(nfc, "skus");
+    if (!(cJSON_IsArray(skus) && cJSON_IsString(sn) && cJSON_IsString(linked)))
+        return true;
+    gNfcs[i].linked = strdup_spiram(linked->valuestring);
+    gNfcs[i].sn = strdup_spiram(sn->valuestring);
+
+    int sku_count = cJSON_GetArraySize(skus);
+    gNfcs[i].skus = heap_caps_calloc(sku_count, sizeof(s3_nfc_skus_t), MALLOC_CAP_SPIRAM);
+    if (!gNfcs[i].skus)
+        return sku_count == 0;
+    gNfcs[i].skusCount = sku_count;
+    // ~~~ get skus ~~~
+    int j = -1;
+    const cJSON *sku;
+    cJSON_ArrayForEach(sku, skus) {
+        j++;
+        if (gWiFi_SYNC_USER_INTERRUPT)
+            return false;
+        if (!cJSON_IsObject(sku))
             continue;
-
-        cJSON *time = cJSON_GetObjectItem(alarm, "time");
-        cJSON *period = cJSON_GetObjectItem(alarm, "period");
-        cJSON *audio = cJSON_GetObjectItem(alarm, "audio");
-        cJSON *filename = cJSON_GetObjectItem(alarm, "filename");
-        cJSON *fileSize = cJSON_GetObjectItem(alarm, "fileSize");
-        cJSON *days = cJSON_GetObjectItem(alarm, "days");
-        if (!(cJSON_IsString(audio) && cJSON_IsString(filename) && cJSON_IsNumber(fileSize) && cJSON_IsArray(days)))
+        const cJSON *skuId = cJSON_GetObjectItem(sku, "skuId");
+        const cJSON *language = cJSON_GetObjectItem(sku, "language");
+        if (!(cJSON_IsString(skuId) && cJSON_IsString(language)))
             continue;
 
-        gAlarms[i].time = strdup_spiram(cJSON_IsString(time) ? time->valuestring : "UNKNOWN");
-        gAlarms[i].period = strdup_spiram(cJSON_IsString(period) ? period->valuestring : "UNKNOWN");
-        gAlarms[i].filename = strdup_spiram(cJSON_IsString(filename) ? filename->valuestring : "UNKNOWN");
-        int day_count = cJSON_GetArraySize(days);
-        for (int d = 0; d < Days_Size; d++) {
-            gAlarms[i].days[d] = 0;
-        }
-        for (int j = 0; j < day_count; j++) {
-            cJSON *day = cJSON_GetArrayItem(days, j);
-            if (cJSON_IsString(day)) {
-                for (int d = 0; d < Days_Size; d++) {
-                    if (strcmp(day->valuestring, s3_days_array[d]) == 0) {
-                        gAlarms[i].days[d] = 1;
-                        break;
-                    }
-                }
-                ESP_LOGD(TAG, "Day %d: %s", j, day->valuestring);
-            }
-        }
-        ESP_LOGD(TAG, "  [%d] filename: %s", i, cJSON_IsString(filename) ? filename->valuestring : "N/A");
-        ESP_LOGD(TAG, "      url: %s", cJSON_IsString(audio) ? audio->valuestring : "N/A");
-        ESP_LOGD(TAG, "      size: %d", cJSON_IsNumber(fileSize) ? fileSize->valueint : -1);
-        if (justPaserContent)
-            continue;
+        // Count the contents array size to get file count, fallback to -1 if not available
+        const cJSON *contents = cJSON_GetObjectItem(sku, "contents");
+        int content_count = cJSON_IsArray(contents) ? cJSON_GetArraySize(contents) : -1;
 
+        ESP_LOGD(TAG, "skuid:%s, language:%s, contentCount:%d", skuId->valuestring, language->valuestring, content_count);
+        s3_nfc_skus_t *nfcSku = &gNfcs[i].skus[j];
+        nfcSku->skuId = strdup_spiram(skuId->valuestring);
+        nfcSku->language = strdup_spiram(language->valuestring);
+        nfcSku->contentCount = content_count;
 
+        const cJSON *expiresAt = cJSON_GetObjectItem(sku, "expiresAt");
+        if (cJSON_IsNumber(expiresAt)) {
+            nfcSku->expiresAt = (unsigned int)expiresAt->valuedouble;
+        } else {
+            nfcSku->expiresAt = 0;
+        }
 
-        memset(path, 0, sizeof(path));
-        memset(fullName, 0, sizeof(fullName));
-        sprintf(path, SDCARD_CONTENT_PATH, "alarms");
-        sprintf(fullName, SDCARD_CONTENT_FULLNAME, "alarms", filename->valuestring);
+        if (!cJSON_IsArray(contents))
+            continue;
+        if (content_count > 0)
+            nfcSku->filenames = heap_caps_calloc(content_count, sizeof(char *), MALLOC_CAP_SPIRAM);
+        const cJSON *content;
+        cJSON_ArrayForEach(content, contents) {
+            if (gWiFi_SYNC_USER_INTERRUPT)
+                return false;
+            if (!cJSON_IsObject(content))
+                continue;
 
-        // ========== DIFFERENTIAL UPDATE LOGIC (Alarms) ==========
-        // Find this file in the new_entries array to determine change type
-        resource_change_type_t change_type = RESOURCE_NEW;
-        content_entry_t *matching_entry = NULL;
+            const cJSON *url = cJSON_GetObjectItem(content, "url");
+            const cJSON *fileSize = cJSON_GetObjectItem(content, "fileSize");
+            const cJSON *filename = cJSON_GetObjectItem(content, "filename");
+            const cJSON *contentId = cJSON_GetObjectItem(content, "contentId");
 
-        if (new_entries && new_count > 0) {
-            for (int k = 0; k < new_count; k++) {
-                if (strcmp(new_entries[k].fullPath, fullName) == 0) {
-                    matching_entry = &new_entries[k];
-                    change_type = compare_content_entry(matching_entry, old_entries, old_count);
-                    break;
-                }
+            // Keep the file list for SKURC playlists
+            if (cJSON_IsString(filename) && nfcSku->filenames) {
+                char *name = strdup_spiram(filename->valuestring);
+                if (name)
+                    nfcSku->filenames[nfcSku->filenameCount++] = name;
             }
-        }
-
-        int size = get_file_size(fullName);
 
-        // Check if file is unchanged and exists with correct size
-        if (change_type == RESOURCE_UNCHANGED && size >= 0 && size == fileSize->valueint) {
-            ESP_LOGI(TAG, "[Alarm UNCHANGED - skipped]: %s (size: %d bytes)", fullName, size);
-            continue;  // Skip downloading this file
-        }
+            if (!(cJSON_IsString(url) && cJSON_IsString(filename) && cJSON_IsNumber(fileSize)))
+                continue;
 
-        // File needs to be downloaded (either MODIFIED or NEW, or UNCHANGED but missing/corrupted)
-        if (change_type == RESOURCE_MODIFIED) {
-            ESP_LOGI(TAG, "[Alarm MODIFIED - download]: %s", fullName);
-        } else if (change_type == RESOURCE_NEW) {
-            ESP_LOGI(TAG, "[Alarm NEW - download]: %s", fullName);
-        }
+            // Add filename-contentId mapping for NFC content
+            if (cJSON_IsString(contentId)) {
+                add_filename_contentid_mapping(filename->valuestring, contentId->valuestring);
+            }
 
-        // Initialize attempt counter for this file
-        int attempt = 1;
-        ESP_LOGI(TAG, "[AudioData n%d - start]: %s", attempt, fullName);
+            if (ctx->justPaserContent)
+                continue;
 
-        if (size >= 0 && size == fileSize->valueint) {
-            ESP_LOGI(TAG, "[AudioData n%d - success]: %s", attempt, fullName);
-        } else {
-            ESP_LOGW(TAG, "[AudioData n%d - fail]: %s, received:%d, expected:%d", attempt, fullName, size, fileSize->valueint);
-            attempt++; // Increment for actual download attempts
-            
-            // Download to tmp/downloads instead of overwriting original
-            char downloadPath[300];
-            const char* filename_only = strrchr(fullName, '/');
-            if (filename_only) filename_only++; else filename_only = fullName;
-            snprintf(downloadPath, sizeof(downloadPath), "/sdcard/tmp/downloads/%s", filename_only);
-            create_directories(downloadPath);
+            ESP_LOGD(TAG, "  [%d] filename: %s", i, filename->valuestring);
+            ESP_LOGD(TAG, "      url: %s", url->valuestring);
+            ESP_LOGD(TAG, "      size: %d", fileSize->valueint);
 
-            // Try download with retry tracking
-            esp_err_t result = ESP_FAIL;
-            while (attempt <= MAX_DOWNLOAD_ATTEMPTS && result != ESP_OK) {
-                ESP_LOGI(TAG, "[AudioData n%d - start]: %s", attempt, downloadPath);
-                result = content_download(audio->valuestring, downloadPath);
-                
-                if (result != ESP_OK) {
-                    ESP_LOGW(TAG, "[AudioData n%d - fail]: download failed", attempt);
-                    attempt++;
-                } else {
-                    ESP_LOGI(TAG, "[AudioData n%d - success]: %s", attempt, downloadPath);
-                }
-            }
-            
-                if (result == ESP_OK) {
-                    // content_download leaves file at downloadPath.tmp, check that file
-                    char tempDownloadPath[320];
-                    snprintf(tempDownloadPath, sizeof(tempDownloadPath), "%s.tmp", downloadPath);
-                    int download_size = get_file_size(tempDownloadPath);
-                    if (download_size == fileSize->valueint) {
-                        // Download successful and size matches - replace original atomically with backup strategy
-                        // Ensure destination directory exists before replacement
-                        create_directories(fullName);
-                        
-                        char backupPath[256];
-                        snprintf(backupPath, sizeof(backupPath), "%s.bak", fullName);
-                        if (access(backupPath, F_OK) == 0) {
-                            unlink(backupPath);
-                        }
-                    
-                    // Step 1: Rename original to backup (if original exists)
-                    bool had_original = (access(fullName, F_OK) == 0);
-                    if (had_original == false)
-                        create_directories(backupPath);
-                    if (had_original && s3_rename(fullName, backupPath) != 0) {
-                        ESP_LOGE(TAG, "Failed to backup original file %s", fullName);
-                    } else {
-                        // Step 2: Move temp to original place
-                        if (s3_rename(tempDownloadPath, fullName) == 0) {
-                            // Step 3: Success - remove backup
-                            if (had_original) s3_remove(backupPath);
-                            ESP_LOGI(TAG, "Successfully replaced %s (%d bytes)", fullName, download_size);
-                        } else {
-                            // Step 4: Failed - restore original from backup
-                            if (had_original) s3_rename(backupPath, fullName);
-                            ESP_LOGE(TAG, "Failed to replace %s - original restored, downloaded file kept at %s", fullName, tempDownloadPath);
-                        }
-                    }
-                } else {
-                    ESP_LOGE(TAG, "Downloaded file size mismatch: expected %d, got %d - kept at %s", fileSize->valueint, download_size, downloadPath);
-                }
-            } else {
-                ESP_LOGE(TAG, "Download failed for %s", fullName);
-            }
+            account_sync_file(ctx, "NFC", skuId->valuestring, filename->valuestring,
+                              url->valuestring, fileSize->valueint, content);
         }
     }
+    return true;
+}
+
+static bool account_stream_cb(const char *path, int index, const cJSON *value, void *arg) {
+    account_parse_ctx_t *ctx = arg;
     if (gWiFi_SYNC_USER_INTERRUPT)
-        goto _FAIL;
+        return false;
 
-    // NFC
-    const cJSON *NFCs = cJSON_GetObjectItem(result, "NFCs");
-    if (!cJSON_IsArray(NFCs)) {
-        ESP_LOGE(TAG, "'NFCs' is not an array");
-        goto _FAIL;
-    }
+    bool ok = true;
+    if (strcmp(path, "result.babyPacks") == 0) {
+        if (index < 0)
+            ctx->has_babyPacks = ctx->has_babyPacks || !value;     // NULL: the array opened
+        else
+            ok = account_parse_baby_pack(ctx, index, value);
+    } else if (strcmp(path, "result.alarms") == 0) {
+        if (index < 0)
+            ctx->has_alarms = ctx->has_alarms || !value;
+        else
+            ok = account_parse_alarm(ctx, index, value);
+    } else if (strcmp(path, "result.NFCs") == 0) {
+        if (index < 0)
+            ctx->has_NFCs = ctx->has_NFCs || !value;
+        else
+            ok = account_parse_nfc(ctx, index, value);
+    } else if (strcmp(path, "result.babyId") == 0 && cJSON_IsString(value)) {
+        strlcpy(s3_babyId, value->valuestring, 32);
+        ESP_LOGI(TAG, "babyId:%s", s3_babyId);
+        ctx->has_babyId = true;
+    } else if (strcmp(path, "result.kidCharacter") == 0 && cJSON_IsString(value)) {
+        strlcpy(s3_WiFiSyncKidIcon, value->valuestring, 8);
+        ESP_LOGI(TAG, "kid:%s", s3_WiFiSyncKidIcon);
+        ctx->has_kid = true;
+    }
+    ctx->failed = ctx->failed || !ok;
+    return ok;
+}
 
-    gNfcCount = 0;
-    gNfcCount = cJSON_GetArraySize(NFCs);
-    ESP_LOGI(TAG, "NFCs count: %d", gNfcCount);
-    if (gNfcCount <= 0) {
-        ESP_LOGE(TAG, "No NFCs in JSON");
-    } else {
-        gNfcs = heap_caps_calloc(gNfcCount, sizeof(s3_nfc_t), MALLOC_CAP_SPIRAM);
+esp_err_t parser_account_contents(int justPaserContent) {
+    ESP_LOGI(TAG, "parser_account_contents justPaser? %d", justPaserContent );
+
+    // Differential update state; declared before the first jump to _FAIL
+    content_entry_t *new_entries = NULL;
+    content_entry_t *old_entries = NULL;
+    int new_count = 0;
+    int old_count = 0;
+    account_hash_t new_index = { .nocase = false };     // fullPath -> new_entries index
+    account_parse_ctx_t ctx = { .justPaserContent = justPaserContent, .new_index = &new_index };
+
+    // Clean up existing data, filename-contentId map and lookup index
+    if (!account_model_lock())
+        return ESP_FAIL;
+    gAccountModelLoaded = false;
+    free_account_index();
+    free_baby_packs();
+    free_alarms();
+    free_NFCs();
+    free_filename_contentid_map();
+
+    if (access("/sdcard/tmp/" CLOUD_ACCOUNT_FILENAME, F_OK) != 0) {
+        account_model_unlock();
+        ESP_LOGE(TAG, "No %s", CLOUD_ACCOUNT_FILENAME);
+        return ESP_FAIL;
     }
+    // Lookups see an empty model until the parse below has indexed it
+    gAccountModelBuilding = true;
+    account_model_unlock();
 
-    for (int i = 0; i < gNfcCount; i++) {
-        cJSON *nfc = cJSON_GetArrayItem(NFCs, i);
-        if (!cJSON_IsObject(nfc))
-            continue;
-        cJSON *sn = cJSON_GetObjectItem(nfc, "sn");
-        cJSON *linked = cJSON_GetObjectItem(nfc, "linked");
-        cJSON *skus = cJSON_GetObjectItem(nfc, "skus");
-        if (!(cJSON_IsArray(skus) && cJSON_IsString(sn) && cJSON_IsString(linked)))
-            continue;
-        gNfcs[i].linked = strdup_spiram(linked->valuestring);
-        gNfcs[i].sn = strdup_spiram(sn->valuestring);
-
-        int sku_count = cJSON_GetArraySize(skus);
-        gNfcs[i].skusCount = sku_count;
-        gNfcs[i].skus = heap_caps_calloc(sku_count, sizeof(s3_nfc_skus_t), MALLOC_CAP_SPIRAM);
-        // ESP_LOGD(TAG, "sn:%s, linked:%s, files: %d", pNFCs[i].sn, pNFCs[i].linked, sku_count);
-        // ~~~ get skus ~~~
-        for (int j = 0; j < sku_count; j++) {
-        	if (gWiFi_SYNC_USER_INTERRUPT)
-        		goto _FAIL;
-            cJSON *sku = cJSON_GetArrayItem(skus, j);
-            if (!cJSON_IsObject(sku))
-                continue;
-            cJSON *skuId = cJSON_GetObjectItem(sku, "skuId");
-            cJSON *language = cJSON_GetObjectItem(sku, "language");
-            if (!(cJSON_IsString(skuId) && cJSON_IsString(language)))
-                continue;
+    // ========== DIFFERENTIAL UPDATE PREPARATION START ==========
 
-            // Count the contents array size to get file count, fallback to -1 if not available
-            cJSON *contents = cJSON_GetObjectItem(sku, "contents");
-            int content_count = cJSON_IsArray(contents) ? cJSON_GetArraySize(contents) : -1;
-            
-            ESP_LOGD(TAG, "skuid:%s, language:%s, contentCount:%d", skuId->valuestring, language->valuestring, content_count);
-            gNfcs[i].skus[j].skuId = strdup_spiram(skuId->valuestring);
-            gNfcs[i].skus[j].language = strdup_spiram(language->valuestring);
-            gNfcs[i].skus[j].contentCount = content_count;
-
-            cJSON *expiresAt = cJSON_GetObjectItem(sku, "expiresAt");
-            if (cJSON_IsNumber(expiresAt)) {
-                gNfcs[i].skus[j].expiresAt = (unsigned int)expiresAt->valuedouble;
-            } else {
-                gNfcs[i].skus[j].expiresAt = 0;
-            }
+    // Skip differential logic if justPaserContent (only parsing metadata)
+    bool has_old_manifest = false;
 
-            if (!cJSON_IsArray(contents))
-                continue;
-            for (int k = 0; k < content_count; k++) {
-            	if (gWiFi_SYNC_USER_INTERRUPT)
-            		goto _FAIL;
-                cJSON *content = cJSON_GetArrayItem(contents, k);
-                if (!cJSON_IsObject(content))
-                    continue;
-
-                cJSON *url = cJSON_GetObjectItem(content, "url");
-                cJSON *fileSize = cJSON_GetObjectItem(content, "fileSize");
-                cJSON *filename = cJSON_GetObjectItem(content, "filename");
-                cJSON *contentId = cJSON_GetObjectItem(content, "contentId");
-
-                if (!(cJSON_IsString(url) && cJSON_IsString(filename) && cJSON_IsNumber(fileSize)))
-                    continue;
-                    
-                // Add filename-contentId mapping for NFC content
-                if (cJSON_IsString(contentId)) {
-                    add_filename_contentid_mapping(filename->valuestring, contentId->valuestring);
-                }
+    if (!justPaserContent) {
+        // Log memory status before parsing to diagnose issues
+        ESP_LOGI(TAG, "Pre-parse memory: Free heap: %u bytes, Free SPIRAM: %u bytes",
+            heap_caps_get_free_size(MALLOC_CAP_8BIT),
+            heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
 
-                if (justPaserContent)
-                	continue;
-
-                ESP_LOGD(TAG, "  [%d] filename: %s", i, cJSON_IsString(filename) ? filename->valuestring : "N/A");
-                ESP_LOGD(TAG, "      url: %s", cJSON_IsString(url) ? url->valuestring : "N/A");
-                ESP_LOGD(TAG, "      size: %d", cJSON_IsNumber(fileSize) ? fileSize->valueint : -1);
-
-                memset(path, 0, sizeof(path));
-                memset(fullName, 0, sizeof(fullName));
-                sprintf(path, SDCARD_CONTENT_PATH, skuId->valuestring);
-                sprintf(fullName, SDCARD_CONTENT_FULLNAME, skuId->valuestring, filename->valuestring);
-
-                // ========== DIFFERENTIAL UPDATE LOGIC (NFCs) ==========
-                // Find this file in the new_entries array to determine change type
-                resource_change_type_t change_type = RESOURCE_NEW;
-                content_entry_t *matching_entry = NULL;
-
-                if (new_entries && new_count > 0) {
-                    for (int m = 0; m < new_count; m++) {
-                        if (strcmp(new_entries[m].fullPath, fullName) == 0) {
-                            matching_entry = &new_entries[m];
-                            change_type = compare_content_entry(matching_entry, old_entries, old_count);
-                            break;
-                        }
-                    }
-                }
+        // Step 1: Parse NEW manifest FIRST (critical - must succeed)
+        new_entries = parse_account_contents_manifest("/sdcard/tmp/" CLOUD_ACCOUNT_FILENAME, &new_count);
+        if (!new_entries) {
+            ESP_LOGW(TAG, "Failed to parse new content manifest - proceeding without differential update");
+        } else {
+            ESP_LOGI(TAG, "Parsed %d entries from new content manifest", new_count);
 
-                int size = get_file_size(fullName);
+            // Log memory after parsing new manifest
+            ESP_LOGI(TAG, "Post-new-manifest memory: Free heap: %u bytes, Free SPIRAM: %u bytes",
+                heap_caps_get_free_size(MALLOC_CAP_8BIT),
+                heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
 
-                // Check if file is unchanged and exists with correct size
-                if (change_type == RESOURCE_UNCHANGED && size >= 0 && size == fileSize->valueint) {
-                    ESP_LOGI(TAG, "[NFC UNCHANGED - skipped]: %s (size: %d bytes)", fullName, size);
-                    continue;  // Skip downloading this file
-                }
+            // Step 2: Check for and parse OLD manifest (optional - for differential comparison)
+            char backup_path[256];
+            snprintf(backup_path, sizeof(backup_path), "/sdcard/tmp/%s.bak", CLOUD_ACCOUNT_FILENAME);
+            has_old_manifest = (access(backup_path, F_OK) == 0);
 
-                // File needs to be downloaded (either MODIFIED or NEW, or UNCHANGED but missing/corrupted)
-                if (change_type == RESOURCE_MODIFIED) {
-                    ESP_LOGI(TAG, "[NFC MODIFIED - download]: %s", fullName);
-                } else if (change_type == RESOURCE_NEW) {
-                    ESP_LOGI(TAG, "[NFC NEW - download]: %s", fullName);
+            if (has_old_manifest) {
+                ESP_LOGI(TAG, "Found old content manifest backup, parsing for differential update");
+                old_entries = parse_account_contents_manifest(backup_path, &old_count);
+                if (old_entries) {
+                    ESP_LOGI(TAG, "Parsed %d entries from old content manifest", old_count);
+                } else {
+                    ESP_LOGW(TAG, "Failed to parse old content manifest, will download all files");
+                    has_old_manifest = false;
                 }
+            } else {
+                ESP_LOGI(TAG, "No old content manifest backup found, will download all files");
+            }
 
-                // Initialize attempt counter for this file
-                int attempt = 1;
-                ESP_LOGI(TAG, "[AudioData n%d - start]: %s", attempt, fullName);
-
-                if (size >= 0 && size == fileSize->valueint) {
-                    ESP_LOGI(TAG, "[AudioData n%d - success]: %s", attempt, fullName);
-                } else {
-                    ESP_LOGW(TAG, "[AudioData n%d - fail]: %s, received:%d, expected:%d", attempt, fullName, size, fileSize->valueint);
-                    attempt++; // Increment for actual download attempts
-                    
-                    // Download to tmp/downloads instead of overwriting original
-                    char downloadPath[300];
-                    const char* filename_only = strrchr(fullName, '/');
-                    if (filename_only) filename_only++; else filename_only = fullName;
-                    snprintf(downloadPath, sizeof(downloadPath), "/sdcard/tmp/downloads/%s", filename_only);
-                    create_directories(downloadPath);
+            // Step 3: Classify every new entry once; the download loops below look it up by path
+            manifest_diff_stats_t diff;
+            int64_t diff_start_us = esp_timer_get_time();
+            diff_content_manifests(new_entries, new_count, old_entries, old_count, &new_index, &diff);
 
-                    
-                    // Try download with retry tracking
-                    esp_err_t result = ESP_FAIL;
-                    while (attempt <= MAX_DOWNLOAD_ATTEMPTS && result != ESP_OK) {
-                        ESP_LOGI(TAG, "[AudioData n%d - start]: %s", attempt, downloadPath);
-                        result = content_download(url->valuestring, downloadPath);
-                        
-                        if (result != ESP_OK) {
-                            ESP_LOGW(TAG, "[AudioData n%d - fail]: download failed", attempt);
-                            attempt++;
-                        } else {
-                            ESP_LOGI(TAG, "[AudioData n%d - success]: %s", attempt, downloadPath);
-                        }
-                    }
-                    
-                    if (result == ESP_OK) {
-                        // content_download leaves file at downloadPath.tmp, check that file
-                        char tempDownloadPath[320];
-                        snprintf(tempDownloadPath, sizeof(tempDownloadPath), "%s.tmp", downloadPath);
-                        int download_size = get_file_size(tempDownloadPath);
-                        if (download_size == fileSize->valueint) {
-                            // Download successful and size matches - replace original atomically with backup strategy
-                            // Ensure destination directory exists before replacement
-                            create_directories(fullName);
-                            
-                            char backupPath[256];
-                            snprintf(backupPath, sizeof(backupPath), "%s.bak", fullName);
-                            if (access(backupPath, F_OK) == 0) {
-                                unlink(backupPath);
-                            }
+            ESP_LOGI(TAG, "========== CONTENT DIFFERENTIAL UPDATE SUMMARY ==========");
+            ESP_LOGI(TAG, "Total files in new manifest: %d", new_count);
+            ESP_LOGI(TAG, "Unchanged files: %d (will skip if exists)", diff.unchanged);
+            ESP_LOGI(TAG, "Modified files: %d (will re-download)", diff.modified);
+            ESP_LOGI(TAG, "New files: %d (will download)", diff.added);
+            ESP_LOGI(TAG, "Removed files: %d (no longer listed)", diff.removed);
+            ESP_LOGI(TAG, "Expected downloads: %d", diff.modified + diff.added);
+            ESP_LOGI(TAG, "Diff computed in %lld ms", (esp_timer_get_time() - diff_start_us) / 1000);
+            ESP_LOGI(TAG, "=========================================================");
 
-                            // Step 1: Rename original to backup (if original exists)
-                            bool had_original = (access(fullName, F_OK) == 0);
-                            if (had_original == false)
-                                create_directories(backupPath);
-                            if (had_original && s3_rename(fullName, backupPath) != 0) {
-                                ESP_LOGE(TAG, "Failed to backup original file %s", fullName);
-                            } else {
-                                // Step 2: Move temp to original place
-                                if (s3_rename(tempDownloadPath, fullName) == 0) {
-                                    // Step 3: Success - remove backup
-                                    if (had_original) s3_remove(backupPath);
-                                    ESP_LOGI(TAG, "Successfully replaced %s (%d bytes)", fullName, download_size);
-                                } else {
-                                    // Step 4: Failed - restore original from backup
-                                    if (had_original) s3_rename(backupPath, fullName);
-                                    ESP_LOGE(TAG, "Failed to replace %s - original restored, downloaded file kept at %s", fullName, tempDownloadPath);
-                                }
-                            }
-                        } else {
-                            ESP_LOGE(TAG, "Downloaded file size mismatch: expected %d, got %d - kept at %s", fileSize->valueint, download_size, downloadPath);
-                        }
-                    } else {
-                        ESP_LOGE(TAG, "Download failed for %s", fullName);
-                    }
-                }
+            // The old manifest is only needed for the diff
+            if (old_entries) {
+                free_content_entries(old_entries, old_count);
+                old_entries = NULL;
+                old_count = 0;
             }
         }
     }
-    if (gWiFi_SYNC_USER_INTERRUPT)
-        goto _FAIL;
 
+    // ========== DIFFERENTIAL UPDATE PREPARATION END ==========
 
-    cJSON_Delete(root);
-    free(buf);
-    buf = NULL;
+    // Content files are fetched in parallel by the pool while the parser keeps walking the manifest
+    if (!justPaserContent && s3_download_pool_start(CONFIG_CONTENT_DOWNLOAD_WORKERS) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start download pool");
+        goto _FAIL;
+    }
 
-    // Log filename-contentId mapping statistics
+    // Baby packs, alarms and NFCs are read one at a time, so memory does not grow with the account
+    ctx.new_entries = new_entries;
+    int64_t parse_start_us = esp_timer_get_time();
+    size_t spiram_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    account_model_lock();
+    esp_err_t parse_err = s3_json_stream_file("/sdcard/tmp/" CLOUD_ACCOUNT_FILENAME, ACCOUNT_SPLIT_PATHS,
+                                              ACCOUNT_SPLIT_PATH_COUNT, account_stream_cb, &ctx);
+    // Index whatever was parsed, even on failure, so lookups match the arrays
     ESP_LOGI(TAG, "Built filename-contentId mapping with %d entries", gFilenameContentIdMapCount);
+    build_account_index();
+    gAccountModelBuilding = false;
+    account_model_unlock();
+    if (gWiFi_SYNC_USER_INTERRUPT)
+        goto _FAIL;
+    if (parse_err != ESP_OK || ctx.failed) {
+        ESP_LOGE(TAG, "Failed to parse JSON");
+        goto _FAIL;
+    }
+    if (!ctx.has_babyId) {
+        ESP_LOGE(TAG, "'babyId' is not an string");
+        goto _FAIL;
+    }
+    if (!ctx.has_kid) {
+        ESP_LOGE(TAG, "'kid' is not an string");
+        goto _FAIL;
+    }
+    if (!ctx.has_babyPacks) {
+        ESP_LOGE(TAG, "'babyPacks' is not an array");
+        goto _FAIL;
+    }
+    if (!ctx.has_alarms) {
+        ESP_LOGE(TAG, "'alarms' is not an array");
+        goto _FAIL;
+    }
+    if (!ctx.has_NFCs) {
+        ESP_LOGE(TAG, "'NFCs' is not an array");
+        goto _FAIL;
+    }
+    ESP_LOGI(TAG, "babyPacks count: %d, alarms count: %d, NFCs count: %d", gBabyPackCount, gAlarmsCount, gNfcCount);
+    if (gBabyPackCount <= 0)
+        ESP_LOGE(TAG, "No babyPacks in JSON");
+    if (gAlarmsCount <= 0)
+        ESP_LOGE(TAG, "No alarms in JSON");
+    if (gNfcCount <= 0)
+        ESP_LOGE(TAG, "No NFCs in JSON");
+    ESP_LOGI(TAG, "Account parsed in %lld ms, SPIRAM free %u -> %u bytes",
+             (esp_timer_get_time() - parse_start_us) / 1000, (unsigned int)spiram_before,
+             (unsigned int)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    account_model_lock();
+    gAccountModelLoaded = true;
+    account_model_unlock();
+
+    // Every queued file is installed (or has failed) once the pool is idle
+    bool sync_complete = false;
+    if (!justPaserContent) {
+        esp_err_t pool_result = s3_download_pool_wait();
+        s3_download_pool_stop();
+        if (gWiFi_SYNC_USER_INTERRUPT)
+            goto _FAIL;
+        if (pool_result != ESP_OK || ctx.queue_failed)
+            ESP_LOGW(TAG, "Some content files were not installed, the next sync retries them");
+        // Every wanted file is installed, so partials still journaled belong to removed content
+        if (pool_result == ESP_OK && !ctx.queue_failed) {
+            s3_dl_journal_prune("/sdcard/tmp/downloads");
+            sync_complete = true;
+        }
+        // Native images of sources removed or replaced since they were converted
+        lvgl_native_img_prune();
+    }
 
     // ========== DIFFERENTIAL UPDATE CLEANUP AND FINAL STATISTICS ==========
-    // Note: new_entries and old_entries are initialized to NULL and only assigned in !justPaserContent block
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    account_hash_clear(&new_index);
     if (new_entries) {
         ESP_LOGI(TAG, "========== DIFFERENTIAL UPDATE FINAL RESULTS ==========");
         ESP_LOGI(TAG, "Differential update completed successfully");
@@ -1394,7 +1557,15 @@ esp_err_t parser_account_contents(int justPaserContent) {
         free_content_entries(old_entries, old_count);
         old_entries = NULL;
     }
-#pragma GCC diagnostic pop
+
+    // Album folders changed file by file above: persist the content index once
+    if (!justPaserContent) {
+        s3_content_index_flush();
+    }
+    // Later syncs may skip an unchanged manifest only once nothing in it is left to download
+    if (sync_complete) {
+        s3_cloud_account_manifest_synced();
+    }
 
     // Log memory after cleanup
     if (!justPaserContent) {
@@ -1406,10 +1577,11 @@ esp_err_t parser_account_contents(int justPaserContent) {
     return ESP_OK;
 
 _FAIL:
+    // Abort outstanding downloads before the manifest they reference is freed
+    s3_download_pool_stop();
+
     // Cleanup differential update resources on failure
-    // Note: new_entries and old_entries are initialized to NULL and only assigned in !justPaserContent block
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    account_hash_clear(&new_index);
     if (new_entries) {
         free_content_entries(new_entries, new_count);
         new_entries = NULL;
@@ -1418,28 +1590,64 @@ _FAIL:
         free_content_entries(old_entries, old_count);
         old_entries = NULL;
     }
-#pragma GCC diagnostic pop
 
-    cJSON_Delete(root);
-    free(buf);
-    buf = NULL;
+    // The pool may have failed to start before the parse cleared this
+    account_model_lock();
+    gAccountModelBuilding = false;
+    account_model_unlock();
     return ESP_FAIL;
 
 }
 
+bool account_contents_present(void) {
+    int count = 0;
+    content_entry_t *entries = parse_account_contents_manifest("/sdcard/tmp/" CLOUD_ACCOUNT_FILENAME, &count);
+    if (!entries) {
+        s3_cloud_account_manifest_invalidate();
+        return false;
+    }
+
+    int missing = 0;
+    for (int i = 0; i < count; i++) {
+        int size = get_file_size(entries[i].fullPath);
+        if (size != entries[i].size) {
+            if (missing++ < 8)
+                ESP_LOGW(TAG, "Missing or incomplete: %s (%d of %d bytes)", entries[i].fullPath, size, entries[i].size);
+        }
+    }
+    free_content_entries(entries, count);
+
+    if (missing > 0) {
+        ESP_LOGW(TAG, "%d of %d account files missing or incomplete, manifest needs a full sync", missing, count);
+        s3_cloud_account_manifest_invalidate();
+        return false;
+    }
+    ESP_LOGI(TAG, "All %d account files present", count);
+    return true;
+}
+
 void get_babyPacks(const s3_babyPack_t **babyPack, int *count) {
+    account_model_lock();
+    account_model_ensure_loaded();
     *babyPack = gBabyPack;
     *count = gBabyPackCount;
+    account_model_unlock();
 }
 
 void get_alarms(const s3_alarm_t **alarm, int *count) {
+    account_model_lock();
+    account_model_ensure_loaded();
     *alarm = gAlarms;
     *count = gAlarmsCount;
+    account_model_unlock();
 }
 
 void get_nfcs(const s3_nfc_t **nfc, int *count) {
+    account_model_lock();
+    account_model_ensure_loaded();
     *nfc = gNfcs;
     *count = gNfcCount;
+    account_model_unlock();
 }
 
 /**
@@ -1453,11 +1661,15 @@ void get_nfcs(const s3_nfc_t **nfc, int *count) {
  * @return HAS_NFC_ENABLED if at least one normal NFC exists, HAS_NFC_DISABLED otherwise
  */
 int haveNFC(void){
+    if (!account_model_lock())
+        return HAS_NFC_DISABLED;
     ESP_LOGI(TAG, "[haveNFC] Total NFC count: %d", gNfcCount);
     
+    int result = HAS_NFC_DISABLED;
     if (gNfcCount == 0) {
         ESP_LOGI(TAG, "[haveNFC] No NFCs at all - returning DISABLED");
-        return HAS_NFC_DISABLED;
+        account_model_unlock();
+        return result;
     }
     
     // Check if at least one NFC is a NORMAL NFC (empty linked field)
@@ -1471,13 +1683,16 @@ int haveNFC(void){
         
         if (is_normal) {
             ESP_LOGI(TAG, "[haveNFC] Found NORMAL NFC at index %d (empty linked) - ENABLED", i);
-            return HAS_NFC_ENABLED;
+            result = HAS_NFC_ENABLED;
+            break;
         }
     }
     
     // Only blankee NFCs found (all have UUID in linked field)
-    ESP_LOGI(TAG, "[haveNFC] Checked all %d NFCs - only BLANKEE NFCs found - DISABLED", gNfcCount);
-    return HAS_NFC_DISABLED;
+    if (result == HAS_NFC_DISABLED)
+        ESP_LOGI(TAG, "[haveNFC] Checked all %d NFCs - only BLANKEE NFCs found - DISABLED", gNfcCount);
+    account_model_unlock();
+    return result;
 }
 
 // FW content sync (skip mp3)
@@ -1523,59 +1738,81 @@ typedef struct {
     char *path;        // File path (e.g., "GraphicData/icon.jpg")
     char *url;         // Download URL
     int size;          // File size in bytes
+    resource_change_type_t change;  // Against the old manifest, set by diff_resource_manifests()
 } resource_entry_t;
 
+static void free_resource_entries(resource_entry_t *entries, int count);
+
+// Growable entry list filled by the manifest stream callbacks
+typedef struct {
+    void *entries;
+    int count;
+    int cap;
+    bool failed;
+} manifest_list_t;
+
+// Slot for one more entry (zeroed), or NULL if the list cannot grow
+static void *manifest_list_add(manifest_list_t *list, size_t entry_size) {
+    if (list->count == list->cap) {
+        int new_cap = list->cap ? list->cap * 2 : 64;
+        void *grown = heap_caps_realloc(list->entries, new_cap * entry_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!grown) {
+            ESP_LOGE(TAG, "Failed to grow manifest list to %d entries", new_cap);
+            list->failed = true;
+            return NULL;
+        }
+        list->entries = grown;
+        list->cap = new_cap;
+    }
+    void *entry = (char *)list->entries + list->count++ * entry_size;
+    memset(entry, 0, entry_size);
+    return entry;
+}
+
+// resource.json is an array of single-member objects: [{"GraphicData/icon.jpg": {"url": ..., "size": ...}}, ...]
+static bool resource_manifest_cb(const char *path, int index, const cJSON *item, void *arg) {
+    manifest_list_t *list = arg;
+    if (!item || !cJSON_IsObject(item))
+        return true;
+
+    const cJSON *entry = item->child;
+    if (!entry || !entry->string || !cJSON_IsObject(entry))
+        return true;
+
+    const cJSON *url = cJSON_GetObjectItem(entry, "url");
+    const cJSON *size = cJSON_GetObjectItem(entry, "size");
+    if (!(cJSON_IsString(url) && cJSON_IsNumber(size)))
+        return true;
+
+    resource_entry_t *res = manifest_list_add(list, sizeof(resource_entry_t));
+    if (!res)
+        return false;
+    res->path = strdup_spiram(entry->string);
+    res->url = strdup_spiram(url->valuestring);
+    res->size = size->valueint;
+    return true;
+}
+
 // Parse resource.json into array of entries
 static resource_entry_t* parse_resource_manifest(const char *json_path, int *out_count) {
     *out_count = 0;
 
-    char *buf = read_file_to_spiram((char*)json_path);
-    if (buf == NULL) {
-        ESP_LOGW(TAG, "Failed to read resource manifest: %s", json_path);
-        return NULL;
-    }
-
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL || !cJSON_IsArray(root)) {
+    static const char *const split_paths[] = { "" };
+    manifest_list_t list = { 0 };
+    esp_err_t err = s3_json_stream_file(json_path, split_paths, 1, resource_manifest_cb, &list);
+    if (err != ESP_OK || list.failed) {
         ESP_LOGE(TAG, "Failed to parse resource JSON: %s", json_path);
-        free(buf);
+        free_resource_entries(list.entries, list.count);
         return NULL;
     }
-
-    int count = cJSON_GetArraySize(root);
-    resource_entry_t *entries = heap_caps_calloc(count, sizeof(resource_entry_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (!entries) {
-        ESP_LOGE(TAG, "Failed to allocate memory for resource entries");
-        cJSON_Delete(root);
-        free(buf);
+    if (list.count == 0) {
+        free(list.entries);
         return NULL;
     }
 
-    int entry_idx = 0;
-    for (int i = 0; i < count; i++) {
-        cJSON *item = cJSON_GetArrayItem(root, i);
-        if (!cJSON_IsObject(item)) continue;
-
-        cJSON *entry = item->child;
-        if (!entry || !entry->string || !cJSON_IsObject(entry)) continue;
-
-        cJSON *url = cJSON_GetObjectItem(entry, "url");
-        cJSON *size = cJSON_GetObjectItem(entry, "size");
-
-        if (cJSON_IsString(url) && cJSON_IsNumber(size)) {
-            entries[entry_idx].path = strdup_spiram(entry->string);
-            entries[entry_idx].url = strdup_spiram(url->valuestring);
-            entries[entry_idx].size = size->valueint;
-            entry_idx++;
-        }
-    }
-
-    *out_count = entry_idx;
-    cJSON_Delete(root);
-    free(buf);
-
-    ESP_LOGI(TAG, "Parsed %d resource entries from %s", entry_idx, json_path);
-    return entries;
+    *out_count = list.count;
+    ESP_LOGI(TAG, "Parsed %d resource entries from %s", list.count, json_path);
+    return list.entries;
 }
 
 // Free resource entries array
@@ -1588,233 +1825,136 @@ static void free_resource_entries(resource_entry_t *entries, int count) {
     free(entries);
 }
 
-// Compare new resource entry against old manifest
-static resource_change_type_t compare_resource_entry(
-    const resource_entry_t *new_entry,
-    const resource_entry_t *old_entries,
-    int old_count
-) {
-    if (!old_entries || old_count == 0) {
-        return RESOURCE_NEW; // No old manifest, everything is new
-    }
-
-    // Search for matching path in old manifest
-    for (int i = 0; i < old_count; i++) {
-        if (strcmp(new_entry->path, old_entries[i].path) == 0) {
-            // Path matches - check if content changed
-            if (new_entry->size == old_entries[i].size &&
-                strcmp(new_entry->url, old_entries[i].url) == 0) {
-                return RESOURCE_UNCHANGED;
-            }
-            return RESOURCE_MODIFIED;
-        }
-    }
-    return RESOURCE_NEW; // Not found in old manifest
-}
-
-// ========== CONTENT MANIFEST HELPER FUNCTIONS (for account_file.json differential updates) ==========
-
-// Parse account_file.json into array of content entries
-static content_entry_t* parse_account_contents_manifest(const char *json_path, int *out_count) {
-    *out_count = 0;
-
-    char *buf = read_file_to_spiram((char*)json_path);
-    if (buf == NULL) {
-        ESP_LOGW(TAG, "Failed to read content manifest: %s", json_path);
-        return NULL;
-    }
-
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to parse content manifest JSON: %s", json_path);
-        free(buf);
-        return NULL;
-    }
+/**
+ * @brief Classify each new resource entry against the old manifest in linear time
+ *
+ * Sets new_entries[i].change; size and URL must both match for UNCHANGED, and a path listed
+ * twice shares its first result. Without an index everything is RESOURCE_NEW.
+ */
+static void diff_resource_manifests(resource_entry_t *new_entries, int new_count,
+                                    const resource_entry_t *old_entries, int old_count) {
+    account_hash_t old_index = { .nocase = false };
+    account_hash_t new_index = { .nocase = false };
+    bool indexed = true;
 
-    const cJSON *result = cJSON_GetObjectItem(root, "result");
-    if (!cJSON_IsObject(result)) {
-        ESP_LOGE(TAG, "No 'result' object in content manifest");
-        cJSON_Delete(root);
-        free(buf);
-        return NULL;
+    for (int i = 0; i < old_count && indexed; i++) {
+        const char *key = old_entries[i].path;
+        if (key && account_hash_get(&old_index, key) < 0)
+            indexed = account_hash_put(&old_index, key, i);
     }
 
-    // Pre-count total entries across all three loops
-    int total_count = 0;
-
-    // Count babyPacks contents
-    const cJSON *babyPacks = cJSON_GetObjectItem(result, "babyPacks");
-    if (cJSON_IsArray(babyPacks)) {
-        int pack_count = cJSON_GetArraySize(babyPacks);
-        for (int i = 0; i < pack_count; i++) {
-            cJSON *pack = cJSON_GetArrayItem(babyPacks, i);
-            if (cJSON_IsObject(pack)) {
-                cJSON *contents = cJSON_GetObjectItem(pack, "contents");
-                if (cJSON_IsArray(contents)) {
-                    total_count += cJSON_GetArraySize(contents);
-                }
-            }
+    for (int i = 0; i < new_count; i++) {
+        resource_entry_t *entry = &new_entries[i];
+        entry->change = RESOURCE_NEW;
+        if (!entry->path || !indexed)
+            continue;
+        int first = account_hash_get(&new_index, entry->path);
+        if (first >= 0) {
+            entry->change = new_entries[first].change;
+            continue;
         }
-    }
-
-    // Count alarms
-    const cJSON *alarms = cJSON_GetObjectItem(result, "alarms");
-    if (cJSON_IsArray(alarms)) {
-        total_count += cJSON_GetArraySize(alarms);
-    }
-
-    // Count NFCs contents
-    const cJSON *NFCs = cJSON_GetObjectItem(result, "NFCs");
-    if (cJSON_IsArray(NFCs)) {
-        int nfc_count = cJSON_GetArraySize(NFCs);
-        for (int i = 0; i < nfc_count; i++) {
-            cJSON *nfc = cJSON_GetArrayItem(NFCs, i);
-            if (cJSON_IsObject(nfc)) {
-                cJSON *skus = cJSON_GetObjectItem(nfc, "skus");
-                if (cJSON_IsArray(skus)) {
-                    int sku_count = cJSON_GetArraySize(skus);
-                    for (int j = 0; j < sku_count; j++) {
-                        cJSON *sku = cJSON_GetArrayItem(skus, j);
-                        if (cJSON_IsObject(sku)) {
-                            cJSON *contents = cJSON_GetObjectItem(sku, "contents");
-                            if (cJSON_IsArray(contents)) {
-                                total_count += cJSON_GetArraySize(contents);
-                            }
-                        }
-                    }
-                }
-            }
+        if (!account_hash_put(&new_index, entry->path, i)) {
+            indexed = false;
+            continue;
+        }
+        int old_idx = account_hash_get(&old_index, entry->path);
+        if (old_idx >= 0) {
+            const resource_entry_t *old = &old_entries[old_idx];
+            entry->change = (old->size == entry->size && old->url && entry->url && strcmp(old->url, entry->url) == 0)
+                                ? RESOURCE_UNCHANGED : RESOURCE_MODIFIED;
         }
     }
 
-    if (total_count == 0) {
-        ESP_LOGW(TAG, "No content entries found in manifest");
-        cJSON_Delete(root);
-        free(buf);
-        return NULL;
-    }
-
-    // Allocate array for all entries
-    content_entry_t *entries = heap_caps_calloc(total_count, sizeof(content_entry_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (!entries) {
-        ESP_LOGE(TAG, "Failed to allocate memory for content entries");
-        cJSON_Delete(root);
-        free(buf);
-        return NULL;
+    if (!indexed) {
+        ESP_LOGW(TAG, "Resource diff index unavailable, treating all entries as new");
+        for (int i = 0; i < new_count; i++)
+            new_entries[i].change = RESOURCE_NEW;
     }
+    account_hash_clear(&old_index);
+    account_hash_clear(&new_index);
+}
 
-    int entry_idx = 0;
-
-    // Parse babyPacks contents
-    if (cJSON_IsArray(babyPacks)) {
-        int pack_count = cJSON_GetArraySize(babyPacks);
-        for (int i = 0; i < pack_count; i++) {
-            cJSON *pack = cJSON_GetArrayItem(babyPacks, i);
-            if (!cJSON_IsObject(pack)) continue;
-
-            cJSON *skuId = cJSON_GetObjectItem(pack, "skuId");
-            cJSON *contents = cJSON_GetObjectItem(pack, "contents");
-            if (!cJSON_IsArray(contents) || !cJSON_IsString(skuId)) continue;
-
-            int content_count = cJSON_GetArraySize(contents);
-            for (int j = 0; j < content_count; j++) {
-                cJSON *item = cJSON_GetArrayItem(contents, j);
-                if (!cJSON_IsObject(item)) continue;
-
-                cJSON *url = cJSON_GetObjectItem(item, "url");
-                cJSON *fileSize = cJSON_GetObjectItem(item, "fileSize");
-                cJSON *filename = cJSON_GetObjectItem(item, "filename");
+// ========== CONTENT MANIFEST HELPER FUNCTIONS (for account_file.json differential updates) ==========
 
-                if (cJSON_IsString(filename) && cJSON_IsString(url) && cJSON_IsNumber(fileSize)) {
-                    char fullPath[256];
-                    snprintf(fullPath, sizeof(fullPath), SDCARD_CONTENT_FULLNAME,
-                            skuId->valuestring, filename->valuestring);
+static bool manifest_add_content(manifest_list_t *list, const char *folder, const cJSON *item,
+                                 const char *url_key, const char *content_type) {
+    const cJSON *url = cJSON_GetObjectItem(item, url_key);
+    const cJSON *fileSize = cJSON_GetObjectItem(item, "fileSize");
+    const cJSON *filename = cJSON_GetObjectItem(item, "filename");
+    if (!(cJSON_IsString(filename) && cJSON_IsString(url) && cJSON_IsNumber(fileSize)))
+        return true;
+
+    content_entry_t *entry = manifest_list_add(list, sizeof(content_entry_t));
+    if (!entry)
+        return false;
+    char fullPath[256];
+    snprintf(fullPath, sizeof(fullPath), SDCARD_CONTENT_FULLNAME, folder, filename->valuestring);
+    entry->fullPath = strdup_spiram(fullPath);
+    entry->url = strdup_spiram(url->valuestring);
+    entry->size = fileSize->valueint;
+    entry->contentType = strdup_spiram(content_type);
+    return true;
+}
 
-                    entries[entry_idx].fullPath = strdup_spiram(fullPath);
-                    entries[entry_idx].url = strdup_spiram(url->valuestring);
-                    entries[entry_idx].size = fileSize->valueint;
-                    entries[entry_idx].contentType = strdup_spiram("babypack");
-                    entry_idx++;
-                }
+// One baby pack, alarm or NFC of account_file.json at a time
+static bool account_manifest_cb(const char *path, int index, const cJSON *item, void *arg) {
+    manifest_list_t *list = arg;
+    if (index < 0 || !cJSON_IsObject(item))
+        return true;
+
+    if (strcmp(path, "result.babyPacks") == 0) {
+        const cJSON *skuId = cJSON_GetObjectItem(item, "skuId");
+        const cJSON *contents = cJSON_GetObjectItem(item, "contents");
+        if (!cJSON_IsArray(contents) || !cJSON_IsString(skuId))
+            return true;
+        const cJSON *content;
+        cJSON_ArrayForEach(content, contents) {
+            if (cJSON_IsObject(content) && !manifest_add_content(list, skuId->valuestring, content, "url", "babypack"))
+                return false;
+        }
+    } else if (strcmp(path, "result.alarms") == 0) {
+        return manifest_add_content(list, "alarms", item, "audio", "alarm");
+    } else if (strcmp(path, "result.NFCs") == 0) {
+        const cJSON *skus = cJSON_GetObjectItem(item, "skus");
+        const cJSON *sku;
+        cJSON_ArrayForEach(sku, skus) {
+            if (!cJSON_IsObject(sku))
+                continue;
+            const cJSON *skuId = cJSON_GetObjectItem(sku, "skuId");
+            const cJSON *contents = cJSON_GetObjectItem(sku, "contents");
+            if (!cJSON_IsArray(contents) || !cJSON_IsString(skuId))
+                continue;
+            const cJSON *content;
+            cJSON_ArrayForEach(content, contents) {
+                if (cJSON_IsObject(content) && !manifest_add_content(list, skuId->valuestring, content, "url", "nfc"))
+                    return false;
             }
         }
     }
+    return true;
+}
 
-    // Parse alarms
-    if (cJSON_IsArray(alarms)) {
-        int alarm_count = cJSON_GetArraySize(alarms);
-        for (int i = 0; i < alarm_count; i++) {
-            cJSON *alarm = cJSON_GetArrayItem(alarms, i);
-            if (!cJSON_IsObject(alarm)) continue;
-
-            cJSON *audio = cJSON_GetObjectItem(alarm, "audio");
-            cJSON *filename = cJSON_GetObjectItem(alarm, "filename");
-            cJSON *fileSize = cJSON_GetObjectItem(alarm, "fileSize");
-
-            if (cJSON_IsString(audio) && cJSON_IsString(filename) && cJSON_IsNumber(fileSize)) {
-                char fullPath[256];
-                snprintf(fullPath, sizeof(fullPath), SDCARD_CONTENT_FULLNAME,
-                        "alarms", filename->valuestring);
+// Parse account_file.json into array of content entries
+static content_entry_t* parse_account_contents_manifest(const char *json_path, int *out_count) {
+    *out_count = 0;
 
-                entries[entry_idx].fullPath = strdup_spiram(fullPath);
-                entries[entry_idx].url = strdup_spiram(audio->valuestring);
-                entries[entry_idx].size = fileSize->valueint;
-                entries[entry_idx].contentType = strdup_spiram("alarm");
-                entry_idx++;
-            }
-        }
+    manifest_list_t list = { 0 };
+    esp_err_t err = s3_json_stream_file(json_path, ACCOUNT_SPLIT_PATHS, ACCOUNT_SPLIT_PATH_COUNT,
+                                        account_manifest_cb, &list);
+    if (err != ESP_OK || list.failed) {
+        ESP_LOGE(TAG, "Failed to parse content manifest JSON: %s", json_path);
+        free_content_entries(list.entries, list.count);
+        return NULL;
     }
-
-    // Parse NFCs contents
-    if (cJSON_IsArray(NFCs)) {
-        int nfc_count = cJSON_GetArraySize(NFCs);
-        for (int i = 0; i < nfc_count; i++) {
-            cJSON *nfc = cJSON_GetArrayItem(NFCs, i);
-            if (!cJSON_IsObject(nfc)) continue;
-
-            cJSON *skus = cJSON_GetObjectItem(nfc, "skus");
-            if (!cJSON_IsArray(skus)) continue;
-
-            int sku_count = cJSON_GetArraySize(skus);
-            for (int j = 0; j < sku_count; j++) {
-                cJSON *sku = cJSON_GetArrayItem(skus, j);
-                if (!cJSON_IsObject(sku)) continue;
-
-                cJSON *skuId = cJSON_GetObjectItem(sku, "skuId");
-                cJSON *contents = cJSON_GetObjectItem(sku, "contents");
-                if (!cJSON_IsArray(contents) || !cJSON_IsString(skuId)) continue;
-
-                int content_count = cJSON_GetArraySize(contents);
-                for (int k = 0; k < content_count; k++) {
-                    cJSON *content = cJSON_GetArrayItem(contents, k);
-                    if (!cJSON_IsObject(content)) continue;
-
-                    cJSON *url = cJSON_GetObjectItem(content, "url");
-                    cJSON *fileSize = cJSON_GetObjectItem(content, "fileSize");
-                    cJSON *filename = cJSON_GetObjectItem(content, "filename");
-
-                    if (cJSON_IsString(url) && cJSON_IsString(filename) && cJSON_IsNumber(fileSize)) {
-                        char fullPath[256];
-                        snprintf(fullPath, sizeof(fullPath), SDCARD_CONTENT_FULLNAME,
-                                skuId->valuestring, filename->valuestring);
-
-                        entries[entry_idx].fullPath = strdup_spiram(fullPath);
-                        entries[entry_idx].url = strdup_spiram(url->valuestring);
-                        entries[entry_idx].size = fileSize->valueint;
-                        entries[entry_idx].contentType = strdup_spiram("nfc");
-                        entry_idx++;
-                    }
-                }
-            }
-        }
+    if (list.count == 0) {
+        ESP_LOGW(TAG, "No content entries found in manifest");
+        free(list.entries);
+        return NULL;
     }
 
-    *out_count = entry_idx;
-    cJSON_Delete(root);
-    free(buf);
-
-    ESP_LOGI(TAG, "Parsed %d content entries from %s", entry_idx, json_path);
-    return entries;
+    *out_count = list.count;
+    ESP_LOGI(TAG, "Parsed %d content entries from %s", list.count, json_path);
+    return list.entries;
 }
 
 // Free content entries array
@@ -1828,27 +1968,71 @@ static void free_content_entries(content_entry_t *entries, int count) {
     free(entries);
 }
 
-// Compare new content entry against old manifest
-static resource_change_type_t compare_content_entry(
-    const content_entry_t *new_entry,
-    const content_entry_t *old_entries,
-    int old_count
-) {
-    if (!old_entries || old_count == 0) {
-        return RESOURCE_NEW; // No old manifest, everything is new
+/**
+ * @brief Classify each new entry against the old manifest in linear time
+ *
+ * Sets new_entries[i].change and fills new_index (fullPath -> first entry with that path).
+ * Size decides MODIFIED, as URLs change with every signed link. If an index cannot be
+ * allocated, entries fall back to RESOURCE_NEW, which still skips files already on the card.
+ */
+static void diff_content_manifests(content_entry_t *new_entries, int new_count,
+                                   const content_entry_t *old_entries, int old_count,
+                                   account_hash_t *new_index, manifest_diff_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    account_hash_t old_index = { .nocase = false };
+    bool indexed = true;
+
+    for (int i = 0; i < old_count && indexed; i++) {
+        const char *key = old_entries[i].fullPath;
+        if (key && account_hash_get(&old_index, key) < 0)
+            indexed = account_hash_put(&old_index, key, i);
+    }
+
+    for (int i = 0; i < new_count; i++) {
+        content_entry_t *entry = &new_entries[i];
+        entry->change = RESOURCE_NEW;
+        if (!entry->fullPath || !indexed)
+            continue;
+        // The same file listed again (baby pack and NFC of one SKU) shares its first result
+        int first = account_hash_get(new_index, entry->fullPath);
+        if (first >= 0) {
+            entry->change = new_entries[first].change;
+            continue;
+        }
+        if (!account_hash_put(new_index, entry->fullPath, i)) {
+            indexed = false;
+            continue;
+        }
+
+        int old_idx = account_hash_get(&old_index, entry->fullPath);
+        if (old_idx < 0) {
+            stats->added++;
+        } else if (old_entries[old_idx].size == entry->size) {
+            entry->change = RESOURCE_UNCHANGED;
+            stats->unchanged++;
+        } else {
+            entry->change = RESOURCE_MODIFIED;
+            stats->modified++;
+        }
     }
 
-    // Search for matching fullPath in old manifest
-    for (int i = 0; i < old_count; i++) {
-        if (strcmp(new_entry->fullPath, old_entries[i].fullPath) == 0) {
-            // Path matches - check if content changed (size only, URLs can change with tokens)
-            if (new_entry->size == old_entries[i].size) {
-                return RESOURCE_UNCHANGED;
+    if (!indexed) {
+        ESP_LOGW(TAG, "Manifest diff index unavailable, treating all entries as new");
+        account_hash_clear(new_index);
+        for (int i = 0; i < new_count; i++)
+            new_entries[i].change = RESOURCE_NEW;
+        memset(stats, 0, sizeof(*stats));
+        stats->added = new_count;
+    } else {
+        for (int i = 0; i < old_count; i++) {
+            const char *key = old_entries[i].fullPath;
+            if (key && account_hash_get(&old_index, key) == i && account_hash_get(new_index, key) < 0) {
+                stats->removed++;
+                ESP_LOGD(TAG, "No longer listed: %s", key);
             }
-            return RESOURCE_MODIFIED;
         }
     }
-    return RESOURCE_NEW; // Not found in old manifest
+    account_hash_clear(&old_index);
 }
 
 esp_err_t sync_resource_without_mp3(char *url,int cnt) {
@@ -1929,7 +2113,9 @@ esp_err_t sync_resource_without_mp3(char *url,int cnt) {
         ESP_LOGI(TAG, "No old manifest backup found, will download all files");
     }
 
-    // Step 2.3: Compare manifests and count changes
+    // Step 2.3: Classify every entry once, then count changes
+    diff_resource_manifests(new_entries, new_count, old_entries, old_count);
+
     int unchanged_count = 0;
     int modified_count = 0;
     int new_file_count = 0;
@@ -1949,10 +2135,7 @@ esp_err_t sync_resource_without_mp3(char *url,int cnt) {
             continue;
         }
 
-        // Compare with old manifest
-        resource_change_type_t change_type = compare_resource_entry(entry, old_entries, old_count);
-
-        switch (change_type) {
+        switch (entry->change) {
             case RESOURCE_UNCHANGED:
                 unchanged_count++;
                 break;
@@ -1993,147 +2176,116 @@ esp_err_t sync_resource_without_mp3(char *url,int cnt) {
 
     // ========== DIFFERENTIAL UPDATE IMPLEMENTATION END ==========
 
-    char *buf = read_file_to_spiram("/sdcard/resource.json");
-    ret = ESP_FAIL;
-    if (buf == NULL) {
-        free_resource_entries(new_entries, new_count);
-        if (old_entries) free_resource_entries(old_entries, old_count);
-        return ret;
-    }
-
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL || !cJSON_IsArray(root)) {
-        ESP_LOGE(TAG, "Failed to parse JSON");
-        free(buf);
-        free_resource_entries(new_entries, new_count);
-        if (old_entries) free_resource_entries(old_entries, old_count);
-        return ret;
-    }
-    int count = cJSON_GetArraySize(root);
-    ESP_LOGI(TAG, "count is %d", count);
+    // The entries parsed for the diff carry everything the download loop needs
     int tmp_count = 0;
     int _count = 0;
     int actually_downloaded = 0;  // Track files actually downloaded
     int skipped_unchanged = 0;     // Track files skipped due to being unchanged
 
-    for (int i = 0; i < count; i++) {
-        cJSON *item = cJSON_GetArrayItem(root, i);
-        if (!cJSON_IsObject(item))
-            continue;
-
-        cJSON *entry = item->child;
-        if (!entry || !entry->string || !cJSON_IsObject(entry))
-            continue;
+    for (int i = 0; i < new_count; i++) {
+        const resource_entry_t *res = &new_entries[i];
 
-        const char *ext = strrchr(entry->string, '.');
-        if (strncmp(entry->string, "sound/", strlen("sound/")) == 0) {
+        const char *ext = strrchr(res->path, '.');
+        if (strncmp(res->path, "sound/", strlen("sound/")) == 0) {
 
-        } else if ( strncmp(entry->string, "animation/", strlen("animation/")) == 0 ||
+        } else if ( strncmp(res->path, "animation/", strlen("animation/")) == 0 ||
             (ext && strcasecmp(ext, ".mp3") == 0 )) {
             continue;
         }
         _count++;
 
-        cJSON *url = cJSON_GetObjectItem(entry, "url");
-        cJSON *r_size = cJSON_GetObjectItem(entry, "size");
         char fullPath[128];
-        sprintf(fullPath, "/sdcard/%s", entry->string);
-
-        if (cJSON_IsString(url) && cJSON_IsNumber(r_size)) {
-            // ========== STEP 2.4: DIFFERENTIAL UPDATE LOGIC ==========
-            // Find this file in the new_entries array to determine change type
-            resource_change_type_t change_type = RESOURCE_NEW;
-            resource_entry_t *matching_entry = NULL;
-
-            for (int j = 0; j < new_count; j++) {
-                if (strcmp(new_entries[j].path, entry->string) == 0) {
-                    matching_entry = &new_entries[j];
-                    change_type = compare_resource_entry(matching_entry, old_entries, old_count);
-                    break;
-                }
-            }
+        sprintf(fullPath, "/sdcard/%s", res->path);
 
-            int attempt = 1;
-            int size = get_file_size(fullPath);
+        // ========== STEP 2.4: DIFFERENTIAL UPDATE LOGIC ==========
+        resource_change_type_t change_type = res->change;
 
-            // Check if file is unchanged and exists with correct size
-            if (change_type == RESOURCE_UNCHANGED && size >= 0 && size == r_size->valueint) {
-                ESP_LOGI(TAG, "[GraphicData UNCHANGED - skipped]: %s (size: %d bytes)", fullPath, size);
-                skipped_unchanged++;
-                tmp_count++;
-                continue;  // Skip downloading this file
-            }
+        int attempt = 1;
+        int size = get_file_size(fullPath);
 
-            // File needs to be downloaded (either MODIFIED or NEW, or UNCHANGED but missing/corrupted)
-            if (change_type == RESOURCE_MODIFIED) {
-                ESP_LOGI(TAG, "[GraphicData MODIFIED - download]: %s", fullPath);
-            } else if (change_type == RESOURCE_NEW) {
-                ESP_LOGI(TAG, "[GraphicData NEW - download]: %s", fullPath);
-            }
+        // Check if file is unchanged and exists with correct size
+        if (change_type == RESOURCE_UNCHANGED && size >= 0 && size == res->size) {
+            ESP_LOGI(TAG, "[GraphicData UNCHANGED - skipped]: %s (size: %d bytes)", fullPath, size);
+            convert_native_image(fullPath);
+            skipped_unchanged++;
+            tmp_count++;
+            continue;  // Skip downloading this file
+        }
 
-            ESP_LOGI(TAG, "[GraphicData n%d - start]: %s", attempt, fullPath);
+        // File needs to be downloaded (either MODIFIED or NEW, or UNCHANGED but missing/corrupted)
+        if (change_type == RESOURCE_MODIFIED) {
+            ESP_LOGI(TAG, "[GraphicData MODIFIED - download]: %s", fullPath);
+        } else if (change_type == RESOURCE_NEW) {
+            ESP_LOGI(TAG, "[GraphicData NEW - download]: %s", fullPath);
+        }
 
-            if (size >= 0 && size == r_size->valueint) {
-                ESP_LOGI(TAG, "[GraphicData n%d - success]: %s", attempt, fullPath);
-                tmp_count++;
-            } else {
-                ESP_LOGW(TAG, "[GraphicData n%d - fail]: %s, received:%d, expected:%d", attempt, fullPath, size, r_size->valueint);
-                attempt++;
-
-                // Download to tmp/downloads instead of overwriting original
-                char downloadPath[300];
-                const char* filename_only = strrchr(fullPath, '/');
-                if (filename_only) filename_only++; else filename_only = fullPath;
-                snprintf(downloadPath, sizeof(downloadPath), "/sdcard/tmp/downloads/%s", filename_only);
-                create_directories(downloadPath);
-
-
-                ESP_LOGI(TAG, "[GraphicData n%d - start]: %s", attempt, downloadPath);
-                esp_err_t result = content_download(url->valuestring, downloadPath);
-                if (result == ESP_OK) {
-                    // content_download leaves file at downloadPath.tmp, check that file
-                    char tempDownloadPath[320];
-                    snprintf(tempDownloadPath, sizeof(tempDownloadPath), "%s.tmp", downloadPath);
-                    int download_size = get_file_size(tempDownloadPath);
-                    if (download_size == r_size->valueint) {
-                        // Download successful and size matches - replace original atomically with backup strategy
-                        // Ensure destination directory exists before replacement
-                        create_directories(fullPath);
-                        
-                        char backupPath[256];
-                        snprintf(backupPath, sizeof(backupPath), "%s.bak", fullPath);
-                        if (access(backupPath, F_OK) == 0) {
-                            unlink(backupPath);
-                        }
-                        
-                        // Step 1: Rename original to backup (if original exists)
-                        bool had_original = (access(fullPath, F_OK) == 0);
-                        if (had_original == false)
-                            create_directories(backupPath);
-                        if (had_original && s3_rename(fullPath, backupPath) != 0) {
-                            ESP_LOGW(TAG, "[GraphicData n%d - fail]: backup failed", attempt);
-                        } else {
-                            // Step 2: Move temp to original place
-                            if (s3_rename(tempDownloadPath, fullPath) == 0) {
-                                // Step 3: Success - remove backup
-                                if (had_original) s3_remove(backupPath);
-                                ESP_LOGI(TAG, "[GraphicData n%d - success]: %s", attempt, fullPath);
-                                tmp_count++; // Count this as success
-                                actually_downloaded++; // Track files actually downloaded
-                                // Step 4: Invalidate image cache for updated file
-                                invalidate_image_cache(fullPath);
-                            } else {
-                                // Step 4: Failed - restore original from backup
-                                if (had_original) s3_rename(backupPath, fullPath);
-                                ESP_LOGW(TAG, "[GraphicData n%d - fail]: move failed", attempt);
+        ESP_LOGI(TAG, "[GraphicData n%d - start]: %s", attempt, fullPath);
+
+        if (size >= 0 && size == res->size) {
+            ESP_LOGI(TAG, "[GraphicData n%d - success]: %s", attempt, fullPath);
+            convert_native_image(fullPath);
+            tmp_count++;
+        } else {
+            ESP_LOGW(TAG, "[GraphicData n%d - fail]: %s, received:%d, expected:%d", attempt, fullPath, size, res->size);
+            attempt++;
+
+            // Download to tmp/downloads instead of overwriting original
+            char downloadPath[300];
+            const char* filename_only = strrchr(fullPath, '/');
+            if (filename_only) filename_only++; else filename_only = fullPath;
+            snprintf(downloadPath, sizeof(downloadPath), "/sdcard/tmp/downloads/%s", filename_only);
+            create_directories(downloadPath);
+
+
+            ESP_LOGI(TAG, "[GraphicData n%d - start]: %s", attempt, downloadPath);
+            esp_err_t result = content_download(res->url, downloadPath);
+            if (result == ESP_OK) {
+                // content_download leaves file at downloadPath.tmp, check that file
+                char tempDownloadPath[320];
+                snprintf(tempDownloadPath, sizeof(tempDownloadPath), "%s.tmp", downloadPath);
+                int download_size = get_file_size(tempDownloadPath);
+                if (download_size == res->size) {
+                    // Download successful and size matches - replace original atomically with backup strategy
+                    // Ensure destination directory exists before replacement
+                    create_directories(fullPath);
+                    
+                    char backupPath[256];
+                    snprintf(backupPath, sizeof(backupPath), "%s.bak", fullPath);
+                    if (access(backupPath, F_OK) == 0) {
+                        unlink(backupPath);
+                    }
+                    
+                    // Step 1: Rename original to backup (if original exists)
+                    bool had_original = (access(fullPath, F_OK) == 0);
+                    if (had_original == false)
+                        create_directories(backupPath);
+                    if (had_original && s3_rename(fullPath, backupPath) != 0) {
+                        ESP_LOGW(TAG, "[GraphicData n%d - fail]: backup failed", attempt);
+                    } else {
+                        // Step 2: Move temp to original place
+                        if (s3_rename(tempDownloadPath, fullPath) == 0) {
+                            // Step 3: Success - remove backup
+                            if (had_original) s3_remove(backupPath);
+                            ESP_LOGI(TAG, "[GraphicData n%d - success]: %s", attempt, fullPath);
+                            tmp_count++; // Count this as success
+                            actually_downloaded++; // Track files actually downloaded
+                            // Step 4: Invalidate image and sound caches for updated file
+                            invalidate_image_cache(fullPath);
+                            if (strncmp(res->path, "sound/", strlen("sound/")) == 0) {
+                                audio_sound_cache_invalidate(fullPath);
                             }
+                            convert_native_image(fullPath);
+                        } else {
+                            // Step 4: Failed - restore original from backup
+                            if (had_original) s3_rename(backupPath, fullPath);
+                            ESP_LOGW(TAG, "[GraphicData n%d - fail]: move failed", attempt);
                         }
-                    } else {
-                        ESP_LOGW(TAG, "[GraphicData n%d - fail]: size mismatch, expected:%d, got:%d", attempt, r_size->valueint, download_size);
                     }
                 } else {
-                    ESP_LOGW(TAG, "[GraphicData n%d - fail]: download failed", attempt);
+                    ESP_LOGW(TAG, "[GraphicData n%d - fail]: size mismatch, expected:%d, got:%d", attempt, res->size, download_size);
                 }
+            } else {
+                ESP_LOGW(TAG, "[GraphicData n%d - fail]: download failed", attempt);
             }
         }
     }
@@ -2153,9 +2305,6 @@ esp_err_t sync_resource_without_mp3(char *url,int cnt) {
     free_resource_entries(new_entries, new_count);
     if (old_entries) free_resource_entries(old_entries, old_count);
 
-    cJSON_Delete(root);
-    free(buf);
-
     esp_err_t final_result = (tmp_count == _count) ? ESP_OK : ESP_FAIL;
 
     // Step 3: Remove backup manifest after successful sync
@@ -2356,20 +2505,31 @@ esp_err_t test_pure_download_speed(char *url, int test_duration_seconds) {
  * @brief Invalidate image cache for a downloaded file
  * @param path File path to invalidate cache for
  *
- * This function checks the file extension and calls the appropriate
- * cache invalidation function (JPEG or PNG).
+ * Only JPEG and PNG files are cached; other downloads are skipped.
  */
 static void invalidate_image_cache(const char *path) {
     if (!path) return;
 
     const char *ext = strrchr(path, '.');
-    if (ext) {
-        if (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0) {
-            jpeg_cache_invalidate(path);
-            ESP_LOGI(TAG, "Invalidated JPEG cache for: %s", path);
-        } else if (strcasecmp(ext, ".png") == 0) {
-            png_cache_invalidate(path);
-            ESP_LOGI(TAG, "Invalidated PNG cache for: %s", path);
+    if (ext && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0 || strcasecmp(ext, ".png") == 0)) {
+        img_cache_invalidate(path);
+        ESP_LOGI(TAG, "Invalidated image cache for: %s", path);
+    }
+}
+
+/**
+ * @brief Convert a synced JPEG or PNG to its LVGL-native file, so screens read it without decoding
+ *
+ * A no-op when the native file is already current; a failure only costs a decode on the device.
+ */
+static void convert_native_image(const char *path) {
+    if (!path) return;
+
+    const char *ext = strrchr(path, '.');
+    if (ext && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0 || strcasecmp(ext, ".png") == 0)) {
+        esp_err_t err = lvgl_native_img_convert(path);
+        if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) {
+            ESP_LOGW(TAG, "Native conversion of %s failed: %s", path, esp_err_to_name(err));
         }
     }
 }
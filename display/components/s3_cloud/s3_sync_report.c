@@ -0,0 +1,110 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "s3_download_pool.h"
+#include "s3_https_cloud.h"
+#include "s3_sync_report.h"
+
+static const char *TAG = "SYNC_REPORT";
+
+typedef struct {
+    int64_t us;
+    s3_cloud_api_stats_t api;
+    s3_download_pool_stats_t pool;
+} sync_snapshot_t;
+
+typedef struct {
+    const char *name;
+    sync_snapshot_t start;
+    sync_snapshot_t end;
+    size_t min_free_internal;   // Lowest free internal RAM seen at the stage boundaries
+} sync_stage_t;
+
+static sync_stage_t s_stages[S3_SYNC_REPORT_MAX_STAGES];
+static int s_stage_count = 0;
+static bool s_active = false;
+static sync_snapshot_t s_begin;
+
+static void sync_snapshot(sync_snapshot_t *snap) {
+    snap->us = esp_timer_get_time();
+    s3_cloud_api_get_stats(&snap->api);
+    s3_download_pool_get_totals(&snap->pool);
+}
+
+static void sync_stage_close(const sync_snapshot_t *now) {
+    if (s_stage_count > 0) {
+        sync_stage_t *st = &s_stages[s_stage_count - 1];
+        if (st->end.us == 0) {
+            st->end = *now;
+            size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+            if (free_internal < st->min_free_internal) {
+                st->min_free_internal = free_internal;
+            }
+        }
+    }
+}
+
+void s3_sync_report_begin(void) {
+    memset(s_stages, 0, sizeof(s_stages));
+    s_stage_count = 0;
+    sync_snapshot(&s_begin);
+    s_active = true;
+}
+
+void s3_sync_report_stage(const char *name) {
+    if (!s_active) {
+        return;
+    }
+    sync_snapshot_t now;
+    sync_snapshot(&now);
+    sync_stage_close(&now);
+    if (s_stage_count >= S3_SYNC_REPORT_MAX_STAGES) {
+        ESP_LOGW(TAG, "Too many stages, \"%s\" is counted in the previous one", name);
+        return;
+    }
+    sync_stage_t *st = &s_stages[s_stage_count++];
+    st->name = name;
+    st->start = now;
+    st->min_free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+static void sync_report_line(const char *name, const sync_snapshot_t *a, const sync_snapshot_t *b, size_t min_free) {
+    ESP_LOGI(TAG, "%-10s %7lld ms | api %3u req %2u conn %2u retry %7llu B out %8llu B in | "
+             "files %3u ok %2u fail %2u retry %2u resumed %2u restarted %9llu B | min int %u",
+             name, (b->us - a->us) / 1000,
+             (unsigned int)(b->api.requests - a->api.requests),
+             (unsigned int)(b->api.connections - a->api.connections),
+             (unsigned int)(b->api.retries - a->api.retries),
+             (unsigned long long)(b->api.bytes_sent - a->api.bytes_sent),
+             (unsigned long long)(b->api.bytes_received - a->api.bytes_received),
+             (unsigned int)(b->pool.files_ok - a->pool.files_ok),
+             (unsigned int)(b->pool.files_failed - a->pool.files_failed),
+             (unsigned int)(b->pool.retries - a->pool.retries),
+             (unsigned int)(b->pool.resumed - a->pool.resumed),
+             (unsigned int)(b->pool.restarted - a->pool.restarted),
+             (unsigned long long)(b->pool.bytes - a->pool.bytes),
+             (unsigned int)min_free);
+}
+
+void s3_sync_report_end(void) {
+    if (!s_active) {
+        return;
+    }
+    sync_snapshot_t now;
+    sync_snapshot(&now);
+    sync_stage_close(&now);
+    s_active = false;
+
+    size_t min_free = SIZE_MAX;
+    for (int i = 0; i < s_stage_count; i++) {
+        sync_report_line(s_stages[i].name, &s_stages[i].start, &s_stages[i].end, s_stages[i].min_free_internal);
+        if (s_stages[i].min_free_internal < min_free) {
+            min_free = s_stages[i].min_free_internal;
+        }
+    }
+    sync_report_line("total", &s_begin, &now, min_free == SIZE_MAX ? heap_caps_get_free_size(MALLOC_CAP_INTERNAL) : min_free);
+}
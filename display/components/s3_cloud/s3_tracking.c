@@ -12,16 +12,184 @@ static int record_capacity = 0;
 #define INITIAL_CAPACITY 10
 
 #include <time.h>
+#include <unistd.h>
+#include <dirent.h>
 #include <sys/stat.h>
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
 #include "freertos/FreeRTOS.h"
 #include "cJSON.h"
 #include "s3_definitions.h"
+#include "s3_https_cloud.h"
+#if S3_TRACKING_UPLOAD_GZIP
+#include "rom/miniz.h"
+#endif
 
 extern esp_err_t g_init_sdcard;
 extern char s3_babyId[32];
 #define TAG "s3_tracking"
 
+/*
+ * tracking_YYYYMMDD.trk: an 8-byte header ("S3TK", u16 version, u16 reserved) followed by
+ * records with fixed-width little-endian fields, so a file reads the same whatever the
+ * toolchain's time_t and int sizes:
+ *   u16 contentId length, contentId bytes, i64 start, i64 end, u8 flags
+ * tracking_YYYYMMDD.bin files from older firmware hold raw structs and are still read.
+ * A record cut short by power loss is cut off the file before the next append, so records
+ * saved after it are never read from the middle of the torn one.
+ */
+#define TRACKING_MAGIC              0x4B543353u  // "S3TK"
+#define TRACKING_VERSION            1
+#define TRACKING_HEADER_SIZE        8
+#define TRACKING_FLAG_FULL_PLAY     (1 << 0)
+#define TRACKING_CONTENT_ID_MAX     UINT16_MAX
+
+static void put_le(uint8_t *p, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+// Older firmware wrote the structs as laid out in memory: u16 length, contentId, time_t, time_t, int
+static bool read_legacy_record(FILE *f, char *contentId, size_t len, TrackingRecord *record)
+{
+    time_t start;
+    time_t end;
+    int isFullPlay;
+    if (fread(contentId, 1, len, f) != len ||
+        fread(&start, sizeof(time_t), 1, f) != 1 ||
+        fread(&end, sizeof(time_t), 1, f) != 1 ||
+        fread(&isFullPlay, sizeof(int), 1, f) != 1) {
+        return false;
+    }
+    record->start = start;
+    record->end = end;
+    record->isFullPlay = isFullPlay;
+    return true;
+}
+
+static bool read_record(FILE *f, char *contentId, size_t len, TrackingRecord *record)
+{
+    uint8_t tail[17];
+    if (fread(contentId, 1, len, f) != len || fread(tail, 1, sizeof(tail), f) != sizeof(tail)) {
+        return false;
+    }
+    record->start = (time_t)(int64_t)get_le(tail, 8);
+    record->end = (time_t)(int64_t)get_le(tail + 8, 8);
+    record->isFullPlay = (tail[16] & TRACKING_FLAG_FULL_PLAY) ? 1 : 0;
+    return true;
+}
+
+typedef enum {
+    TRACKING_READ_OK,
+    TRACKING_READ_END,          // Clean end of file
+    TRACKING_READ_TRUNCATED,    // Record cut short at the end of the file
+    TRACKING_READ_ERROR,
+} tracking_read_t;
+
+static tracking_read_t read_next_record(FILE *f, bool legacy, char *contentId, TrackingRecord *record)
+{
+    // 1. Read contentId length
+    uint8_t len_le[2];
+    size_t got = fread(len_le, 1, sizeof(len_le), f);
+    if (got == 0 && feof(f)) {
+        return TRACKING_READ_END;
+    }
+    size_t len = 0;
+    if (got == sizeof(len_le)) {
+        uint16_t native_len;
+        memcpy(&native_len, len_le, sizeof(native_len));
+        len = legacy ? native_len : (size_t)get_le(len_le, 2);
+    }
+
+    // 2. Read contentId string and the rest of the record
+    record->contentId = contentId;
+    if (got != sizeof(len_le) ||
+        !(legacy ? read_legacy_record(f, contentId, len, record) : read_record(f, contentId, len, record))) {
+        return feof(f) ? TRACKING_READ_TRUNCATED : TRACKING_READ_ERROR;
+    }
+    contentId[len] = '\0'; // Null-terminate the string
+    return TRACKING_READ_OK;
+}
+
+/**
+ * @brief Open a day file for appending, cutting off a record torn by power loss
+ * @return The file positioned at its end, with a valid header; NULL on failure
+ */
+static FILE *open_for_append(const char *filepath)
+{
+    FILE *f = fopen(filepath, "r+b");
+    if (f == NULL) {
+        f = fopen(filepath, "w+b");
+        if (f == NULL) {
+            return NULL;
+        }
+    }
+
+    long valid_end = 0;
+    uint8_t header[TRACKING_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), f) == sizeof(header) && get_le(header, 4) == TRACKING_MAGIC) {
+        if (get_le(header + 4, 2) != TRACKING_VERSION) {
+            ESP_LOGE(TAG, "Unsupported tracking file version %d: %s", (int)get_le(header + 4, 2), filepath);
+            fclose(f);
+            return NULL;
+        }
+        char *contentId = heap_caps_malloc(TRACKING_CONTENT_ID_MAX + 1, MALLOC_CAP_SPIRAM);
+        if (contentId == NULL) {
+            fclose(f);
+            return NULL;
+        }
+        valid_end = TRACKING_HEADER_SIZE;
+        TrackingRecord record;
+        tracking_read_t res;
+        while ((res = read_next_record(f, false, contentId, &record)) == TRACKING_READ_OK) {
+            valid_end = ftell(f);
+        }
+        free(contentId);
+        if (res == TRACKING_READ_ERROR) {
+            fclose(f);
+            return NULL;
+        }
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    if (size != valid_end) {
+        // A torn header restarts the file; a torn record is dropped
+        ESP_LOGW(TAG, "Dropping %ld torn bytes at the end of %s", size - valid_end, filepath);
+        fflush(f);
+        if (ftruncate(fileno(f), valid_end) != 0) {
+            ESP_LOGE(TAG, "Failed to truncate %s", filepath);
+            fclose(f);
+            return NULL;
+        }
+    }
+    fseek(f, valid_end, SEEK_SET);
+
+    if (valid_end == 0) {
+        memset(header, 0, sizeof(header));
+        put_le(header, TRACKING_MAGIC, 4);
+        put_le(header + 4, TRACKING_VERSION, 2);
+        if (fwrite(header, 1, sizeof(header), f) != sizeof(header)) {
+            ESP_LOGE(TAG, "Failed to write tracking header");
+            fclose(f);
+            return NULL;
+        }
+    }
+    return f;
+}
+
 static void save_records_to_sdcard()
 {
     if (record_count == 0) {
@@ -43,39 +211,31 @@ static void save_records_to_sdcard()
     localtime_r(&first_record_time, &timeinfo);
     char date_str[9];
     strftime(date_str, sizeof(date_str), "%Y%m%d", &timeinfo);
-    snprintf(filepath, sizeof(filepath), "/sdcard/tmp/tracking_%s.bin", date_str);
+    snprintf(filepath, sizeof(filepath), "/sdcard/tmp/tracking_%s.trk", date_str);
 
-    FILE *f = fopen(filepath, "ab"); // Append Binary
+    FILE *f = open_for_append(filepath);
     if (f == NULL) {
         ESP_LOGE(TAG, "Failed to open file for writing: %s", filepath);
         return; // Can't save any records if file fails to open
     }
 
     for (int i = 0; i < record_count; i++) {
-        // 1. Write contentId length
-        uint16_t len = strlen(records[i].contentId);
-        if (fwrite(&len, sizeof(uint16_t), 1, f) != 1) {
-            ESP_LOGE(TAG, "Failed to write contentId length");
-            break; // Stop if write fails
+        size_t len = strlen(records[i].contentId);
+        if (len > TRACKING_CONTENT_ID_MAX) {
+            ESP_LOGE(TAG, "contentId too long, record dropped");
+            continue;
         }
-
-        // 2. Write contentId string
-        if (fwrite(records[i].contentId, sizeof(char), len, f) != len) {
-            ESP_LOGE(TAG, "Failed to write contentId string");
-            break; // Stop if write fails
-        }
-
-        // 3. Write the rest of the record
-        if (fwrite(&records[i].start, sizeof(time_t), 1, f) != 1) {
-            ESP_LOGE(TAG, "Failed to write start time");
-            break; // Stop if write fails
-        }
-        if (fwrite(&records[i].end, sizeof(time_t), 1, f) != 1) {
-            ESP_LOGE(TAG, "Failed to write end time");
-            break; // Stop if write fails
-        }
-        if (fwrite(&records[i].isFullPlay, sizeof(int), 1, f) != 1) {
-            ESP_LOGE(TAG, "Failed to write isFullPlay flag");
+        uint8_t head[2];
+        uint8_t tail[17];
+        put_le(head, len, 2);
+        put_le(tail, (uint64_t)(int64_t)records[i].start, 8);
+        put_le(tail + 8, (uint64_t)(int64_t)records[i].end, 8);
+        tail[16] = records[i].isFullPlay ? TRACKING_FLAG_FULL_PLAY : 0;
+
+        if (fwrite(head, 1, sizeof(head), f) != sizeof(head) ||
+            fwrite(records[i].contentId, 1, len, f) != len ||
+            fwrite(tail, 1, sizeof(tail), f) != sizeof(tail)) {
+            ESP_LOGE(TAG, "Failed to write tracking record");
             break; // Stop if write fails
         }
     }
@@ -169,104 +329,112 @@ void s3_tracking_cleanup(void) {
     record_capacity = 0;
 }
 
-int s3_tracking_load_records_from_file(const char *filepath, TrackingRecord **out_records, int *out_count)
+int s3_tracking_read_file(const char *filepath, s3_tracking_record_cb_t cb, void *ctx)
 {
     FILE *f = fopen(filepath, "rb"); // Read Binary
     if (f == NULL) {
         ESP_LOGE(TAG, "File not found or failed to open for reading: %s", filepath);
-        *out_records = NULL;
-        *out_count = 0;
         return -1;
     }
 
-    int capacity = 10;
-    int count = 0;
-    TrackingRecord *records_ptr = malloc(capacity * sizeof(TrackingRecord));
-    if (records_ptr == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate initial memory for records");
+    uint8_t header[TRACKING_HEADER_SIZE];
+    bool legacy = true;
+    if (fread(header, 1, sizeof(header), f) == sizeof(header) && get_le(header, 4) == TRACKING_MAGIC) {
+        int version = (int)get_le(header + 4, 2);
+        if (version != TRACKING_VERSION) {
+            ESP_LOGE(TAG, "Unsupported tracking file version %d: %s", version, filepath);
+            fclose(f);
+            return -1;
+        }
+        legacy = false;
+    } else {
+        rewind(f);
+    }
+
+    char *contentId = heap_caps_malloc(TRACKING_CONTENT_ID_MAX + 1, MALLOC_CAP_SPIRAM);
+    if (contentId == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for contentId");
         fclose(f);
         return -1;
     }
 
+    int count = 0;
+    int ret = 0;
     while (1) {
-        if (count >= capacity) {
-            capacity *= 2;
-            TrackingRecord *new_records = heap_caps_realloc(records_ptr, capacity * sizeof(TrackingRecord), MALLOC_CAP_SPIRAM);
-            if (new_records == NULL) {
-                ESP_LOGE(TAG, "Failed to reallocate memory for records");
-                s3_tracking_free_loaded_records(records_ptr, count);
-                fclose(f);
-                return -1;
+        TrackingRecord record;
+        tracking_read_t res = read_next_record(f, legacy, contentId, &record);
+        if (res == TRACKING_READ_END) {
+            break; // End of file is expected
+        }
+        if (res != TRACKING_READ_OK) {
+            // Power lost while a record was appended: keep the complete ones before it
+            if (res == TRACKING_READ_ERROR) {
+                ESP_LOGE(TAG, "Failed to read record data");
+                ret = -1;
+            } else {
+                ESP_LOGW(TAG, "Truncated record at the end of %s", filepath);
             }
-            records_ptr = new_records;
+            break;
         }
 
-        // 1. Read contentId length
-        uint16_t len;
-        if (fread(&len, sizeof(uint16_t), 1, f) != 1) {
-            if (feof(f)) break; // End of file is expected
-            ESP_LOGE(TAG, "Failed to read contentId length");
-            s3_tracking_free_loaded_records(records_ptr, count);
-            fclose(f);
-            return -1;
+        count++;
+        if (!cb(&record, ctx)) {
+            break;
         }
+    }
 
-        // 2. Read contentId string
-        char *contentId_buf = malloc(len + 1);
-        if (contentId_buf == NULL) {
-            ESP_LOGE(TAG, "Failed to allocate memory for contentId");
-            s3_tracking_free_loaded_records(records_ptr, count);
-            fclose(f);
-            return -1;
-        }
-        if (fread(contentId_buf, sizeof(char), len, f) != len) {
-            ESP_LOGE(TAG, "Failed to read contentId string");
-            free(contentId_buf);
-            s3_tracking_free_loaded_records(records_ptr, count);
-            fclose(f);
-            return -1;
-        }
-        contentId_buf[len] = '\0'; // Null-terminate the string
+    free(contentId);
+    fclose(f);
+    return ret == 0 ? count : -1;
+}
 
-        records_ptr[count].contentId = strdup_spiram(contentId_buf);
-        free(contentId_buf);
-        if (records_ptr[count].contentId == NULL) {
-            ESP_LOGE(TAG, "Failed to duplicate contentId string into SPIRAM");
-            s3_tracking_free_loaded_records(records_ptr, count);
-            fclose(f);
-            return -1;
-        }
+typedef struct {
+    TrackingRecord *records;
+    int count;
+    int capacity;
+} load_ctx_t;
 
-        // 3. Read the rest of the record
-        if (fread(&records_ptr[count].start, sizeof(time_t), 1, f) != 1 ||
-            fread(&records_ptr[count].end, sizeof(time_t), 1, f) != 1 ||
-            fread(&records_ptr[count].isFullPlay, sizeof(int), 1, f) != 1) {
-            ESP_LOGE(TAG, "Failed to read record data");
-            // Free the contentId we just allocated
-            free((void*)records_ptr[count].contentId);
-            s3_tracking_free_loaded_records(records_ptr, count);
-            fclose(f);
-            return -1;
+static bool load_record(const TrackingRecord *record, void *arg)
+{
+    load_ctx_t *load = arg;
+    if (load->count >= load->capacity) {
+        int capacity = load->capacity ? load->capacity * 2 : INITIAL_CAPACITY;
+        TrackingRecord *new_records = heap_caps_realloc(load->records, capacity * sizeof(TrackingRecord), MALLOC_CAP_SPIRAM);
+        if (new_records == NULL) {
+            ESP_LOGE(TAG, "Failed to reallocate memory for records");
+            return false;
         }
+        load->records = new_records;
+        load->capacity = capacity;
+    }
 
-        // uint64_t tStart = records_ptr[count].start;
-        // ESP_LOGI(TAG, "Value: %u%010u",
-        //          (unsigned)(tStart / 10000000000ULL),  // 高位
-        //          (unsigned)(tStart % 10000000000ULL)); // 低位
-        //
-        // uint64_t tEnd = records_ptr[count].end;
-        // ESP_LOGI(TAG, "Value: %u%010u",
-        //          (unsigned)(tEnd / 10000000000ULL),  // 高位
-        //          (unsigned)(tEnd % 10000000000ULL)); // 低位
-
-        ESP_LOGI(TAG, "Loaded record: %s, %d", records_ptr[count].contentId, records_ptr[count].isFullPlay);
-        count++;
+    TrackingRecord *copy = &load->records[load->count];
+    *copy = *record;
+    copy->contentId = strdup_spiram(record->contentId);
+    if (copy->contentId == NULL) {
+        ESP_LOGE(TAG, "Failed to duplicate contentId string into SPIRAM");
+        return false;
     }
+    load->count++;
+    ESP_LOGI(TAG, "Loaded record: %s, %d", copy->contentId, copy->isFullPlay);
+    return true;
+}
 
-    fclose(f);
-    *out_records = records_ptr;
-    *out_count = count;
-    ESP_LOGI(TAG, "Loaded %d records from %s", count, filepath);
+int s3_tracking_load_records_from_file(const char *filepath, TrackingRecord **out_records, int *out_count)
+{
+    load_ctx_t load = {0};
+    *out_records = NULL;
+    *out_count = 0;
+
+    int read = s3_tracking_read_file(filepath, load_record, &load);
+    if (read < 0 || read != load.count) {
+        s3_tracking_free_loaded_records(load.records, load.count);
+        return -1;
+    }
+
+    *out_records = load.records;
+    *out_count = load.count;
+    ESP_LOGI(TAG, "Loaded %d records from %s", load.count, filepath);
     return 0;
 }
 
@@ -281,53 +449,329 @@ void s3_tracking_free_loaded_records(TrackingRecord *loaded_records, int count)
     free(loaded_records);
 }
 
-char *make_json_tracking_messages( TrackingRecord *records, int record_count) {
-    // root object
-    cJSON *root = cJSON_CreateObject();
+/* === Upload body === */
+
+/*
+ *  upload format : https://redmine.pixseecare.com:8081/issues/15143#note-4
+ *  One day: {"date":"YYYYMMDD","source":"device","records":{"<babyId>":[{"contentId":..,"seconds":..,"points":..}]}}
+ *  A batch is a JSON array of days.
+ */
+
+typedef struct {
+    FILE *f;
+    bool failed;
+#if S3_TRACKING_UPLOAD_GZIP
+    tdefl_compressor *deflate;     // NULL when the body is written as is
+    uint32_t crc;
+    uint32_t size;
+#endif
+} upload_writer_t;
+
+#if S3_TRACKING_UPLOAD_GZIP
+static mz_bool upload_put_buf(const void *buf, int len, void *arg)
+{
+    upload_writer_t *w = arg;
+    return fwrite(buf, 1, len, w->f) == (size_t)len;
+}
+#endif
 
-//    time_t now = time(NULL);
-//    struct tm *t = localtime(&now);
-    struct tm *t = localtime(&records[0].start);
-    char date_str[9];
-    strftime(date_str, sizeof(date_str), "%Y%m%d", t);
-    cJSON_AddStringToObject(root, "date", date_str);
-    cJSON_AddStringToObject(root, "source", "device");
+static void upload_write(upload_writer_t *w, const char *data, size_t len)
+{
+    if (w->failed || len == 0) {
+        return;
+    }
+#if S3_TRACKING_UPLOAD_GZIP
+    if (w->deflate) {
+        w->crc = esp_rom_crc32_le(w->crc, (const uint8_t *)data, len);
+        w->size += len;
+        if (tdefl_compress_buffer(w->deflate, data, len, TDEFL_NO_FLUSH) != TDEFL_STATUS_OKAY) {
+            w->failed = true;
+        }
+        return;
+    }
+#endif
+    if (fwrite(data, 1, len, w->f) != len) {
+        w->failed = true;
+    }
+}
+
+static void upload_write_str(upload_writer_t *w, const char *str)
+{
+    upload_write(w, str, strlen(str));
+}
 
-    // records object
-    cJSON *records_obj = cJSON_CreateObject();
-    cJSON *records_array = cJSON_CreateArray();
+typedef struct {
+    upload_writer_t *w;
+    const char *babyId_json;    // babyId as a JSON string
+    int day_records;
+    bool first_day;
+} upload_day_t;
 
-    for (int i = 0; i < record_count; i++) {
-        cJSON *item = cJSON_CreateObject();
-        cJSON_AddStringToObject(item, "contentId", records[i].contentId);
-        cJSON_AddNumberToObject(item, "seconds", records[i].end - records[i].start);
-        if (records[i].end - records[i].start > 300 || records[i].isFullPlay)
-        	cJSON_AddNumberToObject(item, "points", 1);
-        else
-            cJSON_AddNumberToObject(item, "points", 0);
-        cJSON_AddItemToArray(records_array, item);
-    }
-
-    cJSON_AddItemToObject(records_obj, s3_babyId, records_array);
-    cJSON_AddItemToObject(root, "records", records_obj);
-
-    // 輸出字串（記得要 free）
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    return json_str;
+static bool upload_record(const TrackingRecord *record, void *arg)
+{
+    upload_day_t *day = arg;
+    if (day->day_records == 0) {
+        struct tm timeinfo;
+        char date_str[9];
+        localtime_r(&record->start, &timeinfo);
+        strftime(date_str, sizeof(date_str), "%Y%m%d", &timeinfo);
+
+        char head[64];
+        snprintf(head, sizeof(head), "%s{\"date\":\"%s\",\"source\":\"device\",\"records\":{",
+                 day->first_day ? "" : ",", date_str);
+        upload_write_str(day->w, head);
+        upload_write_str(day->w, day->babyId_json);
+        upload_write_str(day->w, ":[");
+        day->first_day = false;
+    } else {
+        upload_write_str(day->w, ",");
+    }
+
+    cJSON *item = cJSON_CreateObject();
+    cJSON_AddStringToObject(item, "contentId", record->contentId);
+    cJSON_AddNumberToObject(item, "seconds", record->end - record->start);
+    if (record->end - record->start > 300 || record->isFullPlay)
+        cJSON_AddNumberToObject(item, "points", 1);
+    else
+        cJSON_AddNumberToObject(item, "points", 0);
+    char *json_str = cJSON_PrintUnformatted(item);
+    cJSON_Delete(item);
+    if (json_str == NULL) {
+        day->w->failed = true;
+        return false;
+    }
+    upload_write_str(day->w, json_str);
+    free(json_str);
+
+    day->day_records++;
+    return !day->w->failed;
+}
+
+esp_err_t s3_tracking_write_upload(const char *const *paths, int path_count, bool as_array, bool gzip,
+                                   const char *out_path, int *day_records)
+{
+    for (int i = 0; i < path_count; i++) {
+        day_records[i] = -1;
+    }
+
+    upload_writer_t w = {0};
+    w.f = fopen(out_path, "wb");
+    if (w.f == NULL) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", out_path);
+        return ESP_FAIL;
+    }
+
+#if S3_TRACKING_UPLOAD_GZIP
+    if (gzip) {
+        w.deflate = heap_caps_malloc(sizeof(tdefl_compressor), MALLOC_CAP_SPIRAM);
+        if (w.deflate == NULL ||
+            tdefl_init(w.deflate, upload_put_buf, &w, TDEFL_DEFAULT_MAX_PROBES) != TDEFL_STATUS_OKAY) {
+            ESP_LOGE(TAG, "Failed to start compression");
+            free(w.deflate);
+            fclose(w.f);
+            return ESP_ERR_NO_MEM;
+        }
+        // gzip member header: deflate, no name, no mtime, unknown OS
+        static const uint8_t gzip_header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+        w.failed = fwrite(gzip_header, 1, sizeof(gzip_header), w.f) != sizeof(gzip_header);
+    }
+#else
+    (void)gzip;
+#endif
+
+    cJSON *babyId = cJSON_CreateString(s3_babyId);
+    char *babyId_json = babyId ? cJSON_PrintUnformatted(babyId) : NULL;
+    cJSON_Delete(babyId);
+
+    upload_day_t day = { .w = &w, .babyId_json = babyId_json ? babyId_json : "\"\"", .first_day = true };
+    if (as_array) {
+        upload_write_str(&w, "[");
+    }
+    for (int i = 0; i < path_count && !w.failed; i++) {
+        day.day_records = 0;
+        if (s3_tracking_read_file(paths[i], upload_record, &day) < 0) {
+            ESP_LOGE(TAG, "Failed to load records from %s", paths[i]);
+            if (day.day_records == 0) {
+                day_records[i] = -1;    // Kept for the next sync
+                continue;
+            }
+        }
+        if (day.day_records > 0) {
+            upload_write_str(&w, "]}}");
+        }
+        day_records[i] = day.day_records;
+    }
+    if (as_array) {
+        upload_write_str(&w, "]");
+    }
+    free(babyId_json);
+
+#if S3_TRACKING_UPLOAD_GZIP
+    if (w.deflate) {
+        if (!w.failed && tdefl_compress_buffer(w.deflate, NULL, 0, TDEFL_FINISH) != TDEFL_STATUS_DONE) {
+            w.failed = true;
+        }
+        uint8_t trailer[8];
+        put_le(trailer, w.crc, 4);
+        put_le(trailer + 4, w.size, 4);
+        if (!w.failed && fwrite(trailer, 1, sizeof(trailer), w.f) != sizeof(trailer)) {
+            w.failed = true;
+        }
+        free(w.deflate);
+    }
+#endif
+
+    if (fclose(w.f) != 0 || w.failed) {
+        ESP_LOGE(TAG, "Failed to write upload body %s", out_path);
+        remove(out_path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
 }
 
-//esp_err_t s3_tracking_messages_format(const char *messages) {
-//    TrackingRecord records[] = {
-//        {"IST-00047", 1757399599, 1757399999, 0}, // 400 points 1
-//        {"IST-00047", 1757399599, 1757399999, 1}, // 400 points 1
-//        {"IST-00099", 1757399899, 1757399999, 0}, // 100 points 0
-//        {"IST-00099", 1757399899, 1757399999, 1}  // 100 points 1
-//    };
-//
-//    char *json_str = make_json_tracking_messages(records, 4);
-//    printf("%s\n", json_str);
-//    free(json_str);
-//    return ESP_OK;
-//}
+/* === Upload of the pending days === */
+
+// Helper structure to hold file information
+typedef struct {
+    char name[64];
+    time_t mtime;
+} file_entry_t;
+
+// Comparison function for qsort
+static int compare_files(const void *a, const void *b) {
+    file_entry_t *file_a = (file_entry_t *)a;
+    file_entry_t *file_b = (file_entry_t *)b;
+    return difftime(file_a->mtime, file_b->mtime);
+}
+
+// The tracking endpoint refused a batched upload; stay on one day per request until reboot
+static bool s_tracking_batch_rejected = false;
+
+esp_err_t s3_tracking_upload_pending(void)
+{
+    const char *dir_path = "/sdcard/tmp";
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        ESP_LOGE(TAG, "Failed to open directory: %s", dir_path);
+        return ESP_FAIL;
+    }
+
+    file_entry_t *files = NULL;
+    int file_count = 0;
+    struct dirent *entry = NULL;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "tracking_", 9) == 0 &&
+            (strstr(entry->d_name, ".trk") != NULL || strstr(entry->d_name, ".bin") != NULL)) {
+            files = heap_caps_realloc(files, (file_count + 1) * sizeof(file_entry_t), MALLOC_CAP_SPIRAM);
+            if (!files) {
+                ESP_LOGE(TAG, "Failed to allocate memory for file list");
+                closedir(dir);
+                return ESP_ERR_NO_MEM;
+            }
+
+            char full_path[256];
+            size_t max_name_len = sizeof(full_path) - strlen(dir_path) - 2;
+            snprintf(full_path, sizeof(full_path), "%s/%.*s", dir_path, (int)max_name_len, entry->d_name);
+
+            struct stat st;
+            if (stat(full_path, &st) == 0) {
+                strncpy(files[file_count].name, entry->d_name, sizeof(files[file_count].name) - 1);
+                files[file_count].name[sizeof(files[file_count].name) - 1] = '\0';
+                files[file_count].mtime = st.st_mtime;
+                file_count++;
+            }
+        }
+    }
+    closedir(dir);
+
+    if (file_count == 0) {
+        ESP_LOGI(TAG, "No tracking files found in %s", dir_path);
+        return ESP_OK;
+    }
+
+    qsort(files, file_count, sizeof(file_entry_t), compare_files);
+
+    ESP_LOGI(TAG, "Found %d tracking files. Processing in chronological order...", file_count);
 
+    char (*paths)[256] = heap_caps_malloc(file_count * sizeof(*paths), MALLOC_CAP_SPIRAM);
+    const char **path_list = heap_caps_malloc(file_count * sizeof(*path_list), MALLOC_CAP_SPIRAM);
+    int *day_records = heap_caps_malloc(file_count * sizeof(*day_records), MALLOC_CAP_SPIRAM);
+    if (!paths || !path_list || !day_records) {
+        ESP_LOGE(TAG, "Failed to allocate memory for file list");
+        free(paths);
+        free(path_list);
+        free(day_records);
+        free(files);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < file_count; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%s", dir_path, files[i].name);
+        path_list[i] = paths[i];
+    }
+    free(files);
+
+    // All pending days go up in one request (CONFIG_TRACKING_UPLOAD_BATCH, on by default); a
+    // server that rejects the batch gets the same days one per request
+    esp_err_t ret = ESP_FAIL;
+    if (S3_TRACKING_UPLOAD_BATCH && !s_tracking_batch_rejected) {
+        ret = s3_tracking_write_upload(path_list, file_count, true, S3_TRACKING_UPLOAD_GZIP,
+                                       TRACKING_UPLOAD_BODY_PATH, day_records);
+        if (ret == ESP_OK) {
+            int total = 0;
+            for (int i = 0; i < file_count; i++) {
+                total += day_records[i] > 0 ? day_records[i] : 0;
+            }
+            if (total > 0) {
+                ret = s3_cloud_upload_tracking_file(TRACKING_UPLOAD_BODY_PATH, S3_TRACKING_UPLOAD_GZIP);
+            }
+            if (ret == ESP_OK) {
+                ESP_LOGI(TAG, "Uploaded %d tracking records from %d files in one request", total, file_count);
+                for (int i = 0; i < file_count; i++) {
+                    if (day_records[i] >= 0) {
+                        remove(paths[i]);
+                    }
+                }
+            } else if (ret == ESP_ERR_NOT_SUPPORTED) {
+                ESP_LOGW(TAG, "Batched tracking upload rejected, uploading one day per request");
+                s_tracking_batch_rejected = true;
+            } else {
+                ESP_LOGE(TAG, "Failed to upload tracking info");
+            }
+        }
+        remove(TRACKING_UPLOAD_BODY_PATH);
+    }
+
+    if (!S3_TRACKING_UPLOAD_BATCH || s_tracking_batch_rejected) {
+        ret = ESP_OK;
+        for (int i = 0; i < file_count; i++) {
+            ESP_LOGI(TAG, "Processing file: %s", paths[i]);
+            if (s3_tracking_write_upload(&path_list[i], 1, false, false,
+                                         TRACKING_UPLOAD_BODY_PATH, &day_records[i]) != ESP_OK ||
+                day_records[i] < 0) {
+                ESP_LOGE(TAG, "Failed to load records from %s", paths[i]);
+                continue;
+            }
+            if (day_records[i] == 0) {
+                ESP_LOGI(TAG, "No records in %s, deleting empty file.", paths[i]);
+                remove(paths[i]);
+                continue;
+            }
+            esp_err_t err = s3_cloud_upload_tracking_file(TRACKING_UPLOAD_BODY_PATH, false);
+            if (err == ESP_OK) {
+                ESP_LOGI(TAG, "Uploaded tracking info from %s", paths[i]);
+                remove(paths[i]);
+            } else {
+                // Kept for the next sync, whatever the server answered
+                ESP_LOGE(TAG, "Failed to upload tracking info from %s", paths[i]);
+                ret = ESP_FAIL;
+            }
+        }
+        remove(TRACKING_UPLOAD_BODY_PATH);
+    }
+
+    free(paths);
+    free(path_list);
+    free(day_records);
+    return ret;
+}
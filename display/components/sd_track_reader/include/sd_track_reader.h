@@ -0,0 +1,117 @@
+#ifndef SD_TRACK_READER_H
+#define SD_TRACK_READER_H
+
+#include "audio_element.h" // Includes basic definitions for ESP-ADF audio elements
+#include "audio_common.h"  // Includes common ESP-ADF definitions
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called from the reader task when the current file is about to run out.
+ * @param el  Reader element
+ * @param ctx User context given to sd_track_reader_set_chain_cb()
+ * @return Path of the file to continue with (malloc'd, the reader takes ownership), or NULL to end the stream
+ */
+typedef char *(*sd_track_reader_next_cb_t)(audio_element_handle_t el, void *ctx);
+
+/**
+ * @brief Called from the reader task right before output stops being contiguous in the file:
+ *        the stream opened at a non-zero byte position, a seek was applied, or a chained file starts.
+ * @param el         Reader element
+ * @param uri        Path of the chained file now being read, or NULL for an open position / seek
+ * @param stream_pos Offset in the element's output stream (counted from open) of the discontinuity
+ * @param file_pos   Absolute offset in the file of the byte output at stream_pos
+ * @param ctx        User context given to sd_track_reader_set_chain_cb()
+ */
+typedef void (*sd_track_reader_switch_cb_t)(audio_element_handle_t el, const char *uri, uint64_t stream_pos,
+                                            int64_t file_pos, void *ctx);
+
+/**
+ * @brief Configuration structure for the SD track reader.
+ */
+typedef struct {
+    int     buf_sz;         /*!< Size of the read buffer. */
+    int     out_rb_size;    /*!< Size of the output ring buffer. */
+    int     task_stack;     /*!< Stack size for the reader task. */
+    int     task_prio;      /*!< Priority for the reader task. */
+    int     task_core;      /*!< CPU core for the reader task to run on. */
+    bool    stack_in_ext;   /*!< Whether to allocate the task stack in external memory. */
+    int     prefetch_size;  /*!< Bytes of the next file read ahead into PSRAM before the current one ends. 0 disables chaining. */
+    bool    decrypt;        /*!< XOR-decrypt data as it is read (replaces a separate xor_decrypt_filter element). */
+} sd_track_reader_cfg_t;
+
+/**
+ * @brief Default configuration for the SD track reader.
+ */
+#define SD_TRACK_READER_CFG_DEFAULT() {                             \
+    .buf_sz = 2048,                                                 \
+    .out_rb_size = 8 * 1024,                                        \
+    .task_stack = 4 * 1024,                                         \
+    .task_prio  = 4,                                                \
+    .task_core  = 0,                                                \
+    .stack_in_ext  = true,                                          \
+    .prefetch_size = 32 * 1024,                                     \
+    .decrypt       = false,                                         \
+}
+
+/**
+ * @brief Initializes and creates an SD track reader audio element.
+ *
+ * Behaves like fatfs_stream in reader mode (the URI is the file path, info.byte_pos is honoured
+ * on open), and can additionally chain straight into the next file without ending the stream
+ * so the downstream decoder never drains at a track boundary. When chaining, only audio crosses
+ * the boundary: a chained file starts after its ID3v2 tag, and every file stops before trailing
+ * ID3v1 and APEv2 tags.
+ *
+ * @param config Pointer to the `sd_track_reader_cfg_t` structure.
+ * @return `audio_element_handle_t` on success, or NULL on failure.
+ */
+audio_element_handle_t sd_track_reader_init(const sd_track_reader_cfg_t *config);
+
+/**
+ * @brief Install the callbacks used to chain files back-to-back.
+ *
+ * @param el        Reader element
+ * @param next_cb   Asked for the next file once the current one is within prefetch_size of its end
+ * @param switch_cb Notified on every discontinuity: open position, seek, chained file (may be NULL)
+ * @param ctx       User context passed to both callbacks
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if el is not a track reader
+ */
+esp_err_t sd_track_reader_set_chain_cb(audio_element_handle_t el,
+                                       sd_track_reader_next_cb_t next_cb,
+                                       sd_track_reader_switch_cb_t switch_cb,
+                                       void *ctx);
+
+/**
+ * @brief Seek to an absolute byte position in the current file.
+ *
+ * Before the element runs this only sets the position open() starts from; while running the
+ * seek is applied by the reader task before its next read. Either way switch_cb is notified.
+ *
+ * @param el       Reader element
+ * @param file_pos Byte offset in the current file
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a bad handle or negative position
+ */
+esp_err_t sd_track_reader_seek(audio_element_handle_t el, int64_t file_pos);
+
+/**
+ * @brief Enable or disable in-place XOR decryption of the data read.
+ *
+ * The key is applied by absolute file offset, so seeks and chained files need no extra
+ * handling. Takes effect from the next open; call it while the element is stopped.
+ *
+ * @param el      Reader element
+ * @param decrypt true to decrypt, false to pass data through
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if el is not a track reader
+ */
+esp_err_t sd_track_reader_set_decrypt(audio_element_handle_t el, bool decrypt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SD_TRACK_READER_H
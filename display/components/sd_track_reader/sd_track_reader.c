@@ -0,0 +1,548 @@
+#include "sd_track_reader.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <string.h>   // for memcpy
+#include <stdlib.h>   // for calloc, free
+#include <sys/stat.h>
+#include "audio_element.h"
+#include "xor_decrypt_filter.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "SD_TRACK_READER";
+
+#define ID3V2_HEADER_LEN    10
+#define ID3V1_TAG_LEN       128
+#define APE_FOOTER_LEN      32
+
+/**
+ * @brief Structure to store private data for the SD track reader.
+ */
+typedef struct {
+    FILE     *file;            /*!< File currently being read. */
+    int64_t   file_pos;        /*!< Read position inside the current file. */
+    int64_t   data_end;        /*!< End of the audio in the current file, before any trailing tags (-1: file end). */
+    uint64_t  stream_pos;      /*!< Bytes output since open, across chained files. */
+    int       prefetch_size;   /*!< Size of head_buf. */
+    bool      decrypt;         /*!< XOR-decrypt output by file offset. */
+
+    uint8_t  *head_buf;        /*!< Prefetched head of a chained file (PSRAM, allocated once). */
+    int       head_len;        /*!< Valid bytes in head_buf for the current file. */
+    int       head_off;        /*!< Bytes of head_buf already output. */
+
+    FILE     *next_file;       /*!< Pre-opened next file, positioned after its prefetched head. */
+    char     *next_uri;        /*!< Path of next_file (owned). */
+    int64_t   next_total;      /*!< Size of next_file. */
+    int64_t   next_data_end;   /*!< data_end of next_file. */
+    int64_t   next_start;      /*!< First audio byte of next_file, past its ID3v2 header. */
+    int       next_head_len;   /*!< Bytes of next_file already sitting in head_buf. */
+    bool      next_requested;  /*!< next_cb was already asked during the current file. */
+
+    int64_t   seek_pos;        /*!< Seek requested while running, applied on the next read (-1: none). */
+    portMUX_TYPE lock;         /*!< Protects seek_pos. */
+
+    sd_track_reader_next_cb_t   next_cb;
+    sd_track_reader_switch_cb_t switch_cb;
+    void                       *cb_ctx;
+} sd_track_reader_t;
+
+/**
+ * @brief Drop the pre-opened next file, if any.
+ */
+static void _release_next(sd_track_reader_t *reader)
+{
+    if (reader->next_file) {
+        fclose(reader->next_file);
+        reader->next_file = NULL;
+    }
+    if (reader->next_uri) {
+        free(reader->next_uri);
+        reader->next_uri = NULL;
+    }
+    reader->next_total = 0;
+    reader->next_data_end = -1;
+    reader->next_start = 0;
+    reader->next_head_len = 0;
+}
+
+/**
+ * @brief Size of the ID3v2 tag at the start of a file, header and footer included.
+ * A chained file's tag would reach the decoder mid-stream, where it is taken for corrupt frames.
+ * @param head First bytes of the file, as read (still encrypted when decrypt is set)
+ * @return Bytes to skip, 0 if there is no tag
+ */
+static int64_t _id3v2_tag_size(const sd_track_reader_t *reader, const uint8_t *head, int head_len)
+{
+    if (head_len < ID3V2_HEADER_LEN) {
+        return 0;
+    }
+    uint8_t hdr[ID3V2_HEADER_LEN];
+    memcpy(hdr, head, sizeof(hdr));
+    if (reader->decrypt) {
+        xor_decrypt_buffer(hdr, sizeof(hdr), 0);
+    }
+    if (memcmp(hdr, "ID3", 3) != 0 || hdr[3] == 0xff || hdr[4] == 0xff ||
+        ((hdr[6] | hdr[7] | hdr[8] | hdr[9]) & 0x80)) {
+        return 0;
+    }
+    // Syncsafe size: 7 bits per byte, excluding the header and the optional footer
+    int64_t size = ((int64_t)hdr[6] << 21) | (hdr[7] << 14) | (hdr[8] << 7) | hdr[9];
+    size += ID3V2_HEADER_LEN;
+    if (hdr[5] & 0x10) {
+        size += ID3V2_HEADER_LEN;
+    }
+    return size;
+}
+
+/**
+ * @brief Read and decrypt len bytes at an absolute file offset.
+ */
+static bool _read_at(const sd_track_reader_t *reader, FILE *file, int64_t pos, uint8_t *buf, int len)
+{
+    if (pos < 0 || fseek(file, pos, SEEK_SET) != 0 || fread(buf, 1, len, file) != (size_t)len) {
+        return false;
+    }
+    if (reader->decrypt) {
+        xor_decrypt_buffer(buf, len, (uint64_t)pos);
+    }
+    return true;
+}
+
+/**
+ * @brief Where the audio of a file ends: before a trailing ID3v1 "TAG" block and an APEv2 tag.
+ * Leaves the file position at an unspecified offset; callers seek afterwards.
+ * @return Offset of the first tag byte, -1 if the audio runs to the end of the file
+ */
+static int64_t _audio_data_end(const sd_track_reader_t *reader, FILE *file, int64_t total)
+{
+    int64_t end = total;
+    uint8_t buf[APE_FOOTER_LEN];
+    if (_read_at(reader, file, end - ID3V1_TAG_LEN, buf, 3) && memcmp(buf, "TAG", 3) == 0) {
+        end -= ID3V1_TAG_LEN;
+    }
+    if (_read_at(reader, file, end - APE_FOOTER_LEN, buf, APE_FOOTER_LEN) && memcmp(buf, "APETAGEX", 8) == 0) {
+        // Footer size covers the items and the footer; bit 31 of the flags adds a 32-byte header
+        uint32_t size = buf[12] | (buf[13] << 8) | (buf[14] << 16) | ((uint32_t)buf[15] << 24);
+        uint32_t flags = buf[20] | (buf[21] << 8) | (buf[22] << 16) | ((uint32_t)buf[23] << 24);
+        int64_t ape_len = (int64_t)size + ((flags & 0x80000000u) ? APE_FOOTER_LEN : 0);
+        if (size >= APE_FOOTER_LEN && ape_len <= end) {
+            end -= ape_len;
+        }
+    }
+    return end < total ? end : -1;
+}
+
+/**
+ * @brief Ask for, open and prefetch the next file once the current one is nearly consumed.
+ * The head buffer is only reused after the current file's own head has been fully output.
+ */
+static void _prepare_next(audio_element_handle_t self, sd_track_reader_t *reader, int64_t total_bytes)
+{
+    if (!reader->next_cb || reader->next_requested || !reader->head_buf) {
+        return;
+    }
+    if (reader->head_off < reader->head_len && (reader->data_end < 0 || reader->head_off < reader->data_end)) {
+        return;
+    }
+    if (total_bytes <= 0 || total_bytes - reader->file_pos > reader->prefetch_size) {
+        return;
+    }
+
+    reader->next_requested = true;
+
+    char *uri = reader->next_cb(self, reader->cb_ctx);
+    if (uri == NULL) {
+        ESP_LOGD(TAG, "No next file - stream will end with the current one");
+        return;
+    }
+
+    FILE *next = fopen(uri, "rb");
+    if (next == NULL) {
+        ESP_LOGW(TAG, "Failed to pre-open next file: %s", uri);
+        free(uri);
+        return;
+    }
+
+    struct stat st;
+    int64_t next_total = (stat(uri, &st) == 0) ? (int64_t)st.st_size : 0;
+
+    int head = fread(reader->head_buf, 1, reader->prefetch_size, next);
+    if (head <= 0) {
+        ESP_LOGW(TAG, "Next file is empty: %s", uri);
+        fclose(next);
+        free(uri);
+        return;
+    }
+
+    // Only the audio goes downstream: the decoder would meet both tags mid-stream
+    int64_t start = _id3v2_tag_size(reader, reader->head_buf, head);
+    int64_t data_end = _audio_data_end(reader, next, next_total);
+    if ((next_total > 0 && start >= next_total) ||
+        fseek(next, start > head ? start : head, SEEK_SET) != 0) {
+        ESP_LOGW(TAG, "No audio after the tags of next file: %s", uri);
+        fclose(next);
+        free(uri);
+        return;
+    }
+
+    reader->next_file = next;
+    reader->next_uri = uri;
+    reader->next_total = next_total;
+    reader->next_data_end = data_end;
+    reader->next_start = start;
+    reader->next_head_len = head;
+    ESP_LOGI(TAG, "Pre-opened next file (%d bytes prefetched, audio %lld..%lld): %s",
+             head, start, data_end >= 0 ? data_end : next_total, uri);
+}
+
+/**
+ * @brief Continue the stream with the pre-opened next file.
+ * @return ESP_OK if a file was chained, ESP_FAIL if the stream should end.
+ */
+static esp_err_t _switch_to_next(audio_element_handle_t self, sd_track_reader_t *reader)
+{
+    if (reader->next_file == NULL) {
+        return ESP_FAIL;
+    }
+
+    fclose(reader->file);
+    reader->file = reader->next_file;
+    reader->next_file = NULL;
+    reader->head_len = reader->next_head_len;
+    // Output starts after the ID3v2 tag, inside head_buf or already seeked past it
+    reader->head_off = reader->next_start < reader->head_len ? (int)reader->next_start : reader->head_len;
+    reader->file_pos = reader->next_start;
+    reader->data_end = reader->next_data_end;
+    reader->next_requested = false;
+
+    // set_uri before getinfo: setinfo copies the uri pointer as well
+    audio_element_set_uri(self, reader->next_uri);
+    audio_element_info_t info = {0};
+    audio_element_getinfo(self, &info);
+    info.byte_pos = reader->next_start;
+    info.total_bytes = reader->next_total;
+    audio_element_setinfo(self, &info);
+
+    ESP_LOGI(TAG, "Chained to next file at stream offset %llu: %s", reader->stream_pos, reader->next_uri);
+    if (reader->switch_cb) {
+        reader->switch_cb(self, reader->next_uri, reader->stream_pos, reader->next_start, reader->cb_ctx);
+    }
+
+    free(reader->next_uri);
+    reader->next_uri = NULL;
+    reader->next_total = 0;
+    reader->next_data_end = -1;
+    reader->next_start = 0;
+    reader->next_head_len = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Apply a seek requested while running.
+ * A seek cancels any prepared next file; it is requested again near the new end.
+ */
+static void _apply_pending_seek(audio_element_handle_t self, sd_track_reader_t *reader)
+{
+    int64_t pos;
+    portENTER_CRITICAL(&reader->lock);
+    pos = reader->seek_pos;
+    reader->seek_pos = -1;
+    portEXIT_CRITICAL(&reader->lock);
+
+    if (pos < 0) {
+        return;
+    }
+
+    if (fseek(reader->file, pos, SEEK_SET) != 0) {
+        ESP_LOGE(TAG, "Failed to seek to %lld", pos);
+        return;
+    }
+
+    _release_next(reader);
+    reader->next_requested = false;
+    reader->head_len = 0;
+    reader->head_off = 0;
+    reader->file_pos = pos;
+
+    audio_element_info_t info = {0};
+    audio_element_getinfo(self, &info);
+    info.byte_pos = pos;
+    audio_element_setinfo(self, &info);
+
+    ESP_LOGI(TAG, "Seeked to %lld at stream offset %llu", pos, reader->stream_pos);
+    if (reader->switch_cb) {
+        reader->switch_cb(self, NULL, reader->stream_pos, pos, reader->cb_ctx);
+    }
+}
+
+/**
+ * @brief Audio element 'open' callback function.
+ */
+static esp_err_t _sd_track_reader_open(audio_element_handle_t self)
+{
+    sd_track_reader_t *reader = (sd_track_reader_t *)audio_element_getdata(self);
+    if (!reader) {
+        ESP_LOGE(TAG, "Private data is NULL in open function.");
+        return ESP_FAIL;
+    }
+    if (reader->file) {
+        ESP_LOGW(TAG, "Already opened");
+        return ESP_OK;
+    }
+
+    char *uri = audio_element_get_uri(self);
+    if (uri == NULL) {
+        ESP_LOGE(TAG, "Error, uri is not set");
+        return ESP_FAIL;
+    }
+
+    reader->file = fopen(uri, "rb");
+    if (reader->file == NULL) {
+        ESP_LOGE(TAG, "Failed to open file: %s", uri);
+        return ESP_FAIL;
+    }
+
+    audio_element_info_t info = {0};
+    audio_element_getinfo(self, &info);
+    struct stat st;
+    if (stat(uri, &st) == 0) {
+        info.total_bytes = st.st_size;
+    }
+    // The first file's ID3v2 tag is at stream start, where the decoder expects one; an ID3v1
+    // trailer would run into the chained file
+    reader->data_end = reader->next_cb ? _audio_data_end(reader, reader->file, info.total_bytes) : -1;
+    if (info.byte_pos > 0 || reader->next_cb) {
+        if (fseek(reader->file, info.byte_pos, SEEK_SET) != 0) {
+            ESP_LOGE(TAG, "Failed to seek to %lld in %s", info.byte_pos, uri);
+            fclose(reader->file);
+            reader->file = NULL;
+            return ESP_FAIL;
+        }
+    }
+
+    reader->file_pos = info.byte_pos;
+    reader->stream_pos = 0;
+    reader->head_len = 0;
+    reader->head_off = 0;
+    reader->next_requested = false;
+    portENTER_CRITICAL(&reader->lock);
+    reader->seek_pos = -1;
+    portEXIT_CRITICAL(&reader->lock);
+
+    // Output starts mid-file: downstream position-dependent filters need to know
+    if (info.byte_pos > 0 && reader->switch_cb) {
+        reader->switch_cb(self, NULL, 0, info.byte_pos, reader->cb_ctx);
+    }
+
+    // Prefetch buffer is allocated once and kept for the element's lifetime
+    if (reader->next_cb && reader->prefetch_size > 0 && reader->head_buf == NULL) {
+        reader->head_buf = heap_caps_malloc(reader->prefetch_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (reader->head_buf == NULL) {
+            ESP_LOGW(TAG, "Failed to allocate %d byte prefetch buffer - chaining disabled", reader->prefetch_size);
+        }
+    }
+
+    ESP_LOGI(TAG, "Opened %s (size %lld, pos %lld)", uri, info.total_bytes, info.byte_pos);
+    return audio_element_setinfo(self, &info);
+}
+
+/**
+ * @brief Audio element 'read' callback function.
+ * Serves the prefetched head of a chained file first, then reads from SD.
+ */
+static int _sd_track_reader_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    sd_track_reader_t *reader = (sd_track_reader_t *)audio_element_getdata(self);
+    int rlen = 0;
+
+    _apply_pending_seek(self, reader);
+
+    // Trailing tags are not passed on: the next chained file follows the last audio byte
+    int want = len;
+    if (reader->data_end >= 0 && reader->file_pos + want > reader->data_end) {
+        want = reader->file_pos < reader->data_end ? (int)(reader->data_end - reader->file_pos) : 0;
+    }
+
+    if (want > 0 && reader->head_off < reader->head_len) {
+        rlen = reader->head_len - reader->head_off;
+        if (rlen > want) {
+            rlen = want;
+        }
+        memcpy(buffer, reader->head_buf + reader->head_off, rlen);
+        reader->head_off += rlen;
+    } else {
+        rlen = want > 0 ? fread(buffer, 1, want, reader->file) : 0;
+        if (rlen <= 0) {
+            if (_switch_to_next(self, reader) == ESP_OK) {
+                return _sd_track_reader_read(self, buffer, len, ticks_to_wait, context);
+            }
+            ESP_LOGW(TAG, "No more data, ret:%d", rlen);
+            return 0;
+        }
+    }
+
+    // head_buf keeps ciphertext; decrypt the copy handed downstream
+    if (reader->decrypt) {
+        xor_decrypt_buffer((uint8_t *)buffer, rlen, (uint64_t)reader->file_pos);
+    }
+
+    reader->file_pos += rlen;
+    reader->stream_pos += rlen;
+    audio_element_update_byte_pos(self, rlen);
+
+    audio_element_info_t info = {0};
+    audio_element_getinfo(self, &info);
+    _prepare_next(self, reader, info.total_bytes);
+
+    return rlen;
+}
+
+/**
+ * @brief Audio element 'process' callback function.
+ */
+static int _sd_track_reader_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    int w_size = 0;
+    if (r_size > 0) {
+        w_size = audio_element_output(self, in_buffer, r_size);
+    } else {
+        w_size = r_size;
+    }
+    return w_size;
+}
+
+/**
+ * @brief Audio element 'close' callback function.
+ */
+static esp_err_t _sd_track_reader_close(audio_element_handle_t self)
+{
+    sd_track_reader_t *reader = (sd_track_reader_t *)audio_element_getdata(self);
+
+    // Keep the byte position across pause, reset it for a real stop (same as fatfs_stream)
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_info_t info = {0};
+        audio_element_getinfo(self, &info);
+        info.byte_pos = 0;
+        audio_element_setinfo(self, &info);
+    }
+
+    if (reader->file) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+    _release_next(reader);
+    reader->head_len = 0;
+    reader->head_off = 0;
+    reader->next_requested = false;
+    return ESP_OK;
+}
+
+/**
+ * @brief Audio element 'destroy' callback function.
+ */
+static esp_err_t _sd_track_reader_destroy(audio_element_handle_t self)
+{
+    sd_track_reader_t *reader = (sd_track_reader_t *)audio_element_getdata(self);
+    if (reader) {
+        if (reader->file) {
+            fclose(reader->file);
+        }
+        _release_next(reader);
+        if (reader->head_buf) {
+            heap_caps_free(reader->head_buf);
+        }
+        free(reader);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Initializes and creates an SD track reader audio element.
+ */
+audio_element_handle_t sd_track_reader_init(const sd_track_reader_cfg_t *config)
+{
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Invalid config for SD track reader. Config pointer is NULL.");
+        return NULL;
+    }
+
+    sd_track_reader_t *reader = (sd_track_reader_t *)calloc(1, sizeof(sd_track_reader_t));
+    if (reader == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate private data for SD track reader");
+        return NULL;
+    }
+    reader->prefetch_size = config->prefetch_size;
+    reader->decrypt = config->decrypt;
+    reader->seek_pos = -1;
+    portMUX_INITIALIZE(&reader->lock);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.tag = "file";
+    cfg.open = _sd_track_reader_open;
+    cfg.close = _sd_track_reader_close;
+    cfg.process = _sd_track_reader_process;
+    cfg.destroy = _sd_track_reader_destroy;
+    cfg.read = _sd_track_reader_read;
+    cfg.buffer_len = config->buf_sz;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+
+    audio_element_handle_t el = audio_element_init(&cfg);
+    if (el == NULL) {
+        ESP_LOGE(TAG, "Failed to create SD track reader audio element");
+        free(reader);
+        return NULL;
+    }
+
+    audio_element_setdata(el, reader);
+    ESP_LOGI(TAG, "SD Track Reader Initialized Successfully");
+    return el;
+}
+
+esp_err_t sd_track_reader_set_chain_cb(audio_element_handle_t el,
+                                       sd_track_reader_next_cb_t next_cb,
+                                       sd_track_reader_switch_cb_t switch_cb,
+                                       void *ctx)
+{
+    sd_track_reader_t *reader = el ? (sd_track_reader_t *)audio_element_getdata(el) : NULL;
+    if (reader == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    reader->next_cb = next_cb;
+    reader->switch_cb = switch_cb;
+    reader->cb_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t sd_track_reader_seek(audio_element_handle_t el, int64_t file_pos)
+{
+    sd_track_reader_t *reader = el ? (sd_track_reader_t *)audio_element_getdata(el) : NULL;
+    if (reader == NULL || file_pos < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (reader->file == NULL) {
+        // Not running: open() starts from byte_pos and reports it
+        return audio_element_set_byte_pos(el, file_pos);
+    }
+
+    portENTER_CRITICAL(&reader->lock);
+    reader->seek_pos = file_pos;
+    portEXIT_CRITICAL(&reader->lock);
+    return ESP_OK;
+}
+
+esp_err_t sd_track_reader_set_decrypt(audio_element_handle_t el, bool decrypt)
+{
+    sd_track_reader_t *reader = el ? (sd_track_reader_t *)audio_element_getdata(el) : NULL;
+    if (reader == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    reader->decrypt = decrypt;
+    return ESP_OK;
+}
@@ -0,0 +1,191 @@
+#ifndef SFX_MIXER_H
+#define SFX_MIXER_H
+
+#include "audio_element.h" // Includes basic definitions for ESP-ADF audio elements
+#include "audio_common.h"  // Includes common ESP-ADF definitions
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called by the mixer once it no longer references a clip's PCM buffer.
+ * May run on the mixer task or on the task calling sfx_mixer_play().
+ */
+typedef void (*sfx_mixer_release_cb_t)(const int16_t *pcm, void *ctx);
+
+/**
+ * @brief Called from the mixer task once the prefill watermark is buffered (or the stream ended
+ * first), right before the held audio is passed to the sink.
+ * @param filled Bytes buffered when the gate opened (0 if prefill could not be set up).
+ */
+typedef void (*sfx_mixer_prefill_cb_t)(audio_element_handle_t el, int filled, void *ctx);
+
+/**
+ * @brief A decoded sound effect to overlay on the stream (16-bit interleaved PCM).
+ */
+typedef struct {
+    const int16_t          *pcm;         /*!< Interleaved 16-bit samples. Must stay valid until release is called. */
+    size_t                  frames;      /*!< Number of frames (samples per channel). */
+    int                     sample_rate; /*!< Clip sample rate, resampled to the stream rate while mixing. */
+    int                     channels;    /*!< 1 or 2. */
+    sfx_mixer_release_cb_t  release;     /*!< Optional, called when the mixer is done with pcm. */
+    void                   *release_ctx; /*!< Passed to release. */
+} sfx_mixer_clip_t;
+
+/**
+ * @brief Configuration structure for the sound effect mixer.
+ */
+typedef struct {
+    int     buf_size;     /*!< Size of the processing buffer in bytes. */
+    int     out_rb_size;  /*!< Size of the output ring buffer. */
+    int     task_stack;   /*!< Stack size for the mixer task. */
+    int     task_prio;    /*!< Priority for the mixer task. */
+    int     task_core;    /*!< CPU core for the mixer task to run on. */
+    bool    stack_in_ext; /*!< Whether to allocate the task stack in external memory. */
+    int     duck_percent; /*!< Music level while an effect plays, in percent of normal. */
+    int     fade_ms;      /*!< Duration of the duck/unduck ramp. */
+} sfx_mixer_cfg_t;
+
+/**
+ * @brief Default configuration for the sound effect mixer.
+ */
+#define DEFAULT_SFX_MIXER_CONFIG() {                                \
+    .buf_size = 2048,                                               \
+    .out_rb_size = 8 * 1024,                                        \
+    .task_stack = 3 * 1024,                                         \
+    .task_prio  = 5,                                                \
+    .task_core  = 0,                                                \
+    .stack_in_ext  = true,                                          \
+    .duck_percent = 35,                                             \
+    .fade_ms = 30,                                                  \
+}
+
+/**
+ * @brief Initializes and creates a sound effect mixer audio element.
+ *
+ * The element passes 16-bit PCM through unchanged until a clip is queued with
+ * sfx_mixer_play(), then ducks the stream and adds the clip on top of it.
+ *
+ * @param config Pointer to the `sfx_mixer_cfg_t` structure.
+ * @return `audio_element_handle_t` on success, or NULL on failure.
+ */
+audio_element_handle_t sfx_mixer_init(const sfx_mixer_cfg_t *config);
+
+/**
+ * @brief Sets the format of the PCM stream passing through the mixer.
+ *
+ * Safe to call from any task: the mixer task applies it between blocks.
+ *
+ * @param el          Mixer element.
+ * @param sample_rate Stream sample rate in Hz.
+ * @param channels    Stream channel count (1 or 2).
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise.
+ */
+esp_err_t sfx_mixer_set_stream_info(audio_element_handle_t el, int sample_rate, int channels);
+
+/**
+ * @brief Makes the mixer follow the format reported in another element's info (the decoder).
+ *
+ * The mixer task reads source's info before each block, so the format (and the prefill
+ * watermark) tracks the decoded stream without any call from the player task.
+ * Call before the pipeline runs.
+ *
+ * @param el     Mixer element.
+ * @param source Element upstream of the mixer, or NULL to stop following it.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise.
+ */
+esp_err_t sfx_mixer_set_stream_source(audio_element_handle_t el, audio_element_handle_t source);
+
+/**
+ * @brief Holds the stream back at the start of every run until prefill_ms of audio is buffered.
+ *
+ * The sink receives nothing until the watermark is reached, then gets the buffered audio in one
+ * go and cb is notified, so the caller can wait on an event instead of polling ring buffers.
+ * The size in bytes follows the stream format (see sfx_mixer_set_stream_source()). Applies
+ * from the next open.
+ *
+ * @param el         Mixer element.
+ * @param prefill_ms Watermark in milliseconds of audio, 0 to disable (cb then fires at open).
+ * @param cb         Notified from the mixer task when the gate opens (may be NULL).
+ * @param ctx        Passed to cb.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise.
+ */
+esp_err_t sfx_mixer_set_prefill(audio_element_handle_t el, int prefill_ms, sfx_mixer_prefill_cb_t cb, void *ctx);
+
+/**
+ * @brief Queues a clip to be mixed over the stream, replacing any clip still playing.
+ *
+ * @param el   Mixer element.
+ * @param clip Clip description; copied, but clip->pcm must stay valid until clip->release is called.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a bad handle or clip.
+ */
+esp_err_t sfx_mixer_play(audio_element_handle_t el, const sfx_mixer_clip_t *clip);
+
+/**
+ * @brief Checks whether a clip is queued or still being mixed.
+ */
+bool sfx_mixer_is_active(audio_element_handle_t el);
+
+/**
+ * @brief Configuration structure for the in-memory clip reader.
+ */
+typedef struct {
+    int     buf_size;     /*!< Bytes handed downstream per read. */
+    int     out_rb_size;  /*!< Size of the output ring buffer. */
+    int     task_stack;   /*!< Stack size for the reader task. */
+    int     task_prio;    /*!< Priority for the reader task. */
+    int     task_core;    /*!< CPU core for the reader task to run on. */
+    bool    stack_in_ext; /*!< Whether to allocate the task stack in external memory. */
+} sfx_clip_reader_cfg_t;
+
+/**
+ * @brief Default configuration for the in-memory clip reader.
+ */
+#define DEFAULT_SFX_CLIP_READER_CONFIG() {                          \
+    .buf_size = 2048,                                               \
+    .out_rb_size = 8 * 1024,                                        \
+    .task_stack = 3 * 1024,                                         \
+    .task_prio  = 5,                                                \
+    .task_core  = 0,                                                \
+    .stack_in_ext  = true,                                          \
+}
+
+/**
+ * @brief Initializes an audio element that streams a decoded clip from memory.
+ *
+ * Used as the first element of a pipeline to send cached PCM straight to a sink,
+ * with no file access or decoding. The element finishes at the end of the clip.
+ *
+ * @param config Pointer to the `sfx_clip_reader_cfg_t` structure.
+ * @return `audio_element_handle_t` on success, or NULL on failure.
+ */
+audio_element_handle_t sfx_clip_reader_init(const sfx_clip_reader_cfg_t *config);
+
+/**
+ * @brief Sets the clip to stream on the next run, releasing any previous clip.
+ *
+ * @param el   Clip reader element.
+ * @param clip Clip description; clip->pcm must stay valid until clip->release is called.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a bad handle or clip.
+ */
+esp_err_t sfx_clip_reader_set_clip(audio_element_handle_t el, const sfx_mixer_clip_t *clip);
+
+/**
+ * @brief Converts a clip to another sample rate / channel count (linear interpolation).
+ *
+ * @param in           Source clip.
+ * @param sample_rate  Target sample rate in Hz.
+ * @param channels     Target channel count (1 or 2).
+ * @param out_frames   Receives the number of frames in the returned buffer.
+ * @return PSRAM buffer to free with heap_caps_free(), or NULL on failure.
+ */
+int16_t *sfx_mixer_convert_clip(const sfx_mixer_clip_t *in, int sample_rate, int channels, size_t *out_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SFX_MIXER_H
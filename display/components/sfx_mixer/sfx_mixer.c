@@ -0,0 +1,704 @@
+#include "sfx_mixer.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h> // for memset
+#include <stdlib.h> // for calloc, free
+#include "audio_element.h" // for AEL_IO_ABORT constant
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "SFX_MIXER";
+
+#define SFX_MIXER_UNITY_GAIN   (32768)   // Q15 gain of 1.0
+
+/**
+ * @brief Structure to store private data for the sound effect mixer.
+ */
+typedef struct {
+    char     *buffer;          /*!< Processing buffer, allocated in open. */
+    int       buf_size;        /*!< Size of buffer in bytes. */
+
+    int       stream_rate;     /*!< Sample rate of the PCM stream passing through (mixer task only). */
+    int       stream_channels; /*!< Channel count of the PCM stream passing through (mixer task only). */
+    audio_element_handle_t source; /*!< Element whose info gives the stream format, or NULL. */
+
+    int32_t   duck_gain;       /*!< Q15 music gain while a clip plays. */
+    int32_t   gain;            /*!< Current Q15 music gain (ramps towards duck_gain / unity). */
+    int32_t   gain_step;       /*!< Q15 gain change per frame during a ramp. */
+    int       fade_ms;
+
+    sfx_mixer_clip_t clip;     /*!< Clip being mixed (owned by the mixer task). */
+    bool      clip_active;
+    uint64_t  clip_pos;        /*!< Read position in the clip, 16.16 fixed point frames. */
+    uint64_t  clip_step;       /*!< Clip frames per stream frame, 16.16 fixed point. */
+
+    sfx_mixer_clip_t pending;  /*!< Clip queued by sfx_mixer_play(), picked up by the mixer task. */
+    bool      pending_valid;
+    int       pending_rate;    /*!< Stream format set by sfx_mixer_set_stream_info(), 0: none. */
+    int       pending_channels;
+    portMUX_TYPE lock;         /*!< Protects pending / pending_valid / pending_rate / pending_channels. */
+
+    int       prefill_ms;      /*!< Watermark armed by sfx_mixer_set_prefill(), 0: disabled. */
+    sfx_mixer_prefill_cb_t prefill_cb;
+    void     *prefill_ctx;
+    bool      prefill_active;  /*!< Holding output back until prefill_target bytes are buffered. */
+    int       prefill_target;  /*!< Watermark in bytes for the current run. */
+    int       prefill_len;     /*!< Bytes held in prefill_buf. */
+    int       prefill_cap;     /*!< Size of prefill_buf (PSRAM, kept for the element's lifetime). */
+    char     *prefill_buf;
+} sfx_mixer_priv_t;
+
+static void _release_clip(sfx_mixer_clip_t *clip)
+{
+    if (clip->release) {
+        clip->release(clip->pcm, clip->release_ctx);
+    }
+    memset(clip, 0, sizeof(*clip));
+}
+
+static inline int16_t _sat16(int32_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+/**
+ * @brief Linear-interpolated clip sample for one stream channel at the current position.
+ */
+static inline int32_t _clip_sample(const sfx_mixer_priv_t *priv, size_t idx, uint32_t frac, int out_ch)
+{
+    const sfx_mixer_clip_t *clip = &priv->clip;
+    size_t next = (idx + 1 < clip->frames) ? idx + 1 : idx;
+    int32_t s0, s1;
+
+    if (clip->channels == 1) {
+        s0 = clip->pcm[idx];
+        s1 = clip->pcm[next];
+    } else if (priv->stream_channels == 1) {
+        // Stereo clip on a mono stream: average both channels
+        s0 = (clip->pcm[idx * 2] + clip->pcm[idx * 2 + 1]) / 2;
+        s1 = (clip->pcm[next * 2] + clip->pcm[next * 2 + 1]) / 2;
+    } else {
+        s0 = clip->pcm[idx * 2 + out_ch];
+        s1 = clip->pcm[next * 2 + out_ch];
+    }
+    return s0 + (((s1 - s0) * (int32_t)frac) >> 16);
+}
+
+/**
+ * @brief Q16 clip step and per-frame duck ramp step for the current stream rate.
+ */
+static void _update_steps(sfx_mixer_priv_t *priv)
+{
+    if (priv->clip_active) {
+        priv->clip_step = ((uint64_t)priv->clip.sample_rate << 16) / (uint64_t)priv->stream_rate;
+    }
+
+    int fade_frames = (priv->stream_rate * priv->fade_ms) / 1000;
+    priv->gain_step = (fade_frames > 0) ? (SFX_MIXER_UNITY_GAIN - priv->duck_gain) / fade_frames : SFX_MIXER_UNITY_GAIN;
+    if (priv->gain_step <= 0) {
+        priv->gain_step = 1;
+    }
+}
+
+/**
+ * @brief Prefill watermark in bytes for the current stream format.
+ */
+static int _prefill_bytes(const sfx_mixer_priv_t *priv)
+{
+    int frame_bytes = priv->stream_channels * sizeof(int16_t);
+    return (int)(((int64_t)priv->stream_rate * priv->prefill_ms / 1000) * frame_bytes);
+}
+
+/**
+ * @brief Pick up the stream format on the mixer task, between blocks.
+ * A format handed over by sfx_mixer_set_stream_info() wins; otherwise it follows the source element.
+ */
+static void _sync_stream_info(sfx_mixer_priv_t *priv)
+{
+    int rate = 0;
+    int channels = 0;
+
+    portENTER_CRITICAL(&priv->lock);
+    if (priv->pending_rate > 0) {
+        rate = priv->pending_rate;
+        channels = priv->pending_channels;
+        priv->pending_rate = 0;
+        priv->pending_channels = 0;
+    }
+    portEXIT_CRITICAL(&priv->lock);
+
+    if (rate == 0 && priv->source) {
+        audio_element_info_t info = {0};
+        audio_element_getinfo(priv->source, &info);
+        rate = info.sample_rates;
+        channels = info.channels;
+    }
+
+    if (rate <= 0 || channels < 1 || channels > 2 ||
+        (rate == priv->stream_rate && channels == priv->stream_channels)) {
+        return;
+    }
+
+    ESP_LOGD(TAG, "Stream format %d Hz x%d -> %d Hz x%d", priv->stream_rate, priv->stream_channels, rate, channels);
+    priv->stream_rate = rate;
+    priv->stream_channels = channels;
+    _update_steps(priv);
+
+    if (priv->prefill_active) {
+        // Watermark was derived from a guessed format at open; keep it within the buffer
+        int target = _prefill_bytes(priv);
+        priv->prefill_target = (target + priv->buf_size <= priv->prefill_cap) ? target : priv->prefill_cap - priv->buf_size;
+    }
+}
+
+/**
+ * @brief Start mixing the pending clip, if sfx_mixer_play() queued one.
+ */
+static void _take_pending(sfx_mixer_priv_t *priv)
+{
+    sfx_mixer_clip_t next;
+    bool have_next = false;
+
+    portENTER_CRITICAL(&priv->lock);
+    if (priv->pending_valid) {
+        next = priv->pending;
+        priv->pending_valid = false;
+        have_next = true;
+    }
+    portEXIT_CRITICAL(&priv->lock);
+
+    if (!have_next) {
+        return;
+    }
+
+    if (priv->clip_active) {
+        _release_clip(&priv->clip);
+    }
+    priv->clip = next;
+    priv->clip_active = true;
+    priv->clip_pos = 0;
+    _update_steps(priv);
+    ESP_LOGD(TAG, "Mixing clip: %u frames @ %d Hz x%d over %d Hz x%d",
+             (unsigned int)next.frames, next.sample_rate, next.channels, priv->stream_rate, priv->stream_channels);
+}
+
+/**
+ * @brief Duck the stream and add the active clip on top of it, in place.
+ */
+static void _mix_block(sfx_mixer_priv_t *priv, int16_t *samples, int frames)
+{
+    int ch = priv->stream_channels;
+
+    for (int f = 0; f < frames; f++) {
+        // Ramp the music gain towards its target
+        int32_t target = priv->clip_active ? priv->duck_gain : SFX_MIXER_UNITY_GAIN;
+        if (priv->gain > target) {
+            priv->gain = (priv->gain - priv->gain_step > target) ? priv->gain - priv->gain_step : target;
+        } else if (priv->gain < target) {
+            priv->gain = (priv->gain + priv->gain_step < target) ? priv->gain + priv->gain_step : target;
+        }
+
+        int16_t *frame = samples + f * ch;
+        if (priv->gain != SFX_MIXER_UNITY_GAIN) {
+            for (int c = 0; c < ch; c++) {
+                frame[c] = (int16_t)(((int32_t)frame[c] * priv->gain) >> 15);
+            }
+        }
+
+        if (!priv->clip_active) {
+            continue;
+        }
+
+        size_t idx = (size_t)(priv->clip_pos >> 16);
+        if (idx >= priv->clip.frames) {
+            // Clip finished: release it and let the music ramp back up
+            _release_clip(&priv->clip);
+            priv->clip_active = false;
+            continue;
+        }
+
+        uint32_t frac = (uint32_t)(priv->clip_pos & 0xFFFF);
+        for (int c = 0; c < ch; c++) {
+            frame[c] = _sat16((int32_t)frame[c] + _clip_sample(priv, idx, frac, c));
+        }
+        priv->clip_pos += priv->clip_step;
+    }
+}
+
+/**
+ * @brief Watermark reached (or input ended first): notify, then hand the held audio downstream.
+ */
+static int _prefill_release(audio_element_handle_t self, sfx_mixer_priv_t *priv)
+{
+    priv->prefill_active = false;
+    ESP_LOGD(TAG, "Prefill released with %d/%d bytes", priv->prefill_len, priv->prefill_target);
+    if (priv->prefill_cb) {
+        priv->prefill_cb(self, priv->prefill_len, priv->prefill_ctx);
+    }
+
+    int len = priv->prefill_len;
+    priv->prefill_len = 0;
+    if (len <= 0) {
+        return 0;
+    }
+    return audio_element_output(self, priv->prefill_buf, len);
+}
+
+/**
+ * @brief Audio element 'open' callback function.
+ */
+static esp_err_t _sfx_mixer_open(audio_element_handle_t self)
+{
+    sfx_mixer_priv_t *priv = (sfx_mixer_priv_t *)audio_element_getdata(self);
+    if (!priv) {
+        ESP_LOGE(TAG, "Private data is NULL in open function.");
+        return ESP_FAIL;
+    }
+
+    if (priv->buffer == NULL) {
+        priv->buffer = (char *)malloc(priv->buf_size);
+        if (priv->buffer == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate buffer in open function");
+            return ESP_FAIL;
+        }
+    }
+
+    priv->gain = SFX_MIXER_UNITY_GAIN;
+    _sync_stream_info(priv);
+
+    // Arm the prefill gate: the sink sees nothing until the watermark is buffered. The source
+    // format may not be known yet, so size the buffer for the largest format (stereo) and let
+    // _sync_stream_info() correct the watermark once the first block arrives.
+    priv->prefill_active = false;
+    priv->prefill_len = 0;
+    if (priv->prefill_ms > 0) {
+        priv->prefill_target = _prefill_bytes(priv);
+        int max_rate = priv->stream_rate > 48000 ? priv->stream_rate : 48000;
+        int cap = (int)(((int64_t)max_rate * priv->prefill_ms / 1000) * 2 * sizeof(int16_t)) +
+                  priv->buf_size;  // Room for the read that crosses the watermark
+        if (priv->prefill_cap < cap) {
+            heap_caps_free(priv->prefill_buf);
+            priv->prefill_buf = heap_caps_malloc(cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            priv->prefill_cap = priv->prefill_buf ? cap : 0;
+        }
+        if (priv->prefill_buf) {
+            priv->prefill_active = true;
+        } else {
+            ESP_LOGW(TAG, "Failed to allocate %d byte prefill buffer - starting without prefill", cap);
+            if (priv->prefill_cb) {
+                priv->prefill_cb(self, 0, priv->prefill_ctx);
+            }
+        }
+    } else if (priv->prefill_cb) {
+        priv->prefill_cb(self, 0, priv->prefill_ctx);  // No gate: open for output right away
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Audio element 'close' callback function.
+ * Drops any clip still queued or playing; effects never outlive the stream they were mixed into.
+ */
+static esp_err_t _sfx_mixer_close(audio_element_handle_t self)
+{
+    sfx_mixer_priv_t *priv = (sfx_mixer_priv_t *)audio_element_getdata(self);
+    if (!priv) {
+        return ESP_OK;
+    }
+
+    if (priv->buffer) {
+        free(priv->buffer);
+        priv->buffer = NULL;
+    }
+
+    sfx_mixer_clip_t pending = {0};
+    bool had_pending = false;
+    portENTER_CRITICAL(&priv->lock);
+    if (priv->pending_valid) {
+        pending = priv->pending;
+        priv->pending_valid = false;
+        had_pending = true;
+    }
+    portEXIT_CRITICAL(&priv->lock);
+
+    if (had_pending) {
+        _release_clip(&pending);
+    }
+    if (priv->clip_active) {
+        _release_clip(&priv->clip);
+        priv->clip_active = false;
+    }
+    priv->gain = SFX_MIXER_UNITY_GAIN;
+    priv->prefill_active = false;
+    priv->prefill_len = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Audio element 'process' callback function.
+ */
+static int _sfx_mixer_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    sfx_mixer_priv_t *priv = (sfx_mixer_priv_t *)audio_element_getdata(self);
+    char *buffer = priv->buffer;
+
+    int r_size = audio_element_input(self, buffer, priv->buf_size);
+    int w_size = 0;
+
+    if (r_size <= 0 && priv->prefill_active) {
+        // Stream ended (or failed) below the watermark: still play what was buffered
+        int ret = _prefill_release(self, priv);
+        return ret < 0 ? ret : r_size;
+    }
+
+    if (r_size > 0) {
+        _sync_stream_info(priv);
+        _take_pending(priv);
+
+        // Pass-through costs nothing extra once the music gain is back at unity
+        if (priv->clip_active || priv->gain != SFX_MIXER_UNITY_GAIN) {
+            int frame_bytes = priv->stream_channels * sizeof(int16_t);
+            _mix_block(priv, (int16_t *)buffer, r_size / frame_bytes);
+        }
+
+        if (priv->prefill_active) {
+            memcpy(priv->prefill_buf + priv->prefill_len, buffer, r_size);
+            priv->prefill_len += r_size;
+            if (priv->prefill_len < priv->prefill_target) {
+                return r_size;
+            }
+            w_size = _prefill_release(self, priv);
+            return w_size < 0 ? w_size : r_size;
+        }
+
+        w_size = audio_element_output(self, buffer, r_size);
+        if (w_size < 0) {
+            if (w_size == AEL_IO_ABORT) {
+                ESP_LOGD(TAG, "Output aborted during pipeline shutdown: %d", w_size);
+            } else {
+                ESP_LOGE(TAG, "Error writing to output: %d", w_size);
+            }
+        }
+    } else {
+        w_size = r_size;
+    }
+
+    return w_size;
+}
+
+/**
+ * @brief Audio element 'destroy' callback function.
+ */
+static esp_err_t _sfx_mixer_destroy(audio_element_handle_t self)
+{
+    sfx_mixer_priv_t *priv = (sfx_mixer_priv_t *)audio_element_getdata(self);
+    if (priv) {
+        _sfx_mixer_close(self);
+        heap_caps_free(priv->prefill_buf);
+        free(priv);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Initializes and creates a sound effect mixer audio element.
+ */
+audio_element_handle_t sfx_mixer_init(const sfx_mixer_cfg_t *config)
+{
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Invalid config for sound effect mixer. Config pointer is NULL.");
+        return NULL;
+    }
+
+    sfx_mixer_priv_t *priv = (sfx_mixer_priv_t *)calloc(1, sizeof(sfx_mixer_priv_t));
+    if (priv == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate private data for sound effect mixer");
+        return NULL;
+    }
+    portMUX_INITIALIZE(&priv->lock);
+    priv->buf_size = config->buf_size;
+    priv->stream_rate = 44100;
+    priv->stream_channels = 2;
+    priv->duck_gain = (SFX_MIXER_UNITY_GAIN * config->duck_percent) / 100;
+    priv->gain = SFX_MIXER_UNITY_GAIN;
+    priv->fade_ms = config->fade_ms;
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.tag = "sfx_mixer";
+    cfg.open = _sfx_mixer_open;
+    cfg.close = _sfx_mixer_close;
+    cfg.process = _sfx_mixer_process;
+    cfg.destroy = _sfx_mixer_destroy;
+    cfg.buffer_len = config->buf_size;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+
+    audio_element_handle_t el = audio_element_init(&cfg);
+    if (el == NULL) {
+        ESP_LOGE(TAG, "Failed to create sound effect mixer audio element");
+        free(priv);
+        return NULL;
+    }
+
+    audio_element_setdata(el, priv);
+    ESP_LOGI(TAG, "Sound Effect Mixer Initialized Successfully (duck %d%%, fade %d ms)",
+             config->duck_percent, config->fade_ms);
+    return el;
+}
+
+esp_err_t sfx_mixer_set_stream_info(audio_element_handle_t el, int sample_rate, int channels)
+{
+    sfx_mixer_priv_t *priv = el ? (sfx_mixer_priv_t *)audio_element_getdata(el) : NULL;
+    if (priv == NULL || sample_rate <= 0 || channels < 1 || channels > 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Applied by the mixer task between blocks, never in the middle of one
+    portENTER_CRITICAL(&priv->lock);
+    priv->pending_rate = sample_rate;
+    priv->pending_channels = channels;
+    portEXIT_CRITICAL(&priv->lock);
+    return ESP_OK;
+}
+
+esp_err_t sfx_mixer_set_stream_source(audio_element_handle_t el, audio_element_handle_t source)
+{
+    sfx_mixer_priv_t *priv = el ? (sfx_mixer_priv_t *)audio_element_getdata(el) : NULL;
+    if (priv == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    priv->source = source;
+    return ESP_OK;
+}
+
+esp_err_t sfx_mixer_set_prefill(audio_element_handle_t el, int prefill_ms, sfx_mixer_prefill_cb_t cb, void *ctx)
+{
+    sfx_mixer_priv_t *priv = el ? (sfx_mixer_priv_t *)audio_element_getdata(el) : NULL;
+    if (priv == NULL || prefill_ms < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    priv->prefill_ms = prefill_ms;
+    priv->prefill_cb = cb;
+    priv->prefill_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t sfx_mixer_play(audio_element_handle_t el, const sfx_mixer_clip_t *clip)
+{
+    sfx_mixer_priv_t *priv = el ? (sfx_mixer_priv_t *)audio_element_getdata(el) : NULL;
+    if (priv == NULL || clip == NULL || clip->pcm == NULL || clip->frames == 0 ||
+        clip->sample_rate <= 0 || clip->channels < 1 || clip->channels > 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sfx_mixer_clip_t replaced = {0};
+    bool had_pending = false;
+
+    portENTER_CRITICAL(&priv->lock);
+    if (priv->pending_valid) {
+        replaced = priv->pending;
+        had_pending = true;
+    }
+    priv->pending = *clip;
+    priv->pending_valid = true;
+    portEXIT_CRITICAL(&priv->lock);
+
+    // A clip that never started mixing is released here, on the caller's task
+    if (had_pending) {
+        _release_clip(&replaced);
+    }
+    return ESP_OK;
+}
+
+bool sfx_mixer_is_active(audio_element_handle_t el)
+{
+    sfx_mixer_priv_t *priv = el ? (sfx_mixer_priv_t *)audio_element_getdata(el) : NULL;
+    if (priv == NULL) {
+        return false;
+    }
+    return priv->pending_valid || priv->clip_active;
+}
+
+/**
+ * @brief Private data for the in-memory clip reader.
+ */
+typedef struct {
+    sfx_mixer_clip_t clip;     /*!< Clip being streamed. */
+    bool      clip_valid;
+    size_t    byte_pos;        /*!< Bytes of the clip already output. */
+} sfx_clip_reader_priv_t;
+
+static esp_err_t _sfx_clip_reader_open(audio_element_handle_t self)
+{
+    sfx_clip_reader_priv_t *priv = (sfx_clip_reader_priv_t *)audio_element_getdata(self);
+    if (!priv || !priv->clip_valid) {
+        ESP_LOGE(TAG, "Clip reader opened without a clip");
+        return ESP_FAIL;
+    }
+
+    priv->byte_pos = 0;
+    audio_element_info_t info = {0};
+    audio_element_getinfo(self, &info);
+    info.sample_rates = priv->clip.sample_rate;
+    info.channels = priv->clip.channels;
+    info.bits = 16;
+    info.byte_pos = 0;
+    info.total_bytes = priv->clip.frames * priv->clip.channels * sizeof(int16_t);
+    return audio_element_setinfo(self, &info);
+}
+
+static int _sfx_clip_reader_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    sfx_clip_reader_priv_t *priv = (sfx_clip_reader_priv_t *)audio_element_getdata(self);
+    size_t total = priv->clip.frames * priv->clip.channels * sizeof(int16_t);
+
+    if (priv->byte_pos >= total) {
+        return 0;  // End of clip
+    }
+
+    size_t rlen = total - priv->byte_pos;
+    if (rlen > (size_t)len) {
+        rlen = len;
+    }
+    memcpy(buffer, (const uint8_t *)priv->clip.pcm + priv->byte_pos, rlen);
+    priv->byte_pos += rlen;
+    audio_element_update_byte_pos(self, rlen);
+    return (int)rlen;
+}
+
+static int _sfx_clip_reader_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    int w_size = 0;
+    if (r_size > 0) {
+        w_size = audio_element_output(self, in_buffer, r_size);
+    } else {
+        w_size = r_size;
+    }
+    return w_size;
+}
+
+static esp_err_t _sfx_clip_reader_close(audio_element_handle_t self)
+{
+    sfx_clip_reader_priv_t *priv = (sfx_clip_reader_priv_t *)audio_element_getdata(self);
+    if (priv) {
+        priv->byte_pos = 0;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _sfx_clip_reader_destroy(audio_element_handle_t self)
+{
+    sfx_clip_reader_priv_t *priv = (sfx_clip_reader_priv_t *)audio_element_getdata(self);
+    if (priv) {
+        if (priv->clip_valid) {
+            _release_clip(&priv->clip);
+        }
+        free(priv);
+    }
+    return ESP_OK;
+}
+
+audio_element_handle_t sfx_clip_reader_init(const sfx_clip_reader_cfg_t *config)
+{
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Invalid config for clip reader. Config pointer is NULL.");
+        return NULL;
+    }
+
+    sfx_clip_reader_priv_t *priv = (sfx_clip_reader_priv_t *)calloc(1, sizeof(sfx_clip_reader_priv_t));
+    if (priv == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate private data for clip reader");
+        return NULL;
+    }
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.tag = "clip";
+    cfg.open = _sfx_clip_reader_open;
+    cfg.close = _sfx_clip_reader_close;
+    cfg.process = _sfx_clip_reader_process;
+    cfg.destroy = _sfx_clip_reader_destroy;
+    cfg.read = _sfx_clip_reader_read;
+    cfg.buffer_len = config->buf_size;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+
+    audio_element_handle_t el = audio_element_init(&cfg);
+    if (el == NULL) {
+        ESP_LOGE(TAG, "Failed to create clip reader audio element");
+        free(priv);
+        return NULL;
+    }
+
+    audio_element_setdata(el, priv);
+    return el;
+}
+
+esp_err_t sfx_clip_reader_set_clip(audio_element_handle_t el, const sfx_mixer_clip_t *clip)
+{
+    sfx_clip_reader_priv_t *priv = el ? (sfx_clip_reader_priv_t *)audio_element_getdata(el) : NULL;
+    if (priv == NULL || clip == NULL || clip->pcm == NULL || clip->frames == 0 ||
+        clip->channels < 1 || clip->channels > 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (priv->clip_valid) {
+        _release_clip(&priv->clip);
+    }
+    priv->clip = *clip;
+    priv->clip_valid = true;
+    priv->byte_pos = 0;
+    return ESP_OK;
+}
+
+int16_t *sfx_mixer_convert_clip(const sfx_mixer_clip_t *in, int sample_rate, int channels, size_t *out_frames)
+{
+    if (in == NULL || in->pcm == NULL || in->frames == 0 || in->sample_rate <= 0 ||
+        in->channels < 1 || in->channels > 2 || sample_rate <= 0 || channels < 1 || channels > 2 || out_frames == NULL) {
+        return NULL;
+    }
+
+    uint64_t step = ((uint64_t)in->sample_rate << 16) / (uint64_t)sample_rate;
+    size_t frames = (size_t)((((uint64_t)in->frames) << 16) / step);
+    if (frames == 0) {
+        return NULL;
+    }
+
+    int16_t *out = heap_caps_malloc(frames * channels * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (out == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u frames for clip conversion", (unsigned int)frames);
+        return NULL;
+    }
+
+    // Reuse the mixer's sampler on a throwaway state describing the source clip
+    sfx_mixer_priv_t conv = {0};
+    conv.clip = *in;
+    conv.stream_channels = channels;
+
+    uint64_t pos = 0;
+    for (size_t f = 0; f < frames; f++) {
+        size_t idx = (size_t)(pos >> 16);
+        if (idx >= in->frames) {
+            idx = in->frames - 1;
+        }
+        uint32_t frac = (uint32_t)(pos & 0xFFFF);
+        for (int c = 0; c < channels; c++) {
+            out[f * channels + c] = _sat16(_clip_sample(&conv, idx, frac, c));
+        }
+        pos += step;
+    }
+
+    *out_frames = frames;
+    return out;
+}
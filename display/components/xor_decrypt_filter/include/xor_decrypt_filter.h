@@ -50,6 +50,45 @@ typedef struct {
  */
 audio_element_handle_t xor_decrypt_filter_init(const xor_decrypt_cfg_t *config);
 
+/**
+ * @brief Decrypts (or encrypts - XOR is symmetric) a buffer in place.
+ *
+ * Word-wide with a precomputed key schedule; safe for any buffer alignment and key phase.
+ * Used by the filter element and by readers that decrypt as they read from SD.
+ *
+ * @param data        Buffer to transform in place.
+ * @param len         Number of bytes.
+ * @param file_offset Absolute offset of data[0] in the encrypted file.
+ */
+void xor_decrypt_buffer(uint8_t *data, size_t len, uint64_t file_offset);
+
+/**
+ * @brief Realigns the key stream to an absolute file offset at a position of the filter's input stream.
+ *
+ * The key byte for each input byte is its absolute offset in the encrypted file modulo the key
+ * length. The upstream reader calls this whenever its output stops being contiguous in the file:
+ * when it starts at a non-zero byte position, seeks while running, or chains to the next file
+ * (file_offset 0). May be called from the reader task before the filter reaches that position,
+ * including before the filter has opened.
+ *
+ * @param el          XOR decrypt element.
+ * @param stream_pos  Input byte offset (counted from open) of the discontinuity.
+ * @param file_offset Absolute file offset of the byte at stream_pos.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a bad handle, ESP_ERR_NO_MEM if too many jumps are pending.
+ */
+esp_err_t xor_decrypt_filter_set_key_offset_at(audio_element_handle_t el, uint64_t stream_pos, uint64_t file_offset);
+
+/**
+ * @brief Random-offset seek test for the decryption key alignment.
+ *
+ * Encrypts random data with a byte-by-byte reference, then decrypts random seek ranges
+ * (including a mid-stream seek) in random chunk sizes and compares against the plaintext.
+ *
+ * @param iterations Number of random seek scenarios (e.g. 1000).
+ * @return ESP_OK if every scenario decrypted correctly.
+ */
+esp_err_t xor_decrypt_filter_test_seek(int iterations);
+
 #ifdef __cplusplus
 }
 #endif
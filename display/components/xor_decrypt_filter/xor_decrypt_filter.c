@@ -5,26 +5,146 @@
 #include "audio_element.h" // for AEL_IO_ABORT constant
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_random.h"
 
 static const char *TAG = "XOR_DECRYPT_FILTER";
 
 // Define the hardcoded XOR decryption key here.
-const char XOR_HARDCODED_KEY[] = "a6cf4c1ef7f43251e673e8578a481a26";
-const size_t XOR_HARDCODED_KEY_LEN = sizeof(XOR_HARDCODED_KEY) - 1; // -1 to exclude the null terminator
+#define XOR_KEY_STRING "a6cf4c1ef7f43251e673e8578a481a26"
+#define XOR_KEY_LEN    (sizeof(XOR_KEY_STRING) - 1)
+const char XOR_HARDCODED_KEY[] = XOR_KEY_STRING;
+const size_t XOR_HARDCODED_KEY_LEN = XOR_KEY_LEN; // -1 to exclude the null terminator
+
+// Key schedule: entry k holds key bytes k..k+3 (wrapping) as one little-endian word, so the
+// decrypt loop does one table load and one XOR per 4 bytes at any key phase.
+static uint32_t s_key_schedule[XOR_KEY_LEN];
+static volatile bool s_key_schedule_ready = false;
 
 // Define a buffer size for processing. This affects memory usage and performance.
 //#define XOR_FILTER_BUFFER_SIZE (8192)
 #define XOR_FILTER_BUFFER_SIZE (4096)
 
+// Maximum number of pending key jumps (seeks / chained files not yet reached by the filter)
+#define XOR_FILTER_MAX_KEY_JUMPS (4)
+
+/**
+ * @brief A point in the input stream where the source continues at another file offset.
+ */
+typedef struct {
+    uint64_t stream_pos;   /*!< Input byte offset (counted from open) of the discontinuity. */
+    uint64_t file_offset;  /*!< Absolute file offset of the byte at stream_pos. */
+} xor_key_jump_t;
+
 /**
  * @brief Structure to store private data for the XOR decrypt filter.
  * We now include a pointer for our pre-allocated buffer.
  */
 typedef struct {
-    size_t current_offset; /*!< Current offset in the XOR key stream, to maintain state. */
+    uint64_t file_offset;  /*!< Absolute offset in the encrypted file of the next input byte; selects the key byte. */
     char   *buffer;        /*!< Pointer to the pre-allocated buffer for processing. */
+    uint64_t stream_pos;   /*!< Input bytes processed since open. */
+    xor_key_jump_t jumps[XOR_FILTER_MAX_KEY_JUMPS]; /*!< Pending discontinuities, in stream order (FIFO). */
+    int      jump_count;
+    portMUX_TYPE lock;     /*!< Protects jumps[] against the reader task. */
 } xor_filter_priv_data_t;
 
+static void _xor_key_schedule_init(void)
+{
+    if (s_key_schedule_ready) {
+        return;
+    }
+    // Idempotent: concurrent first calls write identical values
+    for (size_t k = 0; k < XOR_KEY_LEN; k++) {
+        uint32_t word = 0;
+        for (int j = 0; j < 4; j++) {
+            word |= ((uint32_t)(uint8_t)XOR_HARDCODED_KEY[(k + j) % XOR_KEY_LEN]) << (j * 8);
+        }
+        s_key_schedule[k] = word;
+    }
+    s_key_schedule_ready = true;
+}
+
+/**
+ * @brief Decrypt (or encrypt) a buffer in place, word-wide with the precomputed key schedule.
+ */
+void xor_decrypt_buffer(uint8_t *data, size_t len, uint64_t file_offset)
+{
+    _xor_key_schedule_init();
+
+    size_t k = (size_t)(file_offset % XOR_KEY_LEN);
+    size_t i = 0;
+
+    // Leading bytes until the data pointer is word aligned
+    while (i < len && ((uintptr_t)(data + i) & 3) != 0) {
+        data[i++] ^= (uint8_t)XOR_HARDCODED_KEY[k];
+        if (++k == XOR_KEY_LEN) {
+            k = 0;
+        }
+    }
+
+    // Aligned words: no per-byte modulo, no key assembly
+    uint32_t *words = (uint32_t *)(data + i);
+    size_t word_count = (len - i) / 4;
+    for (size_t w = 0; w < word_count; w++) {
+        words[w] ^= s_key_schedule[k];
+        k += 4;
+        if (k >= XOR_KEY_LEN) {
+            k -= XOR_KEY_LEN;
+        }
+    }
+    i += word_count * 4;
+
+    // Trailing bytes
+    while (i < len) {
+        data[i++] ^= (uint8_t)XOR_HARDCODED_KEY[k];
+        if (++k == XOR_KEY_LEN) {
+            k = 0;
+        }
+    }
+}
+
+/**
+ * @brief Decrypt a block of input in place, following any queued key jumps.
+ * The block is split wherever the source seeked or chained to another file, and the key
+ * is realigned to the absolute file offset of the byte at that point.
+ */
+static void _xor_decrypt_block(xor_filter_priv_data_t *priv_data, uint8_t *data, int len)
+{
+    int processed = 0;
+
+    while (processed < len) {
+        int chunk = len - processed;
+        bool jump = false;
+        uint64_t jump_offset = 0;
+
+        portENTER_CRITICAL(&priv_data->lock);
+        if (priv_data->jump_count > 0) {
+            uint64_t boundary = priv_data->jumps[0].stream_pos;
+            if (boundary <= priv_data->stream_pos) {
+                jump = true;
+                jump_offset = priv_data->jumps[0].file_offset;
+                memmove(&priv_data->jumps[0], &priv_data->jumps[1],
+                        (priv_data->jump_count - 1) * sizeof(priv_data->jumps[0]));
+                priv_data->jump_count--;
+            } else if (boundary < priv_data->stream_pos + chunk) {
+                chunk = (int)(boundary - priv_data->stream_pos);
+            }
+        }
+        portEXIT_CRITICAL(&priv_data->lock);
+
+        if (jump) {
+            ESP_LOGD(TAG, "Key realigned to file offset %llu at input offset %llu", jump_offset, priv_data->stream_pos);
+            priv_data->file_offset = jump_offset;
+            continue;
+        }
+
+        xor_decrypt_buffer(data + processed, chunk, priv_data->file_offset);
+        processed += chunk;
+        priv_data->file_offset += chunk;
+        priv_data->stream_pos += chunk;
+    }
+}
+
 /**
  * @brief Audio element 'open' callback function.
  * Here we allocate the buffer that will be used throughout the element's lifecycle.
@@ -46,9 +166,11 @@ static esp_err_t _xor_decrypt_open(audio_element_handle_t self) {
         }
     }
 
-    // Reset the key stream offset whenever a new stream is opened.
-    priv_data->current_offset = 0;
-    ESP_LOGI(TAG, "XOR Decrypt Filter Opened, buffer allocated, offset reset to %u", (unsigned int)priv_data->current_offset);
+    // A new stream starts at file offset 0 unless the reader already queued its start
+    // position (it may open and seek before this element opens), so jumps are kept here.
+    priv_data->file_offset = 0;
+    priv_data->stream_pos = 0;
+    ESP_LOGI(TAG, "XOR Decrypt Filter Opened, buffer allocated, offset reset to %llu", priv_data->file_offset);
     return ESP_OK;
 }
 
@@ -63,9 +185,13 @@ static esp_err_t _xor_decrypt_close(audio_element_handle_t self) {
         free(priv_data->buffer);
         priv_data->buffer = NULL; // Set to NULL to prevent double-free
     }
-    // Also reset offset
+    // Also reset offset and forget discontinuities of the stream that just ended
     if (priv_data) {
-        priv_data->current_offset = 0;
+        priv_data->file_offset = 0;
+        priv_data->stream_pos = 0;
+        portENTER_CRITICAL(&priv_data->lock);
+        priv_data->jump_count = 0;
+        portEXIT_CRITICAL(&priv_data->lock);
     }
     ESP_LOGI(TAG, "XOR Decrypt Filter Closed, buffer freed.");
     return ESP_OK;
@@ -87,33 +213,10 @@ static int _xor_decrypt_process(audio_element_handle_t self) {
     int w_size = 0;
 
     if (r_size > 0) {
-        // Data was read, now perform XOR decryption with 4-byte alignment optimization.
+        // Data was read, now perform XOR decryption (word-wide, see xor_decrypt_buffer).
         uint8_t *data = (uint8_t *)buffer;
-        int processed = 0;
-        
-        // Process 4 bytes at a time for better performance
-        while (processed + 4 <= r_size) {
-            uint32_t *data32 = (uint32_t *)(data + processed);
-            uint32_t key32 = 0;
-            
-            // Build 4-byte XOR key
-            for (int j = 0; j < 4; j++) {
-                key32 |= ((uint32_t)XOR_HARDCODED_KEY[(priv_data->current_offset + j) % XOR_HARDCODED_KEY_LEN]) << (j * 8);
-            }
-            
-            // XOR 4 bytes at once
-            *data32 ^= key32;
-            
-            processed += 4;
-            priv_data->current_offset += 4;
-        }
-        
-        // Handle remaining bytes (less than 4)
-        for (int i = processed; i < r_size; i++) {
-            data[i] = data[i] ^ XOR_HARDCODED_KEY[priv_data->current_offset % XOR_HARDCODED_KEY_LEN];
-            priv_data->current_offset++;
-        }
-        
+        _xor_decrypt_block(priv_data, data, r_size);
+
         // Write the decrypted data to the downstream element.
         w_size = audio_element_output(self, buffer, r_size);
         if (w_size < 0) {
@@ -170,6 +273,7 @@ audio_element_handle_t xor_decrypt_filter_init(const xor_decrypt_cfg_t *config)
         return NULL;
     }
     // Note: calloc initializes memory to zero, so priv_data->buffer is already NULL.
+    portMUX_INITIALIZE(&priv_data->lock);
 
     // Set basic audio element configuration.
     audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
@@ -200,3 +304,102 @@ audio_element_handle_t xor_decrypt_filter_init(const xor_decrypt_cfg_t *config)
     ESP_LOGI(TAG, "XOR Decrypt Filter Initialized Successfully");
     return el;
 }
+
+/**
+ * @brief Realign the key stream to a file offset at an input stream position.
+ */
+esp_err_t xor_decrypt_filter_set_key_offset_at(audio_element_handle_t el, uint64_t stream_pos, uint64_t file_offset) {
+    xor_filter_priv_data_t *priv_data = el ? (xor_filter_priv_data_t *)audio_element_getdata(el) : NULL;
+    if (priv_data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&priv_data->lock);
+    if (priv_data->jump_count < XOR_FILTER_MAX_KEY_JUMPS) {
+        priv_data->jumps[priv_data->jump_count].stream_pos = stream_pos;
+        priv_data->jumps[priv_data->jump_count].file_offset = file_offset;
+        priv_data->jump_count++;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&priv_data->lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Too many pending key jumps, dropping jump to %llu at %llu", file_offset, stream_pos);
+    }
+    return ret;
+}
+
+/**
+ * @brief Random-offset seek test against a byte-by-byte reference decryption.
+ */
+esp_err_t xor_decrypt_filter_test_seek(int iterations) {
+    const int file_size = 16 * 1024;
+    uint8_t *plain = malloc(file_size);
+    uint8_t *cipher = malloc(file_size);
+    uint8_t *stream = malloc(file_size * 2);
+    xor_filter_priv_data_t *priv_data = calloc(1, sizeof(xor_filter_priv_data_t));
+    esp_err_t result = ESP_OK;
+
+    if (!plain || !cipher || !stream || !priv_data) {
+        ESP_LOGE(TAG, "Seek test: out of memory");
+        result = ESP_ERR_NO_MEM;
+        goto done;
+    }
+    portMUX_INITIALIZE(&priv_data->lock);
+
+    // Reference encryption: key byte = file offset modulo key length
+    esp_fill_random(plain, file_size);
+    for (int i = 0; i < file_size; i++) {
+        cipher[i] = plain[i] ^ (uint8_t)XOR_HARDCODED_KEY[i % XOR_HARDCODED_KEY_LEN];
+    }
+
+    ESP_LOGI(TAG, "STARTING XOR SEEK TEST (%d iterations)", iterations);
+    for (int it = 0; it < iterations && result == ESP_OK; it++) {
+        // Stream = [seek_a .. seek_a + len_a) followed by a mid-stream seek to [seek_b .. seek_b + len_b)
+        uint32_t seek_a = esp_random() % file_size;
+        uint32_t len_a = 1 + esp_random() % (file_size - seek_a);
+        uint32_t seek_b = esp_random() % file_size;
+        uint32_t len_b = 1 + esp_random() % (file_size - seek_b);
+        memcpy(stream, cipher + seek_a, len_a);
+        memcpy(stream + len_a, cipher + seek_b, len_b);
+
+        // Same sequence the element sees: open, reader queues its start offset and a later seek
+        priv_data->file_offset = 0;
+        priv_data->stream_pos = 0;
+        priv_data->jump_count = 0;
+        priv_data->jumps[0] = (xor_key_jump_t){ .stream_pos = 0, .file_offset = seek_a };
+        priv_data->jumps[1] = (xor_key_jump_t){ .stream_pos = len_a, .file_offset = seek_b };
+        priv_data->jump_count = 2;
+
+        // Decrypt in random-sized chunks, like ring buffer reads of varying length
+        uint32_t total = len_a + len_b;
+        uint32_t done_len = 0;
+        while (done_len < total) {
+            uint32_t chunk = 1 + esp_random() % 4096;
+            if (chunk > total - done_len) {
+                chunk = total - done_len;
+            }
+            _xor_decrypt_block(priv_data, stream + done_len, (int)chunk);
+            done_len += chunk;
+        }
+
+        if (memcmp(stream, plain + seek_a, len_a) != 0 || memcmp(stream + len_a, plain + seek_b, len_b) != 0) {
+            ESP_LOGE(TAG, "Seek test FAILED at iteration %d (seek %u+%u, then %u+%u)",
+                     it, (unsigned int)seek_a, (unsigned int)len_a, (unsigned int)seek_b, (unsigned int)len_b);
+            result = ESP_FAIL;
+        }
+    }
+
+    if (result == ESP_OK) {
+        ESP_LOGI(TAG, "XOR SEEK TEST PASSED (%d iterations)", iterations);
+    }
+
+done:
+    free(plain);
+    free(cipher);
+    free(stream);
+    free(priv_data);
+    return result;
+}
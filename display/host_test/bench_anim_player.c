@@ -0,0 +1,133 @@
+// GUI-task cost of a GIF overlay, lv_gif against lv_anim_player, on a headless 240x240 LVGL
+// display with a full-screen image behind the GIF, as on the data sync screen.
+// The GIF is LVGL's bulb.gif (60x80, 113 frames), close to the size of the data sync overlay.
+#define CONFIG_ANIM_FRAME_CACHE_KB  2048      // Kconfig default
+#include "../main/lv_anim_player.c"
+
+#include "host_test.h"
+#include "host_lvgl.h"
+#include "lvgl__lvgl/src/extra/libs/gif/lv_gif.h"
+
+#define GIF_PATH    "../components/lvgl__lvgl/examples/libs/gif/bulb.gif"
+#define RUN_MS      60000
+#define STEP_MS     5           // The device's lv_tick period
+#define RUNS        5
+
+typedef struct {
+    const char *name;
+    uint32_t frames;
+    int64_t busy_us;
+    int64_t max_step_us;
+} result_t;
+
+static void report(const result_t *r)
+{
+    printf("  %-32s %5.1f fps  %6.0f us/frame  max step %5lld us  GUI busy %5.2f%%\n", r->name,
+           r->frames * 1000.0 / RUN_MS, r->frames ? (double)r->busy_us / r->frames : 0.0,
+           (long long)r->max_step_us, r->busy_us / (RUN_MS * 10.0));
+}
+
+// Best of RUNS by total CPU; the overlay is created by create() on a fresh background each run
+static result_t measure(const char *name, lv_obj_t *(*create)(lv_obj_t *parent))
+{
+    static uint16_t bg_pixels[240 * 240];
+    static lv_img_dsc_t bg_dsc = {
+        .header.cf = LV_IMG_CF_TRUE_COLOR,
+        .header.w = 240,
+        .header.h = 240,
+        .data_size = sizeof(bg_pixels),
+        .data = (const uint8_t *)bg_pixels,
+    };
+    for (int i = 0; i < 240 * 240; i++) {
+        bg_pixels[i] = (uint16_t)(i * 2654435761u >> 16);
+    }
+
+    result_t best = { .name = name };
+    for (int run = 0; run < RUNS; run++) {
+        lv_obj_t *bg = lv_img_create(lv_scr_act());
+        lv_img_set_src(bg, &bg_dsc);
+        lv_obj_t *obj = create(bg);
+        lv_obj_set_pos(obj, 169, 127);
+        host_lvgl_run(100, STEP_MS, NULL);     // First draw of the whole screen is not part of it
+
+        result_t r = { .name = name };
+        uint32_t refreshes = host_lvgl_refreshes();
+        r.busy_us = host_lvgl_run(RUN_MS, STEP_MS, &r.max_step_us);
+        r.frames = host_lvgl_refreshes() - refreshes;
+        lv_obj_del(bg);
+        if (run == 0 || r.busy_us < best.busy_us) {
+            best = r;
+        }
+    }
+    return best;
+}
+
+static lv_img_dsc_t s_gif_dsc;
+
+static lv_obj_t *create_lv_gif(lv_obj_t *parent)
+{
+    lv_obj_t *obj = lv_gif_create(parent);
+    lv_gif_set_src(obj, &s_gif_dsc);
+    return obj;
+}
+
+// Leaves the cache empty, so the run includes the pass that fills it
+static lv_obj_t *create_player_first(lv_obj_t *parent)
+{
+    while (s_anims) {
+        anim_entry_free(s_anims);
+    }
+    return lv_anim_player_create(parent, GIF_PATH);
+}
+
+// Every frame was cached by an earlier showing
+static lv_obj_t *create_player_cached(lv_obj_t *parent)
+{
+    return lv_anim_player_create(parent, GIF_PATH);
+}
+
+int main(void)
+{
+    FILE *f = fopen(GIF_PATH, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s (run from host_test)\n", GIF_PATH);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    s_gif_dsc.data_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(s_gif_dsc.data_size);
+    fread(data, 1, s_gif_dsc.data_size, f);
+    fclose(f);
+    s_gif_dsc.data = data;
+
+    host_lvgl_init();
+
+    // What lv_gif does per frame and the player does not once the frame is cached
+    gd_GIF *gif = gd_open_gif_data(data);
+    int frames = 0;
+    int64_t start_us = esp_timer_get_time();
+    for (int pass = 0; pass < 20; pass++) {
+        while (gd_get_frame(gif) == 1) {
+            gif->loop_count = -1;
+            gd_render_frame(gif, gif->canvas);
+            frames++;
+        }
+    }
+    int64_t decode_us = esp_timer_get_time() - start_us;
+    printf("bench_anim_player: %s %ux%u, %d frames per pass; %d s on screen per run, best of %d runs\n",
+           GIF_PATH, gif->width, gif->height, frames / 20, RUN_MS / 1000, RUNS);
+    printf("  gifdec decode + compose alone: %.0f us/frame\n", (double)decode_us / frames);
+    gd_close_gif(gif);
+
+    result_t lv_gif_result = measure("lv_gif", create_lv_gif);
+    result_t first = measure("lv_anim_player, first showing", create_player_first);
+    result_t cached = measure("lv_anim_player, cached", create_player_cached);
+    report(&lv_gif_result);
+    report(&first);
+    report(&cached);
+    HOST_CHECK(cached.frames > 0 && s_anims && s_anims->complete, "bulb.gif was not cached");
+
+    free(data);
+    return host_test_failures != 0;
+}
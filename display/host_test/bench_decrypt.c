@@ -0,0 +1,247 @@
+// Throughput of encrypted playback reading: the fused decrypting reader against the two-element
+// chain it replaced (reader -> ring buffer -> XOR element -> ring buffer).
+// Ring buffers are memcpy in and out, as ESP-ADF's are; the host runs the elements in one
+// thread, so task switches are not counted and the chain figures are on the generous side.
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "audio_element.h"
+#include "xor_decrypt_filter.h"
+#include "sd_track_reader.h"
+
+#define FILE_SIZE       (32 * 1024 * 1024)
+#define CPU_BUF_SIZE    (256 * 1024)
+#define CPU_PASSES      256
+#define RUNS            5
+#define RB_SIZE         (8 * 1024)
+#define READER_BUF      2048        // SD_TRACK_READER_CFG_DEFAULT buf_sz, as fatfs_stream
+#define FILTER_BUF      4096        // XOR_FILTER_BUFFER_SIZE
+
+// The filter's decrypt loop before the word key schedule: builds each 32-bit key with four modulos
+static void baseline_xor_block(uint8_t *data, int len, uint64_t *offset)
+{
+    int processed = 0;
+    while (processed + 4 <= len) {
+        uint32_t *data32 = (uint32_t *)(data + processed);
+        uint32_t key32 = 0;
+        for (int j = 0; j < 4; j++) {
+            key32 |= ((uint32_t)XOR_HARDCODED_KEY[(*offset + j) % XOR_HARDCODED_KEY_LEN]) << (j * 8);
+        }
+        *data32 ^= key32;
+        processed += 4;
+        *offset += 4;
+    }
+    for (int i = processed; i < len; i++) {
+        data[i] = data[i] ^ XOR_HARDCODED_KEY[*offset % XOR_HARDCODED_KEY_LEN];
+        (*offset)++;
+    }
+}
+
+typedef struct {
+    uint8_t buf[RB_SIZE];
+    int head;
+    int fill;
+} ring_t;
+
+static int ring_write(ring_t *rb, const uint8_t *data, int len)
+{
+    int n = RB_SIZE - rb->fill < len ? RB_SIZE - rb->fill : len;
+    int tail = (rb->head + rb->fill) % RB_SIZE;
+    int first = RB_SIZE - tail < n ? RB_SIZE - tail : n;
+    memcpy(rb->buf + tail, data, first);
+    memcpy(rb->buf, data + first, n - first);
+    rb->fill += n;
+    return n;
+}
+
+static int ring_read(ring_t *rb, uint8_t *data, int len)
+{
+    int n = rb->fill < len ? rb->fill : len;
+    int first = RB_SIZE - rb->head < n ? RB_SIZE - rb->head : n;
+    memcpy(data, rb->buf + rb->head, first);
+    memcpy(data + first, rb->buf, n - first);
+    rb->head = (rb->head + n) % RB_SIZE;
+    rb->fill -= n;
+    return n;
+}
+
+typedef struct {
+    ring_t in;
+    ring_t out;
+    bool eof;
+    uint64_t key_offset;        // Baseline filter state
+} chain_t;
+
+static int chain_input(void *ctx, char *buffer, int len)
+{
+    chain_t *c = ctx;
+    int n = ring_read(&c->in, (uint8_t *)buffer, len);
+    return n > 0 ? n : AEL_IO_DONE;
+}
+
+static int chain_output(void *ctx, char *buffer, int len)
+{
+    return ring_write(&((chain_t *)ctx)->out, (uint8_t *)buffer, len);
+}
+
+// Cheap enough not to hide the pipeline's own cost; reads are whole words except at the end
+static uint32_t checksum(uint32_t sum, const uint8_t *data, int len)
+{
+    int i = 0;
+    for (; i + 4 <= len; i += 4) {
+        uint32_t word;
+        memcpy(&word, data + i, 4);
+        sum = ((sum << 5) | (sum >> 27)) ^ word;
+    }
+    for (; i < len; i++) {
+        sum = ((sum << 5) | (sum >> 27)) ^ data[i];
+    }
+    return sum;
+}
+
+typedef enum {
+    CHAIN_BASELINE,     // Reader -> old per-byte-modulo filter
+    CHAIN_WORD,         // Reader -> xor_decrypt_filter element with the word key schedule
+    FUSED,              // Decrypting reader
+} variant_t;
+
+static const char *const VARIANT_NAMES[] = {
+    "reader -> XOR element (old loop)",
+    "reader -> XOR element (word key schedule)",
+    "fused decrypting reader",
+};
+
+// Plays the file through the variant into a consumer (the decoder's input ring buffer reads)
+static int64_t run_variant(const char *path, variant_t variant, uint32_t *sum_out, int64_t *us_out)
+{
+    sd_track_reader_cfg_t reader_cfg = SD_TRACK_READER_CFG_DEFAULT();
+    reader_cfg.decrypt = variant == FUSED;
+    audio_element_handle_t reader = sd_track_reader_init(&reader_cfg);
+    xor_decrypt_cfg_t filter_cfg = DEFAULT_XOR_DECRYPT_CONFIG();
+    audio_element_handle_t filter = variant == CHAIN_WORD ? xor_decrypt_filter_init(&filter_cfg) : NULL;
+    static chain_t c;
+    memset(&c, 0, sizeof(c));
+    uint8_t reader_buf[READER_BUF];
+    uint8_t filter_buf[FILTER_BUF];
+    uint8_t consumer_buf[READER_BUF];
+    uint32_t sum = 0;
+    int64_t bytes = 0;
+
+    audio_element_set_uri(reader, path);
+    int64_t start_us = esp_timer_get_time();
+    host_element_open(reader);
+    if (filter) {
+        host_element_set_io(filter, chain_input, chain_output, &c);
+        host_element_open(filter);
+    }
+
+    // Reader output goes to c.in for the chain, straight to c.out when fused
+    ring_t *reader_rb = variant == FUSED ? &c.out : &c.in;
+    for (;;) {
+        if (!c.eof && RB_SIZE - reader_rb->fill >= READER_BUF) {
+            int n = host_element_read(reader, (char *)reader_buf, READER_BUF);
+            if (n <= 0) {
+                c.eof = true;
+            } else {
+                ring_write(reader_rb, reader_buf, n);
+            }
+        }
+        if (variant == CHAIN_WORD && c.in.fill > 0 && RB_SIZE - c.out.fill >= FILTER_BUF) {
+            host_element_process(filter);
+        } else if (variant == CHAIN_BASELINE && c.in.fill > 0 && RB_SIZE - c.out.fill >= FILTER_BUF) {
+            int n = ring_read(&c.in, filter_buf, FILTER_BUF);
+            baseline_xor_block(filter_buf, n, &c.key_offset);
+            ring_write(&c.out, filter_buf, n);
+        }
+        int n = ring_read(&c.out, consumer_buf, sizeof(consumer_buf));
+        if (n > 0) {
+            sum = checksum(sum, consumer_buf, n);
+            bytes += n;
+        } else if (c.eof && c.in.fill == 0) {
+            break;
+        }
+    }
+    if (filter) {
+        host_element_close(filter);
+        host_element_destroy(filter);
+    }
+    host_element_close(reader);
+    *us_out = esp_timer_get_time() - start_us;
+    host_element_destroy(reader);
+    *sum_out = sum;
+    return bytes;
+}
+
+static void bench_cpu(void)
+{
+    uint8_t *buf = malloc(CPU_BUF_SIZE);
+    memset(buf, 0x5a, CPU_BUF_SIZE);
+    double mb = (double)CPU_BUF_SIZE * CPU_PASSES;
+
+    int64_t start_us = esp_timer_get_time();
+    uint64_t offset = 0;
+    for (int p = 0; p < CPU_PASSES; p++) {
+        baseline_xor_block(buf, CPU_BUF_SIZE, &offset);
+    }
+    int64_t baseline_us = esp_timer_get_time() - start_us;
+
+    start_us = esp_timer_get_time();
+    for (int p = 0; p < CPU_PASSES; p++) {
+        xor_decrypt_buffer(buf, CPU_BUF_SIZE, (uint64_t)p * CPU_BUF_SIZE);
+    }
+    int64_t word_us = esp_timer_get_time() - start_us;
+
+    bool ok = true;
+    for (int i = 0; i < CPU_BUF_SIZE; i++) {
+        ok &= buf[i] == 0x5a;
+    }
+    HOST_CHECK(ok, "old loop and xor_decrypt_buffer applied different key streams");
+    printf("  decrypt loop, old per-byte modulo key:  %8.1f MB/s\n", host_mb_s(mb, baseline_us));
+    printf("  decrypt loop, word key schedule:        %8.1f MB/s  (%.1fx)\n", host_mb_s(mb, word_us),
+           word_us > 0 ? (double)baseline_us / word_us : 0.0);
+    free(buf);
+}
+
+int main(void)
+{
+    const char *path = host_test_path("bench_decrypt.bin");
+    FILE *f = fopen(path, "wb");
+    uint8_t *chunk = malloc(1024 * 1024);
+    host_random_seed(0x5eed0006);
+    for (int i = 0; f && i < FILE_SIZE / (1024 * 1024); i++) {
+        esp_fill_random(chunk, 1024 * 1024);
+        fwrite(chunk, 1, 1024 * 1024, f);
+    }
+    free(chunk);
+    if (!f || fclose(f) != 0) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return 1;
+    }
+
+    printf("bench_decrypt: %d MB file (page cache, so the SD card is not part of it), best of %d runs\n",
+           FILE_SIZE >> 20, RUNS);
+    bench_cpu();
+
+    uint32_t sums[3];
+    for (variant_t v = CHAIN_BASELINE; v <= FUSED; v++) {
+        int64_t best_us = 0;
+        int64_t bytes = 0;
+        for (int r = 0; r < RUNS; r++) {
+            int64_t us;
+            bytes = run_variant(path, v, &sums[v], &us);
+            if (r == 0 || us < best_us) {
+                best_us = us;
+            }
+        }
+        HOST_CHECK(bytes == FILE_SIZE, "%s delivered %lld bytes", VARIANT_NAMES[v], (long long)bytes);
+        printf("  %-42s %8.1f MB/s\n", VARIANT_NAMES[v], host_mb_s(bytes, best_us));
+    }
+    HOST_CHECK(sums[CHAIN_BASELINE] == sums[FUSED] && sums[CHAIN_WORD] == sums[FUSED],
+               "outputs differ: %08x %08x %08x", sums[0], sums[1], sums[2]);
+    remove(path);
+
+    printf("bench_decrypt: %s\n", host_test_failures ? "FAILED" : "outputs identical");
+    return host_test_failures != 0;
+}
@@ -0,0 +1,248 @@
+// Content download wall time against a cloud host, normally mock_cloud.py with injected
+// latency and bandwidth (download_bench.sh): the single-file path the sync used before the
+// pool, one connection per file and one file at a time, against the download pool with
+// 1, 2 and up to -w workers on keep-alive connections. -L adds the single-file loop from
+// before the double-buffered stream (4 KB read, synchronous write, 10 ms sleep).
+//
+//   bench_download -H 127.0.0.1:8443 [-n files] [-w workers] [-L] [-S latency_us:kb_per_s] [-d dir]
+//
+// Every file is the same content URL, as in s3_download_pool_benchmark(). The SD card is a
+// scratch directory (stubs/host_sdcard.c); -S gives each write the cost of a card write.
+#define _GNU_SOURCE     // nftw
+#include <ftw.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "esp_crt_bundle.h"
+#include "esp_http_client.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_test.h"
+#include "s3_download_journal.h"
+#include "s3_download_pool.h"
+
+#define CONTENT_URL_PATH    "/files/content/SKU-00010/PIX-ST-00000-EN_host_mock.mp3"
+
+extern char host_cloud_host[64];
+void host_sdcard_set_root(const char *dir);
+void host_sdcard_set_write_cost(unsigned int latency_us, unsigned int kb_per_s);
+esp_err_t content_download(char *url, char *fullPath);
+
+typedef struct {
+    int64_t us;
+    host_http_stats_t wire;
+} mark_t;
+
+static void mark(mark_t *m)
+{
+    m->us = esp_timer_get_time();
+    host_http_get_stats(&m->wire);
+}
+
+static void bench_path(char *path, size_t size, int i)
+{
+    snprintf(path, size, "/sdcard/tmp/bench/%03d.bin", i);
+}
+
+// Bytes the run left on the card
+static double sd_bytes(int files, const char *suffix)
+{
+    char path[64];
+    char full[80];
+    double total = 0;
+    for (int i = 0; i < files; i++) {
+        bench_path(path, sizeof(path), i);
+        snprintf(full, sizeof(full), "%s%s", path, suffix);
+        struct stat st;
+        if (stat(full, &st) == 0) {
+            total += st.st_size;
+        }
+    }
+    return total;
+}
+
+static void report(const char *name, int files, const mark_t *a, double bytes, bool ok)
+{
+    mark_t b;
+    mark(&b);
+    long long us = b.us - a->us;
+    printf("%-10s %3d files %7.2f MB %8.2f s %7.2f MB/s to SD %7.1f ms/file %3u conn %3u resumed  %s\n",
+           name, files, bytes / (1024.0 * 1024.0), us / 1e6, host_mb_s(bytes, us), us / 1000.0 / files,
+           (unsigned int)(b.wire.connects - a->wire.connects),
+           (unsigned int)(b.wire.tls_resumed - a->wire.tls_resumed), ok ? "ok" : "FAILED");
+}
+
+static void discard_files(int files)
+{
+    char path[64];
+    for (int i = 0; i < files; i++) {
+        bench_path(path, sizeof(path), i);
+        s3_dl_journal_discard(path);
+        remove(path);
+        strlcat(path, ".tmp", sizeof(path));
+        remove(path);
+    }
+}
+
+// direct_download_fallback() before the double-buffered stream, without its resume and
+// logging: 4 KB reads, each written synchronously and followed by a 10 ms sleep
+static esp_err_t legacy_download(const char *url, const char *path)
+{
+    esp_http_client_config_t config = {
+            .url = url,
+            .buffer_size = 4096,
+            .timeout_ms = 30000,
+            .crt_bundle_attach = esp_crt_bundle_attach,
+            .keep_alive_enable = true,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+    esp_http_client_set_header(client, "Accept-Encoding", "identity");
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        esp_http_client_cleanup(client);
+        return err;
+    }
+    int content_length = esp_http_client_fetch_headers(client);
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        esp_http_client_close(client);
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+
+    char buffer[4096];
+    int total_downloaded = 0;
+    while (1) {
+        int read_len = esp_http_client_read(client, buffer, sizeof(buffer));
+        if (read_len <= 0) {
+            break;
+        }
+        fwrite(buffer, 1, read_len, file);
+        total_downloaded += read_len;
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+
+    fclose(file);
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    return content_length > 0 && total_downloaded < content_length ? ESP_FAIL : ESP_OK;
+}
+
+static bool run_legacy(const char *url, int files)
+{
+    char path[64];
+    bool ok = true;
+    discard_files(files);
+    mark_t a;
+    mark(&a);
+    for (int i = 0; i < files; i++) {
+        bench_path(path, sizeof(path), i);
+        ok &= legacy_download(url, path) == ESP_OK;
+    }
+    report("legacy", files, &a, sd_bytes(files, ""), ok);
+    return ok;
+}
+
+// One file after another, each on its own connection (content_download)
+static bool run_serial(const char *url, int files)
+{
+    char path[64];
+    bool ok = true;
+    discard_files(files);
+    mark_t a;
+    mark(&a);
+    for (int i = 0; i < files; i++) {
+        bench_path(path, sizeof(path), i);
+        ok &= content_download((char *)url, path) == ESP_OK;
+    }
+    report("serial", files, &a, sd_bytes(files, ".tmp"), ok);
+    return ok;
+}
+
+static bool run_pool(const char *url, int files, int workers)
+{
+    char path[64];
+    char name[16];
+    discard_files(files);
+    mark_t a;
+    mark(&a);
+    esp_err_t err = s3_download_pool_start(workers);
+    for (int i = 0; i < files && err == ESP_OK; i++) {
+        bench_path(path, sizeof(path), i);
+        err = s3_download_pool_submit(url, path, -1, NULL, NULL, NULL);
+    }
+    bool ok = s3_download_pool_wait() == ESP_OK && err == ESP_OK;
+    // Up to the last file, as s3_download_pool_benchmark(): idle workers take a while to stop
+    snprintf(name, sizeof(name), "pool x%d", workers);
+    report(name, files, &a, sd_bytes(files, ""), ok);
+    s3_download_pool_stop();
+    return ok;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    return remove(path);
+}
+
+int main(int argc, char **argv)
+{
+    const char *host = getenv("MOCK_CLOUD_HOST");
+    const char *dir = NULL;
+    int files = 24;
+    int workers = 4;
+    bool legacy = false;
+    unsigned int write_latency_us = 0;
+    unsigned int write_kb_per_s = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "H:n:w:LS:d:")) != -1) {
+        switch (opt) {
+        case 'H': host = optarg; break;
+        case 'n': files = atoi(optarg); break;
+        case 'w': workers = atoi(optarg); break;
+        case 'L': legacy = true; break;
+        case 'S': sscanf(optarg, "%u:%u", &write_latency_us, &write_kb_per_s); break;
+        case 'd': dir = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s -H host:port [-n files] [-w workers] [-L] [-S latency_us:kb_per_s] [-d dir]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!host || !host[0] || files <= 0 || workers <= 0) {
+        fprintf(stderr, "No cloud host: pass -H host:port or set MOCK_CLOUD_HOST (see mock_cloud.py)\n");
+        return 2;
+    }
+    strlcpy(host_cloud_host, host, sizeof(host_cloud_host));
+    if (!dir) {
+        dir = host_test_path("sdcard");
+    }
+    mkdir(dir, 0775);
+    host_sdcard_set_root(dir);
+    mkdir("/sdcard/tmp", 0775);
+    mkdir("/sdcard/tmp/bench", 0775);
+    host_sdcard_set_write_cost(write_latency_us, write_kb_per_s);
+    if (write_latency_us || write_kb_per_s) {
+        printf("SD writes: %u us + %u KB/s each\n", write_latency_us, write_kb_per_s);
+    }
+
+    char url[160];
+    snprintf(url, sizeof(url), "https://%s%s", host, CONTENT_URL_PATH);
+
+    bool ok = !legacy || run_legacy(url, files);
+    ok &= run_serial(url, files);
+    for (int w = 1; w <= workers; w *= 2) {
+        ok &= run_pool(url, files, w);
+        if (w < workers && w * 2 > workers) {
+            ok &= run_pool(url, files, workers);
+        }
+    }
+
+    nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+// Render time of the home and player screens on a headless 240x240 LVGL display, with the PNG
+// badges (battery, Bluetooth, language) drawn the two ways lv_decoders.c has served them:
+// as cached PNG file bytes (LV_IMG_CF_UNKNOWN), which LVGL's PNG decoder inflates on every
+// draw because LV_IMG_CACHE_DEF_SIZE is 0, and as pixels decoded once into
+// LV_IMG_CF_TRUE_COLOR_ALPHA, which the built-in decoder draws straight from memory.
+// The screens are rebuilt here from lv_screen_mgr.c's layout: the cover, the round base UI,
+// the top battery and Bluetooth badges, then the album dots and language badge (home) or the
+// track number and language badge (player). The device's icons are not in the tree, so the
+// badges are generated anti-aliased shapes of about their size.
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "host_test.h"
+#include "host_lvgl.h"
+#include "lvgl__lvgl/src/extra/libs/png/lodepng.h"
+
+#define FRAMES      200
+#define RUNS        5
+
+typedef enum { BADGE_BATT, BADGE_BT, BADGE_LANG, BADGE_COUNT } badge_t;
+
+static const struct { const char *name; uint16_t w, h; } s_badge_size[BADGE_COUNT] = {
+    [BADGE_BATT] = { "battery", 44, 24 },
+    [BADGE_BT]   = { "bluetooth", 24, 24 },
+    [BADGE_LANG] = { "language", 52, 28 },
+};
+
+static lv_img_dsc_t s_png[BADGE_COUNT];       // PNG file bytes, as cached before
+static lv_img_dsc_t s_decoded[BADGE_COUNT];   // RGB565 + alpha, as cached now
+static uint16_t s_cover_pixels[240 * 240];
+static lv_img_dsc_t s_cover = {
+    .header.cf = LV_IMG_CF_TRUE_COLOR,
+    .header.w = 240,
+    .header.h = 240,
+    .data_size = sizeof(s_cover_pixels),
+    .data = (const uint8_t *)s_cover_pixels,
+};
+
+static int64_t cpu_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// A rounded shape with soft edges and a colour ramp, encoded as a PNG like the icon files
+static void make_badge(badge_t b)
+{
+    uint16_t w = s_badge_size[b].w, h = s_badge_size[b].h;
+    uint8_t *rgba = malloc((size_t)w * h * 4);
+    float r = h / 2.0f;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            float cx = x < r ? r : (x > w - r ? w - r : x);
+            float dx = x + 0.5f - cx, dy = y + 0.5f - r;
+            float edge = r - 1.0f - sqrtf(dx * dx + dy * dy);
+            float a = edge >= 1.0f ? 1.0f : (edge <= 0.0f ? 0.0f : edge);
+            uint8_t *p = &rgba[(y * w + x) * 4];
+            p[0] = (uint8_t)(255 - x * 96 / w);
+            p[1] = (uint8_t)(160 + y * 80 / h);
+            p[2] = (uint8_t)(64 + b * 80);
+            p[3] = (uint8_t)(a * 255);
+        }
+    }
+    unsigned char *png = NULL;
+    size_t png_size = 0;
+    lodepng_encode32(&png, &png_size, rgba, w, h);
+    free(rgba);
+
+    s_png[b] = (lv_img_dsc_t) {
+        .header.cf = LV_IMG_CF_UNKNOWN,
+        .data_size = png_size,
+        .data = png,
+    };
+
+    // Decoded once through LVGL's PNG decoder: the same RGB565 + alpha conversion
+    lv_img_decoder_dsc_t dsc;
+    if (lv_img_decoder_open(&dsc, &s_png[b], lv_color_black(), 0) != LV_RES_OK || !dsc.img_data) {
+        fprintf(stderr, "PNG decoder could not open the %s badge\n", s_badge_size[b].name);
+        exit(1);
+    }
+    size_t size = (size_t)w * h * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    uint8_t *pixels = malloc(size);
+    memcpy(pixels, dsc.img_data, size);
+    lv_img_decoder_close(&dsc);
+    s_decoded[b] = (lv_img_dsc_t) {
+        .header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA,
+        .header.w = w,
+        .header.h = h,
+        .data_size = size,
+        .data = pixels,
+    };
+}
+
+typedef struct {
+    lv_obj_t *badges[4];
+    int badge_count;
+} screen_t;
+
+static lv_obj_t *add_img(lv_obj_t *parent, const lv_img_dsc_t *src)
+{
+    lv_obj_t *img = lv_img_create(parent);
+    lv_img_set_src(img, src);
+    return img;
+}
+
+// lv_base_ui(USE_TRANSPARENCY), the cover and ui_add_top_badge() with Bluetooth paired
+static void build_common(screen_t *s, const lv_img_dsc_t *icons)
+{
+    lv_obj_t *scr = lv_scr_act();
+    lv_obj_clean(scr);
+    lv_obj_remove_style_all(scr);
+    lv_obj_set_style_bg_color(scr, lv_color_hex(0x808080), 0);
+    lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
+    lv_obj_t *main_ui = lv_obj_create(scr);
+    lv_obj_set_size(main_ui, 240, 240);
+    lv_obj_center(main_ui);
+    lv_obj_set_style_radius(main_ui, LV_RADIUS_CIRCLE, 0);
+    lv_obj_set_style_clip_corner(main_ui, true, 0);
+    lv_obj_set_style_bg_opa(main_ui, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(main_ui, 0, 0);
+    lv_obj_set_style_pad_all(main_ui, 0, 0);
+    lv_obj_center(add_img(main_ui, &s_cover));
+
+    s->badge_count = 0;
+    lv_obj_t *batt = add_img(scr, &icons[BADGE_BATT]);
+    lv_obj_set_pos(batt, 82, 6);
+    s->badges[s->badge_count++] = batt;
+
+    lv_obj_t *bt = lv_obj_create(scr);
+    lv_obj_set_size(bt, 32, 32);
+    lv_obj_clear_flag(bt, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_radius(bt, LV_RADIUS_CIRCLE, 0);
+    lv_obj_set_style_clip_corner(bt, true, 0);
+    lv_obj_set_style_bg_color(bt, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(bt, LV_OPA_20, 0);
+    lv_obj_set_style_pad_all(bt, 4, 0);
+    lv_obj_set_style_border_width(bt, 0, 0);
+    lv_obj_align(bt, LV_ALIGN_LEFT_MID, 10, 0);
+    lv_obj_center(add_img(bt, &icons[BADGE_BT]));
+    s->badges[s->badge_count++] = bt;
+}
+
+// lv_home_screen(): album dots (ui_set_dots_bar) and the language badge at (94, 158)
+static void build_home(screen_t *s, const lv_img_dsc_t *icons)
+{
+    build_common(s, icons);
+    for (int i = 0; i < 9; i++) {
+        lv_obj_t *dot = lv_obj_create(lv_scr_act());
+        lv_obj_set_size(dot, 8, 8);
+        lv_obj_set_style_radius(dot, LV_RADIUS_CIRCLE, 0);
+        lv_obj_set_style_bg_color(dot, lv_color_white(), 0);
+        lv_obj_set_style_bg_opa(dot, i == 3 ? LV_OPA_COVER : LV_OPA_50, 0);
+        lv_obj_set_style_border_width(dot, 0, 0);
+        lv_obj_set_pos(dot, 80 + i * 10, 214);
+    }
+    lv_obj_t *lang = add_img(lv_scr_act(), &icons[BADGE_LANG]);
+    lv_obj_set_pos(lang, 94, 158);
+    s->badges[s->badge_count++] = lang;
+}
+
+// lv_player_screen(): the track number label and the language badge at (146, 174)
+static void build_player(screen_t *s, const lv_img_dsc_t *icons)
+{
+    build_common(s, icons);
+    lv_obj_t *number = lv_label_create(lv_scr_act());
+    lv_obj_set_style_text_font(number, &lv_font_montserrat_48, 0);
+    lv_obj_set_style_text_color(number, lv_color_white(), 0);
+    lv_label_set_text(number, "7");
+    lv_obj_align(number, LV_ALIGN_CENTER, 0, 65);
+    s->badges[s->badge_count++] = number;
+    lv_obj_t *lang = add_img(lv_scr_act(), &icons[BADGE_LANG]);
+    lv_obj_set_pos(lang, 146, 174);
+    s->badges[s->badge_count++] = lang;
+}
+
+typedef struct {
+    int64_t avg_us;
+    int64_t max_us;
+} frame_cost_t;
+
+// Best of RUNS by average; badges_only redraws just the badge areas, as a status or track
+// number update does, otherwise the whole screen, as entering it or changing album does
+static frame_cost_t measure(void (*build)(screen_t *, const lv_img_dsc_t *), const lv_img_dsc_t *icons,
+                            bool badges_only)
+{
+    frame_cost_t best = { 0 };
+    for (int run = 0; run < RUNS; run++) {
+        screen_t s;
+        build(&s, icons);
+        lv_refr_now(NULL);
+
+        int64_t total = 0, max = 0;
+        for (int f = 0; f < FRAMES; f++) {
+            if (badges_only) {
+                for (int i = 0; i < s.badge_count; i++) {
+                    lv_obj_invalidate(s.badges[i]);
+                }
+            } else {
+                lv_obj_invalidate(lv_scr_act());
+            }
+            int64_t start = cpu_time_us();
+            lv_refr_now(NULL);
+            int64_t us = cpu_time_us() - start;
+            total += us;
+            if (us > max) {
+                max = us;
+            }
+        }
+        if (run == 0 || total / FRAMES < best.avg_us) {
+            best.avg_us = total / FRAMES;
+            best.max_us = max;
+        }
+    }
+    return best;
+}
+
+static void compare(const char *screen, void (*build)(screen_t *, const lv_img_dsc_t *), bool badges_only)
+{
+    frame_cost_t before = measure(build, s_png, badges_only);
+    frame_cost_t after = measure(build, s_decoded, badges_only);
+    printf("  %-7s %-12s PNG bytes %6lld us/frame (max %6lld) | decoded %6lld us/frame (max %6lld) | %5.1fx\n",
+           screen, badges_only ? "badges only" : "full screen",
+           (long long)before.avg_us, (long long)before.max_us,
+           (long long)after.avg_us, (long long)after.max_us,
+           after.avg_us ? (double)before.avg_us / after.avg_us : 0.0);
+}
+
+int main(void)
+{
+    host_lvgl_init();
+    for (int i = 0; i < 240 * 240; i++) {
+        s_cover_pixels[i] = (uint16_t)(i * 2654435761u >> 16);
+    }
+    printf("bench_screen_render: CPU per refresh, best average of %d runs of %d frames\n", RUNS, FRAMES);
+    for (int b = 0; b < BADGE_COUNT; b++) {
+        make_badge(b);
+        printf("  %-9s badge %2ux%-2u: %5u B PNG, %5u B decoded\n", s_badge_size[b].name,
+               s_badge_size[b].w, s_badge_size[b].h,
+               (unsigned int)s_png[b].data_size, (unsigned int)s_decoded[b].data_size);
+    }
+    compare("home", build_home, false);
+    compare("home", build_home, true);
+    compare("player", build_player, false);
+    compare("player", build_player, true);
+    return 0;
+}
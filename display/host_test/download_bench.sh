@@ -0,0 +1,52 @@
+#!/bin/sh
+# Content download wall time (bench_download) against mock_cloud.py under each link profile:
+# one connection per file against the download pool on keep-alive connections. The lan and
+# sd profiles also run the download loop from before the double-buffered stream; the sd
+# profiles give every SD write 1 ms plus 4 MB/s.
+#
+#   ./download_bench.sh build/bench_download [profile...]
+#
+# Profiles: lan rtt150 rtt150-20mbit sd sd-20mbit (default: all)
+set -e
+
+bench=${1:?usage: $0 path/to/bench_download [profile...]}
+shift
+profiles=${*:-lan rtt150 rtt150-20mbit sd sd-20mbit}
+here=$(dirname "$0")
+tmp=$(mktemp -d)
+mock=
+failed=0
+trap '[ -z "$mock" ] || kill $mock 2>/dev/null; rm -rf "$tmp"' EXIT
+
+for profile in $profiles; do
+    args=""
+    case $profile in
+    lan)            faults=""; args="-L" ;;
+    rtt150)         faults="--rtt-ms 150" ;;
+    rtt150-20mbit)  faults="--rtt-ms 150 --bandwidth-kbps 20000" ;;
+    sd)             faults=""; args="-L -S 1000:4000" ;;
+    sd-20mbit)      faults="--rtt-ms 20 --bandwidth-kbps 20000"; args="-L -S 1000:4000" ;;
+    *) echo "Unknown profile $profile" >&2; exit 2 ;;
+    esac
+
+    rm -f "$tmp/port"
+    python3 "$here/mock_cloud.py" --port 0 --ready-file "$tmp/port" $faults 2>"$tmp/mock.log" &
+    mock=$!
+    while [ ! -s "$tmp/port" ]; do
+        kill -0 $mock 2>/dev/null || { cat "$tmp/mock.log" >&2; exit 1; }
+        sleep 0.1
+    done
+
+    echo "### $profile: ${faults:-no faults}"
+    status=0
+    "$bench" -H "127.0.0.1:$(cat "$tmp/port")" $args || status=$?
+    kill $mock
+    wait $mock 2>/dev/null || true
+    mock=
+    echo
+    if [ $status -ne 0 ]; then
+        echo "### $profile: download failed (exit $status)"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,22 @@
+#pragma once
+// Shared helpers for the host tests and benchmarks
+#include <stdio.h>
+#include <stdlib.h>
+
+extern int host_test_failures;
+
+#define HOST_CHECK(cond, fmt, ...) do {                                         \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+            host_test_failures++;                                               \
+        }                                                                       \
+    } while (0)
+
+// Scratch file path under $TMPDIR (or /tmp), unique per process
+const char *host_test_path(const char *name);
+
+// Megabytes per second for bytes moved in us microseconds
+static inline double host_mb_s(double bytes, long long us)
+{
+    return us > 0 ? bytes / (1024.0 * 1024.0) * 1e6 / us : 0.0;
+}
@@ -0,0 +1,495 @@
+#!/usr/bin/env python3
+"""Mock S3 cloud for sync runs, on the host (sync_harness) or from a device built with
+CONFIG_CLOUD_HOST_OVERRIDE.
+
+Serves the endpoints s3_https_cloud.c calls (binding, device info, fw-contents, account
+manifest, OTA and resource info, tracking_info and the tracking POST) and the content,
+resource and firmware files their responses point to, with Range/If-Range support.
+
+Clients connect to a link emulator in front of the HTTP server, so the faults apply to
+the bytes on the wire, TLS included:
+  --rtt-ms          round trip time, half of it added in each direction
+  --bandwidth-kbps  one bottleneck shared by every connection, per direction
+  --reset-every K   reset every Kth connection after --reset-after bytes sent to the client
+  --reset-prob P    the same for each connection with probability P
+  --range MODE      honor: 206 for a Range whose If-Range still matches
+                    ignore: always 200 with the whole file, no Accept-Ranges
+                    mismatch: If-Range never matches, so resumes restart from zero
+
+Content is generated from --seed, so every run serves the same bytes; --revision R
+changes every fourth content and resource file (and the manifests) to exercise a
+differential sync. Only the standard library and the openssl CLI (for a throwaway
+self-signed certificate) are needed. GET /_mock/stats returns the server counters.
+"""
+
+import argparse
+import asyncio
+import hashlib
+import http.server
+import json
+import os
+import random
+import re
+import shutil
+import signal
+import socket
+import socketserver
+import ssl
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.parse
+from email.utils import formatdate
+
+API = '/client_service/api/v1'
+
+
+class Blob:
+    def __init__(self, data, revision):
+        self.data = data
+        self.sha256 = hashlib.sha256(data).hexdigest()
+        self.md5 = hashlib.md5(data).hexdigest()
+        self.etag = '"%s"' % self.sha256[:16]
+        self.last_modified = formatdate(1700000000 + revision * 3600, usegmt=True)
+
+
+class Catalog:
+    """Every file and manifest the mock serves, built once from the options."""
+
+    def __init__(self, args):
+        self.args = args
+        self.blobs = {}
+        self.content = []    # (folder, filename, url path)
+        self.alarm = None
+        self.nfc = None
+        for i in range(args.files):
+            folder = 'SKU-%05d' % (10 + i % args.packs)
+            name = 'PIX-ST-%05d-EN_host_mock.mp3' % i
+            path = '/files/content/%s/%s' % (folder, name)
+            self._add(path, args.file_size, i % 4 == 0)
+            self.content.append((folder, name, path))
+        self.alarm = '/files/alarms/alarm_%02d.mp3' % 0
+        self._add(self.alarm, max(args.file_size // 4, 1024), False)
+        self.nfc = ('SKU-00900', 'PIX-ST-00900-EN_nfc.mp3', '/files/content/SKU-00900/PIX-ST-00900-EN_nfc.mp3')
+        self._add(self.nfc[2], args.file_size, False)
+
+        resources = []
+        for i in range(args.resources):
+            path = 'image/host_mock/res_%03d.png' % i if i % 4 != 3 else 'sound/host_mock/res_%03d.mp3' % i
+            self._add('/files/resource/' + path, args.resource_size, i % 4 == 0)
+            resources.append(path)
+        # Entries the device skips (animations, and MP3s outside sound/): never served
+        resources += ['animation/host_mock/frame.bin', 'music/host_mock.mp3']
+        self.resources = resources
+
+        self._add('/files/fw/ITC9.bin', args.fw_size, True)
+        self.fw_contents = json.dumps({'files': [c[1] for c in self.content]}).encode()
+        self.blobs['/files/systemContent.json'] = Blob(self.fw_contents, args.revision)
+
+    def _add(self, path, size, changes):
+        revision = self.args.revision if changes else 0
+        rng = random.Random('%d:%s:%d' % (self.args.seed, path, revision))
+        self.blobs[path] = Blob(rng.randbytes(size), revision)
+
+    def resource_manifest(self, base):
+        entries = []
+        for path in self.resources:
+            blob = self.blobs.get('/files/resource/' + path)
+            size = len(blob.data) if blob else 1024
+            entries.append({path: {'url': base + '/files/resource/' + path, 'size': size}})
+        return json.dumps(entries).encode()
+
+    def account(self, base):
+        def item(folder, name, path):
+            blob = self.blobs[path]
+            return {'contentId': 'IST-' + name[7:12], 'url': base + path + '?sv=mock&sig=' + blob.sha256[:8],
+                    'fileSize': len(blob.data), 'filename': name, 'sha256': blob.sha256}
+
+        packs = {}
+        for folder, name, path in self.content:
+            packs.setdefault(folder, []).append(item(folder, name, path))
+        alarm = self.blobs[self.alarm]
+        result = {
+            'babyId': 'host-mock-baby',
+            'nfcLang': 'en-us',
+            'kidCharacter': 'kid5',
+            'babyPacks': [{'skuId': sku, 'language': 'en-us', 'expiresAt': 4102444800, 'contents': contents}
+                          for sku, contents in sorted(packs.items())],
+            'alarms': [{'time': '07:30', 'period': 'AM', 'days': ['Monday', 'Friday'],
+                        'audio': base + self.alarm, 'fileSize': len(alarm.data),
+                        'filename': os.path.basename(self.alarm), 'isActive': True}],
+            'NFCs': [{'sn': 'host-mock-nfc', 'linked': '',
+                      'skus': [{'skuId': self.nfc[0], 'language': 'en-us', 'contents': [item(*self.nfc)]}]}],
+        }
+        return json.dumps({'traceId': 'mock', 'code': 0, 'message': '', 'result': result}, indent=1).encode()
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.counters = {}
+
+    def add(self, key, n=1):
+        with self.lock:
+            self.counters[key] = self.counters.get(key, 0) + n
+
+    def snapshot(self):
+        with self.lock:
+            return dict(sorted(self.counters.items()))
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    server_version = 'MockCloud/1.0'
+    timeout = 60    # Idle keep-alive connections
+
+    def setup(self):
+        # Handshake in the connection's thread, so a slow link does not hold up accept()
+        if self.server.tls_context:
+            self.request = self.server.tls_context.wrap_socket(self.request, server_side=True)
+        super().setup()
+
+    def log_message(self, fmt, *args):
+        if self.server.args.verbose:
+            sys.stderr.write('mock: %s %s\n' % (self.address_string(), fmt % args))
+
+    def base_url(self):
+        scheme = 'https' if self.server.tls_context else 'http'
+        return '%s://%s' % (scheme, self.headers.get('Host', 'localhost'))
+
+    def read_body(self):
+        if 'chunked' in self.headers.get('Transfer-Encoding', ''):
+            body = b''
+            while True:
+                size = int(self.rfile.readline().split(b';')[0], 16)
+                chunk = self.rfile.read(size + 2)[:size]
+                if size == 0:
+                    return body
+                body += chunk
+        return self.rfile.read(int(self.headers.get('Content-Length') or 0))
+
+    def send(self, status, body=b'', content_type='application/json', headers=()):
+        self.send_response(status)
+        self.send_header('Content-Type', content_type)
+        self.send_header('Content-Length', str(len(body)))
+        for key, value in headers:
+            self.send_header(key, value)
+        self.end_headers()
+        if self.command != 'HEAD':
+            self.wfile.write(body)
+        self.server.stats.add('status_%d' % status)
+
+    def send_json(self, obj, status=200):
+        self.send(status, json.dumps(obj).encode())
+
+    def ok(self, result=None, code=0):
+        body = {'traceId': 'mock', 'code': code, 'message': ''}
+        if result is not None:
+            body['result'] = result
+        self.send_json(body)
+
+    def do_PATCH(self):
+        body = self.read_body()
+        path = urllib.parse.urlsplit(self.path).path
+        if path.startswith(API + '/devices/s3/c/'):
+            self.server.stats.add('binding')
+            self.ok(code=self.server.args.binding_code)
+        elif path.startswith(API + '/devices/s3/s/'):
+            self.server.stats.add('device_info')
+            try:
+                json.loads(body)
+                self.ok(code=0 if self.headers.get('x-player-secret') else 10032)
+            except ValueError:
+                self.ok(code=400)
+        else:
+            self.send_json({'code': 404}, 404)
+
+    def do_POST(self):
+        body = self.read_body()
+        path = urllib.parse.urlsplit(self.path).path
+        if path == '/tracking':
+            self.server.stats.add('tracking_posts')
+            self.server.stats.add('tracking_bytes', len(body))
+            status = self.server.args.tracking_status
+            self.send_json({'code': 0 if status < 300 else status}, status)
+        else:
+            self.send_json({'code': 404}, 404)
+
+    def do_HEAD(self):
+        self.do_GET()
+
+    def do_GET(self):
+        url = urllib.parse.urlsplit(self.path)
+        query = urllib.parse.parse_qs(url.query)
+        catalog = self.server.catalog
+        args = self.server.args
+        base = self.base_url()
+        if url.path == API + '/devices/s3/pc':
+            self.server.stats.add('account')
+            self.send_account(catalog.account(base))
+        elif url.path == API + '/contents/s3/c':
+            self.server.stats.add('fw_contents')
+            blob = catalog.blobs['/files/systemContent.json']
+            self.ok({'md5': blob.md5, 'fileName': 'systemContent.json',
+                     'downloadUrl': base + '/files/systemContent.json?sv=mock', 'token': 'sv=mock'})
+        elif url.path == API + '/contents/tracking_info':
+            self.server.stats.add('tracking_info')
+            self.ok({'url': base + '/tracking', 'token': 'Bearer host-mock'})
+        elif url.path.rstrip('/') == '/api/v1/otas':
+            model = query.get('model', [''])[0]
+            self.server.stats.add('ota_info')
+            if model == 'ITC9':
+                self.ok({'firmwareVersion': args.fw_version, 'url': base + '/files/fw/ITC9.bin'})
+            elif model == 'ITC9_RESOURCE':
+                self.ok({'firmwareVersion': args.resource_version, 'url': base + '/files/resource.json'})
+            else:
+                self.ok(code=404)
+        elif url.path == '/files/resource.json':
+            self.server.stats.add('resource_manifest')
+            self.send_blob(Blob(catalog.resource_manifest(base), args.revision))
+        elif url.path in catalog.blobs:
+            self.server.stats.add('files')
+            self.send_blob(catalog.blobs[url.path])
+        elif url.path == '/_mock/stats':
+            self.send_json(self.server.stats.snapshot())
+        else:
+            self.send_json({'code': 404}, 404)
+
+    def send_account(self, body):
+        blob = Blob(body, self.server.args.revision)
+        validators = [('ETag', blob.etag), ('Last-Modified', blob.last_modified)]
+        if not self.server.args.no_304:
+            match = self.headers.get('If-None-Match')
+            since = self.headers.get('If-Modified-Since')
+            if (match and match == blob.etag) or (not match and since == blob.last_modified):
+                self.send(304, headers=validators)
+                return
+        self.send(200, body, headers=validators)
+
+    def send_blob(self, blob):
+        mode = self.server.args.range
+        size = len(blob.data)
+        start, end = 0, size - 1
+        status = 200
+        requested = self.headers.get('Range')
+        match = re.fullmatch(r'bytes=(\d+)-(\d*)', requested.strip()) if requested else None
+        if match and mode != 'ignore':
+            if_range = self.headers.get('If-Range')
+            current = if_range is None or (mode == 'honor' and if_range.strip() in (blob.etag, blob.last_modified))
+            if current:
+                start = int(match.group(1))
+                if start >= size:
+                    self.send(416, headers=[('Content-Range', 'bytes */%d' % size)])
+                    return
+                end = min(int(match.group(2)), size - 1) if match.group(2) else size - 1
+                status = 206
+        self.server.stats.add('range_requests' if requested else 'full_requests')
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(end - start + 1))
+        self.send_header('ETag', blob.etag)
+        self.send_header('Last-Modified', blob.last_modified)
+        if mode != 'ignore':
+            self.send_header('Accept-Ranges', 'bytes')
+        if status == 206:
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, end, size))
+        self.end_headers()
+        self.server.stats.add('status_%d' % status)
+        if self.command == 'HEAD':
+            return
+        view = memoryview(blob.data)[start:end + 1]
+        for offset in range(0, len(view), 64 * 1024):
+            self.wfile.write(view[offset:offset + 64 * 1024])
+        self.server.stats.add('file_bytes', len(view))
+
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+
+    def handle_error(self, request, client_address):
+        # Resets are injected on purpose; only report real bugs
+        if not isinstance(sys.exc_info()[1], (ConnectionError, ssl.SSLError, socket.timeout, BrokenPipeError)):
+            super().handle_error(request, client_address)
+
+
+class Link:
+    """One direction of the emulated link: a shared bottleneck, then a fixed delay."""
+
+    def __init__(self, kbps, delay_s):
+        self.rate = kbps * 1000 / 8 if kbps > 0 else 0
+        self.delay = delay_s
+        self.next_free = 0.0
+
+    async def transmit(self, n):
+        if not self.rate:
+            return
+        loop = asyncio.get_running_loop()
+        now = loop.time()
+        self.next_free = max(now, self.next_free) + n / self.rate
+        await asyncio.sleep(self.next_free - now)
+
+
+class Proxy:
+    def __init__(self, args, backend_port, stats):
+        self.args = args
+        self.backend_port = backend_port
+        self.stats = stats
+        self.rng = random.Random(args.seed)
+        self.connections = 0
+        delay = args.rtt_ms / 2000.0
+        self.up = Link(args.bandwidth_kbps, delay)
+        self.down = Link(args.down_kbps or args.bandwidth_kbps, delay)
+
+    def doomed(self, index):
+        if self.args.reset_every and index % self.args.reset_every == 0:
+            return True
+        return self.args.reset_prob > 0 and self.rng.random() < self.args.reset_prob
+
+    async def handle(self, client_reader, client_writer):
+        self.connections += 1
+        self.stats.add('connections')
+        reset_at = self.args.reset_after if self.doomed(self.connections) else None
+        try:
+            server_reader, server_writer = await asyncio.open_connection('127.0.0.1', self.backend_port)
+        except OSError:
+            client_writer.close()
+            return
+        writers = (client_writer, server_writer)
+
+        def reset():
+            self.stats.add('resets')
+            for w in writers:
+                sock = w.get_extra_info('socket')
+                if sock is not None:
+                    try:
+                        sock.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+                    except OSError:
+                        pass
+                w.transport.abort()
+
+        async def pump(reader, writer, link, limit):
+            queue = asyncio.Queue(maxsize=64)
+            loop = asyncio.get_running_loop()
+
+            async def deliver():
+                sent = 0
+                while True:
+                    due, data = await queue.get()
+                    await asyncio.sleep(max(0.0, due - loop.time()))
+                    if data is None:
+                        if writer.can_write_eof():
+                            writer.write_eof()
+                        return
+                    if limit is not None and sent + len(data) >= limit:
+                        writer.write(data[:limit - sent])
+                        await writer.drain()
+                        reset()
+                        return
+                    writer.write(data)
+                    await writer.drain()
+                    sent += len(data)
+
+            task = asyncio.ensure_future(deliver())
+            try:
+                while not task.done():
+                    data = await reader.read(16 * 1024)
+                    await link.transmit(len(data))
+                    await queue.put((loop.time() + link.delay, data or None))
+                    if not data:
+                        break
+                await task
+            except (ConnectionError, OSError):
+                pass
+            finally:
+                task.cancel()
+
+        await asyncio.gather(pump(client_reader, server_writer, self.up, None),
+                             pump(server_reader, client_writer, self.down, reset_at),
+                             return_exceptions=True)
+        for w in writers:
+            w.close()
+
+
+def make_certificate(directory):
+    cert = os.path.join(directory, 'cert.pem')
+    key = os.path.join(directory, 'key.pem')
+    subprocess.run(['openssl', 'req', '-x509', '-newkey', 'ec', '-pkeyopt', 'ec_paramgen_curve:prime256v1',
+                    '-nodes', '-days', '2', '-subj', '/CN=localhost', '-keyout', key, '-out', cert],
+                   check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def parse_args():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--port', type=int, default=8443, help='port clients connect to (0: any free port)')
+    p.add_argument('--bind', default='127.0.0.1', help='address to listen on (0.0.0.0 for a device on the LAN)')
+    p.add_argument('--plain', action='store_true', help='plain HTTP (CONFIG_CLOUD_HOST_OVERRIDE_HTTP)')
+    p.add_argument('--ready-file', help='write the listening port here once ready')
+    p.add_argument('--verbose', action='store_true', help='log every request')
+    g = p.add_argument_group('content')
+    g.add_argument('--seed', type=int, default=1)
+    g.add_argument('--revision', type=int, default=0, help='change every fourth file and the manifests')
+    g.add_argument('--files', type=int, default=24, help='content files in the account manifest')
+    g.add_argument('--packs', type=int, default=3, help='baby packs the content files are spread over')
+    g.add_argument('--file-size', type=int, default=256 * 1024)
+    g.add_argument('--resources', type=int, default=8, help='resource.json images')
+    g.add_argument('--resource-size', type=int, default=32 * 1024)
+    g.add_argument('--fw-size', type=int, default=1024 * 1024)
+    g.add_argument('--fw-version', default='1.0.1', help='firmware version the OTA info reports')
+    g.add_argument('--resource-version', default='2', help='resource version the OTA info reports')
+    g.add_argument('--binding-code', type=int, default=0, help='binding result code (0 bound)')
+    g.add_argument('--tracking-status', type=int, default=201, help='HTTP status of the tracking POST')
+    g.add_argument('--no-304', action='store_true', help='ignore If-None-Match/If-Modified-Since on the account')
+    g.add_argument('--range', choices=('honor', 'ignore', 'mismatch'), default='honor')
+    f = p.add_argument_group('link faults')
+    f.add_argument('--rtt-ms', type=float, default=0)
+    f.add_argument('--bandwidth-kbps', type=float, default=0, help='0: unlimited')
+    f.add_argument('--down-kbps', type=float, default=0, help='server to client only (default: --bandwidth-kbps)')
+    f.add_argument('--reset-after', type=int, default=48 * 1024, help='bytes to the client before a reset')
+    f.add_argument('--reset-every', type=int, default=0, help='reset every Kth connection')
+    f.add_argument('--reset-prob', type=float, default=0, help='reset each connection with this probability')
+    return p.parse_args()
+
+
+def main():
+    args = parse_args()
+    stats = Stats()
+    tmp = tempfile.mkdtemp(prefix='mock_cloud_')
+    try:
+        server = Server(('127.0.0.1', 0), Handler)
+        server.args = args
+        server.stats = stats
+        server.catalog = Catalog(args)
+        server.tls_context = None
+        if not args.plain:
+            server.tls_context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+            server.tls_context.load_cert_chain(*make_certificate(tmp))
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+
+        loop = asyncio.new_event_loop()
+        asyncio.set_event_loop(loop)
+        proxy = Proxy(args, server.server_address[1], stats)
+        listener = loop.run_until_complete(asyncio.start_server(proxy.handle, args.bind, args.port))
+        port = listener.sockets[0].getsockname()[1]
+        sys.stderr.write('mock_cloud: %s://%s:%d (rtt %g ms, %s, range %s, resets every %d / p=%g after %d B)\n' % (
+            'http' if args.plain else 'https', args.bind, port, args.rtt_ms,
+            '%g kbit/s' % args.bandwidth_kbps if args.bandwidth_kbps else 'unlimited',
+            args.range, args.reset_every, args.reset_prob, args.reset_after))
+        if args.ready_file:
+            with open(args.ready_file + '.tmp', 'w') as f:
+                f.write('%d\n' % port)
+            os.rename(args.ready_file + '.tmp', args.ready_file)
+
+        for sig in (signal.SIGINT, signal.SIGTERM):
+            loop.add_signal_handler(sig, loop.stop)
+        loop.run_forever()
+        sys.stderr.write('mock_cloud: %s\n' % json.dumps(stats.snapshot()))
+    finally:
+        shutil.rmtree(tmp, ignore_errors=True)
+
+
+if __name__ == '__main__':
+    main()
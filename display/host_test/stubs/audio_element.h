@@ -0,0 +1,79 @@
+#pragma once
+// Host stand-in for the part of ESP-ADF audio_element.h the host tests compile against.
+// Elements are plain structs driven by the test: host_element_* calls the callbacks, and
+// audio_element_input/output go through the io hooks the test installs.
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef struct audio_element *audio_element_handle_t;
+
+typedef enum {
+    AEL_IO_OK      = 0,
+    AEL_IO_FAIL    = -1,
+    AEL_IO_DONE    = -2,
+    AEL_IO_ABORT   = -3,
+    AEL_IO_TIMEOUT = -4,
+} audio_element_err_t;
+
+typedef enum {
+    AEL_STATE_NONE    = 0,
+    AEL_STATE_RUNNING = 3,
+    AEL_STATE_PAUSED  = 4,
+    AEL_STATE_STOPPED = 5,
+} audio_element_state_t;
+
+typedef struct {
+    int64_t byte_pos;
+    int64_t total_bytes;
+} audio_element_info_t;
+
+typedef esp_err_t (*el_io_func)(audio_element_handle_t self);
+typedef audio_element_err_t (*process_func)(audio_element_handle_t self, char *el_buffer, int el_buf_len);
+typedef audio_element_err_t (*stream_func)(audio_element_handle_t self, char *buffer, int len,
+                                           TickType_t ticks_to_wait, void *context);
+
+typedef struct {
+    el_io_func open;
+    el_io_func seek;
+    process_func process;
+    el_io_func close;
+    el_io_func destroy;
+    stream_func read;
+    stream_func write;
+    int buffer_len;
+    int task_stack;
+    int task_prio;
+    int task_core;
+    int out_rb_size;
+    void *data;
+    const char *tag;
+    bool stack_in_ext;
+} audio_element_cfg_t;
+
+#define DEFAULT_AUDIO_ELEMENT_CONFIG() { .buffer_len = 2048, .out_rb_size = 8192 }
+
+audio_element_handle_t audio_element_init(audio_element_cfg_t *config);
+void *audio_element_getdata(audio_element_handle_t el);
+esp_err_t audio_element_setdata(audio_element_handle_t el, void *data);
+char *audio_element_get_uri(audio_element_handle_t el);
+esp_err_t audio_element_set_uri(audio_element_handle_t el, const char *uri);
+esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info);
+esp_err_t audio_element_setinfo(audio_element_handle_t el, audio_element_info_t *info);
+esp_err_t audio_element_update_byte_pos(audio_element_handle_t el, int pos);
+esp_err_t audio_element_set_byte_pos(audio_element_handle_t el, int64_t pos);
+esp_err_t audio_element_set_output_ringbuf_size(audio_element_handle_t el, int rb_size);
+audio_element_state_t audio_element_get_state(audio_element_handle_t el);
+int audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size);
+int audio_element_output(audio_element_handle_t el, char *buffer, int write_size);
+
+// Host driver
+typedef int (*host_element_io_t)(void *ctx, char *buffer, int len);
+
+void host_element_set_io(audio_element_handle_t el, host_element_io_t input, host_element_io_t output, void *ctx);
+esp_err_t host_element_open(audio_element_handle_t el);
+int host_element_read(audio_element_handle_t el, char *buffer, int len);
+int host_element_process(audio_element_handle_t el);
+esp_err_t host_element_close(audio_element_handle_t el);
+void host_element_destroy(audio_element_handle_t el);
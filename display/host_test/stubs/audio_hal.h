@@ -0,0 +1,2 @@
+#pragma once
+// Host stand-in for ESP-ADF audio_hal.h
@@ -0,0 +1,3 @@
+#pragma once
+// Host stand-in for ESP-ADF audio_pipeline.h
+#include "audio_element.h"
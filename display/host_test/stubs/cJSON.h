@@ -0,0 +1,57 @@
+#pragma once
+// Host stand-in for the part of cJSON the cloud code uses (host_cjson.c): same struct layout,
+// type bits and ownership rules, parse and unformatted print only
+#include <stdbool.h>
+
+#define cJSON_Invalid       (0)
+#define cJSON_False         (1 << 0)
+#define cJSON_True          (1 << 1)
+#define cJSON_NULL          (1 << 2)
+#define cJSON_Number        (1 << 3)
+#define cJSON_String        (1 << 4)
+#define cJSON_Array         (1 << 5)
+#define cJSON_Object        (1 << 6)
+#define cJSON_Raw           (1 << 7)
+#define cJSON_IsReference   256
+#define cJSON_StringIsConst 512
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *prev;
+    struct cJSON *child;
+    int type;
+    char *valuestring;
+    int valueint;
+    double valuedouble;
+    char *string;
+} cJSON;
+
+typedef int cJSON_bool;
+
+cJSON *cJSON_Parse(const char *value);
+char *cJSON_PrintUnformatted(const cJSON *item);
+void cJSON_Delete(cJSON *item);
+
+int cJSON_GetArraySize(const cJSON *array);
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index);
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string);
+
+cJSON_bool cJSON_IsBool(const cJSON *item);
+cJSON_bool cJSON_IsNumber(const cJSON *item);
+cJSON_bool cJSON_IsString(const cJSON *item);
+cJSON_bool cJSON_IsArray(const cJSON *item);
+cJSON_bool cJSON_IsObject(const cJSON *item);
+
+cJSON *cJSON_CreateObject(void);
+cJSON *cJSON_CreateArray(void);
+cJSON *cJSON_CreateString(const char *string);
+cJSON *cJSON_CreateNumber(double num);
+cJSON_bool cJSON_AddItemToArray(cJSON *array, cJSON *item);
+cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
+cJSON_bool cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item);
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, double number);
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string);
+
+#define cJSON_ArrayForEach(element, array) \
+    for (element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
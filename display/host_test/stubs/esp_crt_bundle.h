@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for esp_crt_bundle.h: the host client does not verify certificates (host_http_client.c)
+#include "esp_err.h"
+
+esp_err_t esp_crt_bundle_attach(void *conf);
@@ -0,0 +1,16 @@
+#pragma once
+// Host stand-in for esp_heap_caps.h: every capability maps to the C heap
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+#define heap_caps_malloc(size, caps)        malloc(size)
+#define heap_caps_calloc(n, size, caps)     calloc(n, size)
+#define heap_caps_realloc(ptr, size, caps)  realloc(ptr, size)
+#define heap_caps_free(ptr)                 free(ptr)
+#define heap_caps_get_free_size(caps)       ((size_t)8 * 1024 * 1024)
+#define heap_caps_get_largest_free_block(caps) ((size_t)4 * 1024 * 1024)
@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for ESP-ADF esp_peripherals.h: only the handle type manual_ota.h needs
+#include "esp_err.h"
+
+typedef struct esp_periph *esp_periph_handle_t;
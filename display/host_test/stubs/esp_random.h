@@ -0,0 +1,8 @@
+#pragma once
+// Host stand-in for esp_random.h (deterministic, seeded by host_random_seed)
+#include <stddef.h>
+#include <stdint.h>
+
+uint32_t esp_random(void);
+void esp_fill_random(void *buf, size_t len);
+void host_random_seed(uint32_t seed);
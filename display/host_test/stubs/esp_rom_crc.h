@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for esp_rom_crc.h, on zlib (host_crypto.c)
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for esp_timer.h: microseconds on the monotonic clock
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
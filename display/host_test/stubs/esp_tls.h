@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in for esp_tls.h: nothing the host build calls, only the system headers it brings in
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "esp_err.h"
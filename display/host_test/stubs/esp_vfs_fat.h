@@ -0,0 +1,3 @@
+#pragma once
+// Host stand-in for esp_vfs_fat.h: nothing the host build calls
+#include "esp_err.h"
@@ -0,0 +1,26 @@
+#pragma once
+// Host stand-in for esp_wifi.h: there is no station, so the diagnostics are skipped
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ESP_ERR_WIFI_NOT_CONNECT 0x300f
+
+typedef enum { WIFI_IF_STA = 0, WIFI_IF_AP } wifi_interface_t;
+typedef enum { WIFI_BW_HT20 = 1, WIFI_BW_HT40 } wifi_bandwidth_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t ssid[33];
+    uint8_t primary;
+    int8_t rssi;
+} wifi_ap_record_t;
+
+static inline esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info)
+{
+    return ESP_ERR_WIFI_NOT_CONNECT;
+}
+
+static inline esp_err_t esp_wifi_get_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t *bw)
+{
+    return ESP_ERR_WIFI_NOT_CONNECT;
+}
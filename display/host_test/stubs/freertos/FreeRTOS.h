@@ -0,0 +1,29 @@
+#pragma once
+// Host stand-in for FreeRTOS.h. Tasks are pthreads (host_freertos.c) and every critical section
+// takes one process-wide lock. Brings in esp_heap_caps.h, as portmacro.h does on the device.
+#include <stdint.h>
+#include <limits.h>
+#include "esp_heap_caps.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef int portMUX_TYPE;
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+
+#define pdTRUE                      1
+#define pdFALSE                     0
+#define pdPASS                      1
+#define pdFAIL                      0
+#define portMAX_DELAY               0xffffffffu
+#define portTICK_PERIOD_MS          1
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(ms))
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portMUX_INITIALIZE(mux)     (*(mux) = 0)
+#define portENTER_CRITICAL(mux)     ((void)(mux), host_critical_enter())
+#define portEXIT_CRITICAL(mux)      ((void)(mux), host_critical_exit())
+
+void host_critical_enter(void);
+void host_critical_exit(void);
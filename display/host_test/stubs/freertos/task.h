@@ -0,0 +1,14 @@
+#pragma once
+// Host stand-in for freertos/task.h: tasks are detached pthreads, priorities are ignored
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *param,
+                       UBaseType_t priority, TaskHandle_t *task);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *param,
+                                   UBaseType_t priority, TaskHandle_t *task, BaseType_t core);
+// Only a task deleting itself (NULL) is supported
+void vTaskDelete(TaskHandle_t task);
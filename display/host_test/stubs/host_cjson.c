@@ -0,0 +1,516 @@
+// Host implementation of the cJSON calls in cJSON.h (the device uses the ESP-IDF json component)
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "cJSON.h"
+
+typedef struct {
+    const char *p;
+} parser_t;
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    bool failed;
+} printer_t;
+
+static cJSON *new_item(int type)
+{
+    cJSON *item = calloc(1, sizeof(cJSON));
+    if (item) {
+        item->type = type;
+    }
+    return item;
+}
+
+void cJSON_Delete(cJSON *item)
+{
+    while (item) {
+        cJSON *next = item->next;
+        if (!(item->type & cJSON_IsReference)) {
+            cJSON_Delete(item->child);
+            free(item->valuestring);
+        }
+        if (!(item->type & cJSON_StringIsConst)) {
+            free(item->string);
+        }
+        free(item);
+        item = next;
+    }
+}
+
+static void skip_ws(parser_t *ps)
+{
+    while (*ps->p && isspace((unsigned char)*ps->p)) {
+        ps->p++;
+    }
+}
+
+static void put_utf8(char **out, unsigned long cp)
+{
+    unsigned char *o = (unsigned char *)*out;
+    if (cp < 0x80) {
+        *o++ = (unsigned char)cp;
+    } else if (cp < 0x800) {
+        *o++ = 0xC0 | (cp >> 6);
+        *o++ = 0x80 | (cp & 0x3F);
+    } else if (cp < 0x10000) {
+        *o++ = 0xE0 | (cp >> 12);
+        *o++ = 0x80 | ((cp >> 6) & 0x3F);
+        *o++ = 0x80 | (cp & 0x3F);
+    } else {
+        *o++ = 0xF0 | (cp >> 18);
+        *o++ = 0x80 | ((cp >> 12) & 0x3F);
+        *o++ = 0x80 | ((cp >> 6) & 0x3F);
+        *o++ = 0x80 | (cp & 0x3F);
+    }
+    *out = (char *)o;
+}
+
+static char *parse_string(parser_t *ps)
+{
+    if (*ps->p != '"') {
+        return NULL;
+    }
+    const char *end = ps->p + 1;
+    while (*end && *end != '"') {
+        if (*end == '\\' && end[1]) {
+            end++;
+        }
+        end++;
+    }
+    if (*end != '"') {
+        return NULL;
+    }
+    // Escapes never make the string longer
+    char *out = malloc(end - ps->p);
+    if (!out) {
+        return NULL;
+    }
+    char *o = out;
+    for (const char *s = ps->p + 1; s < end; s++) {
+        if (*s != '\\') {
+            *o++ = *s;
+            continue;
+        }
+        s++;
+        switch (*s) {
+        case 'b': *o++ = '\b'; break;
+        case 'f': *o++ = '\f'; break;
+        case 'n': *o++ = '\n'; break;
+        case 'r': *o++ = '\r'; break;
+        case 't': *o++ = '\t'; break;
+        case 'u': {
+            char hex[5] = {0};
+            memcpy(hex, s + 1, 4);
+            unsigned long cp = strtoul(hex, NULL, 16);
+            s += 4;
+            if (cp >= 0xD800 && cp < 0xDC00 && s[1] == '\\' && s[2] == 'u') {
+                memcpy(hex, s + 3, 4);
+                unsigned long low = strtoul(hex, NULL, 16);
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                s += 6;
+            }
+            put_utf8(&o, cp);
+            break;
+        }
+        default: *o++ = *s; break;
+        }
+    }
+    *o = '\0';
+    ps->p = end + 1;
+    return out;
+}
+
+static cJSON *parse_value(parser_t *ps, int depth);
+
+static cJSON *parse_container(parser_t *ps, int depth, bool object)
+{
+    cJSON *item = new_item(object ? cJSON_Object : cJSON_Array);
+    if (!item) {
+        return NULL;
+    }
+    char close = object ? '}' : ']';
+    ps->p++;
+    skip_ws(ps);
+    if (*ps->p == close) {
+        ps->p++;
+        return item;
+    }
+    cJSON *tail = NULL;
+    for (;;) {
+        char *key = NULL;
+        skip_ws(ps);
+        if (object) {
+            key = parse_string(ps);
+            skip_ws(ps);
+            if (!key || *ps->p != ':') {
+                free(key);
+                goto fail;
+            }
+            ps->p++;
+        }
+        cJSON *child = parse_value(ps, depth + 1);
+        if (!child) {
+            free(key);
+            goto fail;
+        }
+        child->string = key;
+        if (tail) {
+            tail->next = child;
+            child->prev = tail;
+        } else {
+            item->child = child;
+        }
+        tail = child;
+        item->child->prev = tail;
+        skip_ws(ps);
+        if (*ps->p == ',') {
+            ps->p++;
+            continue;
+        }
+        if (*ps->p == close) {
+            ps->p++;
+            return item;
+        }
+        goto fail;
+    }
+fail:
+    cJSON_Delete(item);
+    return NULL;
+}
+
+static cJSON *parse_value(parser_t *ps, int depth)
+{
+    if (depth > 1000) {
+        return NULL;
+    }
+    skip_ws(ps);
+    const char *p = ps->p;
+    if (strncmp(p, "null", 4) == 0) {
+        ps->p += 4;
+        return new_item(cJSON_NULL);
+    }
+    if (strncmp(p, "false", 5) == 0) {
+        ps->p += 5;
+        return new_item(cJSON_False);
+    }
+    if (strncmp(p, "true", 4) == 0) {
+        ps->p += 4;
+        cJSON *item = new_item(cJSON_True);
+        if (item) {
+            item->valueint = 1;
+        }
+        return item;
+    }
+    if (*p == '"') {
+        char *s = parse_string(ps);
+        cJSON *item = s ? new_item(cJSON_String) : NULL;
+        if (!item) {
+            free(s);
+            return NULL;
+        }
+        item->valuestring = s;
+        return item;
+    }
+    if (*p == '{' || *p == '[') {
+        return parse_container(ps, depth, *p == '{');
+    }
+    if (*p == '-' || isdigit((unsigned char)*p)) {
+        char *end;
+        double d = strtod(p, &end);
+        if (end == p) {
+            return NULL;
+        }
+        cJSON *item = new_item(cJSON_Number);
+        if (!item) {
+            return NULL;
+        }
+        item->valuedouble = d;
+        item->valueint = d >= 2147483647.0 ? 2147483647 : d <= -2147483648.0 ? (int)-2147483648.0 : (int)d;
+        ps->p = end;
+        return item;
+    }
+    return NULL;
+}
+
+cJSON *cJSON_Parse(const char *value)
+{
+    if (!value) {
+        return NULL;
+    }
+    parser_t ps = { value };
+    return parse_value(&ps, 0);
+}
+
+static void emit(printer_t *pr, const char *s, size_t n)
+{
+    if (pr->failed) {
+        return;
+    }
+    if (pr->len + n + 1 > pr->cap) {
+        size_t cap = pr->cap ? pr->cap : 256;
+        while (pr->len + n + 1 > cap) {
+            cap *= 2;
+        }
+        char *grown = realloc(pr->buf, cap);
+        if (!grown) {
+            pr->failed = true;
+            return;
+        }
+        pr->buf = grown;
+        pr->cap = cap;
+    }
+    memcpy(pr->buf + pr->len, s, n);
+    pr->len += n;
+    pr->buf[pr->len] = '\0';
+}
+
+static void emit_string(printer_t *pr, const char *s)
+{
+    emit(pr, "\"", 1);
+    for (; s && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        char esc[8];
+        switch (c) {
+        case '"': emit(pr, "\\\"", 2); break;
+        case '\\': emit(pr, "\\\\", 2); break;
+        case '\n': emit(pr, "\\n", 2); break;
+        case '\r': emit(pr, "\\r", 2); break;
+        case '\t': emit(pr, "\\t", 2); break;
+        default:
+            if (c < 0x20) {
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                emit(pr, esc, 6);
+            } else {
+                emit(pr, (const char *)&c, 1);
+            }
+        }
+    }
+    emit(pr, "\"", 1);
+}
+
+static void emit_item(printer_t *pr, const cJSON *item)
+{
+    char num[32];
+    switch (item->type & 0xFF) {
+    case cJSON_NULL: emit(pr, "null", 4); break;
+    case cJSON_False: emit(pr, "false", 5); break;
+    case cJSON_True: emit(pr, "true", 4); break;
+    case cJSON_Number: {
+        double d = item->valuedouble;
+        int n = (d == (double)(long long)d && fabs(d) < 1e15)
+                ? snprintf(num, sizeof(num), "%lld", (long long)d)
+                : snprintf(num, sizeof(num), "%.17g", d);
+        emit(pr, num, n);
+        break;
+    }
+    case cJSON_String: emit_string(pr, item->valuestring); break;
+    case cJSON_Array:
+    case cJSON_Object: {
+        bool object = (item->type & 0xFF) == cJSON_Object;
+        emit(pr, object ? "{" : "[", 1);
+        for (const cJSON *child = item->child; child; child = child->next) {
+            if (object) {
+                emit_string(pr, child->string);
+                emit(pr, ":", 1);
+            }
+            emit_item(pr, child);
+            if (child->next) {
+                emit(pr, ",", 1);
+            }
+        }
+        emit(pr, object ? "}" : "]", 1);
+        break;
+    }
+    default: break;
+    }
+}
+
+char *cJSON_PrintUnformatted(const cJSON *item)
+{
+    printer_t pr = {0};
+    if (!item) {
+        return NULL;
+    }
+    emit_item(&pr, item);
+    if (pr.failed) {
+        free(pr.buf);
+        return NULL;
+    }
+    return pr.buf;
+}
+
+int cJSON_GetArraySize(const cJSON *array)
+{
+    int n = 0;
+    for (const cJSON *c = array ? array->child : NULL; c; c = c->next) {
+        n++;
+    }
+    return n;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index)
+{
+    cJSON *c = array ? array->child : NULL;
+    while (c && index-- > 0) {
+        c = c->next;
+    }
+    return c;
+}
+
+static cJSON *get_object_item(const cJSON *object, const char *string, bool case_sensitive)
+{
+    if (!object || !string) {
+        return NULL;
+    }
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && (case_sensitive ? strcmp(c->string, string) : strcasecmp(c->string, string)) == 0) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+{
+    return get_object_item(object, string, false);
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string)
+{
+    return get_object_item(object, string, true);
+}
+
+cJSON_bool cJSON_IsBool(const cJSON *item)
+{
+    return item && (item->type & (cJSON_True | cJSON_False)) != 0;
+}
+
+cJSON_bool cJSON_IsNumber(const cJSON *item)
+{
+    return item && (item->type & 0xFF) == cJSON_Number;
+}
+
+cJSON_bool cJSON_IsString(const cJSON *item)
+{
+    return item && (item->type & 0xFF) == cJSON_String;
+}
+
+cJSON_bool cJSON_IsArray(const cJSON *item)
+{
+    return item && (item->type & 0xFF) == cJSON_Array;
+}
+
+cJSON_bool cJSON_IsObject(const cJSON *item)
+{
+    return item && (item->type & 0xFF) == cJSON_Object;
+}
+
+cJSON *cJSON_CreateObject(void)
+{
+    return new_item(cJSON_Object);
+}
+
+cJSON *cJSON_CreateArray(void)
+{
+    return new_item(cJSON_Array);
+}
+
+cJSON *cJSON_CreateString(const char *string)
+{
+    cJSON *item = new_item(cJSON_String);
+    if (item && !(item->valuestring = strdup(string ? string : ""))) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateNumber(double num)
+{
+    cJSON *item = new_item(cJSON_Number);
+    if (item) {
+        item->valuedouble = num;
+        item->valueint = (int)num;
+    }
+    return item;
+}
+
+cJSON_bool cJSON_AddItemToArray(cJSON *array, cJSON *item)
+{
+    if (!array || !item) {
+        return 0;
+    }
+    cJSON *head = array->child;
+    if (!head) {
+        array->child = item;
+        item->prev = item;
+    } else {
+        cJSON *tail = head->prev;
+        tail->next = item;
+        item->prev = tail;
+        head->prev = item;
+    }
+    item->next = NULL;
+    return 1;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+{
+    char *key = string ? strdup(string) : NULL;
+    if (!key || !item) {
+        free(key);
+        return 0;
+    }
+    if (!(item->type & cJSON_StringIsConst)) {
+        free(item->string);
+    }
+    item->string = key;
+    item->type &= ~cJSON_StringIsConst;
+    return cJSON_AddItemToArray(object, item);
+}
+
+cJSON_bool cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item)
+{
+    if (!item) {
+        return 0;
+    }
+    cJSON *ref = new_item(item->type | cJSON_IsReference);
+    if (!ref) {
+        return 0;
+    }
+    ref->child = item->child;
+    ref->valuestring = item->valuestring;
+    ref->valueint = item->valueint;
+    ref->valuedouble = item->valuedouble;
+    if (!cJSON_AddItemToObject(object, string, ref)) {
+        free(ref);
+        return 0;
+    }
+    return 1;
+}
+
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, double number)
+{
+    cJSON *item = cJSON_CreateNumber(number);
+    if (!cJSON_AddItemToObject(object, name, item)) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    return item;
+}
+
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string)
+{
+    cJSON *item = cJSON_CreateString(string);
+    if (!cJSON_AddItemToObject(object, name, item)) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    return item;
+}
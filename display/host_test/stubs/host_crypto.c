@@ -0,0 +1,76 @@
+// Host implementations of the mbedTLS digests (OpenSSL) and the ROM CRC (zlib)
+#include <openssl/evp.h>
+#include <zlib.h>
+#include "esp_rom_crc.h"
+#include "mbedtls/md5.h"
+#include "mbedtls/sha256.h"
+
+static int digest_start(void **md, const EVP_MD *type)
+{
+    if (!*md) {
+        *md = EVP_MD_CTX_new();
+    }
+    return *md && EVP_DigestInit_ex(*md, type, NULL) == 1 ? 0 : -1;
+}
+
+static int digest_finish(void *md, unsigned char *output)
+{
+    return EVP_DigestFinal_ex(md, output, NULL) == 1 ? 0 : -1;
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    ctx->md = NULL;
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    EVP_MD_CTX_free(ctx->md);
+    ctx->md = NULL;
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    return digest_start(&ctx->md, is224 ? EVP_sha224() : EVP_sha256());
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t len)
+{
+    return EVP_DigestUpdate(ctx->md, input, len) == 1 ? 0 : -1;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32])
+{
+    return digest_finish(ctx->md, output);
+}
+
+void mbedtls_md5_init(mbedtls_md5_context *ctx)
+{
+    ctx->md = NULL;
+}
+
+void mbedtls_md5_free(mbedtls_md5_context *ctx)
+{
+    EVP_MD_CTX_free(ctx->md);
+    ctx->md = NULL;
+}
+
+int mbedtls_md5_starts(mbedtls_md5_context *ctx)
+{
+    return digest_start(&ctx->md, EVP_md5());
+}
+
+int mbedtls_md5_update(mbedtls_md5_context *ctx, const unsigned char *input, size_t len)
+{
+    return EVP_DigestUpdate(ctx->md, input, len) == 1 ? 0 : -1;
+}
+
+int mbedtls_md5_finish(mbedtls_md5_context *ctx, unsigned char output[16])
+{
+    return digest_finish(ctx->md, output);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    return (uint32_t)crc32(crc, buf, len);
+}
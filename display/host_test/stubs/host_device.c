@@ -0,0 +1,138 @@
+// Host implementations of the device-side symbols the cloud code links against: the
+// globals WiFi.c and main.c own, NVS and storage reads, and the LVGL and audio hooks
+// sync calls after a file lands. OTA streams the image and discards it.
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_crt_bundle.h"
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "s3_nvs_item.h"
+
+static const char *TAG = "HOST_DEVICE";
+
+bool gWiFi_SYNC_USER_INTERRUPT = false;
+esp_err_t g_init_sdcard = ESP_OK;
+SemaphoreHandle_t g_sdcard_dma_mutex = NULL;
+char s3_WiFiSyncKidIcon[8];
+char s3_babyId[32];
+char host_cloud_host[64];
+
+// Counters the sync harness reports
+int host_alarms_registered;
+int host_cache_invalidations;
+long long host_ota_bytes;
+
+char *strdup_spiram(const char *str)
+{
+    return str ? strdup(str) : NULL;
+}
+
+static const char *host_env(const char *name, const char *fallback)
+{
+    const char *value = getenv(name);
+    return value && value[0] ? value : fallback;
+}
+
+esp_err_t s3_nvs_get(s3_nvs_item_t item, void *value)
+{
+    switch (item) {
+    case NVS_S3_DEVICE_SN:
+        strlcpy(value, host_env("HOST_DEVICE_SN", "S3HOST0000000001"), S3_NVS_SN_LENGTH);
+        return ESP_OK;
+    case NVS_S3_CLOUD_secret_key:
+        strlcpy(value, host_env("HOST_DEVICE_SECRET", "host-secret"), S3_NVS_SECRET_KEY_LENGTH);
+        return ESP_OK;
+    case NVS_S3_SW_CLOUD_DOMAIN:
+        *(int *)value = DOMAIN_DEVELOPER;
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t read_serial_number(char *sn_buffer)
+{
+    return s3_nvs_get(NVS_S3_DEVICE_SN, sn_buffer);
+}
+
+esp_err_t read_secret_key(char *secret_key_str)
+{
+    return s3_nvs_get(NVS_S3_CLOUD_secret_key, secret_key_str);
+}
+
+void register_alarms(const char *full_json_text)
+{
+    (void)full_json_text;
+    host_alarms_registered++;
+}
+
+bool is_audio_playing(void)
+{
+    return false;
+}
+
+void audio_sound_cache_invalidate(const char *path)
+{
+    (void)path;
+    host_cache_invalidations++;
+}
+
+void img_cache_invalidate(const char *path)
+{
+    (void)path;
+    host_cache_invalidations++;
+}
+
+// No native image format on the host: sync keeps the decoded sources only
+esp_err_t lvgl_native_img_convert(const char *path)
+{
+    (void)path;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+int lvgl_native_img_prune(void)
+{
+    return 0;
+}
+
+esp_err_t ota_main(char *uri, int checkVer)
+{
+    (void)checkVer;
+    esp_http_client_config_t config = {
+        .url = uri,
+        .timeout_ms = 10000,
+        .buffer_size = 4096,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (!client) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = ESP_FAIL;
+    if (esp_http_client_open(client, 0) == ESP_OK) {
+        int64_t length = esp_http_client_fetch_headers(client);
+        int status = esp_http_client_get_status_code(client);
+        if (status == 200) {
+            static char buf[16 * 1024];
+            long long total = 0;
+            int n;
+            while ((n = esp_http_client_read(client, buf, sizeof(buf))) > 0) {
+                total += n;
+            }
+            host_ota_bytes += total;
+            if (n == 0 && (length <= 0 || total == length) && esp_http_client_is_complete_data_received(client)) {
+                ret = ESP_OK;
+            } else {
+                ESP_LOGE(TAG, "OTA image cut short: %lld of %lld bytes", total, (long long)length);
+            }
+        } else {
+            ESP_LOGE(TAG, "OTA image: HTTP %d", status);
+        }
+    }
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    return ret;
+}
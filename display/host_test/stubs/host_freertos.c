@@ -0,0 +1,377 @@
+// Host implementations of the FreeRTOS tasks, semaphores, queues and event groups, on pthreads.
+// Linked by the targets that run the cloud code, whose download pool and SD writer are tasks.
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Absolute CLOCK_MONOTONIC deadline for a wait of ticks (1 tick = 1 ms); NULL waits forever
+static const struct timespec *deadline(TickType_t ticks, struct timespec *ts)
+{
+    if (ticks == portMAX_DELAY) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ticks / 1000;
+    ts->tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+static void cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+// false once the deadline passed
+static bool cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock, const struct timespec *until)
+{
+    if (!until) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, until) != ETIMEDOUT;
+}
+
+typedef struct {
+    TaskFunction_t fn;
+    void *param;
+} host_task_t;
+
+static void *task_entry(void *arg)
+{
+    host_task_t task = *(host_task_t *)arg;
+    free(arg);
+    task.fn(task.param);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *param,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    host_task_t *task = malloc(sizeof(*task));
+    if (!task) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->param = param;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        free(task);
+        return pdFAIL;
+    }
+    if (handle) {
+        *handle = (TaskHandle_t)thread;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *param,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    return xTaskCreate(fn, name, stack, param, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task) {
+        pthread_exit(NULL);
+    }
+}
+
+enum { SEM_COUNTING, SEM_MUTEX, SEM_RECURSIVE };
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int kind;
+    UBaseType_t count;
+    UBaseType_t max;
+    pthread_t owner;
+    int depth;
+} host_sem_t;
+
+static SemaphoreHandle_t sem_create(int kind, UBaseType_t max, UBaseType_t initial)
+{
+    host_sem_t *sem = calloc(1, sizeof(*sem));
+    if (sem) {
+        pthread_mutex_init(&sem->lock, NULL);
+        cond_init(&sem->changed);
+        sem->kind = kind;
+        sem->max = max;
+        sem->count = initial;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return sem_create(SEM_COUNTING, 1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return sem_create(SEM_MUTEX, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return sem_create(SEM_RECURSIVE, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return sem_create(SEM_COUNTING, max, initial);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks)
+{
+    host_sem_t *sem = handle;
+    struct timespec ts;
+    const struct timespec *until = deadline(ticks, &ts);
+    BaseType_t taken = pdTRUE;
+    pthread_mutex_lock(&sem->lock);
+    if (sem->kind == SEM_RECURSIVE && sem->depth > 0 && pthread_equal(sem->owner, pthread_self())) {
+        sem->depth++;
+        pthread_mutex_unlock(&sem->lock);
+        return pdTRUE;
+    }
+    while (sem->count == 0) {
+        if (ticks == 0 || !cond_wait(&sem->changed, &sem->lock, until)) {
+            taken = sem->count > 0;
+            break;
+        }
+    }
+    if (taken) {
+        sem->count--;
+        sem->owner = pthread_self();
+        sem->depth = 1;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+    host_sem_t *sem = handle;
+    BaseType_t given = pdTRUE;
+    pthread_mutex_lock(&sem->lock);
+    if (sem->kind == SEM_RECURSIVE && --sem->depth > 0) {
+        pthread_mutex_unlock(&sem->lock);
+        return pdTRUE;
+    }
+    if (sem->count < sem->max) {
+        sem->count++;
+        pthread_cond_signal(&sem->changed);
+    } else {
+        given = pdFALSE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return given;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    return xSemaphoreTake(sem, ticks);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t handle)
+{
+    host_sem_t *sem = handle;
+    if (sem) {
+        pthread_cond_destroy(&sem->changed);
+        pthread_mutex_destroy(&sem->lock);
+        free(sem);
+    }
+}
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+} host_queue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    host_queue_t *queue = calloc(1, sizeof(*queue));
+    if (!queue || !(queue->items = malloc((size_t)length * item_size))) {
+        free(queue);
+        return NULL;
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->changed);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void *item, TickType_t ticks)
+{
+    host_queue_t *queue = handle;
+    struct timespec ts;
+    const struct timespec *until = deadline(ticks, &ts);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (ticks == 0 || !cond_wait(&queue->changed, &queue->lock, until)) {
+            if (queue->count == queue->length) {
+                pthread_mutex_unlock(&queue->lock);
+                return pdFALSE;
+            }
+        }
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + (size_t)tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void *item, TickType_t ticks)
+{
+    host_queue_t *queue = handle;
+    struct timespec ts;
+    const struct timespec *until = deadline(ticks, &ts);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (ticks == 0 || !cond_wait(&queue->changed, &queue->lock, until)) {
+            if (queue->count == 0) {
+                pthread_mutex_unlock(&queue->lock);
+                return pdFALSE;
+            }
+        }
+    }
+    memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle)
+{
+    host_queue_t *queue = handle;
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t handle)
+{
+    host_queue_t *queue = handle;
+    if (queue) {
+        pthread_cond_destroy(&queue->changed);
+        pthread_mutex_destroy(&queue->lock);
+        free(queue->items);
+        free(queue);
+    }
+}
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    EventBits_t bits;
+} host_events_t;
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    host_events_t *group = calloc(1, sizeof(*group));
+    if (group) {
+        pthread_mutex_init(&group->lock, NULL);
+        cond_init(&group->changed);
+    }
+    return group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    host_events_t *group = handle;
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t now = group->bits;
+    pthread_cond_broadcast(&group->changed);
+    pthread_mutex_unlock(&group->lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    host_events_t *group = handle;
+    pthread_mutex_lock(&group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t handle)
+{
+    host_events_t *group = handle;
+    pthread_mutex_lock(&group->lock);
+    EventBits_t now = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return now;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t handle, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks)
+{
+    host_events_t *group = handle;
+    struct timespec ts;
+    const struct timespec *until = deadline(ticks, &ts);
+    pthread_mutex_lock(&group->lock);
+    for (;;) {
+        EventBits_t set = group->bits & bits;
+        if ((wait_for_all ? set == bits : set != 0) || ticks == 0 ||
+            !cond_wait(&group->changed, &group->lock, until)) {
+            break;
+        }
+    }
+    EventBits_t now = group->bits;
+    EventBits_t set = now & bits;
+    if (clear_on_exit && (wait_for_all ? set == bits : set != 0)) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return now;
+}
+
+void vEventGroupDelete(EventGroupHandle_t handle)
+{
+    host_events_t *group = handle;
+    if (group) {
+        pthread_cond_destroy(&group->changed);
+        pthread_mutex_destroy(&group->lock);
+        free(group);
+    }
+}
@@ -0,0 +1,601 @@
+// Host implementation of the esp_http_client calls the cloud code makes, on sockets and OpenSSL.
+//
+// It keeps the device client's behaviour where the cloud code depends on it: open() reuses a
+// connection that is still open (keep-alive), set_url() to another host closes it, read() fills
+// the whole buffer unless the body ends or the connection fails, and a saved TLS session is
+// offered again on the next connect when save_client_session is set. Certificates are not
+// verified: the host runs against the self-signed mock server (mock_cloud.py).
+#define _GNU_SOURCE
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include "esp_crt_bundle.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "HOST_HTTP";
+
+#define HTTP_MAX_HEADERS    16
+#define HTTP_HEAD_MAX       8192
+#define HTTP_RX_CHUNK       16384
+#define HTTP_DEFAULT_TIMEOUT_MS 5000
+
+typedef struct {
+    char *key;
+    char *value;
+} http_header_t;
+
+struct esp_http_client {
+    esp_http_client_config_t config;
+    esp_http_client_method_t method;
+    bool tls;
+    char host[128];
+    int port;
+    char *path;
+    http_header_t headers[HTTP_MAX_HEADERS];
+    int header_count;
+
+    int fd;
+    SSL *ssl;
+    SSL_SESSION *session;
+    bool connected;
+
+    int status;
+    int64_t content_length;     // -1 when the body runs to the end of the connection
+    bool chunked;
+    int64_t chunk_left;
+    bool body_done;
+    int64_t data_process;
+    char *rx;                   // Received but not consumed yet
+    int rx_pos;
+    int rx_len;
+};
+
+static SSL_CTX *s_ssl_ctx;
+static pthread_once_t s_ssl_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t s_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static host_http_stats_t s_stats;
+
+static void ssl_ctx_init(void)
+{
+    signal(SIGPIPE, SIG_IGN);   // A reset connection fails the write instead of killing the process
+    s_ssl_ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(s_ssl_ctx, SSL_VERIFY_NONE, NULL);
+    SSL_CTX_set_session_cache_mode(s_ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+}
+
+static void stats_add(uint64_t *counter, uint64_t n)
+{
+    pthread_mutex_lock(&s_stats_lock);
+    *counter += n;
+    pthread_mutex_unlock(&s_stats_lock);
+}
+
+void host_http_get_stats(host_http_stats_t *stats)
+{
+    pthread_mutex_lock(&s_stats_lock);
+    *stats = s_stats;
+    pthread_mutex_unlock(&s_stats_lock);
+}
+
+esp_err_t esp_crt_bundle_attach(void *conf)
+{
+    return ESP_OK;
+}
+
+static esp_err_t parse_url(esp_http_client_handle_t client, const char *url)
+{
+    const char *p = strstr(url, "://");
+    bool tls = true;
+    if (p) {
+        tls = strncasecmp(url, "https", 5) == 0;
+        p += 3;
+    } else {
+        p = url;
+    }
+    size_t host_len = strcspn(p, ":/?");
+    if (host_len == 0 || host_len >= sizeof(client->host)) {
+        ESP_LOGE(TAG, "Bad URL %s", url);
+        return ESP_FAIL;
+    }
+    char host[sizeof(client->host)];
+    memcpy(host, p, host_len);
+    host[host_len] = '\0';
+    p += host_len;
+    int port = tls ? 443 : 80;
+    if (*p == ':') {
+        port = (int)strtol(p + 1, (char **)&p, 10);
+    }
+    char *path = strdup(*p ? p : "/");
+    if (!path) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (path[0] == '?') {
+        // "host?query" means "/?query"
+        char *rooted = malloc(strlen(path) + 2);
+        if (!rooted) {
+            free(path);
+            return ESP_ERR_NO_MEM;
+        }
+        rooted[0] = '/';
+        strcpy(rooted + 1, path);
+        free(path);
+        path = rooted;
+    }
+
+    if (client->connected && (tls != client->tls || port != client->port || strcasecmp(host, client->host) != 0)) {
+        esp_http_client_close(client);
+    }
+    free(client->path);
+    client->path = path;
+    client->tls = tls;
+    client->port = port;
+    strcpy(client->host, host);
+    return ESP_OK;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    esp_http_client_handle_t client = calloc(1, sizeof(*client));
+    if (!client) {
+        return NULL;
+    }
+    client->config = *config;
+    client->config.url = NULL;
+    if (client->config.timeout_ms <= 0) {
+        client->config.timeout_ms = HTTP_DEFAULT_TIMEOUT_MS;
+    }
+    client->method = config->method;
+    client->fd = -1;
+    client->rx = malloc(HTTP_RX_CHUNK);
+    if (!client->rx || !config->url || parse_url(client, config->url) != ESP_OK) {
+        esp_http_client_cleanup(client);
+        return NULL;
+    }
+    esp_http_client_set_header(client, "User-Agent", config->user_agent ? config->user_agent : "ESP32 HTTP Client/1.0");
+    return client;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    return parse_url(client, url);
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+    client->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    for (int i = 0; i < client->header_count; i++) {
+        if (strcasecmp(client->headers[i].key, key) == 0) {
+            char *copy = strdup(value);
+            if (!copy) {
+                return ESP_ERR_NO_MEM;
+            }
+            free(client->headers[i].value);
+            client->headers[i].value = copy;
+            return ESP_OK;
+        }
+    }
+    if (client->header_count == HTTP_MAX_HEADERS) {
+        return ESP_ERR_NO_MEM;
+    }
+    http_header_t *h = &client->headers[client->header_count];
+    h->key = strdup(key);
+    h->value = strdup(value);
+    if (!h->key || !h->value) {
+        free(h->key);
+        free(h->value);
+        return ESP_ERR_NO_MEM;
+    }
+    client->header_count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+    for (int i = 0; i < client->header_count; i++) {
+        if (strcasecmp(client->headers[i].key, key) == 0) {
+            free(client->headers[i].key);
+            free(client->headers[i].value);
+            client->headers[i] = client->headers[--client->header_count];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static int conn_send(esp_http_client_handle_t client, const char *buf, int len)
+{
+    int sent = 0;
+    while (sent < len) {
+        int n = client->ssl ? SSL_write(client->ssl, buf + sent, len - sent)
+                            : (int)send(client->fd, buf + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return -1;
+        }
+        sent += n;
+    }
+    stats_add(&s_stats.bytes_sent, sent);
+    return sent;
+}
+
+// Bytes received, 0 when the peer closed the connection, -1 on error or timeout
+static int conn_recv(esp_http_client_handle_t client, char *buf, int len)
+{
+    int n;
+    if (client->ssl) {
+        n = SSL_read(client->ssl, buf, len);
+        if (n <= 0) {
+            int err = SSL_get_error(client->ssl, n);
+            n = err == SSL_ERROR_ZERO_RETURN ? 0 : -1;
+            ERR_clear_error();
+        }
+    } else {
+        n = (int)recv(client->fd, buf, len, 0);
+        if (n < 0) {
+            n = -1;
+        }
+    }
+    if (n > 0) {
+        stats_add(&s_stats.bytes_received, n);
+    }
+    return n;
+}
+
+static esp_err_t conn_open(esp_http_client_handle_t client)
+{
+    int64_t start_us = esp_timer_get_time();
+    char port[8];
+    snprintf(port, sizeof(port), "%d", client->port);
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *addrs;
+    if (getaddrinfo(client->host, port, &hints, &addrs) != 0) {
+        ESP_LOGE(TAG, "Cannot resolve %s", client->host);
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    int fd = -1;
+    for (struct addrinfo *a = addrs; a; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Cannot connect to %s:%d: %s", client->host, client->port, strerror(errno));
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    struct timeval tv = { .tv_sec = client->config.timeout_ms / 1000,
+                          .tv_usec = (client->config.timeout_ms % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    client->fd = fd;
+
+    if (client->tls) {
+        pthread_once(&s_ssl_once, ssl_ctx_init);
+        client->ssl = SSL_new(s_ssl_ctx);
+        SSL_set_fd(client->ssl, fd);
+        SSL_set_tlsext_host_name(client->ssl, client->host);
+        if (client->session) {
+            SSL_set_session(client->ssl, client->session);
+        }
+        if (SSL_connect(client->ssl) != 1) {
+            ESP_LOGE(TAG, "TLS handshake with %s failed", client->host);
+            ERR_clear_error();
+            esp_http_client_close(client);
+            return ESP_ERR_HTTP_CONNECT;
+        }
+        if (SSL_session_reused(client->ssl)) {
+            pthread_mutex_lock(&s_stats_lock);
+            s_stats.tls_resumed++;
+            pthread_mutex_unlock(&s_stats_lock);
+        }
+    }
+    client->connected = true;
+    pthread_mutex_lock(&s_stats_lock);
+    s_stats.connects++;
+    s_stats.connect_us += esp_timer_get_time() - start_us;
+    pthread_mutex_unlock(&s_stats_lock);
+    return ESP_OK;
+}
+
+static const char *method_name(esp_http_client_method_t method)
+{
+    static const char *names[] = { "GET", "POST", "PUT", "PATCH", "DELETE", "HEAD" };
+    return method <= HTTP_METHOD_HEAD ? names[method] : "GET";
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    if (!client->connected) {
+        esp_err_t err = conn_open(client);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    client->status = 0;
+    client->content_length = 0;
+    client->chunked = false;
+    client->chunk_left = 0;
+    client->body_done = false;
+    client->data_process = 0;
+
+    char head[HTTP_HEAD_MAX];
+    // Like esp_http_client, the port is part of Host only when it is not the scheme's default
+    int len = snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: %s", method_name(client->method), client->path, client->host);
+    if (client->port != (client->tls ? 443 : 80)) {
+        len += snprintf(head + len, sizeof(head) - len, ":%d", client->port);
+    }
+    len += snprintf(head + len, sizeof(head) - len, "\r\n");
+    for (int i = 0; i < client->header_count && len < (int)sizeof(head); i++) {
+        len += snprintf(head + len, sizeof(head) - len, "%s: %s\r\n", client->headers[i].key, client->headers[i].value);
+    }
+    if (len < (int)sizeof(head)) {
+        len += snprintf(head + len, sizeof(head) - len, "Content-Length: %d\r\n\r\n", write_len > 0 ? write_len : 0);
+    }
+    if (len >= (int)sizeof(head)) {
+        ESP_LOGE(TAG, "Request head too long");
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    if (conn_send(client, head, len) != len) {
+        ESP_LOGE(TAG, "Failed to send the request to %s", client->host);
+        esp_http_client_close(client);
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    return ESP_OK;
+}
+
+int esp_http_client_write(esp_http_client_handle_t client, const char *buffer, int len)
+{
+    return client->connected ? conn_send(client, buffer, len) : -1;
+}
+
+// Next line of the response head (CRLF stripped), NULL when the connection failed
+static char *read_line(esp_http_client_handle_t client, char *line, int size)
+{
+    int len = 0;
+    for (;;) {
+        while (client->rx_pos < client->rx_len) {
+            char c = client->rx[client->rx_pos++];
+            if (c == '\n') {
+                if (len > 0 && line[len - 1] == '\r') {
+                    len--;
+                }
+                line[len] = '\0';
+                return line;
+            }
+            if (len < size - 1) {
+                line[len++] = c;
+            }
+        }
+        int n = conn_recv(client, client->rx, HTTP_RX_CHUNK);
+        if (n <= 0) {
+            return NULL;
+        }
+        client->rx_pos = 0;
+        client->rx_len = n;
+    }
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    if (!client->connected) {
+        return ESP_FAIL;
+    }
+    char line[HTTP_HEAD_MAX];
+    do {
+        // Skip 100 Continue and other interim responses
+        if (!read_line(client, line, sizeof(line)) || sscanf(line, "HTTP/%*d.%*d %d", &client->status) != 1) {
+            ESP_LOGW(TAG, "No response from %s", client->host);
+            return ESP_FAIL;
+        }
+        bool has_length = false;
+        for (;;) {
+            if (!read_line(client, line, sizeof(line))) {
+                return ESP_FAIL;
+            }
+            if (!line[0]) {
+                break;
+            }
+            char *colon = strchr(line, ':');
+            if (!colon) {
+                continue;
+            }
+            *colon = '\0';
+            char *value = colon + 1;
+            while (*value == ' ' || *value == '\t') {
+                value++;
+            }
+            if (strcasecmp(line, "Content-Length") == 0) {
+                client->content_length = strtoll(value, NULL, 10);
+                has_length = true;
+            } else if (strcasecmp(line, "Transfer-Encoding") == 0 && strcasestr(value, "chunked")) {
+                client->chunked = true;
+            }
+            if (client->config.event_handler) {
+                esp_http_client_event_t evt = {
+                    .event_id = HTTP_EVENT_ON_HEADER,
+                    .client = client,
+                    .user_data = client->config.user_data,
+                    .header_key = line,
+                    .header_value = value,
+                };
+                client->config.event_handler(&evt);
+            }
+        }
+        if (client->chunked) {
+            client->content_length = -1;
+        } else if (!has_length) {
+            bool empty = client->method == HTTP_METHOD_HEAD || client->status == 204 || client->status == 304 ||
+                         client->status < 200;
+            client->content_length = empty ? 0 : -1;
+        }
+    } while (client->status < 200);
+
+    client->body_done = client->method == HTTP_METHOD_HEAD || client->content_length == 0;
+    return client->content_length > 0 ? client->content_length : 0;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return client->content_length;
+}
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+    return client->chunked;
+}
+
+// Up to len body bytes from the buffer or the connection: >0, 0 at the end, -1 on error
+static int body_recv(esp_http_client_handle_t client, char *buf, int len)
+{
+    if (client->rx_pos < client->rx_len) {
+        int n = client->rx_len - client->rx_pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(buf, client->rx + client->rx_pos, n);
+        client->rx_pos += n;
+        return n;
+    }
+    return conn_recv(client, buf, len);
+}
+
+// Start of the next chunk; false when the connection failed
+static bool chunk_next(esp_http_client_handle_t client)
+{
+    char line[64];
+    if (client->data_process > 0 && !read_line(client, line, sizeof(line))) {
+        return false;   // CRLF after the previous chunk
+    }
+    if (!read_line(client, line, sizeof(line))) {
+        return false;
+    }
+    client->chunk_left = strtoll(line, NULL, 16);
+    if (client->chunk_left == 0) {
+        do {
+            if (!read_line(client, line, sizeof(line))) {
+                return false;
+            }
+        } while (line[0]);  // Trailers
+        client->body_done = true;
+    }
+    return true;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    int done = 0;
+    while (done < len && !client->body_done && client->connected) {
+        int want = len - done;
+        if (client->chunked) {
+            if (client->chunk_left == 0) {
+                if (!chunk_next(client)) {
+                    break;
+                }
+                continue;
+            }
+            if (want > client->chunk_left) {
+                want = (int)client->chunk_left;
+            }
+        } else if (client->content_length >= 0 && want > client->content_length - client->data_process) {
+            want = (int)(client->content_length - client->data_process);
+        }
+        int n = body_recv(client, buffer + done, want);
+        if (n <= 0) {
+            if (n == 0 && client->content_length < 0 && !client->chunked) {
+                client->body_done = true;   // Body delimited by the end of the connection
+            }
+            if (n < 0 && done == 0) {
+                return -1;
+            }
+            break;
+        }
+        done += n;
+        client->data_process += n;
+        if (client->chunked) {
+            client->chunk_left -= n;
+        } else if (client->content_length >= 0 && client->data_process >= client->content_length) {
+            client->body_done = true;
+        }
+    }
+    return done;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+    return client->body_done;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    if (client->ssl) {
+        if (client->config.save_client_session && SSL_get_session(client->ssl) &&
+            SSL_SESSION_is_resumable(SSL_get_session(client->ssl))) {
+            // TLS 1.3 tickets arrive after the handshake: take the session when the connection ends
+            if (client->session) {
+                SSL_SESSION_free(client->session);
+            }
+            client->session = SSL_get1_session(client->ssl);
+        }
+        // Send close_notify as esp-tls does: OpenSSL drops the session of a connection freed without it
+        SSL_shutdown(client->ssl);
+        ERR_clear_error();
+        SSL_free(client->ssl);
+        client->ssl = NULL;
+    }
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+    client->connected = false;
+    client->rx_pos = client->rx_len = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    if (!client) {
+        return ESP_FAIL;
+    }
+    esp_http_client_close(client);
+    if (client->session) {
+        SSL_SESSION_free(client->session);
+    }
+    for (int i = 0; i < client->header_count; i++) {
+        free(client->headers[i].key);
+        free(client->headers[i].value);
+    }
+    free(client->path);
+    free(client->rx);
+    free(client);
+    return ESP_OK;
+}
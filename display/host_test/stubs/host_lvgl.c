@@ -0,0 +1,94 @@
+// Headless LVGL port and the allocator lv_conf.h expects from lv_screen_mgr.c
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_lvgl.h"
+#include "lv_screen_mgr.h"
+
+#define HOST_HOR_RES    240
+#define HOST_VER_RES    240
+#define HOST_BUF_LINES  40      // LVGL_BUFFER_SIZE on the device is a partial buffer too
+
+static lv_disp_draw_buf_t s_draw_buf;
+static lv_disp_drv_t s_disp_drv;
+static lv_color_t s_buf[HOST_HOR_RES * HOST_BUF_LINES];
+static uint32_t s_flushes;
+static uint32_t s_refreshes;
+
+void *lv_malloc(size_t s)
+{
+    return malloc(s);
+}
+
+void lv_free(void *p)
+{
+    free(p);
+}
+
+void *lv_realloc(void *p, size_t s)
+{
+    return realloc(p, s);
+}
+
+char *strdup_spiram(const char *str)
+{
+    return str ? strdup(str) : NULL;
+}
+
+static void host_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    s_flushes++;
+    lv_disp_flush_ready(drv);
+}
+
+static void host_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    s_refreshes++;
+}
+
+void host_lvgl_init(void)
+{
+    lv_init();
+    lv_disp_draw_buf_init(&s_draw_buf, s_buf, NULL, HOST_HOR_RES * HOST_BUF_LINES);
+    lv_disp_drv_init(&s_disp_drv);
+    s_disp_drv.hor_res = HOST_HOR_RES;
+    s_disp_drv.ver_res = HOST_VER_RES;
+    s_disp_drv.flush_cb = host_flush_cb;
+    s_disp_drv.monitor_cb = host_monitor_cb;
+    s_disp_drv.draw_buf = &s_draw_buf;
+    lv_disp_drv_register(&s_disp_drv);
+}
+
+// Thread CPU time, so a busy host does not inflate the figures
+static int64_t cpu_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t host_lvgl_run(uint32_t ms, uint32_t step_ms, int64_t *max_step_us)
+{
+    int64_t busy_us = 0;
+    for (uint32_t t = 0; t < ms; t += step_ms) {
+        lv_tick_inc(step_ms);
+        int64_t start_us = cpu_time_us();
+        lv_timer_handler();
+        int64_t step_us = cpu_time_us() - start_us;
+        busy_us += step_us;
+        if (max_step_us && step_us > *max_step_us) {
+            *max_step_us = step_us;
+        }
+    }
+    return busy_us;
+}
+
+uint32_t host_lvgl_flushes(void)
+{
+    return s_flushes;
+}
+
+uint32_t host_lvgl_refreshes(void)
+{
+    return s_refreshes;
+}
@@ -0,0 +1,17 @@
+#pragma once
+// Headless LVGL display for the host tests: a 240x240 panel like the device's, flushed nowhere
+#include <stdint.h>
+#include "lvgl.h"
+
+void host_lvgl_init(void);
+
+// Advance the LVGL tick by ms in step_ms steps, running lv_timer_handler() after each.
+// Returns the CPU time spent in lv_timer_handler() in microseconds; max_step_us (may be NULL)
+// is raised to the longest single call.
+int64_t host_lvgl_run(uint32_t ms, uint32_t step_ms, int64_t *max_step_us);
+
+// Display flushes so far (one per refreshed area)
+uint32_t host_lvgl_flushes(void);
+
+// Screen refreshes that drew something (monitor_cb calls)
+uint32_t host_lvgl_refreshes(void);
@@ -0,0 +1,126 @@
+// Host stand-in for the SD card mount: paths under /sdcard are redirected to a host
+// directory. Linked with -Wl,--wrap for each call below (see the Makefile), so the
+// device sources keep their literal "/sdcard/..." paths. fwrite can be given the cost of
+// a card write, so code that overlaps writes with the network shows it on the host.
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SDCARD_PREFIX   "/sdcard"
+
+static char s_root[200];
+static unsigned int s_write_latency_us;
+static unsigned int s_write_kb_per_s;
+
+void host_sdcard_set_root(const char *dir)
+{
+    snprintf(s_root, sizeof(s_root), "%s", dir);
+}
+
+const char *host_sdcard_root(void)
+{
+    return s_root;
+}
+
+// Every fwrite then takes at least latency_us plus its bytes at kb_per_s (0, 0: host speed)
+void host_sdcard_set_write_cost(unsigned int latency_us, unsigned int kb_per_s)
+{
+    s_write_latency_us = latency_us;
+    s_write_kb_per_s = kb_per_s;
+}
+
+static long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// path, or path with /sdcard replaced by the root when one is set
+static const char *sdcard_path(const char *path, char *buf, size_t size)
+{
+    size_t n = strlen(SDCARD_PREFIX);
+    if (!s_root[0] || !path || strncmp(path, SDCARD_PREFIX, n) != 0 || (path[n] != '/' && path[n] != '\0')) {
+        return path;
+    }
+    snprintf(buf, size, "%s%s", s_root, path + n);
+    return buf;
+}
+
+FILE *__real_fopen(const char *path, const char *mode);
+int __real_stat(const char *path, struct stat *st);
+int __real_access(const char *path, int mode);
+int __real_mkdir(const char *path, mode_t mode);
+int __real_remove(const char *path);
+int __real_unlink(const char *path);
+int __real_rename(const char *from, const char *to);
+DIR *__real_opendir(const char *path);
+size_t __real_fwrite(const void *ptr, size_t size, size_t count, FILE *stream);
+
+FILE *__wrap_fopen(const char *path, const char *mode)
+{
+    char buf[512];
+    return __real_fopen(sdcard_path(path, buf, sizeof(buf)), mode);
+}
+
+int __wrap_stat(const char *path, struct stat *st)
+{
+    char buf[512];
+    return __real_stat(sdcard_path(path, buf, sizeof(buf)), st);
+}
+
+int __wrap_access(const char *path, int mode)
+{
+    char buf[512];
+    return __real_access(sdcard_path(path, buf, sizeof(buf)), mode);
+}
+
+int __wrap_mkdir(const char *path, mode_t mode)
+{
+    char buf[512];
+    return __real_mkdir(sdcard_path(path, buf, sizeof(buf)), mode);
+}
+
+int __wrap_remove(const char *path)
+{
+    char buf[512];
+    return __real_remove(sdcard_path(path, buf, sizeof(buf)));
+}
+
+int __wrap_unlink(const char *path)
+{
+    char buf[512];
+    return __real_unlink(sdcard_path(path, buf, sizeof(buf)));
+}
+
+int __wrap_rename(const char *from, const char *to)
+{
+    char buf_from[512], buf_to[512];
+    return __real_rename(sdcard_path(from, buf_from, sizeof(buf_from)), sdcard_path(to, buf_to, sizeof(buf_to)));
+}
+
+DIR *__wrap_opendir(const char *path)
+{
+    char buf[512];
+    return __real_opendir(sdcard_path(path, buf, sizeof(buf)));
+}
+
+size_t __wrap_fwrite(const void *ptr, size_t size, size_t count, FILE *stream)
+{
+    long long start = now_us();
+    size_t n = __real_fwrite(ptr, size, count, stream);
+    if (s_write_latency_us || s_write_kb_per_s) {
+        long long cost = s_write_latency_us;
+        if (s_write_kb_per_s) {
+            cost += (long long)(n * size) * 1000000 / (s_write_kb_per_s * 1024LL);
+        }
+        long long left = cost - (now_us() - start);
+        if (left > 0) {
+            usleep(left);
+        }
+    }
+    return n;
+}
@@ -0,0 +1,252 @@
+// Host implementations of the ESP-IDF, FreeRTOS and ESP-ADF calls the host tests link against
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "audio_element.h"
+#include "freertos/task.h"
+
+int host_log_verbose = 0;
+
+__attribute__((constructor)) static void host_log_init(void)
+{
+    const char *verbose = getenv("HOST_TEST_VERBOSE");
+    host_log_verbose = verbose && verbose[0] == '1';
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    default: return "ESP_ERR";
+    }
+}
+
+// xorshift32: the same sequence on every run for a given seed
+static uint32_t s_random_state = 0x12345678;
+
+void host_random_seed(uint32_t seed)
+{
+    s_random_state = seed ? seed : 1;
+}
+
+uint32_t esp_random(void)
+{
+    uint32_t x = s_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return s_random_state = x;
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    for (size_t i = 0; i < len; i++) {
+        p[i] = (uint8_t)esp_random();
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+static pthread_mutex_t s_critical = PTHREAD_MUTEX_INITIALIZER;
+
+void host_critical_enter(void)
+{
+    pthread_mutex_lock(&s_critical);
+}
+
+void host_critical_exit(void)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+struct audio_element {
+    audio_element_cfg_t cfg;
+    void *data;
+    char *uri;
+    audio_element_info_t info;
+    audio_element_state_t state;
+    char *buffer;
+    host_element_io_t input;
+    host_element_io_t output;
+    void *io_ctx;
+};
+
+audio_element_handle_t audio_element_init(audio_element_cfg_t *config)
+{
+    audio_element_handle_t el = calloc(1, sizeof(*el));
+    if (el) {
+        el->cfg = *config;
+        el->data = config->data;
+    }
+    return el;
+}
+
+void *audio_element_getdata(audio_element_handle_t el)
+{
+    return el->data;
+}
+
+esp_err_t audio_element_setdata(audio_element_handle_t el, void *data)
+{
+    el->data = data;
+    return ESP_OK;
+}
+
+char *audio_element_get_uri(audio_element_handle_t el)
+{
+    return el->uri;
+}
+
+esp_err_t audio_element_set_uri(audio_element_handle_t el, const char *uri)
+{
+    free(el->uri);
+    el->uri = uri ? strdup(uri) : NULL;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info)
+{
+    *info = el->info;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_setinfo(audio_element_handle_t el, audio_element_info_t *info)
+{
+    el->info = *info;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_update_byte_pos(audio_element_handle_t el, int pos)
+{
+    el->info.byte_pos += pos;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_byte_pos(audio_element_handle_t el, int64_t pos)
+{
+    el->info.byte_pos = pos;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_output_ringbuf_size(audio_element_handle_t el, int rb_size)
+{
+    el->cfg.out_rb_size = rb_size;
+    return ESP_OK;
+}
+
+audio_element_state_t audio_element_get_state(audio_element_handle_t el)
+{
+    return el->state;
+}
+
+int audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size)
+{
+    return el->input ? el->input(el->io_ctx, buffer, wanted_size) : AEL_IO_DONE;
+}
+
+int audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+{
+    return el->output ? el->output(el->io_ctx, buffer, write_size) : write_size;
+}
+
+void host_element_set_io(audio_element_handle_t el, host_element_io_t input, host_element_io_t output, void *ctx)
+{
+    el->input = input;
+    el->output = output;
+    el->io_ctx = ctx;
+}
+
+esp_err_t host_element_open(audio_element_handle_t el)
+{
+    el->state = AEL_STATE_RUNNING;
+    return el->cfg.open ? el->cfg.open(el) : ESP_OK;
+}
+
+int host_element_read(audio_element_handle_t el, char *buffer, int len)
+{
+    return el->cfg.read(el, buffer, len, portMAX_DELAY, NULL);
+}
+
+int host_element_process(audio_element_handle_t el)
+{
+    if (!el->buffer) {
+        el->buffer = malloc(el->cfg.buffer_len);
+    }
+    return el->cfg.process(el, el->buffer, el->cfg.buffer_len);
+}
+
+esp_err_t host_element_close(audio_element_handle_t el)
+{
+    el->state = AEL_STATE_STOPPED;
+    return el->cfg.close ? el->cfg.close(el) : ESP_OK;
+}
+
+void host_element_destroy(audio_element_handle_t el)
+{
+    if (el->cfg.destroy) {
+        el->cfg.destroy(el);
+    }
+    free(el->buffer);
+    free(el->uri);
+    free(el);
+}
+
+#include <unistd.h>
+#include "../host_test.h"
+
+int host_test_failures = 0;
+
+const char *host_test_path(const char *name)
+{
+    static char path[4][256];
+    static int slot;
+    const char *dir = getenv("TMPDIR");
+    char *p = path[slot++ % 4];
+    snprintf(p, sizeof(path[0]), "%s/host_test_%d_%s", dir && dir[0] ? dir : "/tmp", (int)getpid(), name);
+    return p;
+}
+
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+size_t strlcat(char *dst, const char *src, size_t size)
+{
+    size_t used = strnlen(dst, size);
+    return used == size ? size + strlen(src) : used + strlcpy(dst + used, src, size - used);
+}
@@ -0,0 +1,7 @@
+#pragma once
+// Host stand-in for lv_screen_mgr.h: lv_conf.h takes LVGL's allocator from it
+#include <stddef.h>
+
+void *lv_malloc(size_t s);
+void lv_free(void *p);
+void *lv_realloc(void *p, size_t s);
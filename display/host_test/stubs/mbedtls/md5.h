@@ -0,0 +1,13 @@
+#pragma once
+// Host stand-in for mbedtls/md5.h, on OpenSSL (host_crypto.c)
+#include <stddef.h>
+
+typedef struct {
+    void *md;   // EVP_MD_CTX
+} mbedtls_md5_context;
+
+void mbedtls_md5_init(mbedtls_md5_context *ctx);
+void mbedtls_md5_free(mbedtls_md5_context *ctx);
+int mbedtls_md5_starts(mbedtls_md5_context *ctx);
+int mbedtls_md5_update(mbedtls_md5_context *ctx, const unsigned char *input, size_t len);
+int mbedtls_md5_finish(mbedtls_md5_context *ctx, unsigned char output[16]);
@@ -0,0 +1,21 @@
+#pragma once
+// Host stand-in for s3_nvs_item.h: the NVS items the cloud code reads (host_device.c)
+#include "esp_err.h"
+
+#define S3_NVS_SN_LENGTH            32
+#define S3_NVS_SECRET_KEY_LENGTH    64
+
+typedef enum {
+    DOMAIN_PRODUCTION = 0,
+    DOMAIN_STAGING,
+    DOMAIN_DEVELOPER,
+    DOMAIN_ARRAY_SIZE,
+} s3_cloud_domain_t;
+
+typedef enum {
+    NVS_S3_DEVICE_SN = 0,
+    NVS_S3_CLOUD_secret_key,
+    NVS_S3_SW_CLOUD_DOMAIN,
+} s3_nvs_item_t;
+
+esp_err_t s3_nvs_get(s3_nvs_item_t item, void *value);
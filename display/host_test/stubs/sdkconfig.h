@@ -0,0 +1,14 @@
+#pragma once
+// Host stand-in for the generated sdkconfig.h: the options the cloud code reads, as in
+// sdkconfig.defaults. The cloud host comes from the command line (host_cloud_host[]).
+#define CONFIG_SPIRAM                           1
+#define CONFIG_MBEDTLS_CERTIFICATE_BUNDLE       1
+#define CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS   1
+#define CONFIG_TRACKING_UPLOAD_BATCH            1
+#define CONFIG_TRACKING_UPLOAD_GZIP             0
+#ifndef CONFIG_CONTENT_DOWNLOAD_WORKERS
+#define CONFIG_CONTENT_DOWNLOAD_WORKERS         3
+#endif
+
+extern char host_cloud_host[64];
+#define CONFIG_CLOUD_HOST_OVERRIDE              host_cloud_host
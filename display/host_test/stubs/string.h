@@ -0,0 +1,8 @@
+// Host stand-in for newlib's string.h: glibc before 2.38 has no strlcpy/strlcat (host_stubs.c)
+#include_next <string.h>
+
+#ifndef HOST_STRING_H
+#define HOST_STRING_H
+size_t strlcpy(char *dst, const char *src, size_t size);
+size_t strlcat(char *dst, const char *src, size_t size);
+#endif
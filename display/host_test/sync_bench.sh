@@ -0,0 +1,50 @@
+#!/bin/sh
+# Full sync (sync_harness) against mock_cloud.py under each link profile: a factory-reset
+# pass (binding), a first sync onto an empty card, then a second sync with nothing changed.
+#
+#   ./sync_bench.sh build/sync_harness [profile...]
+#
+# Profiles: lan wan resets resets-norange resets-mismatch (default: all)
+set -e
+
+harness=${1:?usage: $0 path/to/sync_harness [profile...]}
+shift
+profiles=${*:-lan wan resets resets-norange resets-mismatch}
+here=$(dirname "$0")
+tmp=$(mktemp -d)
+mock=
+failed=0
+trap '[ -z "$mock" ] || kill $mock 2>/dev/null; rm -rf "$tmp"' EXIT
+
+for profile in $profiles; do
+    case $profile in
+    lan)              faults="" ;;
+    wan)              faults="--rtt-ms 150 --bandwidth-kbps 8000" ;;
+    resets)           faults="--rtt-ms 50 --bandwidth-kbps 8000 --reset-every 4 --reset-after 98304" ;;
+    resets-norange)   faults="--rtt-ms 50 --bandwidth-kbps 8000 --reset-every 4 --reset-after 98304 --range ignore" ;;
+    resets-mismatch)  faults="--rtt-ms 50 --bandwidth-kbps 8000 --reset-every 4 --reset-after 98304 --range mismatch" ;;
+    *) echo "Unknown profile $profile" >&2; exit 2 ;;
+    esac
+
+    rm -f "$tmp/port"
+    python3 "$here/mock_cloud.py" --port 0 --ready-file "$tmp/port" $faults 2>"$tmp/mock.log" &
+    mock=$!
+    while [ ! -s "$tmp/port" ]; do
+        kill -0 $mock 2>/dev/null || { cat "$tmp/mock.log" >&2; exit 1; }
+        sleep 0.1
+    done
+
+    echo "### $profile: ${faults:-no faults}"
+    status=0
+    "$harness" -H "127.0.0.1:$(cat "$tmp/port")" -b -n 3 || status=$?
+    kill $mock
+    wait $mock 2>/dev/null || true
+    mock=
+    tail -n 1 "$tmp/mock.log"
+    echo
+    if [ $status -ne 0 ]; then
+        echo "### $profile: sync failed (exit $status)"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,322 @@
+// Runs the stages of a full sync (unified_sync_task in WiFi.c) on the host against a cloud
+// host, normally mock_cloud.py, and prints for every stage its wall time, the bytes and
+// connections on the wire, and the retries at each level: the stage's own attempts, the
+// cloud API client and the download pool. The device's own s3_sync_report table follows.
+//
+//   sync_harness -H 127.0.0.1:8443 [-n passes] [-b] [-t tracking_days] [-f fw_version] [-d dir] [-k] [-v]
+//
+// -b makes the first pass a factory-reset sync, which stops after binding as on the device.
+// The SD card is a scratch directory (stubs/host_sdcard.c) kept between passes, so the second
+// pass shows the incremental sync. SNTP, the UI and the album rebuild are not run.
+#define _GNU_SOURCE     // nftw
+#include <ftw.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_test.h"
+#include "s3_definitions.h"
+#include "s3_download_pool.h"
+#include "s3_https_cloud.h"
+#include "s3_sync_account_contents.h"
+#include "s3_sync_report.h"
+#include "s3_tracking.h"
+
+extern char host_cloud_host[64];
+extern char s3_babyId[32];
+extern long long host_ota_bytes;
+void host_sdcard_set_root(const char *dir);
+
+typedef struct {
+    int64_t us;
+    host_http_stats_t wire;
+    s3_cloud_api_stats_t api;
+    s3_download_pool_stats_t pool;
+    long long ota_bytes;
+} snapshot_t;
+
+typedef struct {
+    const char *name;
+    snapshot_t start;
+    int attempts;
+    bool ok;
+} stage_t;
+
+static stage_t s_stages[8];
+static int s_stage_count;
+static bool s_failed;
+
+static void snapshot(snapshot_t *snap)
+{
+    snap->us = esp_timer_get_time();
+    host_http_get_stats(&snap->wire);
+    s3_cloud_api_get_stats(&snap->api);
+    s3_download_pool_get_totals(&snap->pool);
+    snap->ota_bytes = host_ota_bytes;
+}
+
+static stage_t *stage_begin(const char *name)
+{
+    s3_sync_report_stage(name);
+    stage_t *st = &s_stages[s_stage_count++];
+    memset(st, 0, sizeof(*st));
+    st->name = name;
+    snapshot(&st->start);
+    return st;
+}
+
+static void stage_print(const stage_t *st, const snapshot_t *end)
+{
+    const snapshot_t *a = &st->start;
+    printf("%-9s %-4s %8.1f ms | wire %8llu B out %10llu B in %3u conn %3u resumed | "
+           "retry stage %d api %u pool %u | files %3u ok %2u fail %2u resumed %2u restarted\n",
+           st->name, st->ok ? "ok" : "FAIL", (end->us - a->us) / 1000.0,
+           (unsigned long long)(end->wire.bytes_sent - a->wire.bytes_sent),
+           (unsigned long long)(end->wire.bytes_received - a->wire.bytes_received),
+           (unsigned int)(end->wire.connects - a->wire.connects),
+           (unsigned int)(end->wire.tls_resumed - a->wire.tls_resumed),
+           st->attempts > 1 ? st->attempts - 1 : 0,
+           (unsigned int)(end->api.retries - a->api.retries),
+           (unsigned int)(end->pool.retries - a->pool.retries),
+           (unsigned int)(end->pool.files_ok - a->pool.files_ok),
+           (unsigned int)(end->pool.files_failed - a->pool.files_failed),
+           (unsigned int)(end->pool.resumed - a->pool.resumed),
+           (unsigned int)(end->pool.restarted - a->pool.restarted));
+}
+
+// Same comparison as version_gt() in WiFi.c: dotted numbers, missing parts count as 0
+static bool version_gt(const char *remote, const char *local)
+{
+    int r[3] = { 0 }, l[3] = { 0 };
+    if (!remote || !local) {
+        return false;
+    }
+    sscanf(remote, "%d.%d.%d", &r[0], &r[1], &r[2]);
+    sscanf(local, "%d.%d.%d", &l[0], &l[1], &l[2]);
+    for (int i = 0; i < 3; i++) {
+        if (r[i] != l[i]) {
+            return r[i] > l[i];
+        }
+    }
+    return false;
+}
+
+// Play records for the tracking stage, one file per day as the player saves them
+static void seed_tracking(int days)
+{
+    time_t base = 1767225600;   // 2026-01-01
+    for (int d = 0; d < days; d++) {
+        for (int i = 0; i < 20; i++) {
+            char content_id[16];
+            snprintf(content_id, sizeof(content_id), "IST-%05d", i);
+            time_t start = base + d * 86400 + i * 600;
+            s3_tracking_add_record(content_id, start, start + 300, i % 2);
+        }
+        s3_tracking_save_now();
+    }
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    return remove(path);
+}
+
+static void run_stage_binding(stage_t *st)
+{
+    int code = -1;
+    st->attempts = 1;
+    st->ok = cei_complete_binding_of_device(&code) == ESP_OK;
+}
+
+static void run_stage_resource(stage_t *st)
+{
+    char *version = NULL;
+    char *url = NULL;
+    st->ok = parser_ota_resource_info(&version, &url) == ESP_OK;
+    char local[16];
+    read_resource_version_or_default(local, sizeof(local));
+    if (st->ok && version_gt(version, local)) {
+        st->ok = false;
+        for (int i = 0; i < 2 && !st->ok; i++) {
+            st->attempts++;
+            if (sync_resource_without_mp3(url, i) == ESP_OK) {
+                write_resource_version_to_file(version);
+                st->ok = true;
+            }
+        }
+    }
+    free(version);
+    free(url);
+}
+
+static void run_stage_ota(stage_t *st, const char *fw_version)
+{
+    char *version = NULL;
+    char *url = NULL;
+    st->ok = parser_ota_info(&version, &url) == ESP_OK;
+    if (st->ok && version_gt(version, fw_version)) {
+        st->ok = false;
+        for (int i = 0; i < 4 && !st->ok; i++) {
+            st->attempts++;
+            st->ok = OTA_Update(url) == ESP_OK;
+            if (!st->ok) {
+                vTaskDelay(pdMS_TO_TICKS(100));
+            }
+        }
+    }
+    free(version);
+    free(url);
+}
+
+static void run_stage_device(stage_t *st, const char *fw_version)
+{
+    char patch_data[256];
+    snprintf(patch_data, sizeof(patch_data),
+             "{\"battery\":%d,\"wifi\":\"%s\",\"fwVersion\":\"V%s\",\"mac\":\"02:00:00:00:00:01\"}",
+             87, "host-ssid", fw_version);
+    for (int i = 0; i < 3 && !st->ok; i++) {
+        st->attempts++;
+        esp_err_t ret = cei_upload_device_info(patch_data);
+        st->ok = ret == ESP_OK;
+        if (ret == CEI_INVALID_SECRET_KEY) {
+            break;
+        }
+    }
+}
+
+static bool run_stage_account(stage_t *st)
+{
+    bool modified = true;
+    esp_err_t ret = ESP_FAIL;
+    for (int i = 0; i < 4; i++) {
+        st->attempts++;
+        ret = https_download_account_file(NULL);
+        if (ret == CEI_NOT_MODIFIED && !account_contents_present()) {
+            ret = https_download_account_file(NULL);
+        }
+        if (ret == CEI_NOT_MODIFIED) {
+            modified = false;
+            ret = ESP_OK;
+        }
+        if (ret == ESP_OK) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    st->ok = ret == ESP_OK;
+    return modified;
+}
+
+static void run_pass(int pass, bool bind_only, const char *fw_version, int tracking_days)
+{
+    seed_tracking(tracking_days);
+    s_stage_count = 0;
+    s3_sync_report_begin();
+    snapshot_t begin;
+    snapshot(&begin);
+
+    stage_t *st;
+    if (bind_only) {
+        st = stage_begin("binding");
+        run_stage_binding(st);
+    } else {
+        run_stage_resource(st = stage_begin("resource"));
+        run_stage_ota(st = stage_begin("ota"), fw_version);
+        run_stage_device(st = stage_begin("device"), fw_version);
+        st = stage_begin("tracking");
+        st->attempts = 1;
+        st->ok = s3_tracking_upload_pending() == ESP_OK;
+        st = stage_begin("account");
+        bool modified = run_stage_account(st);
+        if (st->ok) {
+            st = stage_begin("contents");
+            st->attempts = 1;
+            st->ok = !modified || parser_account_contents(PARSE_AND_DOWNLOAD) == ESP_OK;
+        }
+    }
+    // WiFi stops between syncs; the TLS sessions survive for the next pass
+    s3_cloud_api_close();
+
+    snapshot_t end;
+    snapshot(&end);
+    printf("\n== pass %d%s ==\n", pass, bind_only ? " (factory reset: binding only)" : "");
+    for (int i = 0; i < s_stage_count; i++) {
+        stage_t *next = i + 1 < s_stage_count ? &s_stages[i + 1] : NULL;
+        stage_print(&s_stages[i], next ? &next->start : &end);
+        s_failed |= !s_stages[i].ok;
+    }
+    stage_t total = { .name = "total", .start = begin, .ok = true };
+    for (int i = 0; i < s_stage_count; i++) {
+        total.attempts += s_stages[i].attempts > 1 ? s_stages[i].attempts - 1 : 0;
+        total.ok &= s_stages[i].ok;
+    }
+    total.attempts++;
+    stage_print(&total, &end);
+    if (end.ota_bytes != begin.ota_bytes) {
+        printf("firmware image: %lld B\n", end.ota_bytes - begin.ota_bytes);
+    }
+    fflush(stdout);
+
+    int verbose = host_log_verbose;
+    host_log_verbose = 1;
+    s3_sync_report_end();
+    host_log_verbose = verbose;
+}
+
+int main(int argc, char **argv)
+{
+    const char *host = getenv("MOCK_CLOUD_HOST");
+    const char *dir = NULL;
+    const char *fw_version = "1.0.0";
+    int passes = 2;
+    int tracking_days = 3;
+    bool bind = false;
+    bool keep = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "H:d:n:t:f:bkv")) != -1) {
+        switch (opt) {
+        case 'H': host = optarg; break;
+        case 'd': dir = optarg; break;
+        case 'n': passes = atoi(optarg); break;
+        case 't': tracking_days = atoi(optarg); break;
+        case 'f': fw_version = optarg; break;
+        case 'b': bind = true; break;
+        case 'k': keep = true; break;
+        case 'v': host_log_verbose = 1; break;
+        default:
+            fprintf(stderr, "usage: %s -H host:port [-n passes] [-b] [-t tracking_days] [-f fw_version] [-d dir] [-k] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!host || !host[0]) {
+        fprintf(stderr, "No cloud host: pass -H host:port or set MOCK_CLOUD_HOST (see mock_cloud.py)\n");
+        return 2;
+    }
+    strlcpy(host_cloud_host, host, sizeof(host_cloud_host));
+    if (!dir) {
+        dir = host_test_path("sdcard");
+    }
+    mkdir(dir, 0775);
+    host_sdcard_set_root(dir);
+    mkdir("/sdcard/tmp", 0775);
+    strlcpy(s3_babyId, "host-mock-baby", sizeof(s3_babyId));
+
+    printf("sync_harness: https://%s, SD card %s\n", host_cloud_host, dir);
+    for (int pass = 1; pass <= passes; pass++) {
+        run_pass(pass, bind && pass == 1, fw_version, tracking_days);
+    }
+
+    if (!keep) {
+        nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    return s_failed ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+// lv_anim_player against reference frames from gifdec, on a headless LVGL display.
+// The player is included as a source file so the tests can check its cache accounting.
+#define CONFIG_ANIM_FRAME_CACHE_KB  256
+#include "../main/lv_anim_player.c"
+
+#include "host_test.h"
+#include "host_lvgl.h"
+
+#define STEP_MS     10
+
+// Writes an animated GIF with full-frame opaque images. Uses uncompressed LZW: 9-bit literal codes
+// with a clear code before the table would grow, so no encoder is needed.
+static void gif_write(const char *path, int w, int h, int frames, uint16_t delay_cs, int seed)
+{
+    FILE *f = fopen(path, "wb");
+    uint8_t lsd[] = { w & 0xff, w >> 8, h & 0xff, h >> 8, 0xf7, 0, 0 };
+    fwrite("GIF89a", 1, 6, f);
+    fwrite(lsd, 1, sizeof(lsd), f);
+    for (int i = 0; i < 256; i++) {
+        uint8_t rgb[3] = { i, 255 - i, (i * 7 + seed) & 0xff };
+        fwrite(rgb, 1, 3, f);
+    }
+    fwrite("\x21\xff\x0bNETSCAPE2.0\x03\x01\x00\x00\x00", 1, 19, f);   // Loop forever
+
+    uint8_t *block = malloc(256);
+    for (int fr = 0; fr < frames; fr++) {
+        uint8_t gce[] = { 0x21, 0xf9, 0x04, 0x04, delay_cs & 0xff, delay_cs >> 8, 0, 0 };
+        uint8_t desc[] = { 0x2c, 0, 0, 0, 0, w & 0xff, w >> 8, h & 0xff, h >> 8, 0, 8 };
+        fwrite(gce, 1, sizeof(gce), f);
+        fwrite(desc, 1, sizeof(desc), f);
+
+        uint32_t bits = 0;
+        int nbits = 0;
+        int block_len = 0;
+#define EMIT(code) do {                                                     \
+            bits |= (uint32_t)(code) << nbits;                              \
+            nbits += 9;                                                     \
+            while (nbits >= 8) {                                            \
+                block[1 + block_len++] = bits & 0xff;                       \
+                bits >>= 8;                                                 \
+                nbits -= 8;                                                 \
+                if (block_len == 255) {                                     \
+                    block[0] = 255;                                         \
+                    fwrite(block, 1, 256, f);                               \
+                    block_len = 0;                                          \
+                }                                                           \
+            }                                                               \
+        } while (0)
+        for (int i = 0; i < w * h; i++) {
+            if (i % 250 == 0) {
+                EMIT(256);
+            }
+            int x = i % w, y = i / w;
+            EMIT((x + y * 3 + fr * 17 + seed) & 0xff);
+        }
+        EMIT(257);
+        if (nbits > 0) {
+            EMIT(0);    // Pads the last byte; the decoder stops at the end code
+        }
+#undef EMIT
+        if (block_len) {
+            block[0] = block_len;
+            fwrite(block, 1, block_len + 1, f);
+        }
+        fputc(0, f);
+    }
+    fputc(0x3b, f);
+    fclose(f);
+    free(block);
+}
+
+typedef struct {
+    int count;
+    size_t size;
+    uint8_t **frames;
+} reference_t;
+
+static reference_t reference_decode(const char *path)
+{
+    reference_t ref = { 0 };
+    FILE *f = fopen(path, "rb");
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(size);
+    fread(data, 1, size, f);
+    fclose(f);
+
+    gd_GIF *gif = gd_open_gif_data(data);
+    ref.size = (size_t)gif->width * gif->height * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    while (gd_get_frame(gif) == 1) {
+        gif->loop_count = -1;   // One pass: report the trailer instead of rewinding
+        gd_render_frame(gif, gif->canvas);
+        ref.frames = realloc(ref.frames, (ref.count + 1) * sizeof(*ref.frames));
+        ref.frames[ref.count] = malloc(ref.size);
+        memcpy(ref.frames[ref.count++], gif->canvas, ref.size);
+    }
+    gd_close_gif(gif);
+    free(data);
+    return ref;
+}
+
+static anim_player_t *player_of(lv_obj_t *obj)
+{
+    for (anim_player_t *p = s_players; p; p = p->next) {
+        if (p->obj == obj) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Runs the players for ms, checking after every step that each shows its own frame and the budget holds
+static void run_checked(lv_obj_t **objs, const reference_t **refs, int n, uint32_t ms, const char *what)
+{
+    for (uint32_t t = 0; t < ms; t += STEP_MS) {
+        host_lvgl_run(STEP_MS, STEP_MS, NULL);
+        HOST_CHECK(s_cache_bytes <= ANIM_CACHE_BUDGET, "%s: cache %zu bytes over the %zu budget",
+                   what, s_cache_bytes, ANIM_CACHE_BUDGET);
+        for (int i = 0; i < n; i++) {
+            anim_player_t *p = player_of(objs[i]);
+            if (!p || p->index >= refs[i]->count ||
+                memcmp(p->dsc.data, refs[i]->frames[p->index], refs[i]->size) != 0) {
+                HOST_CHECK(false, "%s: player %d shows the wrong pixels for frame %d at %u ms", what, i,
+                           p ? p->index : -1, t);
+                return;
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    host_lvgl_init();
+    lv_obj_t *scr = lv_scr_act();
+
+    // Budget 256 KB. medium: 50x50, 20 frames, 146 KB cached, 56 KB file. big: 64x64, 24 frames,
+    // 288 KB of frames so it streams, 108 KB file and a 16 KB decoder.
+    const char *medium_path = host_test_path("medium.gif");
+    const char *big_path = host_test_path("big.gif");
+    gif_write(medium_path, 50, 50, 20, 5, 2);
+    gif_write(big_path, 64, 64, 24, 5, 3);
+    reference_t medium = reference_decode(medium_path);
+    reference_t big = reference_decode(big_path);
+    HOST_CHECK(medium.count == 20 && big.count == 24, "reference frame counts %d %d", medium.count, big.count);
+
+    // Cached playback, then a second showing served entirely from the cache
+    lv_obj_t *obj = lv_anim_player_create(scr, medium_path);
+    HOST_CHECK(obj != NULL, "medium GIF did not open");
+    const reference_t *refs[2] = { &medium, &medium };
+    run_checked(&obj, refs, 1, 2000, "medium first showing");
+    anim_entry_t *a = player_of(obj)->anim;
+    HOST_CHECK(a->complete && !a->gif && !a->data, "medium GIF not fully cached");
+    lv_obj_del(obj);
+    obj = lv_anim_player_create(scr, medium_path);
+    uint32_t decoded_before = player_of(obj)->decoded;
+    run_checked(&obj, refs, 1, 2000, "medium cached showing");
+    HOST_CHECK(player_of(obj)->decoded == decoded_before, "cached showing decoded %u frames",
+               player_of(obj)->decoded - decoded_before);
+
+    // With the medium GIF on screen, the big one's file and decoder do not fit: not opened
+    lv_obj_t *big_obj = lv_anim_player_create(scr, big_path);
+    HOST_CHECK(big_obj == NULL, "big GIF opened beyond the budget");
+    HOST_CHECK(s_cache_bytes <= ANIM_CACHE_BUDGET, "open went over the budget: %zu", s_cache_bytes);
+
+    // Off screen, the medium GIF is evicted to make room before the big one is counted
+    lv_obj_del(obj);
+    lv_obj_t *objs[2];
+    objs[0] = lv_anim_player_create(scr, big_path);
+    HOST_CHECK(objs[0] != NULL, "big GIF did not open after eviction");
+    HOST_CHECK(s_anims && !s_anims->next, "medium GIF still cached next to the big one");
+    refs[0] = &big;
+    run_checked(objs, refs, 1, 700, "big alone");
+    HOST_CHECK(player_of(objs[0])->anim->streaming, "big GIF did not fall back to streaming");
+
+    // A second player on the streaming GIF decodes on its own, offset from the first
+    objs[1] = lv_anim_player_create(scr, big_path);
+    HOST_CHECK(objs[1] != NULL, "second player on the streaming GIF");
+    refs[1] = &big;
+    run_checked(objs, refs, 2, 4000, "two players on one streaming GIF");
+    HOST_CHECK(player_of(objs[0])->gif && player_of(objs[1])->gif &&
+               player_of(objs[0])->gif != player_of(objs[1])->gif, "players share a decoder");
+    lv_obj_del(objs[1]);
+    run_checked(objs, refs, 1, 500, "first player after the second is gone");
+
+    lv_obj_del(objs[0]);
+    HOST_CHECK(s_anims == NULL && s_cache_bytes == 0, "%zu bytes left after the last player", s_cache_bytes);
+
+    // Two players filling the cache together: when it stops fitting, the one that hit the limit keeps
+    // the decoder and the other restarts on a decoder of its own
+    objs[0] = lv_anim_player_create(scr, big_path);
+    host_lvgl_run(120, STEP_MS, NULL);
+    objs[1] = lv_anim_player_create(scr, big_path);
+    HOST_CHECK(!player_of(objs[1])->anim->streaming, "second player joined after the fallback");
+    run_checked(objs, refs, 2, 4000, "two players when the GIF starts streaming");
+    HOST_CHECK(player_of(objs[0])->gif && player_of(objs[1])->gif &&
+               player_of(objs[0])->gif != player_of(objs[1])->gif, "players share a decoder after the fallback");
+
+    lv_obj_clean(scr);
+    HOST_CHECK(s_anims == NULL && s_cache_bytes == 0, "%zu bytes left after clearing the screen", s_cache_bytes);
+    remove(medium_path);
+    remove(big_path);
+
+    printf("test_anim_player: %s (%d failures)\n", host_test_failures ? "FAILED" : "passed", host_test_failures);
+    return host_test_failures != 0;
+}
@@ -0,0 +1,234 @@
+// Random-offset seek tests for the XOR decryption, against a byte-by-byte reference.
+// Covers xor_decrypt_buffer(), the xor_decrypt_filter element with queued key jumps, and the
+// sd_track_reader decrypting in place, both on their own and chained reader -> filter.
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+#include "esp_random.h"
+#include "audio_element.h"
+#include "xor_decrypt_filter.h"
+#include "sd_track_reader.h"
+
+#define FILE_SIZE   (64 * 1024)
+
+static uint8_t s_plain[FILE_SIZE];
+static uint8_t s_cipher[FILE_SIZE];
+
+static void reference_encrypt(void)
+{
+    esp_fill_random(s_plain, FILE_SIZE);
+    for (int i = 0; i < FILE_SIZE; i++) {
+        s_cipher[i] = s_plain[i] ^ (uint8_t)XOR_HARDCODED_KEY[i % XOR_HARDCODED_KEY_LEN];
+    }
+}
+
+// Any length, buffer alignment and key phase, including offsets past 4 GB
+static void test_buffer_random_offsets(int iterations)
+{
+    uint8_t buf[512 + 4];
+    for (int it = 0; it < iterations; it++) {
+        uint64_t base = ((uint64_t)esp_random() << 3) + esp_random() % FILE_SIZE;
+        size_t len = esp_random() % 512;
+        size_t align = esp_random() % 4;
+        uint8_t *data = buf + align;
+        esp_fill_random(data, len);
+        uint8_t expected[512];
+        for (size_t i = 0; i < len; i++) {
+            expected[i] = data[i] ^ (uint8_t)XOR_HARDCODED_KEY[(base + i) % XOR_HARDCODED_KEY_LEN];
+        }
+        xor_decrypt_buffer(data, len, base);
+        HOST_CHECK(memcmp(data, expected, len) == 0, "buffer offset %llu len %zu align %zu",
+                   (unsigned long long)base, len, align);
+    }
+}
+
+typedef struct {
+    const uint8_t *in;
+    int in_len;
+    int in_pos;
+    uint8_t *out;
+    int out_len;
+} stream_io_t;
+
+// Ring buffer reads of varying length
+static int stream_input(void *ctx, char *buffer, int len)
+{
+    stream_io_t *io = ctx;
+    int n = io->in_len - io->in_pos;
+    if (n <= 0) {
+        return AEL_IO_DONE;
+    }
+    int chunk = 1 + esp_random() % len;
+    if (n > chunk) {
+        n = chunk;
+    }
+    memcpy(buffer, io->in + io->in_pos, n);
+    io->in_pos += n;
+    return n;
+}
+
+static int stream_output(void *ctx, char *buffer, int len)
+{
+    stream_io_t *io = ctx;
+    memcpy(io->out + io->out_len, buffer, len);
+    io->out_len += len;
+    return len;
+}
+
+// Filter element: start offset queued before open, then a seek queued while running
+static void test_filter_element_seeks(int iterations)
+{
+    xor_decrypt_cfg_t cfg = DEFAULT_XOR_DECRYPT_CONFIG();
+    audio_element_handle_t el = xor_decrypt_filter_init(&cfg);
+    HOST_CHECK(el != NULL, "xor_decrypt_filter_init");
+    uint8_t *in = malloc(2 * FILE_SIZE);
+    uint8_t *out = malloc(2 * FILE_SIZE);
+
+    for (int it = 0; it < iterations && el; it++) {
+        uint32_t seek_a = esp_random() % FILE_SIZE;
+        uint32_t len_a = 1 + esp_random() % (FILE_SIZE - seek_a);
+        uint32_t seek_b = esp_random() % FILE_SIZE;
+        uint32_t len_b = 1 + esp_random() % (FILE_SIZE - seek_b);
+        memcpy(in, s_cipher + seek_a, len_a);
+        memcpy(in + len_a, s_cipher + seek_b, len_b);
+
+        stream_io_t io = { .in = in, .in_len = len_a + len_b, .out = out };
+        host_element_set_io(el, stream_input, stream_output, &io);
+        xor_decrypt_filter_set_key_offset_at(el, 0, seek_a);
+        host_element_open(el);
+        xor_decrypt_filter_set_key_offset_at(el, len_a, seek_b);
+        while (host_element_process(el) > 0) {
+        }
+        host_element_close(el);
+
+        HOST_CHECK(io.out_len == io.in_len, "filter output %d of %d bytes", io.out_len, io.in_len);
+        HOST_CHECK(memcmp(out, s_plain + seek_a, len_a) == 0 && memcmp(out + len_a, s_plain + seek_b, len_b) == 0,
+                   "filter seek %u+%u then %u+%u", seek_a, len_a, seek_b, len_b);
+    }
+    if (el) {
+        host_element_destroy(el);
+    }
+    free(in);
+    free(out);
+}
+
+static void reader_switch_cb(audio_element_handle_t el, const char *uri, uint64_t stream_pos, int64_t file_pos, void *ctx)
+{
+    xor_decrypt_filter_set_key_offset_at(ctx, stream_pos, file_pos);
+}
+
+// Reader output in random-sized reads, seeking once seek_at bytes have been handed out
+typedef struct {
+    audio_element_handle_t reader;
+    uint32_t seek_at;
+    uint32_t seek_to;
+    bool seeked;
+    uint32_t emitted;
+    stream_io_t io;
+} reader_src_t;
+
+static int reader_src_read(void *ctx, char *buffer, int len)
+{
+    reader_src_t *src = ctx;
+    if (!src->seeked && src->emitted == src->seek_at) {
+        sd_track_reader_seek(src->reader, src->seek_to);
+        src->seeked = true;
+    }
+    int want = 1 + esp_random() % len;
+    if (!src->seeked && src->emitted + want > src->seek_at) {
+        want = src->seek_at - src->emitted;
+    }
+    int n = host_element_read(src->reader, buffer, want);
+    if (n <= 0) {
+        return AEL_IO_DONE;
+    }
+    src->emitted += n;
+    return n;
+}
+
+static int reader_src_output(void *ctx, char *buffer, int len)
+{
+    return stream_output(&((reader_src_t *)ctx)->io, buffer, len);
+}
+
+/**
+ * Reader opened at a random byte (as audio_play_from_position() does), then seeked while running.
+ * fused: the reader decrypts in place. chained: plain reader -> filter, realigned through switch_cb,
+ * with the pre-seek bytes still in flight when the seek is applied.
+ */
+static void test_reader_seeks(const char *path, bool fused, int iterations)
+{
+    sd_track_reader_cfg_t reader_cfg = SD_TRACK_READER_CFG_DEFAULT();
+    reader_cfg.decrypt = fused;
+    audio_element_handle_t reader = sd_track_reader_init(&reader_cfg);
+    xor_decrypt_cfg_t filter_cfg = DEFAULT_XOR_DECRYPT_CONFIG();
+    audio_element_handle_t filter = fused ? NULL : xor_decrypt_filter_init(&filter_cfg);
+    if (filter) {
+        sd_track_reader_set_chain_cb(reader, NULL, reader_switch_cb, filter);
+    }
+    uint8_t *out = malloc(2 * FILE_SIZE);
+    char buf[4096];
+    audio_element_set_uri(reader, path);
+
+    for (int it = 0; it < iterations; it++) {
+        uint32_t seek_a = esp_random() % FILE_SIZE;
+        reader_src_t src = {
+            .reader = reader,
+            .seek_at = 1 + esp_random() % (FILE_SIZE - seek_a),
+            .seek_to = esp_random() % FILE_SIZE,
+            .io.out = out,
+        };
+        uint32_t len_a = src.seek_at;
+        uint32_t len_b = FILE_SIZE - src.seek_to;
+
+        sd_track_reader_seek(reader, seek_a);
+        host_element_open(reader);
+        if (filter) {
+            host_element_set_io(filter, reader_src_read, reader_src_output, &src);
+            host_element_open(filter);
+            while (host_element_process(filter) > 0) {
+            }
+            host_element_close(filter);
+        } else {
+            int n;
+            while ((n = reader_src_read(&src, buf, sizeof(buf))) > 0) {
+                stream_output(&src.io, buf, n);
+            }
+        }
+        host_element_close(reader);
+
+        HOST_CHECK(src.io.out_len == (int)(len_a + len_b), "%s reader output %d, expected %u",
+                   fused ? "fused" : "chained", src.io.out_len, len_a + len_b);
+        HOST_CHECK(memcmp(out, s_plain + seek_a, len_a) == 0 && memcmp(out + len_a, s_plain + src.seek_to, len_b) == 0,
+                   "%s reader open at %u, %u bytes, seek to %u", fused ? "fused" : "chained", seek_a, len_a, src.seek_to);
+    }
+    host_element_destroy(reader);
+    if (filter) {
+        host_element_destroy(filter);
+    }
+    free(out);
+}
+
+int main(void)
+{
+    host_random_seed(0x5eed0005);
+    reference_encrypt();
+
+    const char *path = host_test_path("xor_seek.bin");
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(s_cipher, 1, FILE_SIZE, f) != FILE_SIZE) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return 1;
+    }
+    fclose(f);
+
+    test_buffer_random_offsets(20000);
+    HOST_CHECK(xor_decrypt_filter_test_seek(2000) == ESP_OK, "xor_decrypt_filter_test_seek");
+    test_filter_element_seeks(1000);
+    test_reader_seeks(path, true, 500);
+    test_reader_seeks(path, false, 500);
+    remove(path);
+
+    printf("test_xor_decrypt: %s (%d failures)\n", host_test_failures ? "FAILED" : "passed", host_test_failures);
+    return host_test_failures != 0;
+}
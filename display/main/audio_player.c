@@ -29,6 +29,9 @@
 #include <sys/types.h>
 #include <string.h>
 #include "xor_decrypt_filter.h"
+#include "sd_track_reader.h"
+#include "sfx_mixer.h"
+#include "raw_stream.h"
 
 #include "s3_nvs_item.h"
 
@@ -36,14 +39,15 @@
 #include "s3_bluetooth.h"
 #include "s3_album_mgr.h"
 #include "s3_definitions.h"
+#include "s3_content_index.h"
 #include "s3_sync_account_contents.h"
 #include "s3_tracking.h"
-#include "cJSON.h"
 #include <unistd.h>
 #include "audio_event_iface.h"
 #include "lv_screen_mgr.h"
 #include "s3_nfc_handler.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "alc5616.h"
 #include "backlight.h"
 #include "app_state_machine.h"
@@ -89,15 +93,68 @@ static size_t shuffle_count = 0;                 // Number of tracks in current
 // Audio pipeline handles
 static audio_pipeline_handle_t active_pipeline = NULL;
 static audio_element_handle_t fatfs_reader = NULL;
-static audio_element_handle_t xor_filter = NULL;
 static audio_element_handle_t mp3_decoder = NULL;
+static audio_element_handle_t sfx_mixer = NULL;     // Overlays sound effects on the decoded PCM
 // Keep track of the current pipeline
 static audio_element_handle_t current_sink_element = NULL;
+static audio_sink_t active_pipeline_sink = AUDIO_SINK_I2S;
+static bool active_pipeline_encrypted = false;
+static bool active_pipeline_reusable = false;   // Set once the pipeline is fully built and linked
+
+// Parked pipeline: a stopped and reset pipeline kept alive between tracks so the
+// next play with the same sink only re-points the URI (and the reader's decrypt flag) instead of
+// allocating, linking and tearing down element tasks and ring buffers again.
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_element_handle_t  fatfs_reader;
+    audio_element_handle_t  mp3_decoder;
+    audio_element_handle_t  sfx_mixer;
+    audio_element_handle_t  sink_element;
+    audio_sink_t            sink;
+} parked_pipeline_t;
+
+static parked_pipeline_t parked_pipeline = {0};
+
+// Gapless chaining: the file reader pre-opens the next track near EOF and continues the
+// same stream into it, so the decoder never drains between tracks of an album.
+static size_t gapless_next_idx = 0;               // Track index handed to the reader (track_mutex)
+static size_t gapless_next_shuffle_pos = 0;       // Shuffle position of gapless_next_idx (track_mutex)
+static volatile bool gapless_switch_pending = false;  // Reader crossed into the next track, bookkeeping pending
+static volatile uint32_t gapless_generation = 0;  // Bumped whenever playback is stopped or retargeted
+static uint32_t gapless_chained_generation = 0;   // gapless_generation when the next track was chained (track_mutex)
+
+// Start-of-track prefill: the mixer holds the sink back until CONFIG_AUDIO_PREFILL_MS is decoded
+static SemaphoreHandle_t prefill_ready_sem = NULL;  // Given by the mixer task when the watermark is reached
 
 // Sound effect quick playback state
-static bool sound_effect_playing = false;
-static char *saved_track_uri = NULL;  // Save current track for restoration
-static bool was_playing_before_effect = false;  // Save previous playback state
+static bool sound_effect_playing = false;       // Standalone effect owns the pipeline
+
+// Effects mixed over a playing track are decoded to PSRAM PCM first
+#define SOUND_EFFECT_PCM_MAX_BYTES  (1024 * 1024)   // ~6 s of 44.1 kHz stereo
+#define SOUND_EFFECT_DECODE_CHUNK   (4 * 1024)
+
+// Decoded system sounds, kept in PSRAM at the sink format so UI sounds skip file access and decoding
+#define SOUND_CACHE_MAX_ENTRIES     8
+#define SOUND_CACHE_MAX_BYTES       (CONFIG_SOUND_EFFECT_CACHE_KB * 1024)
+#define SOUND_CACHE_SAMPLE_RATE     44100           // I2S_STREAM_CFG_DEFAULT rate, same as album content
+#define SOUND_CACHE_CHANNELS        2
+
+typedef struct {
+    char    *path;
+    int16_t *pcm;
+    size_t   frames;
+    size_t   bytes;
+    off_t    file_size;         // Asset identity at decode time - a mismatch means the file changed
+    time_t   file_mtime;
+    int      refs;              // Clips handed out and not yet released (sound_cache_spin)
+    bool     detached;          // Dropped from the cache while referenced - freed on last release
+    int64_t  last_used_us;
+} sound_cache_entry_t;
+
+static sound_cache_entry_t *sound_cache[SOUND_CACHE_MAX_ENTRIES];
+static size_t sound_cache_bytes = 0;
+static SemaphoreHandle_t sound_cache_mutex = NULL;   // Serialises lookups, decodes and eviction
+static portMUX_TYPE sound_cache_spin = portMUX_INITIALIZER_UNLOCKED;  // refs/detached (mixer task releases)
 static bool suppress_auto_play_once = false;    // Skip one auto-advance after manual stop/effect
 
 // Mute timer for ALC5616 codec (I2S sink only)
@@ -148,6 +205,18 @@ bool is_state_stable(void) {
 
 // Forward declarations
 static void stop_active_pipeline_internal(void);
+static void release_parked_pipeline_internal(void);
+static void relink_parked_sink(void);
+static esp_err_t release_parked_pipeline(void);
+static char *gapless_next_track_cb(audio_element_handle_t el, void *ctx);
+static void track_reader_position_cb(audio_element_handle_t el, const char *uri, uint64_t stream_pos, int64_t file_pos, void *ctx);
+static void apply_gapless_track_switch(void);
+static void gapless_cancel(void);
+static void sound_cache_preload_task(void *pvParameters);
+static bool audio_play_cached_sound_effect(const char *path, sfx_mixer_clip_t *clip);
+static bool audio_play_sound_effect_quick_internal(const char *path, bool *mixed);
+static void play_system_sound(const char *path);
+static bool sound_cache_get_clip(const char *path, sfx_mixer_clip_t *clip);
 static void cleanup_simple_shuffle(void);
 bool init_persistent_i2s_element(void);
 void cleanup_persistent_i2s_element(void);
@@ -167,123 +236,6 @@ static void save_tracking_record_if_active(void);
 static void cleanup_playback_tracking(void);
 int track_name_compare(const void *a, const void *b);
 
-/**
- * @brief Get list of filenames from account_file.json for a specific SKURC SKU
- * @param sku The SKURC SKU to look for (e.g., "SKURC-045CA493C12A81")
- * @param filename_count Output parameter - number of filenames found
- * @return Array of filename strings, or NULL on error. Caller must free array and strings.
- */
-static char** get_skurc_filenames_from_account(const char *sku, int *filename_count) {
-    if (!sku || !filename_count) {
-        return NULL;
-    }
-    
-    *filename_count = 0;
-    
-    // Read account_file.json from /sdcard/tmp/
-    // Get file size using stat
-    struct stat st;
-    if (stat("/sdcard/tmp/account_file.json", &st) != 0) {
-        ESP_LOGD(TAG, "Could not stat /sdcard/tmp/account_file.json for SKURC lookup");
-        return NULL;
-    }
-
-    long file_size = st.st_size;
-    if (file_size <= 0 || file_size > 1024*1024) { // Max 1MB safety check
-        return NULL;
-    }
-
-    FILE *fp = fopen("/sdcard/tmp/account_file.json", "r");
-    if (!fp) {
-        ESP_LOGD(TAG, "Could not open /sdcard/tmp/account_file.json for SKURC lookup");
-        return NULL;
-    }
-    
-    // Read file
-    char *json_string = malloc(file_size + 1);
-    if (!json_string) {
-        fclose(fp);
-        return NULL;
-    }
-    
-    size_t read_size = fread(json_string, 1, file_size, fp);
-    fclose(fp);
-    json_string[read_size] = '\0';
-    
-    // Parse JSON
-    cJSON *root = cJSON_Parse(json_string);
-    free(json_string);
-    
-    if (!root) {
-        return NULL;
-    }
-    
-    char **filenames = NULL;
-    int count = 0;
-    
-    // Navigate: result -> NFCs -> find matching SKU -> contents -> filenames
-    cJSON *result = cJSON_GetObjectItem(root, "result");
-    cJSON *nfcs = result ? cJSON_GetObjectItem(result, "NFCs") : NULL;
-    
-    if (cJSON_IsArray(nfcs)) {
-        int nfc_count = cJSON_GetArraySize(nfcs);
-        for (int i = 0; i < nfc_count && !filenames; i++) {
-            cJSON *nfc = cJSON_GetArrayItem(nfcs, i);
-            cJSON *skus = cJSON_IsObject(nfc) ? cJSON_GetObjectItem(nfc, "skus") : NULL;
-            
-            if (cJSON_IsArray(skus)) {
-                int sku_count = cJSON_GetArraySize(skus);
-                for (int j = 0; j < sku_count && !filenames; j++) {
-                    cJSON *sku_obj = cJSON_GetArrayItem(skus, j);
-                    cJSON *skuId = cJSON_IsObject(sku_obj) ? cJSON_GetObjectItem(sku_obj, "skuId") : NULL;
-                    
-                    if (cJSON_IsString(skuId) && strcmp(skuId->valuestring, sku) == 0) {
-                        // Found our SKURC SKU
-                        cJSON *contents = cJSON_GetObjectItem(sku_obj, "contents");
-                        if (cJSON_IsArray(contents)) {
-                            int content_count = cJSON_GetArraySize(contents);
-                            if (content_count > 0) {
-                                filenames = malloc(content_count * sizeof(char*));
-                                if (filenames) {
-                                    for (int k = 0; k < content_count; k++) {
-                                        cJSON *content = cJSON_GetArrayItem(contents, k);
-                                        cJSON *filename = cJSON_IsObject(content) ? cJSON_GetObjectItem(content, "filename") : NULL;
-
-                                        if (cJSON_IsString(filename)) {
-                                            filenames[count] = strdup_spiram(filename->valuestring);
-                                            if (filenames[count]) {
-                                                count++;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    cJSON_Delete(root);
-    
-    if (count > 0) {
-        *filename_count = count;
-        ESP_LOGI(TAG, "Found %d SKURC filenames for SKU '%s' from account data", count, sku);
-        return filenames;
-    }
-    
-    // Cleanup on failure
-    if (filenames) {
-        for (int i = 0; i < count; i++) {
-            free(filenames[i]);
-        }
-        free(filenames);
-    }
-    
-    return NULL;
-}
-
 // Audio handlers
 // Global variable s3_current_alarm is defined in s3_definitions.c and declared in s3_definitions.h
 
@@ -374,6 +326,22 @@ esp_err_t audio_player_init(void)
         }
     }
 
+    if (sound_cache_mutex == NULL) {
+        sound_cache_mutex = xSemaphoreCreateMutex();
+        if (sound_cache_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create sound cache mutex");
+            return ESP_FAIL;
+        }
+    }
+
+    if (prefill_ready_sem == NULL) {
+        prefill_ready_sem = xSemaphoreCreateBinary();
+        if (prefill_ready_sem == NULL) {
+            ESP_LOGE(TAG, "Failed to create prefill semaphore");
+            return ESP_FAIL;
+        }
+    }
+
     vTaskDelay(pdMS_TO_TICKS(100));
     audio_power_on();
 
@@ -393,6 +361,12 @@ esp_err_t audio_player_init(void)
     cleanup_simple_shuffle();
     audio_update_album_data();
 
+    // Decode system sounds in the background so the first UI sound is already cached
+    if (xTaskCreatePinnedToCoreWithCaps(sound_cache_preload_task, "snd_cache", (4 * 1024), NULL, 2,
+                                        NULL, 0, MALLOC_CAP_SPIRAM) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to start sound cache preload - sounds will be decoded on first use");
+    }
+
     return ESP_OK;
 }
 
@@ -408,6 +382,7 @@ void audio_player_cleanup(void)
         if (active_pipeline) {
             stop_active_pipeline_internal();
         }
+        release_parked_pipeline_internal();
         xSemaphoreGive(audio_mutex);
     }
 
@@ -425,6 +400,9 @@ void audio_player_cleanup(void)
     // Clean up tracking state (#15141)
     cleanup_playback_tracking();
 
+    // Drop decoded system sounds (entries still referenced are freed on release)
+    audio_sound_cache_invalidate(NULL);
+
     // Clean up mutexes
     if (track_mutex) {
         vSemaphoreDelete(track_mutex);
@@ -434,6 +412,10 @@ void audio_player_cleanup(void)
         vSemaphoreDelete(audio_mutex);
         audio_mutex = NULL;
     }
+    if (prefill_ready_sem) {
+        vSemaphoreDelete(prefill_ready_sem);
+        prefill_ready_sem = NULL;
+    }
 
     ESP_LOGI(TAG, "Audio player cleanup complete");
 }
@@ -552,6 +534,13 @@ void cleanup_persistent_i2s_element(void)
 {
     if (persistent_i2s_writer) {
         ESP_LOGI(TAG, "Cleaning up persistent I2S writer element");
+
+        // A parked I2S pipeline still has the writer registered - release it first, and keep the
+        // writer alive if that is not possible
+        if (release_parked_pipeline() != ESP_OK) {
+            ESP_LOGE(TAG, "Parked pipeline still references the I2S writer - skipping I2S cleanup");
+            return;
+        }
         
         // Mute codec BEFORE deinitializing I2S element to prevent audio pop
         if (s3_active_sink == AUDIO_SINK_I2S && !codec_is_muted) {
@@ -579,6 +568,7 @@ static void cleanup_simple_shuffle(void) {
     }
     shuffle_count = 0;
     shuffle_position = 0;
+    gapless_cancel();
 }
 
 /**
@@ -620,35 +610,17 @@ static bool wait_for_pipeline_stop(uint32_t timeout_ms)
 }
 
 /**
- * @brief Safely stop and cleanup any active audio pipeline
- * @note This version doesn't attempt to take the mutex, must be called from a function that already holds it
+ * @brief Terminate and deinit a stopped pipeline together with its elements
+ * @note The persistent I2S writer is unregistered first so it survives the deinit
  */
-static void stop_active_pipeline_internal(void)
+static void teardown_pipeline(audio_pipeline_handle_t pipeline,
+                              audio_element_handle_t reader,
+                              audio_element_handle_t decoder,
+                              audio_element_handle_t sink)
 {
-    ESP_LOGI(TAG, "stop_active_pipeline_internal()");
-
-    if (active_pipeline == NULL) {
-        audio_state = AUDIO_STATE_STOPPED;
-        return;
-    }
-
-    // Save tracking record for manual stops (#15141)
-    save_tracking_record_if_active();
-
-    // Codec mute handled by timer system after pipeline stops
-
-    // If the active sink was A2DP, tell the BT stack to stop streaming
-    if (s3_active_sink == AUDIO_SINK_A2DP) {
-        bt_a2dp_stop_media();
-        // Give time for L2CAP layer to flush buffers - reduced to prevent audio event queue overflow
-        vTaskDelay(pdMS_TO_TICKS(500));  // Reduced from 1500ms - balance between L2CAP flush and event queue health
-    }
-
     ESP_LOGI(TAG, "Terminating pipeline...");
-    audio_pipeline_stop(active_pipeline);
-    audio_pipeline_wait_for_stop(active_pipeline);
-    audio_pipeline_terminate(active_pipeline);
-    
+    audio_pipeline_terminate(pipeline);
+
     // Wait for element tasks to reach stopped state before deinit
     // This prevents crash when deinit destroys event groups while tasks are still exiting
     uint16_t wait_ms = 0;
@@ -656,30 +628,30 @@ static void stop_active_pipeline_internal(void)
     while (wait_ms < max_wait_ms) {
         // Check individual element states since there's no audio_pipeline_get_state()
         bool all_stopped = true;
-        if (fatfs_reader) {
-            audio_element_state_t state = audio_element_get_state(fatfs_reader);
+        if (reader) {
+            audio_element_state_t state = audio_element_get_state(reader);
             if (state != AEL_STATE_STOPPED && state != AEL_STATE_INIT) {
                 all_stopped = false;
             }
         }
-        if (mp3_decoder && all_stopped) {
-            audio_element_state_t state = audio_element_get_state(mp3_decoder);
+        if (decoder && all_stopped) {
+            audio_element_state_t state = audio_element_get_state(decoder);
             if (state != AEL_STATE_STOPPED && state != AEL_STATE_INIT) {
                 all_stopped = false;
             }
         }
-        if (current_sink_element && current_sink_element != persistent_i2s_writer && all_stopped) {
-            audio_element_state_t state = audio_element_get_state(current_sink_element);
+        if (sink && sink != persistent_i2s_writer && all_stopped) {
+            audio_element_state_t state = audio_element_get_state(sink);
             if (state != AEL_STATE_STOPPED && state != AEL_STATE_INIT) {
                 all_stopped = false;
             }
         }
-        
+
         if (all_stopped) {
             ESP_LOGI(TAG, "All elements stopped after %d ms", wait_ms);
             break;
         }
-        
+
         vTaskDelay(pdMS_TO_TICKS(10));
         wait_ms += 10;
     }
@@ -689,23 +661,135 @@ static void stop_active_pipeline_internal(void)
     // We only need to unregister the persistent I2S element to prevent it from being destroyed
 
     // Unregister persistent I2S element BEFORE deinit to preserve it
-    if (current_sink_element == persistent_i2s_writer) {
-        audio_pipeline_unregister(active_pipeline, persistent_i2s_writer);
+    if (sink == persistent_i2s_writer) {
+        audio_pipeline_unregister(pipeline, persistent_i2s_writer);
         ESP_LOGI(TAG, "Unregistered persistent I2S element before pipeline deinit");
     }
 
     // De-initialize the pipeline (this unlinks ringbuffers and deinits all REGISTERED elements)
-    audio_pipeline_deinit(active_pipeline);
+    audio_pipeline_deinit(pipeline);
+}
+
+/**
+ * @brief Destroy the parked pipeline, if any
+ * @note Must be called with audio_mutex held
+ */
+static void release_parked_pipeline_internal(void)
+{
+    if (parked_pipeline.pipeline == NULL) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Releasing parked pipeline (sink=%d)", parked_pipeline.sink);
+    teardown_pipeline(parked_pipeline.pipeline, parked_pipeline.fatfs_reader,
+                      parked_pipeline.mp3_decoder, parked_pipeline.sink_element);
+    memset(&parked_pipeline, 0, sizeof(parked_pipeline));
+}
+
+/**
+ * @brief Point the I2S writer back at the parked pipeline's mixer output
+ * @note A cached sound effect borrows the persistent I2S writer for its own clip pipeline, which
+ *       replaces the writer's input ring buffer; tearing that pipeline down frees the buffer.
+ *       Must be called with audio_mutex held, after the borrowing pipeline is gone.
+ */
+static void relink_parked_sink(void)
+{
+    if (parked_pipeline.pipeline == NULL || parked_pipeline.sink_element != persistent_i2s_writer ||
+        parked_pipeline.sfx_mixer == NULL) {
+        return;
+    }
+
+    ringbuf_handle_t rb = audio_element_get_output_ringbuf(parked_pipeline.sfx_mixer);
+    if (rb == NULL || audio_element_set_input_ringbuf(persistent_i2s_writer, rb) != ESP_OK) {
+        ESP_LOGW(TAG, "Could not relink I2S writer to the parked pipeline - releasing it");
+        release_parked_pipeline_internal();
+        return;
+    }
+    ESP_LOGD(TAG, "I2S writer relinked to the parked pipeline");
+}
+
+/**
+ * @brief Thread-safe wrapper for releasing the parked pipeline
+ * @return ESP_OK when nothing is parked any more, ESP_ERR_TIMEOUT when the mutex could not be
+ *         taken and the parked pipeline (and the I2S writer it references) is still alive
+ */
+static esp_err_t release_parked_pipeline(void)
+{
+    if (audio_mutex == NULL) {
+        release_parked_pipeline_internal();
+        return ESP_OK;
+    }
+
+    if (xSemaphoreTake(audio_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to acquire mutex for parked pipeline release");
+        return ESP_ERR_TIMEOUT;
+    }
+    release_parked_pipeline_internal();
+    xSemaphoreGive(audio_mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Safely stop any active audio pipeline
+ * @note This version doesn't attempt to take the mutex, must be called from a function that already holds it
+ * @note A fully built pipeline is stopped, reset and parked for reuse by the next play with the
+ *       same sink; anything else is torn down completely.
+ */
+static void stop_active_pipeline_internal(void)
+{
+    ESP_LOGI(TAG, "stop_active_pipeline_internal()");
 
-    // No need to manually deinit elements - audio_pipeline_deinit() already did it
-    // Exception: If we unregistered persistent I2S, we don't want it deinitialized anyway
+    gapless_cancel();
+
+    if (active_pipeline == NULL) {
+        audio_state = AUDIO_STATE_STOPPED;
+        return;
+    }
+
+    // Save tracking record for manual stops (#15141)
+    save_tracking_record_if_active();
+
+    // Codec mute handled by timer system after pipeline stops
+
+    // If the active sink was A2DP, tell the BT stack to stop streaming
+    if (s3_active_sink == AUDIO_SINK_A2DP) {
+        bt_a2dp_stop_media();
+        // Give time for L2CAP layer to flush buffers - reduced to prevent audio event queue overflow
+        vTaskDelay(pdMS_TO_TICKS(500));  // Reduced from 1500ms - balance between L2CAP flush and event queue health
+    }
+
+    ESP_LOGI(TAG, "Stopping pipeline...");
+    audio_pipeline_stop(active_pipeline);
+    audio_pipeline_wait_for_stop(active_pipeline);
+
+    if (active_pipeline_reusable && is_powered_on) {
+        // Keep element tasks and ring buffers alive; only drop buffered data and element state
+        audio_pipeline_reset_ringbuffer(active_pipeline);
+        audio_pipeline_reset_elements(active_pipeline);
+
+        release_parked_pipeline_internal();  // Only one parked pipeline at a time
+        parked_pipeline.pipeline       = active_pipeline;
+        parked_pipeline.fatfs_reader   = fatfs_reader;
+        parked_pipeline.mp3_decoder    = mp3_decoder;
+        parked_pipeline.sfx_mixer      = sfx_mixer;
+        parked_pipeline.sink_element   = current_sink_element;
+        parked_pipeline.sink           = active_pipeline_sink;
+        ESP_LOGI(TAG, "Pipeline parked for reuse (sink=%d, encryption=%d)",
+                 active_pipeline_sink, active_pipeline_encrypted);
+    } else {
+        teardown_pipeline(active_pipeline, fatfs_reader, mp3_decoder, current_sink_element);
+        if (current_sink_element == persistent_i2s_writer) {
+            relink_parked_sink();  // The torn-down pipeline may have borrowed the writer
+        }
+    }
 
     // Reset the handles
     active_pipeline = NULL;
     fatfs_reader = NULL;
-    xor_filter = NULL;
     mp3_decoder = NULL;
+    sfx_mixer = NULL;
     current_sink_element = NULL;
+    active_pipeline_reusable = false;
     audio_state = AUDIO_STATE_STOPPED;  // Reset state machine when stopping
 
     // After playback stops, reset standby timer so screen doesn't immediately go black
@@ -717,14 +801,7 @@ static void stop_active_pipeline_internal(void)
     }
 
     // Clean up sound effect state when stopping pipeline
-    if (sound_effect_playing) {
-        sound_effect_playing = false;
-        was_playing_before_effect = false;
-        if (saved_track_uri) {
-            free(saved_track_uri);
-            saved_track_uri = NULL;
-        }
-    }
+    sound_effect_playing = false;
     
     // Notify Bluetooth that audio stopped - triggers deferred A2DP connection if pending
     // This prevents crash when BT connects while audio is playing (race condition)
@@ -755,17 +832,46 @@ bool is_audio_playing(void) {
 /**
  * @brief Initialize audio pipeline components
  * @param sink_type The audio sink type (I2S or A2DP)
- * @param use_encryption Whether to include XOR decryption filter in pipeline
+ * @param use_encryption Whether the file reader decrypts what it reads
  * @return true if initialization succeeded, false otherwise
  */
 static bool init_audio_pipeline(audio_sink_t sink_type, bool use_encryption)
 {
     ESP_LOGI(TAG, "init_audio_pipeline(sink_type=%d)", sink_type);
 
+#ifndef CONFIG_USE_ENCRYPTION
+    use_encryption = false;  // Content is never encrypted in this build
+#endif
+
     if (active_pipeline) {
         stop_active_pipeline_internal();
     }
 
+    // Reuse the parked pipeline when it was built for the same sink; decryption is a reader flag
+    if (parked_pipeline.pipeline) {
+        if (parked_pipeline.sink == sink_type) {
+            active_pipeline           = parked_pipeline.pipeline;
+            fatfs_reader              = parked_pipeline.fatfs_reader;
+            mp3_decoder               = parked_pipeline.mp3_decoder;
+            sfx_mixer                 = parked_pipeline.sfx_mixer;
+            current_sink_element      = parked_pipeline.sink_element;
+            active_pipeline_sink      = sink_type;
+            active_pipeline_encrypted = use_encryption;
+            active_pipeline_reusable  = true;
+            // The writer may have been lent to a cached sound effect since this pipeline was parked
+            if (current_sink_element == persistent_i2s_writer && sfx_mixer) {
+                audio_element_set_input_ringbuf(current_sink_element, audio_element_get_output_ringbuf(sfx_mixer));
+            }
+            memset(&parked_pipeline, 0, sizeof(parked_pipeline));
+            sd_track_reader_set_decrypt(fatfs_reader, use_encryption);
+            ESP_LOGI(TAG, "Reusing parked pipeline (sink=%d, encryption=%d)", sink_type, use_encryption);
+            return true;
+        }
+
+        ESP_LOGI(TAG, "Parked pipeline mismatch (sink=%d→%d) - rebuilding", parked_pipeline.sink, sink_type);
+        release_parked_pipeline_internal();
+    }
+
     audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
     // Increase buffer for A2DP
     if (sink_type == AUDIO_SINK_A2DP) {
@@ -775,17 +881,17 @@ static bool init_audio_pipeline(audio_sink_t sink_type, bool use_encryption)
     }
     active_pipeline = audio_pipeline_init(&pipeline_cfg);
 
-    fatfs_stream_cfg_t fs_cfg = FATFS_STREAM_CFG_DEFAULT();
+    sd_track_reader_cfg_t fs_cfg = SD_TRACK_READER_CFG_DEFAULT();
 
-    fs_cfg.out_rb_size = 8 * 1024;  // 8K size is double of xor_filter's input 4K
+    fs_cfg.out_rb_size = 8 * 1024;  // 8K feeds the MP3 decoder directly (no XOR element in between)
     if (sink_type == AUDIO_SINK_A2DP) {
         fs_cfg.task_prio = 14;          // Below LVGL (18) to prevent UI starvation
         fs_cfg.task_core = 1;           // Core 1 - separate from A2DP/BT
     }
     fs_cfg.buf_sz = 2048;
-    fs_cfg.type = AUDIO_STREAM_READER;
+    fs_cfg.decrypt = use_encryption;  // XOR is applied in the reader task, no separate filter task/ring buffer
 
-    fatfs_reader = fatfs_stream_init(&fs_cfg);
+    fatfs_reader = sd_track_reader_init(&fs_cfg);
     if (fatfs_reader == NULL) {
         ESP_LOGE(TAG, "Failed to initialize fatfs reader");
         stop_active_pipeline();
@@ -796,31 +902,10 @@ static bool init_audio_pipeline(audio_sink_t sink_type, bool use_encryption)
     audio_element_set_event_callback(fatfs_reader, NULL, NULL);
     ESP_LOGD(TAG, "Disabled events for fatfs_reader");
 
-#ifdef CONFIG_USE_ENCRYPTION
-    if (use_encryption) {
-        // Initialize XOR filter only when encryption is needed
-        xor_decrypt_cfg_t xor_cfg = DEFAULT_XOR_DECRYPT_CONFIG();
-        xor_cfg.out_rb_size = 12 * 1024; // Optimized 6KB - compromise between 4KB default and 16KB
-        if (sink_type == AUDIO_SINK_A2DP) {
-            xor_cfg.task_core = 1;       // Core 1 - separate from A2DP/BT
-        }
-        xor_filter = xor_decrypt_filter_init(&xor_cfg);
-        if (xor_filter == NULL) {
-            ESP_LOGE(TAG, "Failed to initialize xor_filter");
-            stop_active_pipeline();
-            return false;
-        }
+    // Chain album tracks back-to-back inside the reader (gapless auto-advance)
+    sd_track_reader_set_chain_cb(fatfs_reader, gapless_next_track_cb, track_reader_position_cb, NULL);
 
-        // Disable event generation for XOR filter
-        audio_element_set_event_callback(xor_filter, NULL, NULL);
-        ESP_LOGD(TAG, "Disabled events for xor_filter");
-        
-        ESP_LOGI(TAG, "XOR decryption filter initialized");
-    } else {
-        xor_filter = NULL; // No encryption filter needed
-        ESP_LOGI(TAG, "Skipping XOR decryption filter - playing unencrypted content");
-    }
-#endif
+    ESP_LOGI(TAG, "File reader %s", use_encryption ? "decrypting in place" : "passing unencrypted content through");
 
     // Initialize MP3 decoder
 
@@ -853,6 +938,25 @@ static bool init_audio_pipeline(audio_sink_t sink_type, bool use_encryption)
     audio_element_set_event_callback(mp3_decoder, NULL, NULL);
     ESP_LOGD(TAG, "Disabled events for mp3_decoder");
 
+    // Sound effect mixer between decoder and sink - effects are overlaid on the live track
+    sfx_mixer_cfg_t mix_cfg = DEFAULT_SFX_MIXER_CONFIG();
+    if (sink_type == AUDIO_SINK_A2DP) {
+        mix_cfg.task_prio = 15;          // Same as MP3 decoder
+        mix_cfg.task_core = 1;           // Core 1 - separate from A2DP/BT
+    }
+    sfx_mixer = sfx_mixer_init(&mix_cfg);
+    if (sfx_mixer == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize sound effect mixer");
+        stop_active_pipeline();
+        return false;
+    }
+
+    // Disable event generation for sound effect mixer
+    audio_element_set_event_callback(sfx_mixer, NULL, NULL);
+    // The mixer task picks the stream format up from the decoder itself, between blocks
+    sfx_mixer_set_stream_source(sfx_mixer, mp3_decoder);
+    ESP_LOGD(TAG, "Disabled events for sfx_mixer");
+
     ESP_LOGI(TAG, "Creating sink element for: %s", sink_type == AUDIO_SINK_A2DP ? "A2DP" : "I2S");
     if (sink_type == AUDIO_SINK_A2DP) {
         a2dp_stream_config_t a2dp_config = { .type = AUDIO_STREAM_WRITER };
@@ -882,51 +986,44 @@ static bool init_audio_pipeline(audio_sink_t sink_type, bool use_encryption)
         ESP_LOGI(TAG, "Reusing persistent I2S writer element");
     }
 
-    if (active_pipeline == NULL || fatfs_reader == NULL || mp3_decoder == NULL || current_sink_element == NULL) {
+    if (active_pipeline == NULL || fatfs_reader == NULL || mp3_decoder == NULL || sfx_mixer == NULL || current_sink_element == NULL) {
         ESP_LOGE(TAG, "Failed to initialize one or more pipeline elements");
         stop_active_pipeline_internal();
         return false;
     }
 
     audio_pipeline_register(active_pipeline, fatfs_reader, "file");
-#ifdef CONFIG_USE_ENCRYPTION
-    if (use_encryption) {
-        audio_pipeline_register(active_pipeline, xor_filter, "XOR");
-    }
-#endif
     audio_pipeline_register(active_pipeline, mp3_decoder, "mp3");
+    audio_pipeline_register(active_pipeline, sfx_mixer, "mix");
     audio_pipeline_register(active_pipeline, current_sink_element, "output");
 
-#ifdef CONFIG_USE_ENCRYPTION
-    if (use_encryption) {
-        const char *link_tag[4] = {"file", "XOR", "mp3", "output"};
-        if (audio_pipeline_link(active_pipeline, link_tag, 4) != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to link pipeline elements with encryption");
-            stop_active_pipeline();
-            return false;
-        }
-    } else {
-        const char *link_tag[3] = {"file", "mp3", "output"};
-        if (audio_pipeline_link(active_pipeline, link_tag, 3) != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to link pipeline elements without encryption");
-            stop_active_pipeline_internal();
-            return false;
-        }
-    }
-#else
-    const char *link_tag[3] = {"file", "mp3", "output"};
-    if (audio_pipeline_link(active_pipeline, link_tag, 3) != ESP_OK) {
+    const char *link_tag[4] = {"file", "mp3", "mix", "output"};
+    if (audio_pipeline_link(active_pipeline, link_tag, 4) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to link pipeline elements");
         stop_active_pipeline_internal();
         return false;
     }
-#endif
+
+    active_pipeline_sink      = sink_type;
+    active_pipeline_encrypted = use_encryption;
+    active_pipeline_reusable  = true;
 
     ESP_LOGI(TAG, "Pipeline initialized with automatic cleanup via main loop check");
     
     return true;
 }
 
+/**
+ * @brief Mixer callback: the start-of-track watermark is buffered, the sink is about to get audio
+ * Runs on the mixer task.
+ */
+static void pipeline_prefill_ready_cb(audio_element_handle_t el, int filled, void *ctx)
+{
+    if (prefill_ready_sem) {
+        xSemaphoreGive(prefill_ready_sem);
+    }
+}
+
 /**
  * @brief The new master function to play any media to a specified sink
  */
@@ -968,8 +1065,10 @@ static bool audio_play_internal(const char *path, audio_sink_t sink_pref)
         struct stat st;
         if (stat(path, &st) != 0) {
             ESP_LOGE(TAG, "audio_play_internal: file does not exist: %s", path);
+            s3_content_index_file_removed(path);  // Card changed behind the index: keep it honest
             break;
         }
+        s3_content_index_file_seen(path, (uint32_t)st.st_size);  // Replaced under the same name?
 
         /* 5. Stop anything that was already playing --------------------- */
         stop_active_pipeline_internal();
@@ -980,8 +1079,8 @@ static bool audio_play_internal(const char *path, audio_sink_t sink_pref)
             // Force cleanup anyway
             active_pipeline = NULL;
             fatfs_reader = NULL;
-            xor_filter = NULL;
             mp3_decoder = NULL;
+            sfx_mixer = NULL;
             current_sink_element = NULL;
             audio_state = AUDIO_STATE_STOPPED;
         }
@@ -996,7 +1095,7 @@ static bool audio_play_internal(const char *path, audio_sink_t sink_pref)
         if (sink == AUDIO_SINK_I2S) {
             codec_stop_mute_timer();    // Stop mute timer if running
             codec_unmute_for_i2s_playback();  // Unmute codec before playback
-            vTaskDelay(pdMS_TO_TICKS(300)); // Give some time before pipeline start
+            // No settle delay needed: the sink only gets silence until the prefill gate opens
         }
 
 
@@ -1018,10 +1117,12 @@ static bool audio_play_internal(const char *path, audio_sink_t sink_pref)
             }
         }
         
+        int64_t pipeline_init_start_us = esp_timer_get_time();
         if (!init_audio_pipeline(sink, use_encryption)) {
             ESP_LOGE(TAG, "audio_play_internal: pipeline init failed");
             break;
         }
+        ESP_LOGI(TAG, "Pipeline ready in %lld us", esp_timer_get_time() - pipeline_init_start_us);
         s3_active_sink = sink;
 
         /* 7.1. For I2S sink only: stop mute timer (unmute happens AFTER buffering) */
@@ -1032,61 +1133,31 @@ static bool audio_play_internal(const char *path, audio_sink_t sink_pref)
 
         /* 8. Point file-reader to the MP3 and start the pipeline -------- */
         audio_element_set_uri(fatfs_reader, path);
+        sfx_mixer_set_prefill(sfx_mixer, CONFIG_AUDIO_PREFILL_MS, pipeline_prefill_ready_cb, NULL);
+        xSemaphoreTake(prefill_ready_sem, 0);  // Drop a stale signal from an aborted start
+        int64_t prefill_start_us = esp_timer_get_time();
         if (audio_pipeline_run(active_pipeline) != ESP_OK) {
             ESP_LOGE(TAG, "audio_play_internal: pipeline run failed");
+            active_pipeline_reusable = false; /* don't park a broken pipeline */
             stop_active_pipeline_internal(); /* clean up on failure         */
             break;
         }
 
-        /* 9. Enhanced buffer pre-fill strategy to eliminate initial chopping */
-        // Get the mp3 decoder's output ringbuffer to check fill level
-        ringbuf_handle_t decoder_out_rb = audio_element_get_output_ringbuf(mp3_decoder);
-        if (decoder_out_rb) {
-            int rb_size = rb_get_size(decoder_out_rb);
-            // More aggressive buffering: 75% for I2S (more susceptible to underruns), 60% for A2DP
-            int target_fill = (sink == AUDIO_SINK_I2S) ? (rb_size * 3 / 4) : (rb_size * 3 / 5);
-            uint16_t wait_count = 0;
-            const uint16_t max_wait_ms = 1200;   // Slightly longer timeout for better buffering
-
-            ESP_LOGI(TAG, "Waiting for decoder buffer to fill (target: %d/%d bytes, sink=%s)", 
-                     target_fill, rb_size, (sink == AUDIO_SINK_I2S) ? "I2S" : "A2DP");
-
-            while (wait_count < max_wait_ms) {
-                int filled = rb_bytes_filled(decoder_out_rb);
-                if (filled >= target_fill) {
-                    ESP_LOGI(TAG, "Decoder buffer ready: %d bytes filled in %d ms", filled, wait_count);
-                    break;
-                }
-                vTaskDelay(pdMS_TO_TICKS(20));  // Check every 20ms - faster response to prevent underruns
-                wait_count += 20;
-            }
-
-            if (wait_count >= max_wait_ms) {
-                ESP_LOGW(TAG, "Decoder buffer fill timeout - starting anyway (filled: %d/%d)",
-                         rb_bytes_filled(decoder_out_rb), rb_size);
-            }
-            
-            // Additional I2S-specific buffering: Allow DMA buffers to pre-fill
-            if (sink == AUDIO_SINK_I2S) {
-                ESP_LOGI(TAG, "I2S sink: additional DMA buffer pre-fill delay");
-                vTaskDelay(pdMS_TO_TICKS(100));  // Extra 100ms for I2S DMA buffers to fill
-            }
+        /* 9. Wait for the mixer's prefill gate --------------------------- */
+        // The mixer holds the sink back until CONFIG_AUDIO_PREFILL_MS of audio is decoded and
+        // signals the moment it is; the timeout only covers a reader/decoder that never gets there.
+        if (xSemaphoreTake(prefill_ready_sem, pdMS_TO_TICKS(CONFIG_AUDIO_PREFILL_TIMEOUT_MS)) == pdTRUE) {
+            ESP_LOGI(TAG, "Prefill of %d ms ready in %lld ms (sink=%s)", CONFIG_AUDIO_PREFILL_MS,
+                     (esp_timer_get_time() - prefill_start_us) / 1000, (sink == AUDIO_SINK_I2S) ? "I2S" : "A2DP");
         } else {
-            // Fallback to fixed delay if we can't get ringbuffer
-            ESP_LOGW(TAG, "Cannot get decoder ringbuffer - using fixed delay");
-            if (sink == AUDIO_SINK_I2S) {
-                vTaskDelay(pdMS_TO_TICKS(400));  // Longer delay for I2S to ensure smooth start
-            } else {
-                vTaskDelay(pdMS_TO_TICKS(250));  // A2DP has more internal buffering
-            }
+            ESP_LOGW(TAG, "Prefill not reached in %d ms - starting anyway", CONFIG_AUDIO_PREFILL_TIMEOUT_MS);
         }
 
         /* 9.1. Start media streaming based on sink type */
         if (s3_active_sink == AUDIO_SINK_A2DP) {
             bt_a2dp_start_media();
         } else if (s3_active_sink == AUDIO_SINK_I2S) {
-            // Unmute codec AFTER buffers have filled
-            // I2S DMA buffers will naturally fill from decoder output while we waited above
+            // Unmute codec AFTER buffers have filled (normally already unmuted in step 6)
             codec_unmute_for_i2s_playback();
             ESP_LOGI(TAG, "Codec unmuted after buffer pre-fill");
         }
@@ -1145,6 +1216,7 @@ void reset_albums_from_nfc(void)
 
                     // Reset track index to 0 for the restored album
                     s3_current_idx_track = 0;
+                    gapless_cancel();
 
                     ESP_LOGI(TAG, "Album restored to [%u/%u] → %s",
                              (unsigned int)(s3_current_idx + 1), (unsigned int)s3_current_size, s3_current_album->name);
@@ -1178,6 +1250,39 @@ bool audio_play(const char *path, audio_sink_t sink_pref)
 
 
 
+/**
+ * @brief Play a system sound, from the PCM cache when it can go to the speaker
+ * @note Cached clips run on the I2S writer only; with headphones connected the sound still goes
+ *       through the file pipeline to A2DP, as do sounds the cache cannot hold.
+ */
+static void play_system_sound(const char *path)
+{
+    current_audio_type = AUDIO_TYPE_EFFECT;
+
+    if (!bt_is_a2dp_connected()) {
+        // Fetch (or decode) the PCM before taking audio_mutex
+        sfx_mixer_clip_t clip = {0};
+        if (sound_cache_get_clip(path, &clip)) {
+            bool started = false;
+            if (xSemaphoreTake(audio_mutex, pdMS_TO_TICKS(2000)) == pdTRUE) {
+                if (ensure_audio_system_ready()) {
+                    started = audio_play_cached_sound_effect(path, &clip);
+                }
+                xSemaphoreGive(audio_mutex);
+            }
+            if (clip.pcm) {
+                clip.release(clip.pcm, clip.release_ctx);  // Not taken by the clip reader
+            }
+            if (started) {
+                return;
+            }
+        }
+        ESP_LOGW(TAG, "System sound %s not played from cache - using the file pipeline", path);
+    }
+
+    play_auto_mode(path);
+}
+
 /**
  * @brief Play boot sound
  */
@@ -1194,8 +1299,7 @@ void play_audio_boot()
         vTaskDelay(pdMS_TO_TICKS(200));
     }
     ESP_LOGW(TAG, "Playing audio boot sound");
-    current_audio_type = AUDIO_TYPE_EFFECT;
-    play_auto_mode(BOOT_SOUND);
+    play_system_sound(BOOT_SOUND);
 }
 
 /**
@@ -1212,8 +1316,7 @@ void play_audio_shutdown()
         play_stop();
     }
     ESP_LOGW(TAG, "Playing audio shutdown sound");
-    current_audio_type = AUDIO_TYPE_EFFECT;
-    play_auto_mode(SHUTDOWN_SOUND);
+    play_system_sound(SHUTDOWN_SOUND);
 }
 
 /**
@@ -1226,12 +1329,16 @@ void play_audio_volume()
         return;
     }
     if (is_state_playing()) {
+        bool mixed = false;
+        if (current_audio_type == AUDIO_TYPE_TRACK && audio_play_sound_effect_quick_internal(VOLUME_SOUND, &mixed)) {
+            ESP_LOGI(TAG, "Volume sound %s", mixed ? "mixed over current track" : "played standalone (track stopped)");
+            return;
+        }
         ESP_LOGW(TAG, "Audio is already playing, stopping current playback before volume sound");
         play_stop();
     }
     ESP_LOGW(TAG, "Playing audio volume sound");
-    current_audio_type = AUDIO_TYPE_EFFECT;
-    play_auto_mode(VOLUME_SOUND);
+    play_system_sound(VOLUME_SOUND);
 }
 
 // Global variable to track if we stopped audio for alarm (should resume after)
@@ -1440,10 +1547,12 @@ void audio_play_from_position(int position)
     // Wait for pipeline to start
     vTaskDelay(pdMS_TO_TICKS(200));
     
-    // Seek to saved position
-    if (fatfs_reader && active_pipeline) {
+    // Seek to saved position (the reader decrypts by file offset, so no key realignment needed)
+    if (fatfs_reader && mp3_decoder && active_pipeline) {
         ESP_LOGI(TAG, "Seeking to saved position: %d bytes", position);
-        audio_element_set_byte_pos(fatfs_reader, position);
+        if (sd_track_reader_seek(fatfs_reader, position) != ESP_OK) {
+            ESP_LOGW(TAG, "Seek to %d failed", position);
+        }
         ESP_LOGI(TAG, "Playback resumed from saved position");
     } else {
         ESP_LOGW(TAG, "Failed to seek - no active pipeline after play");
@@ -1841,6 +1950,7 @@ void audio_power_off(void)
 
     ESP_LOGI(TAG, "Powering off audio system");
     stop_active_pipeline();
+    release_parked_pipeline();
 
     // UNUSED: Clean up event listener - can be removed since evt is not used
     /*
@@ -1918,6 +2028,7 @@ static void create_current_shuffle_internal_nolock(void) {
     
     shuffle_count = s3_current_size_track;
     shuffle_position = 0;
+    gapless_cancel();  // A chained track was picked from the old order
     
     ESP_LOGI(TAG, "Shuffle created: [0]=%u [1]=%u [2]=%u",
              (unsigned int)current_shuffle_order[0],
@@ -2029,8 +2140,6 @@ static void build_playlist_internal_nolock()
              s3_current_album->sku ? s3_current_album->sku : "NULL",
              s3_current_album->path ? s3_current_album->path : "NULL");
 
-    DIR *dir = NULL;
-    struct dirent* entry;
     bool is_skurc_album = false;
 
     // Free previous list if exists
@@ -2051,135 +2160,67 @@ static void build_playlist_internal_nolock()
     }
 
     if (is_skurc_album) {
-        // For SKURC albums, get filenames from account data instead of scanning directory
-        int account_filename_count = 0;
-        char **account_filenames = get_skurc_filenames_from_account(s3_current_album->sku, &account_filename_count);
-        
+        // For SKURC albums, get filenames from the parsed account model instead of scanning directory
+        char **account_filenames = NULL;
+        int account_filename_count = get_sku_filenames(s3_current_album->sku, &account_filenames);
+
         if (account_filenames && account_filename_count > 0) {
             ESP_LOGI(TAG, "Using account data for SKURC playlist: %d files listed", account_filename_count);
-            
-            // Count valid files that exist on disk and are real MP3s
-            for (int i = 0; i < account_filename_count; i++) {
+
+            s3_current_track_list = (char**)malloc(account_filename_count * sizeof(char*));
+            if (s3_current_track_list == NULL) {
+                ESP_LOGE(TAG, "Memory allocation failed");
+            }
+
+            for (int i = 0; s3_current_track_list && i < account_filename_count; i++) {
                 char full_path[256];
                 snprintf(full_path, sizeof(full_path), "%s%s", s3_current_album->path, account_filenames[i]);
-                
-                // Check if file exists and is a real MP3
-                if (access(full_path, F_OK) == 0 && is_real_mp3_file(full_path)) {
-                    s3_current_size_track++;
+
+                // Only include files that exist and are valid MP3s (header check is cached in the index)
+                if (s3_content_index_has_track(full_path, true)) {
+                    s3_current_track_list[s3_current_size_track] = strdup_spiram(full_path);
+                    if (s3_current_track_list[s3_current_size_track] != NULL) {
+                        ESP_LOGI(TAG, "Added SKURC track: %s", account_filenames[i]);
+                        s3_current_size_track++;
+                    } else {
+                        ESP_LOGE(TAG, "Failed to allocate memory for track path");
+                    }
                 }
             }
-            
+
             ESP_LOGI(TAG, "SKURC account-based scan: %d valid files found", s3_current_size_track);
+            free_sku_filenames(account_filenames, account_filename_count);
         } else {
-            ESP_LOGW(TAG, "Could not get SKURC filenames from account, falling back to directory scan");
-            // Fall back to directory scan
+            ESP_LOGW(TAG, "Could not get SKURC filenames from account, falling back to album index");
             is_skurc_album = false;
         }
-        
-        // Cleanup account filenames (will re-read them in second pass)
-        if (account_filenames) {
-            for (int i = 0; i < account_filename_count; i++) {
-                free(account_filenames[i]);
-            }
-            free(account_filenames);
-        }
     }
 
     if (!is_skurc_album) {
-        // Regular album: scan directory
-        ESP_LOGI(TAG, "Opening directory for playlist: %s", s3_current_album->path);
-        dir = opendir(s3_current_album->path);
-        if (dir == NULL) {
+        // Regular album: tracks come from the content index, already sorted by name
+        int count = s3_content_index_get_tracks(s3_current_album->path, false, &s3_current_track_list);
+        if (count < 0) {
             ESP_LOGE(TAG, "Failed to open directory: %s", s3_current_album->path);
             return;
         }
-
-        // First pass: count MP3 files
-        while ((entry = readdir(dir)) != NULL) {
-            if (entry->d_type == DT_REG && strstr(entry->d_name, ".mp3")) {
-                s3_current_size_track++;
-            }
-        }
-        rewinddir(dir);
+        s3_current_size_track = count;
     }
 
     if (s3_current_size_track == 0) {
         ESP_LOGW(TAG, "No MP3 files found in directory");
-        closedir(dir);
-        return;
-    }
-
-    // Allocate memory for track list
-    s3_current_track_list = (char**)malloc(s3_current_size_track * sizeof(char*));
-    if (s3_current_track_list == NULL) {
-        ESP_LOGE(TAG, "Memory allocation failed");
-        closedir(dir);
-        s3_current_size_track = 0;
+        free(s3_current_track_list);
+        s3_current_track_list = NULL;
         return;
     }
 
-    // Second pass: store filenames
-    int index = 0;
-    
-    if (is_skurc_album) {
-        // For SKURC albums, use account data to build playlist
-        int account_filename_count = 0;
-        char **account_filenames = get_skurc_filenames_from_account(s3_current_album->sku, &account_filename_count);
-        
-        if (account_filenames && account_filename_count > 0) {
-            ESP_LOGI(TAG, "Building SKURC playlist from account data");
-            
-            for (int i = 0; i < account_filename_count && index < s3_current_size_track; i++) {
-                char full_path[256];
-                snprintf(full_path, sizeof(full_path), "%s%s", s3_current_album->path, account_filenames[i]);
-                
-                // Only include files that exist and are valid MP3s
-                if (access(full_path, F_OK) == 0 && is_real_mp3_file(full_path)) {
-                    s3_current_track_list[index] = strdup_spiram(full_path);
-                    if (s3_current_track_list[index] != NULL) {
-                        ESP_LOGI(TAG, "Added SKURC track: %s", account_filenames[i]);
-                        index++;
-                    } else {
-                        ESP_LOGE(TAG, "Failed to allocate memory for track path");
-                    }
-                }
-            }
-            
-            // Cleanup account filenames
-            for (int i = 0; i < account_filename_count; i++) {
-                free(account_filenames[i]);
-            }
-            free(account_filenames);
-        }
-    } else {
-        // Regular albums: read from directory
-        while ((entry = readdir(dir)) != NULL && index < s3_current_size_track) {
-            if (entry->d_type == DT_REG && strstr(entry->d_name, ".mp3")) {
-                char full_path[256];
-                snprintf(full_path, sizeof(full_path), "%s%s", s3_current_album->path, entry->d_name);
-
-                s3_current_track_list[index] = strdup_spiram(full_path);
-                if (s3_current_track_list[index] == NULL) {
-                    ESP_LOGE(TAG, "Failed to allocate memory for track path");
-                    continue;
-                }
-                index++;
-            }
-        }
-    }
-
-    if (dir) {
-        closedir(dir);
-    }
-    
-    // Sort the track list alphabetically to ensure consistent ordering
-    if (s3_current_size_track > 1) {
+    // Sort the track list alphabetically to ensure consistent ordering (account order is arbitrary)
+    if (is_skurc_album && s3_current_size_track > 1) {
         // Use qsort with a comparison function for strings
         extern int track_name_compare(const void *a, const void *b);
         qsort(s3_current_track_list, s3_current_size_track, sizeof(char*), track_name_compare);
         ESP_LOGI(TAG, "Track list sorted alphabetically");
     }
-    
+
     ESP_LOGI(TAG, "Playlist built with %d tracks", s3_current_size_track);
 
     // Track index is already set by switch_album_internal() before build_playlist() is called
@@ -2241,20 +2282,17 @@ static void build_playlist_all_languages_internal_nolock(char** skus, int sku_co
         }
     }
 
-    // Count total MP3 files from all albums
+    // Collect the tracks of every album from the content index (no directory scans)
+    char **album_tracks[20] = {0};
+    int album_track_counts[20] = {0};
     int total_tracks = 0;
     for (int album_idx = 0; album_idx < albums_count; album_idx++) {
         s3_album_handler_t* album = albums[album_idx];
         if (album && album->path) {
-            DIR* dir = opendir(album->path);
-            if (dir) {
-                struct dirent* entry;
-                while ((entry = readdir(dir)) != NULL) {
-                    if (entry->d_type == DT_REG && strstr(entry->d_name, ".mp3")) {
-                        total_tracks++;
-                    }
-                }
-                closedir(dir);
+            int count = s3_content_index_get_tracks(album->path, false, &album_tracks[album_idx]);
+            if (count > 0) {
+                album_track_counts[album_idx] = count;
+                total_tracks += count;
             }
         }
     }
@@ -2268,33 +2306,22 @@ static void build_playlist_all_languages_internal_nolock(char** skus, int sku_co
     s3_current_track_list = (char**)malloc(total_tracks * sizeof(char*));
     if (s3_current_track_list == NULL) {
         ESP_LOGE(TAG, "Memory allocation failed for combined playlist");
+        for (int album_idx = 0; album_idx < albums_count; album_idx++) {
+            for (int i = 0; i < album_track_counts[album_idx]; i++) {
+                free(album_tracks[album_idx][i]);
+            }
+            free(album_tracks[album_idx]);
+        }
         return;
     }
 
-    // Collect all tracks from all albums
+    // Move the paths into the combined list (ownership transfers, no copies)
     int track_index = 0;
     for (int album_idx = 0; album_idx < albums_count; album_idx++) {
-        s3_album_handler_t* album = albums[album_idx];
-        if (album && album->path) {
-            DIR* dir = opendir(album->path);
-            if (dir) {
-                struct dirent* entry;
-                while ((entry = readdir(dir)) != NULL && track_index < total_tracks) {
-                    if (entry->d_type == DT_REG && strstr(entry->d_name, ".mp3")) {
-                        char full_path[256];
-                        snprintf(full_path, sizeof(full_path), "%s%s", album->path, entry->d_name);
-
-                        s3_current_track_list[track_index] = strdup_spiram(full_path);
-                        if (s3_current_track_list[track_index] == NULL) {
-                            ESP_LOGE(TAG, "Failed to allocate memory for track path");
-                            continue;
-                        }
-                        track_index++;
-                    }
-                }
-                closedir(dir);
-            }
+        for (int i = 0; i < album_track_counts[album_idx]; i++) {
+            s3_current_track_list[track_index++] = album_tracks[album_idx][i];
         }
+        free(album_tracks[album_idx]);
     }
 
     s3_current_size_track = track_index;
@@ -2388,6 +2415,9 @@ void audio_start_playing_with_transition(bool is_track_transition)
         return;
     }
 
+    // A new play retargets the index; drop any switch chained into the previous stream
+    gapless_cancel();
+
     // Double-check playlist is ready (could have been cleared by another thread)
     if (s3_current_track_list == NULL) {
         ESP_LOGE(TAG, "Track list not ready after build attempt - cannot play");
@@ -2617,6 +2647,8 @@ static void one_step_track_shuffle_internal_nolock(bool next) {
         return;
     }
 
+    gapless_cancel();
+
     if (s3_playback_mode == PLAYBACK_MODE_SHUFFLE) {
         // Use simple shuffle navigation
         if (current_shuffle_order && shuffle_count > 0) {
@@ -2780,6 +2812,7 @@ void audio_update_album_data(void)
     }
 
     // Clear the track list cache since we changed album
+    gapless_cancel();
     if (s3_current_track_list) {
         for (int i = 0; i < s3_current_size_track; i++) {
             free(s3_current_track_list[i]);
@@ -2854,6 +2887,7 @@ static void switch_album_internal(size_t idx)
 
     // Initialize track index - always start from track 0 initially
     s3_current_idx_track = 0;
+    gapless_cancel();
     ESP_LOGI(TAG, "Album switched - initial track index set to 0");
 
     // Clean up any existing shuffle
@@ -2992,66 +3026,135 @@ bool audio_player_is_running(void)
 }
 
 /**
- * @brief Restore previous playback state after sound effect completes
+ * @brief Reader callback: pick the track that follows the current one, if it may be chained.
+ * Runs on the file reader task near EOF. Mirrors one_step_track(true) but only peeks - the
+ * index is committed by apply_gapless_track_switch() once the reader actually switches.
+ * Album changes (AUTO_PLAY_ALL at the end of the album) still go through the normal stop/start path.
+ * @return Newly allocated path (owned by the reader) or NULL to let the stream end.
  */
-static void restore_previous_playback_state(void)
+static char *gapless_next_track_cb(audio_element_handle_t el, void *ctx)
 {
-    ESP_LOGI(TAG, "restore_previous_playback_state()");
-    
-    if (!was_playing_before_effect || !saved_track_uri) {
-        ESP_LOGI(TAG, "No previous playback to restore");
-        sound_effect_playing = false;
-        was_playing_before_effect = false;
-        return;
+    if (current_audio_type != AUDIO_TYPE_TRACK || sound_effect_playing || suppress_auto_play_once ||
+        s3_auto_play_mode == AUTO_PLAY_OFF || gapless_switch_pending) {
+        return NULL;
     }
-    
-    ESP_LOGI(TAG, "Restoring previous track: %s", saved_track_uri);
-    
-    // Reset pipeline and restore original track
-    audio_pipeline_stop(active_pipeline);
-    audio_pipeline_wait_for_stop(active_pipeline);
-    audio_pipeline_reset_ringbuffer(active_pipeline);
-    audio_pipeline_reset_elements(active_pipeline);
-    
-    // Restore original track
-    audio_element_set_uri(fatfs_reader, saved_track_uri);
-    if (audio_pipeline_run(active_pipeline) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to restore original playback");
-        stop_active_pipeline_internal();
-        return;
+
+    s3_screens_t current_screen = (s3_screens_t)get_current_screen();
+    if (current_screen != PLAY_SCREEN && !is_screen_dimmed()) {
+        return NULL;
     }
-    
-    // Buffer the restored track
-    vTaskDelay(pdMS_TO_TICKS(200));
 
-    // For A2DP, restart media stream only if still connected
-    if (s3_active_sink == AUDIO_SINK_A2DP) {
-        if (bt_is_a2dp_connected()) {
-            bt_a2dp_start_media();
+    if (xSemaphoreTake(track_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        ESP_LOGW(TAG, "Gapless: track_mutex busy - next track not chained");
+        return NULL;
+    }
+
+    char *next_path = NULL;
+    if (s3_current_track_list != NULL && s3_current_size_track > 0) {
+        bool at_end;
+        size_t next_idx;
+        size_t next_pos = shuffle_position;
+
+        if (s3_playback_mode == PLAYBACK_MODE_SHUFFLE && current_shuffle_order && shuffle_count > 0) {
+            at_end = (shuffle_position == shuffle_count - 1);
+            next_pos = (shuffle_position + 1) % shuffle_count;
+            next_idx = current_shuffle_order[next_pos];
         } else {
-            ESP_LOGW(TAG, "A2DP disconnected, cannot restore BT playback - stopping");
-            stop_active_pipeline_internal();
-            sound_effect_playing = false;
-            was_playing_before_effect = false;
-            free(saved_track_uri);
-            saved_track_uri = NULL;
-            return;
+            at_end = (s3_current_idx_track == s3_current_size_track - 1);
+            next_idx = (s3_current_idx_track + 1) % s3_current_size_track;
+        }
+
+        // AUTO_PLAY_ALL switches albums at the end - leave that to the regular auto-advance
+        if ((!at_end || s3_auto_play_mode == AUTO_PLAY_FOLDER) &&
+            next_idx < s3_current_size_track && s3_current_track_list[next_idx]) {
+            next_path = strdup(s3_current_track_list[next_idx]);
+            gapless_next_idx = next_idx;
+            gapless_next_shuffle_pos = next_pos;
+            gapless_chained_generation = gapless_generation;
         }
     }
 
-    // Ensure audio is unmuted for restored playback
-    if (s3_active_sink == AUDIO_SINK_I2S) {
-        codec_stop_mute_timer();    // Stop mute timer if running
-        codec_unmute_for_i2s_playback();  // Unmute codec for restored playback
+    xSemaphoreGive(track_mutex);
+
+    if (next_path) {
+        ESP_LOGI(TAG, "Gapless: chaining next track %u: %s", (unsigned int)(gapless_next_idx + 1), next_path);
     }
-    
-    // Clean up saved state
-    free(saved_track_uri);
-    saved_track_uri = NULL;
-    sound_effect_playing = false;
-    was_playing_before_effect = false;
-    
-    ESP_LOGI(TAG, "Previous playback restored successfully");
+    return next_path;
+}
+
+/**
+ * @brief Reader callback: the stream continues at another file position - opened mid-file,
+ * seeked, or crossed into the chained track (uri set).
+ * Runs on the file reader task before any byte from the new position is passed downstream.
+ */
+static void track_reader_position_cb(audio_element_handle_t el, const char *uri, uint64_t stream_pos, int64_t file_pos, void *ctx)
+{
+    // Decryption happens in the reader by file offset, so only track changes need handling here
+    // Ignore a chain made before the user stopped or moved to another track
+    if (uri && gapless_chained_generation == gapless_generation) {
+        gapless_switch_pending = true;
+    }
+}
+
+/**
+ * @brief Forget any chained track: the next-track index, its shuffle position and a pending switch.
+ * Called wherever playback is stopped or the track index is retargeted.
+ */
+static void gapless_cancel(void)
+{
+    gapless_switch_pending = false;
+    gapless_next_idx = 0;
+    gapless_next_shuffle_pos = 0;
+    gapless_generation++;
+}
+
+/**
+ * @brief Commit a gapless track switch: index, playback tracking and UI.
+ * Called from audio_pipeline_periodic_check() on the main loop.
+ */
+static void apply_gapless_track_switch(void)
+{
+    if (xSemaphoreTake(audio_mutex, pdMS_TO_TICKS(1)) != pdTRUE) {
+        return;  // Try again on the next check
+    }
+    if (xSemaphoreTake(track_mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        xSemaphoreGive(audio_mutex);
+        return;
+    }
+
+    // Only while the pipeline that crossed into the chained track is still playing it
+    if (!gapless_switch_pending || !active_pipeline || audio_state != AUDIO_STATE_PLAYING ||
+        current_audio_type != AUDIO_TYPE_TRACK || gapless_chained_generation != gapless_generation) {
+        if (gapless_chained_generation != gapless_generation) {
+            gapless_switch_pending = false;
+        }
+        xSemaphoreGive(track_mutex);
+        xSemaphoreGive(audio_mutex);
+        return;
+    }
+
+    gapless_switch_pending = false;
+    s3_current_idx_track = gapless_next_idx;
+    if (s3_playback_mode == PLAYBACK_MODE_SHUFFLE && current_shuffle_order && shuffle_count > 0) {
+        shuffle_position = gapless_next_shuffle_pos;
+    }
+    char *uri = (s3_current_idx_track < s3_current_size_track && s3_current_track_list)
+                ? strdup(s3_current_track_list[s3_current_idx_track]) : NULL;
+    xSemaphoreGive(track_mutex);
+
+    ESP_LOGI(TAG, "Gapless: now playing track %u/%u", (unsigned int)(s3_current_idx_track + 1),
+             (unsigned int)s3_current_size_track);
+
+    // Previous track played to its end
+    finish_playback_tracking(true);
+    if (uri) {
+        start_playback_tracking(uri);
+        free(uri);
+    }
+    xSemaphoreGive(audio_mutex);
+
+    enable_lang_badge_update();
+    refresh_screen_display();
 }
 
 /**
@@ -3078,12 +3181,19 @@ void audio_pipeline_periodic_check(void)
     last_check_time = current_time;
     
     // Only check if we have an active pipeline and audio is actively playing (not paused/stopped)
-    if (!active_pipeline || audio_state != AUDIO_STATE_PLAYING || !mp3_decoder) {
+    // Cached sound effects have no decoder; their clip reader is the last element before the sink
+    audio_element_handle_t last_element = mp3_decoder ? mp3_decoder : fatfs_reader;
+    if (!active_pipeline || audio_state != AUDIO_STATE_PLAYING || !last_element) {
         return;
     }
+
+    // Reader chained into the next track - catch up index, tracking and UI
+    if (gapless_switch_pending) {
+        apply_gapless_track_switch();
+    }
     
     // Check the MP3 decoder state (most reliable indicator of completion)
-    audio_element_state_t mp3_state = audio_element_get_state(mp3_decoder);
+    audio_element_state_t mp3_state = audio_element_get_state(last_element);
     
     if (mp3_state == AEL_STATE_FINISHED) {
         ESP_LOGI(TAG, "Audio finished naturally - automatic cleanup triggered");
@@ -3092,9 +3202,13 @@ void audio_pipeline_periodic_check(void)
         if (xSemaphoreTake(audio_mutex, pdMS_TO_TICKS(1)) == pdTRUE) {
             
             // Check if this was a sound effect that finished
+            // Effects over a playing track are mixed and never end the pipeline,
+            // so this was a standalone effect
             if (sound_effect_playing) {
-                ESP_LOGI(TAG, "Sound effect completed - checking for restoration");
-                restore_previous_playback_state();
+                ESP_LOGI(TAG, "Sound effect completed");
+                sound_effect_playing = false;
+                // Release the finished effect pipeline (a clip pipeline also hands the I2S writer back)
+                stop_active_pipeline_internal();
                 xSemaphoreGive(audio_mutex);
                 return; // Don't proceed with normal auto-play logic
             }
@@ -3178,8 +3292,9 @@ void trigger_shuffle_reshuffle(void) {
 
 /**
  * @brief Path 1: Play sound effect when nothing is currently playing (optimized for speed)
+ * @param clip Cached PCM for path (may be NULL or empty); zeroed when the clip reader takes it
  */
-static bool audio_play_sound_effect_while_stopped(const char *path)
+static bool audio_play_sound_effect_while_stopped(const char *path, sfx_mixer_clip_t *clip)
 {
     ESP_LOGI(TAG, "audio_play_sound_effect_while_stopped(path=\"%s\")", path);
     
@@ -3196,6 +3311,11 @@ static bool audio_play_sound_effect_while_stopped(const char *path)
         return false;
     }
     
+    // Cached PCM goes straight to the sink - no file access, no decoder
+    if (clip && clip->pcm && audio_play_cached_sound_effect(path, clip)) {
+        return true;
+    }
+
     // Build a lightweight pipeline for I2S only (sound effects don't need A2DP)
     // Sound effects are always encrypted, so use encryption = true
     if (!init_audio_pipeline(AUDIO_SINK_I2S, true)) {
@@ -3222,124 +3342,548 @@ static bool audio_play_sound_effect_while_stopped(const char *path)
     // Update state
     sound_effect_playing = true;
     audio_state = AUDIO_STATE_PLAYING;
-    was_playing_before_effect = false;
 
     ESP_LOGI(TAG, "Sound effect started (optimized path - not playing)");
     return true;
 }
 
 /**
- * @brief Path 2: Play sound effect when music is currently playing (preserve current playback)
+ * @brief Release callback for effect PCM handed to the mixer
  */
-static bool audio_play_sound_effect_while_playing(const char *path)
+static void sound_effect_pcm_release(const int16_t *pcm, void *ctx)
+{
+    heap_caps_free((void *)pcm);
+}
+
+/**
+ * @brief Decode a sound effect file to 16-bit PCM in PSRAM
+ * @param path Sound effect file (encrypted like all files under /sdcard/sound/)
+ * @param clip Filled with the decoded PCM on success; free clip->pcm with heap_caps_free()
+ * @return true if at least one frame was decoded
+ * @note Runs a short (decrypting) reader -> MP3 -> raw pipeline next to the playing track; effects are
+ *       short, so this finishes in well under the length of the effect itself.
+ */
+static bool decode_sound_effect_pcm(const char *path, sfx_mixer_clip_t *clip)
+{
+    int64_t start_us = esp_timer_get_time();
+    bool ok = false;
+    uint8_t *pcm = NULL;
+    size_t pcm_len = 0;
+    size_t pcm_cap = 0;
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+
+    sd_track_reader_cfg_t fs_cfg = SD_TRACK_READER_CFG_DEFAULT();
+    fs_cfg.out_rb_size = 4 * 1024;
+    fs_cfg.prefetch_size = 0;  // No chaining for effects
+#ifdef CONFIG_USE_ENCRYPTION
+    fs_cfg.decrypt = true;
+#endif
+    audio_element_handle_t reader = sd_track_reader_init(&fs_cfg);
+
+    mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
+    mp3_cfg.out_rb_size = 8 * 1024;
+    audio_element_handle_t decoder = mp3_decoder_init(&mp3_cfg);
+
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t raw = raw_stream_init(&raw_cfg);
+
+    if (pipeline == NULL || reader == NULL || decoder == NULL || raw == NULL) {
+        ESP_LOGE(TAG, "Failed to create sound effect decode pipeline");
+        goto cleanup;
+    }
+
+    audio_element_set_event_callback(reader, NULL, NULL);
+    audio_element_set_event_callback(decoder, NULL, NULL);
+    audio_element_set_event_callback(raw, NULL, NULL);
+    audio_pipeline_register(pipeline, reader, "file");
+    audio_pipeline_register(pipeline, decoder, "mp3");
+    audio_pipeline_register(pipeline, raw, "raw");
+    const char *link_tag[3] = {"file", "mp3", "raw"};
+    // Elements are owned by the pipeline from here on
+    reader = decoder = raw = NULL;
+
+    if (audio_pipeline_link(pipeline, link_tag, 3) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to link sound effect decode pipeline");
+        goto cleanup;
+    }
+
+    audio_element_handle_t raw_el = audio_pipeline_get_el_by_tag(pipeline, "raw");
+    audio_element_handle_t mp3_el = audio_pipeline_get_el_by_tag(pipeline, "mp3");
+    audio_element_set_input_timeout(raw_el, pdMS_TO_TICKS(500));  // Don't hang on a broken file
+    audio_element_set_uri(audio_pipeline_get_el_by_tag(pipeline, "file"), path);
+    if (audio_pipeline_run(pipeline) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to run sound effect decode pipeline");
+        goto cleanup;
+    }
+
+    while (true) {
+        if (pcm_len + SOUND_EFFECT_DECODE_CHUNK > pcm_cap) {
+            size_t new_cap = pcm_cap ? pcm_cap * 2 : 64 * 1024;
+            if (new_cap > SOUND_EFFECT_PCM_MAX_BYTES) {
+                ESP_LOGW(TAG, "Sound effect longer than %d bytes of PCM - truncated", SOUND_EFFECT_PCM_MAX_BYTES);
+                break;
+            }
+            uint8_t *grown = heap_caps_realloc(pcm, new_cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (grown == NULL) {
+                ESP_LOGE(TAG, "Out of PSRAM decoding sound effect");
+                break;
+            }
+            pcm = grown;
+            pcm_cap = new_cap;
+        }
+        int r = raw_stream_read(raw_el, (char *)pcm + pcm_len, SOUND_EFFECT_DECODE_CHUNK);
+        if (r <= 0) {
+            break;
+        }
+        pcm_len += r;
+    }
+
+    audio_element_info_t info = {0};
+    audio_element_getinfo(mp3_el, &info);
+    int channels = info.channels > 0 ? info.channels : 2;
+    size_t frames = pcm_len / (channels * sizeof(int16_t));
+
+    if (frames > 0 && info.sample_rates > 0 && info.bits == 16) {
+        clip->pcm = (const int16_t *)pcm;
+        clip->frames = frames;
+        clip->sample_rate = info.sample_rates;
+        clip->channels = channels;
+        clip->release = sound_effect_pcm_release;
+        clip->release_ctx = NULL;
+        pcm = NULL;  // Ownership moves to the clip
+        ok = true;
+        ESP_LOGI(TAG, "Decoded sound effect %s: %u frames @ %d Hz x%d in %lld us", path,
+                 (unsigned int)frames, info.sample_rates, channels, esp_timer_get_time() - start_us);
+    } else {
+        ESP_LOGE(TAG, "Sound effect decode produced no usable PCM (%u bytes, %d Hz, %d bits)",
+                 (unsigned int)pcm_len, info.sample_rates, info.bits);
+    }
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+
+cleanup:
+    if (pipeline) {
+        audio_pipeline_terminate(pipeline);
+        audio_pipeline_deinit(pipeline);  // Also deinits every registered element
+    }
+    if (reader) audio_element_deinit(reader);
+    if (decoder) audio_element_deinit(decoder);
+    if (raw) audio_element_deinit(raw);
+    if (pcm) heap_caps_free(pcm);
+    return ok;
+}
+
+/**
+ * @brief Free a cache entry and its PCM
+ */
+static void sound_cache_entry_free(sound_cache_entry_t *entry)
+{
+    if (entry) {
+        free(entry->path);
+        heap_caps_free(entry->pcm);
+        free(entry);
+    }
+}
+
+/**
+ * @brief Release callback for clips served from the cache (may run on the mixer task)
+ */
+static void sound_cache_release_cb(const int16_t *pcm, void *ctx)
+{
+    sound_cache_entry_t *entry = (sound_cache_entry_t *)ctx;
+    bool free_now;
+
+    portENTER_CRITICAL(&sound_cache_spin);
+    entry->refs--;
+    free_now = entry->detached && entry->refs == 0;
+    portEXIT_CRITICAL(&sound_cache_spin);
+
+    if (free_now) {
+        sound_cache_entry_free(entry);
+    }
+}
+
+/**
+ * @brief Remove slot i from the cache; the PCM is freed now or on its last release
+ * @note Caller holds sound_cache_mutex
+ */
+static void sound_cache_drop_nolock(int i)
+{
+    sound_cache_entry_t *entry = sound_cache[i];
+    bool free_now;
+
+    sound_cache[i] = NULL;
+    sound_cache_bytes -= entry->bytes;
+
+    portENTER_CRITICAL(&sound_cache_spin);
+    entry->detached = true;
+    free_now = entry->refs == 0;
+    portEXIT_CRITICAL(&sound_cache_spin);
+
+    ESP_LOGI(TAG, "Sound cache: dropped %s (%u bytes, %u cached)", entry->path,
+             (unsigned int)entry->bytes, (unsigned int)sound_cache_bytes);
+    if (free_now) {
+        sound_cache_entry_free(entry);
+    }
+}
+
+/**
+ * @brief Evict least recently used, unreferenced entries until bytes fit and a slot is free
+ * @return Free slot index, or -1 if the entry can't be cached
+ * @note Caller holds sound_cache_mutex
+ */
+static int sound_cache_make_room_nolock(size_t bytes)
+{
+    if (bytes > SOUND_CACHE_MAX_BYTES) {
+        return -1;
+    }
+
+    while (true) {
+        int free_slot = -1;
+        int lru = -1;
+        for (int i = 0; i < SOUND_CACHE_MAX_ENTRIES; i++) {
+            if (sound_cache[i] == NULL) {
+                if (free_slot < 0) free_slot = i;
+                continue;
+            }
+            if (sound_cache[i]->refs == 0 &&
+                (lru < 0 || sound_cache[i]->last_used_us < sound_cache[lru]->last_used_us)) {
+                lru = i;
+            }
+        }
+
+        if (free_slot >= 0 && sound_cache_bytes + bytes <= SOUND_CACHE_MAX_BYTES) {
+            return free_slot;
+        }
+        if (lru < 0) {
+            return -1;  // Everything left is in use
+        }
+        sound_cache_drop_nolock(lru);
+    }
+}
+
+/**
+ * @brief Get a sound effect as PCM at the sink format, from the cache or by decoding it
+ * @param path Sound effect file
+ * @param clip Filled on success; hand it to the mixer / clip reader, which calls clip->release
+ * @return true on success
+ * @note Entries are checked against the file's size and mtime, so replaced assets are re-decoded.
+ *       Sounds that don't fit in the cache are still returned, as an uncached clip.
+ */
+static bool sound_cache_get_clip(const char *path, sfx_mixer_clip_t *clip)
 {
-    ESP_LOGI(TAG, "audio_play_sound_effect_while_playing(path=\"%s\")", path);
-    
-    // Check file exists
     struct stat st;
     if (stat(path, &st) != 0) {
         ESP_LOGE(TAG, "Sound effect file does not exist: %s", path);
         return false;
     }
-    
-    // Save current track URI for restoration
-    if (fatfs_reader) {
-        char *current_uri = audio_element_get_uri(fatfs_reader);
-        if (current_uri) {
-            if (saved_track_uri) {
-                free(saved_track_uri);
-            }
-            saved_track_uri = strdup_spiram(current_uri);
-            ESP_LOGI(TAG, "Saved current track URI: %s", saved_track_uri);
-        }
-    }
-    
-    if (!active_pipeline) {
-        ESP_LOGE(TAG, "No active pipeline to switch - falling back to stopped mode");
-        return audio_play_sound_effect_while_stopped(path);
+
+    if (sound_cache_mutex == NULL || xSemaphoreTake(sound_cache_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGW(TAG, "Sound cache busy - decoding %s uncached", path);
+        return decode_sound_effect_pcm(path, clip);
     }
-    
-    // Use pipeline switching technique as suggested
-    ESP_LOGI(TAG, "Switching pipeline to sound effect...");
-    
-    // Stop current pipeline but don't destroy it
-    audio_pipeline_stop(active_pipeline);
-    audio_pipeline_wait_for_stop(active_pipeline);
-    audio_pipeline_reset_ringbuffer(active_pipeline);
-    audio_pipeline_reset_elements(active_pipeline);
-    
-    // Switch to sound effect
-    audio_element_set_uri(fatfs_reader, path);
-    if (audio_pipeline_run(active_pipeline) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to run pipeline with sound effect");
-        // Try to restore original track
-        if (saved_track_uri) {
-            audio_element_set_uri(fatfs_reader, saved_track_uri);
-            audio_pipeline_run(active_pipeline);
+
+    for (int i = 0; i < SOUND_CACHE_MAX_ENTRIES; i++) {
+        sound_cache_entry_t *entry = sound_cache[i];
+        if (entry == NULL || strcmp(entry->path, path) != 0) {
+            continue;
+        }
+        if (entry->file_size != st.st_size || entry->file_mtime != st.st_mtime) {
+            ESP_LOGI(TAG, "Sound cache: %s changed on disk", path);
+            sound_cache_drop_nolock(i);
+            break;
         }
+
+        portENTER_CRITICAL(&sound_cache_spin);
+        entry->refs++;
+        portEXIT_CRITICAL(&sound_cache_spin);
+        entry->last_used_us = esp_timer_get_time();
+
+        clip->pcm = entry->pcm;
+        clip->frames = entry->frames;
+        clip->sample_rate = SOUND_CACHE_SAMPLE_RATE;
+        clip->channels = SOUND_CACHE_CHANNELS;
+        clip->release = sound_cache_release_cb;
+        clip->release_ctx = entry;
+        xSemaphoreGive(sound_cache_mutex);
+        ESP_LOGD(TAG, "Sound cache hit: %s", path);
+        return true;
+    }
+
+    // Miss: decode and convert once to the sink format
+    sfx_mixer_clip_t decoded = {0};
+    if (!decode_sound_effect_pcm(path, &decoded)) {
+        xSemaphoreGive(sound_cache_mutex);
         return false;
     }
-    
-    // Shorter buffer delay since pipeline infrastructure is already in place
-    vTaskDelay(pdMS_TO_TICKS(100));
 
-    // For A2DP, restart media stream only if still connected
-    if (s3_active_sink == AUDIO_SINK_A2DP) {
-        if (bt_is_a2dp_connected()) {
-            bt_a2dp_start_media();
+    if (decoded.sample_rate != SOUND_CACHE_SAMPLE_RATE || decoded.channels != SOUND_CACHE_CHANNELS) {
+        size_t frames = 0;
+        int16_t *converted = sfx_mixer_convert_clip(&decoded, SOUND_CACHE_SAMPLE_RATE, SOUND_CACHE_CHANNELS, &frames);
+        if (converted) {
+            decoded.release(decoded.pcm, decoded.release_ctx);
+            decoded.pcm = converted;
+            decoded.frames = frames;
+            decoded.sample_rate = SOUND_CACHE_SAMPLE_RATE;
+            decoded.channels = SOUND_CACHE_CHANNELS;
         } else {
-            ESP_LOGW(TAG, "A2DP disconnected, cannot play sound effect via BT - stopping");
-            stop_active_pipeline_internal();
-            sound_effect_playing = false;
-            if (saved_track_uri) {
-                free(saved_track_uri);
-                saved_track_uri = NULL;
-            }
-            return false;
+            // Still playable (the mixer resamples), just not cacheable in the sink format
+            xSemaphoreGive(sound_cache_mutex);
+            *clip = decoded;
+            return true;
         }
     }
 
-    // Keep existing unmute behavior since we're switching content, not starting fresh
-    if (s3_active_sink == AUDIO_SINK_I2S) {
-        ESP_LOGI(TAG, "Using timer system for pipeline switch");
-        codec_stop_mute_timer();    // Stop mute timer if running
-        codec_unmute_for_i2s_playback();  // Ensure unmuted for switch
+    size_t bytes = decoded.frames * SOUND_CACHE_CHANNELS * sizeof(int16_t);
+    int slot = sound_cache_make_room_nolock(bytes);
+    sound_cache_entry_t *entry = (slot >= 0) ? calloc(1, sizeof(sound_cache_entry_t)) : NULL;
+    char *entry_path = entry ? strdup_spiram(path) : NULL;
+    if (entry == NULL || entry_path == NULL) {
+        ESP_LOGW(TAG, "Sound cache full (%u/%d bytes) - %s played uncached",
+                 (unsigned int)sound_cache_bytes, SOUND_CACHE_MAX_BYTES, path);
+        free(entry);
+        xSemaphoreGive(sound_cache_mutex);
+        *clip = decoded;
+        return true;
     }
-    
-    // Update state
+
+    entry->path = entry_path;
+    entry->pcm = (int16_t *)decoded.pcm;
+    entry->frames = decoded.frames;
+    entry->bytes = bytes;
+    entry->file_size = st.st_size;
+    entry->file_mtime = st.st_mtime;
+    entry->refs = 1;
+    entry->last_used_us = esp_timer_get_time();
+    sound_cache[slot] = entry;
+    sound_cache_bytes += bytes;
+
+    clip->pcm = entry->pcm;
+    clip->frames = entry->frames;
+    clip->sample_rate = SOUND_CACHE_SAMPLE_RATE;
+    clip->channels = SOUND_CACHE_CHANNELS;
+    clip->release = sound_cache_release_cb;
+    clip->release_ctx = entry;
+
+    ESP_LOGI(TAG, "Sound cache: added %s (%u bytes, %u/%d cached)", path,
+             (unsigned int)bytes, (unsigned int)sound_cache_bytes, SOUND_CACHE_MAX_BYTES);
+    xSemaphoreGive(sound_cache_mutex);
+    return true;
+}
+
+/**
+ * @brief Drop cached PCM for a sound file, or for all sounds when path is NULL
+ */
+void audio_sound_cache_invalidate(const char *path)
+{
+    if (sound_cache_mutex == NULL || xSemaphoreTake(sound_cache_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGW(TAG, "Sound cache busy - invalidation skipped (entries are revalidated on use)");
+        return;
+    }
+
+    for (int i = 0; i < SOUND_CACHE_MAX_ENTRIES; i++) {
+        if (sound_cache[i] && (path == NULL || strcmp(sound_cache[i]->path, path) == 0)) {
+            sound_cache_drop_nolock(i);
+        }
+    }
+
+    xSemaphoreGive(sound_cache_mutex);
+}
+
+/**
+ * @brief Decode the system sounds into the cache
+ */
+void audio_sound_cache_preload(void)
+{
+    static const char *const system_sounds[] = {
+        BOOT_SOUND, SHUTDOWN_SOUND, VOLUME_SOUND, NFC_DETECTED_SOUND,
+    };
+
+    int64_t start_us = esp_timer_get_time();
+    for (size_t i = 0; i < sizeof(system_sounds) / sizeof(system_sounds[0]); i++) {
+        sfx_mixer_clip_t clip = {0};
+        if (sound_cache_get_clip(system_sounds[i], &clip)) {
+            clip.release(clip.pcm, clip.release_ctx);
+        }
+    }
+    ESP_LOGI(TAG, "Sound cache preloaded in %lld ms (%u/%d bytes)", (esp_timer_get_time() - start_us) / 1000,
+             (unsigned int)sound_cache_bytes, SOUND_CACHE_MAX_BYTES);
+}
+
+static void sound_cache_preload_task(void *pvParameters)
+{
+    audio_sound_cache_preload();
+    vTaskDeleteWithCaps(NULL);
+}
+
+/**
+ * @brief Play a cached sound effect on I2S with a clip reader -> sink pipeline
+ * @param clip Clip from sound_cache_get_clip(); taken over (zeroed) once handed to the clip reader
+ * @return true if playback started; false to fall back to the file/decoder pipeline
+ * @note Caller holds audio_mutex
+ */
+static bool audio_play_cached_sound_effect(const char *path, sfx_mixer_clip_t *clip)
+{
+    if (clip->sample_rate != SOUND_CACHE_SAMPLE_RATE || clip->channels != SOUND_CACHE_CHANNELS) {
+        return false;  // Sink runs at the default format only
+    }
+
+    if (!i2s_element_initialized || !persistent_i2s_writer) {
+        return false;
+    }
+
+    stop_active_pipeline_internal();
+
+    sfx_clip_reader_cfg_t clip_cfg = DEFAULT_SFX_CLIP_READER_CONFIG();
+    audio_element_handle_t clip_reader = sfx_clip_reader_init(&clip_cfg);
+    if (clip_reader == NULL) {
+        return false;
+    }
+    sfx_clip_reader_set_clip(clip_reader, clip);  // Reader owns the clip from here on
+    memset(clip, 0, sizeof(*clip));
+    audio_element_set_event_callback(clip_reader, NULL, NULL);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    if (pipeline == NULL) {
+        audio_element_deinit(clip_reader);
+        return false;
+    }
+
+    audio_pipeline_register(pipeline, clip_reader, "clip");
+    audio_pipeline_register(pipeline, persistent_i2s_writer, "output");
+    const char *link_tag[2] = {"clip", "output"};
+    if (audio_pipeline_link(pipeline, link_tag, 2) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to link cached sound effect pipeline");
+        teardown_pipeline(pipeline, clip_reader, NULL, persistent_i2s_writer);
+        relink_parked_sink();
+        return false;
+    }
+
+    // Not parked on stop: the next play needs the full reader/decoder pipeline anyway
+    active_pipeline = pipeline;
+    fatfs_reader = clip_reader;
+    mp3_decoder = NULL;
+    sfx_mixer = NULL;
+    current_sink_element = persistent_i2s_writer;
+    active_pipeline_reusable = false;
+    s3_active_sink = AUDIO_SINK_I2S;
+
+    codec_stop_mute_timer();
+    codec_unmute_for_i2s_playback();
+
+    if (audio_pipeline_run(active_pipeline) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start cached sound effect pipeline");
+        stop_active_pipeline_internal();
+        return false;
+    }
+
     sound_effect_playing = true;
-    was_playing_before_effect = true;  // Mark that we need to restore playback
-    // audio_state remains in playing state since we're still playing something
+    audio_state = AUDIO_STATE_PLAYING;
+    ESP_LOGI(TAG, "Sound effect started from cache: %s", path);
+    return true;
+}
 
-    ESP_LOGI(TAG, "Sound effect started (optimized path - while playing)");
+/**
+ * @brief Path 2: Play sound effect when music is currently playing (preserve current playback)
+ * @note The effect is decoded to PCM and overlaid on the live track by the pipeline's mixer
+ *       (music ducked while it plays); the track's reader and decoder are never touched.
+ * @param clip PCM for path; zeroed when the mixer takes it
+ */
+static bool audio_play_sound_effect_while_playing(const char *path, sfx_mixer_clip_t *clip)
+{
+    ESP_LOGI(TAG, "audio_play_sound_effect_while_playing(path=\"%s\")", path);
+
+    if (clip == NULL || clip->pcm == NULL) {
+        return false;
+    }
+
+    if (!active_pipeline || !sfx_mixer || !mp3_decoder) {
+        ESP_LOGE(TAG, "No active pipeline to mix into");
+        return false;
+    }
+
+    // The mixer follows the decoder's format; mixing before it is known would resample wrongly
+    audio_element_info_t track_info = {0};
+    audio_element_getinfo(mp3_decoder, &track_info);
+    if (track_info.sample_rates <= 0 || track_info.channels <= 0) {
+        ESP_LOGW(TAG, "Track format not known yet - cannot mix sound effect");
+        return false;
+    }
+
+    if (sfx_mixer_play(sfx_mixer, clip) != ESP_OK) {
+        ESP_LOGE(TAG, "Mixer rejected sound effect");
+        return false;
+    }
+    memset(clip, 0, sizeof(*clip));  // Mixer releases it once played
+
+    ESP_LOGI(TAG, "Sound effect mixed over current track");
     return true;
 }
 
 /**
- * @brief Main entry point for quick sound effect playback
+ * @brief Check whether a sound effect is playing, standalone or mixed over a track
+ */
+bool audio_sound_effect_is_playing(void)
+{
+    return sound_effect_playing || (sfx_mixer && sfx_mixer_is_active(sfx_mixer));
+}
+
+/**
+ * @brief Quick sound effect playback
  * @param path Path to the sound effect file
+ * @param mixed Optional, set to true when the effect was mixed over the playing track
  * @return true if sound effect playback started successfully, false otherwise
  */
-bool audio_play_sound_effect_quick(const char *path)
+static bool audio_play_sound_effect_quick_internal(const char *path, bool *mixed)
 {
+    if (mixed) {
+        *mixed = false;
+    }
     if (path == NULL || *path == '\0') {
         ESP_LOGE(TAG, "audio_play_sound_effect_quick: NULL or empty path");
         return false;
     }
     
     ESP_LOGI(TAG, "audio_play_sound_effect_quick(path=\"%s\")", path);
-    
-    suppress_auto_play_once = true; // Skip auto-play when detection sound finishes
 
+    // Fetch the PCM before taking audio_mutex: a cache miss decodes from SD card, and playback
+    // control must not wait on that
+    sfx_mixer_clip_t clip = {0};
+    sound_cache_get_clip(path, &clip);
+    
     // Take mutex with shorter timeout since this is for quick sound effects
     if (xSemaphoreTake(audio_mutex, pdMS_TO_TICKS(500)) != pdTRUE) {
         ESP_LOGW(TAG, "audio_play_sound_effect_quick: timeout waiting for mutex");
+        if (clip.pcm) {
+            clip.release(clip.pcm, clip.release_ctx);
+        }
         return false;
     }
-    
-    bool success = audio_play_sound_effect_while_stopped(path);
+
+    bool success = false;
+    if (is_state_playing() && current_audio_type == AUDIO_TYPE_TRACK && !sound_effect_playing) {
+        // Overlay on the running track; fall back to a standalone effect if mixing fails
+        success = audio_play_sound_effect_while_playing(path, &clip);
+        if (mixed) {
+            *mixed = success;
+        }
+    }
+    if (!success) {
+        suppress_auto_play_once = true; // Skip auto-play when detection sound finishes
+        success = audio_play_sound_effect_while_stopped(path, &clip);
+    }
     
     xSemaphoreGive(audio_mutex);
+
+    // Not handed to the mixer or clip reader (uncached fallback or failure)
+    if (clip.pcm) {
+        clip.release(clip.pcm, clip.release_ctx);
+    }
     
     if (success) {
         ESP_LOGI(TAG, "Sound effect quick playback started successfully");
@@ -3350,6 +3894,262 @@ bool audio_play_sound_effect_quick(const char *path)
     return success;
 }
 
+/**
+ * @brief Main entry point for quick sound effect playback
+ * @param path Path to the sound effect file
+ * @return true if sound effect playback started successfully, false otherwise
+ */
+bool audio_play_sound_effect_quick(const char *path)
+{
+    return audio_play_sound_effect_quick_internal(path, NULL);
+}
+
+/**
+ * @brief Skip-latency and heap soak test for the persistent pipeline
+ * @param skip_count Number of consecutive next-track skips (e.g. 500)
+ * @return ESP_OK if every skip started playback, ESP_FAIL otherwise
+ * @note Runs the same sequence as a PLAY_SCREEN next-track press (play_stop, one_step_track,
+ *       audio_start_playing) on the current album and reports skip latency plus PSRAM and
+ *       internal heap high-water marks, including the largest free block to expose fragmentation.
+ */
+esp_err_t audio_player_test_skip_latency(int skip_count)
+{
+    if (skip_count <= 0 || !s3_current_album) {
+        ESP_LOGE(TAG, "Skip latency test needs a positive skip count and a current album");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "STARTING SKIP LATENCY TEST (%d skips, album %s)", skip_count,
+             s3_current_album->sku ? s3_current_album->sku : "unknown");
+
+    size_t psram_free_start    = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    size_t psram_largest_start = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    size_t dram_free_start     = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t psram_low_water     = psram_free_start;
+    size_t dram_low_water      = dram_free_start;
+
+    int64_t min_us = INT64_MAX;
+    int64_t max_us = 0;
+    int64_t total_us = 0;
+    int failures = 0;
+
+    for (int i = 0; i < skip_count; i++) {
+        int64_t start_us = esp_timer_get_time();
+
+        play_stop();
+        one_step_track(true);
+        audio_start_playing();
+
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        if (!is_audio_playing()) {
+            failures++;
+        }
+
+        total_us += elapsed_us;
+        if (elapsed_us < min_us) min_us = elapsed_us;
+        if (elapsed_us > max_us) max_us = elapsed_us;
+
+        size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        size_t dram_free  = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        if (psram_free < psram_low_water) psram_low_water = psram_free;
+        if (dram_free < dram_low_water) dram_low_water = dram_free;
+
+        if ((i + 1) % 50 == 0) {
+            ESP_LOGI(TAG, "Skip %d/%d | last %lld ms | avg %lld ms | PSRAM free %u (largest %u) | DRAM free %u",
+                     i + 1, skip_count, elapsed_us / 1000, total_us / (i + 1) / 1000,
+                     (unsigned int)psram_free,
+                     (unsigned int)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),
+                     (unsigned int)dram_free);
+        }
+
+        // Let the decoder actually produce audio before the next skip
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+
+    play_stop();
+
+    size_t psram_free_end    = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    size_t psram_largest_end = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    size_t dram_free_end     = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+
+    ESP_LOGI(TAG, "========== SKIP LATENCY TEST RESULTS ==========");
+    ESP_LOGI(TAG, "   Skips: %d (failed to start: %d)", skip_count, failures);
+    ESP_LOGI(TAG, "   Skip latency: avg %lld ms | min %lld ms | max %lld ms",
+             total_us / skip_count / 1000, min_us / 1000, max_us / 1000);
+    ESP_LOGI(TAG, "   PSRAM free: start %u | end %u | low-water %u",
+             (unsigned int)psram_free_start, (unsigned int)psram_free_end, (unsigned int)psram_low_water);
+    ESP_LOGI(TAG, "   PSRAM largest block: start %u | end %u",
+             (unsigned int)psram_largest_start, (unsigned int)psram_largest_end);
+    ESP_LOGI(TAG, "   DRAM free: start %u | end %u | low-water %u",
+             (unsigned int)dram_free_start, (unsigned int)dram_free_end, (unsigned int)dram_low_water);
+    ESP_LOGI(TAG, "   Heap minimum ever (8bit): %u", (unsigned int)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    ESP_LOGI(TAG, "===============================================");
+
+    return failures == 0 ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief Read a whole file through a decrypting pipeline into a raw sink and checksum the output
+ * @param fused true: reader decrypts in place; false: plain reader -> xor_decrypt_filter element
+ * @return Bytes drained, or -1 if the pipeline could not be built
+ */
+static int64_t drain_decrypt_pipeline(const char *path, bool fused, uint32_t *checksum, int64_t *elapsed_us)
+{
+    int64_t total = -1;
+    char *chunk = heap_caps_malloc(SOUND_EFFECT_DECODE_CHUNK, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+
+    sd_track_reader_cfg_t fs_cfg = SD_TRACK_READER_CFG_DEFAULT();
+    fs_cfg.prefetch_size = 0;
+    fs_cfg.decrypt = fused;
+    audio_element_handle_t reader = sd_track_reader_init(&fs_cfg);
+
+    audio_element_handle_t xor = NULL;
+    if (!fused) {
+        xor_decrypt_cfg_t xor_cfg = DEFAULT_XOR_DECRYPT_CONFIG();
+        xor_cfg.out_rb_size = 12 * 1024;  // Same as the playback pipeline used before the fused reader
+        xor = xor_decrypt_filter_init(&xor_cfg);
+    }
+
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t raw = raw_stream_init(&raw_cfg);
+
+    if (chunk == NULL || pipeline == NULL || reader == NULL || raw == NULL || (!fused && xor == NULL)) {
+        ESP_LOGE(TAG, "Failed to create decrypt benchmark pipeline");
+        goto cleanup;
+    }
+
+    audio_element_set_event_callback(reader, NULL, NULL);
+    audio_element_set_event_callback(raw, NULL, NULL);
+    audio_pipeline_register(pipeline, reader, "file");
+    audio_pipeline_register(pipeline, raw, "raw");
+    if (xor) {
+        audio_element_set_event_callback(xor, NULL, NULL);
+        audio_pipeline_register(pipeline, xor, "XOR");
+    }
+    const char *fused_tags[2] = {"file", "raw"};
+    const char *chain_tags[3] = {"file", "XOR", "raw"};
+    bool linked = fused ? audio_pipeline_link(pipeline, fused_tags, 2) == ESP_OK
+                        : audio_pipeline_link(pipeline, chain_tags, 3) == ESP_OK;
+    // Elements are owned by the pipeline from here on
+    reader = xor = raw = NULL;
+    if (!linked) {
+        ESP_LOGE(TAG, "Failed to link decrypt benchmark pipeline");
+        goto cleanup;
+    }
+
+    audio_element_handle_t raw_el = audio_pipeline_get_el_by_tag(pipeline, "raw");
+    audio_element_set_input_timeout(raw_el, pdMS_TO_TICKS(500));
+    audio_element_set_uri(audio_pipeline_get_el_by_tag(pipeline, "file"), path);
+
+    uint32_t sum = 0;
+    int64_t start_us = esp_timer_get_time();
+    if (audio_pipeline_run(pipeline) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to run decrypt benchmark pipeline");
+        goto cleanup;
+    }
+    total = 0;
+    int r;
+    while ((r = raw_stream_read(raw_el, chunk, SOUND_EFFECT_DECODE_CHUNK)) > 0) {
+        for (int i = 0; i < r; i++) {
+            sum = sum * 31 + (uint8_t)chunk[i];
+        }
+        total += r;
+    }
+    *elapsed_us = esp_timer_get_time() - start_us;
+    *checksum = sum;
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+
+cleanup:
+    if (pipeline) {
+        audio_pipeline_terminate(pipeline);
+        audio_pipeline_deinit(pipeline);  // Also deinits every registered element
+    }
+    if (reader) audio_element_deinit(reader);
+    if (xor) audio_element_deinit(xor);
+    if (raw) audio_element_deinit(raw);
+    if (chunk) heap_caps_free(chunk);
+    return total;
+}
+
+/**
+ * @brief Decryption throughput test: fused decrypting reader vs reader -> XOR element chain
+ * @param path Encrypted file on the SD card (any track; it is read, not played)
+ * @return ESP_OK if both paths produced identical output, ESP_FAIL otherwise
+ * @note Also times the word-wide xor_decrypt_buffer() against a per-byte modulo loop on a
+ *       PSRAM buffer, to separate CPU cost from SD/ring buffer cost. Run with playback stopped.
+ */
+esp_err_t audio_player_test_decrypt_throughput(const char *path)
+{
+    if (path == NULL || is_audio_playing()) {
+        ESP_LOGE(TAG, "Decrypt throughput test needs a file path and stopped playback");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "STARTING DECRYPT THROUGHPUT TEST (%s)", path);
+
+    // CPU only: 256KB buffer, 8 passes per variant
+    const size_t cpu_len = 256 * 1024;
+    const int cpu_passes = 8;
+    uint8_t *buf = heap_caps_malloc(cpu_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Out of PSRAM for decrypt test buffer");
+        return ESP_ERR_NO_MEM;
+    }
+    memset(buf, 0x5A, cpu_len);
+
+    int64_t start_us = esp_timer_get_time();
+    for (int p = 0; p < cpu_passes; p++) {
+        for (size_t i = 0; i < cpu_len; i++) {
+            buf[i] ^= (uint8_t)XOR_HARDCODED_KEY[(p * cpu_len + i) % XOR_HARDCODED_KEY_LEN];
+        }
+    }
+    int64_t bytewise_us = esp_timer_get_time() - start_us;
+
+    start_us = esp_timer_get_time();
+    for (int p = 0; p < cpu_passes; p++) {
+        xor_decrypt_buffer(buf, cpu_len, (uint64_t)p * cpu_len);
+    }
+    int64_t wordwise_us = esp_timer_get_time() - start_us;
+
+    // Both variants applied the same key stream, so the buffer must be back to its fill value
+    bool cpu_ok = true;
+    for (size_t i = 0; i < cpu_len; i++) {
+        if (buf[i] != 0x5A) {
+            cpu_ok = false;
+            break;
+        }
+    }
+    heap_caps_free(buf);
+
+    uint32_t fused_sum = 0, chain_sum = 0;
+    int64_t fused_us = 0, chain_us = 0;
+    int64_t chain_bytes = drain_decrypt_pipeline(path, false, &chain_sum, &chain_us);
+    int64_t fused_bytes = drain_decrypt_pipeline(path, true, &fused_sum, &fused_us);
+
+    bool stream_ok = fused_bytes > 0 && fused_bytes == chain_bytes && fused_sum == chain_sum;
+    double cpu_mb = (double)cpu_len * cpu_passes / (1024.0 * 1024.0);
+
+    ESP_LOGI(TAG, "========== DECRYPT THROUGHPUT TEST RESULTS ==========");
+    ESP_LOGI(TAG, "   CPU per-byte modulo: %.2f MB/s", bytewise_us > 0 ? cpu_mb * 1e6 / bytewise_us : 0.0);
+    ESP_LOGI(TAG, "   CPU word key schedule: %.2f MB/s (%s)",
+             wordwise_us > 0 ? cpu_mb * 1e6 / wordwise_us : 0.0, cpu_ok ? "round-trip OK" : "MISMATCH");
+    ESP_LOGI(TAG, "   Reader -> XOR element: %lld bytes in %lld ms, %.2f MB/s", chain_bytes, chain_us / 1000,
+             chain_us > 0 ? chain_bytes / (1024.0 * 1024.0) * 1e6 / chain_us : 0.0);
+    ESP_LOGI(TAG, "   Fused reader: %lld bytes in %lld ms, %.2f MB/s", fused_bytes, fused_us / 1000,
+             fused_us > 0 ? fused_bytes / (1024.0 * 1024.0) * 1e6 / fused_us : 0.0);
+    ESP_LOGI(TAG, "   Output %s (checksum %08lx / %08lx)", stream_ok ? "identical" : "DIFFERS",
+             (unsigned long)fused_sum, (unsigned long)chain_sum);
+    ESP_LOGI(TAG, "=====================================================");
+
+    return (cpu_ok && stream_ok) ? ESP_OK : ESP_FAIL;
+}
+
 // ============================================================================
 // PLAYBACK TRACKING IMPLEMENTATION (#15141)
 // ============================================================================
@@ -3379,7 +4179,7 @@ static void start_playback_tracking(const char* file_path) {
 
     // Extract filename and get contentId
     const char* filename = extract_filename(file_path);
-    const char* contentId = GetContentId(filename);
+    char* contentId = GetContentId(filename);
 
     if (!contentId) {
         ESP_LOGD(TAG, "No contentId found for filename: %s - skipping tracking", filename);
@@ -3394,7 +4194,7 @@ static void start_playback_tracking(const char* file_path) {
 
     // Initialize tracking only when contentId is available
     if (current_tracking.contentId) free(current_tracking.contentId);
-    current_tracking.contentId = strdup_spiram(contentId);
+    current_tracking.contentId = contentId;
     current_tracking.start_time = time(NULL);
     current_tracking.total_pause_time = 0;
     current_tracking.pause_start_time = 0;
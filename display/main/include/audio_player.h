@@ -325,10 +325,47 @@ void audio_start_playing_with_transition(bool is_track_transition);
  * @return true if sound effect playback started successfully, false otherwise
  * @note This function uses optimized paths for faster sound effect playback:
  *       - When not playing: Uses direct unmute and minimal buffering
- *       - When playing: Uses pipeline switching to preserve current playback
+ *       - When a track is playing: Mixes the effect over it (music ducked), track keeps playing
  */
 bool audio_play_sound_effect_quick(const char *path);
 
+/**
+ * @brief Check whether a sound effect is playing
+ * @return true while a standalone effect plays or an effect is being mixed over a track
+ */
+bool audio_sound_effect_is_playing(void);
+
+/**
+ * @brief Decode the system sounds (boot, shutdown, volume, NFC detected) into the PSRAM PCM cache
+ * @note Runs automatically in the background after audio_player_init()
+ */
+void audio_sound_cache_preload(void);
+
+/**
+ * @brief Drop cached PCM for a sound file
+ * @param path Sound file path, or NULL to drop every cached sound
+ * @note Call after replacing sound assets; entries are also revalidated against file size/mtime on use
+ */
+void audio_sound_cache_invalidate(const char *path);
+
+/**
+ * @brief Skip-latency and heap soak test for the persistent pipeline
+ * @param skip_count Number of consecutive next-track skips to run (e.g. 500)
+ * @return ESP_OK if every skip started playback, ESP_FAIL otherwise
+ * @note Plays the current album; logs skip latency and PSRAM/internal heap high-water marks.
+ *       Not called by the firmware: run it from a development build once an album is selected.
+ *       It needs the real ADF pipeline, I2S and codec, so host_test has no equivalent.
+ */
+esp_err_t audio_player_test_skip_latency(int skip_count);
+
+/**
+ * @brief Decryption throughput test: fused decrypting file reader vs separate XOR element
+ * @param path Encrypted file to read through both paths (playback must be stopped)
+ * @return ESP_OK if both paths produced identical output, ESP_FAIL otherwise
+ * @note Logs MB/s for each path and for the word-wide vs per-byte XOR loop
+ */
+esp_err_t audio_player_test_decrypt_throughput(const char *path);
+
 /**
  * @brief Scan directory for MP3 files and build playlist
  */
@@ -0,0 +1,24 @@
+#ifndef LV_ANIM_PLAYER_H
+#define LV_ANIM_PLAYER_H
+
+#include "lvgl.h"
+
+/*
+ * GIF player backed by a PSRAM frame cache.
+ *
+ * Each frame is decoded once, on its first showing, and kept as a composited
+ * LV_IMG_CF_TRUE_COLOR_ALPHA image; later loops and later screens showing the same GIF
+ * only swap the image data. The cache is bounded by CONFIG_ANIM_FRAME_CACHE_KB: animations
+ * not on screen are evicted first, and a GIF that does not fit on its own is played by
+ * decoding every frame, as lv_gif does, with a decoder per player. The GIF file and its
+ * decoders count against the budget as well; a GIF whose file and decoder do not fit is
+ * not opened. GUI task only.
+ */
+
+/**
+ * @brief Create an image object playing the GIF at path (drop-in for lv_gif_create + lv_gif_set_src)
+ * @return The object, or NULL when the GIF cannot be opened
+ */
+lv_obj_t *lv_anim_player_create(lv_obj_t *parent, const char *path);
+
+#endif // LV_ANIM_PLAYER_H
@@ -39,13 +39,43 @@ const lv_img_dsc_t *lvgl_get_content_dsc(content_type_t content_type);
 bool lvgl_validate_gif_dsc(const lv_img_dsc_t *gif_dsc);
 void lvgl_free_previous_buffer(void);
 
-// JPEG Cache functions
-void jpeg_cache_init(void);
-void jpeg_cache_invalidate(const char *path);
+// Decoded-image cache (JPEG and PNG), bounded by CONFIG_IMAGE_CACHE_BUDGET_KB of PSRAM
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t insertions;
+    uint32_t evictions;
+    uint32_t rejected;      // Too large, or the budget is held by images on screen
+    uint32_t entries;
+    size_t bytes;           // Currently cached
+    size_t peak_bytes;
+    size_t budget;
+    uint32_t decodes;       // JPEG and PNG decodes, on the GUI task or the prefetch worker
+    uint64_t decode_us;     // Time spent in them
+    uint32_t native_loads;  // Images read from their pre-converted native file instead
+    uint64_t native_us;
+} img_cache_stats_t;
+
+void img_cache_init(void);
+void img_cache_invalidate(const char *path);
+void img_cache_get_stats(img_cache_stats_t *stats);
+void img_cache_log_stats(void);
+
+// Convert a JPEG or PNG into its LVGL-native file (CONFIG_NATIVE_IMAGES), called by sync; a no-op when current
+esp_err_t lvgl_native_img_convert(const char *path);
+// Delete the native file of a source that is being removed from the card
+void lvgl_native_img_remove(const char *path);
+// Delete native files whose source is gone or changed (sync pass); returns how many were removed
+int lvgl_native_img_prune(void);
+
+// Background JPEG prefetch into the image cache (decoded on core 0, off the GUI task)
+void lvgl_prefetch_jpeg(const char *path);
+void lvgl_prefetch_cancel(void);
 
-// PNG Cache functions
-void png_cache_init(void);
-void png_cache_invalidate(const char *path);
+// Show a JPEG in img (through lvgl_get_img()) without decoding on the GUI task: a cached image
+// is shown at once, otherwise img shows a placeholder until the prefetch worker has decoded it.
+// Any later jpg load, or lvgl_free_previous_buffer(), cancels the swap.
+esp_err_t lvgl_show_image_async(lv_obj_t *img, const char *path);
 
 #endif // LV_DECODERS_H
 
@@ -36,4 +36,5 @@ void lv_wifi_helper(void);
 void refresh_screen_display(void);  // Refresh the screen display
 void lvgl_process_step(uint32_t delay_ms);
 void lvgl_tick_inc_locked(uint32_t inc_ms);
+void lvgl_render_monitor_cb(struct _lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px);  // Display driver monitor_cb: per-screen render timing
 #endif /* LV_SCREEN_MGR_H */
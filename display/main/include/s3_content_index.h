@@ -0,0 +1,87 @@
+#ifndef S3_CONTENT_INDEX_H
+#define S3_CONTENT_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Persistent index of album folders on the SD card (tracks, sizes, MP3 validity).
+ *
+ * Album folders are scanned once, on first use, and the result is kept in PSRAM and in
+ * CONTENT_INDEX_PATH. After that, playlists and availability checks read the index
+ * instead of running opendir/readdir/stat on the shared 1-line SD bus. Sync and the
+ * file server report what they change through s3_content_index_file_updated() and
+ * s3_content_index_file_removed(). Changes made elsewhere are picked up per mount: each
+ * album is revalidated against its folder on first use after boot or
+ * s3_content_index_card_changed().
+ *
+ * Album directories are given like s3_album_handler_t.path ("/sdcard/content/full/<SKU>/").
+ * All functions are thread-safe.
+ */
+
+/**
+ * @brief Number of MP3 tracks in an album folder
+ * @param album_dir Album directory, with trailing '/'
+ * @param verify_mp3 Only count files whose header looks like a real MP3 (checked once per file, then cached)
+ * @return Track count, or -1 if the directory does not exist
+ */
+int s3_content_index_track_count(const char *album_dir, bool verify_mp3);
+
+/**
+ * @brief Full paths of an album's MP3 tracks, sorted by name
+ * @param album_dir Album directory, with trailing '/'
+ * @param verify_mp3 Only return files whose header looks like a real MP3
+ * @param out_paths Receives a malloc'd array of PSRAM strings; free each entry and the array
+ * @return Number of paths returned, or -1 if the directory does not exist
+ */
+int s3_content_index_get_tracks(const char *album_dir, bool verify_mp3, char ***out_paths);
+
+/**
+ * @brief Check that a track is present in the index
+ * @param path Full path of the track
+ * @param verify_mp3 Also require a real MP3 header
+ */
+bool s3_content_index_has_track(const char *path, bool verify_mp3);
+
+/**
+ * @brief Record that a file was written or replaced
+ * @note Only MP3 files in already indexed album folders change the index
+ */
+void s3_content_index_file_updated(const char *path);
+
+/**
+ * @brief Record that a file was deleted
+ */
+void s3_content_index_file_removed(const char *path);
+
+/**
+ * @brief Report the size of a track just opened, so a file replaced outside sync is rechecked
+ */
+void s3_content_index_file_seen(const char *path, uint32_t size);
+
+/**
+ * @brief The SD card was (re)mounted: revalidate every album against its folder on next use
+ */
+void s3_content_index_card_changed(void);
+
+/**
+ * @brief Forget an album folder so that it is rescanned on next use
+ * @param album_dir Album directory, or NULL to drop the whole index
+ */
+void s3_content_index_invalidate(const char *album_dir);
+
+/**
+ * @brief Write the index to the SD card if it changed since the last flush
+ */
+esp_err_t s3_content_index_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // S3_CONTENT_INDEX_H
@@ -75,6 +75,8 @@ extern const char *content_type_names[];
 
 // Provisory resources - START
 #define DEFAULT_ALBUM_CONTENT_PATH  "/sdcard/tmp/default_albums.json"
+#define CONTENT_INDEX_PATH          "/sdcard/tmp/content_index.bin"  // s3_content_index: album folders, tracks, sizes
+#define CONTENT_DIGEST_PATH         "/sdcard/tmp/content_digests.txt"  // s3_content_verify: SHA-256 of installed downloads
 #define IMAGE_OP2       "/sdcard/spiffs/images/album_cover_1.jpg"
 #define IMAGE_OP1       "/sdcard/spiffs/images/album_cover_2.jpg"
 
@@ -87,6 +89,7 @@ extern const char *content_type_names[];
 #define BOOT_SOUND      "/sdcard/sound/PIX-WE-01-Power_on.mp3"
 #define SHUTDOWN_SOUND  "/sdcard/sound/PIX-WE-02-Power_off.mp3"
 #define VOLUME_SOUND    "/sdcard/sound/PIX-WE-03-Volume.mp3"
+#define NFC_DETECTED_SOUND "/sdcard/sound/PIX-WE-04-Detected.mp3"
 #define SAMPLE_SOUND    "/sdcard/sound/sample.mp3"
 // Provisory resources - END
 
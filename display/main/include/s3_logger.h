@@ -8,8 +8,17 @@
 
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
+// Logger counters since boot
+typedef struct {
+    uint32_t dropped_lines;     // Lines lost because the ring was full
+    uint32_t truncated_lines;   // Lines cut to the maximum line length
+    uint32_t bytes_written;     // Bytes written to the log file
+    uint32_t rotations;         // Times the log file was rotated
+} s3_logger_stats_t;
+
 #if USE_S3_LOGGER
 // Initialize logging (call once, at startup)
 esp_err_t s3_logger_init(const char *path);
@@ -19,6 +28,8 @@ void s3_logger_close(void);
 void s3_logger_flush_buffer(void);
 // Test function to get vprintf call count
 uint32_t s3_logger_get_call_count(void);
+// Dropped/truncated line counters and file statistics
+void s3_logger_get_stats(s3_logger_stats_t *stats);
 
 // SD card mutex management (used internally, delegates to s3_definitions)
 void s3_logger_init_mutex(void);
@@ -40,6 +51,11 @@ static inline esp_err_t s3_logger_init(const char *path) {
 }
 static inline void s3_logger_close(void) {}
 static inline void s3_logger_flush_buffer(void) {}
+static inline void s3_logger_get_stats(s3_logger_stats_t *stats) {
+    if (stats) {
+        *stats = (s3_logger_stats_t){0};
+    }
+}
 
 #define s3_fopen  fopen
 #define s3_fread  fread
@@ -0,0 +1,506 @@
+#include "lv_anim_player.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "s3_logger.h"
+#include "s3_definitions.h"
+#include "lvgl__lvgl/src/extra/libs/gif/gifdec.h"
+#include <string.h>
+#include <sys/stat.h>
+
+static const char *TAG = "ANIM_PLAYER";
+
+#define ANIM_CACHE_BUDGET       ((size_t)CONFIG_ANIM_FRAME_CACHE_KB * 1024)
+#define ANIM_MIN_DELAY_CS       5       // GIF delays are in 1/100 s; faster frames are held 50 ms
+#define ANIM_TICK_MS            10
+#define ANIM_STATS_INTERVAL_US  (5 * 1000 * 1000)
+
+typedef struct anim_entry {
+    char *path;
+    uint16_t width;
+    uint16_t height;
+    size_t frame_size;              // Bytes of one LV_IMG_CF_TRUE_COLOR_ALPHA frame
+    uint8_t **frames;               // Composited frames decoded so far
+    uint16_t *delays_ms;
+    int frame_count;
+    int frame_cap;
+    int loops;                      // From the GIF: -1 play once, 0 forever, n plays
+    bool loops_known;
+    bool complete;                  // Every frame is cached; the decoder is closed
+    bool streaming;                 // Did not fit the budget: each player decodes on every showing
+    gd_GIF *gif;                    // Fills the frame cache until complete
+    uint8_t *data;                  // GIF file, while any decoder reads it
+    size_t data_size;
+    size_t bytes;                   // Counted against the budget (frames, file and the filling decoder)
+    int refs;                       // Players showing it
+    uint32_t last_used;
+    struct anim_entry *next;
+} anim_entry_t;
+
+typedef struct anim_player {
+    lv_obj_t *obj;
+    lv_timer_t *timer;
+    anim_entry_t *anim;
+    gd_GIF *gif;                    // Own decoder once the animation streams, counted in s_cache_bytes
+    lv_img_dsc_t dsc;
+    int index;                      // Frame on screen
+    int plays;                      // Completed passes
+    uint16_t delay_ms;              // Of the frame on screen
+    uint32_t last_tick;
+    // Statistics since the last report
+    uint32_t frames;
+    uint32_t decoded;
+    uint64_t work_us;
+    uint32_t max_work_us;
+    int64_t stats_start_us;
+    struct anim_player *next;
+} anim_player_t;
+
+// Touched by the GUI task only
+static anim_entry_t *s_anims = NULL;
+static anim_player_t *s_players = NULL;
+static size_t s_cache_bytes = 0;
+static uint32_t s_use_counter = 0;
+
+static void anim_entry_free(anim_entry_t *a)
+{
+    for (anim_entry_t **pp = &s_anims; *pp; pp = &(*pp)->next) {
+        if (*pp == a) {
+            *pp = a->next;
+            break;
+        }
+    }
+    for (int i = 0; i < a->frame_count; i++) {
+        heap_caps_free(a->frames[i]);
+    }
+    if (a->gif) {
+        gd_close_gif(a->gif);
+    }
+    heap_caps_free(a->data);
+    heap_caps_free(a->frames);
+    heap_caps_free(a->delays_ms);
+    s_cache_bytes -= a->bytes;
+    free(a->path);
+    heap_caps_free(a);
+}
+
+/**
+ * @brief Evict least recently used animations not on screen until size more bytes fit the budget
+ */
+static bool anim_cache_reserve(size_t size)
+{
+    while (s_cache_bytes + size > ANIM_CACHE_BUDGET) {
+        anim_entry_t *victim = NULL;
+        for (anim_entry_t *a = s_anims; a; a = a->next) {
+            if (a->refs == 0 && (!victim || (int32_t)(a->last_used - victim->last_used) < 0)) {
+                victim = a;
+            }
+        }
+        if (!victim) {
+            return false;
+        }
+        ESP_LOGI(TAG, "Evicting %s (%d frames, %u KB)", victim->path, victim->frame_count,
+                 (unsigned int)(victim->bytes / 1024));
+        anim_entry_free(victim);
+    }
+    return true;
+}
+
+static void anim_entry_add_bytes(anim_entry_t *a, size_t size)
+{
+    a->bytes += size;
+    s_cache_bytes += size;
+}
+
+static void anim_entry_sub_bytes(anim_entry_t *a, size_t size)
+{
+    a->bytes -= size;
+    s_cache_bytes -= size;
+}
+
+// gifdec allocates the decoder with its canvas and index buffer in one block
+static size_t anim_decoder_size(const anim_entry_t *a)
+{
+    return sizeof(gd_GIF) + (size_t)a->width * a->height * (LV_IMG_PX_SIZE_ALPHA_BYTE + 1);
+}
+
+static anim_entry_t *anim_entry_open(const char *path)
+{
+    for (anim_entry_t *a = s_anims; a; a = a->next) {
+        if (strcmp(a->path, path) == 0) {
+            return a;
+        }
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size <= 0) {
+        ESP_LOGE(TAG, "Failed to stat %s or invalid file size", path);
+        return NULL;
+    }
+    size_t size = st.st_size;
+
+    anim_entry_t *a = heap_caps_calloc(1, sizeof(anim_entry_t), MALLOC_CAP_SPIRAM);
+    if (!a || !(a->path = strdup_spiram(path))) {
+        heap_caps_free(a);
+        return NULL;
+    }
+    a->loops = -1;
+
+    FILE *f = s3_fopen(path, "rb");
+    a->data = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    bool read_ok = f && a->data && s3_fread(a->data, 1, size, f) == size;
+    if (f) {
+        s3_fclose(f);
+    }
+    if (!read_ok || !(a->gif = gd_open_gif_data(a->data))) {
+        ESP_LOGE(TAG, "Failed to load GIF %s", path);
+        anim_entry_free(a);
+        return NULL;
+    }
+
+    a->width = a->gif->width;
+    a->height = a->gif->height;
+    a->frame_size = (size_t)a->width * a->height * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    a->data_size = size;
+
+    // Linked only once it fits, so the reservation cannot evict the entry itself
+    if (!anim_cache_reserve(size + anim_decoder_size(a))) {
+        ESP_LOGE(TAG, "%s needs %u KB to decode, more than the %u KB frame cache has free", path,
+                 (unsigned int)((size + anim_decoder_size(a)) / 1024), (unsigned int)(ANIM_CACHE_BUDGET / 1024));
+        anim_entry_free(a);
+        return NULL;
+    }
+    anim_entry_add_bytes(a, size + anim_decoder_size(a));
+    a->next = s_anims;
+    s_anims = a;
+    ESP_LOGI(TAG, "Opened %s: %ux%u, %u bytes", path, a->width, a->height, (unsigned int)size);
+    return a;
+}
+
+// The decoder is only needed until every frame is cached
+static void anim_entry_close_decoder(anim_entry_t *a)
+{
+    if (a->gif) {
+        gd_close_gif(a->gif);
+        a->gif = NULL;
+        anim_entry_sub_bytes(a, anim_decoder_size(a));
+    }
+    if (a->data) {
+        heap_caps_free(a->data);
+        a->data = NULL;
+        anim_entry_sub_bytes(a, a->data_size);
+    }
+}
+
+// Decode the next frame into the decoder canvas; 1 on a frame, 0 at the end of a pass, -1 on error
+static int anim_decode_next(anim_entry_t *a, gd_GIF *gif)
+{
+    // With loop_count reset, gifdec rewinds and reports the trailer instead of looping by itself
+    if (a->loops_known) {
+        gif->loop_count = -1;
+    }
+    int ret = gd_get_frame(gif);
+    if (!a->loops_known) {
+        a->loops = gif->loop_count;
+        a->loops_known = true;
+    }
+    if (ret == 1) {
+        gd_render_frame(gif, gif->canvas);
+    }
+    return ret;
+}
+
+static uint16_t anim_frame_delay_ms(const gd_GIF *gif)
+{
+    uint16_t delay = gif->gce.delay;
+    return (delay < ANIM_MIN_DELAY_CS ? ANIM_MIN_DELAY_CS : delay) * 10;
+}
+
+static void anim_player_close_decoder(anim_player_t *p)
+{
+    if (p->gif) {
+        gd_close_gif(p->gif);
+        p->gif = NULL;
+        s_cache_bytes -= anim_decoder_size(p->anim);
+    }
+}
+
+/**
+ * @brief Give a player of a streaming animation its own decoder, positioned on the first frame
+ */
+static esp_err_t anim_player_open_decoder(anim_player_t *p, uint16_t *delay_ms)
+{
+    anim_entry_t *a = p->anim;
+    if (!anim_cache_reserve(anim_decoder_size(a)) || !(p->gif = gd_open_gif_data(a->data))) {
+        ESP_LOGE(TAG, "No room for another decoder of %s", a->path);
+        return ESP_ERR_NO_MEM;
+    }
+    s_cache_bytes += anim_decoder_size(a);
+    if (anim_decode_next(a, p->gif) != 1) {
+        ESP_LOGE(TAG, "Failed to decode %s", a->path);
+        anim_player_close_decoder(p);
+        return ESP_FAIL;
+    }
+    *delay_ms = anim_frame_delay_ms(p->gif);
+    return ESP_OK;
+}
+
+/**
+ * @brief Give up caching a GIF that does not fit the budget
+ *
+ * The filling decoder becomes the owner's; other players showing a cached frame restart on their own decoder.
+ */
+static void anim_entry_stream(anim_entry_t *a, anim_player_t *owner)
+{
+    ESP_LOGW(TAG, "%s does not fit the %u KB frame cache after %d frames, decoding on every showing",
+             a->path, (unsigned int)(ANIM_CACHE_BUDGET / 1024), a->frame_count);
+    a->streaming = true;
+    owner->gif = a->gif;
+    a->gif = NULL;
+    a->bytes -= anim_decoder_size(a);
+    owner->dsc.data = owner->gif->canvas;
+    for (int i = 0; i < a->frame_count; i++) {
+        heap_caps_free(a->frames[i]);
+    }
+    anim_entry_sub_bytes(a, a->frame_count * a->frame_size);
+    a->frame_count = 0;
+
+    for (anim_player_t *p = s_players; p; p = p->next) {
+        if (p->anim != a || p == owner) {
+            continue;
+        }
+        p->index = 0;
+        if (anim_player_open_decoder(p, &p->delay_ms) == ESP_OK) {
+            p->dsc.data = p->gif->canvas;
+            lv_img_cache_invalidate_src(&p->dsc);
+            lv_obj_invalidate(p->obj);
+        } else {
+            lv_timer_pause(p->timer);
+        }
+    }
+}
+
+/**
+ * @brief Frame index of the player's animation: cached, or decoded now when it is the next one
+ * @param decoded Set when the frame had to be decoded
+ * @return ESP_ERR_NOT_FOUND past the last frame (the pass is over)
+ */
+static esp_err_t anim_entry_frame(anim_player_t *p, int index, const uint8_t **pixels, uint16_t *delay_ms, bool *decoded)
+{
+    anim_entry_t *a = p->anim;
+    if (!a->streaming && index < a->frame_count) {
+        *pixels = a->frames[index];
+        *delay_ms = a->delays_ms[index];
+        *decoded = false;
+        return ESP_OK;
+    }
+    if (a->complete) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    gd_GIF *gif = a->streaming ? p->gif : a->gif;
+    int ret = anim_decode_next(a, gif);
+    if (ret <= 0) {
+        if (ret < 0 && (a->streaming || a->frame_count == 0)) {
+            ESP_LOGE(TAG, "Failed to decode %s", a->path);
+            return ESP_FAIL;
+        }
+        if (ret < 0) {
+            ESP_LOGW(TAG, "%s is truncated, playing its first %d frames", a->path, a->frame_count);
+        }
+        if (!a->streaming) {
+            a->complete = true;
+            anim_entry_close_decoder(a);
+            ESP_LOGI(TAG, "Cached %s: %d frames, %u KB (frame cache %u/%u KB)", a->path, a->frame_count,
+                     (unsigned int)(a->bytes / 1024), (unsigned int)(s_cache_bytes / 1024),
+                     (unsigned int)(ANIM_CACHE_BUDGET / 1024));
+        }
+        return ESP_ERR_NOT_FOUND;
+    }
+    *decoded = true;
+    *delay_ms = anim_frame_delay_ms(gif);
+
+    if (!a->streaming) {
+        uint8_t *frame = NULL;
+        if (a->frame_count == a->frame_cap) {
+            int cap = a->frame_cap ? a->frame_cap * 2 : 16;
+            uint8_t **frames = heap_caps_realloc(a->frames, cap * sizeof(*frames), MALLOC_CAP_SPIRAM);
+            uint16_t *delays = frames ? heap_caps_realloc(a->delays_ms, cap * sizeof(*delays), MALLOC_CAP_SPIRAM) : NULL;
+            if (frames) {
+                a->frames = frames;
+            }
+            if (delays) {
+                a->delays_ms = delays;
+                a->frame_cap = cap;
+            }
+        }
+        if (a->frame_count < a->frame_cap && anim_cache_reserve(a->frame_size)) {
+            frame = heap_caps_malloc(a->frame_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (!frame) {
+            anim_entry_stream(a, p);
+            gif = p->gif;
+        } else {
+            memcpy(frame, gif->canvas, a->frame_size);
+            a->frames[a->frame_count] = frame;
+            a->delays_ms[a->frame_count] = *delay_ms;
+            a->frame_count++;
+            anim_entry_add_bytes(a, a->frame_size);
+            *pixels = frame;
+            return ESP_OK;
+        }
+    }
+    *pixels = gif->canvas;
+    return ESP_OK;
+}
+
+static void anim_player_log_stats(anim_player_t *p)
+{
+    int64_t elapsed_us = esp_timer_get_time() - p->stats_start_us;
+    if (!p->frames || elapsed_us <= 0) {
+        return;
+    }
+    // lv_timer_get_idle() is the share of time the GUI task spends outside LVGL's timers and refresh
+    ESP_LOGI(TAG, "[ANIM] %s: %u frames (%u decoded), frame work avg %u us max %u us, %.1f fps, "
+             "GUI task load %u%%, frame cache %u/%u KB",
+             p->anim->path, (unsigned int)p->frames, (unsigned int)p->decoded,
+             (unsigned int)(p->work_us / p->frames), (unsigned int)p->max_work_us,
+             p->frames * 1000000.0f / elapsed_us, (unsigned int)(100 - lv_timer_get_idle()),
+             (unsigned int)(s_cache_bytes / 1024), (unsigned int)(ANIM_CACHE_BUDGET / 1024));
+    p->frames = 0;
+    p->decoded = 0;
+    p->work_us = 0;
+    p->max_work_us = 0;
+    p->stats_start_us = esp_timer_get_time();
+}
+
+static void anim_player_show(anim_player_t *p, const uint8_t *pixels)
+{
+    p->dsc.data = pixels;
+    lv_img_cache_invalidate_src(&p->dsc);
+    lv_obj_invalidate(p->obj);
+}
+
+static void anim_player_tick(lv_timer_t *t)
+{
+    anim_player_t *p = t->user_data;
+    if (lv_tick_elaps(p->last_tick) < p->delay_ms) {
+        return;
+    }
+    p->last_tick = lv_tick_get();
+
+    int64_t start_us = esp_timer_get_time();
+    anim_entry_t *a = p->anim;
+    const uint8_t *pixels = NULL;
+    bool decoded = false;
+    int index = p->index + 1;
+    esp_err_t ret = anim_entry_frame(p, index, &pixels, &p->delay_ms, &decoded);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        p->plays++;
+        if (a->loops != 0 && p->plays >= (a->loops < 0 ? 1 : a->loops)) {
+            lv_timer_pause(t);
+            lv_event_send(p->obj, LV_EVENT_READY, NULL);
+            return;
+        }
+        index = 0;
+        ret = anim_entry_frame(p, index, &pixels, &p->delay_ms, &decoded);
+    }
+    if (ret != ESP_OK) {
+        lv_timer_pause(t);
+        return;
+    }
+    p->index = index;
+    anim_player_show(p, pixels);
+
+    uint32_t work_us = esp_timer_get_time() - start_us;
+    p->frames++;
+    p->decoded += decoded;
+    p->work_us += work_us;
+    if (work_us > p->max_work_us) {
+        p->max_work_us = work_us;
+    }
+    if (esp_timer_get_time() - p->stats_start_us >= ANIM_STATS_INTERVAL_US) {
+        anim_player_log_stats(p);
+    }
+}
+
+static void anim_player_delete_cb(lv_event_t *e)
+{
+    anim_player_t *p = lv_event_get_user_data(e);
+    anim_player_log_stats(p);
+    lv_timer_del(p->timer);
+
+    for (anim_player_t **pp = &s_players; *pp; pp = &(*pp)->next) {
+        if (*pp == p) {
+            *pp = p->next;
+            break;
+        }
+    }
+
+    // Complete animations stay cached for the next screen; partial ones only hold a decoder
+    anim_entry_t *a = p->anim;
+    anim_player_close_decoder(p);
+    a->last_used = ++s_use_counter;
+    if (--a->refs == 0 && !a->complete) {
+        anim_entry_free(a);
+    }
+    heap_caps_free(p);
+}
+
+lv_obj_t *lv_anim_player_create(lv_obj_t *parent, const char *path)
+{
+    anim_entry_t *a = anim_entry_open(path);
+    if (!a) {
+        return NULL;
+    }
+    anim_player_t *p = heap_caps_calloc(1, sizeof(anim_player_t), MALLOC_CAP_SPIRAM);
+    if (!p) {
+        if (a->refs == 0 && !a->complete) {
+            anim_entry_free(a);
+        }
+        return NULL;
+    }
+    p->anim = a;
+    a->refs++;
+    a->last_used = ++s_use_counter;
+
+    const uint8_t *pixels = NULL;
+    bool decoded = true;
+    esp_err_t ret;
+    if (a->streaming) {
+        ret = anim_player_open_decoder(p, &p->delay_ms);
+        pixels = ret == ESP_OK ? p->gif->canvas : NULL;
+    } else {
+        ret = anim_entry_frame(p, 0, &pixels, &p->delay_ms, &decoded);
+    }
+    if (ret != ESP_OK) {
+        anim_player_close_decoder(p);
+        if (--a->refs == 0) {
+            anim_entry_free(a);
+        }
+        heap_caps_free(p);
+        return NULL;
+    }
+
+    p->dsc.header.always_zero = 0;
+    p->dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    p->dsc.header.w = a->width;
+    p->dsc.header.h = a->height;
+    p->dsc.data_size = a->frame_size;
+    p->dsc.data = pixels;
+    p->frames = 1;
+    p->decoded = decoded;
+    p->stats_start_us = esp_timer_get_time();
+    p->last_tick = lv_tick_get();
+
+    p->obj = lv_img_create(parent);
+    lv_img_set_src(p->obj, &p->dsc);
+    p->timer = lv_timer_create(anim_player_tick, ANIM_TICK_MS, p);
+    lv_obj_add_event_cb(p->obj, anim_player_delete_cb, LV_EVENT_DELETE, p);
+    p->next = s_players;
+    s_players = p;
+
+    ESP_LOGI(TAG, "Playing %s from %s", path, a->complete ? "the frame cache" : "the decoder");
+    return p->obj;
+}
@@ -4,13 +4,20 @@
 #include "esp_jpeg_dec.h"
 #include "esp_jpeg_common.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
 #include <stdlib.h>
 #include "s3_logger.h"
+#include "lvgl__lvgl/src/extra/libs/png/lodepng.h"
 #include "s3_sync_account_contents.h"
+#include "s3_https_cloud.h"
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <unistd.h>
 
 #if ESP_IDF_VERSION_MAJOR >= 5
@@ -44,388 +51,421 @@ static lv_img_dsc_t content_dsc[CONTENT_TYPE_MAX] = {[0 ... CONTENT_TYPE_MAX-1]
 static uint8_t *content_buf[CONTENT_TYPE_MAX] = {NULL};
 static bool content_buf_is_cached[CONTENT_TYPE_MAX] = {false};
 
-// JPEG Cache for 240x240 images (20 slots)
-#define JPEG_CACHE_SLOTS 20
-#define JPEG_CACHE_TARGET_SIZE 240  // Only cache 240x240 images
-
-typedef struct {
-    char *path;              // File path string (dynamically allocated)
-    uint8_t *buffer;         // Decoded RGB565 image buffer
-    uint32_t timestamp;      // Last access time (monotonic counter for LRU)
-    uint16_t width;          // Image width
-    uint16_t height;         // Image height
-    size_t buffer_size;      // Actual buffer size in bytes
-    bool valid;              // true if slot contains valid data
-} jpeg_cache_entry_t;
-
-static jpeg_cache_entry_t jpeg_cache[JPEG_CACHE_SLOTS];
-static uint32_t cache_timestamp_counter = 0;
-static uint32_t cache_hits = 0;
-static uint32_t cache_misses = 0;
-
-// PNG Cache for any size images (file size based filtering)
-#define PNG_CACHE_SLOTS 30
-#define PNG_CACHE_MAX_FILE_SIZE (100 * 1024)  // Only cache PNGs < 100KB
+/*
+ * Decoded-image cache shared by every loader (JPEG covers and icons, PNG badges).
+ *
+ * Entries are keyed by path (FNV-1a hash, chained buckets) and kept in LRU order. The
+ * cache is bounded by bytes of PSRAM rather than by slot count, so a few large covers and
+ * many small icons share one budget. A buffer borrowed by a descriptor (on screen) is never
+ * evicted or freed: an entry invalidated while on screen moves to a stale list and is freed
+ * once no descriptor borrows it. The GUI task and the prefetch worker share the cache under
+ * img_cache_mutex.
+ */
+#define IMG_CACHE_BUCKETS       64      // Power of two
+#define IMG_CACHE_BUDGET        ((size_t)CONFIG_IMAGE_CACHE_BUDGET_KB * 1024)
+#define IMG_CACHE_MAX_ENTRY     (IMG_CACHE_BUDGET / 4)  // Larger images are not cached
+
+typedef struct img_cache_entry {
+    char *path;                     // File path string (dynamically allocated)
+    uint32_t hash;
+    uint8_t *buffer;                // Display-ready data, described by cf
+    size_t size;                    // Buffer size in bytes
+    uint16_t width;
+    uint16_t height;
+    lv_img_cf_t cf;                 // LV_IMG_CF_TRUE_COLOR for JPEG, LV_IMG_CF_TRUE_COLOR_ALPHA for PNG
+    struct img_cache_entry *chain;  // Next entry in the same bucket
+    struct img_cache_entry *newer;  // LRU list neighbours
+    struct img_cache_entry *older;
+} img_cache_entry_t;
+
+static img_cache_entry_t *img_cache_buckets[IMG_CACHE_BUCKETS];
+static img_cache_entry_t *img_cache_newest = NULL;
+static img_cache_entry_t *img_cache_oldest = NULL;
+static img_cache_entry_t *img_cache_stale = NULL;      // Invalidated while on screen, linked by chain
+static img_cache_stats_t img_cache_stats;
+static SemaphoreHandle_t img_cache_mutex = NULL;
+
+// Background JPEG prefetch: decodes into the image cache on core 0 while the GUI task (core 1) keeps rendering
+#define PREFETCH_QUEUE_LEN      6
+#define PREFETCH_TASK_STACK     (6 * 1024)
+#define PREFETCH_WAIT_MS        1000    // Longest a load waits for the worker to finish the same file
+#define PREFETCH_BIT_IDLE       BIT0
 
 typedef struct {
-    char *path;              // File path string (dynamically allocated)
-    uint8_t *buffer;         // Raw PNG file data
-    uint32_t timestamp;      // Last access time (monotonic counter for LRU)
-    uint16_t width;          // PNG width
-    uint16_t height;         // PNG height
-    size_t file_size;        // PNG file size in bytes
-    bool valid;              // true if slot contains valid data
-} png_cache_entry_t;
-
-static png_cache_entry_t png_cache[PNG_CACHE_SLOTS];
-static uint32_t png_cache_timestamp_counter = 0;
-static uint32_t png_cache_hits = 0;
-static uint32_t png_cache_misses = 0;
-static size_t png_cache_total_bytes = 0;
+    char *path;
+    uint32_t generation;     // Dropped when lvgl_prefetch_cancel() ran after it was queued
+    uint32_t async_seq;      // Non-zero: a screen shows a placeholder until this decode is done
+} prefetch_req_t;
+
+static QueueHandle_t prefetch_queue = NULL;
+static EventGroupHandle_t prefetch_events = NULL;
+static volatile uint32_t prefetch_generation = 0;
+static char *prefetch_busy_path = NULL;  // File the worker is decoding (under img_cache_mutex)
+
+/*
+ * Cover loads that miss the cache are decoded by the prefetch worker, never on the GUI task.
+ * The image object shows a placeholder meanwhile; an LVGL timer on the GUI task polls for the
+ * result and swaps the cover in. The worker hands over pixels the cache would not take.
+ */
+#define ASYNC_POLL_MS           20
+#define ASYNC_PLACEHOLDER_COLOR 0x303030
+
+static struct {
+    uint32_t seq;               // Request being waited for, 0 if none
+    char *path;
+    lv_obj_t *img;
+    lv_timer_t *timer;
+} async_load;                   // GUI task only
+static uint32_t async_next_seq = 0;
+
+static struct {
+    uint32_t seq;               // Last request the worker finished
+    esp_err_t ret;
+    uint8_t *buf;               // Decoded pixels not taken by the cache, owned until the GUI takes them
+    uint16_t width;
+    uint16_t height;
+    size_t len;
+} async_result;                 // Under img_cache_mutex
+
+static void prefetch_start(void);
+static void img_cache_reap_stale(void);
 
 /**
- * @brief Initialize the JPEG cache system
+ * @brief Initialize the image cache and start the prefetch worker
  */
-void jpeg_cache_init(void)
+void img_cache_init(void)
 {
-    for (int i = 0; i < JPEG_CACHE_SLOTS; i++) {
-        jpeg_cache[i].path = NULL;
-        jpeg_cache[i].buffer = NULL;
-        jpeg_cache[i].timestamp = 0;
-        jpeg_cache[i].width = 0;
-        jpeg_cache[i].height = 0;
-        jpeg_cache[i].buffer_size = 0;
-        jpeg_cache[i].valid = false;
-    }
-    cache_timestamp_counter = 0;
-    cache_hits = 0;
-    cache_misses = 0;
-    ESP_LOGI(TAG, "JPEG cache initialized: %d slots for %dx%d images",
-             JPEG_CACHE_SLOTS, JPEG_CACHE_TARGET_SIZE, JPEG_CACHE_TARGET_SIZE);
+    if (!img_cache_mutex) {
+        img_cache_mutex = xSemaphoreCreateMutex();
+    }
+    memset(img_cache_buckets, 0, sizeof(img_cache_buckets));
+    img_cache_newest = NULL;
+    img_cache_oldest = NULL;
+    img_cache_stale = NULL;
+    memset(&img_cache_stats, 0, sizeof(img_cache_stats));
+    img_cache_stats.budget = IMG_CACHE_BUDGET;
+    ESP_LOGI(TAG, "Image cache initialized: %u KB budget, %u KB per image max",
+             (unsigned int)(IMG_CACHE_BUDGET / 1024), (unsigned int)(IMG_CACHE_MAX_ENTRY / 1024));
+
+    prefetch_start();
 }
 
-/**
- * @brief Find a JPEG in the cache by path
- * @param path File path to search for
- * @return Pointer to cache entry if found, NULL otherwise
- */
-static jpeg_cache_entry_t *jpeg_cache_find(const char *path)
+static void img_cache_lock(void)
 {
-    if (!path) return NULL;
+    if (img_cache_mutex) {
+        xSemaphoreTake(img_cache_mutex, portMAX_DELAY);
+    }
+}
 
-    for (int i = 0; i < JPEG_CACHE_SLOTS; i++) {
-        if (jpeg_cache[i].valid &&
-            jpeg_cache[i].path &&
-            strcmp(jpeg_cache[i].path, path) == 0) {
-            // Update timestamp on access (LRU)
-            jpeg_cache[i].timestamp = cache_timestamp_counter++;
-            cache_hits++;
-            ESP_LOGI(TAG, "Cache HIT [%d]: %s (hits=%u, misses=%u, ratio=%.1f%%)",
-                     i, path, cache_hits, cache_misses,
-                     (100.0f * cache_hits) / (cache_hits + cache_misses));
-            return &jpeg_cache[i];
-        }
+static void img_cache_unlock(void)
+{
+    if (img_cache_mutex) {
+        xSemaphoreGive(img_cache_mutex);
     }
+}
 
-    cache_misses++;
-    ESP_LOGI(TAG, "Cache MISS: %s (hits=%u, misses=%u, ratio=%.1f%%)",
-             path, cache_hits, cache_misses,
-             (100.0f * cache_hits) / (cache_hits + cache_misses));
-    return NULL;
+static uint32_t img_cache_hash(const char *path)
+{
+    uint32_t h = 2166136261u;   // FNV-1a
+    while (*path) {
+        h ^= (uint8_t)*path++;
+        h *= 16777619u;
+    }
+    return h;
 }
 
 /**
- * @brief Find the oldest (least recently used) cache slot
- * @return Slot index of the LRU entry
+ * @brief Entry holding path, without touching LRU order or statistics
  */
-static int jpeg_cache_find_oldest_slot(void)
+static img_cache_entry_t *img_cache_lookup(const char *path)
 {
-    int oldest_idx = 0;
-    uint32_t oldest_timestamp = UINT32_MAX;
-
-    // First, prefer invalid (empty) slots
-    for (int i = 0; i < JPEG_CACHE_SLOTS; i++) {
-        if (!jpeg_cache[i].valid) {
-            return i;
+    uint32_t hash = img_cache_hash(path);
+    for (img_cache_entry_t *e = img_cache_buckets[hash & (IMG_CACHE_BUCKETS - 1)]; e; e = e->chain) {
+        if (e->hash == hash && strcmp(e->path, path) == 0) {
+            return e;
         }
     }
+    return NULL;
+}
 
-    // If all slots are valid, find the one with smallest timestamp
-    for (int i = 0; i < JPEG_CACHE_SLOTS; i++) {
-        if (jpeg_cache[i].timestamp < oldest_timestamp) {
-            oldest_timestamp = jpeg_cache[i].timestamp;
-            oldest_idx = i;
-        }
-    }
+static void img_cache_lru_unlink(img_cache_entry_t *e)
+{
+    if (e->newer) e->newer->older = e->older; else img_cache_newest = e->older;
+    if (e->older) e->older->newer = e->newer; else img_cache_oldest = e->newer;
+    e->newer = e->older = NULL;
+}
 
-    return oldest_idx;
+static void img_cache_lru_push(img_cache_entry_t *e)
+{
+    e->older = img_cache_newest;
+    e->newer = NULL;
+    if (img_cache_newest) img_cache_newest->newer = e; else img_cache_oldest = e;
+    img_cache_newest = e;
 }
 
 /**
- * @brief Evict (remove) a cache entry
- * @param slot_index Index of the slot to evict
+ * @brief Find an image in the cache and mark it most recently used
+ * @return Cache entry if found, NULL otherwise
  */
-static void jpeg_cache_evict_slot(int slot_index)
+static img_cache_entry_t *img_cache_find(const char *path)
 {
-    if (slot_index < 0 || slot_index >= JPEG_CACHE_SLOTS) {
-        return;
-    }
-
-    jpeg_cache_entry_t *entry = &jpeg_cache[slot_index];
+    if (!path) return NULL;
 
-    if (entry->path) {
-        ESP_LOGI(TAG, "Cache EVICT [%d]: %s (%ux%u, %u bytes)",
-                 slot_index, entry->path, entry->width, entry->height, (unsigned int)entry->buffer_size);
-        free(entry->path);
-        entry->path = NULL;
-    }
+    img_cache_reap_stale();
 
-    if (entry->buffer) {
-        heap_caps_free(entry->buffer);
-        entry->buffer = NULL;
+    img_cache_entry_t *e = img_cache_lookup(path);
+    if (e) {
+        img_cache_lru_unlink(e);
+        img_cache_lru_push(e);
+        img_cache_stats.hits++;
+        ESP_LOGI(TAG, "Cache HIT: %s (hits=%u, misses=%u, ratio=%.1f%%)",
+                 path, (unsigned int)img_cache_stats.hits, (unsigned int)img_cache_stats.misses,
+                 (100.0f * img_cache_stats.hits) / (img_cache_stats.hits + img_cache_stats.misses));
+        return e;
     }
 
-    entry->timestamp = 0;
-    entry->width = 0;
-    entry->height = 0;
-    entry->buffer_size = 0;
-    entry->valid = false;
+    img_cache_stats.misses++;
+    ESP_LOGI(TAG, "Cache MISS: %s (hits=%u, misses=%u, ratio=%.1f%%)",
+             path, (unsigned int)img_cache_stats.hits, (unsigned int)img_cache_stats.misses,
+             (100.0f * img_cache_stats.hits) / (img_cache_stats.hits + img_cache_stats.misses));
+    return NULL;
 }
 
 /**
- * @brief Invalidate (clear) a specific image from the cache by path
- * @param path File path to invalidate
+ * @brief Whether a cached buffer is currently borrowed by a descriptor (on screen)
  */
-void jpeg_cache_invalidate(const char *path) {
-    if (!path)
-        return;
-
-    for (int i = 0; i < JPEG_CACHE_SLOTS; i++) {
-        if (jpeg_cache[i].valid && jpeg_cache[i].path && strcmp(jpeg_cache[i].path, path) == 0) {
-            ESP_LOGI(TAG, "Cache INVALIDATE [%d]: %s", i, path);
-            jpeg_cache_evict_slot(i);
-            return;
+static bool img_cache_buffer_in_use(const uint8_t *buffer)
+{
+    if (buffer == jpg_buf || buffer == icon_buf || buffer == png_buf) {
+        return true;
+    }
+    for (int i = 0; i < CONTENT_TYPE_MAX; i++) {
+        if (buffer == content_buf[i]) {
+            return true;
         }
     }
-    ESP_LOGD(TAG, "Cache invalidate: %s not found in cache", path);
+    return false;
 }
 
 /**
- * @brief Add a decoded JPEG to the cache
- * @param path File path
- * @param buffer Decoded image buffer (ownership transferred to cache)
- * @param width Image width
- * @param height Image height
- * @param size Buffer size in bytes
+ * @brief Unlink an entry from its bucket and the LRU list, so it can no longer be found
  */
-static void jpeg_cache_add(const char *path, uint8_t *buffer, uint16_t width, uint16_t height, size_t size)
+static void img_cache_unlink(img_cache_entry_t *e)
 {
-    if (!path || !buffer) {
-        return;
+    img_cache_entry_t **link = &img_cache_buckets[e->hash & (IMG_CACHE_BUCKETS - 1)];
+    while (*link && *link != e) {
+        link = &(*link)->chain;
     }
-
-    // Only cache 240x240 images
-    if (width != JPEG_CACHE_TARGET_SIZE || height != JPEG_CACHE_TARGET_SIZE) {
-        ESP_LOGD(TAG, "Not caching %s: size %ux%u != %dx%d",
-                 path, width, height, JPEG_CACHE_TARGET_SIZE, JPEG_CACHE_TARGET_SIZE);
-        return;
+    if (*link) {
+        *link = e->chain;
     }
+    img_cache_lru_unlink(e);
+    e->chain = NULL;
+}
 
-    // Find a slot (prefer empty, otherwise evict oldest)
-    int slot_idx = jpeg_cache_find_oldest_slot();
-
-    // Evict if needed
-    if (jpeg_cache[slot_idx].valid) {
-        jpeg_cache_evict_slot(slot_idx);
-    }
-
-    // Add new entry
-    jpeg_cache_entry_t *entry = &jpeg_cache[slot_idx];
-    entry->path = strdup_spiram(path);
-    entry->buffer = buffer;
-    entry->width = width;
-    entry->height = height;
-    entry->buffer_size = size;
-    entry->timestamp = cache_timestamp_counter++;
-    entry->valid = true;
-
-    ESP_LOGI(TAG, "Cache ADD [%d]: %s (%ux%u, %u bytes) @ %p",
-             slot_idx, path, width, height, (unsigned int)size, buffer);
+static void img_cache_free_entry(img_cache_entry_t *e)
+{
+    img_cache_stats.bytes -= e->size;
+    img_cache_stats.entries--;
+    free(e->path);
+    heap_caps_free(e->buffer);
+    heap_caps_free(e);
 }
 
 /**
- * @brief Initialize the PNG cache system
+ * @brief Unlink an entry and free it
  */
-void png_cache_init(void)
+static void img_cache_remove(img_cache_entry_t *e)
 {
-    for (int i = 0; i < PNG_CACHE_SLOTS; i++) {
-        png_cache[i].path = NULL;
-        png_cache[i].buffer = NULL;
-        png_cache[i].timestamp = 0;
-        png_cache[i].width = 0;
-        png_cache[i].height = 0;
-        png_cache[i].file_size = 0;
-        png_cache[i].valid = false;
-    }
-    png_cache_timestamp_counter = 0;
-    png_cache_hits = 0;
-    png_cache_misses = 0;
-    png_cache_total_bytes = 0;
-    ESP_LOGI(TAG, "PNG cache initialized: %d slots (max %d KB per file)",
-             PNG_CACHE_SLOTS, PNG_CACHE_MAX_FILE_SIZE / 1024);
+    img_cache_unlink(e);
+    img_cache_free_entry(e);
 }
 
 /**
- * @brief Find a PNG in the cache by path
- * @param path File path to search for
- * @return Pointer to cache entry if found, NULL otherwise
+ * @brief Free the stale entries no descriptor borrows any more
  */
-static png_cache_entry_t *png_cache_find(const char *path)
+static void img_cache_reap_stale(void)
 {
-    if (!path) return NULL;
-
-    for (int i = 0; i < PNG_CACHE_SLOTS; i++) {
-        if (png_cache[i].valid &&
-            png_cache[i].path &&
-            strcmp(png_cache[i].path, path) == 0) {
-            // Update timestamp on access (LRU)
-            png_cache[i].timestamp = png_cache_timestamp_counter++;
-            png_cache_hits++;
-            ESP_LOGI(TAG, "PNG Cache HIT [%d]: %s (%ux%u, %u bytes) (hits=%u, misses=%u, ratio=%.1f%%)",
-                     i, path, png_cache[i].width, png_cache[i].height, (unsigned int)png_cache[i].file_size,
-                     png_cache_hits, png_cache_misses,
-                     (100.0f * png_cache_hits) / (png_cache_hits + png_cache_misses));
-            return &png_cache[i];
+    img_cache_entry_t **link = &img_cache_stale;
+    while (*link) {
+        img_cache_entry_t *e = *link;
+        if (img_cache_buffer_in_use(e->buffer)) {
+            link = &e->chain;
+            continue;
         }
+        *link = e->chain;
+        ESP_LOGI(TAG, "Cache FREE stale: %s (%u bytes)", e->path, (unsigned int)e->size);
+        img_cache_free_entry(e);
     }
-
-    png_cache_misses++;
-    ESP_LOGI(TAG, "PNG Cache MISS: %s (hits=%u, misses=%u)", path, png_cache_hits, png_cache_misses);
-    return NULL;
 }
 
 /**
- * @brief Find the oldest (least recently used) PNG cache slot
- * @return Slot index of the LRU entry
+ * @brief Whether buffer belongs to an invalidated entry (its file changed since it was decoded)
  */
-static int png_cache_find_oldest_slot(void)
+static bool img_cache_buffer_stale(const uint8_t *buffer)
 {
-    int oldest_idx = 0;
-    uint32_t oldest_timestamp = UINT32_MAX;
-
-    // First, prefer invalid (empty) slots
-    for (int i = 0; i < PNG_CACHE_SLOTS; i++) {
-        if (!png_cache[i].valid) {
-            return i;
-        }
+    if (!buffer) {
+        return false;
     }
-
-    // If all slots are valid, find the one with smallest timestamp
-    for (int i = 0; i < PNG_CACHE_SLOTS; i++) {
-        if (png_cache[i].timestamp < oldest_timestamp) {
-            oldest_timestamp = png_cache[i].timestamp;
-            oldest_idx = i;
-        }
+    bool stale = false;
+    img_cache_lock();
+    for (img_cache_entry_t *e = img_cache_stale; e && !stale; e = e->chain) {
+        stale = e->buffer == buffer;
     }
-
-    return oldest_idx;
+    img_cache_unlock();
+    return stale;
 }
 
 /**
- * @brief Evict (remove) a PNG cache entry
- * @param slot_index Index of the slot to evict
+ * @brief Evict least recently used entries (skipping those on screen) until size more bytes fit
+ * @return false if not enough could be evicted
  */
-static void png_cache_evict_slot(int slot_index)
+static bool img_cache_make_room(size_t size)
 {
-    if (slot_index < 0 || slot_index >= PNG_CACHE_SLOTS) {
-        return;
-    }
-
-    png_cache_entry_t *entry = &png_cache[slot_index];
-
-    if (entry->path) {
-        ESP_LOGI(TAG, "PNG Cache EVICT [%d]: %s (%ux%u, %u bytes)",
-                 slot_index, entry->path, entry->width, entry->height, (unsigned int)entry->file_size);
-        free(entry->path);
-        entry->path = NULL;
-    }
-
-    if (entry->buffer) {
-        heap_caps_free(entry->buffer);
-        entry->buffer = NULL;
+    img_cache_reap_stale();
+    img_cache_entry_t *e = img_cache_oldest;
+    while (img_cache_stats.bytes + size > IMG_CACHE_BUDGET && e) {
+        img_cache_entry_t *newer = e->newer;
+        if (!img_cache_buffer_in_use(e->buffer)) {
+            ESP_LOGI(TAG, "Cache EVICT: %s (%ux%u, %u bytes)",
+                     e->path, e->width, e->height, (unsigned int)e->size);
+            img_cache_remove(e);
+            img_cache_stats.evictions++;
+        }
+        e = newer;
     }
-
-    entry->timestamp = 0;
-    entry->width = 0;
-    entry->height = 0;
-    entry->file_size = 0;
-    entry->valid = false;
+    return img_cache_stats.bytes + size <= IMG_CACHE_BUDGET;
 }
 
 /**
- * @brief Invalidate (clear) a specific PNG from the cache by path
+ * @brief Invalidate (clear) a specific image from the cache by path
  * @param path File path to invalidate
  */
-void png_cache_invalidate(const char *path) {
+void img_cache_invalidate(const char *path) {
     if (!path)
         return;
 
-    for (int i = 0; i < PNG_CACHE_SLOTS; i++) {
-        if (png_cache[i].valid && png_cache[i].path && strcmp(png_cache[i].path, path) == 0) {
-            ESP_LOGI(TAG, "PNG Cache INVALIDATE [%d]: %s", i, path);
-            png_cache_total_bytes -= png_cache[i].file_size;
-            png_cache_evict_slot(i);
-            return;
-        }
+    img_cache_lock();
+    img_cache_entry_t *e = img_cache_lookup(path);
+    if (e && img_cache_buffer_in_use(e->buffer)) {
+        // Still drawn from: no longer found by path, freed once its descriptor lets go
+        ESP_LOGI(TAG, "Cache INVALIDATE: %s (on screen, freed when released)", path);
+        img_cache_unlink(e);
+        e->chain = img_cache_stale;
+        img_cache_stale = e;
+    } else if (e) {
+        ESP_LOGI(TAG, "Cache INVALIDATE: %s", path);
+        img_cache_remove(e);
+    } else {
+        ESP_LOGD(TAG, "Cache invalidate: %s not found in cache", path);
     }
-    ESP_LOGD(TAG, "PNG cache invalidate: %s not found in cache", path);
+    img_cache_reap_stale();
+    img_cache_unlock();
 }
 
 /**
- * @brief Add a PNG to the cache
+ * @brief Add an image to the cache
  * @param path File path
- * @param buffer Raw PNG file data (ownership transferred to cache)
- * @param width PNG width
- * @param height PNG height
- * @param file_size PNG file size in bytes
+ * @param buffer Image data (ownership transferred to cache on success)
+ * @param width Image width
+ * @param height Image height
+ * @param cf Color format of buffer
+ * @param size Buffer size in bytes
+ * @return true if the cache took the buffer; false leaves it with the caller
  */
-static void png_cache_add(const char *path, uint8_t *buffer, uint16_t width, uint16_t height, size_t file_size)
+static bool img_cache_add(const char *path, uint8_t *buffer, uint16_t width, uint16_t height,
+                          lv_img_cf_t cf, size_t size)
 {
-    if (!path || !buffer) {
-        return;
+    if (!path || !buffer || img_cache_lookup(path)) {
+        return false;
     }
 
-    // Only cache if file size is within limit
-    if (file_size > PNG_CACHE_MAX_FILE_SIZE) {
-        ESP_LOGD(TAG, "Not caching %s: file size %u > max %d",
-                 path, (unsigned int)file_size, PNG_CACHE_MAX_FILE_SIZE);
-        return;
+    if (size > IMG_CACHE_MAX_ENTRY || !img_cache_make_room(size)) {
+        ESP_LOGW(TAG, "Not caching %s (%u bytes): %s", path, (unsigned int)size,
+                 size > IMG_CACHE_MAX_ENTRY ? "too large" : "budget held by images on screen");
+        img_cache_stats.rejected++;
+        return false;
     }
 
-    // Find a slot (prefer empty, otherwise evict oldest)
-    int slot_idx = png_cache_find_oldest_slot();
-
-    // Evict if needed (update total_bytes)
-    if (png_cache[slot_idx].valid) {
-        png_cache_total_bytes -= png_cache[slot_idx].file_size;
-        png_cache_evict_slot(slot_idx);
+    img_cache_entry_t *e = heap_caps_calloc(1, sizeof(img_cache_entry_t), MALLOC_CAP_SPIRAM);
+    char *key = strdup_spiram(path);
+    if (!e || !key) {
+        heap_caps_free(e);
+        free(key);
+        img_cache_stats.rejected++;
+        return false;
     }
+    e->path = key;
+    e->hash = img_cache_hash(path);
+    e->buffer = buffer;
+    e->size = size;
+    e->width = width;
+    e->height = height;
+    e->cf = cf;
+
+    img_cache_entry_t **bucket = &img_cache_buckets[e->hash & (IMG_CACHE_BUCKETS - 1)];
+    e->chain = *bucket;
+    *bucket = e;
+    img_cache_lru_push(e);
+
+    img_cache_stats.insertions++;
+    img_cache_stats.entries++;
+    img_cache_stats.bytes += size;
+    if (img_cache_stats.bytes > img_cache_stats.peak_bytes) {
+        img_cache_stats.peak_bytes = img_cache_stats.bytes;
+    }
+
+    ESP_LOGI(TAG, "Cache ADD: %s (%ux%u, %u bytes) @ %p (total cache: %u KB, %u images)",
+             path, width, height, (unsigned int)size, buffer,
+             (unsigned int)(img_cache_stats.bytes / 1024), (unsigned int)img_cache_stats.entries);
+    return true;
+}
 
-    // Add new entry
-    png_cache_entry_t *entry = &png_cache[slot_idx];
-    entry->path = strdup_spiram(path);
-    entry->buffer = buffer;
-    entry->width = width;
-    entry->height = height;
-    entry->file_size = file_size;
-    entry->timestamp = png_cache_timestamp_counter++;
-    entry->valid = true;
+/**
+ * @brief Count a decode in the cache statistics
+ */
+static void img_cache_count_decode(int64_t elapsed_us)
+{
+    img_cache_lock();
+    img_cache_stats.decodes++;
+    img_cache_stats.decode_us += elapsed_us;
+    img_cache_unlock();
+}
 
-    png_cache_total_bytes += file_size;
+/**
+ * @brief Count a native image read (instead of a decode) in the cache statistics
+ */
+static void img_cache_count_native(int64_t elapsed_us)
+{
+    img_cache_lock();
+    img_cache_stats.native_loads++;
+    img_cache_stats.native_us += elapsed_us;
+    img_cache_unlock();
+}
+
+void img_cache_get_stats(img_cache_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    img_cache_lock();
+    *stats = img_cache_stats;
+    img_cache_unlock();
+}
 
-    ESP_LOGI(TAG, "PNG Cache ADD [%d]: %s (%ux%u, %u bytes) @ %p (total cache: %u KB)",
-             slot_idx, path, width, height, (unsigned int)file_size, buffer,
-             (unsigned int)(png_cache_total_bytes / 1024));
+void img_cache_log_stats(void)
+{
+    img_cache_stats_t st;
+    img_cache_get_stats(&st);
+    uint32_t lookups = st.hits + st.misses;
+    ESP_LOGI(TAG, "Image cache: %u images, %u/%u KB (peak %u KB), hits %u, misses %u (%.1f%%), "
+             "%u added, %u evicted, %u rejected, %u decodes averaging %u ms, %u native reads averaging %u ms",
+             (unsigned int)st.entries, (unsigned int)(st.bytes / 1024), (unsigned int)(st.budget / 1024),
+             (unsigned int)(st.peak_bytes / 1024), (unsigned int)st.hits, (unsigned int)st.misses,
+             lookups ? (100.0f * st.hits) / lookups : 0.0f,
+             (unsigned int)st.insertions, (unsigned int)st.evictions, (unsigned int)st.rejected,
+             (unsigned int)st.decodes, st.decodes ? (unsigned int)(st.decode_us / st.decodes / 1000) : 0,
+             (unsigned int)st.native_loads, st.native_loads ? (unsigned int)(st.native_us / st.native_loads / 1000) : 0);
 }
 
 /**
@@ -555,65 +595,660 @@ static esp_err_t create_fallback_image(content_type_t content_type, uint8_t **ou
         }
     }
 
-    // Set up image descriptor
-    out_dsc->header.cf = LV_IMG_CF_TRUE_COLOR;  // RGB565
-    out_dsc->header.w = width;
-    out_dsc->header.h = height;
-    out_dsc->data_size = buffer_size;
-    out_dsc->data = *out_buf;
+    // Set up image descriptor
+    out_dsc->header.cf = LV_IMG_CF_TRUE_COLOR;  // RGB565
+    out_dsc->header.w = width;
+    out_dsc->header.h = height;
+    out_dsc->data_size = buffer_size;
+    out_dsc->data = *out_buf;
+
+    ESP_LOGI(TAG, "Created fallback image for %s: %dx%d, %s style",
+             content_type_names[content_type], width, height, is_badge ? "badge" : "full-screen");
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Read and decode a JPEG file into a new RGB565 buffer (PSRAM preferred)
+ * @param out_buf Receives the decoded pixels, owned by the caller
+ */
+static esp_err_t jpeg_decode_file(const char *path, uint8_t **out_buf, uint16_t *width, uint16_t *height, size_t *out_len)
+{
+    int64_t start_us = esp_timer_get_time();
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        ESP_LOGE(TAG, "stat %s failed", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t in_len = st.st_size;
+
+    FILE *f = s3_fopen(path, "rb");
+    if (!f) { ESP_LOGE(TAG, "open %s failed", path); return ESP_ERR_NOT_FOUND; }
+
+    uint8_t *jpg_data = malloc(in_len);
+    if (!jpg_data) { s3_fclose(f); return ESP_ERR_NO_MEM; }
+
+    s3_fread(jpg_data, 1, in_len, f);
+    s3_fclose(f);
+
+    jpeg_dec_config_t cfg = DEFAULT_JPEG_DEC_CONFIG();
+#if LV_COLOR_16_SWAP
+    cfg.output_type = JPEG_RAW_TYPE_RGB565_BE;
+#else
+    cfg.output_type = JPEG_RAW_TYPE_RGB565_LE;
+#endif
+    jpeg_dec_handle_t h = jpeg_dec_open(&cfg);
+    if (!h) { free(jpg_data); return ESP_FAIL; }
+
+    jpeg_dec_io_t io = { .inbuf = jpg_data, .inbuf_len = in_len };
+    jpeg_dec_header_info_t info = {0};
+    if (jpeg_dec_parse_header(h, &io, &info) < 0) {
+        jpeg_dec_close(h); free(jpg_data); return ESP_FAIL;
+    }
+
+    size_t len = info.width * info.height * 2;          /* RGB565 */
+
+    uint8_t *buf = heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf)
+        buf = heap_caps_aligned_alloc(16, len, MALLOC_CAP_8BIT);
+    if (!buf) {
+        jpeg_dec_close(h); free(jpg_data); return ESP_ERR_NO_MEM;
+    }
+
+    io.outbuf = buf;
+    if (jpeg_dec_process(h, &io) < 0) {
+        jpeg_dec_close(h); free(jpg_data); heap_caps_free(buf);
+        return ESP_FAIL;
+    }
+    jpeg_dec_close(h);
+    free(jpg_data);
+    img_cache_count_decode(esp_timer_get_time() - start_us);
+
+    *out_buf = buf;
+    *width = info.width;
+    *height = info.height;
+    *out_len = len;
+    return ESP_OK;
+}
+
+/**
+ * @brief Decode a PNG file into LVGL's true color + alpha layout (RGB565 followed by 8-bit alpha)
+ *
+ * The result is drawn by LVGL's built-in decoder straight from memory, so the PNG is inflated
+ * once per load instead of on every draw.
+ */
+static esp_err_t png_decode_file(const char *path, uint8_t **out_buf, uint16_t *width, uint16_t *height, size_t *out_len)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size <= 0) {
+        ESP_LOGE(TAG, "Failed to stat PNG file or invalid size: %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t file_size = st.st_size;
+
+    FILE *f = s3_fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open PNG file: %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t *png_data = heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!png_data) {
+        png_data = heap_caps_malloc(file_size, MALLOC_CAP_8BIT);
+    }
+    if (!png_data) {
+        s3_fclose(f);
+        ESP_LOGE(TAG, "Failed to allocate memory for PNG data: %u bytes", (unsigned int)file_size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (s3_fread(png_data, 1, file_size, f) != file_size) {
+        s3_fclose(f);
+        heap_caps_free(png_data);
+        ESP_LOGE(TAG, "Failed to read PNG data from file");
+        return ESP_FAIL;
+    }
+    s3_fclose(f);
+
+    // lodepng allocates its RGBA8888 output through lv_mem_alloc
+    unsigned char *rgba = NULL;
+    unsigned w = 0, h = 0;
+    unsigned error = lodepng_decode32(&rgba, &w, &h, png_data, file_size);
+    heap_caps_free(png_data);
+    if (error) {
+        if (rgba) {
+            lv_mem_free(rgba);
+        }
+        ESP_LOGE(TAG, "PNG decode failed for %s: %s", path, lodepng_error_text(error));
+        return ESP_FAIL;
+    }
+
+    size_t px_cnt = (size_t)w * h;
+    size_t len = px_cnt * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    uint8_t *buf = heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf) {
+        buf = heap_caps_aligned_alloc(16, len, MALLOC_CAP_8BIT);
+    }
+    if (!buf) {
+        lv_mem_free(rgba);
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for decoded PNG %s", (unsigned int)len, path);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Same conversion as LVGL's PNG decoder: native (byte-swapped) color, then alpha
+    const uint8_t *src = rgba;
+    uint8_t *dst = buf;
+    for (size_t i = 0; i < px_cnt; i++) {
+        lv_color_t c = lv_color_make(src[0], src[1], src[2]);
+        memcpy(dst, &c, LV_IMG_PX_SIZE_ALPHA_BYTE - 1);
+        dst[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = src[3];
+        src += 4;
+        dst += LV_IMG_PX_SIZE_ALPHA_BYTE;
+    }
+    lv_mem_free(rgba);
+    img_cache_count_decode(esp_timer_get_time() - start_us);
+
+    *out_buf = buf;
+    *width = w;
+    *height = h;
+    *out_len = len;
+    return ESP_OK;
+}
+
+/*
+ * LVGL-native image files.
+ *
+ * Sync converts each JPEG and PNG it installs into the pixel layout LVGL draws from (RGB565,
+ * plus 8-bit alpha for PNG) and stores it under NATIVE_IMG_DIR, mirroring the source path.
+ * Loading a native file is a header check and a read instead of a decode. The header records
+ * the source's size and mtime: a native file that no longer matches its source is ignored and
+ * the source is decoded as before. A native file whose source was removed is deleted with it,
+ * and sync prunes any left behind (source gone, or converted from an older version of it).
+ */
+#if CONFIG_NATIVE_IMAGES
+#define NATIVE_IMG_DIR          "/sdcard/tmp/native"
+#define NATIVE_IMG_MAGIC        0x494E3353  // "S3NI"
+#define NATIVE_IMG_VERSION      1
+#define NATIVE_IMG_FLAG_RLE     0x01
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t cf;             // lv_img_cf_t of the pixels
+    uint8_t flags;
+    uint8_t px_size;        // Bytes per pixel
+    uint16_t width;
+    uint16_t height;
+    uint32_t data_len;      // Pixel bytes once expanded
+    uint32_t stored_len;    // Bytes following the header
+    uint32_t src_size;      // Source file the pixels were converted from
+    uint32_t src_mtime;
+} native_img_header_t;
+
+static bool native_img_path(const char *path, char *out, size_t out_size)
+{
+    // "/sdcard/animation_jpg/x.jpg" -> NATIVE_IMG_DIR "/animation_jpg/x.jpg.bin"
+    const char *rel = strncmp(path, "/sdcard/", 8) == 0 ? path + 7 : path;
+    int n = snprintf(out, out_size, NATIVE_IMG_DIR "%s.bin", rel);
+    return n > 0 && (size_t)n < out_size;
+}
+
+static uint8_t native_img_px_size(lv_img_cf_t cf)
+{
+    return cf == LV_IMG_CF_TRUE_COLOR_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+}
+
+/**
+ * @brief Open the native file of path when it is current for the source described by src_st
+ * @return The file, positioned after the header, or NULL
+ */
+static FILE *native_img_open(const char *path, const struct stat *src_st, lv_img_cf_t cf, native_img_header_t *hdr)
+{
+    char native_path[256];
+    if (!native_img_path(path, native_path, sizeof(native_path))) {
+        return NULL;
+    }
+    FILE *f = s3_fopen(native_path, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    uint8_t px_size = native_img_px_size(cf);
+    if (s3_fread(hdr, 1, sizeof(*hdr), f) != sizeof(*hdr) ||
+        hdr->magic != NATIVE_IMG_MAGIC || hdr->version != NATIVE_IMG_VERSION ||
+        hdr->cf != cf || hdr->px_size != px_size ||
+        hdr->data_len != (uint32_t)hdr->width * hdr->height * px_size ||
+        (!(hdr->flags & NATIVE_IMG_FLAG_RLE) && hdr->stored_len != hdr->data_len)) {
+        ESP_LOGW(TAG, "Ignoring invalid native image %s", native_path);
+        s3_fclose(f);
+        return NULL;
+    }
+    if (hdr->src_size != (uint32_t)src_st->st_size || hdr->src_mtime != (uint32_t)src_st->st_mtime) {
+        ESP_LOGD(TAG, "Native image %s is older than its source", native_path);
+        s3_fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+/**
+ * @brief Run-length encode pixels: a control byte n < 0x80 is followed by n + 1 literal pixels,
+ *        n >= 0x80 by one pixel repeated n - 0x7F times
+ * @return Encoded length, or 0 when it would not fit in dst_size
+ */
+static size_t native_rle_encode(const uint8_t *src, size_t px_cnt, size_t px_size, uint8_t *dst, size_t dst_size)
+{
+    size_t i = 0, o = 0;
+    while (i < px_cnt) {
+        size_t run = 1;
+        while (i + run < px_cnt && run < 128 && memcmp(src + (i + run) * px_size, src + i * px_size, px_size) == 0) {
+            run++;
+        }
+        if (run > 1) {
+            if (o + 1 + px_size > dst_size) {
+                return 0;
+            }
+            dst[o++] = 0x80 | (run - 1);
+            memcpy(dst + o, src + i * px_size, px_size);
+            o += px_size;
+            i += run;
+            continue;
+        }
+
+        // Literal pixels up to the next repeat
+        size_t lit = 1;
+        while (i + lit < px_cnt && lit < 128 &&
+               !(i + lit + 1 < px_cnt &&
+                 memcmp(src + (i + lit) * px_size, src + (i + lit + 1) * px_size, px_size) == 0)) {
+            lit++;
+        }
+        if (o + 1 + lit * px_size > dst_size) {
+            return 0;
+        }
+        dst[o++] = lit - 1;
+        memcpy(dst + o, src + i * px_size, lit * px_size);
+        o += lit * px_size;
+        i += lit;
+    }
+    return o;
+}
+
+static bool native_rle_decode(const uint8_t *src, size_t src_len, size_t px_size, uint8_t *dst, size_t dst_len)
+{
+    size_t i = 0, o = 0;
+    while (i < src_len) {
+        uint8_t n = src[i++];
+        if (n & 0x80) {
+            size_t count = n - 0x7F;
+            if (i + px_size > src_len || o + count * px_size > dst_len) {
+                return false;
+            }
+            for (size_t k = 0; k < count; k++, o += px_size) {
+                memcpy(dst + o, src + i, px_size);
+            }
+            i += px_size;
+        } else {
+            size_t bytes = (n + 1) * px_size;
+            if (i + bytes > src_len || o + bytes > dst_len) {
+                return false;
+            }
+            memcpy(dst + o, src + i, bytes);
+            i += bytes;
+            o += bytes;
+        }
+    }
+    return o == dst_len;
+}
+
+/**
+ * @brief Read the native pixels of path into a new buffer (PSRAM preferred), owned by the caller
+ * @return ESP_ERR_NOT_FOUND when there is no current native file
+ */
+static esp_err_t native_img_load(const char *path, lv_img_cf_t cf, uint8_t **out_buf,
+                                 uint16_t *width, uint16_t *height, size_t *out_len)
+{
+    int64_t start_us = esp_timer_get_time();
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    native_img_header_t hdr;
+    FILE *f = native_img_open(path, &st, cf, &hdr);
+    if (!f) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t *buf = heap_caps_aligned_alloc(16, hdr.data_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf) {
+        buf = heap_caps_aligned_alloc(16, hdr.data_len, MALLOC_CAP_8BIT);
+    }
+    if (!buf) {
+        s3_fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool ok;
+    if (hdr.flags & NATIVE_IMG_FLAG_RLE) {
+        uint8_t *packed = heap_caps_malloc(hdr.stored_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ok = packed && s3_fread(packed, 1, hdr.stored_len, f) == hdr.stored_len &&
+             native_rle_decode(packed, hdr.stored_len, hdr.px_size, buf, hdr.data_len);
+        heap_caps_free(packed);
+    } else {
+        ok = s3_fread(buf, 1, hdr.data_len, f) == hdr.data_len;
+    }
+    s3_fclose(f);
+    if (!ok) {
+        ESP_LOGW(TAG, "Failed to read native image of %s, decoding the source", path);
+        heap_caps_free(buf);
+        return ESP_FAIL;
+    }
+
+    img_cache_count_native(esp_timer_get_time() - start_us);
+    *out_buf = buf;
+    *width = hdr.width;
+    *height = hdr.height;
+    *out_len = hdr.data_len;
+    return ESP_OK;
+}
+
+/**
+ * @brief Write pixels as the native file of path (via a temp file, so readers never see half of it)
+ */
+static esp_err_t native_img_write(const char *path, const struct stat *src_st, lv_img_cf_t cf,
+                                  const uint8_t *pixels, uint16_t width, uint16_t height, size_t len)
+{
+    char native_path[256];
+    char temp_path[260];
+    if (!native_img_path(path, native_path, sizeof(native_path))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", native_path);
+
+    native_img_header_t hdr = {
+        .magic = NATIVE_IMG_MAGIC,
+        .version = NATIVE_IMG_VERSION,
+        .cf = cf,
+        .px_size = native_img_px_size(cf),
+        .width = width,
+        .height = height,
+        .data_len = len,
+        .stored_len = len,
+        .src_size = src_st->st_size,
+        .src_mtime = src_st->st_mtime,
+    };
+
+    // Keep the encoded form only when it saves at least a quarter (flat icons and badges)
+    const uint8_t *payload = pixels;
+    uint8_t *packed = NULL;
+#if CONFIG_NATIVE_IMAGES_RLE
+    size_t packed_max = len - len / 4;
+    packed = heap_caps_malloc(packed_max, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (packed) {
+        size_t packed_len = native_rle_encode(pixels, len / hdr.px_size, hdr.px_size, packed, packed_max);
+        if (packed_len) {
+            hdr.flags |= NATIVE_IMG_FLAG_RLE;
+            hdr.stored_len = packed_len;
+            payload = packed;
+        }
+    }
+#endif
+
+    create_directories(native_path);
+    FILE *f = s3_fopen(temp_path, "wb");
+    if (!f) {
+        heap_caps_free(packed);
+        ESP_LOGE(TAG, "Failed to create %s", temp_path);
+        return ESP_FAIL;
+    }
+    bool ok = s3_fwrite(&hdr, 1, sizeof(hdr), f) == sizeof(hdr) &&
+              s3_fwrite(payload, 1, hdr.stored_len, f) == hdr.stored_len;
+    ok = (s3_fclose(f) == 0) && ok;
+    heap_caps_free(packed);
+
+    // FAT cannot rename over an existing file
+    if (ok) {
+        s3_remove(native_path);
+        ok = s3_rename(temp_path, native_path) == 0;
+    }
+    if (!ok) {
+        s3_remove(temp_path);
+        ESP_LOGE(TAG, "Failed to write native image %s", native_path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t lvgl_native_img_convert(const char *path)
+{
+    const char *ext = path ? strrchr(path, '.') : NULL;
+    bool png = ext && strcasecmp(ext, ".png") == 0;
+    if (!ext || (!png && strcasecmp(ext, ".jpg") != 0 && strcasecmp(ext, ".jpeg") != 0)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    lv_img_cf_t cf = png ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Already converted from this version of the source
+    native_img_header_t hdr;
+    FILE *f = native_img_open(path, &st, cf, &hdr);
+    if (f) {
+        s3_fclose(f);
+        return ESP_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    uint8_t *pixels = NULL;
+    uint16_t width = 0, height = 0;
+    size_t len = 0;
+    esp_err_t ret = png ? png_decode_file(path, &pixels, &width, &height, &len)
+                        : jpeg_decode_file(path, &pixels, &width, &height, &len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = native_img_write(path, &st, cf, pixels, width, height, len);
+    heap_caps_free(pixels);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Converted %s to native %ux%u (%u bytes) in %lld ms", path, width, height,
+                 (unsigned int)len, (esp_timer_get_time() - start_us) / 1000);
+    }
+    return ret;
+}
+void lvgl_native_img_remove(const char *path)
+{
+    char native_path[256];
+    if (path && native_img_path(path, native_path, sizeof(native_path)) &&
+        access(native_path, F_OK) == 0 && s3_remove(native_path) == 0) {
+        ESP_LOGI(TAG, "Removed native image %s", native_path);
+    }
+}
+
+/**
+ * @brief Delete the native files under dir whose source is gone or changed, and temp files
+ *        left by an interrupted write; empty subdirectories go too
+ */
+static int native_img_prune_dir(const char *dir)
+{
+    DIR *d = opendir(dir);
+    if (!d) {
+        return 0;
+    }
+
+    int removed = 0;
+    struct dirent *entry;
+    char native_path[256];
+    char src_path[256];
+    while ((entry = readdir(d)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        int n = snprintf(native_path, sizeof(native_path), "%s/%s", dir, entry->d_name);
+        if (n <= 0 || (size_t)n >= sizeof(native_path)) {
+            continue;
+        }
+        if (entry->d_type == DT_DIR) {
+            removed += native_img_prune_dir(native_path);
+            rmdir(native_path);     // Fails while anything is left in it
+            continue;
+        }
+
+        // NATIVE_IMG_DIR "/animation_jpg/x.jpg.bin" -> "/sdcard/animation_jpg/x.jpg"
+        size_t len = strlen(native_path);
+        bool keep = false;
+        if (len > 4 && strcmp(native_path + len - 4, ".bin") == 0) {
+            snprintf(src_path, sizeof(src_path), "/sdcard%.*s", (int)(len - 4 - strlen(NATIVE_IMG_DIR)),
+                     native_path + strlen(NATIVE_IMG_DIR));
+            const char *ext = strrchr(src_path, '.');
+            lv_img_cf_t cf = (ext && strcasecmp(ext, ".png") == 0) ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+            struct stat st;
+            native_img_header_t hdr;
+            FILE *f = stat(src_path, &st) == 0 ? native_img_open(src_path, &st, cf, &hdr) : NULL;
+            if (f) {
+                s3_fclose(f);
+                keep = true;
+            }
+        }
+        if (!keep && s3_remove(native_path) == 0) {
+            ESP_LOGD(TAG, "Pruned native image %s", native_path);
+            removed++;
+        }
+    }
+    closedir(d);
+    return removed;
+}
+
+int lvgl_native_img_prune(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    int removed = native_img_prune_dir(NATIVE_IMG_DIR);
+    if (removed > 0) {
+        ESP_LOGI(TAG, "Pruned %d orphaned native images in %lld ms", removed,
+                 (esp_timer_get_time() - start_us) / 1000);
+    }
+    return removed;
+}
+#else
+static esp_err_t native_img_load(const char *path, lv_img_cf_t cf, uint8_t **out_buf,
+                                 uint16_t *width, uint16_t *height, size_t *out_len)
+{
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t lvgl_native_img_convert(const char *path)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void lvgl_native_img_remove(const char *path)
+{
+}
+
+int lvgl_native_img_prune(void)
+{
+    return 0;
+}
+#endif // CONFIG_NATIVE_IMAGES
+
+/**
+ * @brief JPEG pixels (RGB565): read from the native file when sync produced a current one, else decoded
+ */
+static esp_err_t decode_jpeg_file(const char *path, uint8_t **out_buf, uint16_t *width, uint16_t *height, size_t *out_len)
+{
+    if (native_img_load(path, LV_IMG_CF_TRUE_COLOR, out_buf, width, height, out_len) == ESP_OK) {
+        return ESP_OK;
+    }
+    return jpeg_decode_file(path, out_buf, width, height, out_len);
+}
+
+/**
+ * @brief PNG pixels (RGB565 + alpha): read from the native file when sync produced a current one, else decoded
+ */
+static esp_err_t decode_png_file(const char *path, uint8_t **out_buf, uint16_t *width, uint16_t *height, size_t *out_len)
+{
+    if (native_img_load(path, LV_IMG_CF_TRUE_COLOR_ALPHA, out_buf, width, height, out_len) == ESP_OK) {
+        return ESP_OK;
+    }
+    return png_decode_file(path, out_buf, width, height, out_len);
+}
+
+/**
+ * @brief If the prefetch worker is decoding path right now, wait for it instead of decoding it twice
+ */
+static void prefetch_wait_for(const char *path)
+{
+    if (!prefetch_events) {
+        return;
+    }
+    img_cache_lock();
+    bool busy = prefetch_busy_path && strcmp(prefetch_busy_path, path) == 0;
+    img_cache_unlock();
+    if (busy) {
+        int64_t start_us = esp_timer_get_time();
+        xEventGroupWaitBits(prefetch_events, PREFETCH_BIT_IDLE, pdFALSE, pdTRUE, pdMS_TO_TICKS(PREFETCH_WAIT_MS));
+        ESP_LOGI(TAG, "Waited %lld ms for prefetch of %s", (esp_timer_get_time() - start_us) / 1000, path);
+    }
+}
 
-    ESP_LOGI(TAG, "Created fallback image for %s: %dx%d, %s style",
-             content_type_names[content_type], width, height, is_badge ? "badge" : "full-screen");
+/**
+ * @brief Point a descriptor at the cached pixels of path, releasing what it held before
+ * @return false on a cache miss (descriptor untouched)
+ */
+static bool jpeg_borrow_cached(const char *path, uint8_t **out_buf, lv_img_dsc_t *out_dsc, bool *is_cached)
+{
+    img_cache_lock();
+    img_cache_entry_t *cached = img_cache_find(path);
+    if (!cached) {
+        img_cache_unlock();
+        return false;
+    }
 
-    return ESP_OK;
+    // Free old path and buffer if different (only if owned, not cached)
+    if (out_dsc->path) {
+        free(out_dsc->path);
+        out_dsc->path = NULL;
+    }
+    if (*out_buf && !(*is_cached)) {
+        heap_caps_free(*out_buf);
+        *out_buf = NULL;
+    }
+
+    // Point to cached buffer (no ownership transfer)
+    *out_buf = cached->buffer;
+#if LVGL_VERSION_MAJOR == 8
+    out_dsc->header.cf = cached->cf;
+    out_dsc->header.w  = cached->width;
+    out_dsc->header.h  = cached->height;
+#endif
+    out_dsc->data_size = cached->size;
+    out_dsc->data      = cached->buffer;
+    out_dsc->path      = strdup_spiram(path);
+    *is_cached = true;
+    img_cache_unlock();
+    return true;
 }
 
 static esp_err_t load_jpeg_into_buffer(const char       *path, uint8_t **out_buf, lv_img_dsc_t *out_dsc, bool *is_cached)
 {
-    // Check if path matches existing resource
-    if (out_dsc->path && strcmp(out_dsc->path, path) == 0) {
+    // Check if path matches existing resource (unless the file changed since it was decoded)
+    if (out_dsc->path && strcmp(out_dsc->path, path) == 0 && !img_cache_buffer_stale(*out_buf)) {
         ESP_LOGI(TAG, "JPEG %s already loaded, reusing buffer @ %p", path, *out_buf);
         return ESP_OK;
     }
 
     // Try to find in cache first (ONLY if is_cached tracking is enabled)
     // If is_cached is NULL, caller doesn't want cached buffers (manages own memory)
-    jpeg_cache_entry_t *cached = NULL;
     if (is_cached) {
-        cached = jpeg_cache_find(path);
-    }
-
-    if (cached) {
-        // Cache hit - reuse the cached buffer
-        // Free old path and buffer if different (only if owned, not cached)
-        if (out_dsc->path) {
-            free(out_dsc->path);
-            out_dsc->path = NULL;
-        }
-        if (*out_buf && is_cached && !(*is_cached)) {
-            // Only free if we own the buffer (not borrowed from cache)
-            heap_caps_free(*out_buf);
-            *out_buf = NULL;
-        }
-
-        // Point to cached buffer (no ownership transfer)
-        *out_buf = cached->buffer;
-
-#if LVGL_VERSION_MAJOR == 8
-        out_dsc->header.cf = LV_IMG_CF_TRUE_COLOR;
-        out_dsc->header.w  = cached->width;
-        out_dsc->header.h  = cached->height;
-#endif
-        out_dsc->data_size = cached->buffer_size;
-        out_dsc->data      = cached->buffer;
-        out_dsc->path      = strdup_spiram(path);
-
-        // Mark as cached (borrowed from cache)
-        if (is_cached) {
-            *is_cached = true;
+        prefetch_wait_for(path);
+        if (jpeg_borrow_cached(path, out_buf, out_dsc, is_cached)) {
+            return ESP_OK;
         }
-
-        return ESP_OK;
     }
 
     // Cache miss - need to load and decode
@@ -630,60 +1265,21 @@ static esp_err_t load_jpeg_into_buffer(const char       *path, uint8_t **out_buf
     }
 
     // Load new resource
-    struct stat st;
-    if (stat(path, &st) != 0) {
-        ESP_LOGE(TAG, "stat %s failed", path);
-        return ESP_ERR_NOT_FOUND;
-    }
-
-    size_t in_len = st.st_size;
-
-    FILE *f = s3_fopen(path, "rb");
-    if (!f) { ESP_LOGE(TAG, "open %s failed", path); return ESP_ERR_NOT_FOUND; }
-
-    uint8_t *jpg_data = malloc(in_len);
-    if (!jpg_data) { s3_fclose(f); return ESP_ERR_NO_MEM; }
-
-    s3_fread(jpg_data, 1, in_len, f);
-    s3_fclose(f);
-
-    jpeg_dec_config_t cfg = DEFAULT_JPEG_DEC_CONFIG();
-#if LV_COLOR_16_SWAP
-    cfg.output_type = JPEG_RAW_TYPE_RGB565_BE;
-#else
-    cfg.output_type = JPEG_RAW_TYPE_RGB565_LE;
-#endif
-    jpeg_dec_handle_t h = jpeg_dec_open(&cfg);
-    if (!h) { free(jpg_data); return ESP_FAIL; }
-
-    jpeg_dec_io_t io = { .inbuf = jpg_data, .inbuf_len = in_len };
-    jpeg_dec_header_info_t info = {0};
-    if (jpeg_dec_parse_header(h, &io, &info) < 0) {
-        jpeg_dec_close(h); free(jpg_data); return ESP_FAIL;
-    }
-
-    size_t out_len = info.width * info.height * 2;          /* RGB565 */
-
-    *out_buf = heap_caps_aligned_alloc(16, out_len,
-                                       MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (!*out_buf)
-        *out_buf = heap_caps_aligned_alloc(16, out_len, MALLOC_CAP_8BIT);
-    if (!*out_buf) {
-        jpeg_dec_close(h); free(jpg_data); return ESP_ERR_NO_MEM;
-    }
-
-    io.outbuf = *out_buf;
-    if (jpeg_dec_process(h, &io) < 0) {
-        jpeg_dec_close(h); free(jpg_data); heap_caps_free(*out_buf); *out_buf = NULL;
-        return ESP_FAIL;
+    uint16_t width = 0, height = 0;
+    size_t out_len = 0;
+    uint8_t *decoded = NULL;
+    esp_err_t ret = decode_jpeg_file(path, &decoded, &width, &height, &out_len);
+    if (ret != ESP_OK) {
+        // Old buffer (if borrowed) is dropped too: the descriptor no longer matches it
+        *out_buf = NULL;
+        return ret;
     }
-    jpeg_dec_close(h);
-    free(jpg_data);
+    *out_buf = decoded;
 
 #if LVGL_VERSION_MAJOR == 8
     out_dsc->header.cf = LV_IMG_CF_TRUE_COLOR;
-    out_dsc->header.w  = info.width;
-    out_dsc->header.h  = info.height;
+    out_dsc->header.w  = width;
+    out_dsc->header.h  = height;
 #endif
     out_dsc->data_size = out_len;
     out_dsc->data      = *out_buf;
@@ -691,31 +1287,295 @@ static esp_err_t load_jpeg_into_buffer(const char       *path, uint8_t **out_buf
     // Save the path for future reuse checking
     out_dsc->path = strdup_spiram(path);
 
-    ESP_LOGI(TAG, "JPEG %s → %ux%u (%u B) @ %p", path, info.width, info.height,
+    ESP_LOGI(TAG, "JPEG %s → %ux%u (%u B) @ %p", path, width, height,
              (unsigned int)out_len, *out_buf);
 
     // Try to add to cache if it's 240x240 AND caller supports cache borrowing (is_cached != NULL)
     // Only legacy buffers (jpg_buf, icon_buf) support borrowing from cache
     // Content buffers manage their own memory and shouldn't be cached to avoid duplication
-    if (is_cached && info.width == JPEG_CACHE_TARGET_SIZE && info.height == JPEG_CACHE_TARGET_SIZE) {
+    if (is_cached) {
         // For legacy buffers: add current buffer to cache (transfer ownership to cache)
         // The next time this image is requested, cache will provide it
-        jpeg_cache_add(path, *out_buf, info.width, info.height, out_len);
+        img_cache_lock();
+        *is_cached = img_cache_add(path, *out_buf, width, height, LV_IMG_CF_TRUE_COLOR, out_len);
+        img_cache_unlock();
+
+        if (*is_cached) {
+            ESP_LOGI(TAG, "Added to cache [%s]: buffer @ %p now managed by cache", path, *out_buf);
+        }
+    }
+
+    return ESP_OK;
+}
+
+static void prefetch_task(void *arg)
+{
+    prefetch_req_t req;
+    while (true) {
+        if (xQueueReceive(prefetch_queue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        img_cache_lock();
+        // A screen waiting for the decode is never cancelled; it only needs the image cached
+        bool cached = img_cache_lookup(req.path) != NULL;
+        bool skip = cached || (!req.async_seq && req.generation != prefetch_generation);
+        if (cached && req.async_seq) {
+            heap_caps_free(async_result.buf);
+            async_result.buf = NULL;
+            async_result.seq = req.async_seq;
+            async_result.ret = ESP_OK;
+        }
+        if (!skip) {
+            prefetch_busy_path = req.path;
+            xEventGroupClearBits(prefetch_events, PREFETCH_BIT_IDLE);
+        }
+        img_cache_unlock();
+        if (skip) {
+            free(req.path);
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        uint8_t *buf = NULL;
+        uint16_t width = 0, height = 0;
+        size_t len = 0;
+        esp_err_t ret = decode_jpeg_file(req.path, &buf, &width, &height, &len);
+
+        img_cache_lock();
+        bool added = ret == ESP_OK && img_cache_add(req.path, buf, width, height, LV_IMG_CF_TRUE_COLOR, len);
+        if (req.async_seq) {
+            // An earlier result nobody took is dropped
+            heap_caps_free(async_result.buf);
+            async_result.buf = NULL;
+            async_result.seq = req.async_seq;
+            async_result.ret = ret;
+            if (ret == ESP_OK && !added) {
+                async_result.buf = buf;
+                async_result.width = width;
+                async_result.height = height;
+                async_result.len = len;
+                buf = NULL;
+                added = true;
+            }
+        }
+        prefetch_busy_path = NULL;
+        xEventGroupSetBits(prefetch_events, PREFETCH_BIT_IDLE);
+        img_cache_unlock();
+
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Prefetch of %s failed: %s", req.path, esp_err_to_name(ret));
+        } else {
+            ESP_LOGI(TAG, "Prefetched %s in %lld ms%s", req.path, (esp_timer_get_time() - start_us) / 1000,
+                     added ? "" : " (not cacheable, dropped)");
+            if (!added) {
+                heap_caps_free(buf);
+            }
+        }
+        free(req.path);
+    }
+}
+
+static void prefetch_start(void)
+{
+    if (prefetch_queue) {
+        return;
+    }
+    prefetch_events = xEventGroupCreate();
+    prefetch_queue = xQueueCreate(PREFETCH_QUEUE_LEN, sizeof(prefetch_req_t));
+    if (!prefetch_events || !prefetch_queue) {
+        ESP_LOGE(TAG, "Failed to create prefetch queue - covers will be decoded on demand");
+        return;
+    }
+    xEventGroupSetBits(prefetch_events, PREFETCH_BIT_IDLE);
+
+    // Core 0: the GUI task runs on core 1. The stack stays in internal RAM: the worker reads
+    // the SD card, and flash/SD operations may run with the PSRAM cache disabled
+    if (xTaskCreatePinnedToCore(prefetch_task, "img_prefetch", PREFETCH_TASK_STACK, NULL, 2,
+                                NULL, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start prefetch worker - covers will be decoded on demand");
+        vQueueDelete(prefetch_queue);
+        prefetch_queue = NULL;
+    }
+}
+
+void lvgl_prefetch_jpeg(const char *path)
+{
+    if (!prefetch_queue || !path || !path[0]) {
+        return;
+    }
+    prefetch_req_t req = {
+        .path = strdup_spiram(path),
+        .generation = prefetch_generation,
+    };
+    if (!req.path) {
+        return;
+    }
+    // Never block the GUI task: a full queue just means this one is decoded on demand
+    if (xQueueSend(prefetch_queue, &req, 0) != pdTRUE) {
+        ESP_LOGD(TAG, "Prefetch queue full, skipping %s", path);
+        free(req.path);
+    }
+}
+
+void lvgl_prefetch_cancel(void)
+{
+    // Queued requests are dropped by the worker; a decode already running still lands in the cache
+    prefetch_generation++;
+}
+
+/**
+ * @brief Forget the cover load being waited for; a decode already queued still lands in the cache
+ */
+static void async_load_cancel(void)
+{
+    if (async_load.timer) {
+        lv_timer_del(async_load.timer);
+        async_load.timer = NULL;
+    }
+    free(async_load.path);
+    async_load.path = NULL;
+    async_load.img = NULL;
+    async_load.seq = 0;
+}
+
+static void async_placeholder_set(lv_obj_t *img, bool on)
+{
+    if (on) {
+        lv_obj_set_size(img, LV_PCT(100), LV_PCT(100));
+        lv_obj_set_style_bg_color(img, lv_color_hex(ASYNC_PLACEHOLDER_COLOR), LV_PART_MAIN);
+        lv_obj_set_style_bg_opa(img, LV_OPA_COVER, LV_PART_MAIN);
+    } else {
+        lv_obj_set_style_bg_opa(img, LV_OPA_TRANSP, LV_PART_MAIN);
+        lv_obj_set_size(img, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+    }
+}
+
+static esp_err_t async_load_queue(const char *path)
+{
+    if (++async_next_seq == 0) {
+        async_next_seq = 1;
+    }
+    prefetch_req_t req = {
+        .path = strdup_spiram(path),
+        .generation = prefetch_generation,
+        .async_seq = async_next_seq,
+    };
+    if (!req.path) {
+        return ESP_ERR_NO_MEM;
+    }
+    // Ahead of the neighbour prefetches: this one is on screen
+    if (xQueueSendToFront(prefetch_queue, &req, 0) != pdTRUE) {
+        free(req.path);
+        return ESP_ERR_NO_MEM;
+    }
+    async_load.seq = req.async_seq;
+    return ESP_OK;
+}
+
+/**
+ * @brief GUI task timer: swap the decoded cover in once the worker is done with it
+ */
+static void async_load_poll(lv_timer_t *timer)
+{
+    img_cache_lock();
+    bool done = async_result.seq == async_load.seq;
+    esp_err_t ret = async_result.ret;
+    uint8_t *buf = NULL;
+    uint16_t width = async_result.width, height = async_result.height;
+    size_t len = async_result.len;
+    if (done) {
+        buf = async_result.buf;
+        async_result.buf = NULL;
+    }
+    img_cache_unlock();
+    if (!done) {
+        return;
+    }
+
+    lv_obj_t *img = async_load.img;
+    if (!lv_obj_is_valid(img)) {
+        // Screen changed meanwhile: the cover stays cached for the next showing
+        heap_caps_free(buf);
+        async_load_cancel();
+        return;
+    }
+
+    if (ret == ESP_OK && buf) {
+        // Not cacheable: the descriptor owns the pixels, as after a direct decode
+        if (jpg_dsc.path) {
+            free(jpg_dsc.path);
+        }
+        if (jpg_buf && !jpg_buf_is_cached) {
+            heap_caps_free(jpg_buf);
+        }
+        jpg_buf = buf;
+        jpg_buf_is_cached = false;
+#if LVGL_VERSION_MAJOR == 8
+        jpg_dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+        jpg_dsc.header.w  = width;
+        jpg_dsc.header.h  = height;
+#endif
+        jpg_dsc.data_size = len;
+        jpg_dsc.data      = buf;
+        jpg_dsc.path      = strdup_spiram(async_load.path);
+    } else if (ret == ESP_OK && !jpeg_borrow_cached(async_load.path, &jpg_buf, &jpg_dsc, &jpg_buf_is_cached)) {
+        // Evicted before the GUI got to it: decode it again, still off the GUI task
+        if (async_load_queue(async_load.path) == ESP_OK) {
+            return;
+        }
+        ret = ESP_ERR_NO_MEM;
+    }
+
+    if (ret == ESP_OK) {
+        async_placeholder_set(img, false);
+        lv_img_set_src(img, &jpg_dsc);
+        ESP_LOGI(TAG, "Cover %s swapped in", async_load.path);
+    } else {
+        ESP_LOGW(TAG, "Cover %s failed to load: %s, keeping the placeholder", async_load.path, esp_err_to_name(ret));
+    }
+    async_load_cancel();
+}
+
+esp_err_t lvgl_show_image_async(lv_obj_t *img, const char *path)
+{
+    async_load_cancel();
+    if (!img || !path || !path[0]) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-        // Mark that this buffer is now owned by cache (don't free on cleanup)
-        *is_cached = true;
+    // Already decoded: shown right away
+    bool shown = jpg_dsc.path && strcmp(jpg_dsc.path, path) == 0 && !img_cache_buffer_stale(jpg_buf);
+    if (shown || jpeg_borrow_cached(path, &jpg_buf, &jpg_dsc, &jpg_buf_is_cached)) {
+        lv_img_set_src(img, &jpg_dsc);
+        return ESP_OK;
+    }
 
-        ESP_LOGI(TAG, "Added to cache [%s]: buffer @ %p now managed by cache", path, *out_buf);
-    } else if (is_cached) {
-        // Mark as owned (not cached) for non-240x240 images
-        *is_cached = false;
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!prefetch_queue || async_load_queue(path) != ESP_OK) {
+        ESP_LOGW(TAG, "Prefetch worker unavailable, decoding %s on the GUI task", path);
+        esp_err_t ret = load_jpeg_into_buffer(path, &jpg_buf, &jpg_dsc, &jpg_buf_is_cached);
+        if (ret == ESP_OK) {
+            lv_img_set_src(img, &jpg_dsc);
+        }
+        return ret;
     }
 
+    async_load.path = strdup_spiram(path);
+    async_load.img = img;
+    async_load.timer = lv_timer_create(async_load_poll, ASYNC_POLL_MS, NULL);
+    async_placeholder_set(img, true);
+    ESP_LOGI(TAG, "Cover %s queued for decoding, placeholder shown", path);
     return ESP_OK;
 }
 
 esp_err_t lvgl_load_image_from_sdcard(const char *path)
 {
+    // The synchronous load takes over jpg_dsc from a cover still being decoded
+    async_load_cancel();
     return load_jpeg_into_buffer(path, &jpg_buf, &jpg_dsc, &jpg_buf_is_cached);
 }
 
@@ -806,47 +1666,20 @@ const lv_img_dsc_t *lvgl_get_gif(void)
     return &gif_dsc;
 }
 
-// Simple PNG header parser to extract dimensions
-static esp_err_t parse_png_header(const char *path, uint32_t *width, uint32_t *height)
-{
-    FILE *f = s3_fopen(path, "rb");
-    if (!f) {
-        return ESP_FAIL;
-    }
-
-    uint8_t header[24]; // PNG signature (8) + IHDR length (4) + IHDR type (4) + width (4) + height (4)
-    if (s3_fread(header, 1, 24, f) != 24) {
-        s3_fclose(f);
-        return ESP_FAIL;
-    }
-    s3_fclose(f);
-
-    // Check PNG signature
-    uint8_t png_sig[8] = {0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A};
-    if (memcmp(header, png_sig, 8) != 0) {
-        return ESP_FAIL;
-    }
-
-    // Extract width and height from IHDR chunk (big endian)
-    *width = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
-    *height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
-
-    return ESP_OK;
-}
-
 static esp_err_t load_png_into_buffer(const char *path, uint8_t **out_buf, lv_img_dsc_t *out_dsc, bool *is_cached)
 {
-    // Check if path matches existing resource
-    if (out_dsc->path && strcmp(out_dsc->path, path) == 0) {
+    // Check if path matches existing resource (unless the file changed since it was decoded)
+    if (out_dsc->path && strcmp(out_dsc->path, path) == 0 && !img_cache_buffer_stale(*out_buf)) {
         ESP_LOGI(TAG, "PNG %s already loaded, reusing buffer @ %p", path, *out_buf);
         return ESP_OK;
     }
 
     // Try to find in cache first (ONLY if is_cached tracking is enabled)
     // If is_cached is NULL, caller doesn't want cached buffers (manages own memory)
-    png_cache_entry_t *cached = NULL;
+    img_cache_entry_t *cached = NULL;
     if (is_cached) {
-        cached = png_cache_find(path);
+        img_cache_lock();
+        cached = img_cache_find(path);
     }
 
     if (cached) {
@@ -866,11 +1699,11 @@ static esp_err_t load_png_into_buffer(const char *path, uint8_t **out_buf, lv_im
         *out_buf = cached->buffer;
 
 #if LVGL_VERSION_MAJOR == 8
-        out_dsc->header.cf = LV_IMG_CF_UNKNOWN;  // Let LVGL decode PNG
+        out_dsc->header.cf = cached->cf;
         out_dsc->header.w  = cached->width;
         out_dsc->header.h  = cached->height;
 #endif
-        out_dsc->data_size = cached->file_size;
+        out_dsc->data_size = cached->size;
         out_dsc->data      = cached->buffer;
         out_dsc->path      = strdup_spiram(path);
 
@@ -878,9 +1711,13 @@ static esp_err_t load_png_into_buffer(const char *path, uint8_t **out_buf, lv_im
         if (is_cached) {
             *is_cached = true;
         }
+        img_cache_unlock();
 
         return ESP_OK;
     }
+    if (is_cached) {
+        img_cache_unlock();
+    }
 
     // Cache miss - need to load PNG file
     // Free old path and buffer if different (only if owned, not cached)
@@ -895,76 +1732,39 @@ static esp_err_t load_png_into_buffer(const char *path, uint8_t **out_buf, lv_im
         *out_buf = NULL;
     }
 
-    // Get file size using stat
-    struct stat st;
-    if (stat(path, &st) != 0 || st.st_size <= 0) {
-        ESP_LOGE(TAG, "Failed to stat PNG file or invalid size: %s", path);
-        return ESP_ERR_NOT_FOUND;
-    }
-
-    size_t file_size = st.st_size;
-
-    // Parse PNG header to get dimensions
-    uint32_t width = 0, height = 0;
-    if (parse_png_header(path, &width, &height) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to parse PNG header: %s", path);
-        return ESP_ERR_NOT_FOUND;
-    }
-
-    // Load PNG file
-    FILE *f = s3_fopen(path, "rb");
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open PNG file: %s", path);
-        return ESP_ERR_NOT_FOUND;
-    }
-
-    // Allocate memory for PNG data (try PSRAM first, then internal)
-    *out_buf = heap_caps_aligned_alloc(16, file_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (!*out_buf) {
-        *out_buf = heap_caps_aligned_alloc(16, file_size, MALLOC_CAP_8BIT);
-        if (!*out_buf) {
-            s3_fclose(f);
-            ESP_LOGE(TAG, "Failed to allocate memory for PNG data: %u bytes", (unsigned int)file_size);
-            return ESP_ERR_NO_MEM;
-        }
-    }
-
-    // Read PNG data into buffer
-    if (s3_fread(*out_buf, 1, file_size, f) != file_size) {
-        s3_fclose(f);
-        heap_caps_free(*out_buf);
+    // Decode once; the pixels are what gets cached and drawn
+    uint16_t width = 0, height = 0;
+    size_t data_size = 0;
+    esp_err_t ret = decode_png_file(path, out_buf, &width, &height, &data_size);
+    if (ret != ESP_OK) {
         *out_buf = NULL;
-        ESP_LOGE(TAG, "Failed to read PNG data from file");
-        return ESP_FAIL;
+        return ret;
     }
-    s3_fclose(f);
 
     // Set up PNG descriptor
 #if LVGL_VERSION_MAJOR == 8
-    out_dsc->header.cf = LV_IMG_CF_UNKNOWN;  // Let LVGL detect and decode PNG
+    out_dsc->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
     out_dsc->header.w = width;
     out_dsc->header.h = height;
 #endif
-    out_dsc->data_size = file_size;
+    out_dsc->data_size = data_size;
     out_dsc->data      = *out_buf;
 
     // Save the path for future reuse checking
     out_dsc->path = strdup_spiram(path);
 
-    ESP_LOGI(TAG, "PNG %s → %ux%u (file: %u bytes) @ %p", path, width, height, (unsigned int)file_size, *out_buf);
+    ESP_LOGI(TAG, "PNG %s → %ux%u (decoded: %u bytes) @ %p", path, width, height, (unsigned int)data_size, *out_buf);
 
-    // Try to add to cache if file size is within limit AND caller supports cache borrowing
-    if (is_cached && file_size <= PNG_CACHE_MAX_FILE_SIZE) {
+    // Try to add to cache if caller supports cache borrowing (oversized PNGs stay owned)
+    if (is_cached) {
         // Transfer ownership to cache
-        png_cache_add(path, *out_buf, width, height, file_size);
+        img_cache_lock();
+        *is_cached = img_cache_add(path, *out_buf, width, height, LV_IMG_CF_TRUE_COLOR_ALPHA, data_size);
+        img_cache_unlock();
 
-        // Mark that this buffer is now owned by cache (don't free on cleanup)
-        *is_cached = true;
-
-        ESP_LOGI(TAG, "Added to PNG cache [%s]: buffer @ %p now managed by cache", path, *out_buf);
-    } else if (is_cached) {
-        // Mark as owned (not cached) for oversized PNGs
-        *is_cached = false;
+        if (*is_cached) {
+            ESP_LOGI(TAG, "Added to PNG cache [%s]: buffer @ %p now managed by cache", path, *out_buf);
+        }
     }
 
     return ESP_OK;
@@ -1221,12 +2021,13 @@ esp_err_t lvgl_set_content_buffer(content_type_t content_type,
     }
 
     // Free any existing buffer for this content type
-    if (content_buf[content_type]) {
+    if (content_buf[content_type] && !content_buf_is_cached[content_type]) {
         ESP_LOGI(TAG, "Freeing existing [%s] buffer @ %p",
                  content_type_names[content_type], content_buf[content_type]);
         heap_caps_free(content_buf[content_type]);
-        content_buf[content_type] = NULL;
     }
+    content_buf[content_type] = NULL;
+    content_buf_is_cached[content_type] = false;
 
     // Free any existing path
     if (content_dsc[content_type].path) {
@@ -1276,10 +2077,11 @@ esp_err_t lvgl_load_content_jpg(content_type_t content_type, const char *path)
             free(content_dsc[content_type].path);
             content_dsc[content_type].path = NULL;
         }
-        if (content_buf[content_type]) {
-            free(content_buf[content_type]);
-            content_buf[content_type] = NULL;
+        if (content_buf[content_type] && !content_buf_is_cached[content_type]) {
+            heap_caps_free(content_buf[content_type]);
         }
+        content_buf[content_type] = NULL;
+        content_buf_is_cached[content_type] = false;
         if (result == ESP_ERR_NOT_FOUND) {
             ESP_LOGE(TAG, "Error loading JPEG [%s]: %s", content_type_names[content_type], esp_err_to_name(result));
             // Remove resource verion, so we can reload during data sync
@@ -1322,10 +2124,11 @@ esp_err_t lvgl_load_content_png(content_type_t content_type, const char *path)
             free(content_dsc[content_type].path);
             content_dsc[content_type].path = NULL;
         }
-        if (content_buf[content_type]) {
-            free(content_buf[content_type]);
-            content_buf[content_type] = NULL;
+        if (content_buf[content_type] && !content_buf_is_cached[content_type]) {
+            heap_caps_free(content_buf[content_type]);
         }
+        content_buf[content_type] = NULL;
+        content_buf_is_cached[content_type] = false;
         if (result == ESP_ERR_NOT_FOUND) {
             ESP_LOGE(TAG, "Error loading JPEG [%s]: %s", content_type_names[content_type], esp_err_to_name(result));
             // Remove resource verion, so we can reload during data sync
@@ -1369,10 +2172,11 @@ esp_err_t lvgl_load_content_gif(content_type_t content_type, const char *path)
         free(content_dsc[content_type].path);
         content_dsc[content_type].path = NULL;
     }
-    if (content_buf[content_type]) {
+    if (content_buf[content_type] && !content_buf_is_cached[content_type]) {
         heap_caps_free(content_buf[content_type]);
-        content_buf[content_type] = NULL;
     }
+    content_buf[content_type] = NULL;
+    content_buf_is_cached[content_type] = false;
 
     struct stat st;
     if (stat(path, &st) != 0 || st.st_size <= 0) {
@@ -1440,6 +2244,8 @@ const lv_img_dsc_t *lvgl_get_content_dsc(content_type_t content_type)
 
 void lvgl_free_previous_buffer(void)
 {
+    async_load_cancel();
+
     // Free legacy buffers (only if owned, not borrowed from cache)
     if (jpg_buf && !jpg_buf_is_cached)  { heap_caps_free(jpg_buf);  jpg_buf  = NULL; }
     if (icon_buf && !icon_buf_is_cached) { heap_caps_free(icon_buf); icon_buf = NULL; }
@@ -1485,6 +2291,11 @@ void lvgl_free_previous_buffer(void)
         }
         memset(&content_dsc[i], 0, sizeof(content_dsc[i]));
     }
+
+    // Nothing borrows from the cache any more
+    img_cache_lock();
+    img_cache_reap_stale();
+    img_cache_unlock();
 }
 
 bool lvgl_validate_gif_dsc(const lv_img_dsc_t *gif_dsc) {
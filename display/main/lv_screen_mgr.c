@@ -11,12 +11,12 @@ static void ui_add_top_badge(void);
 #include "lvgl.h"
 #include "esp_heap_caps.h"
 #include "lv_decoders.h"
+#include "lv_anim_player.h"
 #include "lv_screen_mgr.h"
 #include "audio_player.h"
 #include "s3_definitions.h"
 #include "lvgl__lvgl/src/misc/lv_color.h"
 #include "lvgl__lvgl/src/extra/libs/qrcode/lv_qrcode.h"
-#include "lvgl__lvgl/src/extra/libs/gif/lv_gif.h"
 #include "fonts/cherry_bomb_fonts.h"
 #include "storage.h"
 #include "sntp_syncer.h"
@@ -161,6 +161,7 @@ void ui_set_battery_level(int pct);
 void ui_set_dots_bar(lv_obj_t *anchor, uint8_t num_dots, uint8_t selected_dot);
 // static void ensure_lottie_buf(int width, int height);
 static void screen_timer_cb(lv_timer_t *t);
+static void render_stats_log(void);
 static const char* get_mini_language_resource(void);
 
 /* Forward declarations for callbacks */
@@ -1710,22 +1711,14 @@ lv_obj_t *lv_animation_ui(char *animation, int use_animation)
 
     if (use_animation == USE_ANIM_GIF)
     {
-        ESP_LOGI(TAG, "[ * ] [LVGL] lv_animation_ui: gif decode %s", animation);
-        esp_err_t ret = lvgl_load_gif_from_sdcard(animation);
-        if (ret != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to load GIF %s (error: %s), skipping animation",
-                     animation, esp_err_to_name(ret));
+        ESP_LOGI(TAG, "[ * ] [LVGL] lv_animation_ui: gif play %s", animation);
+        // Frames come from the animation frame cache after the first pass
+        lv_obj_t *gif = lv_anim_player_create(animation_ui, animation);
+        if (!gif) {
+            ESP_LOGW(TAG, "Failed to load GIF %s, skipping animation", animation);
             // Return the container without animation - graceful degradation
             return animation_ui;
         }
-        ESP_LOG_BUFFER_HEX(TAG, animation, strlen(animation));
-
-        lv_obj_t *gif = lv_gif_create(animation_ui);
-        if (!lvgl_validate_gif_dsc(lvgl_get_gif())) {
-            ESP_LOGE("GIF", "Refusing to load invalid gif_dsc");
-            return animation_ui;  // Return container without GIF
-        }
-        lv_gif_set_src(gif, lvgl_get_gif());
         lv_obj_center(gif);
     } else
     {
@@ -2294,6 +2287,38 @@ void lv_clock_screen(void)
     ui_add_batt_badge(USE_ANIM_PNG);
 }
 
+/**
+ * @brief Queue background decodes of the covers the next swipe or screen change will need
+ *
+ * Neighbours are the albums s3_albums_next() / s3_albums_prev() would select. On the home
+ * screen the current album's play cover is queued first, for entering the player.
+ */
+static void prefetch_adjacent_covers(bool home)
+{
+    lvgl_prefetch_cancel();
+
+    size_t count = s3_albums_get_size();
+    if (!s3_current_album || count == 0) {
+        return;
+    }
+    if (home) {
+        lvgl_prefetch_jpeg(s3_current_album->play_cover);
+    }
+    if (count < 2) {
+        return;
+    }
+
+    size_t idx = s3_current_idx < count ? s3_current_idx : 0;
+    const s3_album_handler_t *next = s3_albums_get((idx + 1) % count);
+    const s3_album_handler_t *prev = s3_albums_get(idx ? idx - 1 : count - 1);
+    if (next) {
+        lvgl_prefetch_jpeg(home ? next->home_cover : next->play_cover);
+    }
+    if (prev && prev != next) {
+        lvgl_prefetch_jpeg(home ? prev->home_cover : prev->play_cover);
+    }
+}
+
 // Revised - half term
 void lv_home_screen(bool renew)
 {
@@ -2317,18 +2342,16 @@ void lv_home_screen(bool renew)
         bool album_changed = (renew == true ) ? true : ((last_displayed_home_album == NULL ) ? true : strcmp(last_displayed_home_album->home_cover, s3_current_album->home_cover) != 0 );
         if (album_changed) {
             ESP_LOGI(TAG, "[LVGL] lv_home_screen: FULL RECREATION - album changed");
-            esp_err_t ret = lvgl_load_image_from_sdcard(s3_current_album->home_cover);
-            ESP_LOGI(TAG, "[ * ] [LVGL] lv_home_screen: jpg decode %s", s3_current_album->home_cover);
-
+            cover_ui = lv_base_ui(USE_TRANSPARENCY);
+            lv_obj_t *img = lv_img_create(cover_ui);
+            lv_obj_center(img);
+            // A cover not in the cache is decoded by the prefetch worker behind a placeholder
+            esp_err_t ret = lvgl_show_image_async(img, s3_current_album->home_cover);
             if (ret != ESP_OK) {
                 ESP_LOGW(TAG, "Failed to load album cover %s (error: %s), using default",
                          s3_current_album->home_cover, esp_err_to_name(ret));
+                lv_obj_del(img);
                 // Continue with default UI - don't crash
-            } else {
-                cover_ui = lv_base_ui(USE_TRANSPARENCY);
-                lv_obj_t *img = lv_img_create(cover_ui);
-                lv_img_set_src(img, lvgl_get_img());
-                lv_obj_center(img);
             }
         } 
         ESP_LOGI(TAG, "[ * ] [LVGL] lv_home_screen: Update badge");
@@ -2339,6 +2362,11 @@ void lv_home_screen(bool renew)
         ui_add_lang_badge(LANG_HOME);
 
         last_displayed_home_album = s3_current_album;
+        if (album_changed) {
+            prefetch_adjacent_covers(true);
+            img_cache_log_stats();
+            render_stats_log();
+        }
 
     }
     else
@@ -2409,19 +2437,18 @@ void lv_player_screen(bool renew)
 
         if (s3_current_album)
         {
-            esp_err_t ret = lvgl_load_image_from_sdcard(s3_current_album->play_cover);
-            ESP_LOGI(TAG, "[ * ] [LVGL] lv_player_screen: jpg decode %s", s3_current_album->play_cover);
-
+            cover_ui = lv_base_ui(USE_TRANSPARENCY);  // ← This cleans the screen!
+            lv_obj_t *img = lv_img_create(cover_ui);
+            lv_obj_center(img);
+            // A cover not in the cache is decoded by the prefetch worker behind a placeholder
+            esp_err_t ret = lvgl_show_image_async(img, s3_current_album->play_cover);
             if (ret != ESP_OK) {
                 ESP_LOGW(TAG, "Failed to load play cover %s (error: %s), using default",
                          s3_current_album->play_cover, esp_err_to_name(ret));
+                lv_obj_del(img);
                 // Continue with default UI - don't crash
-            } else {
-                cover_ui = lv_base_ui(USE_TRANSPARENCY);  // ← This cleans the screen!
-                lv_obj_t *img = lv_img_create(cover_ui);
-                lv_img_set_src(img, lvgl_get_img());
-                lv_obj_center(img);
             }
+            prefetch_adjacent_covers(false);
         }
         else
         {
@@ -2679,27 +2706,19 @@ void lv_data_sync_screen(void)
         // Reset static GIF object pointer since screen was cleared by lv_animation_ui
         data_sync_gif_obj = NULL;
 
+        // Each stage recreates the screen; the frame cache keeps the GIF decoded across stages
         ESP_LOGI(TAG, "[ * ] [LVGL] lv_data_sync_screen: loading GIF %s", gif_path);
-        esp_err_t ret = lvgl_load_gif_from_sdcard(gif_path);
-        if (ret == ESP_OK) {
-            data_sync_gif_obj = lv_gif_create(local_ui);
-            if (data_sync_gif_obj && lvgl_validate_gif_dsc(lvgl_get_gif())) {
-                lv_gif_set_src(data_sync_gif_obj, lvgl_get_gif());
-                lv_obj_set_pos(data_sync_gif_obj, 169, 127);
-                lv_obj_move_foreground(data_sync_gif_obj);
-
-                // Force LVGL to update display to ensure GIF starts playing
-                lv_refr_now(NULL);
-
-                ESP_LOGI(TAG, "[ * ] [LVGL] lv_data_sync_screen: GIF animation overlayed and started at (169, 127)");
-            } else {
-                ESP_LOGW(TAG, "[ * ] [LVGL] lv_data_sync_screen: Invalid GIF descriptor or failed to create object");
-                data_sync_gif_obj = NULL;
-            }
+        data_sync_gif_obj = lv_anim_player_create(local_ui, gif_path);
+        if (data_sync_gif_obj) {
+            lv_obj_set_pos(data_sync_gif_obj, 169, 127);
+            lv_obj_move_foreground(data_sync_gif_obj);
+
+            // Force LVGL to update display to ensure GIF starts playing
+            lv_refr_now(NULL);
+
+            ESP_LOGI(TAG, "[ * ] [LVGL] lv_data_sync_screen: GIF animation overlayed and started at (169, 127)");
         } else {
-            ESP_LOGW(TAG, "[ * ] [LVGL] lv_data_sync_screen: Failed to load GIF %s (error: %s)",
-                     gif_path, esp_err_to_name(ret));
-            data_sync_gif_obj = NULL;
+            ESP_LOGW(TAG, "[ * ] [LVGL] lv_data_sync_screen: Failed to load GIF %s", gif_path);
         }
     } else {
         // Clear GIF object when showing wait screen
@@ -3213,17 +3232,56 @@ void lv_animation_dummy_screen(void)
     ESP_LOGI(TAG, "Opacity animation: %p", (void*)&opacity_anim);
 }
 
+// Render timing per screen, fed by the display driver's monitor callback (lv_tick resolution)
+static struct {
+    s3_screens_t screen;
+    uint32_t frames;
+    uint32_t total_ms;
+    uint32_t max_ms;
+    uint64_t pixels;
+} render_stats = {.screen = NULL_SCREEN};
+
+/**
+ * @brief Log and reset the render timing of the home, player and data sync screens
+ */
+static void render_stats_log(void)
+{
+    if (render_stats.frames && (render_stats.screen == HOME_SCREEN || render_stats.screen == PLAY_SCREEN ||
+                                render_stats.screen == DATA_SYNC_SCREEN)) {
+        ESP_LOGI(TAG, "[RENDER] %s: %u frames, avg %u ms, max %u ms, %u px/frame",
+                 s3_screen_resources[render_stats.screen].name, (unsigned int)render_stats.frames,
+                 (unsigned int)(render_stats.total_ms / render_stats.frames), (unsigned int)render_stats.max_ms,
+                 (unsigned int)(render_stats.pixels / render_stats.frames));
+    }
+    render_stats.frames = 0;
+    render_stats.total_ms = 0;
+    render_stats.max_ms = 0;
+    render_stats.pixels = 0;
+}
+
+void lvgl_render_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
+{
+    (void)drv;
+    if (render_stats.screen != s3_current_screen) {
+        render_stats_log();
+        render_stats.screen = s3_current_screen;
+    }
+    render_stats.frames++;
+    render_stats.total_ms += time_ms;
+    render_stats.pixels += px;
+    if (time_ms > render_stats.max_ms) {
+        render_stats.max_ms = time_ms;
+    }
+}
+
 // Screen control functions
 lv_timer_t *init_screen_manager(bool use_carroucel)
 {
     // Initialize the GUI mutex first
     gui_mutex_init();
 
-    // Initialize JPEG cache system
-    jpeg_cache_init();
-
-    // Initialize PNG cache system
-    png_cache_init();
+    // Initialize the decoded-image cache (JPEG and PNG)
+    img_cache_init();
 
     gui_lock();
     s3_carroucel = use_carroucel;
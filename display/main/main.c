@@ -29,6 +29,8 @@
 #include "cjson_psram_hooks.h"
 #include "voltage_kalman.h"
 #include "s3_definitions.h" 
+#include "lv_screen_mgr.h"
+#include "s3_content_index.h"
 
 #include "wifi_manager.h"
 #include "ble_manager.h"
@@ -105,6 +107,7 @@ static void lv_port_init_local(esp_lcd_panel_handle_t lcd_handle) {
     disp_drv.hor_res = 240; 
     disp_drv.ver_res = 240;
     disp_drv.flush_cb = lvgl_flush_cb;
+    disp_drv.monitor_cb = lvgl_render_monitor_cb;
     disp_drv.draw_buf = &disp_buf;
     disp_drv.user_data = lcd_handle;
     lv_disp_drv_register(&disp_drv);
@@ -219,6 +222,10 @@ static esp_err_t sgm41513_event_handler(audio_event_iface_msg_t *event, void *co
     if (event->source_type == PERIPH_ID_SGM41513 && event->cmd == PERIPH_SGM41513_PLUGGED_IN) {
         backlight_on();
     }
+    // The card may have been edited elsewhere: the content index revalidates albums on next use
+    if (event->source_type == PERIPH_ID_SDCARD && event->cmd == SDCARD_STATUS_MOUNTED) {
+        s3_content_index_card_changed();
+    }
     return ESP_OK;
 }
 
@@ -11,6 +11,7 @@
 #include <errno.h>
 #include <time.h>
 #include "s3_definitions.h"
+#include "s3_content_index.h"
 #include "audio_player.h"
 #include "s3_nvs_item.h"
 #include "lv_screen_mgr.h"
@@ -496,14 +497,6 @@ static bool s3_album_is_available(const s3_album_handler_t *album)
         return false;
     }
     
-    ESP_LOGI(TAG, "[ALBUM_CHECK] Checking directory: %s", album->path);
-    struct stat st;
-    if (stat(album->path, &st) != 0) {
-        ESP_LOGW(TAG, "[ALBUM_CHECK] FAILED - Album directory missing: %s", album->path);
-        return false;
-    }
-    ESP_LOGI(TAG, "[ALBUM_CHECK] Directory exists: %s", album->path);
-
     // COMMENTED OUT: Resource (jpg/gif/png) checks - only validate MP3 files
     // Check if cover images exist (optional files)
     // if (album->home_cover) {
@@ -524,39 +517,14 @@ static bool s3_album_is_available(const s3_album_handler_t *album)
     //     ESP_LOGI(TAG, "[ALBUM_CHECK] Play cover exists: %s", album->play_cover);
     // }
 
-    // Count MP3 files in the directory
-    ESP_LOGI(TAG, "[ALBUM_CHECK] Counting MP3 files in: %s", album->path);
-    DIR *dir = opendir(album->path);
-    if (!dir) {
-        ESP_LOGW(TAG, "[ALBUM_CHECK] FAILED - Cannot open album directory: %s", album->path);
+    // Count MP3 files from the content index (SKURC headers are checked once per file, then cached)
+    bool is_skurc_album = (album->sku && strncmp(album->sku, "SKURC-", 6) == 0);
+    int mp3_count = s3_content_index_track_count(album->path, is_skurc_album);
+    if (mp3_count < 0) {
+        ESP_LOGW(TAG, "[ALBUM_CHECK] FAILED - Album directory missing: %s", album->path);
         return false;
     }
 
-    int mp3_count = 0;
-    bool is_skurc_album = (album->sku && strncmp(album->sku, "SKURC-", 6) == 0);
-    
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_type == DT_REG && strcasestr(entry->d_name, ".mp3")) {
-            if (is_skurc_album) {
-                // For SKURC albums, validate MP3 header to exclude MP4/AAC files
-                char full_path[300];
-                snprintf(full_path, sizeof(full_path), "%s%s", album->path, entry->d_name);
-                if (is_real_mp3_file(full_path)) {
-                    mp3_count++;
-                    ESP_LOGI(TAG, "[ALBUM_CHECK] Valid MP3 file: %s", entry->d_name);
-                } else {
-                    ESP_LOGW(TAG, "[ALBUM_CHECK] Skipping invalid MP3 file: %s (not a real MP3)", entry->d_name);
-                }
-            } else {
-                // For regular albums, count all .mp3 files
-                mp3_count++;
-                ESP_LOGD(TAG, "[ALBUM_CHECK] Found MP3 file: %s", entry->d_name);
-            }
-        }
-    }
-    closedir(dir);
-    
     ESP_LOGI(TAG, "[ALBUM_CHECK] Found %d valid MP3 files, expected %d", mp3_count, album->files_available);
 
     // Check if we have the expected number of files (if specified)
@@ -1002,6 +970,8 @@ bool s3_albums_dynamic_build(void)
     }
     
     // STEP 2: Parse SKUs from album_data JSON for player availability
+    // new_available_skus points into the account model until the flags below are set
+    account_model_lock();
     get_babyPacks(&albums, &album_count);
     
     // Check bounds and warn if approaching or exceeding limit
@@ -1158,6 +1128,7 @@ bool s3_albums_dynamic_build(void)
             }
         }
     }
+    account_model_unlock();
     
     // STEP 6: Build available albums list based on flags already set by s3_album_mgr_scan_sd_downloads()
     // Note: is_downloaded flags were already validated in s3_album_mgr_load_from_cloud() -> s3_album_mgr_scan_sd_downloads()
@@ -1491,6 +1462,7 @@ esp_err_t s3_album_mgr_load_from_cloud(void) {
     const s3_nfc_t *nfcs = NULL;
     int nfcCount = 0;
     
+    account_model_lock();
     get_babyPacks(&babyPacks, &babyPackCount);
     get_nfcs(&nfcs, &nfcCount);
     
@@ -1628,6 +1600,7 @@ esp_err_t s3_album_mgr_load_from_cloud(void) {
         }
     }
     
+    account_model_unlock();
     ESP_LOGI(TAG, "[S3_DYNAMIC_ALBUMS] Album creation completed: %u total albums", (unsigned int)s3_dynamic_albums_count);
     
     // After creating all albums, scan SD card to update is_downloaded flags
@@ -1669,8 +1642,9 @@ void s3_album_mgr_scan_sd_downloads(void) {
         ESP_LOGD(TAG, "Animation: %s", album->anim);
         
         // Check components for comprehensive download verification
-        struct stat st;
-        bool path_exists = (stat(album->path, &st) == 0 && S_ISDIR(st.st_mode));
+        // MP3 count comes from the content index: -1 means the directory doesn't exist
+        int mp3_count = s3_content_index_track_count(album->path, false);
+        bool path_exists = (mp3_count >= 0);
 
         // COMMENTED OUT: Resource (jpg/gif/png) checks - only validate MP3 files
         // For blankee albums, implement fallback logic for covers
@@ -1718,7 +1692,6 @@ void s3_album_mgr_scan_sd_downloads(void) {
         // bool anim_exists = album->anim[0] ? (stat(album->anim, &st) == 0) : true; // Animation optional for blankee
 
         bool had_downloaded = album->is_downloaded;
-        int mp3_count = 0;
 
         ESP_LOGI(TAG, "[DOWNLOAD_VALIDATION] %s:", album->sku);
         ESP_LOGI(TAG, "  Directory: %s (%s)", album->path, path_exists ? "EXISTS" : "MISSING");
@@ -1727,73 +1700,45 @@ void s3_album_mgr_scan_sd_downloads(void) {
         // ESP_LOGI(TAG, "  Animation: %s (%s)", album->anim, anim_exists ? "EXISTS" : "MISSING");
         
         if (path_exists) {
-            // Directory exists, check if it has MP3 files
-            DIR *dir = opendir(album->path);
-            if (dir) {
-                struct dirent *entry;
-                
-                ESP_LOGD(TAG, "Directory %s opened successfully, checking for MP3 files...", album->path);
-                
-                while ((entry = readdir(dir)) != NULL) {
-                    if (entry->d_type == DT_REG) {
-                        // Check if it's an MP3 file (case insensitive)
-                        size_t name_len = strlen(entry->d_name);
-                        if (name_len > 4) {
-                            const char *ext = &entry->d_name[name_len - 4];
-                            if (strcasecmp(ext, ".mp3") == 0) {
-                                mp3_count++;
-                                ESP_LOGD(TAG, "Found MP3 file: %s", entry->d_name);
-                            }
-                        }
-                    }
-                }
-                closedir(dir);
-                
-                ESP_LOGI(TAG, "  MP3 files: %d found (expected: %d)", mp3_count, album->files_available);
-
-                // Album is considered downloaded if:
-                // 1. Directory exists and has MP3 files
-                // 2. SKIP: Required covers check (commented out)
-                // 3. SKIP: Animation check (commented out)
-                // 4. If files_available is -1, skip file count validation
-                // 5. For SKURC albums, check sync list instead of strict file count
-                bool has_required_mp3s;
-                if (album->files_available == -1) {
-                    // Skip file count validation when count is unknown (-1)
-                    has_required_mp3s = (mp3_count > 0);
-                    ESP_LOGI(TAG, "  File count validation skipped (unknown count: -1), MP3s: %d", mp3_count);
-                } else if (album->sku && strncmp(album->sku, "SKURC-", 6) == 0) {
-                    // SKURC albums: just check if any MP3 files exist (account file determines playlist)
-                    if (mp3_count > 0) {
-                        has_required_mp3s = true;
-                        ESP_LOGI(TAG, "  SKURC album: %d MP3 files found (expected: %d), considering downloaded",
-                                 mp3_count, album->files_available);
-                    } else {
-                        has_required_mp3s = false;
-                        ESP_LOGW(TAG, "  SKURC album: no MP3 files found in directory");
-                    }
+            ESP_LOGI(TAG, "  MP3 files: %d found (expected: %d)", mp3_count, album->files_available);
+
+            // Album is considered downloaded if:
+            // 1. Directory exists and has MP3 files
+            // 2. SKIP: Required covers check (commented out)
+            // 3. SKIP: Animation check (commented out)
+            // 4. If files_available is -1, skip file count validation
+            // 5. For SKURC albums, check sync list instead of strict file count
+            bool has_required_mp3s;
+            if (album->files_available == -1) {
+                // Skip file count validation when count is unknown (-1)
+                has_required_mp3s = (mp3_count > 0);
+                ESP_LOGI(TAG, "  File count validation skipped (unknown count: -1), MP3s: %d", mp3_count);
+            } else if (album->sku && strncmp(album->sku, "SKURC-", 6) == 0) {
+                // SKURC albums: just check if any MP3 files exist (account file determines playlist)
+                if (mp3_count > 0) {
+                    has_required_mp3s = true;
+                    ESP_LOGI(TAG, "  SKURC album: %d MP3 files found (expected: %d), considering downloaded",
+                             mp3_count, album->files_available);
                 } else {
-                    // Normal file count validation for regular albums
-                    has_required_mp3s = (mp3_count > 0) &&
-                        (album->files_available <= 0 || mp3_count >= album->files_available);
-                }
-
-                // SIMPLIFIED: Only require MP3 files (no cover/animation checks)
-                album->is_downloaded = has_required_mp3s;
-                ESP_LOGI(TAG, "  Album result: %s (MP3s: %s)",
-                         album->is_downloaded ? "DOWNLOADED" : "NOT_DOWNLOADED",
-                         has_required_mp3s ? "OK" : "MISSING");
-                
-                if (had_downloaded != album->is_downloaded) {
-                    ESP_LOGI(TAG, "  Status changed: %s -> %s", 
-                             had_downloaded ? "DOWNLOADED" : "NOT_DOWNLOADED", 
-                             album->is_downloaded ? "DOWNLOADED" : "NOT_DOWNLOADED");
+                    has_required_mp3s = false;
+                    ESP_LOGW(TAG, "  SKURC album: no MP3 files found in directory");
                 }
             } else {
-                // Directory exists but can't be opened
-                album->is_downloaded = false;
-                ESP_LOGW(TAG, "  Directory %s exists but cannot be opened: %s", album->path, strerror(errno));
-                ESP_LOGI(TAG, "  Result: NOT_DOWNLOADED (directory access error)");
+                // Normal file count validation for regular albums
+                has_required_mp3s = (mp3_count > 0) &&
+                    (album->files_available <= 0 || mp3_count >= album->files_available);
+            }
+
+            // SIMPLIFIED: Only require MP3 files (no cover/animation checks)
+            album->is_downloaded = has_required_mp3s;
+            ESP_LOGI(TAG, "  Album result: %s (MP3s: %s)",
+                     album->is_downloaded ? "DOWNLOADED" : "NOT_DOWNLOADED",
+                     has_required_mp3s ? "OK" : "MISSING");
+            
+            if (had_downloaded != album->is_downloaded) {
+                ESP_LOGI(TAG, "  Status changed: %s -> %s", 
+                         had_downloaded ? "DOWNLOADED" : "NOT_DOWNLOADED", 
+                         album->is_downloaded ? "DOWNLOADED" : "NOT_DOWNLOADED");
             }
         } else {
             // Directory doesn't exist
@@ -1804,6 +1749,9 @@ void s3_album_mgr_scan_sd_downloads(void) {
         ESP_LOGD(TAG, "=== End check for %s ===\n", album->sku);
     }
     
+    // Persist whatever had to be scanned, so the next boot reads it back instead
+    s3_content_index_flush();
+
     ESP_LOGI(TAG, "SD card scan completed for album is_downloaded flags");
 }
 
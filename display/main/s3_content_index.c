@@ -0,0 +1,845 @@
+/**
+ * @file s3_content_index.c
+ * @brief Persistent index of album folders on the SD card
+ *
+ * Every album folder is scanned at most once (opendir/readdir/stat) and kept in PSRAM,
+ * sorted by file name. The index is saved to CONTENT_INDEX_PATH so the stats and MP3 header
+ * checks don't happen again after a reboot either. Sync and the file server keep it current
+ * file by file.
+ *
+ * The card can be edited elsewhere between mounts, so after each mount (boot or card change)
+ * an album is revalidated on its first use with a readdir-only pass: only names that appeared
+ * are stat'ed, and names that disappeared are dropped. A file replaced under the same name is
+ * caught when it is opened for playback (s3_content_index_file_seen()). Folders that don't exist
+ * are remembered too, until the next mount or a file is written into them.
+ *
+ * On-disk format (little endian, CRC32 over everything after the header):
+ *   header   { magic, version, album_count, crc }
+ *   album    { u8 dir_len, dir[dir_len], u16 track_count }
+ *   track    { u32 size, u8 flags, u8 name_len, name[name_len] }   (track_count times)
+ */
+
+#include "s3_content_index.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "s3_definitions.h"
+#include "s3_logger.h"
+#include "audio_player.h"
+
+#define TAG                     "S3_CONTENT_INDEX"
+
+#define CONTENT_INDEX_MAGIC     0x49433353u  // "S3CI"
+#define CONTENT_INDEX_VERSION   1
+
+#define TRACK_FLAG_CHECKED      (1 << 0)     // MP3 header was inspected
+#define TRACK_FLAG_VALID_MP3    (1 << 1)     // ...and looks like a real MP3
+
+typedef struct {
+    char     *name;             // File name only (PSRAM)
+    uint32_t  size;
+    uint8_t   flags;
+} index_track_t;
+
+typedef struct {
+    char          *dir;         // Album directory with trailing '/' (PSRAM)
+    uint32_t       hash;
+    int            track_count;
+    int            track_cap;
+    index_track_t *tracks;      // Sorted by name (PSRAM)
+    bool           verified;    // Checked against the card since the last mount (not saved)
+    bool           missing;     // Folder doesn't exist (not saved)
+} index_album_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t album_count;
+    uint32_t crc;
+} index_header_t;
+
+static index_album_t *s_albums = NULL;
+static int s_album_count = 0;
+static int s_album_cap = 0;
+static bool s_loaded = false;
+static bool s_dirty = false;
+
+static SemaphoreHandle_t s_mutex = NULL;
+static portMUX_TYPE s_mutex_create_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void index_load(void);
+
+static bool index_lock(void)
+{
+    if (s_mutex == NULL) {
+        SemaphoreHandle_t m = xSemaphoreCreateMutex();
+        portENTER_CRITICAL(&s_mutex_create_lock);
+        if (s_mutex == NULL) {
+            s_mutex = m;
+            m = NULL;
+        }
+        portEXIT_CRITICAL(&s_mutex_create_lock);
+        if (m) {
+            vSemaphoreDelete(m);
+        }
+    }
+    if (s_mutex == NULL || xSemaphoreTake(s_mutex, portMAX_DELAY) != pdTRUE) {
+        return false;
+    }
+    if (!s_loaded) {
+        s_loaded = true;
+        index_load();
+    }
+    return true;
+}
+
+static void index_unlock(void)
+{
+    xSemaphoreGive(s_mutex);
+}
+
+static uint32_t dir_hash(const char *s)
+{
+    uint32_t h = 2166136261u;  // FNV-1a
+    while (*s) {
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+    }
+    return h;
+}
+
+static bool is_mp3_name(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 4 && strcasecmp(name + len - 4, ".mp3") == 0;
+}
+
+/**
+ * @brief Split "/dir/name.mp3" into "/dir/" and "name.mp3"
+ */
+static bool split_path(const char *path, char *dir, size_t dir_size, const char **name)
+{
+    const char *slash = path ? strrchr(path, '/') : NULL;
+    if (slash == NULL || (size_t)(slash - path + 1) >= dir_size) {
+        return false;
+    }
+    memcpy(dir, path, slash - path + 1);
+    dir[slash - path + 1] = '\0';
+    *name = slash + 1;
+    return **name != '\0';
+}
+
+static void album_free(index_album_t *album)
+{
+    for (int i = 0; i < album->track_count; i++) {
+        free(album->tracks[i].name);
+    }
+    heap_caps_free(album->tracks);
+    free(album->dir);
+    memset(album, 0, sizeof(*album));
+}
+
+static index_album_t *album_find(const char *dir)
+{
+    uint32_t h = dir_hash(dir);
+    for (int i = 0; i < s_album_count; i++) {
+        if (s_albums[i].hash == h && strcmp(s_albums[i].dir, dir) == 0) {
+            return &s_albums[i];
+        }
+    }
+    return NULL;
+}
+
+static index_album_t *album_add(const char *dir)
+{
+    if (s_album_count == s_album_cap) {
+        int cap = s_album_cap ? s_album_cap * 2 : 32;
+        index_album_t *grown = heap_caps_realloc(s_albums, cap * sizeof(index_album_t), MALLOC_CAP_SPIRAM);
+        if (grown == NULL) {
+            return NULL;
+        }
+        s_albums = grown;
+        s_album_cap = cap;
+    }
+    index_album_t *album = &s_albums[s_album_count];
+    memset(album, 0, sizeof(*album));
+    album->dir = strdup_spiram(dir);
+    if (album->dir == NULL) {
+        return NULL;
+    }
+    album->hash = dir_hash(dir);
+    s_album_count++;
+    return album;
+}
+
+static void album_remove(index_album_t *album)
+{
+    int idx = album - s_albums;
+    album_free(album);
+    memmove(&s_albums[idx], &s_albums[idx + 1], (s_album_count - idx - 1) * sizeof(index_album_t));
+    s_album_count--;
+}
+
+static bool album_reserve(index_album_t *album, int count)
+{
+    if (count <= album->track_cap) {
+        return true;
+    }
+    int cap = album->track_cap ? album->track_cap : 16;
+    while (cap < count) {
+        cap *= 2;
+    }
+    index_track_t *grown = heap_caps_realloc(album->tracks, cap * sizeof(index_track_t), MALLOC_CAP_SPIRAM);
+    if (grown == NULL) {
+        return false;
+    }
+    album->tracks = grown;
+    album->track_cap = cap;
+    return true;
+}
+
+/**
+ * @brief Binary search by name
+ * @return Index of the track, or -(insert position) - 1 if absent
+ */
+static int track_find(const index_album_t *album, const char *name)
+{
+    int lo = 0;
+    int hi = album->track_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(album->tracks[mid].name, name);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -lo - 1;
+}
+
+static int track_name_cmp(const void *a, const void *b)
+{
+    return strcmp(((const index_track_t *)a)->name, ((const index_track_t *)b)->name);
+}
+
+/**
+ * @brief Read an album folder's MP3 tracks (name and size) into album->tracks, sorted
+ * @return false if the folder doesn't exist
+ */
+static bool album_read_dir(index_album_t *album)
+{
+    DIR *d = opendir(album->dir);
+    if (d == NULL) {
+        return false;
+    }
+
+    struct dirent *entry;
+    char path[320];
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_type != DT_REG || !is_mp3_name(entry->d_name)) {
+            continue;
+        }
+        if (!album_reserve(album, album->track_count + 1)) {
+            ESP_LOGE(TAG, "Out of memory indexing %s", album->dir);
+            break;
+        }
+        index_track_t *t = &album->tracks[album->track_count];
+        memset(t, 0, sizeof(*t));
+        t->name = strdup_spiram(entry->d_name);
+        if (t->name == NULL) {
+            break;
+        }
+        struct stat st;
+        snprintf(path, sizeof(path), "%s%s", album->dir, entry->d_name);
+        if (stat(path, &st) == 0) {
+            t->size = (uint32_t)st.st_size;
+        }
+        album->track_count++;
+    }
+    closedir(d);
+
+    if (album->track_count > 1) {
+        qsort(album->tracks, album->track_count, sizeof(index_track_t), track_name_cmp);
+    }
+    return true;
+}
+
+/**
+ * @brief Scan an album folder once and add it to the index
+ * @return The new entry (marked missing if the folder doesn't exist), or NULL when out of memory
+ */
+static index_album_t *album_scan(const char *dir)
+{
+    int64_t start_us = esp_timer_get_time();
+    index_album_t *album = album_add(dir);
+    if (album == NULL) {
+        ESP_LOGE(TAG, "Out of memory indexing %s", dir);
+        return NULL;
+    }
+
+    album->verified = true;
+    if (!album_read_dir(album)) {
+        album->missing = true;  // Remembered, so absent albums don't cost an opendir on every check
+        ESP_LOGI(TAG, "Indexed %s: folder missing", dir);
+        return album;
+    }
+    s_dirty = true;
+    ESP_LOGI(TAG, "Indexed %s: %d tracks in %lld ms", dir, album->track_count,
+             (esp_timer_get_time() - start_us) / 1000);
+    return album;
+}
+
+/**
+ * @brief Check an album loaded from the index file (or from before a card change) against the card
+ *
+ * Only readdir runs for an unchanged folder; names that appeared are stat'ed and names that
+ * disappeared are dropped. A folder that was missing is scanned in full.
+ */
+static void album_revalidate(index_album_t *album)
+{
+    int64_t start_us = esp_timer_get_time();
+    album->verified = true;
+
+    DIR *d = opendir(album->dir);
+    if (d == NULL) {
+        if (!album->missing) {
+            ESP_LOGW(TAG, "Revalidated %s: folder gone", album->dir);
+            for (int i = 0; i < album->track_count; i++) {
+                free(album->tracks[i].name);
+            }
+            album->track_count = 0;
+            album->missing = true;
+            s_dirty = true;
+        }
+        return;
+    }
+
+    if (album->missing) {
+        closedir(d);
+        album->missing = false;
+        if (album_read_dir(album)) {
+            s_dirty = true;
+            ESP_LOGI(TAG, "Revalidated %s: folder appeared, %d tracks", album->dir, album->track_count);
+        } else {
+            album->missing = true;
+        }
+        return;
+    }
+
+    // Mark the names still present; anything unmarked afterwards was removed
+    bool *seen = album->track_count ? heap_caps_calloc(album->track_count, sizeof(bool), MALLOC_CAP_SPIRAM) : NULL;
+    if (album->track_count && seen == NULL) {
+        closedir(d);
+        album->verified = false;
+        return;
+    }
+
+    int added = 0;
+    int removed = 0;
+    struct dirent *entry;
+    char path[320];
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_type != DT_REG || !is_mp3_name(entry->d_name)) {
+            continue;
+        }
+        int idx = track_find(album, entry->d_name);
+        if (idx >= 0) {
+            if (idx < album->track_count && seen) {
+                seen[idx] = true;
+            }
+            continue;
+        }
+
+        // New file: insert it sorted; it is past every marked entry, so shift the marks with it
+        char *dup = strdup_spiram(entry->d_name);
+        bool *grown_seen = heap_caps_realloc(seen, (album->track_count + 1) * sizeof(bool), MALLOC_CAP_SPIRAM);
+        if (dup == NULL || grown_seen == NULL || !album_reserve(album, album->track_count + 1)) {
+            free(dup);
+            seen = grown_seen ? grown_seen : seen;
+            ESP_LOGE(TAG, "Out of memory revalidating %s", album->dir);
+            album->verified = false;
+            break;
+        }
+        seen = grown_seen;
+        idx = -idx - 1;
+        memmove(&album->tracks[idx + 1], &album->tracks[idx], (album->track_count - idx) * sizeof(index_track_t));
+        memmove(&seen[idx + 1], &seen[idx], (album->track_count - idx) * sizeof(bool));
+        memset(&album->tracks[idx], 0, sizeof(index_track_t));
+        album->tracks[idx].name = dup;
+        snprintf(path, sizeof(path), "%s%s", album->dir, dup);
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            album->tracks[idx].size = (uint32_t)st.st_size;
+        }
+        seen[idx] = true;
+        album->track_count++;
+        added++;
+    }
+    closedir(d);
+
+    if (album->verified && seen) {
+        int out = 0;
+        for (int i = 0; i < album->track_count; i++) {
+            if (seen[i]) {
+                album->tracks[out++] = album->tracks[i];
+            } else {
+                free(album->tracks[i].name);
+                removed++;
+            }
+        }
+        album->track_count = out;
+    }
+    heap_caps_free(seen);
+
+    if (added || removed) {
+        s_dirty = true;
+        ESP_LOGI(TAG, "Revalidated %s: +%d -%d tracks in %lld ms", album->dir, added, removed,
+                 (esp_timer_get_time() - start_us) / 1000);
+    } else {
+        ESP_LOGD(TAG, "Revalidated %s: unchanged", album->dir);
+    }
+}
+
+/**
+ * @brief Look up an album, scanning its folder on first use and revalidating it once per mount
+ * @return The entry, or NULL if the folder doesn't exist
+ */
+static index_album_t *album_get(const char *dir)
+{
+    index_album_t *album = album_find(dir);
+    if (album == NULL) {
+        album = album_scan(dir);
+    } else if (!album->verified) {
+        album_revalidate(album);
+    }
+    return (album && !album->missing) ? album : NULL;
+}
+
+/**
+ * @brief Inspect the MP3 header once per file and remember the result
+ */
+static bool track_is_valid_mp3(const index_album_t *album, index_track_t *t)
+{
+    if (!(t->flags & TRACK_FLAG_CHECKED)) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s%s", album->dir, t->name);
+        t->flags = TRACK_FLAG_CHECKED | (is_real_mp3_file(path) ? TRACK_FLAG_VALID_MP3 : 0);
+        s_dirty = true;
+    }
+    return (t->flags & TRACK_FLAG_VALID_MP3) != 0;
+}
+
+static void index_clear(void)
+{
+    for (int i = 0; i < s_album_count; i++) {
+        album_free(&s_albums[i]);
+    }
+    s_album_count = 0;
+}
+
+/* === Serialization === */
+
+typedef struct {
+    uint8_t *buf;
+    size_t   len;
+    size_t   cap;
+    bool     failed;
+} out_buf_t;
+
+static void out_put(out_buf_t *o, const void *data, size_t len)
+{
+    if (o->failed) {
+        return;
+    }
+    if (o->len + len > o->cap) {
+        size_t cap = o->cap ? o->cap * 2 : 16 * 1024;
+        while (cap < o->len + len) {
+            cap *= 2;
+        }
+        uint8_t *grown = heap_caps_realloc(o->buf, cap, MALLOC_CAP_SPIRAM);
+        if (grown == NULL) {
+            o->failed = true;
+            return;
+        }
+        o->buf = grown;
+        o->cap = cap;
+    }
+    memcpy(o->buf + o->len, data, len);
+    o->len += len;
+}
+
+static bool in_get(const uint8_t **p, const uint8_t *end, void *out, size_t len)
+{
+    if ((size_t)(end - *p) < len) {
+        return false;
+    }
+    memcpy(out, *p, len);
+    *p += len;
+    return true;
+}
+
+static char *in_get_str(const uint8_t **p, const uint8_t *end, size_t len)
+{
+    if ((size_t)(end - *p) < len) {
+        return NULL;
+    }
+    char *s = heap_caps_malloc(len + 1, MALLOC_CAP_SPIRAM);
+    if (s) {
+        memcpy(s, *p, len);
+        s[len] = '\0';
+    }
+    *p += len;
+    return s;
+}
+
+static void index_load(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    char *data = NULL;
+    long size = 0;
+
+    FILE *f = s3_fopen(CONTENT_INDEX_PATH, "rb");
+    if (f == NULL) {
+        ESP_LOGI(TAG, "No content index yet - album folders are indexed on first use");
+        return;
+    }
+    if (s3_fseek(f, 0, SEEK_END) == 0) {
+        size = ftell(f);
+        s3_fseek(f, 0, SEEK_SET);
+    }
+    if (size > (long)sizeof(index_header_t)) {
+        data = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (data && s3_fread(data, 1, size, f) != (size_t)size) {
+            heap_caps_free(data);
+            data = NULL;
+        }
+    }
+    s3_fclose(f);
+    if (data == NULL) {
+        ESP_LOGW(TAG, "Content index unreadable - rebuilding on demand");
+        return;
+    }
+
+    index_header_t hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    const uint8_t *p = (const uint8_t *)data + sizeof(hdr);
+    const uint8_t *end = (const uint8_t *)data + size;
+    if (hdr.magic != CONTENT_INDEX_MAGIC || hdr.version != CONTENT_INDEX_VERSION ||
+        esp_rom_crc32_le(0, p, end - p) != hdr.crc) {
+        ESP_LOGW(TAG, "Content index stale or corrupt - rebuilding on demand");
+        heap_caps_free(data);
+        return;
+    }
+
+    bool ok = true;
+    for (uint32_t a = 0; a < hdr.album_count && ok; a++) {
+        uint8_t dir_len;
+        uint16_t track_count;
+        char *dir = NULL;
+        ok = in_get(&p, end, &dir_len, 1) && (dir = in_get_str(&p, end, dir_len)) != NULL &&
+             in_get(&p, end, &track_count, 2);
+        index_album_t *album = ok ? album_add(dir) : NULL;
+        free(dir);
+        if (album == NULL || !album_reserve(album, track_count)) {
+            ok = false;
+            break;
+        }
+        for (int i = 0; i < track_count && ok; i++) {
+            index_track_t *t = &album->tracks[i];
+            uint8_t name_len;
+            memset(t, 0, sizeof(*t));
+            ok = in_get(&p, end, &t->size, 4) && in_get(&p, end, &t->flags, 1) &&
+                 in_get(&p, end, &name_len, 1) && (t->name = in_get_str(&p, end, name_len)) != NULL;
+            if (ok) {
+                album->track_count++;
+            }
+        }
+    }
+    heap_caps_free(data);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Content index truncated - rebuilding on demand");
+        index_clear();
+        return;
+    }
+    ESP_LOGI(TAG, "Loaded content index: %d albums in %lld ms", s_album_count,
+             (esp_timer_get_time() - start_us) / 1000);
+}
+
+static esp_err_t index_save(void)
+{
+    out_buf_t o = {0};
+    index_header_t hdr = {
+        .magic = CONTENT_INDEX_MAGIC,
+        .version = CONTENT_INDEX_VERSION,
+    };
+    out_put(&o, &hdr, sizeof(hdr));
+    for (int a = 0; a < s_album_count; a++) {
+        const index_album_t *album = &s_albums[a];
+        if (album->missing) {
+            continue;  // Only valid until the next mount
+        }
+        hdr.album_count++;
+        uint8_t dir_len = (uint8_t)strnlen(album->dir, 255);
+        uint16_t track_count = (uint16_t)album->track_count;
+        out_put(&o, &dir_len, 1);
+        out_put(&o, album->dir, dir_len);
+        out_put(&o, &track_count, 2);
+        for (int i = 0; i < track_count; i++) {
+            const index_track_t *t = &album->tracks[i];
+            uint8_t name_len = (uint8_t)strnlen(t->name, 255);
+            out_put(&o, &t->size, 4);
+            out_put(&o, &t->flags, 1);
+            out_put(&o, &name_len, 1);
+            out_put(&o, t->name, name_len);
+        }
+    }
+    if (o.failed) {
+        heap_caps_free(o.buf);
+        return ESP_ERR_NO_MEM;
+    }
+    hdr.crc = esp_rom_crc32_le(0, o.buf + sizeof(hdr), o.len - sizeof(hdr));
+    memcpy(o.buf, &hdr, sizeof(hdr));
+
+    // Write next to the old index and swap, so a power cut never leaves a half-written one
+    esp_err_t ret = ESP_FAIL;
+    FILE *f = s3_fopen(CONTENT_INDEX_PATH ".tmp", "wb");
+    if (f) {
+        size_t written = s3_fwrite(o.buf, 1, o.len, f);
+        s3_fclose(f);
+        if (written == o.len) {
+            s3_remove(CONTENT_INDEX_PATH);
+            if (s3_rename(CONTENT_INDEX_PATH ".tmp", CONTENT_INDEX_PATH) == 0) {
+                ret = ESP_OK;
+            }
+        }
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Saved content index: %u albums, %u bytes", (unsigned int)hdr.album_count, (unsigned int)o.len);
+    } else {
+        ESP_LOGE(TAG, "Failed to save content index");
+    }
+    heap_caps_free(o.buf);
+    return ret;
+}
+
+/* === Public API === */
+
+int s3_content_index_track_count(const char *album_dir, bool verify_mp3)
+{
+    if (album_dir == NULL || !index_lock()) {
+        return -1;
+    }
+    int count = -1;
+    index_album_t *album = album_get(album_dir);
+    if (album) {
+        count = 0;
+        for (int i = 0; i < album->track_count; i++) {
+            if (!verify_mp3 || track_is_valid_mp3(album, &album->tracks[i])) {
+                count++;
+            }
+        }
+    }
+    index_unlock();
+    return count;
+}
+
+int s3_content_index_get_tracks(const char *album_dir, bool verify_mp3, char ***out_paths)
+{
+    if (album_dir == NULL || out_paths == NULL || !index_lock()) {
+        return -1;
+    }
+    *out_paths = NULL;
+
+    index_album_t *album = album_get(album_dir);
+    if (album == NULL) {
+        index_unlock();
+        return -1;
+    }
+
+    int count = 0;
+    char **paths = album->track_count ? malloc(album->track_count * sizeof(char *)) : NULL;
+    if (paths) {
+        char path[320];
+        for (int i = 0; i < album->track_count; i++) {
+            index_track_t *t = &album->tracks[i];
+            if (verify_mp3 && !track_is_valid_mp3(album, t)) {
+                continue;
+            }
+            snprintf(path, sizeof(path), "%s%s", album->dir, t->name);
+            paths[count] = strdup_spiram(path);
+            if (paths[count]) {
+                count++;
+            }
+        }
+    }
+    index_unlock();
+
+    if (count == 0) {
+        free(paths);
+        paths = NULL;
+    }
+    *out_paths = paths;
+    return count;
+}
+
+bool s3_content_index_has_track(const char *path, bool verify_mp3)
+{
+    char dir[256];
+    const char *name;
+    if (!split_path(path, dir, sizeof(dir), &name) || !index_lock()) {
+        return false;
+    }
+    bool found = false;
+    index_album_t *album = album_get(dir);
+    if (album) {
+        int idx = track_find(album, name);
+        found = idx >= 0 && (!verify_mp3 || track_is_valid_mp3(album, &album->tracks[idx]));
+    }
+    index_unlock();
+    return found;
+}
+
+void s3_content_index_file_updated(const char *path)
+{
+    char dir[256];
+    const char *name;
+    if (!split_path(path, dir, sizeof(dir), &name) || !is_mp3_name(name) || !index_lock()) {
+        return;
+    }
+
+    // Folders not indexed yet are scanned complete on first use, nothing to patch
+    index_album_t *album = album_find(dir);
+    if (album && album->missing) {
+        album_remove(album);  // Folder exists now: rescan it on next use
+        album = NULL;
+    }
+    struct stat st;
+    if (album && stat(path, &st) == 0) {
+        int idx = track_find(album, name);
+        if (idx < 0) {
+            char *dup = strdup_spiram(name);
+            if (dup == NULL || !album_reserve(album, album->track_count + 1)) {
+                // Can't patch the entry: drop it so the folder is rescanned
+                free(dup);
+                album_remove(album);
+                album = NULL;
+            } else {
+                idx = -idx - 1;
+                memmove(&album->tracks[idx + 1], &album->tracks[idx],
+                        (album->track_count - idx) * sizeof(index_track_t));
+                album->tracks[idx].name = dup;
+                album->track_count++;
+            }
+        }
+        if (album) {
+            album->tracks[idx].size = (uint32_t)st.st_size;
+            album->tracks[idx].flags = 0;  // Content changed: check the header again
+        }
+        s_dirty = true;
+        ESP_LOGD(TAG, "Updated %s", path);
+    }
+    index_unlock();
+}
+
+void s3_content_index_file_removed(const char *path)
+{
+    char dir[256];
+    const char *name;
+    if (!split_path(path, dir, sizeof(dir), &name) || !index_lock()) {
+        return;
+    }
+    index_album_t *album = album_find(dir);
+    if (album) {
+        int idx = track_find(album, name);
+        if (idx >= 0) {
+            free(album->tracks[idx].name);
+            memmove(&album->tracks[idx], &album->tracks[idx + 1],
+                    (album->track_count - idx - 1) * sizeof(index_track_t));
+            album->track_count--;
+            s_dirty = true;
+            ESP_LOGD(TAG, "Removed %s", path);
+        }
+    }
+    index_unlock();
+}
+
+void s3_content_index_file_seen(const char *path, uint32_t size)
+{
+    char dir[256];
+    const char *name;
+    if (!split_path(path, dir, sizeof(dir), &name) || !is_mp3_name(name) || !index_lock()) {
+        return;
+    }
+    index_album_t *album = album_find(dir);
+    int idx = (album && !album->missing) ? track_find(album, name) : -1;
+    if (idx >= 0 && album->tracks[idx].size != size) {
+        ESP_LOGI(TAG, "%s changed outside sync (%u -> %u bytes)", path,
+                 (unsigned int)album->tracks[idx].size, (unsigned int)size);
+        album->tracks[idx].size = size;
+        album->tracks[idx].flags = 0;  // Check the header again
+        s_dirty = true;
+    }
+    index_unlock();
+}
+
+void s3_content_index_card_changed(void)
+{
+    // Nothing loaded yet: whatever is loaded later starts unverified anyway
+    if (!s_loaded || !index_lock()) {
+        return;
+    }
+    for (int i = 0; i < s_album_count; i++) {
+        s_albums[i].verified = false;
+    }
+    ESP_LOGI(TAG, "Card (re)mounted - %d albums will be revalidated on next use", s_album_count);
+    index_unlock();
+}
+
+void s3_content_index_invalidate(const char *album_dir)
+{
+    if (!index_lock()) {
+        return;
+    }
+    if (album_dir == NULL) {
+        index_clear();
+        s_dirty = true;
+        ESP_LOGI(TAG, "Content index cleared");
+    } else {
+        index_album_t *album = album_find(album_dir);
+        if (album) {
+            album_remove(album);
+            s_dirty = true;
+            ESP_LOGI(TAG, "Content index entry dropped: %s", album_dir);
+        }
+    }
+    index_unlock();
+}
+
+esp_err_t s3_content_index_flush(void)
+{
+    if (!index_lock()) {
+        return ESP_FAIL;
+    }
+    esp_err_t ret = ESP_OK;
+    if (s_dirty) {
+        ret = index_save();
+        if (ret == ESP_OK) {
+            s_dirty = false;
+        }
+    }
+    index_unlock();
+    return ret;
+}
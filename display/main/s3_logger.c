@@ -8,213 +8,291 @@
 
 #if USE_S3_LOGGER
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "s3_definitions.h"
 
 static const char *TAG = "S3_LOGGER";
 static TaskHandle_t logger_task_handle = NULL;
-static bool logger_initialized = false;
-static volatile uint32_t vprintf_call_count = 0;
-static const char *log_file_path = "/sdcard/esp32.log";
-
-// Circular buffer configuration
-#define LOG_BUFFER_SIZE (16 * 1024)  // 16KB circular buffer
-#define FLUSH_WHEN_FULL 1            // Only flush when buffer is full
-
-static char log_buffer[LOG_BUFFER_SIZE];
-static volatile size_t write_pos = 0;
-static volatile size_t read_pos = 0;
-static SemaphoreHandle_t buffer_mutex = NULL;
-static volatile bool flush_requested = false;
-
-// Helper function to get available space in circular buffer
-static size_t get_available_space(void) {
-    size_t w = write_pos;
-    size_t r = read_pos;
-    if (w >= r) {
-        return LOG_BUFFER_SIZE - (w - r) - 1; // Keep 1 byte gap to distinguish full from empty
-    } else {
-        return r - w - 1;
-    }
+static volatile bool logger_initialized = false;
+static volatile bool logger_stop_requested = false;
+static atomic_uint vprintf_call_count = 0;
+static char log_file_path[64] = "/sdcard/esp32.log";
+
+// Lock-free multi-producer ring: producers reserve space with a CAS on ring_head, copy their
+// line, then publish it by setting the COMMITTED bit in the record header. Only the logger
+// task advances ring_tail. Producers never wait: if the ring is full the line is dropped and counted.
+#define LOG_RING_SIZE       (16 * 1024)     // Must be a power of two
+#define LOG_RING_MASK       (LOG_RING_SIZE - 1)
+#define LOG_LINE_MAX        256             // Longer lines are cut and counted as truncated
+#define LOG_STAGE_SIZE      (4 * 1024)      // Logger task copies the ring out in chunks this big
+#define LOG_FLUSH_INTERVAL_MS   2000
+#define LOG_ROTATE_SIZE     (1024 * 1024)   // Rotate esp32.log at 1 MB ...
+#define LOG_ROTATE_KEEP     3               // ... keeping esp32.log.1 .. esp32.log.3
+
+#define REC_HDR_SIZE        4
+#define REC_COMMITTED       0x80000000u
+#define REC_PADDING         0x40000000u
+#define REC_LEN_MASK        0x0000FFFFu
+#define REC_ALIGN(n)        (((n) + 3u) & ~3u)
+
+static uint8_t log_ring[LOG_RING_SIZE] __attribute__((aligned(4)));
+static atomic_uint ring_head = 0;   // Monotonic byte counters, masked on access
+static atomic_uint ring_tail = 0;
+static char log_stage[LOG_STAGE_SIZE];
+
+static atomic_uint dropped_lines = 0;
+static atomic_uint truncated_lines = 0;
+static uint32_t reported_dropped = 0;
+static uint32_t reported_truncated = 0;
+static uint32_t bytes_written = 0;
+static uint32_t rotations = 0;
+
+static FILE *log_file = NULL;
+static size_t log_file_size = 0;
+
+static inline uint32_t *ring_header(uint32_t pos) {
+    return (uint32_t *)&log_ring[pos & LOG_RING_MASK];
 }
 
-// Helper function to get used space in circular buffer
-static size_t get_used_space(void) {
-    size_t w = write_pos;
-    size_t r = read_pos;
-    if (w >= r) {
-        return w - r;
-    } else {
-        return LOG_BUFFER_SIZE - (r - w);
+/**
+ * @brief Append one line to the ring without blocking
+ * @return false if the ring had no room and the line was dropped
+ */
+static bool ring_append(const char *data, size_t len) {
+    uint32_t need = REC_ALIGN(REC_HDR_SIZE + len);
+    uint32_t head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    uint32_t pad;
+
+    for (;;) {
+        uint32_t room_to_end = LOG_RING_SIZE - (head & LOG_RING_MASK);
+        pad = (room_to_end < need) ? room_to_end : 0;    // Records never straddle the end
+        uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+        if (head + pad + need - tail > LOG_RING_SIZE) {
+            atomic_fetch_add_explicit(&dropped_lines, 1, memory_order_relaxed);
+            return false;
+        }
+        if (atomic_compare_exchange_weak_explicit(&ring_head, &head, head + pad + need,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+            break;
+        }
     }
-}
 
-// Fast, non-blocking function to add data to circular buffer
-static void add_to_buffer(const char *data, size_t len) {
-    if (!buffer_mutex || !data || len == 0) return;
-    
-    // Take mutex with short timeout to avoid blocking calling task
-    if (xSemaphoreTake(buffer_mutex, pdMS_TO_TICKS(5)) != pdTRUE) {
-        return; // Skip this log if we can't get mutex quickly
+    if (pad) {
+        __atomic_store_n(ring_header(head), REC_COMMITTED | REC_PADDING | pad, __ATOMIC_RELEASE);
+        head += pad;
     }
-    
-    size_t available = get_available_space();
-    if (len > available) {
-        // If not enough space, advance read pointer to make room (drop old data)
-        size_t need_to_drop = len - available;
-        read_pos = (read_pos + need_to_drop) % LOG_BUFFER_SIZE;
+    uint32_t *hdr = ring_header(head);
+    memcpy(hdr + 1, data, len);
+    __atomic_store_n(hdr, REC_COMMITTED | (uint32_t)len, __ATOMIC_RELEASE);
+
+    // Wake the logger task once per crossing of the half-full mark
+    uint32_t used = head + need - atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    if (used >= LOG_RING_SIZE / 2 && used - need < LOG_RING_SIZE / 2 && logger_task_handle) {
+        xTaskNotifyGive(logger_task_handle);
     }
-    
-    // Add data to circular buffer
-    size_t w = write_pos;
-    for (size_t i = 0; i < len; i++) {
-        log_buffer[w] = data[i];
-        w = (w + 1) % LOG_BUFFER_SIZE;
-    }
-    write_pos = w;
-    
-    // Request flush ONLY when buffer is completely full
-    if (get_available_space() == 0) {
-        flush_requested = true;
-    }
-    
-    xSemaphoreGive(buffer_mutex);
+    return true;
 }
 
-// Async logging vprintf hook - runs in caller's task context
+// Async logging vprintf hook - runs in caller's task context and never blocks
 int s3_log_vprintf(const char *fmt, va_list args) {
-    // Increment call counter to track hook usage
-    vprintf_call_count++;
-    
+    atomic_fetch_add_explicit(&vprintf_call_count, 1, memory_order_relaxed);
+
     // Always print to UART first (immediate feedback)
+    va_list args_copy;
+    va_copy(args_copy, args);
     int ret = vprintf(fmt, args);
-    
-    // If logger not ready, just return
-    if (!logger_initialized || !buffer_mutex) {
+
+    if (!logger_initialized) {
+        va_end(args_copy);
         return ret;
     }
-    
-    // Format the log message into a temporary buffer
-    // Use a very small buffer to minimize stack usage
-    char temp_buffer[128]; // Reduced to 128 bytes to minimize stack impact
-    
-    // Get timestamp
+
+    char line[LOG_LINE_MAX];
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    
-    // Format timestamp + message (reuse va_list by creating temp copy)
-    va_list args_copy;
-    va_copy(args_copy, args);
-    
-    int timestamp_len = snprintf(temp_buffer, sizeof(temp_buffer), "[%ld.%03ld] ", 
-                                tv.tv_sec, tv.tv_usec / 1000);
-    
-    if (timestamp_len > 0 && timestamp_len < sizeof(temp_buffer)) {
-        int msg_len = vsnprintf(temp_buffer + timestamp_len, 
-                               sizeof(temp_buffer) - timestamp_len, fmt, args_copy);
-        
-        if (msg_len > 0) {
-            int total_len = timestamp_len + msg_len;
-            if (total_len < sizeof(temp_buffer)) {
-                // Add to circular buffer (non-blocking)
-                add_to_buffer(temp_buffer, total_len);
-            }
+    int len = snprintf(line, sizeof(line), "[%ld.%03ld] ", (long)tv.tv_sec, (long)(tv.tv_usec / 1000));
+    int msg_len = vsnprintf(line + len, sizeof(line) - len, fmt, args_copy);
+    va_end(args_copy);
+
+    if (msg_len > 0) {
+        len += msg_len;
+        if (len >= (int)sizeof(line)) {
+            // Keep what fits and mark the cut so the file still reads line by line
+            static const char marker[] = "...\n";
+            len = sizeof(line) - 1;
+            memcpy(line + len - (sizeof(marker) - 1), marker, sizeof(marker) - 1);
+            atomic_fetch_add_explicit(&truncated_lines, 1, memory_order_relaxed);
         }
+        ring_append(line, len);
     }
-    
-    va_end(args_copy);
     return ret;
 }
 
-// Logger task - handles actual file I/O ONLY when buffer is full
-static void logger_task(void *pvParameters) {
-    printf("[S3_LOGGER] Logger task started! Will only write when buffer is full.\n");
-    
-    while (1) {
-        // Check if we should flush (ONLY when buffer is full or manually requested)
-        if (xSemaphoreTake(buffer_mutex, pdMS_TO_TICKS(500)) == pdTRUE) {
-            size_t used = get_used_space();
-            
-            // Only flush when explicitly requested (buffer full) 
-            if (flush_requested && used > 0) {
-                printf("[S3_LOGGER] Buffer full! Writing %u bytes to SD card\n", (unsigned int)used);
-                
-                // Open file, write all buffered data, close file
-                FILE *log_file = fopen(log_file_path, "a");
-                if (!log_file) {
-                    printf("[S3_LOGGER] ERROR: Failed to open log file: %s\n", log_file_path);
-                } else {
-                    size_t r = read_pos;
-                    size_t to_write = used;
-                    size_t total_written = 0;
-                    
-                    // Write all data from circular buffer (handle wrap-around)
-                    while (to_write > 0) {
-                        size_t chunk_size = (r + to_write <= LOG_BUFFER_SIZE) ? 
-                                           to_write : (LOG_BUFFER_SIZE - r);
-                        
-                        size_t written = fwrite(&log_buffer[r], 1, chunk_size, log_file);
-                        total_written += written;
-                        
-                        if (written != chunk_size) {
-                            printf("[S3_LOGGER] ERROR: Failed to write chunk (wrote %u/%u bytes)\n", (unsigned int)written, (unsigned int)chunk_size);
-                            break;
-                        }
-                        
-                        r = (r + chunk_size) % LOG_BUFFER_SIZE;
-                        to_write -= chunk_size;
-                    }
-                    
-                    // Force write to disk and close file
-                    fflush(log_file);
-                    fclose(log_file);
-                    
-                    // Clear buffer - reset positions
-                    read_pos = 0;
-                    write_pos = 0;
-                    
-                    printf("[S3_LOGGER] Successfully wrote %u bytes to SD card and cleared buffer\n", (unsigned int)total_written);
-                }
-                
-                flush_requested = false;
+static void logger_sd_lock(void) {
+    if (g_sdcard_dma_mutex) xSemaphoreTake(g_sdcard_dma_mutex, portMAX_DELAY);
+}
+
+static void logger_sd_unlock(void) {
+    if (g_sdcard_dma_mutex) xSemaphoreGive(g_sdcard_dma_mutex);
+}
+
+static void logger_close_file(void) {
+    if (log_file) {
+        logger_sd_lock();
+        fclose(log_file);
+        logger_sd_unlock();
+        log_file = NULL;
+    }
+}
+
+// esp32.log -> esp32.log.1 -> ... -> esp32.log.LOG_ROTATE_KEEP (oldest is deleted)
+static void logger_rotate(void) {
+    char from[72];
+    char to[72];
+
+    logger_close_file();
+    logger_sd_lock();
+    snprintf(to, sizeof(to), "%s.%d", log_file_path, LOG_ROTATE_KEEP);
+    remove(to);
+    for (int i = LOG_ROTATE_KEEP - 1; i >= 1; i--) {
+        snprintf(from, sizeof(from), "%s.%d", log_file_path, i);
+        snprintf(to, sizeof(to), "%s.%d", log_file_path, i + 1);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", log_file_path);
+    rename(log_file_path, to);
+    logger_sd_unlock();
+
+    log_file_size = 0;
+    rotations++;
+    printf("[S3_LOGGER] Rotated %s (%u rotations)\n", log_file_path, (unsigned int)rotations);
+}
+
+// Write one staged chunk to the log file, opening it on first use and rotating by size
+static void logger_write(const char *data, size_t len) {
+    if (!log_file) {
+        struct stat st;
+        logger_sd_lock();
+        log_file_size = (stat(log_file_path, &st) == 0) ? (size_t)st.st_size : 0;
+        log_file = fopen(log_file_path, "a");
+        logger_sd_unlock();
+        if (!log_file) {
+            printf("[S3_LOGGER] ERROR: Failed to open log file: %s\n", log_file_path);
+            return;
+        }
+    }
+
+    logger_sd_lock();
+    size_t written = fwrite(data, 1, len, log_file);
+    fflush(log_file);
+    fsync(fileno(log_file));
+    logger_sd_unlock();
+
+    log_file_size += written;
+    bytes_written += written;
+    if (written != len) {
+        printf("[S3_LOGGER] ERROR: Failed to write log chunk (wrote %u/%u bytes)\n", (unsigned int)written, (unsigned int)len);
+        logger_close_file();    // Reopen on the next chunk
+        return;
+    }
+    if (log_file_size >= LOG_ROTATE_SIZE) {
+        logger_rotate();
+    }
+}
+
+// Move every committed record out of the ring and write it in LOG_STAGE_SIZE chunks
+static void logger_drain(void) {
+    size_t staged = 0;
+
+    for (;;) {
+        uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&ring_head, memory_order_acquire)) {
+            break;
+        }
+        uint32_t *hdr = ring_header(tail);
+        uint32_t h = __atomic_load_n(hdr, __ATOMIC_ACQUIRE);
+        if (!(h & REC_COMMITTED)) {
+            break;      // Producer is still copying; pick it up next round
+        }
+
+        uint32_t len = h & REC_LEN_MASK;
+        uint32_t step = len;
+        if (!(h & REC_PADDING)) {
+            if (staged + len > LOG_STAGE_SIZE) {
+                logger_write(log_stage, staged);
+                staged = 0;
             }
-            
-            xSemaphoreGive(buffer_mutex);
+            memcpy(log_stage + staged, hdr + 1, len);
+            staged += len;
+            step = REC_ALIGN(REC_HDR_SIZE + len);
         }
-        
-        // Sleep longer since we only work when buffer is full
-        vTaskDelay(pdMS_TO_TICKS(500));
+        // Free space must read as zero: a later header may land on old payload bytes
+        memset(hdr, 0, step);
+        atomic_store_explicit(&ring_tail, tail + step, memory_order_release);
+    }
+
+    // Note losses in the file itself so gaps are explained when reading it later
+    uint32_t dropped = atomic_load_explicit(&dropped_lines, memory_order_relaxed);
+    uint32_t truncated = atomic_load_explicit(&truncated_lines, memory_order_relaxed);
+    if (dropped != reported_dropped || truncated != reported_truncated) {
+        if (staged + 96 > LOG_STAGE_SIZE) {
+            logger_write(log_stage, staged);
+            staged = 0;
+        }
+        staged += snprintf(log_stage + staged, LOG_STAGE_SIZE - staged,
+                           "[S3_LOGGER] %u lines dropped, %u truncated since boot\n",
+                           (unsigned int)dropped, (unsigned int)truncated);
+        reported_dropped = dropped;
+        reported_truncated = truncated;
+    }
+
+    if (staged > 0) {
+        logger_write(log_stage, staged);
     }
 }
 
-esp_err_t s3_logger_init(const char *log_file_path) {
+// Logger task - the only writer of the log file
+static void logger_task(void *pvParameters) {
+    printf("[S3_LOGGER] Logger task started\n");
+
+    while (!logger_stop_requested) {
+        // Woken early when the ring is half full or a flush is requested
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_FLUSH_INTERVAL_MS));
+        logger_drain();
+    }
+
+    logger_drain();
+    logger_close_file();
+    logger_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t s3_logger_init(const char *path) {
     if (logger_initialized) {
         ESP_LOGW(TAG, "Logger already initialized");
         return ESP_OK;
     }
 
-    printf("[S3_LOGGER] Initializing async logger with circular buffer\n");
-    printf("[S3_LOGGER] Buffer size: %d bytes - flushes when full\n", LOG_BUFFER_SIZE);
-    
-    // Create mutex for buffer access
-    buffer_mutex = xSemaphoreCreateMutex();
-    if (!buffer_mutex) {
-        printf("[S3_LOGGER] Failed to create buffer mutex\n");
-        return ESP_FAIL;
+    if (path) {
+        strlcpy(log_file_path, path, sizeof(log_file_path));
     }
-    
+    printf("[S3_LOGGER] Initializing lock-free logger: %d byte ring, rotate at %d bytes, keep %d\n",
+           LOG_RING_SIZE, LOG_ROTATE_SIZE, LOG_ROTATE_KEEP);
     printf("[S3_LOGGER] Log file path: %s\n", log_file_path);
-    
-    // Initialize circular buffer
-    write_pos = 0;
-    read_pos = 0;
-    flush_requested = false;
-    
+
+    atomic_store(&ring_head, 0);
+    atomic_store(&ring_tail, 0);
+    memset(log_ring, 0, sizeof(log_ring));
+    logger_stop_requested = false;
+
     // Create logger task with adequate stack
     BaseType_t task_created = xTaskCreate(
         logger_task,
@@ -224,65 +302,77 @@ esp_err_t s3_logger_init(const char *log_file_path) {
         1,     // Lower priority to not interfere with other tasks
         &logger_task_handle
     );
-    
-    if (task_created == pdPASS) {
-        printf("[S3_LOGGER] Logger task created successfully\n");
-    } else {
+
+    if (task_created != pdPASS) {
         printf("[S3_LOGGER] Logger task creation failed\n");
-        vSemaphoreDelete(buffer_mutex);
-        buffer_mutex = NULL;
+        logger_task_handle = NULL;
         return ESP_FAIL;
     }
-    
+
+    // Mark the start of the logging session
+    char marker[96];
+    time_t now = time(NULL);
+    struct tm *local_time = localtime(&now);
+    int len = snprintf(marker, sizeof(marker), "\n=== S3_LOGGER SESSION START: %04d-%02d-%02d %02d:%02d:%02d ===\n",
+                       local_time->tm_year + 1900, local_time->tm_mon + 1, local_time->tm_mday,
+                       local_time->tm_hour, local_time->tm_min, local_time->tm_sec);
+    ring_append(marker, len);
+
+    logger_initialized = true;
+
     // Set the ESP-IDF vprintf hook to redirect logs
     esp_log_set_vprintf(s3_log_vprintf);
-    printf("[S3_LOGGER] ESP log vprintf hook set - async logging active\n");
-    
-    // Write today's date to mark the start of logging session
-    printf("[S3_LOGGER] Writing session start marker to log file...\n");
-    FILE *temp_log_file = fopen(log_file_path, "a");
-    if (temp_log_file) {
-        time_t now = time(NULL);
-        struct tm *local_time = localtime(&now);
-        fprintf(temp_log_file, "\n=== S3_LOGGER SESSION START: %04d-%02d-%02d %02d:%02d:%02d ===\n",
-                local_time->tm_year + 1900, local_time->tm_mon + 1, local_time->tm_mday,
-                local_time->tm_hour, local_time->tm_min, local_time->tm_sec);
-        fflush(temp_log_file);
-        fclose(temp_log_file);
-        printf("[S3_LOGGER] Session start marker written successfully\n");
-    } else {
-        printf("[S3_LOGGER] WARNING: Could not write session start marker\n");
-    }
-    
-    logger_initialized = true;
-    
-    // Force some ESP-IDF logs to test the hook
-    ESP_LOGI(TAG, "Testing ESP-IDF log hook - this should increment call count");
-    ESP_LOGW(TAG, "Warning test log");
-    ESP_LOGE(TAG, "Error test log");
-    
-    vTaskDelay(pdMS_TO_TICKS(2000)); // Wait 2 seconds
-    printf("[S3_LOGGER] vprintf call count after ESP-IDF test: %u\n", vprintf_call_count);
+    ESP_LOGI(TAG, "ESP log vprintf hook set - async logging active");
 
     return ESP_OK;
 }
 
+void s3_logger_close(void) {
+    if (!logger_initialized) {
+        return;
+    }
+
+    esp_log_set_vprintf(vprintf);
+    logger_initialized = false;
+    logger_stop_requested = true;
+    if (logger_task_handle) {
+        xTaskNotifyGive(logger_task_handle);
+    }
+
+    // The task drains the ring and closes the file before the card is unmounted
+    for (int i = 0; i < 100 && logger_task_handle; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (logger_task_handle) {
+        printf("[S3_LOGGER] WARNING: logger task did not stop in time\n");
+    }
+}
+
 // Manual flush function for compatibility
 void s3_logger_flush_buffer(void) {
-    if (!logger_initialized || !buffer_mutex) {
+    if (!logger_initialized || !logger_task_handle) {
         return;
     }
-    
-    // Request immediate flush
-    flush_requested = true;
-    
+
+    xTaskNotifyGive(logger_task_handle);
+
     // Give some time for the logger task to process the flush
     vTaskDelay(pdMS_TO_TICKS(100));
 }
 
 // Test function to get vprintf call count
 uint32_t s3_logger_get_call_count(void) {
-    return vprintf_call_count;
+    return atomic_load_explicit(&vprintf_call_count, memory_order_relaxed);
+}
+
+void s3_logger_get_stats(s3_logger_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    stats->dropped_lines = atomic_load_explicit(&dropped_lines, memory_order_relaxed);
+    stats->truncated_lines = atomic_load_explicit(&truncated_lines, memory_order_relaxed);
+    stats->bytes_written = bytes_written;
+    stats->rotations = rotations;
 }
 
 // Thread-safe SD card wrappers (using global DMA mutex from s3_definitions)
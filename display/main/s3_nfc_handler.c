@@ -71,46 +71,14 @@ static bool is_sku_expired(const char* sku)
         return false;
     }
 
-    // Check baby packs
-    const s3_babyPack_t *babyPacks = NULL;
-    int babyPackCount = 0;
-    get_babyPacks(&babyPacks, &babyPackCount);
-
-    if (babyPacks && babyPackCount > 0) {
-        for (int i = 0; i < babyPackCount; i++) {
-            if (babyPacks[i].skuId && strcmp(babyPacks[i].skuId, sku) == 0) {
-                if (babyPacks[i].expiresAt != 0 && babyPacks[i].expiresAt < (unsigned int)now) {
-                    ESP_LOGE(TAG, "Baby pack SKU %s expired (expiresAt: %u, now: %u)",
-                             sku, babyPacks[i].expiresAt, (unsigned int)now);
-                    return true;
-                }
-                // Found matching SKU and it's not expired
-                return false;
-            }
-        }
-    }
-
-    // Check NFC data
-    const s3_nfc_t *nfcs = NULL;
-    int nfcCount = 0;
-    get_nfcs(&nfcs, &nfcCount);
-
-    if (nfcs && nfcCount > 0) {
-        for (int i = 0; i < nfcCount; i++) {
-            if (nfcs[i].skus && nfcs[i].skusCount > 0) {
-                for (int j = 0; j < nfcs[i].skusCount; j++) {
-                    if (nfcs[i].skus[j].skuId && strcmp(nfcs[i].skus[j].skuId, sku) == 0) {
-                        if (nfcs[i].skus[j].expiresAt != 0 && nfcs[i].skus[j].expiresAt < (unsigned int)now) {
-                            ESP_LOGE(TAG, "NFC SKU %s expired (expiresAt: %u, now: %u)",
-                                     sku, nfcs[i].skus[j].expiresAt, (unsigned int)now);
-                            return true;
-                        }
-                        // Found matching SKU and it's not expired
-                        return false;
-                    }
-                }
-            }
+    // Indexed by SKU: baby pack entries take precedence over NFC entries
+    unsigned int expiresAt = 0;
+    if (find_sku_expires_at(sku, &expiresAt)) {
+        if (expiresAt != 0 && expiresAt < (unsigned int)now) {
+            ESP_LOGE(TAG, "SKU %s expired (expiresAt: %u, now: %u)", sku, expiresAt, (unsigned int)now);
+            return true;
         }
+        return false;
     }
 
     // SKU not found in baby packs or NFC data, assume not expired
@@ -146,24 +114,13 @@ static void uid_to_string(const uint8_t* uid, char* uid_str)
  */
 static bool validate_enfc_nfc_uid(const uint8_t* uid)
 {
-    const s3_nfc_t *nfcs = NULL;
-    int nfc_count = 0;
-
-    get_nfcs(&nfcs, &nfc_count);
-    if (nfcs == NULL || nfc_count == 0) {
-        ESP_LOGW(TAG, "No NFCs found in account data for enfc validation");
-        return false;
-    }
-
     char uid_str[15];
     uid_to_string(uid, uid_str);
     ESP_LOGI(TAG, "Validating enfc NFC UID: %s", uid_str);
 
-    for (int i = 0; i < nfc_count; i++) {
-        if (nfcs[i].sn != NULL && strcmp(nfcs[i].sn, uid_str) == 0) {
-            ESP_LOGI(TAG, "enfc NFC UID %s matches account sn", uid_str);
-            return true;
-        }
+    if (find_nfc_by_sn(uid_str, NULL)) {
+        ESP_LOGI(TAG, "enfc NFC UID %s matches account sn", uid_str);
+        return true;
     }
 
     ESP_LOGW(TAG, "enfc NFC UID %s not found in account NFCs", uid_str);
@@ -183,24 +140,13 @@ static bool check_nfc_uid_in_account(const uint8_t* uid)
         return false;
     }
 
-    const s3_nfc_t *nfcs = NULL;
-    int nfc_count = 0;
-    get_nfcs(&nfcs, &nfc_count);
-
-    if (nfcs == NULL || nfc_count == 0) {
-        ESP_LOGW(TAG, "No NFCs found in account data");
-        return false;
-    }
-
     char uid_str[15];
     uid_to_string(uid, uid_str);
     ESP_LOGI(TAG, "Step 1: Checking if UID %s is in account", uid_str);
 
-    for (int i = 0; i < nfc_count; i++) {
-        if (nfcs[i].sn != NULL && strcmp(nfcs[i].sn, uid_str) == 0) {
-            ESP_LOGI(TAG, "UID %s found in account NFCs", uid_str);
-            return true;
-        }
+    if (find_nfc_by_sn(uid_str, NULL)) {
+        ESP_LOGI(TAG, "UID %s found in account NFCs", uid_str);
+        return true;
     }
 
     ESP_LOGW(TAG, "UID %s not found in account NFCs", uid_str);
@@ -231,38 +177,33 @@ static bool check_nfc_has_content(const char* sku_code, const uint8_t* uid, bool
             return false;
         }
 
-        const s3_nfc_t *nfcs = NULL;
-        int nfc_count = 0;
-        get_nfcs(&nfcs, &nfc_count);
-
-        if (nfcs && nfc_count > 0) {
-            char uid_str[15];
-            uid_to_string(uid, uid_str);
-
-            for (int i = 0; i < nfc_count; i++) {
-                if (nfcs[i].sn != NULL && strcmp(nfcs[i].sn, uid_str) == 0) {
-                    // Found matching UID, check if it has this SKU
-                    if (nfcs[i].skus && nfcs[i].skusCount > 0) {
-                        for (int j = 0; j < nfcs[i].skusCount; j++) {
-                            if (nfcs[i].skus[j].skuId && strcmp(nfcs[i].skus[j].skuId, sku_code) == 0) {
-                                // Check if this SKU is expired
-                                if (nfcs[i].skus[j].expiresAt != 0) {
-                                    time_t now = time(NULL);
-                                    if (now != (time_t)-1 && nfcs[i].skus[j].expiresAt < (unsigned int)now) {
-                                        ESP_LOGE(TAG, "Step 2: SKU %s is expired (expiresAt: %u, now: %u)",
-                                                 sku_code, nfcs[i].skus[j].expiresAt, (unsigned int)now);
-                                        return false;
-                                    }
-                                }
-                                ESP_LOGI(TAG, "Step 2: Found valid SKU %s for UID %s in account", sku_code, uid_str);
-                                return true;
-                            }
+        char uid_str[15];
+        uid_to_string(uid, uid_str);
+        s3_nfc_t nfc;
+
+        if (find_nfc_by_sn(uid_str, &nfc)) {
+            // Found matching UID, check if it has this SKU
+            for (int j = 0; nfc.skus && j < nfc.skusCount; j++) {
+                if (nfc.skus[j].skuId && strcmp(nfc.skus[j].skuId, sku_code) == 0) {
+                    // Check if this SKU is expired
+                    bool expired = false;
+                    if (nfc.skus[j].expiresAt != 0) {
+                        time_t now = time(NULL);
+                        if (now != (time_t)-1 && nfc.skus[j].expiresAt < (unsigned int)now) {
+                            ESP_LOGE(TAG, "Step 2: SKU %s is expired (expiresAt: %u, now: %u)",
+                                     sku_code, nfc.skus[j].expiresAt, (unsigned int)now);
+                            expired = true;
                         }
                     }
-                    ESP_LOGW(TAG, "Step 2: UID %s found but SKU %s not in its skus array", uid_str, sku_code);
-                    return false;
+                    if (!expired)
+                        ESP_LOGI(TAG, "Step 2: Found valid SKU %s for UID %s in account", sku_code, uid_str);
+                    free_nfc_copy(&nfc);
+                    return !expired;
                 }
             }
+            free_nfc_copy(&nfc);
+            ESP_LOGW(TAG, "Step 2: UID %s found but SKU %s not in its skus array", uid_str, sku_code);
+            return false;
         }
         ESP_LOGW(TAG, "Step 2: UID not found in account NFCs");
         return false;
@@ -309,6 +250,7 @@ static bool check_nfc_has_content(const char* sku_code, const uint8_t* uid, bool
         // Also check baby packs
         const s3_babyPack_t *babyPacks = NULL;
         int babyPackCount = 0;
+        account_model_lock();
         get_babyPacks(&babyPacks, &babyPackCount);
 
         if (babyPacks && babyPackCount > 0) {
@@ -320,6 +262,7 @@ static bool check_nfc_has_content(const char* sku_code, const uint8_t* uid, bool
                 }
             }
         }
+        account_model_unlock();
 
         if (has_content) {
             break;
@@ -421,45 +364,40 @@ static bool check_nfc_content_downloaded(const char* sku_code, bool is_blankee)
  */
 static const char* check_special_album_by_uid(const uint8_t* uid)
 {
-    const s3_nfc_t *nfcs = NULL;
-    int nfc_count = 0;
-
-    get_nfcs(&nfcs, &nfc_count);
-    if (nfcs == NULL || nfc_count == 0) {
-        ESP_LOGW(TAG, "No NFCs found in account data for special album check");
-        return BLANKEE_NOT_FOUND;
-    }
-
     char uid_str[15];
     uid_to_string(uid, uid_str);
     ESP_LOGI(TAG, "Checking for special albums with UID: %s", uid_str);
 
-    // Search for matching UID in account NFCs
-    for (int i = 0; i < nfc_count; i++) {
-        if (nfcs[i].sn != NULL && strcmp(nfcs[i].sn, uid_str) == 0) {
-            ESP_LOGI(TAG, "Found matching UID %s in account NFCs (skusCount: %d)", uid_str, nfcs[i].skusCount);
+    // Look up the UID in the indexed account NFCs
+    s3_nfc_t nfc;
+    if (find_nfc_by_sn(uid_str, &nfc)) {
+        ESP_LOGI(TAG, "Found matching UID %s in account NFCs (skusCount: %d)", uid_str, nfc.skusCount);
 
-            // Check if this NFC has any SKUs at all
-            if (nfcs[i].skusCount == 0) {
-                ESP_LOGI(TAG, "UID %s found but skus array is empty - no content available", uid_str);
-                return BLANKEE_NO_CONTENT;
-            }
+        // Check if this NFC has any SKUs at all
+        if (nfc.skusCount == 0) {
+            ESP_LOGI(TAG, "UID %s found but skus array is empty - no content available", uid_str);
+            free_nfc_copy(&nfc);
+            return BLANKEE_NO_CONTENT;
+        }
 
-            // Check if this NFC has SKURC albums
-            for (int j = 0; j < nfcs[i].skusCount; j++) {
-                if (nfcs[i].skus[j].skuId != NULL) {
-                    // Check if SKU starts with "SKURC-" (custom recording)
-                    if (strncmp(nfcs[i].skus[j].skuId, "SKURC-", 6) == 0) {
-                        ESP_LOGI(TAG, "Found special album: %s for UID %s", nfcs[i].skus[j].skuId, uid_str);
-                        // Return the SKU ID directly - we'll use it to find the album later
-                        return nfcs[i].skus[j].skuId;
-                    }
+        // Check if this NFC has SKURC albums
+        static char special_sku[64];
+        for (int j = 0; j < nfc.skusCount; j++) {
+            if (nfc.skus[j].skuId != NULL) {
+                // Check if SKU starts with "SKURC-" (custom recording)
+                if (strncmp(nfc.skus[j].skuId, "SKURC-", 6) == 0) {
+                    ESP_LOGI(TAG, "Found special album: %s for UID %s", nfc.skus[j].skuId, uid_str);
+                    // Return the SKU ID - we'll use it to find the album later
+                    strlcpy(special_sku, nfc.skus[j].skuId, sizeof(special_sku));
+                    free_nfc_copy(&nfc);
+                    return special_sku;
                 }
             }
-
-            ESP_LOGI(TAG, "UID %s found but no SKURC albums associated (has %d non-SKURC SKUs)", uid_str, nfcs[i].skusCount);
-            return BLANKEE_NO_CONTENT;
         }
+
+        ESP_LOGI(TAG, "UID %s found but no SKURC albums associated (has %d non-SKURC SKUs)", uid_str, nfc.skusCount);
+        free_nfc_copy(&nfc);
+        return BLANKEE_NO_CONTENT;
     }
 
     ESP_LOGI(TAG, "UID %s not found in account NFCs", uid_str);
@@ -552,6 +490,7 @@ nfc_result_t handle_nfc_input(const char* sku_code, const uint8_t* uid)
                 if (!found_in_account) {
                     const s3_babyPack_t *babyPacks = NULL;
                     int babyPackCount = 0;
+                    account_model_lock();
                     get_babyPacks(&babyPacks, &babyPackCount);
 
                     if (babyPacks && babyPackCount > 0) {
@@ -562,6 +501,7 @@ nfc_result_t handle_nfc_input(const char* sku_code, const uint8_t* uid)
                             }
                         }
                     }
+                    account_model_unlock();
                 }
 
                 if (found_in_account) {
@@ -1050,7 +990,7 @@ static void nfc_worker_task(void *pv)
                 }
             }
 
-            if (audio_play_sound_effect_quick("/sdcard/sound/PIX-WE-04-Detected.mp3")) {
+            if (audio_play_sound_effect_quick(NFC_DETECTED_SOUND)) {
                 ESP_LOGI("NFC", "NFC detection sound started successfully");
             } else {
                 ESP_LOGW("NFC", "Failed to play NFC detection sound");